@@ -32,6 +32,7 @@
 #import "CC3PerformanceAppDelegate.h"
 #import "CC3PerformanceLayer.h"
 #import "CC3PerformanceScene.h"
+#import "CC3SceneBenchmark.h"
 
 @implementation CC3PerformanceAppDelegate {
 	UIWindow *window;
@@ -46,6 +47,15 @@
 
 -(void) applicationDidFinishLaunching:(UIApplication*)application {
 	
+	// When launched with the argument "-CC3Benchmark YES", run the standard headless scene
+	// benchmarks, print the results as JSON to standard output, and exit, without any display.
+	if ([[NSUserDefaults standardUserDefaults] boolForKey: @"CC3Benchmark"]) {
+		NSString* results = [CC3SceneBenchmark runBenchmarks: [CC3SceneBenchmark standardBenchmarks]];
+		fputs([results UTF8String], stdout);
+		fflush(stdout);
+		exit(0);
+	}
+	
 	// Establish the type of CCDirector to use.
 	// Try to use CADisplayLink director and if it fails (SDK < 3.1) use the default director.
 	// This must be the first thing we do and must be done before establishing view controller.
@@ -0,0 +1,1463 @@
+/*
+ * CC3SceneBenchmark.h
+ *
+ * cocos3d 2.0.0
+ * Author: Bill Hollings
+ * Copyright (c) 2010-2013 The Brenwill Workshop Ltd. All rights reserved.
+ * http://www.brenwill.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * http://en.wikipedia.org/wiki/MIT_License
+ */
+
+/** @file */	// Doxygen marker
+
+#import "CC3Scene.h"
+#import "CC3VertexArrays.h"
+#import "CC3VertexSkinning.h"
+#import "CC3TextureLoader.h"
+#import "CC3LightAssigner.h"
+#import "CC3ShadowVolumes.h"
+#import "CC3NodePrefab.h"
+#import "CC3NodePool.h"
+#import "CC3PointParticles.h"
+#import "CC3ParametricMeshNodes.h"
+#import "CC3PVRFoundation.h"
+
+@class CC3ResourceNode;
+
+
+#pragma mark -
+#pragma mark CC3Benchmark
+
+/**
+ * CC3Benchmark is the abstract parent class of the benchmarks in this file. Each benchmark is
+ * identified by a name, performs its measurements when its run method is invoked, and reports
+ * the results of the last run, in a machine-readable JSON format, from its resultJSON method.
+ * A collection of benchmarks of any kind can be run together, and their results collected,
+ * using the runBenchmarks: method of CC3SceneBenchmark.
+ *
+ * This class should be considered for testing and experimental use only, and there is no
+ * need to include it in any finished application.
+ */
+@interface CC3Benchmark : NSObject {
+	NSString* name;
+}
+
+/** The name of this benchmark, as used to identify it in the results. */
+@property(nonatomic, retain) NSString* name;
+
+/**
+ * Runs this benchmark.
+ *
+ * Subclasses must override this method to perform their measurements.
+ * This implementation does nothing.
+ */
+-(void) run;
+
+/**
+ * Returns the results of the last run, as a JSON object.
+ *
+ * Subclasses must override this method to report their results.
+ * This implementation returns a JSON object containing only the name of this benchmark.
+ */
+-(NSString*) resultJSON;
+
+/**
+ * Returns the number of operations performed per millisecond, when the specified number
+ * of operations took the specified total time, in seconds. Returns zero if the time is zero.
+ */
+-(double) rateOf: (double) opCount perMillisecondIn: (ccTime) aTime;
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3SceneBenchmark
+
+/**
+ * CC3SceneBenchmark drives a CC3Scene through a fixed number of update and drawing frames,
+ * using a fixed frame interval, and reports the per-phase timings and counters collected
+ * by the CC3PerformanceStatistics of the scene, in a machine-readable JSON format that can
+ * be captured and compared across builds to track performance regressions.
+ *
+ * In both modes, each frame is updated normally, and is then drawn by invoking the drawScene
+ * method of the scene, so that all phases of drawing, including shadows, illumination and
+ * billboards, are measured. A benchmark can run in one of two modes, as determined by the
+ * isHeadless property:
+ *   - When headless, no GL context is required. The drawVisitor of the scene records the
+ *     nodes to be drawn into a draw command list, which is executed by a headless executor
+ *     that does not invoke the GL engine, but which counts the nodes, draw calls and faces
+ *     that would have been submitted to it. While the frames are run, no GL context is made
+ *     current, so that the GL calls made elsewhere in the drawScene method, including those
+ *     made while drawing shadows and billboards, are ignored by the platform.
+ *   - When not headless, the nodes are drawn to the GL engine. This requires that a GL
+ *     context be active on the current thread.
+ *
+ * Although the GL calls made while a headless benchmark runs are ignored, the GL state trackers
+ * of the CC3OpenGLESEngine, the GLSL programs, and the material and mesh switching state, are
+ * still driven by them, and no longer reflect the state of the GL engine once the benchmark has
+ * run. When a headless benchmark finishes, it restores the GL context that was current when it
+ * started, and invalidates all of that tracked state, using the invalidateTrackedState method
+ * of the CC3OpenGLESEngine, so that the original GL values are read again, and all GL state is
+ * set again, the next time the scene is rendered with GL. A headless benchmark can therefore
+ * be run before or between normal rendering, on the rendering thread.
+ *
+ * Benchmarks on scenes loaded from POD files can also be created without a GL context, by
+ * loading their textures through a CC3TextureLoader that uses a headless uploader. See the
+ * nodeFromPODFile: method.
+ *
+ * Because the CCDirector is not driving the scene, CCActions are not run during a benchmark.
+ * Instead, nodes that contain animation can be added to the benchmark using the
+ * addAnimatedNode: method, and their animation will be advanced on each frame.
+ *
+ * A number of class-side factory methods create benchmarks on representative scenes, and the
+ * standardBenchmarks method returns a collection of these. Applications can also create a
+ * benchmark around any custom CC3Scene using the benchmarkWithName:onScene: method.
+ *
+ * This class should be considered for testing and experimental use only, and there is no
+ * need to include it in any finished application.
+ */
+@interface CC3SceneBenchmark : CC3Benchmark {
+	CC3Scene* scene;
+	CCArray* animatedNodes;
+	GLuint frameCount;
+	GLuint warmUpFrameCount;
+	ccTime frameInterval;
+	ccTime animationDuration;
+	ccTime elapsedTime;
+	ccTime runTime;
+	GLuint nodeLookupCount;
+	ccTime indexedNodeLookupTime;
+	ccTime searchedNodeLookupTime;
+	BOOL isHeadless : 1;
+	BOOL shouldBenchmarkNodeLookup : 1;
+}
+
+/** The scene that is being benchmarked. */
+@property(nonatomic, retain, readonly) CC3Scene* scene;
+
+/**
+ * The number of frames that will be updated and drawn, and whose statistics will be
+ * collected, when the run method is invoked.
+ *
+ * The initial value of this property is 300.
+ */
+@property(nonatomic, assign) GLuint frameCount;
+
+/**
+ * The number of frames that will be updated and drawn, before statistics are collected,
+ * when the run method is invoked. These frames allow particle emitters to reach a steady
+ * state, and caches to be populated, before measurement begins.
+ *
+ * The initial value of this property is 30.
+ */
+@property(nonatomic, assign) GLuint warmUpFrameCount;
+
+/**
+ * The simulated interval between frames, in seconds. This interval is passed to the
+ * updateScene: method of the scene on each frame, and is recorded as the frame time.
+ *
+ * The initial value of this property is 1/60 second.
+ */
+@property(nonatomic, assign) ccTime frameInterval;
+
+/**
+ * The duration, in seconds, of a full cycle of the animation of the nodes added to this
+ * benchmark using the addAnimatedNode: method.
+ *
+ * The initial value of this property is one second.
+ */
+@property(nonatomic, assign) ccTime animationDuration;
+
+/**
+ * Indicates whether this benchmark draws frames without using the GL engine.
+ *
+ * See the notes for this class for a description of the behaviour of each mode.
+ *
+ * The initial value of this property is YES.
+ */
+@property(nonatomic, assign) BOOL isHeadless;
+
+/**
+ * Indicates whether the run method should also measure the time taken to retrieve each
+ * named and tagged node in the scene, both through the name and tag index maintained by
+ * the scene, and by searching the node structure of the scene. Each node is retrieved
+ * from its parent, which resolves any nodes elsewhere in the scene with the same name
+ * or tag.
+ *
+ * The initial value of this property is YES.
+ */
+@property(nonatomic, assign) BOOL shouldBenchmarkNodeLookup;
+
+/** The nodes whose animation is advanced on each frame. */
+@property(nonatomic, readonly) CCArray* animatedNodes;
+
+/** Adds the specified node to the collection of nodes whose animation is advanced on each frame. */
+-(void) addAnimatedNode: (CC3Node*) aNode;
+
+/** The performance statistics of the scene, which are created if the scene does not already have them. */
+@property(nonatomic, readonly) CC3PerformanceStatistics* performanceStatistics;
+
+
+#pragma mark Allocation and initialization
+
+/**
+ * Initializes this instance with the specified name, to benchmark the specified scene.
+ *
+ * The scene should contain an active camera, and will be played and sized to a default
+ * viewport when the run method is invoked.
+ */
+-(id) initWithName: (NSString*) aName onScene: (CC3Scene*) aScene;
+
+/** Allocates and initializes an autoreleased instance with the specified name, to benchmark the specified scene. */
++(id) benchmarkWithName: (NSString*) aName onScene: (CC3Scene*) aScene;
+
+
+#pragma mark Representative scenes
+
+/**
+ * Loads and returns a node containing the content of the specified POD file.
+ *
+ * If a GL context is current, the file is loaded normally. Otherwise, the textures in the
+ * file are decoded by a temporary CC3TextureLoader that uses a headless uploader, so that
+ * the file can be loaded, and the resulting nodes benchmarked, without a GL engine.
+ */
++(CC3ResourceNode*) nodeFromPODFile: (NSString*) aFilePath;
+
+/** Returns a benchmark on a scene containing the specified number of teapot mesh nodes, spread in a grid. */
++(id) meshNodeBenchmarkWithCount: (GLuint) nodeCount;
+
+/**
+ * Returns a benchmark on a scene containing the specified number of animated skinned
+ * characters, each loaded from the specified POD file.
+ */
++(id) skinnedCharacterBenchmarkFromFile: (NSString*) aFilePath withCount: (GLuint) charCount;
+
+/** Returns a benchmark on a scene containing the specified number of point particle hose emitters. */
++(id) pointParticleBenchmarkWithCount: (GLuint) emitterCount;
+
+/** Returns a benchmark on a scene containing the specified number of mesh particle hose emitters. */
++(id) meshParticleBenchmarkWithCount: (GLuint) emitterCount;
+
+/**
+ * Returns a benchmark on a scene containing the specified number of sphere mesh nodes,
+ * each casting a shadow volume from a single light.
+ */
++(id) shadowVolumeBenchmarkWithCount: (GLuint) nodeCount;
+
+/**
+ * Returns a benchmark on the same scene as the shadowVolumeBenchmarkWithCount: method, with
+ * the light rendering its shadows using a shadow map instead of shadow volumes. Because the
+ * light is positional, the shadow map contains a single perspective cascade.
+ */
++(id) shadowMapBenchmarkWithCount: (GLuint) nodeCount;
+
+/**
+ * Returns a benchmark on the same scene as the shadowMapBenchmarkWithCount: method, with the
+ * light made directional, so that its shadow map is split into cascades.
+ */
++(id) cascadedShadowMapBenchmarkWithCount: (GLuint) nodeCount;
+
+/** Returns a benchmark on a scene containing the specified number of billboards. */
++(id) billboardBenchmarkWithCount: (GLuint) billboardCount;
+
+/**
+ * Returns a benchmark on a scene containing the specified number of copies of a small node
+ * hierarchy. Each copy contains nodes with the same names and tags as the nodes in every
+ * other copy, so that the node lookups measured by the benchmark must resolve duplicates,
+ * as is typical when retrieving the parts of many copies of the same loaded model.
+ *
+ * The nodes contain no content to draw, so the measured frames are short, and the results
+ * are dominated by the node lookups.
+ */
++(id) nodeLookupBenchmarkWithCount: (GLuint) copyCount;
+
+/**
+ * Returns a collection of benchmarks covering each of the representative scenes created by
+ * the class-side factory methods above, each sized to exercise a realistic workload.
+ *
+ * The shadow volume benchmark is accompanied by a shadow map benchmark and a cascaded shadow
+ * map benchmark on the same scene, so that the shadow techniques can be compared directly.
+ *
+ * A node lookup benchmark of 100 copies of a hierarchy with duplicated names and tags
+ * is also included.
+ *
+ * The skinned character benchmark, a CC3SkeletalAnimationBenchmark for each of 1, 10 and
+ * 100 characters, a CC3AnimationBlendingBenchmark of 50 characters each blending 3 clips, and
+ * a CC3PrefabBenchmark that spawns 100 characters, are included only if the man.pod file is
+ * available in the application bundle. A
+ * CC3PODTangentSpaceBenchmark is also included for each of the demo POD files that is
+ * available in the application bundle, along with a CC3BoundingVolumeBenchmark for each
+ * of the packed and interleaved vertex layouts, a CC3TextureStreamingBenchmark that loads
+ * 200 textures of 256x256 pixels in the background, a CC3LightAssignmentBenchmark that
+ * selects the most influential of 100 lights for each of 2000 nodes, a
+ * CC3ShadowVolumeCacheBenchmark that populates the shadow volumes of spheres of 64x64 divisions,
+ * a CC3ObjectPoolBenchmark that spawns and removes 200 nodes and particles in each of 50 cycles,
+ * a CC3VertexBufferUpdateBenchmark that changes 1024 of 65536 vertices on each of 100 frames,
+ * and, if the Arial32BMGlyph.fnt font file is available in the application bundle, a
+ * CC3BitmapLabelBenchmark that updates the text of 40 labels 100 times.
+ */
++(CCArray*) standardBenchmarks;
+
+
+#pragma mark Running
+
+/**
+ * Runs this benchmark.
+ *
+ * Plays the scene and sizes its viewport, runs the number of frames specified by the
+ * warmUpFrameCount property, resets the performance statistics and frame timings, and
+ * then runs the number of frames specified by the frameCount property. If the
+ * shouldBenchmarkNodeLookup property is YES, node retrieval is measured as well.
+ *
+ * Once this method has completed, the results can be retrieved using the resultJSON method.
+ */
+-(void) run;
+
+/**
+ * Updates and draws a single frame.
+ *
+ * This is invoked automatically for each frame by the run method. Subclasses may override
+ * to perform additional activities on each frame.
+ */
+-(void) runFrame;
+
+/** The wall-clock time, in seconds, taken to run the measured frames during the last invocation of the run method. */
+@property(nonatomic, readonly) ccTime runTime;
+
+/** The number of node retrievals made by each node lookup method during the last invocation of the run method. */
+@property(nonatomic, readonly) GLuint nodeLookupCount;
+
+/** The time, in seconds, taken to retrieve nodes using the name and tag index of the scene. */
+@property(nonatomic, readonly) ccTime indexedNodeLookupTime;
+
+/** The time, in seconds, taken to retrieve nodes by searching the node structure of the scene. */
+@property(nonatomic, readonly) ccTime searchedNodeLookupTime;
+
+/**
+ * Returns the results of the last invocation of the run method, as a JSON object containing
+ * the name and configuration of this benchmark, the counters and averages collected by the
+ * performance statistics of the scene, and the average, p50, p95 and p99 time of each phase,
+ * in milliseconds.
+ */
+-(NSString*) resultJSON;
+
+/**
+ * Runs each of the specified benchmarks, in order, and returns a JSON array containing the
+ * results of each, as returned by the resultJSON method of each benchmark.
+ *
+ * The collection may contain any kind of CC3Benchmark, including instances of CC3SceneBenchmark,
+ * CC3PODTangentSpaceBenchmark, CC3BoundingVolumeBenchmark, CC3SkeletalAnimationBenchmark,
+ * CC3AnimationBlendingBenchmark, CC3PrefabBenchmark, CC3ObjectPoolBenchmark,
+ * CC3BitmapLabelBenchmark and CC3VertexBufferUpdateBenchmark.
+ */
++(NSString*) runBenchmarks: (CCArray*) benchmarks;
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3PODTangentSpaceBenchmark
+
+/**
+ * CC3PODTangentSpaceBenchmark measures the time taken to generate vertex tangents and
+ * bitangents for each triangle mesh in a POD file, using both the PVRTVertexGenerateTangentSpace
+ * function, and the original PVRTVertexGenerateTangentSpaceLegacy function that it replaces,
+ * and verifies that both produce identical vertices and vertex indices.
+ *
+ * Only meshes that contain vertex normals and texture coordinates, and that are drawn as
+ * triangle lists, are included. The tangent space is generated from the first set of
+ * texture coordinates in each mesh.
+ *
+ * The POD file is loaded, and the tangent space is generated and compared, by the
+ * CC3ComparePODFileTangentSpaceGeneration function.
+ *
+ * This class should be considered for testing and experimental use only, and there is no
+ * need to include it in any finished application.
+ */
+@interface CC3PODTangentSpaceBenchmark : CC3Benchmark {
+	NSString* filePath;
+	GLuint repeatCount;
+	GLuint threadCount;
+	GLfloat splitDifference;
+	CC3PODTangentSpaceComparison comparison;
+}
+
+/** The POD file whose meshes are processed. */
+@property(nonatomic, retain) NSString* filePath;
+
+/**
+ * The number of times the tangent space of each mesh is generated by each function.
+ *
+ * The initial value of this property is 10.
+ */
+@property(nonatomic, assign) GLuint repeatCount;
+
+/**
+ * The number of threads PVRTVertexGenerateTangentSpace may use to calculate triangle tangents.
+ *
+ * The initial value of this property is one.
+ */
+@property(nonatomic, assign) GLuint threadCount;
+
+/**
+ * Vertices are split when the DP3 of the tangents or bitangents desired by triangles sharing
+ * the vertex is below this value.
+ *
+ * The initial value of this property is 0.9.
+ */
+@property(nonatomic, assign) GLfloat splitDifference;
+
+/** The number of meshes processed during the last run. */
+@property(nonatomic, readonly) GLuint meshCount;
+
+/** The number of triangles in the meshes processed during the last run. */
+@property(nonatomic, readonly) GLuint triangleCount;
+
+/** The number of vertices in the meshes processed during the last run. */
+@property(nonatomic, readonly) GLuint vertexCountIn;
+
+/** The number of vertices, including split vertices, generated during the last run. */
+@property(nonatomic, readonly) GLuint vertexCountOut;
+
+/** The number of meshes for which both functions generated identical vertices and indices. */
+@property(nonatomic, readonly) GLuint meshesMatched;
+
+/** The number of meshes for which both functions succeeded, but generated different content. */
+@property(nonatomic, readonly) GLuint meshesDiffered;
+
+/**
+ * The number of meshes for which only the legacy function failed, typically
+ * because more than 32 triangles share a vertex.
+ */
+@property(nonatomic, readonly) GLuint legacyFailures;
+
+/** The number of meshes for which PVRTVertexGenerateTangentSpace failed. */
+@property(nonatomic, readonly) GLuint failures;
+
+/** The total time, in seconds, spent in the legacy function during the last run. */
+@property(nonatomic, readonly) ccTime legacyTime;
+
+/** The total time, in seconds, spent in the PVRTVertexGenerateTangentSpace function during the last run. */
+@property(nonatomic, readonly) ccTime generatorTime;
+
+
+#pragma mark Allocation and initialization
+
+/** Initializes this instance to process the meshes in the specified POD file. */
+-(id) initFromFile: (NSString*) aFilePath;
+
+/** Allocates and initializes an autoreleased instance to process the meshes in the specified POD file. */
++(id) benchmarkFromFile: (NSString*) aFilePath;
+
+
+#pragma mark Running
+
+/** Loads the POD file, and generates and compares the tangent space of each mesh. */
+-(void) run;
+
+/** Returns the results of the last run, as a JSON object. */
+-(NSString*) resultJSON;
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3BoundingVolumeBenchmark
+
+/**
+ * CC3BoundingVolumeBenchmark measures the time taken to build the bounding box and radius of
+ * a CC3VertexLocations instance, both by the bulk location functions CC3BoundingBoxFromLocations
+ * and CC3RadiusOfLocationsFromCenter, and by accumulating each location retrieved individually
+ * through the locationAt: method, and verifies that both produce identical results. The time
+ * taken to build the minimalBoundingSphere of the vertex locations is also measured, and the
+ * radius of that sphere is reported alongside the radius around the centerOfGeometry.
+ *
+ * The vertex locations are populated with a synthetic, asymmetric cloud of locations, and can
+ * either be tightly packed, or interleaved with normal and texture coordinate content, as
+ * determined by the isInterleaved property.
+ *
+ * This class should be considered for testing and experimental use only, and there is no
+ * need to include it in any finished application.
+ */
+@interface CC3BoundingVolumeBenchmark : CC3Benchmark {
+	CC3VertexLocations* vertexLocations;
+	GLuint vertexCount;
+	GLuint repeatCount;
+	GLuint mismatches;
+	GLfloat radius;
+	GLfloat minimalRadius;
+	ccTime elementwiseTime;
+	ccTime bulkTime;
+	ccTime minimalSphereTime;
+	BOOL isInterleaved : 1;
+}
+
+/** The number of vertices in the synthetic vertex locations. */
+@property(nonatomic, readonly) GLuint vertexCount;
+
+/** Indicates whether the vertex locations are interleaved with other vertex content. */
+@property(nonatomic, readonly) BOOL isInterleaved;
+
+/**
+ * The number of times the bounding box and radius are built by each method.
+ *
+ * The initial value of this property is 20.
+ */
+@property(nonatomic, assign) GLuint repeatCount;
+
+/** The number of runs in which the two methods produced a different bounding box or radius. */
+@property(nonatomic, readonly) GLuint mismatches;
+
+/** The radius around the centerOfGeometry of the vertex locations. */
+@property(nonatomic, readonly) GLfloat radius;
+
+/** The radius of the minimalBoundingSphere of the vertex locations. */
+@property(nonatomic, readonly) GLfloat minimalRadius;
+
+/** The total time, in seconds, spent accumulating individual locations during the last run. */
+@property(nonatomic, readonly) ccTime elementwiseTime;
+
+/** The total time, in seconds, spent in the bulk location functions during the last run. */
+@property(nonatomic, readonly) ccTime bulkTime;
+
+/** The total time, in seconds, spent building the minimal bounding sphere during the last run. */
+@property(nonatomic, readonly) ccTime minimalSphereTime;
+
+
+#pragma mark Allocation and initialization
+
+/**
+ * Initializes this instance to measure vertex locations containing the specified number of
+ * vertices, either interleaved with other vertex content, or tightly packed.
+ */
+-(id) initWithVertexCount: (GLuint) vtxCount interleaved: (BOOL) interleave;
+
+/**
+ * Allocates and initializes an autoreleased instance to measure vertex locations containing the
+ * specified number of vertices, either interleaved with other vertex content, or tightly packed.
+ */
++(id) benchmarkWithVertexCount: (GLuint) vtxCount interleaved: (BOOL) interleave;
+
+
+#pragma mark Running
+
+/** Builds and compares the bounding box and radius of the vertex locations using each method. */
+-(void) run;
+
+/** Returns the results of the last run, as a JSON object. */
+-(NSString*) resultJSON;
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3CharacterAnimationBenchmark
+
+/**
+ * CC3CharacterAnimationBenchmark is the abstract parent class of benchmarks that animate a
+ * number of skinned characters.
+ *
+ * The characters are loaded once from a POD file, and the loaded node is copied for each
+ * additional character. Only the animation is measured. The transforms of the nodes are not
+ * rebuilt, and nothing is drawn.
+ *
+ * This class should be considered for testing and experimental use only, and there is no
+ * need to include it in any finished application.
+ */
+@interface CC3CharacterAnimationBenchmark : CC3Benchmark {
+	NSString* filePath;
+	CCArray* characters;
+	CCArray* softBodyNodes;
+	GLuint characterCount;
+	GLuint sampleCount;
+}
+
+/** The POD file from which the characters are loaded. */
+@property(nonatomic, readonly) NSString* filePath;
+
+/** The number of characters animated by this benchmark. */
+@property(nonatomic, readonly) GLuint characterCount;
+
+/**
+ * The number of times, evenly distributed across the animation, at which all characters
+ * are animated by each method that is measured.
+ *
+ * The initial value of this property is set by each subclass.
+ */
+@property(nonatomic, assign) GLuint sampleCount;
+
+/**
+ * The number of animated nodes across all characters, as determined during the last run.
+ *
+ * This implementation returns zero. Subclasses must override.
+ */
+@property(nonatomic, readonly) GLuint animatedNodeCount;
+
+
+#pragma mark Allocation and initialization
+
+/**
+ * Initializes this instance to animate the specified number of characters, each loaded from
+ * the specified POD file. The name of this benchmark is formed from the specified name prefix,
+ * the name of the POD file, and the number of characters.
+ */
+-(id) initWithNamePrefix: (NSString*) namePrefix fromFile: (NSString*) aFilePath withCount: (GLuint) charCount;
+
+
+#pragma mark Running
+
+/**
+ * Loads the characters once, copies the loaded node for each additional character, and collects
+ * the characters into the characters array, and the CC3SoftBodyNodes of all characters into the
+ * softBodyNodes array.
+ *
+ * This method is invoked automatically at the beginning of the run method of each subclass.
+ * Subclasses that override to perform additional preparation must invoke this superclass method.
+ */
+-(void) loadCharacters;
+
+/**
+ * Releases the characters and soft-body nodes loaded by the loadCharacters method.
+ *
+ * This method is invoked automatically at the end of the run method of each subclass.
+ */
+-(void) releaseCharacters;
+
+/**
+ * Returns the number of nodes animated per millisecond, when all of the animated nodes were
+ * animated at each sample time within the specified total time, in seconds.
+ */
+-(double) nodesPerMillisecondIn: (ccTime) aTime;
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3SkeletalAnimationBenchmark
+
+/**
+ * CC3SkeletalAnimationBenchmark measures the rate at which the animated nodes of a number of
+ * skinned characters can be animated, both by having each node sample its own CC3NodeAnimation
+ * individually, and by having each CC3SoftBodyNode sample all of its bones together through a
+ * CC3NodeAnimationBatch. It also verifies that both produce the same node locations, quaternions
+ * and scales, within a small tolerance that allows for the difference between the normalized
+ * linear interpolation used by the batch and the spherical linear interpolation used by each node.
+ *
+ * This class should be considered for testing and experimental use only, and there is no
+ * need to include it in any finished application.
+ */
+@interface CC3SkeletalAnimationBenchmark : CC3CharacterAnimationBenchmark {
+	GLuint animatedNodeCount;
+	GLuint batchedNodeCount;
+	GLuint mismatches;
+	ccTime unbatchedTime;
+	ccTime batchedTime;
+}
+
+/**
+ * The number of times, evenly distributed across the animation, at which all characters
+ * are animated by each method.
+ *
+ * The initial value of this property is 200.
+ */
+@property(nonatomic, assign) GLuint sampleCount;
+
+/** The number of animated nodes across all characters, as determined during the last run. */
+@property(nonatomic, readonly) GLuint animatedNodeCount;
+
+/**
+ * The number of animated nodes across all characters that were held in an animation batch
+ * during the last run. The remaining animated nodes were animated individually by each batch.
+ */
+@property(nonatomic, readonly) GLuint batchedNodeCount;
+
+/** The number of animated nodes whose batched animation differed from their individual animation. */
+@property(nonatomic, readonly) GLuint mismatches;
+
+/** The total time, in seconds, spent animating each node individually during the last run. */
+@property(nonatomic, readonly) ccTime unbatchedTime;
+
+/** The total time, in seconds, spent animating the nodes in batches during the last run. */
+@property(nonatomic, readonly) ccTime batchedTime;
+
+
+#pragma mark Allocation and initialization
+
+/**
+ * Initializes this instance to animate the specified number of characters,
+ * each loaded from the specified POD file.
+ */
+-(id) initFromFile: (NSString*) aFilePath withCount: (GLuint) charCount;
+
+/**
+ * Allocates and initializes an autoreleased instance to animate the specified
+ * number of characters, each loaded from the specified POD file.
+ */
++(id) benchmarkFromFile: (NSString*) aFilePath withCount: (GLuint) charCount;
+
+
+#pragma mark Running
+
+/** Animates all characters with and without animation batches, and compares the results. */
+-(void) run;
+
+/**
+ * Returns the results of the last run, as a JSON object, including the number of
+ * nodes animated per millisecond by each method.
+ */
+-(NSString*) resultJSON;
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3AnimationBlendingBenchmark
+
+/**
+ * CC3AnimationBlendingBenchmark measures the rate at which the animated nodes of a number of
+ * skinned characters can be posed by blending several weighted animation clips, both by a
+ * CC3NodeAnimationBlender on each CC3SoftBodyNode, and by having each node sample each clip
+ * through its own CC3NodeAnimation, and blending the resulting node properties, as application
+ * code would otherwise have to do.
+ *
+ * Each clip is taken from the animation loaded with the characters, played at a different
+ * time offset. Both methods apply the clips as layers, each blending the pose established by
+ * the clips below it towards its own pose by its weight. Node locations and scales produced by
+ * both methods are verified to match, and the largest difference in rotation is reported, since
+ * the blender blends rotations by normalized linear interpolation, whereas the individual method
+ * uses spherical linear interpolation.
+ *
+ * This class should be considered for testing and experimental use only, and there is no
+ * need to include it in any finished application.
+ */
+@interface CC3AnimationBlendingBenchmark : CC3CharacterAnimationBenchmark {
+	CCArray* animatedNodes;
+	GLfloat* restContent;
+	GLfloat* blendContent;
+	GLuint clipCount;
+	GLuint mismatches;
+	GLfloat maxRotationDifference;
+	ccTime individualTime;
+	ccTime blendedTime;
+}
+
+/** The number of animation clips blended for each character. */
+@property(nonatomic, readonly) GLuint clipCount;
+
+/**
+ * The number of times, evenly distributed across the animation, at which all characters
+ * are posed by each method.
+ *
+ * The initial value of this property is 100.
+ */
+@property(nonatomic, assign) GLuint sampleCount;
+
+/** The number of animated nodes across all characters, as determined during the last run. */
+@property(nonatomic, readonly) GLuint animatedNodeCount;
+
+/** The number of animated nodes whose blended location or scale differed between the two methods. */
+@property(nonatomic, readonly) GLuint mismatches;
+
+/** The largest difference in the rotation of any node between the two methods, in degrees. */
+@property(nonatomic, readonly) GLfloat maxRotationDifference;
+
+/** The total time, in seconds, spent sampling and blending each node individually during the last run. */
+@property(nonatomic, readonly) ccTime individualTime;
+
+/** The total time, in seconds, spent blending with the animation blenders during the last run. */
+@property(nonatomic, readonly) ccTime blendedTime;
+
+
+#pragma mark Allocation and initialization
+
+/**
+ * Initializes this instance to animate the specified number of characters, each loaded
+ * from the specified POD file, by blending the specified number of animation clips.
+ */
+-(id) initFromFile: (NSString*) aFilePath withCount: (GLuint) charCount blendingClips: (GLuint) numClips;
+
+/**
+ * Allocates and initializes an autoreleased instance to animate the specified number of
+ * characters, each loaded from the specified POD file, by blending the specified number
+ * of animation clips.
+ */
++(id) benchmarkFromFile: (NSString*) aFilePath withCount: (GLuint) charCount blendingClips: (GLuint) numClips;
+
+
+#pragma mark Running
+
+/** Poses all characters using each method, and compares the results. */
+-(void) run;
+
+/**
+ * Returns the results of the last run, as a JSON object, including the number of
+ * nodes posed per millisecond by each method.
+ */
+-(NSString*) resultJSON;
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3TextureStreamingBenchmark
+
+/**
+ * CC3TextureStreamingBenchmark measures the loading of a number of texture files in the
+ * background by a CC3TextureLoader, and verifies the content that the loader submits.
+ *
+ * The texture files are synthetic PNG images, written to the temporary directory the first
+ * time the benchmark is run. All of the files are submitted to the loader at once, and the
+ * uploadWithinBudget method of the loader is then invoked once per simulated frame until
+ * all textures have been loaded. The time taken to submit the files, the longest time spent
+ * uploading on any one frame, the most bytes uploaded on any one frame, and the total time
+ * and number of frames needed to load all of the textures, are reported.
+ *
+ * When the isHeadless property is set to YES, the loader uses an uploader that records the
+ * uploads, instead of submitting them to the GL engine. The recorded uploads are checked to
+ * ensure that the levels of each texture are submitted in order, with the correct dimensions,
+ * and that each CC3Texture ends up holding a loaded texture of the correct size, rather than
+ * the placeholder or a preview. Any discrepancies are reported as mismatches.
+ *
+ * This class should be considered for testing and experimental use only, and there is no
+ * need to include it in any finished application.
+ */
+@interface CC3TextureStreamingBenchmark : CC3Benchmark {
+	CCArray* textures;
+	GLuint textureCount;
+	GLuint textureSize;
+	GLuint uploadBudget;
+	GLuint loadingFrameCount;
+	GLuint maxFrameBytesUploaded;
+	GLuint bytesUploaded;
+	GLuint previewsLoaded;
+	GLuint mismatches;
+	ccTime frameInterval;
+	ccTime submitTime;
+	ccTime maxFrameUploadTime;
+	ccTime loadingTime;
+	BOOL isHeadless : 1;
+}
+
+/** The number of texture files loaded. */
+@property(nonatomic, readonly) GLuint textureCount;
+
+/** The width and height of each texture file, in pixels. */
+@property(nonatomic, readonly) GLuint textureSize;
+
+/**
+ * The uploadBudget of the loader, in bytes.
+ *
+ * The initial value of this property is the initial value of the uploadBudget property of CC3TextureLoader.
+ */
+@property(nonatomic, assign) GLuint uploadBudget;
+
+/**
+ * Indicates whether the uploads are recorded instead of being submitted to the GL engine.
+ *
+ * The initial value of this property is YES.
+ */
+@property(nonatomic, assign) BOOL isHeadless;
+
+/**
+ * The interval between simulated frames, in seconds.
+ *
+ * The initial value of this property is 1/60 second.
+ */
+@property(nonatomic, assign) ccTime frameInterval;
+
+/** The number of frames on which uploadWithinBudget was invoked before all textures were loaded. */
+@property(nonatomic, readonly) GLuint loadingFrameCount;
+
+/** The largest number of bytes uploaded on any one frame. */
+@property(nonatomic, readonly) GLuint maxFrameBytesUploaded;
+
+/** The number of discrepancies found in the uploads or the loaded textures. */
+@property(nonatomic, readonly) GLuint mismatches;
+
+/** The time, in seconds, taken to submit all of the files to the loader. */
+@property(nonatomic, readonly) ccTime submitTime;
+
+/** The longest time, in seconds, spent in the uploadWithinBudget method on any one frame. */
+@property(nonatomic, readonly) ccTime maxFrameUploadTime;
+
+/** The time, in seconds, from submitting the first file until all textures were loaded. */
+@property(nonatomic, readonly) ccTime loadingTime;
+
+
+#pragma mark Allocation and initialization
+
+/** Initializes this instance to load the specified number of square textures of the specified size. */
+-(id) initWithTextureCount: (GLuint) texCount ofSize: (GLuint) texSize;
+
+/** Allocates and initializes an autoreleased instance to load the specified number of square textures of the specified size. */
++(id) benchmarkWithTextureCount: (GLuint) texCount ofSize: (GLuint) texSize;
+
+
+#pragma mark Running
+
+/** Loads the textures in the background, one simulated frame at a time, and verifies the results. */
+-(void) run;
+
+/** Returns the results of the last run, as a JSON object. */
+-(NSString*) resultJSON;
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3LightAssignmentBenchmark
+
+/**
+ * CC3LightAssignmentBenchmark measures the CPU time taken by a CC3LightAssigner to select the
+ * most influential lights for each of a large number of nodes, from a scene containing many
+ * more lights than the GL engine supports, and verifies the lights that it selects.
+ *
+ * The lights are positional lights, with random colors and attenuations, scattered at random
+ * throughout a cube. The nodes are represented by bounding spheres of random sizes, scattered
+ * throughout the same cube. The lights are created without GL light indexes, so no GL context
+ * is required, and the benchmark does not bind any lights to the GL engine.
+ *
+ * On each repeat, the time taken by the prepareLights: method, and the total time taken by the
+ * selectLightsForSphere: method across all of the spheres, are measured. The lights selected
+ * for each sphere are compared with those found by testing every light against that sphere,
+ * and the time taken by that exhaustive selection is reported for comparison. Any sphere for
+ * which the two selections differ is reported as a mismatch.
+ *
+ * This class should be considered for testing and experimental use only, and there is no
+ * need to include it in any finished application.
+ */
+@interface CC3LightAssignmentBenchmark : CC3Benchmark {
+	CCArray* lights;
+	CC3Sphere* spheres;
+	GLuint lightCount;
+	GLuint sphereCount;
+	GLuint repeatCount;
+	GLuint mismatches;
+	GLuint lightsTested;
+	GLuint lightsSelected;
+	ccTime prepareTime;
+	ccTime selectionTime;
+	ccTime exhaustiveTime;
+}
+
+/** The number of lights in the synthetic scene. */
+@property(nonatomic, readonly) GLuint lightCount;
+
+/** The number of bounding spheres for which lights are selected. */
+@property(nonatomic, readonly) GLuint sphereCount;
+
+/**
+ * The number of times the lights are prepared, and selected for each sphere.
+ *
+ * The initial value of this property is 10.
+ */
+@property(nonatomic, assign) GLuint repeatCount;
+
+/** The number of spheres for which the assigner selected different lights than the exhaustive selection. */
+@property(nonatomic, readonly) GLuint mismatches;
+
+/** The total time, in seconds, spent preparing the lights during the last run. */
+@property(nonatomic, readonly) ccTime prepareTime;
+
+/** The total time, in seconds, spent by the assigner selecting lights for the spheres during the last run. */
+@property(nonatomic, readonly) ccTime selectionTime;
+
+/** The total time, in seconds, spent testing every light against each sphere during the last run. */
+@property(nonatomic, readonly) ccTime exhaustiveTime;
+
+
+#pragma mark Allocation and initialization
+
+/** Initializes this instance to select lights from the specified number of lights for the specified number of spheres. */
+-(id) initWithLightCount: (GLuint) ltCount sphereCount: (GLuint) sphCount;
+
+/**
+ * Allocates and initializes an autoreleased instance to select lights from the
+ * specified number of lights for the specified number of spheres.
+ */
++(id) benchmarkWithLightCount: (GLuint) ltCount sphereCount: (GLuint) sphCount;
+
+
+#pragma mark Running
+
+/** Selects the lights for each sphere, using both the assigner and an exhaustive search. */
+-(void) run;
+
+/** Returns the results of the last run, as a JSON object. */
+-(NSString*) resultJSON;
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3ShadowVolumeCacheBenchmark
+
+/**
+ * CC3ShadowVolumeCacheBenchmark measures the CPU time taken to populate the shadow volume of a
+ * tessellated sphere, with and without the shadow volume cache enabled by the
+ * shouldCacheShadowVolumes property, and verifies the shadow volumes built from the cache.
+ *
+ * Two identical spheres, and a positional light, are placed under a common parent node.
+ * The shadow volume of one sphere caches its shadow, and the shadow volume of the other
+ * does not. No GL context is required, since the shadow volume meshes do not use GL buffers.
+ *
+ * The benchmark runs in two phases, each of frameCount frames:
+ *   - The light orbits the spheres by a small angle on each frame, and both shadow volumes
+ *     are populated. The caching shadow volume updates its terminator incrementally, and the
+ *     other rebuilds its shadow volume from every face of its sphere. The triangles of the
+ *     two shadow volume meshes are compared on each frame, and any frame on which they
+ *     differ is reported as a mismatch.
+ *   - The common parent node is moved and rotated on each frame, carrying the spheres and
+ *     the light with it. Because the light does not move relative to the spheres, the
+ *     caching shadow volume reuses its existing mesh.
+ *
+ * This class should be considered for testing and experimental use only, and there is no
+ * need to include it in any finished application.
+ */
+@interface CC3ShadowVolumeCacheBenchmark : CC3Benchmark {
+	GLuint tessellation;
+	GLuint frameCount;
+	GLuint faceCount;
+	GLuint incrementalUpdates;
+	GLuint reusedUpdates;
+	GLuint mismatches;
+	ccTime uncachedTime;
+	ccTime incrementalTime;
+	ccTime reuseTime;
+}
+
+/** The number of divisions along each axis of the sphere that casts the shadows. */
+@property(nonatomic, readonly) GLuint tessellation;
+
+/**
+ * The number of frames in each phase of the benchmark.
+ *
+ * The initial value of this property is 200.
+ */
+@property(nonatomic, assign) GLuint frameCount;
+
+/** The number of frames on which the caching shadow volume updated its terminator incrementally. */
+@property(nonatomic, readonly) GLuint incrementalUpdates;
+
+/** The number of frames on which the caching shadow volume reused its existing mesh. */
+@property(nonatomic, readonly) GLuint reusedUpdates;
+
+/** The number of frames on which the caching and non-caching shadow volumes contained different triangles. */
+@property(nonatomic, readonly) GLuint mismatches;
+
+/** The total time, in seconds, spent populating the non-caching shadow volume while the light was orbiting. */
+@property(nonatomic, readonly) ccTime uncachedTime;
+
+/** The total time, in seconds, spent populating the caching shadow volume while the light was orbiting. */
+@property(nonatomic, readonly) ccTime incrementalTime;
+
+/** The total time, in seconds, spent populating the caching shadow volume while the parent node was moving. */
+@property(nonatomic, readonly) ccTime reuseTime;
+
+
+#pragma mark Allocation and initialization
+
+/** Initializes this instance to cast shadows from spheres with the specified number of divisions along each axis. */
+-(id) initWithTessellation: (GLuint) divsPerAxis;
+
+/**
+ * Allocates and initializes an autoreleased instance to cast shadows from spheres
+ * with the specified number of divisions along each axis.
+ */
++(id) benchmarkWithTessellation: (GLuint) divsPerAxis;
+
+
+#pragma mark Running
+
+/** Populates the shadow volumes of the spheres while the light, and then their parent, moves. */
+-(void) run;
+
+/** Returns the results of the last run, as a JSON object. */
+-(NSString*) resultJSON;
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3PrefabBenchmark
+
+/**
+ * CC3PrefabBenchmark measures the rate at which instances of a skinned character can be spawned,
+ * both by copying the loaded character with the copyWithName: method, and by instantiating it
+ * through a CC3NodePrefab. It also verifies that every instance created by either method has the
+ * same number of nodes as the loaded character, and that each of its skin sections is attached
+ * to bones within that instance, rather than to the bones of the loaded character.
+ *
+ * The character is loaded once from a POD file, and its animation is batched, as it would be
+ * for a character that is animated in a scene. Only spawning is measured. The instances are
+ * not added to a scene, and nothing is drawn.
+ *
+ * This class should be considered for testing and experimental use only, and there is no
+ * need to include it in any finished application.
+ */
+@interface CC3PrefabBenchmark : CC3Benchmark {
+	NSString* filePath;
+	GLuint instanceCount;
+	GLuint nodeCount;
+	GLuint mismatches;
+	ccTime copyTime;
+	ccTime prefabTime;
+	ccTime prefabCreationTime;
+}
+
+/** The POD file from which the character is loaded. */
+@property(nonatomic, readonly) NSString* filePath;
+
+/** The number of instances spawned by each method. */
+@property(nonatomic, readonly) GLuint instanceCount;
+
+/** The number of nodes in each instance, as determined during the last run. */
+@property(nonatomic, readonly) GLuint nodeCount;
+
+/**
+ * The number of instances, across both methods, whose node count differed from that of the
+ * loaded character, or whose skin sections were attached to bones outside that instance.
+ */
+@property(nonatomic, readonly) GLuint mismatches;
+
+/** The total time, in seconds, spent spawning instances by copying during the last run. */
+@property(nonatomic, readonly) ccTime copyTime;
+
+/** The total time, in seconds, spent spawning instances through the prefab during the last run. */
+@property(nonatomic, readonly) ccTime prefabTime;
+
+/** The time, in seconds, spent creating the prefab from the loaded character during the last run. */
+@property(nonatomic, readonly) ccTime prefabCreationTime;
+
+
+#pragma mark Allocation and initialization
+
+/**
+ * Initializes this instance to spawn the specified number of instances of the
+ * character loaded from the specified POD file.
+ */
+-(id) initFromFile: (NSString*) aFilePath withCount: (GLuint) instCount;
+
+/**
+ * Allocates and initializes an autoreleased instance to spawn the specified number
+ * of instances of the character loaded from the specified POD file.
+ */
++(id) benchmarkFromFile: (NSString*) aFilePath withCount: (GLuint) instCount;
+
+
+#pragma mark Running
+
+/** Spawns the instances by copying and through a prefab, and verifies the instances. */
+-(void) run;
+
+/**
+ * Returns the results of the last run, as a JSON object, including the number of
+ * instances spawned per millisecond by each method.
+ */
+-(NSString*) resultJSON;
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3ObjectPoolBenchmark
+
+/**
+ * CC3ObjectPoolBenchmark measures the cost of spawn-and-remove churn, such as that of projectiles,
+ * hit effects and short-lived particle bursts, both with and without object pooling.
+ *
+ * The node churn repeatedly adds a number of small mesh node assemblies to a parent node and then
+ * removes them. Without pooling, each assembly is created by copying a template node. With pooling,
+ * each assembly is acquired from a CC3NodePool, and is recycled into that pool when removed.
+ *
+ * The particle churn repeatedly creates a point particle emitter, emits a number of particles from
+ * it, and stops it. Without pooling, each emitter instantiates its own particles. With pooling, each
+ * emitter acquires its particles from a CC3ParticlePool shared by all of the emitters, and recycles
+ * them into that pool when stopped.
+ *
+ * The pool hit and miss counts are included in the results, so that the proportion of spawns that
+ * were satisfied by reusing a pooled object can be verified.
+ *
+ * This class should be considered for testing and experimental use only, and there is no
+ * need to include it in any finished application.
+ */
+@interface CC3ObjectPoolBenchmark : CC3Benchmark {
+	CC3NodePool* nodePool;
+	CC3ParticlePool* particlePool;
+	GLuint spawnCount;
+	GLuint cycleCount;
+	ccTime nodeCopyTime;
+	ccTime nodePoolTime;
+	ccTime particleTime;
+	ccTime particlePoolTime;
+}
+
+/** The number of nodes, or particles, spawned and removed in each cycle. */
+@property(nonatomic, readonly) GLuint spawnCount;
+
+/** The number of spawn-and-remove cycles performed for each kind of churn. */
+@property(nonatomic, readonly) GLuint cycleCount;
+
+/** The node pool used during the last run. */
+@property(nonatomic, readonly) CC3NodePool* nodePool;
+
+/** The particle pool used during the last run. */
+@property(nonatomic, readonly) CC3ParticlePool* particlePool;
+
+/** The total time, in seconds, spent on node churn without pooling during the last run. */
+@property(nonatomic, readonly) ccTime nodeCopyTime;
+
+/** The total time, in seconds, spent on node churn with pooling during the last run. */
+@property(nonatomic, readonly) ccTime nodePoolTime;
+
+/** The total time, in seconds, spent on particle churn without pooling during the last run. */
+@property(nonatomic, readonly) ccTime particleTime;
+
+/** The total time, in seconds, spent on particle churn with pooling during the last run. */
+@property(nonatomic, readonly) ccTime particlePoolTime;
+
+
+#pragma mark Allocation and initialization
+
+/**
+ * Initializes this instance to spawn and remove the specified number of nodes,
+ * or particles, in each of the specified number of cycles.
+ */
+-(id) initWithSpawnCount: (GLuint) spawns cycles: (GLuint) cycles;
+
+/**
+ * Allocates and initializes an autoreleased instance to spawn and remove the specified
+ * number of nodes, or particles, in each of the specified number of cycles.
+ */
++(id) benchmarkWithSpawnCount: (GLuint) spawns cycles: (GLuint) cycles;
+
+
+#pragma mark Running
+
+/** Performs the node and particle churn, both with and without pooling. */
+-(void) run;
+
+/**
+ * Returns the results of the last run, as a JSON object, including the number of
+ * spawns per millisecond, and the pool hits and misses, for each kind of churn.
+ */
+-(NSString*) resultJSON;
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3BitmapLabelBenchmark
+
+/**
+ * CC3BitmapLabelBenchmark measures the cost of updating the text of a number of bitmap font
+ * labels, such as the scores and timers of a HUD, each of which changes on every frame.
+ *
+ * Each update sets a counter string, whose last few digits change, into every label. The updates
+ * are performed both by rebuilding the entire mesh of each label, using the
+ * populateAsBitmapFontLabelFromString:fromFontFile:andLineHeight:andTextAlignment:andRelativeOrigin:andTessellation:
+ * method of CC3MeshNode, and by setting the labelString property of a CC3BitmapLabelNode, which
+ * rewrites only the glyphs that changed.
+ *
+ * The labels are not added to a scene, and nothing is drawn.
+ *
+ * This class should be considered for testing and experimental use only, and there is no
+ * need to include it in any finished application.
+ */
+@interface CC3BitmapLabelBenchmark : CC3Benchmark {
+	NSString* fontFileName;
+	GLuint labelCount;
+	GLuint updateCount;
+	ccTime rebuildTime;
+	ccTime incrementalTime;
+}
+
+/** The bitmap font file used by the labels. */
+@property(nonatomic, readonly) NSString* fontFileName;
+
+/** The number of labels updated. */
+@property(nonatomic, readonly) GLuint labelCount;
+
+/** The number of times the text of each label is updated. */
+@property(nonatomic, readonly) GLuint updateCount;
+
+/** The total time, in seconds, spent updating the labels by rebuilding their meshes during the last run. */
+@property(nonatomic, readonly) ccTime rebuildTime;
+
+/** The total time, in seconds, spent updating the labels incrementally during the last run. */
+@property(nonatomic, readonly) ccTime incrementalTime;
+
+
+#pragma mark Allocation and initialization
+
+/**
+ * Initializes this instance to update the specified number of labels, displayed in the
+ * font loaded from the specified bitmap font file, the specified number of times.
+ */
+-(id) initFromFontFile: (NSString*) aFileName withLabelCount: (GLuint) lblCount updates: (GLuint) updCount;
+
+/**
+ * Allocates and initializes an autoreleased instance to update the specified number of labels,
+ * displayed in the font loaded from the specified bitmap font file, the specified number of times.
+ */
++(id) benchmarkFromFontFile: (NSString*) aFileName withLabelCount: (GLuint) lblCount updates: (GLuint) updCount;
+
+
+#pragma mark Running
+
+/** Updates the labels by rebuilding their meshes, and incrementally. */
+-(void) run;
+
+/**
+ * Returns the results of the last run, as a JSON object, including the number of
+ * label updates per millisecond by each method.
+ */
+-(NSString*) resultJSON;
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3VertexBufferUpdateBenchmark
+
+/**
+ * CC3VertexBufferUpdateBenchmark measures the cost of copying changed vertex content to a GL
+ * vertex buffer, when only a small portion of the vertices of a large mesh change on each frame,
+ * such as when deforming a small area of terrain or cloth.
+ *
+ * On each simulated frame, the locations of a contiguous window of vertices are changed, using
+ * the setLocation:at: method of CC3VertexLocations, and the window is moved along the mesh from
+ * frame to frame. The changes are copied to the GL engine in four ways:
+ *   - by updating the entire GL buffer, using the updateGLBuffer method.
+ *   - by updating only the dirty vertex range, using glBufferSubData.
+ *   - by reloading the entire GL buffer whenever it is dirty, allowing the GL engine to orphan
+ *     the existing buffer memory, as happens when most of the buffer is dirty.
+ *   - by streaming the entire content into the shared CC3OpenGLESVertexStream on each frame,
+ *     as happens for vertex arrays whose shouldStreamVertices property is set to YES.
+ *
+ * The dirty vertex range is copied using the updateGLBufferFromDirtyVertexRange method, which
+ * is also invoked automatically when a vertex array is bound for drawing. The bytesLoaded
+ * property of the GL array buffer binding is used to count the bytes copied to the GL buffer
+ * in each case, and the counts are compared to the bytes expected for each case. Any
+ * discrepancies are reported as mismatches. The statistics of the vertex stream, including
+ * the number of stalls avoided by streaming into a ring of GL buffers, are also reported.
+ *
+ * Streaming advances the frames of the shared vertex stream, and so the benchmark should not be
+ * run while a scene is being drawn.
+ *
+ * This benchmark requires a GL context. If the GL buffer cannot be created, nothing is measured.
+ *
+ * This class should be considered for testing and experimental use only, and there is no
+ * need to include it in any finished application.
+ */
+@interface CC3VertexBufferUpdateBenchmark : CC3Benchmark {
+	CC3VertexLocations* vertexLocations;
+	GLuint vertexCount;
+	GLuint changeCount;
+	GLuint frameCount;
+	GLuint fullBytes;
+	GLuint rangeBytes;
+	GLuint reloadBytes;
+	GLuint streamBytes;
+	GLuint streamStallsAvoided;
+	GLuint streamOrphanCount;
+	GLuint mismatchCount;
+	ccTime fullTime;
+	ccTime rangeTime;
+	ccTime reloadTime;
+	ccTime streamTime;
+}
+
+/** The number of vertices in the mesh. */
+@property(nonatomic, readonly) GLuint vertexCount;
+
+/** The number of vertices whose locations are changed on each frame. */
+@property(nonatomic, readonly) GLuint changeCount;
+
+/** The number of simulated frames for which each update technique is run. */
+@property(nonatomic, readonly) GLuint frameCount;
+
+/** The number of bytes copied to the GL buffer when updating the entire buffer during the last run. */
+@property(nonatomic, readonly) GLuint fullBytes;
+
+/** The number of bytes copied to the GL buffer when updating the dirty vertex range during the last run. */
+@property(nonatomic, readonly) GLuint rangeBytes;
+
+/** The number of bytes copied to the GL buffer when reloading the buffer during the last run. */
+@property(nonatomic, readonly) GLuint reloadBytes;
+
+/** The number of bytes copied to the vertex stream when streaming the content during the last run. */
+@property(nonatomic, readonly) GLuint streamBytes;
+
+/** The number of stalls avoided by the vertex stream when streaming the content during the last run. */
+@property(nonatomic, readonly) GLuint streamStallsAvoided;
+
+/** The number of times the vertex stream orphaned buffer storage when streaming the content during the last run. */
+@property(nonatomic, readonly) GLuint streamOrphanCount;
+
+/**
+ * The number of update techniques that copied a different number of bytes to the GL buffer
+ * than expected during the last run.
+ */
+@property(nonatomic, readonly) GLuint mismatchCount;
+
+/** The total time, in seconds, spent updating the entire buffer during the last run. */
+@property(nonatomic, readonly) ccTime fullTime;
+
+/** The total time, in seconds, spent updating the dirty vertex range during the last run. */
+@property(nonatomic, readonly) ccTime rangeTime;
+
+/** The total time, in seconds, spent reloading the buffer during the last run. */
+@property(nonatomic, readonly) ccTime reloadTime;
+
+/** The total time, in seconds, spent streaming the content during the last run. */
+@property(nonatomic, readonly) ccTime streamTime;
+
+
+#pragma mark Allocation and initialization
+
+/**
+ * Initializes this instance to change the locations of the specified number of vertices,
+ * within a mesh of the specified number of vertices, on each of the specified number of frames.
+ */
+-(id) initWithVertexCount: (GLuint) vtxCount changesPerFrame: (GLuint) changes frames: (GLuint) frames;
+
+/**
+ * Allocates and initializes an autoreleased instance to change the locations of the specified
+ * number of vertices, within a mesh of the specified number of vertices, on each of the specified
+ * number of frames.
+ */
++(id) benchmarkWithVertexCount: (GLuint) vtxCount changesPerFrame: (GLuint) changes frames: (GLuint) frames;
+
+
+#pragma mark Running
+
+/** Updates the GL buffer using each of the update techniques. */
+-(void) run;
+
+/**
+ * Returns the results of the last run, as a JSON object, including the number of bytes
+ * copied to the GL buffer, and the time taken, by each of the update techniques.
+ */
+-(NSString*) resultJSON;
+
+@end
@@ -0,0 +1,2506 @@
+/*
+ * CC3SceneBenchmark.m
+ *
+ * cocos3d 2.0.0
+ * Author: Bill Hollings
+ * Copyright (c) 2010-2013 The Brenwill Workshop Ltd. All rights reserved.
+ * http://www.brenwill.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * http://en.wikipedia.org/wiki/MIT_License
+ * 
+ * See header file CC3SceneBenchmark.h for full API documentation.
+ */
+
+#import "CC3SceneBenchmark.h"
+#import "CC3ModelSampleFactory.h"
+#import "CC3PointParticleSamples.h"
+#import "CC3MeshParticleSamples.h"
+#import "CC3ParametricMeshNodes.h"
+#import "CC3PODResourceNode.h"
+#import "CC3ShadowVolumes.h"
+#import "CC3Billboard.h"
+#import "CC3TextureLoader.h"
+#import <OpenGLES/EAGL.h>
+#import "CC3NodeAnimation.h"
+#import "CC3OpenGLESEngine.h"
+
+
+// The size of the viewport used when running a benchmark.
+#define kCC3SceneBenchmarkViewportWidth		1024
+#define kCC3SceneBenchmarkViewportHeight	768
+
+// The spacing between nodes arranged in a grid in the representative scenes.
+#define kCC3SceneBenchmarkGridSpacing		100.0f
+
+
+#pragma mark -
+#pragma mark CC3Benchmark
+
+@implementation CC3Benchmark
+
+@synthesize name;
+
+-(void) dealloc {
+	[name release];
+	[super dealloc];
+}
+
+-(NSString*) description { return [NSString stringWithFormat: @"%@ '%@'", [self class], name]; }
+
+-(void) run {}
+
+-(NSString*) resultJSON { return [NSString stringWithFormat: @"{\"name\":\"%@\"}", name]; }
+
+-(double) rateOf: (double) opCount perMillisecondIn: (ccTime) aTime {
+	return (aTime > 0.0) ? opCount / (aTime * 1000.0) : 0.0;
+}
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3CountingDrawCommandExecutor
+
+/**
+ * A headless CC3DrawCommandExecutor that does not draw anything, but adds the nodes, drawing
+ * calls and faces that would have been submitted to the GL engine to the performance statistics.
+ */
+@interface CC3CountingDrawCommandExecutor : NSObject <CC3DrawCommandExecutor>
++(id) executor;
+@end
+
+@implementation CC3CountingDrawCommandExecutor
+
+-(BOOL) isHeadless { return YES; }
+
+-(void) executeCommandList: (CC3DrawCommandList*) cmdList withVisitor: (CC3NodeDrawingVisitor*) visitor {
+	CC3PerformanceStatistics* stats = visitor.performanceStatistics;
+	GLuint cmdCount = cmdList.commandCount;
+	for (GLuint i = 0; i < cmdCount; i++) {
+		CC3DrawCommand* cmd = [cmdList commandAt: i];
+		[stats incrementNodesDrawn];
+		if (cmd->shouldDrawLive) continue;
+		[stats addDrawingCallsMade: cmd->drawRangeCount];
+		[stats addFacesPresented: cmd->faceCount];
+	}
+}
+
++(id) executor { return [[[self alloc] init] autorelease]; }
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3NullTextureUploader
+
+/**
+ * A headless CC3TextureUploader that allocates texture names, but does not submit
+ * anything to the GL engine. This allows files containing textures to be loaded
+ * without a GL context.
+ */
+@interface CC3NullTextureUploader : NSObject <CC3TextureUploader> {
+	GLuint textureNameCount;
+}
++(id) uploader;
+@end
+
+@implementation CC3NullTextureUploader
+
+-(BOOL) isHeadless { return YES; }
+
+-(GLuint) generateTextureNameWithWidth: (GLuint) width
+								height: (GLuint) height
+							levelCount: (GLuint) levelCount {
+	return ++textureNameCount;
+}
+
+-(void) uploadLevel: (GLuint) level
+		  ofTexture: (GLuint) texName
+		  withWidth: (GLuint) width
+		  andHeight: (GLuint) height
+			 pixels: (const GLvoid*) pixels {}
+
+-(void) completeTexture: (GLuint) texName withLevelCount: (GLuint) levelCount {}
+
+-(BOOL) copyLevels: (GLuint) levelCount
+		startingAt: (GLuint) srcLevel
+		 ofTexture: (GLuint) srcTexName
+	   intoTexture: (GLuint) dstTexName {
+	return YES;
+}
+
+-(void) deleteTextureName: (GLuint) texName {}
+
++(id) uploader { return [[[self alloc] init] autorelease]; }
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3SceneBenchmark
+
+// Template methods of CC3Node that are used to compare lookups.
+@interface CC3Node (TemplateMethods)
+-(CC3Node*) findNodeNamed: (NSString*) aName;
+-(CC3Node*) findNodeTagged: (GLuint) aTag;
+@end
+
+@interface CC3SceneBenchmark (TemplateMethods)
+-(void) openScene;
+-(void) benchmarkNodeLookup;
+-(void) appendPhase: (CC3PerformancePhase) phase toJSON: (NSMutableString*) json;
++(CC3Scene*) makeSceneNamed: (NSString*) aName withExtent: (GLfloat) extent;
++(CC3Vector) gridLocationAt: (GLuint) index of: (GLuint) count;
++(GLfloat) gridExtentOf: (GLuint) count;
++(CC3Scene*) makeShadowSceneNamed: (NSString*) aName withCount: (GLuint) nodeCount;
+@end
+
+@implementation CC3SceneBenchmark
+
+@synthesize scene, frameCount, warmUpFrameCount, frameInterval, animationDuration;
+@synthesize isHeadless, shouldBenchmarkNodeLookup, animatedNodes, runTime;
+@synthesize nodeLookupCount, indexedNodeLookupTime, searchedNodeLookupTime;
+
+-(void) dealloc {
+	[scene release];
+	[animatedNodes release];
+	[super dealloc];
+}
+
+-(void) addAnimatedNode: (CC3Node*) aNode { [animatedNodes addObject: aNode]; }
+
+-(CC3PerformanceStatistics*) performanceStatistics {
+	if ( !scene.performanceStatistics ) scene.performanceStatistics = [CC3PerformanceStatistics statistics];
+	return scene.performanceStatistics;
+}
+
+
+#pragma mark Allocation and initialization
+
+-(id) initWithName: (NSString*) aName onScene: (CC3Scene*) aScene {
+	if ( (self = [super init]) ) {
+		name = [aName retain];
+		scene = [aScene retain];
+		animatedNodes = [[CCArray array] retain];
+		frameCount = 300;
+		warmUpFrameCount = 30;
+		frameInterval = 1.0 / 60.0;
+		animationDuration = 1.0;
+		elapsedTime = 0.0;
+		runTime = 0.0;
+		nodeLookupCount = 0;
+		indexedNodeLookupTime = 0.0;
+		searchedNodeLookupTime = 0.0;
+		isHeadless = YES;
+		shouldBenchmarkNodeLookup = YES;
+	}
+	return self;
+}
+
++(id) benchmarkWithName: (NSString*) aName onScene: (CC3Scene*) aScene {
+	return [[[self alloc] initWithName: aName onScene: aScene] autorelease];
+}
+
+
+#pragma mark Representative scenes
+
+/**
+ * Returns a scene with the specified name, containing a camera looking at the origin
+ * from a distance that will show content of the specified extent, and a single light.
+ */
++(CC3Scene*) makeSceneNamed: (NSString*) aName withExtent: (GLfloat) extent {
+	CC3Scene* aScene = [CC3Scene scene];
+	aScene.name = aName;
+
+	GLfloat camDist = MAX(extent, kCC3SceneBenchmarkGridSpacing) * 1.5f;
+	CC3Camera* cam = [CC3Camera nodeWithName: @"Camera"];
+	cam.location = cc3v(0.0, 0.0, camDist);
+	cam.targetLocation = kCC3VectorZero;
+	cam.farClippingDistance = camDist * 4.0f;
+	[aScene addChild: cam];
+
+	CC3Light* lamp = [CC3Light nodeWithName: @"Lamp"];
+	lamp.location = cc3v(camDist, camDist, camDist);
+	lamp.isDirectionalOnly = NO;
+	[aScene addChild: lamp];
+
+	return aScene;
+}
+
+/** Returns the location of the node at the specified index within a square grid of the specified number of nodes. */
++(CC3Vector) gridLocationAt: (GLuint) index of: (GLuint) count {
+	GLuint side = (GLuint)ceilf(sqrtf((GLfloat)count));
+	GLfloat offset = (side - 1) * kCC3SceneBenchmarkGridSpacing * 0.5f;
+	return cc3v((index % side) * kCC3SceneBenchmarkGridSpacing - offset,
+				(index / side) * kCC3SceneBenchmarkGridSpacing - offset,
+				0.0);
+}
+
+/** Returns the width of a square grid of the specified number of nodes. */
++(GLfloat) gridExtentOf: (GLuint) count {
+	return ceilf(sqrtf((GLfloat)count)) * kCC3SceneBenchmarkGridSpacing;
+}
+
++(CC3ResourceNode*) nodeFromPODFile: (NSString*) aFilePath {
+	if ([EAGLContext currentContext]) return [CC3PODResourceNode nodeFromFile: aFilePath];
+
+	CC3TextureLoader* sharedLoader = CC3TextureLoader.hasSharedLoader ? CC3TextureLoader.sharedLoader : nil;
+	[[sharedLoader retain] autorelease];
+	BOOL wasLoadingInBackground = CC3Texture.shouldLoadInBackground;
+
+	CC3TextureLoader* loader = [CC3TextureLoader loader];
+	loader.uploader = [CC3NullTextureUploader uploader];
+	CC3TextureLoader.sharedLoader = loader;
+	CC3Texture.shouldLoadInBackground = YES;
+
+	CC3ResourceNode* podNode = [CC3PODResourceNode nodeFromFile: aFilePath];
+	[loader finishLoading];
+
+	CC3Texture.shouldLoadInBackground = wasLoadingInBackground;
+	CC3TextureLoader.sharedLoader = sharedLoader;
+	return podNode;
+}
+
++(id) meshNodeBenchmarkWithCount: (GLuint) nodeCount {
+	CC3Scene* aScene = [self makeSceneNamed: @"MeshNodes" withExtent: [self gridExtentOf: nodeCount]];
+	CC3ModelSampleFactory* factory = [CC3ModelSampleFactory factory];
+	for (GLuint i = 0; i < nodeCount; i++) {
+		NSString* nodeName = [NSString stringWithFormat: @"Teapot-%u", i];
+		CC3MeshNode* teapot = [factory makeUniColoredTeapotNamed: nodeName withColor: kCCC4FWhite];
+		teapot.tag = i + 1;
+		teapot.uniformScale = kCC3SceneBenchmarkGridSpacing * 0.5f;
+		teapot.location = [self gridLocationAt: i of: nodeCount];
+		[aScene addChild: teapot];
+	}
+	return [self benchmarkWithName: @"MeshNodes" onScene: aScene];
+}
+
++(id) skinnedCharacterBenchmarkFromFile: (NSString*) aFilePath withCount: (GLuint) charCount {
+	CC3Scene* aScene = [self makeSceneNamed: @"SkinnedCharacters"
+								 withExtent: [self gridExtentOf: charCount]];
+	CC3SceneBenchmark* bm = [self benchmarkWithName: @"SkinnedCharacters" onScene: aScene];
+
+	// Load the characters once, and copy the loaded node for each additional character.
+	CC3ResourceNode* podNode = [self nodeFromPODFile: aFilePath];
+	podNode.resource.expectsVerticallyFlippedTextures = NO;
+	for (GLuint i = 0; i < charCount; i++) {
+		NSString* charName = [NSString stringWithFormat: @"Character-%u", i];
+		CC3Node* character = i ? [[podNode copyWithName: charName] autorelease] : podNode;
+		character.name = charName;
+		character.tag = i + 1;
+		character.location = [self gridLocationAt: i of: charCount];
+		[aScene addChild: character];
+		[bm addAnimatedNode: character];
+	}
+	return bm;
+}
+
++(id) pointParticleBenchmarkWithCount: (GLuint) emitterCount {
+	CC3Scene* aScene = [self makeSceneNamed: @"PointParticles" withExtent: [self gridExtentOf: emitterCount]];
+	for (GLuint i = 0; i < emitterCount; i++) {
+		NSString* emName = [NSString stringWithFormat: @"PointHose-%u", i];
+		CC3VariegatedPointParticleHoseEmitter* emitter = [CC3VariegatedPointParticleHoseEmitter nodeWithName: emName];
+		emitter.vertexContentTypes = kCC3VertexContentLocation |
+									 kCC3VertexContentColor |
+									 kCC3VertexContentPointSize;
+		emitter.emissionRate = 100.0f;
+		emitter.tag = i + 1;
+
+		CC3HoseParticleNavigator* nav = (CC3HoseParticleNavigator*)emitter.particleNavigator;
+		nav.minParticleLifeSpan = 3.0f;
+		nav.maxParticleLifeSpan = 4.0f;
+		nav.minParticleSpeed = 20.0f;
+		nav.maxParticleSpeed = 40.0f;
+		nav.dispersionAngle = CGSizeMake(30.0, 30.0);
+		nav.nozzle.location = [self gridLocationAt: i of: emitterCount];
+		nav.nozzle.rotation = cc3v(-90.0, 0.0, 0.0);
+
+		[aScene addChild: nav.nozzle];
+		[aScene addChild: emitter];
+		[emitter play];
+	}
+	return [self benchmarkWithName: @"PointParticles" onScene: aScene];
+}
+
++(id) meshParticleBenchmarkWithCount: (GLuint) emitterCount {
+	CC3Scene* aScene = [self makeSceneNamed: @"MeshParticles" withExtent: [self gridExtentOf: emitterCount]];
+
+	CC3MeshNode* boxNode = [CC3MeshNode nodeWithName: @"ParticleTemplate"];
+	[boxNode populateAsSolidBox: CC3BoundingBoxMake(-2.0, -2.0, -2.0, 2.0, 2.0, 2.0)];
+	CC3VertexArrayMesh* boxMesh = (CC3VertexArrayMesh*)boxNode.mesh;
+
+	for (GLuint i = 0; i < emitterCount; i++) {
+		NSString* emName = [NSString stringWithFormat: @"MeshHose-%u", i];
+		CC3MeshParticleEmitter* emitter = [CC3MeshParticleEmitter nodeWithName: emName];
+		emitter.vertexContentTypes = kCC3VertexContentLocation |
+									 kCC3VertexContentNormal |
+									 kCC3VertexContentColor;
+		emitter.particleClass = [CC3UniformlyEvolvingMeshParticle class];
+		emitter.particleTemplateMesh = boxMesh;
+		emitter.emissionRate = 50.0f;
+		emitter.tag = i + 1;
+
+		CC3HoseParticleNavigator* nav = [CC3HoseParticleNavigator navigator];
+		nav.minParticleLifeSpan = 4.0f;
+		nav.maxParticleLifeSpan = 6.0f;
+		nav.minParticleSpeed = 10.0f;
+		nav.maxParticleSpeed = 20.0f;
+		nav.dispersionAngle = CGSizeMake(30.0, 30.0);
+		emitter.particleNavigator = nav;
+		nav.nozzle.location = [self gridLocationAt: i of: emitterCount];
+		nav.nozzle.rotation = cc3v(-90.0, 0.0, 0.0);
+
+		[aScene addChild: nav.nozzle];
+		[aScene addChild: emitter];
+		[emitter play];
+	}
+	return [self benchmarkWithName: @"MeshParticles" onScene: aScene];
+}
+
+/**
+ * Returns a scene containing the specified number of sphere mesh nodes, each casting shadows
+ * from the lamp, which is pointed at the center of the grid so that a shadow map covers it.
+ */
++(CC3Scene*) makeShadowSceneNamed: (NSString*) aName withCount: (GLuint) nodeCount {
+	CC3Scene* aScene = [self makeSceneNamed: aName withExtent: [self gridExtentOf: nodeCount]];
+	CC3Light* lamp = (CC3Light*)[aScene getNodeNamed: @"Lamp"];
+	lamp.targetLocation = kCC3VectorZero;
+	for (GLuint i = 0; i < nodeCount; i++) {
+		NSString* nodeName = [NSString stringWithFormat: @"Sphere-%u", i];
+		CC3MeshNode* sphere = [CC3MeshNode nodeWithName: nodeName];
+		[sphere populateAsSphereWithRadius: kCC3SceneBenchmarkGridSpacing * 0.3f
+						   andTessellation: ccg(16, 16)];
+		sphere.tag = i + 1;
+		sphere.location = [self gridLocationAt: i of: nodeCount];
+		[aScene addChild: sphere];
+		[sphere addShadowVolumesForLight: lamp];
+	}
+	return aScene;
+}
+
++(id) shadowVolumeBenchmarkWithCount: (GLuint) nodeCount {
+	CC3Scene* aScene = [self makeShadowSceneNamed: @"ShadowVolumes" withCount: nodeCount];
+	return [self benchmarkWithName: @"ShadowVolumes" onScene: aScene];
+}
+
++(id) shadowMapBenchmarkWithCount: (GLuint) nodeCount {
+	CC3Scene* aScene = [self makeShadowSceneNamed: @"ShadowMap" withCount: nodeCount];
+	((CC3Light*)[aScene getNodeNamed: @"Lamp"]).shadowTechnique = kCC3ShadowTechniqueShadowMap;
+	return [self benchmarkWithName: @"ShadowMap" onScene: aScene];
+}
+
++(id) cascadedShadowMapBenchmarkWithCount: (GLuint) nodeCount {
+	CC3Scene* aScene = [self makeShadowSceneNamed: @"CascadedShadowMap" withCount: nodeCount];
+	CC3Light* lamp = (CC3Light*)[aScene getNodeNamed: @"Lamp"];
+	lamp.isDirectionalOnly = YES;
+	lamp.shadowTechnique = kCC3ShadowTechniqueShadowMap;
+	return [self benchmarkWithName: @"CascadedShadowMap" onScene: aScene];
+}
+
++(id) billboardBenchmarkWithCount: (GLuint) billboardCount {
+	CC3Scene* aScene = [self makeSceneNamed: @"Billboards" withExtent: [self gridExtentOf: billboardCount]];
+	for (GLuint i = 0; i < billboardCount; i++) {
+		CCNode* bbContent = [CCNode node];
+		bbContent.contentSize = CGSizeMake(32.0, 16.0);
+		NSString* bbName = [NSString stringWithFormat: @"Billboard-%u", i];
+		CC3Billboard* bb = [CC3Billboard nodeWithName: bbName withBillboard: bbContent];
+		bb.shouldDrawAs2DOverlay = YES;
+		bb.tag = i + 1;
+		bb.location = [self gridLocationAt: i of: billboardCount];
+		[aScene addChild: bb];
+	}
+	return [self benchmarkWithName: @"Billboards" onScene: aScene];
+}
+
+/**
+ * Each copy is a group node holding a chain of limbs, each of which holds a pair of digits.
+ * The names and tags of the limbs and digits are the same in every copy.
+ */
++(id) nodeLookupBenchmarkWithCount: (GLuint) copyCount {
+	CC3Scene* aScene = [self makeSceneNamed: @"NodeLookup" withExtent: [self gridExtentOf: copyCount]];
+	GLuint limbCount = 8;
+	for (GLuint i = 0; i < copyCount; i++) {
+		CC3Node* group = [CC3Node nodeWithName: [NSString stringWithFormat: @"Group-%u", i]];
+		group.tag = i + 1000;
+		group.location = [self gridLocationAt: i of: copyCount];
+		CC3Node* limbParent = group;
+		for (GLuint j = 0; j < limbCount; j++) {
+			CC3Node* limb = [CC3Node nodeWithName: [NSString stringWithFormat: @"Limb-%u", j]];
+			limb.tag = j + 1;
+			for (GLuint k = 0; k < 2; k++) {
+				CC3Node* digit = [CC3Node nodeWithName: [NSString stringWithFormat: @"Digit-%u-%u", j, k]];
+				digit.tag = limbCount + (j * 2) + k + 1;
+				[limb addChild: digit];
+			}
+			[limbParent addChild: limb];
+			limbParent = limb;
+		}
+		[aScene addChild: group];
+	}
+	return [self benchmarkWithName: @"NodeLookup" onScene: aScene];
+}
+
++(CCArray*) standardBenchmarks {
+	CCArray* bms = [CCArray array];
+	[bms addObject: [self meshNodeBenchmarkWithCount: 400]];
+	[bms addObject: [self nodeLookupBenchmarkWithCount: 100]];
+	if ([[NSBundle mainBundle] pathForResource: @"man" ofType: @"pod"]) {
+		[bms addObject: [self skinnedCharacterBenchmarkFromFile: @"man.pod" withCount: 10]];
+		[bms addObject: [CC3SkeletalAnimationBenchmark benchmarkFromFile: @"man.pod" withCount: 1]];
+		[bms addObject: [CC3SkeletalAnimationBenchmark benchmarkFromFile: @"man.pod" withCount: 10]];
+		[bms addObject: [CC3SkeletalAnimationBenchmark benchmarkFromFile: @"man.pod" withCount: 100]];
+		[bms addObject: [CC3AnimationBlendingBenchmark benchmarkFromFile: @"man.pod" withCount: 50 blendingClips: 3]];
+		[bms addObject: [CC3PrefabBenchmark benchmarkFromFile: @"man.pod" withCount: 100]];
+	}
+	[bms addObject: [self pointParticleBenchmarkWithCount: 10]];
+	[bms addObject: [self meshParticleBenchmarkWithCount: 10]];
+	[bms addObject: [self shadowVolumeBenchmarkWithCount: 50]];
+	[bms addObject: [self shadowMapBenchmarkWithCount: 50]];
+	[bms addObject: [self cascadedShadowMapBenchmarkWithCount: 50]];
+	[bms addObject: [self billboardBenchmarkWithCount: 200]];
+	[bms addObject: [CC3BoundingVolumeBenchmark benchmarkWithVertexCount: 20000 interleaved: NO]];
+	[bms addObject: [CC3BoundingVolumeBenchmark benchmarkWithVertexCount: 20000 interleaved: YES]];
+	[bms addObject: [CC3TextureStreamingBenchmark benchmarkWithTextureCount: 200 ofSize: 256]];
+	[bms addObject: [CC3LightAssignmentBenchmark benchmarkWithLightCount: 100 sphereCount: 2000]];
+	[bms addObject: [CC3ShadowVolumeCacheBenchmark benchmarkWithTessellation: 64]];
+	[bms addObject: [CC3ObjectPoolBenchmark benchmarkWithSpawnCount: 200 cycles: 50]];
+	[bms addObject: [CC3VertexBufferUpdateBenchmark benchmarkWithVertexCount: 65536 changesPerFrame: 1024 frames: 100]];
+	if ([[NSBundle mainBundle] pathForResource: @"Arial32BMGlyph" ofType: @"fnt"])
+		[bms addObject: [CC3BitmapLabelBenchmark benchmarkFromFontFile: @"Arial32BMGlyph.fnt" withLabelCount: 40 updates: 100]];
+	for (NSString* podName in [NSArray arrayWithObjects: @"man", @"Head", @"BeachBall", @"cocos3dMascot", nil]) {
+		if ([[NSBundle mainBundle] pathForResource: podName ofType: @"pod"]) {
+			NSString* podFile = [podName stringByAppendingPathExtension: @"pod"];
+			[bms addObject: [CC3PODTangentSpaceBenchmark benchmarkFromFile: podFile]];
+		}
+	}
+	return bms;
+}
+
+
+#pragma mark Running
+
+/**
+ * If headless, no GL context is current while the frames are run, so that any GL calls are ignored.
+ * Because the GL state trackers and the material and mesh switching state were nonetheless driven
+ * by those frames, they are invalidated once the GL context has been restored.
+ */
+-(void) run {
+	LogInfo(@"%@ running %u frames after %u warm-up frames %@", self,
+			frameCount, warmUpFrameCount, (isHeadless ? @"headless" : @"with GL"));
+	EAGLContext* glContext = [[[EAGLContext currentContext] retain] autorelease];
+	if (isHeadless) [EAGLContext setCurrentContext: nil];
+
+	[self openScene];
+
+	for (GLuint i = 0; i < warmUpFrameCount; i++) [self runFrame];
+
+	CC3PerformanceStatistics* stats = self.performanceStatistics;
+	[stats reset];
+	[stats clearFrameTimings];
+
+	double startTime = CC3PerformanceTimeNow();
+	for (GLuint i = 0; i < frameCount; i++) [self runFrame];
+	runTime = CC3PerformanceTimeNow() - startTime;
+
+	if (isHeadless) {
+		[EAGLContext setCurrentContext: glContext];
+		[self invalidateTrackedGLState];
+	}
+
+	if (shouldBenchmarkNodeLookup) [self benchmarkNodeLookup];
+}
+
+/**
+ * Prepares the scene to be driven by this benchmark, by establishing performance statistics,
+ * sizing the viewport, and playing the scene. If headless, the drawVisitor of the scene is
+ * given a draw command list that uses a headless executor.
+ */
+-(void) openScene {
+	[self performanceStatistics];
+	elapsedTime = 0.0;
+
+	[scene.viewportManager updateBounds: CGRectMake(0.0, 0.0,
+													kCC3SceneBenchmarkViewportWidth,
+													kCC3SceneBenchmarkViewportHeight)
+				  withDeviceOrientation: UIDeviceOrientationPortrait];
+	if (isHeadless) {
+		scene.shouldUseDrawCommandList = YES;
+		scene.drawVisitor.commandList.executor = [CC3CountingDrawCommandExecutor executor];
+	} else {
+		[scene createGLBuffers];
+	}
+	[scene play];
+	[scene updateScene];
+}
+
+/**
+ * Discards the GL state cached by the GL state trackers, and the material and mesh switching
+ * state, none of which reflect the GL engine after GL calls have been ignored.
+ */
+-(void) invalidateTrackedGLState {
+	[CC3OpenGLESEngine.engine invalidateTrackedState];
+	[CC3Material resetSwitching];
+	[CC3VertexArrayMesh resetSwitching];
+}
+
+-(void) runFrame {
+	elapsedTime += frameInterval;
+	ccTime animFrac = fmodf(elapsedTime / animationDuration, 1.0f);
+	for (CC3Node* aNode in animatedNodes) [aNode establishAnimationFrameAt: animFrac];
+
+	[scene updateScene: frameInterval];
+	[scene drawScene];
+}
+
+/**
+ * Retrieves each named and tagged node in the scene from its parent, first from the index
+ * maintained by the scene, and then by searching the node structure, and records the time
+ * taken by each.
+ */
+-(void) benchmarkNodeLookup {
+	CCArray* allNodes = [scene flatten];
+	nodeLookupCount = 0;
+
+	double startTime = CC3PerformanceTimeNow();
+	for (CC3Node* aNode in allNodes) {
+		CC3Node* searchRoot = aNode.parent ? aNode.parent : aNode;
+		[searchRoot getNodeNamed: aNode.name];
+		[searchRoot getNodeTagged: aNode.tag];
+		nodeLookupCount += 2;
+	}
+	indexedNodeLookupTime = CC3PerformanceTimeNow() - startTime;
+
+	startTime = CC3PerformanceTimeNow();
+	for (CC3Node* aNode in allNodes) {
+		CC3Node* searchRoot = aNode.parent ? aNode.parent : aNode;
+		[searchRoot findNodeNamed: aNode.name];
+		[searchRoot findNodeTagged: aNode.tag];
+	}
+	searchedNodeLookupTime = CC3PerformanceTimeNow() - startTime;
+}
+
+
+#pragma mark Results
+
+-(void) appendPhase: (CC3PerformancePhase) phase toJSON: (NSMutableString*) json {
+	CC3PerformanceStatistics* stats = self.performanceStatistics;
+	[json appendFormat: @"\"%@\":{\"avg\":%.4f,\"p50\":%.4f,\"p95\":%.4f,\"p99\":%.4f}",
+	 NSStringFromCC3PerformancePhase(phase),
+	 [stats averageTimeForPhase: phase] * 1000.0,
+	 [stats p50TimeForPhase: phase] * 1000.0,
+	 [stats p95TimeForPhase: phase] * 1000.0,
+	 [stats p99TimeForPhase: phase] * 1000.0];
+}
+
+-(NSString*) resultJSON {
+	CC3PerformanceStatistics* stats = self.performanceStatistics;
+	NSMutableString* json = [NSMutableString stringWithCapacity: 2048];
+
+	[json appendFormat: @"{\"name\":\"%@\",\"headless\":%@,\"frames\":%u,\"frameInterval\":%.4f,\"runTime\":%.4f,",
+	 name, (isHeadless ? @"true" : @"false"), frameCount, frameInterval * 1000.0, runTime * 1000.0];
+
+	[json appendFormat: @"\"counters\":{\"updatesHandled\":%u,\"nodesUpdated\":%u,\"nodesTransformed\":%u,"
+	 @"\"framesHandled\":%u,\"nodesVisitedForDrawing\":%u,\"nodesDrawn\":%u,"
+	 @"\"drawingCallsMade\":%u,\"facesPresented\":%u,\"bonesUpdated\":%u,\"bonesSkipped\":%u,"
+	 @"\"shadowVolumesCulled\":%u,\"shadowLightsCulled\":%u,\"shadowCastersCulled\":%u},",
+	 stats.updatesHandled, stats.nodesUpdated, stats.nodesTransformed,
+	 stats.framesHandled, stats.nodesVisitedForDrawing, stats.nodesDrawn,
+	 stats.drawingCallsMade, stats.facesPresented, stats.bonesUpdated, stats.bonesSkipped,
+	 stats.shadowVolumesCulled, stats.shadowLightsCulled, stats.shadowCastersCulled];
+
+	[json appendFormat: @"\"averages\":{\"nodesUpdatedPerUpdate\":%.2f,\"nodesTransformedPerUpdate\":%.2f,"
+	 @"\"nodesVisitedForDrawingPerFrame\":%.2f,\"nodesDrawnPerFrame\":%.2f,"
+	 @"\"drawingCallsMadePerFrame\":%.2f,\"facesPresentedPerFrame\":%.2f},",
+	 stats.averageNodesUpdatedPerUpdate, stats.averageNodesTransformedPerUpdate,
+	 stats.averageNodesVisitedForDrawingPerFrame, stats.averageNodesDrawnPerFrame,
+	 stats.averageDrawingCallsMadePerFrame, stats.averageFacesPresentedPerFrame];
+
+	[json appendString: @"\"phases\":{"];
+	for (GLuint phase = 0; phase < kCC3PerformancePhaseCount; phase++) {
+		if (phase) [json appendString: @","];
+		[self appendPhase: phase toJSON: json];
+	}
+	[json appendString: @"}"];
+
+	if (shouldBenchmarkNodeLookup) {
+		[json appendFormat: @",\"nodeLookup\":{\"lookups\":%u,\"indexed\":%.4f,\"searched\":%.4f}",
+		 nodeLookupCount, indexedNodeLookupTime * 1000.0, searchedNodeLookupTime * 1000.0];
+	}
+
+	[json appendString: @"}"];
+	return json;
+}
+
++(NSString*) runBenchmarks: (CCArray*) benchmarks {
+	NSMutableString* json = [NSMutableString stringWithCapacity: (benchmarks.count * 2048 + 16)];
+	[json appendString: @"["];
+	BOOL isFirst = YES;
+	for (id bm in benchmarks) {
+		NSAutoreleasePool* pool = [NSAutoreleasePool new];
+		[bm run];
+		[json appendFormat: @"%@\n%@", (isFirst ? @"" : @","), [bm resultJSON]];
+		isFirst = NO;
+		[pool drain];
+	}
+	[json appendString: @"\n]\n"];
+	return json;
+}
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3PODTangentSpaceBenchmark
+
+@implementation CC3PODTangentSpaceBenchmark
+
+@synthesize filePath, repeatCount, threadCount, splitDifference;
+
+-(void) dealloc {
+	[filePath release];
+	[super dealloc];
+}
+
+-(GLuint) meshCount { return comparison.meshCount; }
+-(GLuint) triangleCount { return comparison.triangleCount; }
+-(GLuint) vertexCountIn { return comparison.vertexCountIn; }
+-(GLuint) vertexCountOut { return comparison.vertexCountOut; }
+-(GLuint) meshesMatched { return comparison.meshesMatched; }
+-(GLuint) meshesDiffered { return comparison.meshesDiffered; }
+-(GLuint) legacyFailures { return comparison.legacyFailures; }
+-(GLuint) failures { return comparison.failures; }
+-(ccTime) legacyTime { return comparison.legacyTime; }
+-(ccTime) generatorTime { return comparison.generatorTime; }
+
+
+#pragma mark Allocation and initialization
+
+-(id) initFromFile: (NSString*) aFilePath {
+	if ( (self = [super init]) ) {
+		self.filePath = aFilePath;
+		self.name = [NSString stringWithFormat: @"TangentSpace-%@", [aFilePath lastPathComponent]];
+		repeatCount = 10;
+		threadCount = 1;
+		splitDifference = 0.9f;
+		memset(&comparison, 0, sizeof(comparison));
+	}
+	return self;
+}
+
++(id) benchmarkFromFile: (NSString*) aFilePath {
+	return [[[self alloc] initFromFile: aFilePath] autorelease];
+}
+
+
+#pragma mark Running
+
+-(void) run {
+	memset(&comparison, 0, sizeof(comparison));
+
+	NSString* absPath = CC3EnsureAbsoluteFilePath(filePath);
+	if ( !CC3ComparePODFileTangentSpaceGeneration(absPath, repeatCount, threadCount, splitDifference, &comparison) ) {
+		LogError(@"%@ could not load POD file %@", self, absPath);
+		return;
+	}
+
+	LogInfo(@"%@ processed %u meshes in %.3f ms, versus %.3f ms for legacy tangent space generation",
+			self, comparison.meshCount, comparison.generatorTime * 1000.0, comparison.legacyTime * 1000.0);
+}
+
+-(NSString*) resultJSON {
+	return [NSString stringWithFormat: @"{\"name\":\"%@\",\"repeats\":%u,\"threads\":%u,\"splitDifference\":%.3f,"
+			@"\"counters\":{\"meshes\":%u,\"triangles\":%u,\"verticesIn\":%u,\"verticesOut\":%u,"
+			@"\"matched\":%u,\"differed\":%u,\"legacyFailures\":%u,\"failures\":%u},"
+			@"\"legacyTime\":%.4f,\"generatorTime\":%.4f}",
+			name, repeatCount, threadCount, splitDifference,
+			comparison.meshCount, comparison.triangleCount, comparison.vertexCountIn, comparison.vertexCountOut,
+			comparison.meshesMatched, comparison.meshesDiffered, comparison.legacyFailures, comparison.failures,
+			comparison.legacyTime * 1000.0, comparison.generatorTime * 1000.0];
+}
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3BoundingVolumeBenchmark
+
+@interface CC3VertexLocations (TemplateMethods)
+-(void) buildBoundingBox;
+-(void) calcRadius;
+@end
+
+@interface CC3BoundingVolumeBenchmark (TemplateMethods)
+-(void) populateVertexLocations;
+@end
+
+
+@implementation CC3BoundingVolumeBenchmark
+
+@synthesize vertexCount, isInterleaved, repeatCount, mismatches, radius, minimalRadius;
+@synthesize elementwiseTime, bulkTime, minimalSphereTime;
+
+-(void) dealloc {
+	[vertexLocations release];
+	[super dealloc];
+}
+
+
+#pragma mark Allocation and initialization
+
+-(id) initWithVertexCount: (GLuint) vtxCount interleaved: (BOOL) interleave {
+	if ( (self = [super init]) ) {
+		vertexCount = vtxCount;
+		isInterleaved = interleave;
+		self.name = [NSString stringWithFormat: @"BoundingVolume-%u-%@",
+					 vtxCount, (interleave ? @"interleaved" : @"packed")];
+		repeatCount = 20;
+		vertexLocations = nil;
+	}
+	return self;
+}
+
++(id) benchmarkWithVertexCount: (GLuint) vtxCount interleaved: (BOOL) interleave {
+	return [[[self alloc] initWithVertexCount: vtxCount interleaved: interleave] autorelease];
+}
+
+
+#pragma mark Running
+
+/**
+ * Populates the vertex locations with a cloud of locations that is dense near the XY-plane
+ * and thins out along the positive Z-axis, so that the center of geometry is well away from
+ * the center of the smallest sphere that encloses the locations.
+ */
+-(void) populateVertexLocations {
+	[vertexLocations release];
+	vertexLocations = [[CC3VertexLocations vertexArrayWithName: name] retain];
+	if (isInterleaved) vertexLocations.vertexStride = sizeof(CC3TexturedVertex);
+	vertexLocations.allocatedVertexCapacity = vertexCount;
+	for (GLuint i = 0; i < vertexCount; i++) {
+		GLfloat zFactor = CC3RandomFloatBetween(0.0f, 1.0f);
+		CC3Vector aLoc = cc3v(CC3RandomFloatBetween(-1.0f, 1.0f),
+							  CC3RandomFloatBetween(-1.0f, 1.0f),
+							  4.0f * zFactor * zFactor * zFactor);
+		[vertexLocations setLocation: aLoc at: i];
+	}
+}
+
+-(void) run {
+	mismatches = 0;
+	elementwiseTime = 0.0;
+	bulkTime = 0.0;
+	minimalSphereTime = 0.0;
+
+	[self populateVertexLocations];
+
+	for (GLuint r = 0; r < repeatCount; r++) {
+
+		// Accumulate each location individually, as retrieved through the locationAt: method
+		double startTime = CC3PerformanceTimeNow();
+		CC3Vector vlMin = [vertexLocations locationAt: 0];
+		CC3Vector vlMax = vlMin;
+		for (GLuint i = 1; i < vertexCount; i++) {
+			CC3Vector vl = [vertexLocations locationAt: i];
+			vlMin = CC3VectorMinimize(vlMin, vl);
+			vlMax = CC3VectorMaximize(vlMax, vl);
+		}
+		CC3Vector cog = CC3BoundingBoxCenter(CC3BoundingBoxFromMinMax(vlMin, vlMax));
+		GLfloat radiusSq = 0.0f;
+		for (GLuint i = 0; i < vertexCount; i++)
+			radiusSq = MAX(radiusSq, CC3VectorDistanceSquared([vertexLocations locationAt: i], cog));
+		GLfloat elementwiseRadius = sqrtf(radiusSq);
+		elementwiseTime += CC3PerformanceTimeNow() - startTime;
+
+		// Build the same boundary using the bulk location functions
+		startTime = CC3PerformanceTimeNow();
+		[vertexLocations buildBoundingBox];
+		[vertexLocations calcRadius];
+		bulkTime += CC3PerformanceTimeNow() - startTime;
+
+		// SIMD summation order may differ in the last bit of the radius
+		radius = vertexLocations.radius;
+		if ( !(CC3BoundingBoxesAreEqual(vertexLocations.boundingBox, CC3BoundingBoxFromMinMax(vlMin, vlMax)) &&
+			   fabsf(radius - elementwiseRadius) <= (elementwiseRadius * 1.0e-5f)) ) mismatches++;
+
+		startTime = CC3PerformanceTimeNow();
+		minimalRadius = [vertexLocations minimalBoundingSphere].radius;
+		minimalSphereTime += CC3PerformanceTimeNow() - startTime;
+	}
+
+	if (mismatches) LogError(@"%@ bulk functions built a different boundary than individual locations in %u of %u runs",
+							 self, mismatches, repeatCount);
+	LogInfo(@"%@ built boundary in %.3f ms, versus %.3f ms from individual locations. Minimal sphere radius %.3f versus %.3f",
+			self, bulkTime * 1000.0, elementwiseTime * 1000.0, minimalRadius, radius);
+
+	[vertexLocations release];
+	vertexLocations = nil;
+}
+
+-(NSString*) resultJSON {
+	return [NSString stringWithFormat: @"{\"name\":\"%@\",\"repeats\":%u,\"interleaved\":%@,"
+			@"\"counters\":{\"vertices\":%u,\"mismatches\":%u},"
+			@"\"radius\":%.4f,\"minimalRadius\":%.4f,"
+			@"\"elementwiseTime\":%.4f,\"bulkTime\":%.4f,\"minimalSphereTime\":%.4f}",
+			name, repeatCount, (isInterleaved ? @"true" : @"false"),
+			vertexCount, mismatches, radius, minimalRadius,
+			elementwiseTime * 1000.0, bulkTime * 1000.0, minimalSphereTime * 1000.0];
+}
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3CharacterAnimationBenchmark
+
+@interface CC3CharacterAnimationBenchmark (TemplateMethods)
+-(void) collectSoftBodyNodesFrom: (CC3Node*) aNode;
+@end
+
+@implementation CC3CharacterAnimationBenchmark
+
+@synthesize filePath, characterCount, sampleCount;
+
+-(void) dealloc {
+	[filePath release];
+	[characters release];
+	[softBodyNodes release];
+	[super dealloc];
+}
+
+-(GLuint) animatedNodeCount { return 0; }
+
+
+#pragma mark Allocation and initialization
+
+-(id) initWithNamePrefix: (NSString*) namePrefix fromFile: (NSString*) aFilePath withCount: (GLuint) charCount {
+	if ( (self = [super init]) ) {
+		filePath = [aFilePath retain];
+		characterCount = charCount;
+		self.name = [NSString stringWithFormat: @"%@-%@-%u", namePrefix,
+					 [[aFilePath lastPathComponent] stringByDeletingPathExtension], charCount];
+		sampleCount = 100;
+		characters = nil;
+		softBodyNodes = nil;
+	}
+	return self;
+}
+
+
+#pragma mark Running
+
+-(void) loadCharacters {
+	[characters release];
+	characters = [[CCArray arrayWithCapacity: characterCount] retain];
+	[softBodyNodes release];
+	softBodyNodes = [[CCArray array] retain];
+
+	CC3ResourceNode* podNode = [CC3SceneBenchmark nodeFromPODFile: filePath];
+	for (GLuint i = 0; i < characterCount; i++) {
+		NSString* charName = [NSString stringWithFormat: @"Character-%u", i];
+		CC3Node* character = i ? [[podNode copyWithName: charName] autorelease] : podNode;
+		[characters addObject: character];
+		[self collectSoftBodyNodesFrom: character];
+	}
+}
+
+-(void) collectSoftBodyNodesFrom: (CC3Node*) aNode {
+	if ( [aNode isKindOfClass: [CC3SoftBodyNode class]] ) {
+		[softBodyNodes addObject: aNode];
+		return;
+	}
+	for (CC3Node* child in aNode.children) [self collectSoftBodyNodesFrom: child];
+}
+
+-(void) releaseCharacters {
+	[characters release];
+	characters = nil;
+	[softBodyNodes release];
+	softBodyNodes = nil;
+}
+
+-(double) nodesPerMillisecondIn: (ccTime) aTime {
+	return [self rateOf: ((double)self.animatedNodeCount * sampleCount) perMillisecondIn: aTime];
+}
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3SkeletalAnimationBenchmark
+
+// The animation time at which the batched and individual animation are compared.
+// This lies between frames for most frame counts, so that interpolation is compared.
+#define kCC3SkeletalAnimationCompareTime		0.37f
+
+// The tolerance within which batched and individual animation are considered equal.
+#define kCC3SkeletalAnimationCompareTolerance	1.0e-3f
+
+@interface CC3SkeletalAnimationBenchmark (TemplateMethods)
+-(void) animateCharactersAt: (ccTime) t;
+-(ccTime) animateCharacters;
+-(void) setBatchesEnabled: (BOOL) shouldBatch;
+-(void) compareBatches;
+@end
+
+
+@implementation CC3SkeletalAnimationBenchmark
+
+@synthesize animatedNodeCount, batchedNodeCount, mismatches, unbatchedTime, batchedTime;
+
+
+#pragma mark Allocation and initialization
+
+-(id) initFromFile: (NSString*) aFilePath withCount: (GLuint) charCount {
+	if ( (self = [super initWithNamePrefix: @"SkeletalAnimation" fromFile: aFilePath withCount: charCount]) ) {
+		sampleCount = 200;
+	}
+	return self;
+}
+
++(id) benchmarkFromFile: (NSString*) aFilePath withCount: (GLuint) charCount {
+	return [[[self alloc] initFromFile: aFilePath withCount: charCount] autorelease];
+}
+
+
+#pragma mark Running
+
+/** Counts the animated nodes of all characters, and batches the animation of each soft-body node. */
+-(void) loadCharacters {
+	[super loadCharacters];
+
+	animatedNodeCount = 0;
+	for (CC3Node* character in characters)
+		for (CC3Node* aNode in [character flatten])
+			if (aNode.animation && aNode.isAnimationEnabled) animatedNodeCount++;
+
+	batchedNodeCount = 0;
+	for (CC3SoftBodyNode* sbNode in softBodyNodes) {
+		[sbNode batchAnimation];
+		batchedNodeCount += sbNode.animationBatch.nodes.count;
+	}
+}
+
+/** Enables or disables the animation batches, by swapping them in and out of the soft-body nodes. */
+-(void) setBatchesEnabled: (BOOL) shouldBatch {
+	for (CC3SoftBodyNode* sbNode in softBodyNodes) {
+		if (shouldBatch) {
+			if ( !sbNode.animationBatch ) [sbNode batchAnimation];
+		} else {
+			sbNode.animationBatch = nil;
+		}
+	}
+}
+
+-(void) animateCharactersAt: (ccTime) t {
+	for (CC3Node* character in characters) [character establishAnimationFrameAt: t];
+}
+
+/** Animates all characters at each sample time, and returns the time taken. */
+-(ccTime) animateCharacters {
+	double startTime = CC3PerformanceTimeNow();
+	for (GLuint i = 0; i < sampleCount; i++)
+		[self animateCharactersAt: ((ccTime)i / (ccTime)MAX(sampleCount - 1, 1))];
+	return CC3PerformanceTimeNow() - startTime;
+}
+
+/**
+ * Animates all characters at the same time both individually and in batches, and counts
+ * the animated nodes whose location, quaternion or scale differs between the two methods.
+ * Quaternions are compared by the absolute value of their dot product, since a quaternion
+ * and its negation represent the same rotation.
+ */
+-(void) compareBatches {
+	CCArray* animNodes = [CCArray array];
+	for (CC3Node* character in characters)
+		for (CC3Node* aNode in [character flatten])
+			if (aNode.animation && aNode.isAnimationEnabled) [animNodes addObject: aNode];
+
+	GLuint nodeCount = animNodes.count;
+	CC3Vector* locs = malloc(nodeCount * sizeof(CC3Vector));
+	CC3Quaternion* quats = malloc(nodeCount * sizeof(CC3Quaternion));
+	CC3Vector* scales = malloc(nodeCount * sizeof(CC3Vector));
+
+	[self setBatchesEnabled: NO];
+	[self animateCharactersAt: kCC3SkeletalAnimationCompareTime];
+	for (GLuint i = 0; i < nodeCount; i++) {
+		CC3Node* aNode = [animNodes objectAtIndex: i];
+		locs[i] = aNode.location;
+		quats[i] = aNode.quaternion;
+		scales[i] = aNode.scale;
+	}
+
+	[self setBatchesEnabled: YES];
+	[self animateCharactersAt: kCC3SkeletalAnimationCompareTime];
+	mismatches = 0;
+	for (GLuint i = 0; i < nodeCount; i++) {
+		CC3Node* aNode = [animNodes objectAtIndex: i];
+		GLfloat tol = kCC3SkeletalAnimationCompareTolerance;
+		GLfloat locTol = tol * MAX(CC3VectorLength(locs[i]), 1.0f);
+		if ( CC3VectorDistance(aNode.location, locs[i]) > locTol ||
+			 (1.0f - fabsf(CC3Vector4Dot(aNode.quaternion, quats[i]))) > tol ||
+			 CC3VectorDistance(aNode.scale, scales[i]) > tol ) mismatches++;
+	}
+
+	free(locs);
+	free(quats);
+	free(scales);
+}
+
+-(void) run {
+	[self loadCharacters];
+
+	// Warm up both paths before timing
+	[self setBatchesEnabled: NO];
+	[self animateCharactersAt: 0.5f];
+	unbatchedTime = [self animateCharacters];
+
+	[self setBatchesEnabled: YES];
+	[self animateCharactersAt: 0.5f];
+	batchedTime = [self animateCharacters];
+
+	[self compareBatches];
+
+	if (mismatches) LogError(@"%@ batched animation differed from individual animation for %u of %u nodes",
+							 self, mismatches, animatedNodeCount);
+	LogInfo(@"%@ animated %u nodes (%u batched) %u times in %.3f ms batched, versus %.3f ms individually",
+			self, animatedNodeCount, batchedNodeCount, sampleCount, batchedTime * 1000.0, unbatchedTime * 1000.0);
+
+	[self releaseCharacters];
+}
+
+-(NSString*) resultJSON {
+	return [NSString stringWithFormat: @"{\"name\":\"%@\",\"samples\":%u,"
+			@"\"counters\":{\"characters\":%u,\"animatedNodes\":%u,\"batchedNodes\":%u,\"mismatches\":%u},"
+			@"\"unbatchedTime\":%.4f,\"batchedTime\":%.4f,"
+			@"\"unbatchedNodesPerMs\":%.1f,\"batchedNodesPerMs\":%.1f}",
+			name, sampleCount, characterCount, animatedNodeCount, batchedNodeCount, mismatches,
+			unbatchedTime * 1000.0, batchedTime * 1000.0,
+			[self nodesPerMillisecondIn: unbatchedTime], [self nodesPerMillisecondIn: batchedTime]];
+}
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3AnimationBlendingBenchmark
+
+// The tolerance within which blended locations and scales are considered equal.
+#define kCC3AnimationBlendingCompareTolerance	1.0e-3f
+
+// The number of floats held for each node: location, quaternion and scale.
+#define kCC3AnimationBlendingNodeStride			10
+
+@interface CC3AnimationBlendingBenchmark (TemplateMethods)
+-(GLfloat) weightOfClip: (GLuint) clipIdx;
+-(ccTime) timeOfClip: (GLuint) clipIdx at: (ccTime) t;
+-(void) blendIndividuallyAt: (ccTime) t;
+-(void) blendWithBlendersAt: (ccTime) t;
+-(void) capturePoseInto: (GLfloat*) content;
+-(void) comparePoses;
+@end
+
+
+@implementation CC3AnimationBlendingBenchmark
+
+@synthesize clipCount, mismatches, maxRotationDifference, individualTime, blendedTime;
+
+-(void) dealloc {
+	[animatedNodes release];
+	free(restContent);
+	free(blendContent);
+	[super dealloc];
+}
+
+-(GLuint) animatedNodeCount { return animatedNodes.count; }
+
+
+#pragma mark Allocation and initialization
+
+-(id) initFromFile: (NSString*) aFilePath withCount: (GLuint) charCount blendingClips: (GLuint) numClips {
+	if ( (self = [super initWithNamePrefix: @"AnimationBlending" fromFile: aFilePath withCount: charCount]) ) {
+		clipCount = MAX(numClips, 1);
+		self.name = [NSString stringWithFormat: @"%@-%u", name, clipCount];
+		sampleCount = 100;
+		animatedNodes = nil;
+		restContent = NULL;
+		blendContent = NULL;
+	}
+	return self;
+}
+
++(id) benchmarkFromFile: (NSString*) aFilePath withCount: (GLuint) charCount blendingClips: (GLuint) numClips {
+	return [[[self alloc] initFromFile: aFilePath withCount: charCount blendingClips: numClips] autorelease];
+}
+
+
+#pragma mark Clips
+
+/** The first clip is fully weighted, and each subsequent clip has a decreasing weight. */
+-(GLfloat) weightOfClip: (GLuint) clipIdx { return 1.0f / (clipIdx + 1); }
+
+/** Each clip plays at an equally spaced offset within the animation. */
+-(ccTime) timeOfClip: (GLuint) clipIdx at: (ccTime) t {
+	ccTime clipTime = t + ((ccTime)clipIdx / (ccTime)clipCount);
+	return (clipTime > 1.0f) ? (clipTime - 1.0f) : clipTime;
+}
+
+
+#pragma mark Running
+
+/**
+ * Gives each soft-body node an animation blender with one layer per clip,
+ * and captures the rest pose of all animated nodes.
+ */
+-(void) loadCharacters {
+	[super loadCharacters];
+	[animatedNodes release];
+	animatedNodes = [[CCArray array] retain];
+
+	for (CC3SoftBodyNode* sbNode in softBodyNodes) {
+		for (CC3Node* aNode in [sbNode flatten])
+			if (aNode.animation && aNode.isAnimationEnabled) [animatedNodes addObject: aNode];
+
+		CC3NodeAnimationBlender* blender = [CC3NodeAnimationBlender blenderForNode: sbNode];
+		for (GLuint clipIdx = 0; clipIdx < clipCount; clipIdx++)
+			[blender addLayer].weight = [self weightOfClip: clipIdx];
+		sbNode.animationBlender = blender;
+	}
+
+	GLuint contentLength = MAX(animatedNodes.count, 1) * kCC3AnimationBlendingNodeStride;
+	free(restContent);
+	restContent = calloc(contentLength, sizeof(GLfloat));
+	free(blendContent);
+	blendContent = calloc(contentLength, sizeof(GLfloat));
+	[self capturePoseInto: restContent];
+}
+
+/** Copies the location, quaternion and scale of each animated node into the specified content. */
+-(void) capturePoseInto: (GLfloat*) content {
+	GLuint nodeCount = animatedNodes.count;
+	for (GLuint nodeIdx = 0; nodeIdx < nodeCount; nodeIdx++) {
+		CC3Node* aNode = [animatedNodes objectAtIndex: nodeIdx];
+		GLfloat* pNode = content + (nodeIdx * kCC3AnimationBlendingNodeStride);
+		*(CC3Vector*)pNode = aNode.location;
+		*(CC3Quaternion*)(pNode + 3) = aNode.quaternion;
+		*(CC3Vector*)(pNode + 7) = aNode.scale;
+	}
+}
+
+/**
+ * Poses each node by sampling each clip through the animation of the node, reading back the
+ * resulting node properties, and blending them, starting from the rest pose, as application
+ * code would have to do without an animation blender.
+ */
+-(void) blendIndividuallyAt: (ccTime) t {
+	GLuint nodeCount = animatedNodes.count;
+	memcpy(blendContent, restContent, nodeCount * kCC3AnimationBlendingNodeStride * sizeof(GLfloat));
+	for (GLuint clipIdx = 0; clipIdx < clipCount; clipIdx++) {
+		ccTime clipTime = [self timeOfClip: clipIdx at: t];
+		GLfloat clipWeight = [self weightOfClip: clipIdx];
+		for (GLuint nodeIdx = 0; nodeIdx < nodeCount; nodeIdx++) {
+			CC3Node* aNode = [animatedNodes objectAtIndex: nodeIdx];
+			CC3NodeAnimation* anim = aNode.animation;
+			[anim establishFrameAt: clipTime forNode: aNode];
+
+			GLfloat* pNode = blendContent + (nodeIdx * kCC3AnimationBlendingNodeStride);
+			CC3Vector* pLoc = (CC3Vector*)pNode;
+			CC3Quaternion* pQuat = (CC3Quaternion*)(pNode + 3);
+			CC3Vector* pScale = (CC3Vector*)(pNode + 7);
+			if (anim.isAnimatingLocation) *pLoc = CC3VectorLerp(*pLoc, aNode.location, clipWeight);
+			if (anim.isAnimatingQuaternion) *pQuat = CC3QuaternionSlerp(*pQuat, aNode.quaternion, clipWeight);
+			if (anim.isAnimatingScale) *pScale = CC3VectorLerp(*pScale, aNode.scale, clipWeight);
+		}
+	}
+	for (GLuint nodeIdx = 0; nodeIdx < nodeCount; nodeIdx++) {
+		CC3Node* aNode = [animatedNodes objectAtIndex: nodeIdx];
+		GLfloat* pNode = blendContent + (nodeIdx * kCC3AnimationBlendingNodeStride);
+		aNode.location = *(CC3Vector*)pNode;
+		aNode.quaternion = *(CC3Quaternion*)(pNode + 3);
+		aNode.scale = *(CC3Vector*)(pNode + 7);
+	}
+}
+
+/** Poses each character by blending the clips using the animation blender of each soft-body node. */
+-(void) blendWithBlendersAt: (ccTime) t {
+	for (CC3SoftBodyNode* sbNode in softBodyNodes) {
+		CC3NodeAnimationBlender* blender = sbNode.animationBlender;
+		GLuint clipIdx = 0;
+		for (CC3NodeAnimationLayer* layer in blender.layers)
+			layer.animationTime = [self timeOfClip: clipIdx++ at: t];
+		[blender establishFrame];
+	}
+}
+
+/**
+ * Poses all characters at the same time using each method, and counts the animated nodes
+ * whose location or scale differs between the two methods, and measures the largest
+ * difference in rotation between the two methods.
+ */
+-(void) comparePoses {
+	ccTime t = 0.37f;
+	[self blendIndividuallyAt: t];
+	GLuint nodeCount = animatedNodes.count;
+	GLfloat* individualContent = malloc(MAX(nodeCount, 1) * kCC3AnimationBlendingNodeStride * sizeof(GLfloat));
+	[self capturePoseInto: individualContent];
+
+	[self blendWithBlendersAt: t];
+	mismatches = 0;
+	maxRotationDifference = 0.0f;
+	for (GLuint nodeIdx = 0; nodeIdx < nodeCount; nodeIdx++) {
+		CC3Node* aNode = [animatedNodes objectAtIndex: nodeIdx];
+		GLfloat* pNode = individualContent + (nodeIdx * kCC3AnimationBlendingNodeStride);
+		CC3Vector indLoc = *(CC3Vector*)pNode;
+		CC3Quaternion indQuat = *(CC3Quaternion*)(pNode + 3);
+		CC3Vector indScale = *(CC3Vector*)(pNode + 7);
+		GLfloat locTol = kCC3AnimationBlendingCompareTolerance * MAX(CC3VectorLength(indLoc), 1.0f);
+		if (CC3VectorDistance(aNode.location, indLoc) > locTol ||
+			CC3VectorDistance(aNode.scale, indScale) > kCC3AnimationBlendingCompareTolerance) mismatches++;
+		
+		GLfloat cosHalfAngle = MIN(fabsf(CC3Vector4Dot(CC3QuaternionNormalize(aNode.quaternion),
+													   CC3QuaternionNormalize(indQuat))), 1.0f);
+		maxRotationDifference = MAX(maxRotationDifference, RadiansToDegrees(2.0f * acosf(cosHalfAngle)));
+	}
+	free(individualContent);
+}
+
+-(void) run {
+	[self loadCharacters];
+
+	// Warm up both methods before timing
+	[self blendIndividuallyAt: 0.5f];
+	double startTime = CC3PerformanceTimeNow();
+	for (GLuint i = 0; i < sampleCount; i++)
+		[self blendIndividuallyAt: ((ccTime)i / (ccTime)MAX(sampleCount - 1, 1))];
+	individualTime = CC3PerformanceTimeNow() - startTime;
+
+	[self blendWithBlendersAt: 0.5f];
+	startTime = CC3PerformanceTimeNow();
+	for (GLuint i = 0; i < sampleCount; i++)
+		[self blendWithBlendersAt: ((ccTime)i / (ccTime)MAX(sampleCount - 1, 1))];
+	blendedTime = CC3PerformanceTimeNow() - startTime;
+
+	[self comparePoses];
+
+	if (mismatches) LogError(@"%@ blended location or scale differed from individual blending for %u of %u nodes",
+							 self, mismatches, self.animatedNodeCount);
+	LogInfo(@"%@ blended %u clips for %u nodes %u times in %.3f ms, versus %.3f ms individually, within %.2f degrees",
+			self, clipCount, self.animatedNodeCount, sampleCount, blendedTime * 1000.0, individualTime * 1000.0,
+			maxRotationDifference);
+
+	[self releaseCharacters];
+}
+
+-(NSString*) resultJSON {
+	return [NSString stringWithFormat: @"{\"name\":\"%@\",\"samples\":%u,"
+			@"\"counters\":{\"characters\":%u,\"clips\":%u,\"animatedNodes\":%u,\"mismatches\":%u},"
+			@"\"maxRotationDifference\":%.3f,\"individualTime\":%.4f,\"blendedTime\":%.4f,"
+			@"\"individualNodesPerMs\":%.1f,\"blendedNodesPerMs\":%.1f}",
+			name, sampleCount, characterCount, clipCount, self.animatedNodeCount, mismatches,
+			maxRotationDifference, individualTime * 1000.0, blendedTime * 1000.0,
+			[self nodesPerMillisecondIn: individualTime], [self nodesPerMillisecondIn: blendedTime]];
+}
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3RecordingTextureUploader
+
+/**
+ * Texture names generated by the recording uploader start at this value, to stay clear of the
+ * names generated by the GL engine. The textures that wrap these names delete them when they
+ * are deallocated, and the GL engine silently ignores names that it did not generate.
+ */
+#define kCC3RecordingTextureNameBase	10000
+
+/** The uploads recorded for a single texture name. */
+typedef struct {
+	GLuint nextLevel;		/**< The level expected to be uploaded next. */
+	GLuint levelCount;		/**< The number of levels the texture was created to hold. */
+	GLuint width;			/**< The width of level zero. */
+	GLuint height;			/**< The height of level zero. */
+} CC3RecordedTexture;
+
+/**
+ * A headless CC3TextureUploader that does not submit anything to the GL engine, but records
+ * the uploads and copies that would have been made, and counts any that are out of order, or
+ * that have dimensions inconsistent with the dimensions with which the texture was created.
+ */
+@interface CC3RecordingTextureUploader : NSObject <CC3TextureUploader> {
+	CC3RecordedTexture* recordedTextures;
+	GLuint textureNameCount;
+	GLuint uploadCount;
+	GLuint copiedLevelCount;
+	GLuint completedCount;
+	GLuint mismatches;
+}
+@property(nonatomic, readonly) GLuint uploadCount;
+@property(nonatomic, readonly) GLuint copiedLevelCount;
+@property(nonatomic, readonly) GLuint completedCount;
+@property(nonatomic, readonly) GLuint mismatches;
++(id) uploader;
+@end
+
+@implementation CC3RecordingTextureUploader
+
+@synthesize uploadCount, copiedLevelCount, completedCount, mismatches;
+
+-(void) dealloc {
+	free(recordedTextures);
+	[super dealloc];
+}
+
++(id) uploader { return [[[self alloc] init] autorelease]; }
+
+-(BOOL) isHeadless { return YES; }
+
+-(GLuint) generateTextureNameWithWidth: (GLuint) width
+								height: (GLuint) height
+							levelCount: (GLuint) levelCount {
+	CC3RecordedTexture* recs = realloc(recordedTextures, (textureNameCount + 1) * sizeof(CC3RecordedTexture));
+	if ( !recs ) return 0;
+	recordedTextures = recs;
+	CC3RecordedTexture* rec = recordedTextures + textureNameCount;
+	rec->nextLevel = 0;
+	rec->levelCount = levelCount;
+	rec->width = width;
+	rec->height = height;
+	return kCC3RecordingTextureNameBase + textureNameCount++;
+}
+
+-(CC3RecordedTexture*) recordedTextureNamed: (GLuint) texName {
+	GLuint texIdx = texName - kCC3RecordingTextureNameBase;
+	return (texName >= kCC3RecordingTextureNameBase && texIdx < textureNameCount) ? (recordedTextures + texIdx) : NULL;
+}
+
+-(void) uploadLevel: (GLuint) level
+		  ofTexture: (GLuint) texName
+		  withWidth: (GLuint) width
+		  andHeight: (GLuint) height
+			 pixels: (const GLvoid*) pixels {
+	uploadCount++;
+	CC3RecordedTexture* rec = [self recordedTextureNamed: texName];
+	if ( !rec || !pixels || level != rec->nextLevel || level >= rec->levelCount ) {
+		mismatches++;
+		return;
+	}
+	if (width != MAX(rec->width >> level, 1) || height != MAX(rec->height >> level, 1)) mismatches++;
+	rec->nextLevel++;
+}
+
+/** The copied levels must be complete in the source, and must be the next levels expected in the destination. */
+-(BOOL) copyLevels: (GLuint) levelCount
+		startingAt: (GLuint) srcLevel
+		 ofTexture: (GLuint) srcTexName
+	   intoTexture: (GLuint) dstTexName {
+	CC3RecordedTexture* src = [self recordedTextureNamed: srcTexName];
+	CC3RecordedTexture* dst = [self recordedTextureNamed: dstTexName];
+	if ( !src || !dst || (srcLevel + levelCount) > src->nextLevel ) {
+		mismatches++;
+		return NO;
+	}
+	GLuint srcWidth = MAX(src->width >> srcLevel, 1);
+	GLuint srcHeight = MAX(src->height >> srcLevel, 1);
+	GLuint dstLevel = dst->nextLevel;
+	if (srcWidth != MAX(dst->width >> dstLevel, 1) || srcHeight != MAX(dst->height >> dstLevel, 1) ||
+		(dstLevel + levelCount) > dst->levelCount) {
+		mismatches++;
+		return NO;
+	}
+	dst->nextLevel += levelCount;
+	copiedLevelCount += levelCount;
+	return YES;
+}
+
+-(void) completeTexture: (GLuint) texName withLevelCount: (GLuint) levelCount {
+	completedCount++;
+	CC3RecordedTexture* rec = [self recordedTextureNamed: texName];
+	if ( !rec || levelCount != rec->nextLevel ) mismatches++;
+}
+
+-(void) deleteTextureName: (GLuint) texName {}
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3TextureStreamingBenchmark
+
+@interface CC3TextureStreamingBenchmark (TemplateMethods)
+-(NSArray*) makeTextureFiles;
+-(void) writeTextureFile: (NSString*) aFilePath withSeed: (GLuint) seed;
+@end
+
+
+@implementation CC3TextureStreamingBenchmark
+
+@synthesize textureCount, textureSize, uploadBudget, isHeadless, frameInterval;
+@synthesize loadingFrameCount, maxFrameBytesUploaded, mismatches;
+@synthesize submitTime, maxFrameUploadTime, loadingTime;
+
+-(void) dealloc {
+	[textures release];
+	[super dealloc];
+}
+
+
+#pragma mark Allocation and initialization
+
+-(id) initWithTextureCount: (GLuint) texCount ofSize: (GLuint) texSize {
+	if ( (self = [super init]) ) {
+		textureCount = texCount;
+		textureSize = texSize;
+		self.name = [NSString stringWithFormat: @"TextureStreaming-%u-%u", texCount, texSize];
+		textures = nil;
+		uploadBudget = [CC3TextureLoader loader].uploadBudget;
+		frameInterval = 1.0f / 60.0f;
+		isHeadless = YES;
+	}
+	return self;
+}
+
++(id) benchmarkWithTextureCount: (GLuint) texCount ofSize: (GLuint) texSize {
+	return [[[self alloc] initWithTextureCount: texCount ofSize: texSize] autorelease];
+}
+
+
+#pragma mark Running
+
+/** Returns the paths of the texture files, writing any that do not yet exist to the temporary directory. */
+-(NSArray*) makeTextureFiles {
+	NSMutableArray* filePaths = [NSMutableArray arrayWithCapacity: textureCount];
+	for (GLuint i = 0; i < textureCount; i++) {
+		NSString* fileName = [NSString stringWithFormat: @"CC3TextureStreaming-%u-%u.png", textureSize, i];
+		NSString* filePath = [NSTemporaryDirectory() stringByAppendingPathComponent: fileName];
+		if ( ![[NSFileManager defaultManager] fileExistsAtPath: filePath] )
+			[self writeTextureFile: filePath withSeed: i];
+		[filePaths addObject: filePath];
+	}
+	return filePaths;
+}
+
+/** Writes a PNG file containing a gradient pattern that differs for each seed. */
+-(void) writeTextureFile: (NSString*) aFilePath withSeed: (GLuint) seed {
+	GLuint rowBytes = textureSize * 4;
+	GLubyte* pixels = malloc(rowBytes * textureSize);
+	if ( !pixels ) return;
+	for (GLuint y = 0; y < textureSize; y++) {
+		GLubyte* px = pixels + (y * rowBytes);
+		for (GLuint x = 0; x < textureSize; x++, px += 4) {
+			px[0] = (GLubyte)((x * 255) / textureSize);
+			px[1] = (GLubyte)((y * 255) / textureSize);
+			px[2] = (GLubyte)((x ^ y ^ seed) & 0xFF);
+			px[3] = 0xFF;
+		}
+	}
+
+	CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+	CGContextRef context = CGBitmapContextCreate(pixels, textureSize, textureSize, 8, rowBytes, colorSpace,
+												 kCGImageAlphaPremultipliedLast | kCGBitmapByteOrder32Big);
+	CGColorSpaceRelease(colorSpace);
+	if (context) {
+		CGImageRef image = CGBitmapContextCreateImage(context);
+		[UIImagePNGRepresentation([UIImage imageWithCGImage: image]) writeToFile: aFilePath atomically: YES];
+		CGImageRelease(image);
+		CGContextRelease(context);
+	}
+	free(pixels);
+}
+
+-(void) run {
+	loadingFrameCount = 0;
+	maxFrameBytesUploaded = 0;
+	mismatches = 0;
+	submitTime = 0.0;
+	maxFrameUploadTime = 0.0;
+	loadingTime = 0.0;
+
+	NSArray* filePaths = [self makeTextureFiles];
+
+	CC3TextureLoader* loader = [CC3TextureLoader loader];
+	CC3RecordingTextureUploader* recorder = nil;
+	if (isHeadless) {
+		recorder = [CC3RecordingTextureUploader uploader];
+		loader.uploader = recorder;
+	}
+	loader.uploadBudget = uploadBudget;
+	CCTexture2D* placeholder = loader.placeholderTexture;
+
+	[textures release];
+	textures = [[CCArray arrayWithCapacity: textureCount] retain];
+
+	// Submit all files at once, as when loading a level
+	double startTime = CC3PerformanceTimeNow();
+	for (NSString* filePath in filePaths) {
+		CC3Texture* tex = [[[CC3Texture alloc] initWithName: filePath.lastPathComponent] autorelease];
+		if ( ![loader loadFile: filePath intoTexture: tex] || tex.texture != placeholder ) mismatches++;
+		[textures addObject: tex];
+	}
+	submitTime = CC3PerformanceTimeNow() - startTime;
+
+	// Upload once per simulated frame, while the worker threads decode
+	while ( !loader.isIdle ) {
+		[NSThread sleepForTimeInterval: frameInterval];
+		double frameStartTime = CC3PerformanceTimeNow();
+		[loader uploadWithinBudget];
+		maxFrameUploadTime = MAX(maxFrameUploadTime, CC3PerformanceTimeNow() - frameStartTime);
+		maxFrameBytesUploaded = MAX(maxFrameBytesUploaded, loader.lastFrameBytesUploaded);
+		loadingFrameCount++;
+	}
+	loadingTime = CC3PerformanceTimeNow() - startTime;
+	bytesUploaded = loader.bytesUploaded;
+	previewsLoaded = loader.previewsLoaded;
+
+	// Each texture should hold a full-size texture, padded to power-of-two dimensions
+	GLuint texPixels = ccNextPOT(textureSize);
+	for (CC3Texture* tex in textures) {
+		CCTexture2D* tex2D = tex.texture;
+		if ( !tex2D || tex2D == placeholder || tex2D.pixelsWide != texPixels || tex2D.pixelsHigh != texPixels ||
+			tex.hasMipmap != CC3Texture.shouldGenerateMipmaps ) mismatches++;
+	}
+	if (recorder) {
+		mismatches += recorder.mismatches;
+		if (recorder.completedCount != textureCount + previewsLoaded + 1) mismatches++;	// Includes placeholder
+		if (recorder.copiedLevelCount < previewsLoaded) mismatches++;	// Final textures reuse preview levels
+	}
+
+	if (mismatches) LogError(@"%@ found %u discrepancies in the loaded textures", self, mismatches);
+	LogInfo(@"%@ loaded %u textures in %.3f ms over %u frames, with at most %u bytes and %.3f ms per frame",
+			self, textureCount, loadingTime * 1000.0, loadingFrameCount,
+			maxFrameBytesUploaded, maxFrameUploadTime * 1000.0);
+
+	[textures release];
+	textures = nil;
+}
+
+-(NSString*) resultJSON {
+	return [NSString stringWithFormat: @"{\"name\":\"%@\",\"headless\":%@,\"uploadBudget\":%u,"
+			@"\"counters\":{\"textures\":%u,\"previews\":%u,\"bytesUploaded\":%u,"
+			@"\"loadingFrames\":%u,\"maxFrameBytesUploaded\":%u,\"mismatches\":%u},"
+			@"\"submitTime\":%.4f,\"maxFrameUploadTime\":%.4f,\"loadingTime\":%.4f}",
+			name, (isHeadless ? @"true" : @"false"), uploadBudget,
+			textureCount, previewsLoaded, bytesUploaded,
+			loadingFrameCount, maxFrameBytesUploaded, mismatches,
+			submitTime * 1000.0, maxFrameUploadTime * 1000.0, loadingTime * 1000.0];
+}
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3LightAssignmentBenchmark
+
+/** The length of the side of the cube throughout which the lights and spheres are scattered. */
+#define kCC3LightAssignmentBenchmarkExtent		1000.0f
+
+
+@interface CC3LightAssignmentBenchmark (TemplateMethods)
+-(void) populateScene;
+-(GLuint) selectLightsExhaustivelyForSphere: (CC3Sphere) aSphere
+								withAssigner: (CC3LightAssigner*) assigner
+									 into: (CC3Light**) selLights;
+@end
+
+
+@implementation CC3LightAssignmentBenchmark
+
+@synthesize lightCount, sphereCount, repeatCount, mismatches;
+@synthesize prepareTime, selectionTime, exhaustiveTime;
+
+-(void) dealloc {
+	[lights release];
+	free(spheres);
+	[super dealloc];
+}
+
+
+#pragma mark Allocation and initialization
+
+-(id) initWithLightCount: (GLuint) ltCount sphereCount: (GLuint) sphCount {
+	if ( (self = [super init]) ) {
+		lightCount = ltCount;
+		sphereCount = sphCount;
+		self.name = [NSString stringWithFormat: @"LightAssignment-%u-%u", ltCount, sphCount];
+		repeatCount = 10;
+		lights = nil;
+		spheres = NULL;
+	}
+	return self;
+}
+
++(id) benchmarkWithLightCount: (GLuint) ltCount sphereCount: (GLuint) sphCount {
+	return [[[self alloc] initWithLightCount: ltCount sphereCount: sphCount] autorelease];
+}
+
+
+#pragma mark Running
+
+static CC3Vector CC3LightAssignmentBenchmarkRandomLocation(void) {
+	GLfloat halfExt = kCC3LightAssignmentBenchmarkExtent * 0.5f;
+	return cc3v(CC3RandomFloatBetween(-halfExt, halfExt),
+				CC3RandomFloatBetween(-halfExt, halfExt),
+				CC3RandomFloatBetween(-halfExt, halfExt));
+}
+
+/**
+ * Populates the lights and spheres. The lights are created with the kCC3LightIndexNone
+ * light index, so they do not consume, or require, any GL lights.
+ */
+-(void) populateScene {
+	[lights release];
+	lights = [[CCArray arrayWithCapacity: lightCount] retain];
+	for (GLuint i = 0; i < lightCount; i++) {
+		CC3Light* lgt = [CC3Light lightWithLightIndex: kCC3LightIndexNone];
+		lgt.location = CC3LightAssignmentBenchmarkRandomLocation();
+		lgt.isDirectionalOnly = NO;
+		lgt.diffuseColor = ccc4f(CC3RandomFloatBetween(0.2f, 1.0f),
+								 CC3RandomFloatBetween(0.2f, 1.0f),
+								 CC3RandomFloatBetween(0.2f, 1.0f), 1.0f);
+		CC3AttenuationCoefficients att = { 1.0f, CC3RandomFloatBetween(0.01f, 0.05f),
+										   CC3RandomFloatBetween(0.002f, 0.02f) };
+		lgt.attenuation = att;
+		[lgt updateTransformMatrices];
+		[lights addObject: lgt];
+	}
+
+	free(spheres);
+	spheres = calloc(sphereCount, sizeof(CC3Sphere));
+	for (GLuint i = 0; i < sphereCount; i++) {
+		spheres[i] = CC3SphereMake(CC3LightAssignmentBenchmarkRandomLocation(),
+								   CC3RandomFloatBetween(1.0f, 20.0f));
+	}
+}
+
+/** Selects the lights for the specified sphere by testing every light, and returns the number selected. */
+-(GLuint) selectLightsExhaustivelyForSphere: (CC3Sphere) aSphere
+								withAssigner: (CC3LightAssigner*) assigner
+									 into: (CC3Light**) selLights {
+	GLfloat selInfluences[kCC3LightAssignerMaxLightsPerNode];
+	GLuint maxCount = assigner.maxLightsPerNode;
+	GLuint selCount = 0;
+	for (CC3Light* lgt in lights) {
+		CC3AttenuationCoefficients att = lgt.attenuation;
+		ccColor4F dc = lgt.diffuseColor;
+		ccColor4F ac = lgt.ambientColor;
+		GLfloat intensity = MAX(MAX(dc.r, dc.g), dc.b) + MAX(MAX(ac.r, ac.g), ac.b);
+		GLfloat dist = MAX(CC3VectorDistance(lgt.globalLocation, aSphere.center) - aSphere.radius, 0.0f);
+		GLfloat influence = intensity / (att.a + (att.b * dist) + (att.c * dist * dist));
+		if (influence < assigner.influenceThreshold) continue;
+
+		GLuint pos;
+		if (selCount < maxCount) {
+			pos = selCount++;
+		} else if (influence > selInfluences[maxCount - 1]) {
+			pos = maxCount - 1;
+		} else {
+			continue;
+		}
+		while (pos > 0 && influence > selInfluences[pos - 1]) {
+			selLights[pos] = selLights[pos - 1];
+			selInfluences[pos] = selInfluences[pos - 1];
+			pos--;
+		}
+		selLights[pos] = lgt;
+		selInfluences[pos] = influence;
+	}
+	return selCount;
+}
+
+-(void) run {
+	mismatches = 0;
+	prepareTime = 0.0;
+	selectionTime = 0.0;
+	exhaustiveTime = 0.0;
+
+	[self populateScene];
+	if ( !spheres ) {
+		LogError(@"%@ could not allocate space for %u spheres", self, sphereCount);
+		return;
+	}
+
+	CC3LightAssigner* assigner = [CC3LightAssigner assigner];
+	CC3Light* selLights[kCC3LightAssignerMaxLightsPerNode];
+
+	for (GLuint r = 0; r < repeatCount; r++) {
+		double startTime = CC3PerformanceTimeNow();
+		[assigner prepareLights: lights];
+		prepareTime += CC3PerformanceTimeNow() - startTime;
+
+		startTime = CC3PerformanceTimeNow();
+		for (GLuint i = 0; i < sphereCount; i++) [assigner selectLightsForSphere: spheres[i]];
+		selectionTime += CC3PerformanceTimeNow() - startTime;
+
+		startTime = CC3PerformanceTimeNow();
+		for (GLuint i = 0; i < sphereCount; i++)
+			[self selectLightsExhaustivelyForSphere: spheres[i] withAssigner: assigner into: selLights];
+		exhaustiveTime += CC3PerformanceTimeNow() - startTime;
+	}
+
+	// Verify the selections outside the timed loops
+	for (GLuint i = 0; i < sphereCount; i++) {
+		GLuint selCount = [assigner selectLightsForSphere: spheres[i]];
+		GLuint exCount = [self selectLightsExhaustivelyForSphere: spheres[i] withAssigner: assigner into: selLights];
+		BOOL isMatch = (selCount == exCount);
+		for (GLuint j = 0; isMatch && j < selCount; j++) isMatch = ([assigner selectedLightAt: j] == selLights[j]);
+		if ( !isMatch ) mismatches++;
+	}
+	lightsTested = assigner.lightsTested;
+	lightsSelected = assigner.lightsSelected;
+
+	if (mismatches) LogError(@"%@ assigner selected different lights than an exhaustive search for %u of %u spheres",
+							 self, mismatches, sphereCount);
+	LogInfo(@"%@ selected lights in %.3f ms after preparing in %.3f ms, versus %.3f ms testing every light",
+			self, selectionTime * 1000.0, prepareTime * 1000.0, exhaustiveTime * 1000.0);
+
+	[lights release];
+	lights = nil;
+}
+
+-(NSString*) resultJSON {
+	return [NSString stringWithFormat: @"{\"name\":\"%@\",\"repeats\":%u,"
+			@"\"counters\":{\"lights\":%u,\"spheres\":%u,\"lightsTested\":%u,\"lightsSelected\":%u,\"mismatches\":%u},"
+			@"\"prepareTime\":%.4f,\"selectionTime\":%.4f,\"exhaustiveTime\":%.4f}",
+			name, repeatCount, lightCount, sphereCount, lightsTested, lightsSelected, mismatches,
+			prepareTime * 1000.0, selectionTime * 1000.0, exhaustiveTime * 1000.0];
+}
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3ShadowVolumeCacheBenchmark
+
+/** The distance from the spheres at which the light orbits them. */
+#define kCC3ShadowVolumeCacheBenchmarkLightDistance		8.0f
+
+/** The angle, in degrees, through which the light orbits the spheres on each frame. */
+#define kCC3ShadowVolumeCacheBenchmarkOrbitStep			0.25f
+
+
+@interface CC3ShadowVolumeMeshNode (TemplateMethods)
+-(void) populateShadowMesh;
+@end
+
+@interface CC3ShadowVolumeCacheBenchmark (TemplateMethods)
+-(CC3MeshNode*) sphereNamed: (NSString*) aName;
+-(BOOL) doesShadowVolume: (CC3ShadowVolumeMeshNode*) sv1 matchShadowVolume: (CC3ShadowVolumeMeshNode*) sv2;
+@end
+
+
+@implementation CC3ShadowVolumeCacheBenchmark
+
+@synthesize tessellation, frameCount, incrementalUpdates, reusedUpdates, mismatches;
+@synthesize uncachedTime, incrementalTime, reuseTime;
+
+-(void) dealloc {
+	[super dealloc];
+}
+
+
+#pragma mark Allocation and initialization
+
+-(id) initWithTessellation: (GLuint) divsPerAxis {
+	if ( (self = [super init]) ) {
+		tessellation = divsPerAxis;
+		self.name = [NSString stringWithFormat: @"ShadowVolumeCache-%u", divsPerAxis];
+		frameCount = 200;
+	}
+	return self;
+}
+
++(id) benchmarkWithTessellation: (GLuint) divsPerAxis {
+	return [[[self alloc] initWithTessellation: divsPerAxis] autorelease];
+}
+
+
+#pragma mark Running
+
+-(CC3MeshNode*) sphereNamed: (NSString*) aName {
+	CC3MeshNode* sphere = [CC3MeshNode nodeWithName: aName];
+	[sphere populateAsSphereWithRadius: 1.0f andTessellation: ccg(tessellation, tessellation)];
+	return sphere;
+}
+
+/** Triangles of homogeneous vertices are sorted into a canonical order for comparison. */
+static int CC3ShadowVolumeCacheBenchmarkCompareTriangles(const void* a, const void* b) {
+	return memcmp(a, b, sizeof(CC3Vector4) * 3);
+}
+
+/**
+ * Returns whether the two shadow volumes contain the same triangles, regardless
+ * of the order in which the triangles were added to each shadow volume mesh.
+ */
+-(BOOL) doesShadowVolume: (CC3ShadowVolumeMeshNode*) sv1 matchShadowVolume: (CC3ShadowVolumeMeshNode*) sv2 {
+	GLuint vtxCount = sv1.mesh.vertexCount;
+	if (vtxCount != sv2.mesh.vertexCount) return NO;
+	if (vtxCount == 0) return YES;
+
+	CC3Vector4* vtx1 = malloc(vtxCount * sizeof(CC3Vector4));
+	CC3Vector4* vtx2 = malloc(vtxCount * sizeof(CC3Vector4));
+	BOOL isMatch = (vtx1 && vtx2);
+	if (isMatch) {
+		for (GLuint i = 0; i < vtxCount; i++) {
+			vtx1[i] = [sv1.mesh vertexHomogeneousLocationAt: i];
+			vtx2[i] = [sv2.mesh vertexHomogeneousLocationAt: i];
+		}
+		qsort(vtx1, vtxCount / 3, sizeof(CC3Vector4) * 3, CC3ShadowVolumeCacheBenchmarkCompareTriangles);
+		qsort(vtx2, vtxCount / 3, sizeof(CC3Vector4) * 3, CC3ShadowVolumeCacheBenchmarkCompareTriangles);
+		isMatch = (memcmp(vtx1, vtx2, vtxCount * sizeof(CC3Vector4)) == 0);
+	}
+	free(vtx1);
+	free(vtx2);
+	return isMatch;
+}
+
+-(void) run {
+	incrementalUpdates = 0;
+	reusedUpdates = 0;
+	mismatches = 0;
+	uncachedTime = 0.0;
+	incrementalTime = 0.0;
+	reuseTime = 0.0;
+
+	// The light is created with the kCC3LightIndexNone light index, so it does not require a GL light.
+	CC3Node* rig = [CC3Node nodeWithName: @"ShadowRig"];
+	CC3Light* lgt = [CC3Light lightWithLightIndex: kCC3LightIndexNone];
+	lgt.isDirectionalOnly = NO;
+	[rig addChild: lgt];
+
+	CC3MeshNode* cachingSphere = [self sphereNamed: @"CachingSphere"];
+	CC3MeshNode* uncachedSphere = [self sphereNamed: @"UncachedSphere"];
+	[rig addChild: cachingSphere];
+	[rig addChild: uncachedSphere];
+	[cachingSphere addShadowVolumesForLight: lgt];
+	[uncachedSphere addShadowVolumesForLight: lgt];
+	CC3ShadowVolumeMeshNode* cachingSV = (CC3ShadowVolumeMeshNode*)[cachingSphere getShadowVolumeForLight: lgt];
+	CC3ShadowVolumeMeshNode* uncachedSV = (CC3ShadowVolumeMeshNode*)[uncachedSphere getShadowVolumeForLight: lgt];
+	cachingSV.shouldCacheShadowVolumes = YES;
+	uncachedSV.shouldCacheShadowVolumes = NO;
+	faceCount = cachingSphere.faceCount;
+
+	// Orbit the light around the spheres, populating both shadow volumes on each frame.
+	for (GLuint f = 0; f < frameCount; f++) {
+		GLfloat angle = DegreesToRadians(f * kCC3ShadowVolumeCacheBenchmarkOrbitStep);
+		lgt.location = cc3v(kCC3ShadowVolumeCacheBenchmarkLightDistance * sinf(angle), 2.0f,
+							kCC3ShadowVolumeCacheBenchmarkLightDistance * cosf(angle));
+		[rig updateTransformMatrices];
+
+		double startTime = CC3PerformanceTimeNow();
+		[uncachedSV populateShadowMesh];
+		uncachedTime += CC3PerformanceTimeNow() - startTime;
+
+		startTime = CC3PerformanceTimeNow();
+		[cachingSV populateShadowMesh];
+		incrementalTime += CC3PerformanceTimeNow() - startTime;
+
+		if (cachingSV.wasShadowUpdatedIncrementally) incrementalUpdates++;
+		if ( ![self doesShadowVolume: cachingSV matchShadowVolume: uncachedSV] ) mismatches++;
+	}
+
+	// Move the parent of the spheres and the light, so the light does not move relative to the spheres.
+	for (GLuint f = 0; f < frameCount; f++) {
+		rig.location = cc3v(f * 0.1f, 0.0f, f * -0.05f);
+		rig.rotation = cc3v(0.0f, f * 0.5f, f * 0.2f);
+		[rig updateTransformMatrices];
+
+		double startTime = CC3PerformanceTimeNow();
+		[cachingSV populateShadowMesh];
+		reuseTime += CC3PerformanceTimeNow() - startTime;
+
+		if (cachingSV.wasShadowReused) reusedUpdates++;
+	}
+
+	if (mismatches) LogError(@"%@ cached shadow volume differed from the uncached shadow volume on %u of %u frames",
+							 self, mismatches, frameCount);
+	LogInfo(@"%@ populated shadow volumes of %u faces in %.3f ms incrementally, versus %.3f ms uncached,"
+			@" and in %.3f ms while reusing %u of %u frames",
+			self, faceCount, incrementalTime * 1000.0, uncachedTime * 1000.0,
+			reuseTime * 1000.0, reusedUpdates, frameCount);
+
+	[cachingSphere removeShadowVolumes];
+	[uncachedSphere removeShadowVolumes];
+}
+
+-(NSString*) resultJSON {
+	return [NSString stringWithFormat: @"{\"name\":\"%@\",\"frames\":%u,"
+			@"\"counters\":{\"faces\":%u,\"incrementalUpdates\":%u,\"reusedUpdates\":%u,\"mismatches\":%u},"
+			@"\"uncachedTime\":%.4f,\"incrementalTime\":%.4f,\"reuseTime\":%.4f}",
+			name, frameCount, faceCount, incrementalUpdates, reusedUpdates, mismatches,
+			uncachedTime * 1000.0, incrementalTime * 1000.0, reuseTime * 1000.0];
+}
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3PrefabBenchmark
+
+@interface CC3PrefabBenchmark (TemplateMethods)
+-(BOOL) verifyInstance: (CC3Node*) anInstance;
+-(void) verifyInstances: (CCArray*) instances;
+-(double) instancesPerMillisecondIn: (ccTime) aTime;
+@end
+
+
+@implementation CC3PrefabBenchmark
+
+@synthesize filePath, instanceCount, nodeCount, mismatches, copyTime, prefabTime, prefabCreationTime;
+
+-(void) dealloc {
+	[filePath release];
+	[super dealloc];
+}
+
+
+#pragma mark Allocation and initialization
+
+-(id) initFromFile: (NSString*) aFilePath withCount: (GLuint) instCount {
+	if ( (self = [super init]) ) {
+		filePath = [aFilePath retain];
+		instanceCount = instCount;
+		self.name = [NSString stringWithFormat: @"Prefab-%@-%u",
+					 [[aFilePath lastPathComponent] stringByDeletingPathExtension], instCount];
+	}
+	return self;
+}
+
++(id) benchmarkFromFile: (NSString*) aFilePath withCount: (GLuint) instCount {
+	return [[[self alloc] initFromFile: aFilePath withCount: instCount] autorelease];
+}
+
+
+#pragma mark Running
+
+/**
+ * Returns whether the specified instance has the expected number of nodes, and whether
+ * each of its skin sections is attached only to bones within that instance.
+ */
+-(BOOL) verifyInstance: (CC3Node*) anInstance {
+	CCArray* instNodes = [anInstance flatten];
+	if (instNodes.count != nodeCount) return NO;
+	for (CC3Node* aNode in instNodes) {
+		if ( ![aNode isKindOfClass: [CC3SkinMeshNode class]] ) continue;
+		for (CC3SkinSection* skinSctn in ((CC3SkinMeshNode*)aNode).skinSections)
+			for (CC3Bone* bone in skinSctn.bones)
+				if ( ![bone isDescendantOf: anInstance] ) return NO;
+	}
+	return YES;
+}
+
+-(void) verifyInstances: (CCArray*) instances {
+	for (CC3Node* inst in instances) if ( ![self verifyInstance: inst] ) mismatches++;
+}
+
+-(void) run {
+	CC3ResourceNode* podNode = [CC3SceneBenchmark nodeFromPODFile: filePath];
+	for (CC3Node* aNode in [podNode flatten])
+		if ( [aNode isKindOfClass: [CC3SoftBodyNode class]] ) [(CC3SoftBodyNode*)aNode batchAnimation];
+	nodeCount = [podNode flatten].count;
+	mismatches = 0;
+
+	NSString* instName = @"Character";
+	CCArray* instances = [CCArray arrayWithCapacity: instanceCount];
+
+	// Warm up both paths before timing
+	[[podNode copyWithName: instName] release];
+
+	double startTime = CC3PerformanceTimeNow();
+	CC3NodePrefab* prefab = [CC3NodePrefab prefabFromNode: podNode];
+	prefabCreationTime = CC3PerformanceTimeNow() - startTime;
+	[prefab instanceWithName: instName];
+
+	startTime = CC3PerformanceTimeNow();
+	for (GLuint i = 0; i < instanceCount; i++)
+		[instances addObject: [[podNode copyWithName: instName] autorelease]];
+	copyTime = CC3PerformanceTimeNow() - startTime;
+	[self verifyInstances: instances];
+	[instances removeAllObjects];
+
+	startTime = CC3PerformanceTimeNow();
+	for (GLuint i = 0; i < instanceCount; i++)
+		[instances addObject: [prefab instanceWithName: instName]];
+	prefabTime = CC3PerformanceTimeNow() - startTime;
+	[self verifyInstances: instances];
+	[instances removeAllObjects];
+
+	if (mismatches) LogError(@"%@ %u of %u instances were not structured like the loaded character",
+							 self, mismatches, (instanceCount * 2));
+	LogInfo(@"%@ spawned %u instances of %u nodes in %.3f ms through a prefab (created in %.3f ms), versus %.3f ms by copying",
+			self, instanceCount, nodeCount, prefabTime * 1000.0, prefabCreationTime * 1000.0, copyTime * 1000.0);
+}
+
+/** Returns the number of instances spawned per millisecond, for the specified total time. */
+-(double) instancesPerMillisecondIn: (ccTime) aTime {
+	return [self rateOf: instanceCount perMillisecondIn: aTime];
+}
+
+-(NSString*) resultJSON {
+	return [NSString stringWithFormat: @"{\"name\":\"%@\","
+			@"\"counters\":{\"instances\":%u,\"nodesPerInstance\":%u,\"mismatches\":%u},"
+			@"\"copyTime\":%.4f,\"prefabTime\":%.4f,\"prefabCreationTime\":%.4f,"
+			@"\"copiedInstancesPerMs\":%.2f,\"prefabInstancesPerMs\":%.2f}",
+			name, instanceCount, nodeCount, mismatches,
+			copyTime * 1000.0, prefabTime * 1000.0, prefabCreationTime * 1000.0,
+			[self instancesPerMillisecondIn: copyTime], [self instancesPerMillisecondIn: prefabTime]];
+}
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3ObjectPoolBenchmark
+
+@interface CC3ObjectPoolBenchmark (TemplateMethods)
+-(CC3Node*) makeTemplateNode;
+-(void) runNodeChurn;
+-(void) runParticleChurn;
+-(ccTime) churnParticlesWithPool: (CC3ParticlePool*) aPool;
+-(double) spawnsPerMillisecondIn: (ccTime) aTime;
+@end
+
+
+@implementation CC3ObjectPoolBenchmark
+
+@synthesize spawnCount, cycleCount, nodePool, particlePool;
+@synthesize nodeCopyTime, nodePoolTime, particleTime, particlePoolTime;
+
+-(void) dealloc {
+	[nodePool release];
+	[particlePool release];
+	[super dealloc];
+}
+
+
+#pragma mark Allocation and initialization
+
+-(id) initWithSpawnCount: (GLuint) spawns cycles: (GLuint) cycles {
+	if ( (self = [super init]) ) {
+		spawnCount = spawns;
+		cycleCount = cycles;
+		nodePool = nil;
+		particlePool = nil;
+		self.name = [NSString stringWithFormat: @"ObjectPool-%u-%u", spawns, cycles];
+	}
+	return self;
+}
+
++(id) benchmarkWithSpawnCount: (GLuint) spawns cycles: (GLuint) cycles {
+	return [[[self alloc] initWithSpawnCount: spawns cycles: cycles] autorelease];
+}
+
+
+#pragma mark Running
+
+/** Returns a small projectile-like assembly of a box mesh node with a child marker node. */
+-(CC3Node*) makeTemplateNode {
+	CC3MeshNode* boxNode = [CC3MeshNode nodeWithName: @"Projectile"];
+	[boxNode populateAsSolidBox: CC3BoundingBoxMake(-0.5, -0.5, -0.5, 0.5, 0.5, 0.5)];
+	[boxNode addChild: [CC3Node nodeWithName: @"Trail"]];
+	return boxNode;
+}
+
+-(void) runNodeChurn {
+	CC3Node* tmplNode = [self makeTemplateNode];
+	CC3Node* world = [CC3Node nodeWithName: @"World"];
+	CCArray* spawned = [CCArray arrayWithCapacity: spawnCount];
+
+	[nodePool release];
+	nodePool = [[CC3NodePool alloc] initFromNode: tmplNode];
+	nodePool.capacity = spawnCount;
+
+	double startTime = CC3PerformanceTimeNow();
+	for (GLuint c = 0; c < cycleCount; c++) {
+		for (GLuint i = 0; i < spawnCount; i++) {
+			CC3Node* aNode = [tmplNode copyWithName: tmplNode.name];
+			[world addChild: aNode];
+			[spawned addObject: aNode];
+			[aNode release];
+		}
+		for (CC3Node* aNode in spawned) [aNode remove];
+		[spawned removeAllObjects];
+	}
+	nodeCopyTime = CC3PerformanceTimeNow() - startTime;
+
+	startTime = CC3PerformanceTimeNow();
+	for (GLuint c = 0; c < cycleCount; c++) {
+		for (GLuint i = 0; i < spawnCount; i++) {
+			CC3Node* aNode = [nodePool acquireNode];
+			[world addChild: aNode];
+			[spawned addObject: aNode];
+		}
+		for (CC3Node* aNode in spawned) [aNode remove];		// Recycles into the pool
+		[spawned removeAllObjects];
+	}
+	nodePoolTime = CC3PerformanceTimeNow() - startTime;
+}
+
+/**
+ * Repeatedly creates a point particle emitter, fills it with particles, and stops it, and returns
+ * the total time taken. If the specified pool is not nil, the emitters share particles through it.
+ */
+-(ccTime) churnParticlesWithPool: (CC3ParticlePool*) aPool {
+	double startTime = CC3PerformanceTimeNow();
+	for (GLuint c = 0; c < cycleCount; c++) {
+		NSAutoreleasePool* arPool = [NSAutoreleasePool new];
+		CC3PointParticleEmitter* emitter = [CC3PointParticleEmitter nodeWithName: @"Burst"];
+		emitter.particleClass = [CC3PointParticle class];
+		emitter.particlePool = aPool;
+		emitter.maximumParticleCapacity = spawnCount;
+		emitter.particleCapacityExpansionIncrement = spawnCount;
+		emitter.vertexContentTypes = kCC3VertexContentLocation;
+		for (GLuint i = 0; i < spawnCount; i++) [emitter emitParticle];
+		[emitter stop];
+		[arPool drain];
+	}
+	return CC3PerformanceTimeNow() - startTime;
+}
+
+-(void) runParticleChurn {
+	[particlePool release];
+	particlePool = [[CC3ParticlePool alloc] initForClass: [CC3PointParticle class]];
+	particlePool.capacity = spawnCount;
+
+	particleTime = [self churnParticlesWithPool: nil];
+	particlePoolTime = [self churnParticlesWithPool: particlePool];
+}
+
+-(void) run {
+	[self runNodeChurn];
+	[self runParticleChurn];
+
+	LogInfo(@"%@ node churn took %.3f ms pooled (%@), versus %.3f ms copied",
+			self, nodePoolTime * 1000.0, nodePool, nodeCopyTime * 1000.0);
+	LogInfo(@"%@ particle churn took %.3f ms pooled (%@), versus %.3f ms unpooled",
+			self, particlePoolTime * 1000.0, particlePool, particleTime * 1000.0);
+}
+
+/** Returns the number of spawns per millisecond, for the specified total time. */
+-(double) spawnsPerMillisecondIn: (ccTime) aTime {
+	return [self rateOf: ((double)spawnCount * cycleCount) perMillisecondIn: aTime];
+}
+
+-(NSString*) resultJSON {
+	return [NSString stringWithFormat: @"{\"name\":\"%@\","
+			@"\"counters\":{\"spawnsPerCycle\":%u,\"cycles\":%u,"
+			@"\"nodePoolHits\":%u,\"nodePoolMisses\":%u,\"nodePoolDiscards\":%u,"
+			@"\"particlePoolHits\":%u,\"particlePoolMisses\":%u,\"particlePoolDiscards\":%u},"
+			@"\"nodeCopyTime\":%.4f,\"nodePoolTime\":%.4f,\"particleTime\":%.4f,\"particlePoolTime\":%.4f,"
+			@"\"copiedNodesPerMs\":%.2f,\"pooledNodesPerMs\":%.2f,"
+			@"\"particlesPerMs\":%.2f,\"pooledParticlesPerMs\":%.2f}",
+			name, spawnCount, cycleCount,
+			nodePool.hitCount, nodePool.missCount, nodePool.discardedCount,
+			particlePool.hitCount, particlePool.missCount, particlePool.discardedCount,
+			nodeCopyTime * 1000.0, nodePoolTime * 1000.0, particleTime * 1000.0, particlePoolTime * 1000.0,
+			[self spawnsPerMillisecondIn: nodeCopyTime], [self spawnsPerMillisecondIn: nodePoolTime],
+			[self spawnsPerMillisecondIn: particleTime], [self spawnsPerMillisecondIn: particlePoolTime]];
+}
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3BitmapLabelBenchmark
+
+@interface CC3BitmapLabelBenchmark (TemplateMethods)
+-(NSString*) labelStringAt: (GLuint) lblIdx forUpdate: (GLuint) updIdx;
+-(double) updatesPerMillisecondIn: (ccTime) aTime;
+@end
+
+
+@implementation CC3BitmapLabelBenchmark
+
+@synthesize fontFileName, labelCount, updateCount, rebuildTime, incrementalTime;
+
+-(void) dealloc {
+	[fontFileName release];
+	[super dealloc];
+}
+
+
+#pragma mark Allocation and initialization
+
+-(id) initFromFontFile: (NSString*) aFileName withLabelCount: (GLuint) lblCount updates: (GLuint) updCount {
+	if ( (self = [super init]) ) {
+		fontFileName = [aFileName retain];
+		labelCount = lblCount;
+		updateCount = updCount;
+		self.name = [NSString stringWithFormat: @"BitmapLabels-%u-%u", lblCount, updCount];
+	}
+	return self;
+}
+
++(id) benchmarkFromFontFile: (NSString*) aFileName withLabelCount: (GLuint) lblCount updates: (GLuint) updCount {
+	return [[[self alloc] initFromFontFile: aFileName withLabelCount: lblCount updates: updCount] autorelease];
+}
+
+
+#pragma mark Running
+
+/** Returns a score-like string for the specified label, whose last digits change with each update. */
+-(NSString*) labelStringAt: (GLuint) lblIdx forUpdate: (GLuint) updIdx {
+	return [NSString stringWithFormat: @"Score %u: %06u", lblIdx, (lblIdx * 1000) + (updIdx * 7)];
+}
+
+-(void) run {
+	CCArray* meshNodes = [CCArray arrayWithCapacity: labelCount];
+	CCArray* labels = [CCArray arrayWithCapacity: labelCount];
+	for (GLuint i = 0; i < labelCount; i++) {
+		[meshNodes addObject: [CC3MeshNode nodeWithName: [NSString stringWithFormat: @"Mesh-%u", i]]];
+
+		CC3BitmapLabelNode* lbl = [CC3BitmapLabelNode nodeWithName: [NSString stringWithFormat: @"Label-%u", i]];
+		lbl.fontFileName = fontFileName;
+		lbl.labelString = [self labelStringAt: i forUpdate: 0];
+		[labels addObject: lbl];
+	}
+
+	double startTime = CC3PerformanceTimeNow();
+	for (GLuint u = 1; u <= updateCount; u++) {
+		GLuint lblIdx = 0;
+		for (CC3MeshNode* aNode in meshNodes) {
+			[aNode populateAsBitmapFontLabelFromString: [self labelStringAt: lblIdx++ forUpdate: u]
+										  fromFontFile: fontFileName
+										 andLineHeight: 0
+									  andTextAlignment: UITextAlignmentLeft
+									 andRelativeOrigin: ccp(0,0)
+									   andTessellation: ccg(1,1)];
+			[aNode markBoundingVolumeDirty];
+		}
+	}
+	rebuildTime = CC3PerformanceTimeNow() - startTime;
+
+	startTime = CC3PerformanceTimeNow();
+	for (GLuint u = 1; u <= updateCount; u++) {
+		GLuint lblIdx = 0;
+		for (CC3BitmapLabelNode* lbl in labels)
+			lbl.labelString = [self labelStringAt: lblIdx++ forUpdate: u];
+	}
+	incrementalTime = CC3PerformanceTimeNow() - startTime;
+
+	LogInfo(@"%@ updated %u labels %u times in %.3f ms incrementally, versus %.3f ms by rebuilding",
+			self, labelCount, updateCount, incrementalTime * 1000.0, rebuildTime * 1000.0);
+}
+
+/** Returns the number of label updates per millisecond, for the specified total time. */
+-(double) updatesPerMillisecondIn: (ccTime) aTime {
+	return [self rateOf: ((double)labelCount * updateCount) perMillisecondIn: aTime];
+}
+
+-(NSString*) resultJSON {
+	return [NSString stringWithFormat: @"{\"name\":\"%@\","
+			@"\"counters\":{\"labels\":%u,\"updates\":%u},"
+			@"\"rebuildTime\":%.4f,\"incrementalTime\":%.4f,"
+			@"\"rebuiltUpdatesPerMs\":%.2f,\"incrementalUpdatesPerMs\":%.2f}",
+			name, labelCount, updateCount, rebuildTime * 1000.0, incrementalTime * 1000.0,
+			[self updatesPerMillisecondIn: rebuildTime], [self updatesPerMillisecondIn: incrementalTime]];
+}
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3VertexBufferUpdateBenchmark
+
+/** The techniques used to copy the changed vertex content to the GL buffer. */
+typedef enum {
+	kCC3VertexBufferUpdateFull,				/**< Update the entire buffer. */
+	kCC3VertexBufferUpdateRange,			/**< Update only the dirty vertex range. */
+	kCC3VertexBufferUpdateReload,			/**< Reload the entire buffer. */
+	kCC3VertexBufferUpdateStream,			/**< Stream the entire content into the vertex stream. */
+} CC3VertexBufferUpdateTechnique;
+
+
+@interface CC3VertexBufferUpdateBenchmark (TemplateMethods)
+-(void) populateVertexLocations;
+-(void) changeVerticesForFrame: (GLuint) frameIdx;
+-(ccTime) runTechnique: (CC3VertexBufferUpdateTechnique) technique bytesLoaded: (GLuint*) pBytes;
+-(void) verifyBytes: (GLuint) bytes perFrame: (GLuint) vtxCount forTechnique: (NSString*) techName;
+-(double) kilobytesPerFrameFor: (GLuint) bytes;
+@end
+
+
+@implementation CC3VertexBufferUpdateBenchmark
+
+@synthesize vertexCount, changeCount, frameCount, mismatchCount;
+@synthesize fullBytes, rangeBytes, reloadBytes, fullTime, rangeTime, reloadTime;
+@synthesize streamBytes, streamStallsAvoided, streamOrphanCount, streamTime;
+
+-(void) dealloc {
+	[vertexLocations release];
+	[super dealloc];
+}
+
+
+#pragma mark Allocation and initialization
+
+-(id) initWithVertexCount: (GLuint) vtxCount changesPerFrame: (GLuint) changes frames: (GLuint) frames {
+	if ( (self = [super init]) ) {
+		vertexCount = vtxCount;
+		changeCount = MIN(changes, vtxCount);
+		frameCount = frames;
+		vertexLocations = nil;
+		self.name = [NSString stringWithFormat: @"VertexBufferUpdate-%u-%u", vtxCount, changes];
+	}
+	return self;
+}
+
++(id) benchmarkWithVertexCount: (GLuint) vtxCount changesPerFrame: (GLuint) changes frames: (GLuint) frames {
+	return [[[self alloc] initWithVertexCount: vtxCount changesPerFrame: changes frames: frames] autorelease];
+}
+
+
+#pragma mark Running
+
+/** Creates the vertex locations as a flat grid of vertices, and buffers them to the GL engine. */
+-(void) populateVertexLocations {
+	[vertexLocations release];
+	vertexLocations = [[CC3VertexLocations vertexArrayWithName: name] retain];
+	vertexLocations.allocatedVertexCapacity = vertexCount;
+	GLuint side = (GLuint)ceilf(sqrtf((GLfloat)vertexCount));
+	for (GLuint i = 0; i < vertexCount; i++) {
+		[vertexLocations setLocation: cc3v(i % side, 0.0f, i / side) at: i];
+	}
+	vertexLocations.bufferUsage = GL_DYNAMIC_DRAW;
+	[vertexLocations createGLBuffer];
+}
+
+/** Raises the vertices in a window that moves along the mesh from frame to frame. */
+-(void) changeVerticesForFrame: (GLuint) frameIdx {
+	GLuint windowCount = (vertexCount - changeCount) + 1;
+	GLuint startIdx = (frameIdx * changeCount) % windowCount;
+	for (GLuint i = startIdx; i < startIdx + changeCount; i++) {
+		CC3Vector loc = [vertexLocations locationAt: i];
+		loc.y = (GLfloat)(frameIdx % 8);
+		[vertexLocations setLocation: loc at: i];
+	}
+}
+
+/**
+ * Changes the vertices and copies them to the GL buffer, on each frame, using the specified
+ * technique. Returns the time taken, and the number of bytes copied in the specified pointer.
+ */
+-(ccTime) runTechnique: (CC3VertexBufferUpdateTechnique) technique bytesLoaded: (GLuint*) pBytes {
+	CC3OpenGLESStateTrackerArrayBufferBinding* bufferBinding;
+	bufferBinding = [CC3OpenGLESEngine.engine.vertices bufferBinding: vertexLocations.bufferTarget];
+
+	CC3OpenGLESVertexStream* vtxStream = [CC3OpenGLESEngine.engine.vertices streamForTarget: vertexLocations.bufferTarget];
+	GLsizeiptr streamLength = vertexLocations.vertexStride * vertexCount;
+
+	GLfloat origThreshold = [CC3VertexArray dirtyBufferReloadThreshold];
+	[CC3VertexArray setDirtyBufferReloadThreshold: (technique == kCC3VertexBufferUpdateReload) ? 0.0f : 2.0f];
+	[vtxStream resetStatistics];
+	[bufferBinding resetBytesLoaded];
+
+	double startTime = CC3PerformanceTimeNow();
+	for (GLuint f = 0; f < frameCount; f++) {
+		[self changeVerticesForFrame: f];
+		GLintptr streamOffset;
+		switch (technique) {
+			case kCC3VertexBufferUpdateFull:
+				[vertexLocations updateGLBuffer];
+				break;
+			case kCC3VertexBufferUpdateStream:
+				[vtxStream beginFrame];
+				[vtxStream streamData: vertexLocations.vertices
+							 ofLength: streamLength
+							 toOffset: &streamOffset
+							 canReuse: NO];
+				break;
+			default:
+				[vertexLocations updateGLBufferFromDirtyVertexRange];
+				break;
+		}
+	}
+	glFinish();
+	ccTime runTime = CC3PerformanceTimeNow() - startTime;
+
+	*pBytes = bufferBinding.bytesLoaded;
+	[bufferBinding unbind];
+	[CC3VertexArray setDirtyBufferReloadThreshold: origThreshold];
+	return runTime;
+}
+
+/** Counts a mismatch if the specified byte count is not the expected count for the specified vertices per frame. */
+-(void) verifyBytes: (GLuint) bytes perFrame: (GLuint) vtxCount forTechnique: (NSString*) techName {
+	GLuint expectedBytes = vtxCount * vertexLocations.vertexStride * frameCount;
+	if (bytes != expectedBytes) {
+		LogInfo(@"%@ %@ copied %u bytes to the GL buffer but %u were expected", self, techName, bytes, expectedBytes);
+		mismatchCount++;
+	}
+}
+
+-(void) run {
+	mismatchCount = 0;
+	fullBytes = rangeBytes = reloadBytes = streamBytes = 0;
+	streamStallsAvoided = streamOrphanCount = 0;
+	fullTime = rangeTime = reloadTime = streamTime = 0.0;
+
+	[self populateVertexLocations];
+	if ( !vertexLocations.isUsingGLBuffer ) {
+		LogInfo(@"%@ could not create a GL buffer, and has nothing to measure", self);
+		return;
+	}
+
+	fullTime = [self runTechnique: kCC3VertexBufferUpdateFull bytesLoaded: &fullBytes];
+	rangeTime = [self runTechnique: kCC3VertexBufferUpdateRange bytesLoaded: &rangeBytes];
+	reloadTime = [self runTechnique: kCC3VertexBufferUpdateReload bytesLoaded: &reloadBytes];
+
+	[vertexLocations deleteGLBuffer];
+	streamTime = [self runTechnique: kCC3VertexBufferUpdateStream bytesLoaded: &streamBytes];
+	CC3OpenGLESVertexStream* vtxStream = [CC3OpenGLESEngine.engine.vertices streamForTarget: vertexLocations.bufferTarget];
+	streamStallsAvoided = vtxStream.stallsAvoided;
+	streamOrphanCount = vtxStream.orphanCount;
+
+	[self verifyBytes: fullBytes perFrame: vertexCount forTechnique: @"full update"];
+	[self verifyBytes: rangeBytes perFrame: changeCount forTechnique: @"range update"];
+	[self verifyBytes: reloadBytes perFrame: vertexCount forTechnique: @"reload"];
+	[self verifyBytes: streamBytes perFrame: vertexCount forTechnique: @"stream"];
+	if (vtxStream.overflowCount) {
+		LogInfo(@"%@ content of %u bytes overflowed %@", self, vertexCount * vertexLocations.vertexStride, vtxStream);
+		mismatchCount++;
+	}
+
+	LogInfo(@"%@ copied %u bytes in %.3f ms by range, versus %u bytes in %.3f ms in full and %u bytes in %.3f ms by reloading",
+			self, rangeBytes, rangeTime * 1000.0, fullBytes, fullTime * 1000.0, reloadBytes, reloadTime * 1000.0);
+	LogInfo(@"%@ streamed %u bytes in %.3f ms, avoiding %u stalls with %u orphans",
+			self, streamBytes, streamTime * 1000.0, streamStallsAvoided, streamOrphanCount);
+}
+
+/** Returns the number of kilobytes copied per frame, for the specified total bytes. */
+-(double) kilobytesPerFrameFor: (GLuint) bytes {
+	return frameCount ? (double)bytes / (1024.0 * frameCount) : 0.0;
+}
+
+-(NSString*) resultJSON {
+	return [NSString stringWithFormat: @"{\"name\":\"%@\","
+			@"\"counters\":{\"vertexCount\":%u,\"changesPerFrame\":%u,\"frames\":%u,"
+			@"\"fullBytes\":%u,\"rangeBytes\":%u,\"reloadBytes\":%u,\"streamBytes\":%u,"
+			@"\"streamStallsAvoided\":%u,\"streamOrphans\":%u,\"mismatches\":%u},"
+			@"\"fullTime\":%.4f,\"rangeTime\":%.4f,\"reloadTime\":%.4f,\"streamTime\":%.4f,"
+			@"\"fullKBPerFrame\":%.2f,\"rangeKBPerFrame\":%.2f,\"reloadKBPerFrame\":%.2f,\"streamKBPerFrame\":%.2f}",
+			name, vertexCount, changeCount, frameCount,
+			fullBytes, rangeBytes, reloadBytes, streamBytes,
+			streamStallsAvoided, streamOrphanCount, mismatchCount,
+			fullTime * 1000.0, rangeTime * 1000.0, reloadTime * 1000.0, streamTime * 1000.0,
+			[self kilobytesPerFrameFor: fullBytes], [self kilobytesPerFrameFor: rangeBytes],
+			[self kilobytesPerFrameFor: reloadBytes], [self kilobytesPerFrameFor: streamBytes]];
+}
+
+@end
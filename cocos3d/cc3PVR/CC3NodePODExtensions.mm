@@ -83,8 +83,12 @@ extern "C" {
 			self.scale = *(CC3Vector*)psn->pfAnimScale;
 		}
 		if ([CC3PODNodeAnimation sPODNodeDoesContainAnimation: (PODStructPtr)psn]) {
-			self.animation = [CC3PODNodeAnimation animationFromSPODNode: (PODStructPtr)psn
-														 withFrameCount: aPODRez.animationFrameCount];
+			CC3NodeAnimation* podAnim = [CC3PODNodeAnimation animationFromSPODNode: (PODStructPtr)psn
+																	withFrameCount: aPODRez.animationFrameCount];
+			if (aPODRez.shouldCompressAnimation)
+				podAnim = [CC3CompressedNodeAnimation animationFromAnimation: podAnim
+															   withTolerance: [CC3CompressedNodeAnimation defaultTolerance]];
+			self.animation = podAnim;
 		}
 	}
 	return self; 
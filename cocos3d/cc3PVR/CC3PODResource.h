@@ -99,6 +99,10 @@
 	CCArray* materials;
 	CCArray* textures;
 	ccTexParams textureParameters;
+	BOOL shouldOptimizeMeshes : 1;
+	BOOL shouldOptimizeMeshOverdraw : 1;
+	BOOL shouldQuantizeMeshes : 1;
+	BOOL shouldCompressAnimation : 1;
 }
 
 /**
@@ -139,6 +143,75 @@
 /** A collection of the CC3Meshs extracted from  the POD file. */
 @property(nonatomic, readonly) CCArray* meshes;
 
+/**
+ * Indicates whether the triangles and vertices of each mesh should be reordered, as the
+ * meshes are built, to improve the reuse of vertices in the post-transform vertex cache
+ * of the GPU, and the locality of vertex fetches from memory.
+ *
+ * Optimization is performed by the optimizeMeshAtIndex: method. Since optimization takes
+ * time during loading, it is best used on meshes that were not optimized when exported.
+ *
+ * The initial value of this property is set from the class-side defaultShouldOptimizeMeshes
+ * property, which is initially NO.
+ */
+@property(nonatomic, assign) BOOL shouldOptimizeMeshes;
+
+/**
+ * Indicates whether, when optimizing meshes, clusters of triangles should also be reordered
+ * so that the triangles facing outwards from the center of each mesh are drawn first, to
+ * reduce overdraw when the mesh occludes itself. This has a slight cost in vertex cache reuse.
+ *
+ * This property has no effect unless the shouldOptimizeMeshes property is set to YES.
+ *
+ * The initial value of this property is NO.
+ */
+@property(nonatomic, assign) BOOL shouldOptimizeMeshOverdraw;
+
+/** The initial value of the shouldOptimizeMeshes property of new instances. Initially NO. */
++(BOOL) defaultShouldOptimizeMeshes;
+
+/** Sets the initial value of the shouldOptimizeMeshes property of new instances. */
++(void) setDefaultShouldOptimizeMeshes: (BOOL) shouldOptimize;
+
+/**
+ * Indicates whether the vertex content of each mesh should be converted to compact quantized
+ * forms, as the meshes are built, to reduce the memory and bandwidth consumed by the meshes.
+ *
+ * Quantization is performed by the quantizeVertexContent method of CC3VertexArrayMesh.
+ * See the notes for that method for the conversions performed, and their limitations.
+ *
+ * The initial value of this property is set from the class-side defaultShouldQuantizeMeshes
+ * property, which is initially NO.
+ */
+@property(nonatomic, assign) BOOL shouldQuantizeMeshes;
+
+/** The initial value of the shouldQuantizeMeshes property of new instances. Initially NO. */
++(BOOL) defaultShouldQuantizeMeshes;
+
+/** Sets the initial value of the shouldQuantizeMeshes property of new instances. */
++(void) setDefaultShouldQuantizeMeshes: (BOOL) shouldQuantize;
+
+/**
+ * Indicates whether the animation content of each node should be compressed, as the nodes
+ * are built, to reduce the memory consumed by the animation.
+ *
+ * When this property is YES, the animation of each animated node is held in a
+ * CC3CompressedNodeAnimation, using the tolerance returned by the class-side defaultTolerance
+ * property of that class, instead of in a CC3PODNodeAnimation. The number of bytes saved by
+ * the compression is logged once all of the nodes have been built. See the notes for the
+ * CC3CompressedNodeAnimation class for the compression performed.
+ *
+ * The initial value of this property is set from the class-side defaultShouldCompressAnimation
+ * property, which is initially NO.
+ */
+@property(nonatomic, assign) BOOL shouldCompressAnimation;
+
+/** The initial value of the shouldCompressAnimation property of new instances. Initially NO. */
++(BOOL) defaultShouldCompressAnimation;
+
+/** Sets the initial value of the shouldCompressAnimation property of new instances. */
++(void) setDefaultShouldCompressAnimation: (BOOL) shouldCompress;
+
 /** The number of materials in the POD file. */
 @property(nonatomic, readonly) uint materialCount;
 
@@ -313,6 +386,20 @@
  */
 -(CC3Mesh*) buildMeshAtIndex: (uint) meshIndex;
 
+/**
+ * Reorders the triangles and vertices of the meshIndex'th SPODMesh structure for better
+ * post-transform vertex cache reuse, and, if the shouldOptimizeMeshOverdraw property is
+ * set to YES, for less overdraw. The average cache miss ratio (ACMR) and average transformed
+ * vertex ratio (ATVR) of the mesh, before and after optimization, are logged.
+ *
+ * This is automatically invoked from the buildMeshes method, before the mesh is built, if
+ * the shouldOptimizeMeshes property is set to YES. Meshes that are not drawn as indexed
+ * triangle lists are left unchanged.
+ *
+ * This template method can be overridden in a subclass if specialized processing is required.
+ */
+-(void) optimizeMeshAtIndex: (uint) meshIndex;
+
 /**
  * Returns meshIndex'th SPODMesh structure from the data structures.
  * Note that meshIndex is an ordinal number indicating the rank of the mesh.
@@ -56,12 +56,14 @@ static const id placeHolder = [NSObject new];
 
 /** The underlying pvrtModel property, cast to the correct CPVRTModelPOD C++ class. */
 @property(nonatomic, readonly)  CPVRTModelPOD* pvrtModelImpl;
+-(void) logAnimationCompression;
 @end
 
 
 @implementation CC3PODResource
 
 @synthesize pvrtModel, allNodes, meshes, materials, textures, textureParameters;
+@synthesize shouldOptimizeMeshes, shouldOptimizeMeshOverdraw, shouldQuantizeMeshes, shouldCompressAnimation;
 
 -(void) dealloc {
 	[allNodes release];
@@ -86,10 +88,38 @@ static const id placeHolder = [NSObject new];
 		materials = [[CCArray array] retain];
 		textures = [[CCArray array] retain];
 		textureParameters = [CC3Texture defaultTextureParameters];
+		shouldOptimizeMeshes = [[self class] defaultShouldOptimizeMeshes];
+		shouldOptimizeMeshOverdraw = NO;
+		shouldQuantizeMeshes = [[self class] defaultShouldQuantizeMeshes];
+		shouldCompressAnimation = [[self class] defaultShouldCompressAnimation];
 	}
 	return self;
 }
 
+static BOOL defaultShouldOptimizeMeshes = NO;
+
++(BOOL) defaultShouldOptimizeMeshes { return defaultShouldOptimizeMeshes; }
+
++(void) setDefaultShouldOptimizeMeshes: (BOOL) shouldOptimize {
+	defaultShouldOptimizeMeshes = shouldOptimize;
+}
+
+static BOOL defaultShouldQuantizeMeshes = NO;
+
++(BOOL) defaultShouldQuantizeMeshes { return defaultShouldQuantizeMeshes; }
+
++(void) setDefaultShouldQuantizeMeshes: (BOOL) shouldQuantize {
+	defaultShouldQuantizeMeshes = shouldQuantize;
+}
+
+static BOOL defaultShouldCompressAnimation = NO;
+
++(BOOL) defaultShouldCompressAnimation { return defaultShouldCompressAnimation; }
+
++(void) setDefaultShouldCompressAnimation: (BOOL) shouldCompress {
+	defaultShouldCompressAnimation = shouldCompress;
+}
+
 -(BOOL) processFile: (NSString*) anAbsoluteFilePath {
 	wasLoaded = (self.pvrtModelImpl->ReadFromFile([anAbsoluteFilePath cStringUsingEncoding:NSUTF8StringEncoding]) == PVR_SUCCESS);
 	if (wasLoaded) [self build];
@@ -143,6 +173,26 @@ static const id placeHolder = [NSObject new];
 			[self.nodes addObject: aNode];
 		}
 	}
+
+	if (shouldCompressAnimation) [self logAnimationCompression];
+}
+
+/** Logs the number of bytes saved by compressing the animation content of the nodes. */
+-(void) logAnimationCompression {
+	GLuint animCount = 0, keyCount = 0, uncompressedByteCount = 0, byteCount = 0;
+	for (CC3Node* aNode in allNodes) {
+		CC3NodeAnimation* anim = aNode.animation;
+		if ( ![anim isKindOfClass: [CC3CompressedNodeAnimation class]] ) continue;
+
+		CC3CompressedNodeAnimation* compAnim = (CC3CompressedNodeAnimation*)anim;
+		animCount++;
+		keyCount += compAnim.keyCount;
+		uncompressedByteCount += compAnim.uncompressedByteCount;
+		byteCount += compAnim.byteCount;
+	}
+	if (animCount) LogInfo(@"%@ compressed %u frames of animation of %u nodes into %u keys, reducing %u bytes to %u bytes (%.1f%%)",
+						   self, self.animationFrameCount, animCount, keyCount, uncompressedByteCount, byteCount,
+						   (100.0f * byteCount / MAX(uncompressedByteCount, 1)));
 }
 
 -(CC3Node*) buildNodeAtIndex: (uint) nodeIndex {
@@ -267,7 +317,22 @@ static const id placeHolder = [NSObject new];
 	
 	// Build the array containing all materials in the PVRT structure
 	for (uint i = 0; i < mCount; i++) {
-		[meshes addObject: [self buildMeshAtIndex: i]];
+		if (shouldOptimizeMeshes) [self optimizeMeshAtIndex: i];
+		CC3VertexArrayMesh* mesh = (CC3VertexArrayMesh*)[self buildMeshAtIndex: i];
+		if (shouldQuantizeMeshes) [mesh quantizeVertexContent];
+		[meshes addObject: mesh];
+	}
+}
+
+-(void) optimizeMeshAtIndex: (uint) meshIndex {
+	SPODMesh* psm = (SPODMesh*)[self meshPODStructAtIndex: meshIndex];
+	SPODMeshOptimizeStats stats;
+	if (PVRTModelPODOptimizeMesh(*psm, &stats, shouldOptimizeMeshOverdraw) == PVR_SUCCESS) {
+		LogInfo(@"%@ optimized mesh %u with %u vertices and %u faces. ACMR: %.3f -> %.3f, ATVR: %.3f -> %.3f",
+				self, meshIndex, psm->nNumVertex, psm->nNumFaces,
+				stats.fACMRBefore, stats.fACMRAfter, stats.fATVRBefore, stats.fATVRAfter);
+	} else {
+		LogRez(@"%@ could not optimize mesh %u, because it is not an indexed triangle list", self, meshIndex);
 	}
 }
 
@@ -103,3 +103,36 @@ NSString* NSStringFromSPODLight(PODStructPtr pSPODLight);
 /** Returns the name of the specified ePODLight light type operation. */
 NSString* NSStringFromEPODLight(uint ePODLight);
 
+
+#pragma mark -
+#pragma mark Tangent space generation
+
+/** The results of comparing the tangent space generated for the meshes in a POD file by two functions. */
+typedef struct {
+	GLuint meshCount;			/**< The number of meshes processed. */
+	GLuint triangleCount;		/**< The number of triangles in the meshes processed. */
+	GLuint vertexCountIn;		/**< The number of vertices in the meshes processed. */
+	GLuint vertexCountOut;		/**< The number of vertices, including split vertices, generated. */
+	GLuint meshesMatched;		/**< The number of meshes for which both functions generated identical content. */
+	GLuint meshesDiffered;		/**< The number of meshes for which both functions succeeded with different content. */
+	GLuint legacyFailures;		/**< The number of meshes for which only the legacy function failed. */
+	GLuint failures;			/**< The number of meshes for which PVRTVertexGenerateTangentSpace failed. */
+	ccTime legacyTime;			/**< The total time, in seconds, spent in the legacy function. */
+	ccTime generatorTime;		/**< The total time, in seconds, spent in PVRTVertexGenerateTangentSpace. */
+} CC3PODTangentSpaceComparison;
+
+/**
+ * Loads the POD file at the specified absolute file path, and generates the vertex tangents and
+ * bitangents of each of its meshes the specified number of times, using both the
+ * PVRTVertexGenerateTangentSpace function, with the specified number of threads, and the original
+ * PVRTVertexGenerateTangentSpaceLegacy function that it replaces, and compares the results.
+ *
+ * Only meshes that contain vertex normals and texture coordinates, and that are drawn as triangle
+ * lists, are included. The tangent space is generated from the first set of texture coordinates.
+ *
+ * The results are accumulated into the specified comparison structure, which should be zeroed
+ * beforehand. Returns NO if the POD file could not be loaded, or YES otherwise.
+ */
+BOOL CC3ComparePODFileTangentSpaceGeneration(NSString* aFilePath, GLuint repeatCount, GLuint threadCount,
+											 GLfloat splitDifference, CC3PODTangentSpaceComparison* comparison);
+
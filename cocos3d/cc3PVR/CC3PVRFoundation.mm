@@ -31,10 +31,12 @@
 
 extern "C" {
 	#import "CC3Foundation.h"	// extern must be first, since foundation also imported via other imports
+	#import "CC3PerformanceStatistics.h"
 }
 #import "CC3PVRFoundation.h"
 #import "CC3PVRTModelPOD.h"
 #import "CC3Matrix4x4.h"
+#import "PVRTVertex.h"
 
 
 NSString* NSStringFromSPODNode(PODStructPtr pSPODNode) {
@@ -396,3 +398,137 @@ NSString* NSStringFromSPODTexture(PODStructPtr pSPODTexture) {
 }
 
 
+#pragma mark -
+#pragma mark Tangent space generation
+
+/** Layout of the packed vertices from which the tangent space is generated. */
+typedef struct {
+	GLfloat location[3];
+	GLfloat normal[3];
+	GLfloat texCoord[2];
+	GLfloat tangent[3];
+	GLfloat bitangent[3];
+} CC3TangentSpaceVertex;
+
+#define kCC3TangentSpaceOffsetLocation	offsetof(CC3TangentSpaceVertex, location)
+#define kCC3TangentSpaceOffsetNormal	offsetof(CC3TangentSpaceVertex, normal)
+#define kCC3TangentSpaceOffsetTexCoord	offsetof(CC3TangentSpaceVertex, texCoord)
+#define kCC3TangentSpaceOffsetTangent	offsetof(CC3TangentSpaceVertex, tangent)
+#define kCC3TangentSpaceOffsetBitangent	offsetof(CC3TangentSpaceVertex, bitangent)
+
+/** Returns a pointer to the data for the specified vertex in the specified POD data array. */
+static const char* CC3PODVertexData(SPODMesh* psm, CPODData* pData, GLuint vtxIdx) {
+	const char* pBase = psm->pInterleaved
+							? (const char*)psm->pInterleaved + (size_t)pData->pData
+							: (const char*)pData->pData;
+	return pBase + (vtxIdx * pData->nStride);
+}
+
+/** Generates and compares the tangent space of the specified mesh, if it is a triangle list with normals and texture coordinates. */
+static void CC3ComparePODMeshTangentSpaceGeneration(SPODMesh* psm, GLuint repeatCount, GLuint threadCount,
+													GLfloat splitDifference, CC3PODTangentSpaceComparison* comparison) {
+	if (psm->ePrimitiveType != ePODTriangles || psm->nNumStrips ||
+		!psm->sNormals.n || !psm->nNumUVW || !psm->psUVW[0].n) return;
+
+	GLuint vtxCount = psm->nNumVertex;
+	GLuint triCount = psm->nNumFaces;
+	GLuint idxCount = triCount * 3;
+
+	// Pack the locations, normals and texture coordinates into float vertices
+	CC3TangentSpaceVertex* vertices = (CC3TangentSpaceVertex*)calloc(vtxCount, sizeof(CC3TangentSpaceVertex));
+	for (GLuint v = 0; v < vtxCount; v++) {
+		PVRTVECTOR4f vec;
+		PVRTVertexRead(&vec, CC3PODVertexData(psm, &psm->sVertex, v), psm->sVertex.eType, 3);
+		memcpy(vertices[v].location, &vec, sizeof(vertices[v].location));
+		PVRTVertexRead(&vec, CC3PODVertexData(psm, &psm->sNormals, v), psm->sNormals.eType, 3);
+		memcpy(vertices[v].normal, &vec, sizeof(vertices[v].normal));
+		PVRTVertexRead(&vec, CC3PODVertexData(psm, &psm->psUVW[0], v), psm->psUVW[0].eType, 2);
+		memcpy(vertices[v].texCoord, &vec, sizeof(vertices[v].texCoord));
+	}
+
+	GLuint* indices = (GLuint*)malloc(idxCount * sizeof(GLuint));
+	for (GLuint i = 0; i < idxCount; i++) {
+		indices[i] = (psm->sFaces.eType == EPODDataUnsignedInt)
+						? ((PVRTuint32*)psm->sFaces.pData)[i]
+						: ((PVRTuint16*)psm->sFaces.pData)[i];
+	}
+
+	GLuint* legacyIndices = (GLuint*)malloc(idxCount * sizeof(GLuint));
+	GLuint* genIndices = (GLuint*)malloc(idxCount * sizeof(GLuint));
+	char* legacyVertices = NULL;
+	char* genVertices = NULL;
+	unsigned int legacyVtxCount = 0;
+	unsigned int genVtxCount = 0;
+	EPVRTError legacyErr = PVR_FAIL;
+	EPVRTError genErr = PVR_FAIL;
+
+	for (GLuint r = 0; r < repeatCount; r++) {
+		FREE(legacyVertices);
+		memcpy(legacyIndices, indices, idxCount * sizeof(GLuint));
+		double startTime = CC3PerformanceTimeNow();
+		legacyErr = PVRTVertexGenerateTangentSpaceLegacy(&legacyVtxCount, &legacyVertices, legacyIndices,
+														 vtxCount, (const char*)vertices, sizeof(CC3TangentSpaceVertex),
+														 kCC3TangentSpaceOffsetLocation, EPODDataFloat,
+														 kCC3TangentSpaceOffsetNormal, EPODDataFloat,
+														 kCC3TangentSpaceOffsetTexCoord, EPODDataFloat,
+														 kCC3TangentSpaceOffsetTangent, EPODDataFloat,
+														 kCC3TangentSpaceOffsetBitangent, EPODDataFloat,
+														 triCount, splitDifference);
+		comparison->legacyTime += CC3PerformanceTimeNow() - startTime;
+
+		FREE(genVertices);
+		memcpy(genIndices, indices, idxCount * sizeof(GLuint));
+		startTime = CC3PerformanceTimeNow();
+		genErr = PVRTVertexGenerateTangentSpace(&genVtxCount, &genVertices, genIndices,
+												vtxCount, (const char*)vertices, sizeof(CC3TangentSpaceVertex),
+												kCC3TangentSpaceOffsetLocation, EPODDataFloat,
+												kCC3TangentSpaceOffsetNormal, EPODDataFloat,
+												kCC3TangentSpaceOffsetTexCoord, EPODDataFloat,
+												kCC3TangentSpaceOffsetTangent, EPODDataFloat,
+												kCC3TangentSpaceOffsetBitangent, EPODDataFloat,
+												triCount, splitDifference, threadCount);
+		comparison->generatorTime += CC3PerformanceTimeNow() - startTime;
+	}
+
+	comparison->meshCount++;
+	comparison->triangleCount += triCount;
+	comparison->vertexCountIn += vtxCount;
+	if (genErr != PVR_SUCCESS) {
+		comparison->failures++;
+	} else {
+		comparison->vertexCountOut += genVtxCount;
+		if (legacyErr != PVR_SUCCESS) {
+			comparison->legacyFailures++;
+		} else if (legacyVtxCount == genVtxCount &&
+				   memcmp(legacyIndices, genIndices, idxCount * sizeof(GLuint)) == 0 &&
+				   memcmp(legacyVertices, genVertices, genVtxCount * sizeof(CC3TangentSpaceVertex)) == 0) {
+			comparison->meshesMatched++;
+		} else {
+			comparison->meshesDiffered++;
+			LogError(@"PVRTVertexGenerateTangentSpace generated a different tangent space than the legacy function for a mesh with %u vertices",
+					 vtxCount);
+		}
+	}
+
+	FREE(legacyVertices);
+	FREE(genVertices);
+	free(legacyIndices);
+	free(genIndices);
+	free(indices);
+	free(vertices);
+}
+
+// Loads a private copy of the POD data, since CC3PODResource hands
+// ownership of the vertex content over to the meshes it builds.
+BOOL CC3ComparePODFileTangentSpaceGeneration(NSString* aFilePath, GLuint repeatCount, GLuint threadCount,
+											 GLfloat splitDifference, CC3PODTangentSpaceComparison* comparison) {
+	CPVRTModelPOD* pod = new CPVRTModelPOD();
+	if (pod->ReadFromFile([aFilePath cStringUsingEncoding: NSUTF8StringEncoding]) != PVR_SUCCESS) {
+		delete pod;
+		return NO;
+	}
+	for (GLuint i = 0; i < pod->nNumMesh; i++)
+		CC3ComparePODMeshTangentSpaceGeneration(&pod->pMesh[i], repeatCount, threadCount, splitDifference, comparison);
+	delete pod;
+	return YES;
+}
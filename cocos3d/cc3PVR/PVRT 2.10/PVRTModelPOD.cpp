@@ -180,6 +180,8 @@ struct SPVRTPODImpl
 	PVRTMATRIX	*pWmCache;		/*!< Cache of world matrices */
 	PVRTMATRIX	*pWmZeroCache;	/*!< Pre-calculated frame 0 matrices */
 
+	unsigned int	*pnEvalOrder;	/*!< Node indices, ordered so that each parent precedes its children */
+
 	bool		bFromMemory;	/*!< Was the mesh data loaded from memory? */
 
 #ifdef _DEBUG
@@ -2089,6 +2091,8 @@ EPVRTError CPVRTModelPOD::InitImpl()
 	m_pImpl->pfCache		= new VERTTYPE[nNumNode];
 	m_pImpl->pWmCache		= new PVRTMATRIX[nNumNode];
 	m_pImpl->pWmZeroCache	= new PVRTMATRIX[nNumNode];
+	m_pImpl->pnEvalOrder	= new unsigned int[nNumNode];
+	BuildEvalOrder();
 	FlushCache();
 
 	return PVR_SUCCESS;
@@ -2105,6 +2109,7 @@ void CPVRTModelPOD::DestroyImpl()
 		if(m_pImpl->pfCache)		delete [] m_pImpl->pfCache;
 		if(m_pImpl->pWmCache)		delete [] m_pImpl->pWmCache;
 		if(m_pImpl->pWmZeroCache)	delete [] m_pImpl->pWmZeroCache;
+		if(m_pImpl->pnEvalOrder)	delete [] m_pImpl->pnEvalOrder;
 
 		delete m_pImpl;
 		m_pImpl = 0;
@@ -2118,10 +2123,17 @@ void CPVRTModelPOD::DestroyImpl()
 *************************************************************************/
 void CPVRTModelPOD::FlushCache()
 {
-	// Pre-calc frame zero matrices
+	// Pre-calc frame zero matrices, each from the already calculated matrix of its parent
 	SetFrame(0);
 	for(unsigned int i = 0; i < nNumNode; ++i)
-		GetWorldMatrixNoCache(m_pImpl->pWmZeroCache[i], pNode[i]);
+	{
+		unsigned int nIdx = m_pImpl->pnEvalOrder[i];
+		const SPODNode &node = pNode[nIdx];
+
+		GetLocalMatrix(m_pImpl->pWmZeroCache[nIdx], node);
+		if(node.nIdxParent >= 0)
+			PVRTMatrixMultiply(m_pImpl->pWmZeroCache[nIdx], m_pImpl->pWmZeroCache[nIdx], m_pImpl->pWmZeroCache[node.nIdxParent]);
+	}
 
 	// Load cache with frame-zero data
 	memcpy(m_pImpl->pWmCache, m_pImpl->pWmZeroCache, nNumNode * sizeof(*m_pImpl->pWmCache));
@@ -2137,6 +2149,65 @@ bool CPVRTModelPOD::IsLoaded()
 	return (m_pImpl!=NULL);
 }
 
+/*!***********************************************************************
+ @Function		BuildEvalOrder
+ @Description	Orders the nodes by increasing depth in the hierarchy,
+				so that each parent precedes its children.
+*************************************************************************/
+void CPVRTModelPOD::BuildEvalOrder()
+{
+	unsigned int i;
+
+	if(!nNumNode)
+		return;
+
+	// Find the depth of each node. A node whose parent is not yet known is revisited
+	// on a later pass; the number of passes is bounded to guard against bad parent links.
+	unsigned int *pnDepth = new unsigned int[nNumNode];
+	unsigned int nMaxDepth = 0;
+	for(i = 0; i < nNumNode; ++i)
+		pnDepth[i] = (pNode[i].nIdxParent < 0 || (unsigned int)pNode[i].nIdxParent >= nNumNode) ? 0 : (unsigned int)-1;
+
+	bool bChanged = true;
+	for(unsigned int nPass = 0; bChanged && nPass < nNumNode; ++nPass)
+	{
+		bChanged = false;
+		for(i = 0; i < nNumNode; ++i)
+		{
+			if(pnDepth[i] != (unsigned int)-1)
+				continue;
+
+			unsigned int nParentDepth = pnDepth[pNode[i].nIdxParent];
+			if(nParentDepth != (unsigned int)-1)
+			{
+				pnDepth[i] = nParentDepth + 1;
+				nMaxDepth = PVRT_MAX(nMaxDepth, pnDepth[i]);
+				bChanged = true;
+			}
+		}
+	}
+	for(i = 0; i < nNumNode; ++i)
+	{
+		_ASSERT(pnDepth[i] != (unsigned int)-1);	// Parent links form a cycle
+		if(pnDepth[i] == (unsigned int)-1)
+			pnDepth[i] = 0;
+	}
+
+	// Order the nodes by increasing depth
+	unsigned int nOut = 0;
+	for(unsigned int nDepth = 0; nDepth <= nMaxDepth; ++nDepth)
+	{
+		for(i = 0; i < nNumNode; ++i)
+		{
+			if(pnDepth[i] == nDepth)
+				m_pImpl->pnEvalOrder[nOut++] = i;
+		}
+	}
+	_ASSERT(nOut == nNumNode);
+
+	delete [] pnDepth;
+}
+
 /*!***************************************************************************
  @Function			Constructor
  @Description		Initializes the pointer to scene data to NULL
@@ -2525,13 +2596,13 @@ void CPVRTModelPOD::GetTransformationMatrix(PVRTMATRIX &mOut, const SPODNode &no
 	}
 }
 /*!***************************************************************************
- @Function			GetWorldMatrixNoCache
- @Output			mOut			World matrix
- @Input				node			Node to get the world matrix from
- @Description		Generates the world matrix for the given Mesh Instance;
-					applies the parent's transform too. Uses animation data.
+ @Function			GetLocalMatrix
+ @Output			mOut			Local matrix
+ @Input				node			Node to get the local matrix from
+ @Description		Generates the matrix for the given node, relative to its
+					parent. Uses animation data.
 *****************************************************************************/
-void CPVRTModelPOD::GetWorldMatrixNoCache(
+void CPVRTModelPOD::GetLocalMatrix(
 	PVRTMATRIX		&mOut,
 	const SPODNode	&node) const
 {
@@ -2552,6 +2623,22 @@ void CPVRTModelPOD::GetWorldMatrixNoCache(
 		GetTranslationMatrix(mTmp, node);
 		PVRTMatrixMultiply(mOut, mOut, mTmp);
 	}
+}
+
+/*!***************************************************************************
+ @Function			GetWorldMatrixNoCache
+ @Output			mOut			World matrix
+ @Input				node			Node to get the world matrix from
+ @Description		Generates the world matrix for the given Mesh Instance;
+					applies the parent's transform too. Uses animation data.
+*****************************************************************************/
+void CPVRTModelPOD::GetWorldMatrixNoCache(
+	PVRTMATRIX		&mOut,
+	const SPODNode	&node) const
+{
+	PVRTMATRIX mTmp;
+
+	GetLocalMatrix(mOut, node);
 
  	// Do we have to worry about a parent?
 	if(node.nIdxParent < 0)
@@ -2618,7 +2705,15 @@ void CPVRTModelPOD::GetWorldMatrix(
 		return;
 	}
 
-	GetWorldMatrixNoCache(mOut, node);
+	// Build on the cached world matrix of the parent, so that each
+	// ancestor is calculated at most once for this frame.
+	GetLocalMatrix(mOut, node);
+	if(node.nIdxParent >= 0)
+	{
+		PVRTMATRIX mParent;
+		GetWorldMatrix(mParent, pNode[node.nIdxParent]);
+		PVRTMatrixMultiply(mOut, mOut, mParent);
+	}
 
 	// Cache the matrix
 	m_pImpl->pfCache[nIdx]	= m_pImpl->fFrame;
@@ -3752,6 +3847,115 @@ void PVRTModelPODToggleStrips(SPODMesh &mesh)
 	FREE(old.pData);
 }
 
+/*!***************************************************************************
+ @Function			ReorderArray
+ @Modified			data		Per-vertex data to reorder
+ @Input				nNumVertex	Number of vertices
+ @Input				pui32Remap	New index of each vertex
+ @Return			PVR_FAIL if there was a problem.
+ @Description		Reorders a non-interleaved vertex array, if present.
+*****************************************************************************/
+static EPVRTError ReorderArray(
+	CPODData			&data,
+	const unsigned int	nNumVertex,
+	const unsigned int	* const pui32Remap)
+{
+	if(!data.nStride || !data.pData)
+		return PVR_SUCCESS;
+
+	return PVRTVertexReorder((char*)data.pData, nNumVertex, data.nStride, pui32Remap);
+}
+
+/*!***************************************************************************
+ @Function		PVRTModelPODOptimizeMesh
+ @Modified		mesh				Mesh to modify
+ @Output		psStats				If not NULL, receives the vertex cache statistics
+ @Input			bOptimizeOverdraw	Also reorder clusters of triangles to reduce overdraw
+ @Input			nCacheSize			Size of the FIFO post-transform vertex cache
+ @Return		PVR_FAIL if the mesh could not be optimized.
+ @Description	Reorders the triangles of the supplied mesh for post-transform
+				vertex cache reuse, optionally followed by overdraw-aware
+				ordering of clusters of triangles, and then reorders the
+				vertices into the order in which they are first used.
+				Triangles are only reordered within each bone batch.
+				Only indexed triangle lists can be optimized.
+*****************************************************************************/
+EPVRTError PVRTModelPODOptimizeMesh(
+	SPODMesh				&mesh,
+	SPODMeshOptimizeStats	* const psStats,
+	const bool				bOptimizeOverdraw,
+	const unsigned int		nCacheSize)
+{
+	unsigned int	*pui32Idx, *pui32Remap;
+	unsigned int	nIdxNum, nBatch, nBatchNum, nTriStart, nTriEnd, i;
+	EPVRTError		eErr = PVR_SUCCESS;
+
+	if(mesh.ePrimitiveType != ePODTriangles || mesh.nNumStrips || !mesh.sFaces.pData || !mesh.nNumFaces)
+		return PVR_FAIL;
+
+	nIdxNum		= mesh.nNumFaces * 3;
+	pui32Idx	= (unsigned int*)malloc(nIdxNum * sizeof(*pui32Idx));
+	pui32Remap	= (unsigned int*)malloc(mesh.nNumVertex * sizeof(*pui32Remap));
+	if(!pui32Idx || !pui32Remap)
+	{
+		FREE(pui32Idx);
+		FREE(pui32Remap);
+		return PVR_FAIL;
+	}
+
+	for(i = 0; i < nIdxNum; ++i)
+		PVRTVertexRead(&pui32Idx[i], mesh.sFaces.pData + i * mesh.sFaces.nStride, mesh.sFaces.eType);
+
+	if(psStats)
+		PVRTVertexCacheStatistics(&psStats->fACMRBefore, &psStats->fATVRBefore, pui32Idx, mesh.nNumFaces, mesh.nNumVertex, nCacheSize);
+
+	// Each bone batch is drawn separately, so its triangles must stay together
+	const PVRTuint8 * const pVtxBase = mesh.pInterleaved ? mesh.pInterleaved + (size_t) mesh.sVertex.pData : mesh.sVertex.pData;
+	nBatchNum = mesh.sBoneBatches.nBatchCnt ? mesh.sBoneBatches.nBatchCnt : 1;
+	for(nBatch = 0; nBatch < nBatchNum && eErr == PVR_SUCCESS; ++nBatch) {
+		nTriStart	= mesh.sBoneBatches.nBatchCnt ? mesh.sBoneBatches.pnBatchOffset[nBatch] : 0;
+		nTriEnd		= (nBatch + 1 < (unsigned int) mesh.sBoneBatches.nBatchCnt) ? mesh.sBoneBatches.pnBatchOffset[nBatch + 1] : mesh.nNumFaces;
+
+		eErr = PVRTVertexCacheOptimize(&pui32Idx[nTriStart * 3], nTriEnd - nTriStart, mesh.nNumVertex, nCacheSize);
+
+		if(eErr == PVR_SUCCESS && bOptimizeOverdraw && pVtxBase)
+			eErr = PVRTVertexOverdrawOptimize(&pui32Idx[nTriStart * 3], nTriEnd - nTriStart,
+				(const char*) pVtxBase, mesh.nNumVertex, mesh.sVertex.nStride, 0, mesh.sVertex.eType, nCacheSize);
+	}
+
+	if(eErr == PVR_SUCCESS)
+		eErr = PVRTVertexFetchOptimize(pui32Remap, pui32Idx, mesh.nNumFaces, mesh.nNumVertex);
+
+	if(eErr == PVR_SUCCESS) {
+		if(mesh.pInterleaved) {
+			eErr = PVRTVertexReorder((char*) mesh.pInterleaved, mesh.nNumVertex, mesh.sVertex.nStride, pui32Remap);
+		} else {
+			if(eErr == PVR_SUCCESS) eErr = ReorderArray(mesh.sVertex, mesh.nNumVertex, pui32Remap);
+			if(eErr == PVR_SUCCESS) eErr = ReorderArray(mesh.sNormals, mesh.nNumVertex, pui32Remap);
+			if(eErr == PVR_SUCCESS) eErr = ReorderArray(mesh.sTangents, mesh.nNumVertex, pui32Remap);
+			if(eErr == PVR_SUCCESS) eErr = ReorderArray(mesh.sBinormals, mesh.nNumVertex, pui32Remap);
+			if(eErr == PVR_SUCCESS) eErr = ReorderArray(mesh.sVtxColours, mesh.nNumVertex, pui32Remap);
+			if(eErr == PVR_SUCCESS) eErr = ReorderArray(mesh.sBoneIdx, mesh.nNumVertex, pui32Remap);
+			if(eErr == PVR_SUCCESS) eErr = ReorderArray(mesh.sBoneWeight, mesh.nNumVertex, pui32Remap);
+			for(i = 0; i < mesh.nNumUVW && eErr == PVR_SUCCESS; ++i)
+				eErr = ReorderArray(mesh.psUVW[i], mesh.nNumVertex, pui32Remap);
+		}
+	}
+
+	// Only write the indices back once the vertices are known to match them
+	if(eErr == PVR_SUCCESS) {
+		for(i = 0; i < nIdxNum; ++i)
+			PVRTVertexWrite(mesh.sFaces.pData + i * mesh.sFaces.nStride, mesh.sFaces.eType, pui32Idx[i]);
+
+		if(psStats)
+			PVRTVertexCacheStatistics(&psStats->fACMRAfter, &psStats->fATVRAfter, pui32Idx, mesh.nNumFaces, mesh.nNumVertex, nCacheSize);
+	}
+
+	FREE(pui32Idx);
+	FREE(pui32Remap);
+	return eErr;
+}
+
 /*!***************************************************************************
  @Function		PVRTModelPODCountIndices
  @Input			mesh		Mesh
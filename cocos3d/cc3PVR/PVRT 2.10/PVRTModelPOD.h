@@ -193,6 +193,18 @@ struct SPODMesh {
 	PVRTMATRIX			mUnpackMatrix;	/*!< A matrix used for unscaling scaled vertex data created with PVRTModelPODScaleAndConvertVtxData*/
 };
 
+/*!****************************************************************************
+ @Struct      SPODMeshOptimizeStats
+ @Brief       Post-transform vertex cache statistics of a mesh, before and after
+              it is optimized by PVRTModelPODOptimizeMesh
+******************************************************************************/
+struct SPODMeshOptimizeStats {
+	float				fACMRBefore;	/*!< Average cache miss ratio (vertices transformed per triangle) before optimization */
+	float				fATVRBefore;	/*!< Average transformed vertex ratio (vertices transformed per vertex) before optimization */
+	float				fACMRAfter;		/*!< Average cache miss ratio after optimization */
+	float				fATVRAfter;		/*!< Average transformed vertex ratio after optimization */
+};
+
 /*!****************************************************************************
  @Struct      SPODNode
  @Brief       Struct for storing POD node data
@@ -699,6 +711,23 @@ public:
 	EPVRTError SavePOD(const char * const pszFilename, const char * const pszExpOpt = 0, const char * const pszHistory = 0);
 
 private:
+	/*!***************************************************************************
+	 @Function		GetLocalMatrix
+	 @Output		mOut			Local matrix
+	 @Input			node			Node to get the local matrix from
+	 @Description	Generates the matrix for the given node, relative to its
+					parent. Uses animation data.
+	*****************************************************************************/
+	void GetLocalMatrix(
+		PVRTMATRIX		&mOut,
+		const SPODNode	&node) const;
+
+	/*!***********************************************************************
+	 @Function		BuildEvalOrder
+	 @Description	Orders the nodes so that each parent precedes its children.
+	*************************************************************************/
+	void BuildEvalOrder();
+
 	SPVRTPODImpl	*m_pImpl;	/*!< Internal implementation data */
 };
 
@@ -807,6 +836,26 @@ void PVRTModelPODDeIndex(SPODMesh &mesh);
 *****************************************************************************/
 void PVRTModelPODToggleStrips(SPODMesh &mesh);
 
+/*!***************************************************************************
+ @Function		PVRTModelPODOptimizeMesh
+ @Modified		mesh				Mesh to modify
+ @Output		psStats				If not NULL, receives the vertex cache statistics
+ @Input			bOptimizeOverdraw	Also reorder clusters of triangles to reduce overdraw
+ @Input			nCacheSize			Size of the FIFO post-transform vertex cache
+ @Return		PVR_FAIL if the mesh could not be optimized.
+ @Description	Reorders the triangles of the supplied mesh for post-transform
+				vertex cache reuse, optionally followed by overdraw-aware
+				ordering of clusters of triangles, and then reorders the
+				vertices into the order in which they are first used.
+				Triangles are only reordered within each bone batch.
+				Only indexed triangle lists can be optimized.
+*****************************************************************************/
+EPVRTError PVRTModelPODOptimizeMesh(
+	SPODMesh				&mesh,
+	SPODMeshOptimizeStats	* const psStats = NULL,
+	const bool				bOptimizeOverdraw = false,
+	const unsigned int		nCacheSize = PVRT_VCACHE_SIZE);
+
 /*!***************************************************************************
  @Function		PVRTModelPODCountIndices
  @Input			mesh		Mesh
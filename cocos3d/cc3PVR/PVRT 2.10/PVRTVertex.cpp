@@ -22,6 +22,7 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
 
 #include "PVRTFixedPoint.h"
 #include "PVRTMatrix.h"
@@ -30,6 +31,22 @@
 /****************************************************************************
 ** Defines
 ****************************************************************************/
+#if defined(__APPLE__) || defined(__linux__) || defined(__ANDROID__)
+#define PVRTVERTEX_THREADS
+#include <pthread.h>
+#endif
+
+#define PVRT_TANGENT_NONE				(0xFFFFFFFF)			// No group, or end of a group's corner list
+#define PVRT_TANGENT_NO_CELL			(~(PVRTuint64)0)		// Tangent frame that has not been quantized
+#define PVRT_TANGENT_CELL_BITS			(10)					// Bits per quantized tangent frame component
+#define PVRT_TANGENT_CELL_MASK			((1 << PVRT_TANGENT_CELL_BITS) - 1)
+#define PVRT_TANGENT_MIN_THREAD_TRIS	(1024)					// Minimum triangles per thread worth starting a thread for
+
+#define PVRT_VCACHE_NONE				(0xFFFFFFFF)			// No triangle, or vertex not yet in the cache
+#define PVRT_VCACHE_DECAY_POWER			(1.5f)
+#define PVRT_VCACHE_LAST_TRI_SCORE		(0.75f)
+#define PVRT_VCACHE_VALENCE_SCALE		(2.0f)
+#define PVRT_VCACHE_VALENCE_POWER		(0.5f)
 
 /****************************************************************************
 ** Macros
@@ -39,6 +56,41 @@
 /****************************************************************************
 ** Structures
 ****************************************************************************/
+/*!***************************************************************************
+ @Struct			SPVRTTangentWork
+ @Brief				A range of triangles whose corner tangent frames are to be
+					calculated, by PVRTVertexGenerateTangentSpace.
+*****************************************************************************/
+struct SPVRTTangentWork
+{
+	const char			*pVtx;			// Input vertices
+	const unsigned int	*pui32Idx;		// Triangle list indices
+	unsigned int		nStride;		// Size of a vertex (in bytes)
+	unsigned int		nOffsetPos;		// Offset in bytes to the vertex position
+	EPVRTDataType		eTypePos;		// Data type of the position
+	unsigned int		nOffsetNor;		// Offset in bytes to the vertex normal
+	EPVRTDataType		eTypeNor;		// Data type of the normal
+	unsigned int		nOffsetTex;		// Offset in bytes to the vertex texture coordinate
+	EPVRTDataType		eTypeTex;		// Data type of the texture coordinate
+	unsigned int		nTriStart;		// First triangle in the range
+	unsigned int		nTriEnd;		// One past the last triangle in the range
+	PVRTVECTOR3f		*pvTan;			// Output tangent, one per triangle corner
+	PVRTVECTOR3f		*pvBin;			// Output bitangent, one per triangle corner
+};
+
+/*!***************************************************************************
+ @Struct			SPVRTVertexCluster
+ @Brief				A run of triangles that is reordered as a unit by
+					PVRTVertexOverdrawOptimize.
+*****************************************************************************/
+struct SPVRTVertexCluster
+{
+	unsigned int		nTriStart;		// First triangle in the cluster
+	unsigned int		nTriNum;		// Number of triangles in the cluster
+	PVRTVECTOR3f		vNormal;		// Area-weighted normal of the cluster
+	PVRTVECTOR3f		vCentre;		// Centre of the cluster, relative to the centre of the mesh
+	float				fSortKey;		// How far the cluster faces out from the centre of the mesh
+};
 
 /****************************************************************************
 ** Constants
@@ -48,6 +100,21 @@
 ** Local function definitions
 ****************************************************************************/
 
+/*!***************************************************************************
+ @Function			PVRTVertexClusterCompare
+ @Description		qsort comparison placing the most outward-facing cluster
+					first, and otherwise retaining the original order.
+*****************************************************************************/
+static int PVRTVertexClusterCompare(const void *pA, const void *pB)
+{
+	const SPVRTVertexCluster * const psA = (const SPVRTVertexCluster*) pA;
+	const SPVRTVertexCluster * const psB = (const SPVRTVertexCluster*) pB;
+
+	if(psA->fSortKey > psB->fSortKey) return -1;
+	if(psA->fSortKey < psB->fSortKey) return 1;
+	return (psA->nTriStart < psB->nTriStart) ? -1 : (psA->nTriStart > psB->nTriStart) ? 1 : 0;
+}
+
 /*****************************************************************************
 ** Functions
 *****************************************************************************/
@@ -530,7 +597,7 @@ void PVRTVertexTangentBitangent(
 }
 
 /*!***************************************************************************
- @Function			PVRTVertexGenerateTangentSpace
+ @Function			PVRTVertexGenerateTangentSpaceLegacy
  @Output			pnVtxNumOut			Output vertex count
  @Output			pVtxOut				Output vertices (program must free() this)
  @Modified			pui32Idx			input AND output; index array for triangle list
@@ -559,8 +626,13 @@ void PVRTVertexTangentBitangent(
 					uses fSplitDifference - of the DP3 of two desired
 					tangents or two desired bitangents is higher than this,
 					the vertex will be split.
+
+					This is the original implementation, which fails if more
+					than 32 triangles share a vertex. It is retained so that
+					PVRTVertexGenerateTangentSpace can be validated and
+					benchmarked against it.
 *****************************************************************************/
-EPVRTError PVRTVertexGenerateTangentSpace(
+EPVRTError PVRTVertexGenerateTangentSpaceLegacy(
 	unsigned int	* const pnVtxNumOut,
 	char			** const pVtxOut,
 	unsigned int	* const pui32Idx,
@@ -792,6 +864,927 @@ EPVRTError PVRTVertexGenerateTangentSpace(
 	return PVR_SUCCESS;
 }
 
+/*!***************************************************************************
+ @Function			PVRTVertexTangentCornerFrames
+ @Modified			psWork				Triangle range to process, and output arrays
+ @Description		Calculates the tangent and bitangent desired by each corner
+					of each triangle in the work range. Each triangle writes
+					only its own three corners, so separate ranges may be
+					processed concurrently.
+*****************************************************************************/
+static void PVRTVertexTangentCornerFrames(const SPVRTTangentWork * const psWork)
+{
+	unsigned int	nCurr, nIdx0, nIdx1, nIdx2;
+	float			pfPos0[4], pfPos1[4], pfPos2[4];
+	float			pfTex0[4], pfTex1[4], pfTex2[4];
+	float			pfNor0[4], pfNor1[4], pfNor2[4];
+	const char		*pVtx = psWork->pVtx;
+	const unsigned int	nStride = psWork->nStride;
+
+	for(nCurr = psWork->nTriStart; nCurr < psWork->nTriEnd; ++nCurr) {
+		nIdx0 = psWork->pui32Idx[3*nCurr+0];
+		nIdx1 = psWork->pui32Idx[3*nCurr+1];
+		nIdx2 = psWork->pui32Idx[3*nCurr+2];
+
+		PVRTVertexRead((PVRTVECTOR4f*) &pfPos0[0], (char*)&pVtx[nIdx0 * nStride] + psWork->nOffsetPos, psWork->eTypePos, 3);
+		PVRTVertexRead((PVRTVECTOR4f*) &pfPos1[0], (char*)&pVtx[nIdx1 * nStride] + psWork->nOffsetPos, psWork->eTypePos, 3);
+		PVRTVertexRead((PVRTVECTOR4f*) &pfPos2[0], (char*)&pVtx[nIdx2 * nStride] + psWork->nOffsetPos, psWork->eTypePos, 3);
+
+		PVRTVertexRead((PVRTVECTOR4f*) &pfNor0[0], (char*)&pVtx[nIdx0 * nStride] + psWork->nOffsetNor, psWork->eTypeNor, 3);
+		PVRTVertexRead((PVRTVECTOR4f*) &pfNor1[0], (char*)&pVtx[nIdx1 * nStride] + psWork->nOffsetNor, psWork->eTypeNor, 3);
+		PVRTVertexRead((PVRTVECTOR4f*) &pfNor2[0], (char*)&pVtx[nIdx2 * nStride] + psWork->nOffsetNor, psWork->eTypeNor, 3);
+
+		PVRTVertexRead((PVRTVECTOR4f*) &pfTex0[0], (char*)&pVtx[nIdx0 * nStride] + psWork->nOffsetTex, psWork->eTypeTex, 3);
+		PVRTVertexRead((PVRTVECTOR4f*) &pfTex1[0], (char*)&pVtx[nIdx1 * nStride] + psWork->nOffsetTex, psWork->eTypeTex, 3);
+		PVRTVertexRead((PVRTVECTOR4f*) &pfTex2[0], (char*)&pVtx[nIdx2 * nStride] + psWork->nOffsetTex, psWork->eTypeTex, 3);
+
+		PVRTVertexTangentBitangent(
+			&psWork->pvTan[3*nCurr+0], &psWork->pvBin[3*nCurr+0],
+			(PVRTVECTOR3f*) &pfNor0[0],
+			pfPos0, pfPos1, pfPos2,
+			pfTex0, pfTex1, pfTex2);
+
+		PVRTVertexTangentBitangent(
+			&psWork->pvTan[3*nCurr+1], &psWork->pvBin[3*nCurr+1],
+			(PVRTVECTOR3f*) &pfNor1[0],
+			pfPos1, pfPos2, pfPos0,
+			pfTex1, pfTex2, pfTex0);
+
+		PVRTVertexTangentBitangent(
+			&psWork->pvTan[3*nCurr+2], &psWork->pvBin[3*nCurr+2],
+			(PVRTVECTOR3f*) &pfNor2[0],
+			pfPos2, pfPos0, pfPos1,
+			pfTex2, pfTex0, pfTex1);
+	}
+}
+
+#if defined(PVRTVERTEX_THREADS)
+/*!***************************************************************************
+ @Function			PVRTVertexTangentCornerFramesThread
+ @Input				pArg				The SPVRTTangentWork to process
+ @Return			NULL
+ @Description		pthread entry point for PVRTVertexTangentCornerFrames.
+*****************************************************************************/
+static void* PVRTVertexTangentCornerFramesThread(void *pArg)
+{
+	PVRTVertexTangentCornerFrames((const SPVRTTangentWork*) pArg);
+	return NULL;
+}
+#endif
+
+/*!***************************************************************************
+ @Function			PVRTVertexTangentCell
+ @Input				vTan				Tangent
+ @Input				vBin				Bitangent
+ @Input				fCellInv			Reciprocal of the width of a cell
+ @Return			The packed cell coordinates, or PVRT_TANGENT_NO_CELL
+ @Description		Quantizes a unit tangent frame onto a grid of cells, and
+					packs the six cell coordinates into a single key. Frames
+					that are not of unit length (eg. from triangles with
+					degenerate texture coordinates) are not given a cell.
+*****************************************************************************/
+static PVRTuint64 PVRTVertexTangentCell(
+	const PVRTVECTOR3f	&vTan,
+	const PVRTVECTOR3f	&vBin,
+	const float			fCellInv)
+{
+	const float	pfCmp[6] = { vTan.x, vTan.y, vTan.z, vBin.x, vBin.y, vBin.z };
+	PVRTuint64	nCell = 0;
+	int			i, nQ;
+
+	if(!(PVRTMatrixVec3DotProductF(vTan, vTan) >= 0.99f && PVRTMatrixVec3DotProductF(vBin, vBin) >= 0.99f))
+		return PVRT_TANGENT_NO_CELL;
+
+	for(i = 0; i < 6; ++i) {
+		nQ = (int) floorf((pfCmp[i] + 1.0f) * fCellInv);
+		nQ = PVRT_CLAMP(nQ, 0, PVRT_TANGENT_CELL_MASK);
+		nCell = (nCell << PVRT_TANGENT_CELL_BITS) | (PVRTuint64) nQ;
+	}
+	return nCell;
+}
+
+/*!***************************************************************************
+ @Function			PVRTVertexTangentHash
+ @Input				nCell				Packed cell key
+ @Input				nMask				Hash table size minus one
+ @Return			Hash table slot to start probing at
+*****************************************************************************/
+static unsigned int PVRTVertexTangentHash(const PVRTuint64 nCell, const unsigned int nMask)
+{
+	return (unsigned int)((nCell * 0x9E3779B97F4A7C15ULL) >> 32) & nMask;
+}
+
+/*!***************************************************************************
+ @Function			PVRTVertexGenerateTangentSpace
+ @Output			pnVtxNumOut			Output vertex count
+ @Output			pVtxOut				Output vertices (program must free() this)
+ @Modified			pui32Idx			input AND output; index array for triangle list
+ @Input				nVtxNum				Input vertex count
+ @Input				pVtx				Input vertices
+ @Input				nStride				Size of a vertex (in bytes)
+ @Input				nOffsetPos			Offset in bytes to the vertex position
+ @Input				eTypePos			Data type of the position
+ @Input				nOffsetNor			Offset in bytes to the vertex normal
+ @Input				eTypeNor			Data type of the normal
+ @Input				nOffsetTex			Offset in bytes to the vertex texture coordinate to use
+ @Input				eTypeTex			Data type of the texture coordinate
+ @Input				nOffsetTan			Offset in bytes to the vertex tangent
+ @Input				eTypeTan			Data type of the tangent
+ @Input				nOffsetBin			Offset in bytes to the vertex bitangent
+ @Input				eTypeBin			Data type of the bitangent
+ @Input				nTriNum				Number of triangles
+ @Input				fSplitDifference	Split a vertex if the DP3 of tangents/bitangents are below this (range -1..1)
+ @Input				nThreadNum			Number of threads to use when calculating the triangle tangent frames
+ @Return			PVR_FAIL if there was a problem.
+ @Description		Calculates the tangent space for all supplied vertices.
+					Writes tangent and bitangent vectors to the output
+					vertices, copies all other elements from input vertices.
+					Will split vertices if necessary - i.e. if two triangles
+					sharing a vertex want to assign it different
+					tangent-space matrices. The decision whether to split
+					uses fSplitDifference - of the DP3 of two desired
+					tangents or two desired bitangents is higher than this,
+					the vertex will be split.
+
+					The tangent frame desired by each triangle corner is held
+					in compact arrays, and the corners are bucketed by vertex
+					with a counting sort, so there is no limit on the number
+					of triangles that may share a vertex. When grouping the
+					corners of a vertex, each corner is first looked up by a
+					hash of its quantized tangent frame. The cells are sized
+					from fSplitDifference so that any two frames in the same
+					cell are guaranteed to pass the DP3 test, which lets a
+					corner join a matching group without comparing it against
+					each member. The grouping, output vertex order and output
+					indices are identical to PVRTVertexGenerateTangentSpaceLegacy.
+*****************************************************************************/
+EPVRTError PVRTVertexGenerateTangentSpace(
+	unsigned int	* const pnVtxNumOut,
+	char			** const pVtxOut,
+	unsigned int	* const pui32Idx,
+	const unsigned int	nVtxNum,
+	const char		* const pVtx,
+	const unsigned int	nStride,
+	const unsigned int	nOffsetPos,
+	EPVRTDataType	eTypePos,
+	const unsigned int	nOffsetNor,
+	EPVRTDataType	eTypeNor,
+	const unsigned int	nOffsetTex,
+	EPVRTDataType	eTypeTex,
+	const unsigned int	nOffsetTan,
+	EPVRTDataType	eTypeTan,
+	const unsigned int	nOffsetBin,
+	EPVRTDataType	eTypeBin,
+	const unsigned int	nTriNum,
+	const float		fSplitDifference,
+	const unsigned int	nThreadNum)
+{
+	const unsigned int	nCrnNum = nTriNum * 3;
+	unsigned int	*pnVtxCrnStart;	// Start of each vertex's run of corners in pnVtxCrn (nVtxNum + 1 entries)
+	unsigned int	*pnVtxCrn;		// Triangle corners (3*tri+n), bucketed by vertex, in triangle order
+	unsigned int	*pnCrnNext;		// Next corner in the same tangent-space group
+	PVRTVECTOR3f	*pvCrnTan;		// Tangent desired by each triangle corner
+	PVRTVECTOR3f	*pvCrnBin;		// Bitangent desired by each triangle corner
+	unsigned int	*pnGrpFirst, *pnGrpLast;	// First and last corner of each group of the current vertex
+	PVRTuint64		*pnGrpCell;		// Cell of the first corner of each group
+	PVRTuint8		*pbGrpPure;		// Whether all corners in each group lie in the same cell
+	unsigned int	*pnHash;		// Open-addressed hash of cell to group, for the current vertex
+	unsigned int	*pui32IdxNew;	// New index array, this will be copied over the input array
+	unsigned int	nVtxCap, nMaxShared, nHashSize, nHashMask, nGrpNum, nFastGrp;
+	unsigned int	nVert, nCurr, nCrn, nCmp, nGrp, nSlot, i;
+	PVRTuint64		nCell;
+	float			fCellWidth, fCellInv;
+	bool			bUseCells, bMatch;
+	float			pfTan[4], pfBin[4];
+	SPVRTTangentWork	sWork;
+
+	// Initialise the outputs
+	*pnVtxNumOut	= 0;
+	nVtxCap			= nVtxNum ? nVtxNum : 1;
+	*pVtxOut		= (char*)malloc(nVtxCap * nStride);
+	if(!*pVtxOut)
+	{
+		return PVR_FAIL;
+	}
+
+	// Bucket the triangle corners by vertex with a counting sort
+	pnVtxCrnStart	= (unsigned int*)calloc(nVtxNum + 1, sizeof(*pnVtxCrnStart));
+	pnVtxCrn		= (unsigned int*)malloc((nCrnNum ? nCrnNum : 1) * sizeof(*pnVtxCrn));
+	if(!pnVtxCrnStart || !pnVtxCrn)
+	{
+		FREE(pnVtxCrnStart);
+		FREE(pnVtxCrn);
+		FREE(*pVtxOut);
+		return PVR_FAIL;
+	}
+
+	for(nCurr = 0; nCurr < nTriNum; ++nCurr) {
+		const unsigned int nIdx0 = pui32Idx[3*nCurr+0];
+		const unsigned int nIdx1 = pui32Idx[3*nCurr+1];
+		const unsigned int nIdx2 = pui32Idx[3*nCurr+2];
+
+		_ASSERT(nIdx0 < nVtxNum);
+		_ASSERT(nIdx1 < nVtxNum);
+		_ASSERT(nIdx2 < nVtxNum);
+
+		if(nIdx0 >= nVtxNum || nIdx1 >= nVtxNum || nIdx2 >= nVtxNum) {
+			_RPT0(_CRT_WARN,"GenerateTangentSpace(): Index out of range.\n");
+			FREE(pnVtxCrnStart);
+			FREE(pnVtxCrn);
+			FREE(*pVtxOut);
+			return PVR_FAIL;
+		}
+
+		if(nIdx0 == nIdx1 || nIdx1 == nIdx2 || nIdx0 == nIdx2) {
+			_RPT0(_CRT_WARN,"GenerateTangentSpace(): Degenerate triangle found.\n");
+			FREE(pnVtxCrnStart);
+			FREE(pnVtxCrn);
+			FREE(*pVtxOut);
+			return PVR_FAIL;
+		}
+
+		++pnVtxCrnStart[nIdx0 + 1];
+		++pnVtxCrnStart[nIdx1 + 1];
+		++pnVtxCrnStart[nIdx2 + 1];
+	}
+
+	nMaxShared = 0;
+	for(nVert = 0; nVert < nVtxNum; ++nVert) {
+		nMaxShared = PVRT_MAX(nMaxShared, pnVtxCrnStart[nVert + 1]);
+		pnVtxCrnStart[nVert + 1] += pnVtxCrnStart[nVert];
+	}
+
+	// Use the starts as insertion cursors, which leaves each holding the start of the next run
+	for(nCrn = 0; nCrn < nCrnNum; ++nCrn)
+		pnVtxCrn[pnVtxCrnStart[pui32Idx[nCrn]]++] = nCrn;
+
+	for(nVert = nVtxNum; nVert > 0; --nVert)
+		pnVtxCrnStart[nVert] = pnVtxCrnStart[nVert - 1];
+	pnVtxCrnStart[0] = 0;
+
+	// Allocate the remaining work space, sized by the corner count and the most shared vertex
+	for(nHashSize = 1; nHashSize < 2 * nMaxShared; nHashSize <<= 1);
+
+	pui32IdxNew	= (unsigned int*)malloc((nCrnNum ? nCrnNum : 1) * sizeof(*pui32IdxNew));
+	pnCrnNext	= (unsigned int*)malloc((nCrnNum ? nCrnNum : 1) * sizeof(*pnCrnNext));
+	pvCrnTan	= (PVRTVECTOR3f*)malloc((nCrnNum ? nCrnNum : 1) * sizeof(*pvCrnTan));
+	pvCrnBin	= (PVRTVECTOR3f*)malloc((nCrnNum ? nCrnNum : 1) * sizeof(*pvCrnBin));
+	pnGrpFirst	= (unsigned int*)malloc((nMaxShared + 1) * sizeof(*pnGrpFirst));
+	pnGrpLast	= (unsigned int*)malloc((nMaxShared + 1) * sizeof(*pnGrpLast));
+	pnGrpCell	= (PVRTuint64*)malloc((nMaxShared + 1) * sizeof(*pnGrpCell));
+	pbGrpPure	= (PVRTuint8*)malloc((nMaxShared + 1) * sizeof(*pbGrpPure));
+	pnHash		= (unsigned int*)malloc(nHashSize * sizeof(*pnHash));
+	_ASSERT(pui32IdxNew && pnCrnNext && pvCrnTan && pvCrnBin);
+	_ASSERT(pnGrpFirst && pnGrpLast && pnGrpCell && pbGrpPure && pnHash);
+
+	if(!pui32IdxNew || !pnCrnNext || !pvCrnTan || !pvCrnBin ||
+		!pnGrpFirst || !pnGrpLast || !pnGrpCell || !pbGrpPure || !pnHash)
+	{
+		FREE(pnVtxCrnStart);	FREE(pnVtxCrn);		FREE(pui32IdxNew);
+		FREE(pnCrnNext);		FREE(pvCrnTan);		FREE(pvCrnBin);
+		FREE(pnGrpFirst);		FREE(pnGrpLast);	FREE(pnGrpCell);
+		FREE(pbGrpPure);		FREE(pnHash);		FREE(*pVtxOut);
+		return PVR_FAIL;
+	}
+
+	// Calculate the tangent frame desired by each triangle corner, optionally across several threads
+	sWork.pVtx			= pVtx;
+	sWork.pui32Idx		= pui32Idx;
+	sWork.nStride		= nStride;
+	sWork.nOffsetPos	= nOffsetPos;
+	sWork.eTypePos		= eTypePos;
+	sWork.nOffsetNor	= nOffsetNor;
+	sWork.eTypeNor		= eTypeNor;
+	sWork.nOffsetTex	= nOffsetTex;
+	sWork.eTypeTex		= eTypeTex;
+	sWork.pvTan			= pvCrnTan;
+	sWork.pvBin			= pvCrnBin;
+	sWork.nTriStart		= 0;
+	sWork.nTriEnd		= nTriNum;
+
+#if defined(PVRTVERTEX_THREADS)
+	if(nThreadNum > 1 && nTriNum >= nThreadNum * PVRT_TANGENT_MIN_THREAD_TRIS)
+	{
+		SPVRTTangentWork	*psWork		= (SPVRTTangentWork*)malloc(nThreadNum * sizeof(*psWork));
+		pthread_t			*pThread	= (pthread_t*)malloc(nThreadNum * sizeof(*pThread));
+		PVRTuint8			*pbStarted	= (PVRTuint8*)calloc(nThreadNum, sizeof(*pbStarted));
+
+		if(psWork && pThread && pbStarted)
+		{
+			for(i = 0; i < nThreadNum; ++i) {
+				psWork[i]			= sWork;
+				psWork[i].nTriStart	= (unsigned int)(((PVRTuint64) nTriNum * i) / nThreadNum);
+				psWork[i].nTriEnd	= (unsigned int)(((PVRTuint64) nTriNum * (i + 1)) / nThreadNum);
+			}
+
+			// The calling thread processes the first range itself
+			for(i = 1; i < nThreadNum; ++i)
+				pbStarted[i] = (pthread_create(&pThread[i], NULL, PVRTVertexTangentCornerFramesThread, &psWork[i]) == 0);
+
+			PVRTVertexTangentCornerFrames(&psWork[0]);
+
+			for(i = 1; i < nThreadNum; ++i) {
+				if(pbStarted[i])
+					pthread_join(pThread[i], NULL);
+				else
+					PVRTVertexTangentCornerFrames(&psWork[i]);
+			}
+			sWork.nTriEnd = 0;	// Done
+		}
+
+		FREE(psWork);
+		FREE(pThread);
+		FREE(pbStarted);
+	}
+#endif
+
+	if(sWork.nTriEnd > sWork.nTriStart)
+		PVRTVertexTangentCornerFrames(&sWork);
+
+	// Two unit frames in the same cell differ by at most fCellWidth * sqrt(3) in each of tangent and
+	// bitangent, so their DP3 is at least 1 - 1.5 * fCellWidth^2. Size the cells, with a safety margin,
+	// so that this always passes fSplitDifference. Very fine splits fall back to comparing every member.
+	fCellWidth	= 0.5f * sqrtf(PVRT_MAX(0.0f, 1.0f - fSplitDifference) / 1.5f);
+	bUseCells	= fCellWidth >= (2.0f / PVRT_TANGENT_CELL_MASK);
+	fCellInv	= bUseCells ? (1.0f / fCellWidth) : 0.0f;
+
+	// Now let's go through the vertices grouping the corners that can share a tangent-space
+	for(nVert = 0; nVert < nVtxNum; ++nVert) {
+		const unsigned int nRunStart	= pnVtxCrnStart[nVert];
+		const unsigned int nRunEnd		= pnVtxCrnStart[nVert + 1];
+
+		// Size and clear the hash table for the number of corners using this vertex
+		for(nHashSize = 1; nHashSize < 2 * (nRunEnd - nRunStart); nHashSize <<= 1);
+		nHashMask = nHashSize - 1;
+		memset(pnHash, 0xFF, nHashSize * sizeof(*pnHash));
+
+		nGrpNum = 0;
+		for(i = nRunStart; i < nRunEnd; ++i) {
+			nCrn	= pnVtxCrn[i];
+			nCell	= bUseCells ? PVRTVertexTangentCell(pvCrnTan[nCrn], pvCrnBin[nCrn], fCellInv) : PVRT_TANGENT_NO_CELL;
+
+			// Look up the group, if any, whose corners all lie in the same cell as this one
+			nFastGrp = PVRT_TANGENT_NONE;
+			nSlot = 0;
+			if(nCell != PVRT_TANGENT_NO_CELL) {
+				for(nSlot = PVRTVertexTangentHash(nCell, nHashMask);
+					pnHash[nSlot] != PVRT_TANGENT_NONE && pnGrpCell[pnHash[nSlot]] != nCell;
+					nSlot = (nSlot + 1) & nHashMask);
+
+				if(pnHash[nSlot] != PVRT_TANGENT_NONE && pbGrpPure[pnHash[nSlot]])
+					nFastGrp = pnHash[nSlot];
+			}
+
+			// Join the first group whose members all match, as the pairwise comparison would
+			for(nGrp = 0; nGrp < nGrpNum; ++nGrp) {
+				if(nGrp == nFastGrp)
+					break;
+
+				bMatch = true;
+				for(nCmp = pnGrpFirst[nGrp]; nCmp != PVRT_TANGENT_NONE; nCmp = pnCrnNext[nCmp]) {
+					if(PVRTMatrixVec3DotProductF(pvCrnTan[nCrn], pvCrnTan[nCmp]) < fSplitDifference ||
+						PVRTMatrixVec3DotProductF(pvCrnBin[nCrn], pvCrnBin[nCmp]) < fSplitDifference)
+					{
+						bMatch = false;
+						break;
+					}
+				}
+				if(bMatch)
+					break;
+			}
+
+			pnCrnNext[nCrn] = PVRT_TANGENT_NONE;
+			if(nGrp < nGrpNum) {
+				pnCrnNext[pnGrpLast[nGrp]] = nCrn;
+				pnGrpLast[nGrp] = nCrn;
+				if(nCell != pnGrpCell[nGrp])
+					pbGrpPure[nGrp] = 0;
+			} else {
+				// We never found another matching matrix, so let's add this as a different one
+				pnGrpFirst[nGrpNum]	= nCrn;
+				pnGrpLast[nGrpNum]	= nCrn;
+				pnGrpCell[nGrpNum]	= nCell;
+				pbGrpPure[nGrpNum]	= (nCell != PVRT_TANGENT_NO_CELL);
+
+				// Only one pure group per cell can exist, since any later corner in it would have joined it
+				if(nCell != PVRT_TANGENT_NO_CELL)
+					pnHash[nSlot] = nGrpNum;
+
+				++nGrpNum;
+			}
+		}
+
+		// OK, now we have 'nGrpNum' different desired matrices, so we need to add that many to output
+		_ASSERT(nGrpNum >= 1 || nRunEnd == nRunStart);
+		for(nGrp = 0; nGrp < nGrpNum; ++nGrp) {
+			memset(&pfTan, 0, sizeof(pfTan));
+			memset(&pfBin, 0, sizeof(pfBin));
+
+			for(nCmp = pnGrpFirst[nGrp]; nCmp != PVRT_TANGENT_NONE; nCmp = pnCrnNext[nCmp]) {
+				// Sum the tangent & bitangents, so we can average them
+				pfTan[0] += pvCrnTan[nCmp].x;
+				pfTan[1] += pvCrnTan[nCmp].y;
+				pfTan[2] += pvCrnTan[nCmp].z;
+
+				pfBin[0] += pvCrnBin[nCmp].x;
+				pfBin[1] += pvCrnBin[nCmp].y;
+				pfBin[2] += pvCrnBin[nCmp].z;
+
+				// Update the triangle corner to use this vtx
+				pui32IdxNew[nCmp] = *pnVtxNumOut;
+			}
+
+			PVRTMatrixVec3NormalizeF(*(PVRTVECTOR3f*) &pfTan[0], *(PVRTVECTOR3f*) &pfTan[0]);
+			PVRTMatrixVec3NormalizeF(*(PVRTVECTOR3f*) &pfBin[0], *(PVRTVECTOR3f*) &pfBin[0]);
+
+			if(*pnVtxNumOut >= nVtxCap) {
+				char *pVtxGrown = (char*)realloc(*pVtxOut, 2 * nVtxCap * nStride);
+				if(!pVtxGrown) {
+					_RPT0(_CRT_WARN,"PVRTVertexGenerateTangentSpace() ran out of memory for split vertices\n");
+					FREE(pnVtxCrnStart);	FREE(pnVtxCrn);		FREE(pui32IdxNew);
+					FREE(pnCrnNext);		FREE(pvCrnTan);		FREE(pvCrnBin);
+					FREE(pnGrpFirst);		FREE(pnGrpLast);	FREE(pnGrpCell);
+					FREE(pbGrpPure);		FREE(pnHash);		FREE(*pVtxOut);
+					*pnVtxNumOut = 0;
+					return PVR_FAIL;
+				}
+				*pVtxOut = pVtxGrown;
+				nVtxCap *= 2;
+			}
+
+			memcpy(&(*pVtxOut)[(*pnVtxNumOut) * nStride], &pVtx[nVert*nStride], nStride);
+			PVRTVertexWrite((char*)&(*pVtxOut)[(*pnVtxNumOut) * nStride] + nOffsetTan, eTypeTan, 3, (PVRTVECTOR4f*) &pfTan[0]);
+			PVRTVertexWrite((char*)&(*pVtxOut)[(*pnVtxNumOut) * nStride] + nOffsetBin, eTypeBin, 3, (PVRTVECTOR4f*) &pfBin[0]);
+
+			++*pnVtxNumOut;
+		}
+	}
+
+	FREE(pnVtxCrnStart);
+	FREE(pnVtxCrn);
+	FREE(pnCrnNext);
+	FREE(pvCrnTan);
+	FREE(pvCrnBin);
+	FREE(pnGrpFirst);
+	FREE(pnGrpLast);
+	FREE(pnGrpCell);
+	FREE(pbGrpPure);
+	FREE(pnHash);
+
+	if(*pnVtxNumOut) {
+		char *pVtxShrunk = (char*)realloc(*pVtxOut, *pnVtxNumOut * nStride);
+		if(pVtxShrunk)
+			*pVtxOut = pVtxShrunk;
+	}
+
+	memcpy(pui32Idx, pui32IdxNew, nCrnNum * sizeof(*pui32IdxNew));
+	FREE(pui32IdxNew);
+
+	_RPT3(_CRT_WARN, "GenerateTangentSpace(): %d tris, %d vtx in, %d vtx out\n", nTriNum, nVtxNum, *pnVtxNumOut);
+
+	return PVR_SUCCESS;
+}
+
+/*!***************************************************************************
+ @Function			PVRTVertexCacheScore
+ @Input				nCachePos			Position of the vertex in the simulated cache, or -1
+ @Input				nRemaining			Number of triangles still to be output that use the vertex
+ @Input				nCacheSize			Size of the simulated cache
+ @Return			The score of the vertex
+ @Description		Scores a vertex for PVRTVertexCacheOptimize, favouring
+					vertices that are recently used, and vertices that have
+					few remaining triangles, so that they are finished off.
+*****************************************************************************/
+static float PVRTVertexCacheScore(const int nCachePos, const unsigned int nRemaining, const unsigned int nCacheSize)
+{
+	float fScore = 0.0f;
+
+	if(nRemaining == 0)
+		return -1.0f;
+
+	if(nCachePos >= 0) {
+		if(nCachePos < 3) {
+			// The vertices of the last triangle are given a fixed score, so that the next triangle
+			// does not simply reuse its two most recent vertices, which would form a strip.
+			fScore = PVRT_VCACHE_LAST_TRI_SCORE;
+		} else {
+			fScore = powf(1.0f - (float)(nCachePos - 3) / (float)(nCacheSize - 3), PVRT_VCACHE_DECAY_POWER);
+		}
+	}
+
+	return fScore + PVRT_VCACHE_VALENCE_SCALE * powf((float) nRemaining, -PVRT_VCACHE_VALENCE_POWER);
+}
+
+/*!***************************************************************************
+ @Function			PVRTVertexCacheOptimize
+ @Modified			pui32Idx			Triangle list indices, reordered in place
+ @Input				nTriNum				Number of triangles
+ @Input				nVtxNum				Number of vertices referenced by the indices
+ @Input				nCacheSize			Size of the LRU vertex cache to simulate
+ @Return			PVR_FAIL if there was a problem.
+ @Description		Reorders the triangles of a triangle list to improve the
+					reuse of vertices in the post-transform vertex cache,
+					using Tom Forsyth's linear-speed greedy algorithm. The
+					winding of each triangle is preserved.
+*****************************************************************************/
+EPVRTError PVRTVertexCacheOptimize(
+	unsigned int		* const pui32Idx,
+	const unsigned int	nTriNum,
+	const unsigned int	nVtxNum,
+	const unsigned int	nCacheSize)
+{
+	unsigned int	*pnVtxTriStart;		// Start of each vertex's run of triangles in pnVtxTri
+	unsigned int	*pnVtxTri;			// Triangles using each vertex; the first pnVtxRemaining are not yet output
+	unsigned int	*pnVtxRemaining;	// Number of triangles using each vertex that are not yet output
+	int				*pnVtxCachePos;		// Position of each vertex in the simulated cache, or -1
+	float			*pfVtxScore;
+	float			*pfTriScore;
+	PVRTuint8		*pbTriAdded;
+	unsigned int	*pui32IdxNew;
+	unsigned int	*pnCache, *pnCacheNew;	// Simulated LRU cache, with room for the three vertices of the next triangle
+	unsigned int	nCacheLen, nCacheNewLen, nCursor, nBestTri, nOut, nVert, nTri, i, j, k;
+	float			fBestScore, fScore;
+
+	if(!nTriNum)
+		return PVR_SUCCESS;
+
+	// The vertices of the last triangle are scored separately, so the cache must hold more than those
+	if(nCacheSize <= 3) {
+		_RPT0(_CRT_WARN,"PVRTVertexCacheOptimize(): Cache size must be greater than 3.\n");
+		return PVR_FAIL;
+	}
+
+	pnVtxTriStart	= (unsigned int*)calloc(nVtxNum + 1, sizeof(*pnVtxTriStart));
+	pnVtxTri		= (unsigned int*)malloc(nTriNum * 3 * sizeof(*pnVtxTri));
+	pnVtxRemaining	= (unsigned int*)calloc(nVtxNum + 1, sizeof(*pnVtxRemaining));
+	pnVtxCachePos	= (int*)malloc((nVtxNum + 1) * sizeof(*pnVtxCachePos));
+	pfVtxScore		= (float*)malloc((nVtxNum + 1) * sizeof(*pfVtxScore));
+	pfTriScore		= (float*)malloc(nTriNum * sizeof(*pfTriScore));
+	pbTriAdded		= (PVRTuint8*)calloc(nTriNum, sizeof(*pbTriAdded));
+	pui32IdxNew		= (unsigned int*)malloc(nTriNum * 3 * sizeof(*pui32IdxNew));
+	pnCache			= (unsigned int*)malloc((nCacheSize + 3) * sizeof(*pnCache));
+	pnCacheNew		= (unsigned int*)malloc((nCacheSize + 3) * sizeof(*pnCacheNew));
+
+	if(!pnVtxTriStart || !pnVtxTri || !pnVtxRemaining || !pnVtxCachePos ||
+		!pfVtxScore || !pfTriScore || !pbTriAdded || !pui32IdxNew || !pnCache || !pnCacheNew)
+	{
+		FREE(pnVtxTriStart);	FREE(pnVtxTri);		FREE(pnVtxRemaining);	FREE(pnVtxCachePos);
+		FREE(pfVtxScore);		FREE(pfTriScore);	FREE(pbTriAdded);		FREE(pui32IdxNew);
+		FREE(pnCache);			FREE(pnCacheNew);
+		return PVR_FAIL;
+	}
+
+	// Bucket the triangles by vertex with a counting sort
+	for(i = 0; i < nTriNum * 3; ++i) {
+		if(pui32Idx[i] >= nVtxNum) {
+			_RPT0(_CRT_WARN,"PVRTVertexCacheOptimize(): Index out of range.\n");
+			FREE(pnVtxTriStart);	FREE(pnVtxTri);		FREE(pnVtxRemaining);	FREE(pnVtxCachePos);
+			FREE(pfVtxScore);		FREE(pfTriScore);	FREE(pbTriAdded);		FREE(pui32IdxNew);
+			FREE(pnCache);			FREE(pnCacheNew);
+			return PVR_FAIL;
+		}
+		++pnVtxRemaining[pui32Idx[i]];
+	}
+
+	for(nVert = 0; nVert < nVtxNum; ++nVert)
+		pnVtxTriStart[nVert + 1] = pnVtxTriStart[nVert] + pnVtxRemaining[nVert];
+
+	memset(pnVtxRemaining, 0, nVtxNum * sizeof(*pnVtxRemaining));
+	for(i = 0; i < nTriNum * 3; ++i) {
+		nVert = pui32Idx[i];
+		pnVtxTri[pnVtxTriStart[nVert] + pnVtxRemaining[nVert]++] = i / 3;
+	}
+
+	for(nVert = 0; nVert < nVtxNum; ++nVert) {
+		pnVtxCachePos[nVert]	= -1;
+		pfVtxScore[nVert]		= PVRTVertexCacheScore(-1, pnVtxRemaining[nVert], nCacheSize);
+	}
+
+	fBestScore	= -1.0f;
+	nBestTri	= 0;
+	for(nTri = 0; nTri < nTriNum; ++nTri) {
+		pfTriScore[nTri] = pfVtxScore[pui32Idx[3*nTri+0]] + pfVtxScore[pui32Idx[3*nTri+1]] + pfVtxScore[pui32Idx[3*nTri+2]];
+		if(pfTriScore[nTri] > fBestScore) {
+			fBestScore	= pfTriScore[nTri];
+			nBestTri	= nTri;
+		}
+	}
+
+	nCacheLen	= 0;
+	nCursor		= 0;
+	for(nOut = 0; nOut < nTriNum; ++nOut) {
+		if(nBestTri == PVRT_VCACHE_NONE) {
+			// None of the cached vertices has any triangles left, so start afresh from the next unused triangle
+			while(pbTriAdded[nCursor])
+				++nCursor;
+			nBestTri = nCursor;
+		}
+
+		// Output the triangle, and remove it from the triangle lists of its vertices
+		pbTriAdded[nBestTri] = 1;
+		for(k = 0; k < 3; ++k) {
+			nVert = pui32Idx[3*nBestTri+k];
+			pui32IdxNew[3*nOut+k] = nVert;
+
+			unsigned int * const pnTris = &pnVtxTri[pnVtxTriStart[nVert]];
+			for(j = 0; pnTris[j] != nBestTri; ++j);
+			pnTris[j] = pnTris[--pnVtxRemaining[nVert]];
+			pnTris[pnVtxRemaining[nVert]] = nBestTri;
+		}
+
+		// Move the vertices of the triangle to the front of the simulated LRU cache
+		nCacheNewLen = 0;
+		for(k = 0; k < 3; ++k)
+			pnCacheNew[nCacheNewLen++] = pui32Idx[3*nBestTri+k];
+
+		for(i = 0; i < nCacheLen; ++i) {
+			nVert = pnCache[i];
+			if(nVert != pnCacheNew[0] && nVert != pnCacheNew[1] && nVert != pnCacheNew[2])
+				pnCacheNew[nCacheNewLen++] = nVert;
+		}
+
+		// Rescore the cached vertices, including those just pushed out, and the triangles using them
+		fBestScore	= -1.0f;
+		nBestTri	= PVRT_VCACHE_NONE;
+		for(i = 0; i < nCacheNewLen; ++i) {
+			nVert = pnCacheNew[i];
+			pnVtxCachePos[nVert] = (i < nCacheSize) ? (int) i : -1;
+
+			fScore = PVRTVertexCacheScore(pnVtxCachePos[nVert], pnVtxRemaining[nVert], nCacheSize);
+			const float fDelta = fScore - pfVtxScore[nVert];
+			pfVtxScore[nVert] = fScore;
+
+			for(j = 0; j < pnVtxRemaining[nVert]; ++j) {
+				nTri = pnVtxTri[pnVtxTriStart[nVert] + j];
+				pfTriScore[nTri] += fDelta;
+				if(pfTriScore[nTri] > fBestScore) {
+					fBestScore	= pfTriScore[nTri];
+					nBestTri	= nTri;
+				}
+			}
+		}
+
+		nCacheLen = PVRT_MIN(nCacheNewLen, nCacheSize);
+		memcpy(pnCache, pnCacheNew, nCacheLen * sizeof(*pnCache));
+	}
+
+	memcpy(pui32Idx, pui32IdxNew, nTriNum * 3 * sizeof(*pui32Idx));
+
+	FREE(pnVtxTriStart);	FREE(pnVtxTri);		FREE(pnVtxRemaining);	FREE(pnVtxCachePos);
+	FREE(pfVtxScore);		FREE(pfTriScore);	FREE(pbTriAdded);		FREE(pui32IdxNew);
+	FREE(pnCache);			FREE(pnCacheNew);
+	return PVR_SUCCESS;
+}
+
+/*!***************************************************************************
+ @Function			PVRTVertexOverdrawOptimize
+ @Modified			pui32Idx			Triangle list indices, reordered in place
+ @Input				nTriNum				Number of triangles
+ @Input				pVtx				Input vertices
+ @Input				nVtxNum				Number of vertices
+ @Input				nStride				Size of a vertex (in bytes)
+ @Input				nOffsetPos			Offset in bytes to the vertex position
+ @Input				eTypePos			Data type of the position
+ @Input				nCacheSize			Size of the FIFO vertex cache to preserve
+ @Return			PVR_FAIL if there was a problem.
+ @Description		Reorders clusters of triangles so that those facing
+					outwards from the centre of the mesh are drawn first,
+					reducing overdraw when the mesh occludes itself. The
+					triangles are split into clusters wherever a triangle
+					misses the vertex cache for all three of its vertices,
+					so that the vertex cache order established by
+					PVRTVertexCacheOptimize is largely retained.
+*****************************************************************************/
+EPVRTError PVRTVertexOverdrawOptimize(
+	unsigned int		* const pui32Idx,
+	const unsigned int	nTriNum,
+	const char			* const pVtx,
+	const unsigned int	nVtxNum,
+	const unsigned int	nStride,
+	const unsigned int	nOffsetPos,
+	const EPVRTDataType	eTypePos,
+	const unsigned int	nCacheSize)
+{
+	SPVRTVertexCluster	*psCluster;
+	unsigned int		*pnVtxStamp;		// Cache miss count at which each vertex was loaded into the FIFO cache
+	unsigned int		*pui32IdxNew;
+	unsigned int		nClusterNum, nMisses, nTriMisses, nTri, nOut, i, k;
+	PVRTVECTOR3f		vMeshCentre, vEdge1, vEdge2, vNormal;
+	float				pfPos[3][4];
+	float				fLen;
+
+	if(!nTriNum)
+		return PVR_SUCCESS;
+
+	psCluster	= (SPVRTVertexCluster*)calloc(nTriNum, sizeof(*psCluster));
+	pnVtxStamp	= (unsigned int*)malloc(nVtxNum * sizeof(*pnVtxStamp));
+	pui32IdxNew	= (unsigned int*)malloc(nTriNum * 3 * sizeof(*pui32IdxNew));
+	if(!psCluster || !pnVtxStamp || !pui32IdxNew)
+	{
+		FREE(psCluster);	FREE(pnVtxStamp);	FREE(pui32IdxNew);
+		return PVR_FAIL;
+	}
+
+	for(i = 0; i < nVtxNum; ++i)
+		pnVtxStamp[i] = PVRT_VCACHE_NONE;
+
+	// Split into clusters, accumulating the area-weighted normal and centre of each
+	memset(&vMeshCentre, 0, sizeof(vMeshCentre));
+	nClusterNum	= 0;
+	nMisses		= 0;
+	for(nTri = 0; nTri < nTriNum; ++nTri) {
+		nTriMisses = 0;
+		for(k = 0; k < 3; ++k) {
+			const unsigned int nVert = pui32Idx[3*nTri+k];
+			if(nVert >= nVtxNum) {
+				_RPT0(_CRT_WARN,"PVRTVertexOverdrawOptimize(): Index out of range.\n");
+				FREE(psCluster);	FREE(pnVtxStamp);	FREE(pui32IdxNew);
+				return PVR_FAIL;
+			}
+			if(pnVtxStamp[nVert] == PVRT_VCACHE_NONE || nMisses - pnVtxStamp[nVert] >= nCacheSize) {
+				pnVtxStamp[nVert] = nMisses++;
+				++nTriMisses;
+			}
+			PVRTVertexRead((PVRTVECTOR4f*) &pfPos[k][0], (char*)&pVtx[nVert * nStride] + nOffsetPos, eTypePos, 3);
+		}
+
+		if(nTri == 0 || nTriMisses == 3) {
+			psCluster[nClusterNum].nTriStart = nTri;
+			++nClusterNum;
+		}
+
+		SPVRTVertexCluster * const psCurr = &psCluster[nClusterNum - 1];
+		++psCurr->nTriNum;
+
+		vEdge1.x = pfPos[1][0] - pfPos[0][0];	vEdge1.y = pfPos[1][1] - pfPos[0][1];	vEdge1.z = pfPos[1][2] - pfPos[0][2];
+		vEdge2.x = pfPos[2][0] - pfPos[0][0];	vEdge2.y = pfPos[2][1] - pfPos[0][1];	vEdge2.z = pfPos[2][2] - pfPos[0][2];
+		PVRTMatrixVec3CrossProductF(vNormal, vEdge1, vEdge2);
+		psCurr->vNormal.x += vNormal.x;
+		psCurr->vNormal.y += vNormal.y;
+		psCurr->vNormal.z += vNormal.z;
+
+		for(k = 0; k < 3; ++k) {
+			psCurr->vCentre.x += pfPos[k][0];
+			psCurr->vCentre.y += pfPos[k][1];
+			psCurr->vCentre.z += pfPos[k][2];
+			vMeshCentre.x += pfPos[k][0];
+			vMeshCentre.y += pfPos[k][1];
+			vMeshCentre.z += pfPos[k][2];
+		}
+	}
+
+	vMeshCentre.x /= (float)(nTriNum * 3);
+	vMeshCentre.y /= (float)(nTriNum * 3);
+	vMeshCentre.z /= (float)(nTriNum * 3);
+
+	// Sort the clusters so that those pointing furthest out from the centre of the mesh come first
+	for(i = 0; i < nClusterNum; ++i) {
+		SPVRTVertexCluster * const psCurr = &psCluster[i];
+		psCurr->vCentre.x = psCurr->vCentre.x / (float)(psCurr->nTriNum * 3) - vMeshCentre.x;
+		psCurr->vCentre.y = psCurr->vCentre.y / (float)(psCurr->nTriNum * 3) - vMeshCentre.y;
+		psCurr->vCentre.z = psCurr->vCentre.z / (float)(psCurr->nTriNum * 3) - vMeshCentre.z;
+
+		fLen = PVRTMatrixVec3LengthF(psCurr->vNormal);
+		psCurr->fSortKey = (fLen > 0.0f) ? PVRTMatrixVec3DotProductF(psCurr->vCentre, psCurr->vNormal) / fLen : 0.0f;
+	}
+	qsort(psCluster, nClusterNum, sizeof(*psCluster), PVRTVertexClusterCompare);
+
+	nOut = 0;
+	for(i = 0; i < nClusterNum; ++i) {
+		memcpy(&pui32IdxNew[nOut * 3], &pui32Idx[psCluster[i].nTriStart * 3], psCluster[i].nTriNum * 3 * sizeof(*pui32IdxNew));
+		nOut += psCluster[i].nTriNum;
+	}
+	_ASSERT(nOut == nTriNum);
+	memcpy(pui32Idx, pui32IdxNew, nTriNum * 3 * sizeof(*pui32Idx));
+
+	FREE(psCluster);	FREE(pnVtxStamp);	FREE(pui32IdxNew);
+	return PVR_SUCCESS;
+}
+
+/*!***************************************************************************
+ @Function			PVRTVertexFetchOptimize
+ @Output			pui32Remap			New index of each vertex (nVtxNum entries)
+ @Modified			pui32Idx			Triangle list indices, rewritten to the new vertex order
+ @Input				nTriNum				Number of triangles
+ @Input				nVtxNum				Number of vertices
+ @Return			PVR_FAIL if there was a problem.
+ @Description		Calculates a new vertex order in which vertices appear in
+					the order they are first used by the triangles, so that
+					vertex fetches move linearly through memory. Vertices
+					that are not used by any triangle are moved to the end,
+					in their original order. Use PVRTVertexReorder to apply
+					the new order to the vertex data.
+*****************************************************************************/
+EPVRTError PVRTVertexFetchOptimize(
+	unsigned int		* const pui32Remap,
+	unsigned int		* const pui32Idx,
+	const unsigned int	nTriNum,
+	const unsigned int	nVtxNum)
+{
+	unsigned int i, nNext = 0;
+
+	for(i = 0; i < nVtxNum; ++i)
+		pui32Remap[i] = PVRT_VCACHE_NONE;
+
+	for(i = 0; i < nTriNum * 3; ++i) {
+		if(pui32Idx[i] >= nVtxNum) {
+			_RPT0(_CRT_WARN,"PVRTVertexFetchOptimize(): Index out of range.\n");
+			return PVR_FAIL;
+		}
+		if(pui32Remap[pui32Idx[i]] == PVRT_VCACHE_NONE)
+			pui32Remap[pui32Idx[i]] = nNext++;
+		pui32Idx[i] = pui32Remap[pui32Idx[i]];
+	}
+
+	for(i = 0; i < nVtxNum; ++i) {
+		if(pui32Remap[i] == PVRT_VCACHE_NONE)
+			pui32Remap[i] = nNext++;
+	}
+	_ASSERT(nNext == nVtxNum);
+	return PVR_SUCCESS;
+}
+
+/*!***************************************************************************
+ @Function			PVRTVertexReorder
+ @Modified			pVtx				Vertices to reorder
+ @Input				nVtxNum				Number of vertices
+ @Input				nStride				Size of a vertex (in bytes)
+ @Input				pui32Remap			New index of each vertex, as from PVRTVertexFetchOptimize
+ @Return			PVR_FAIL if there was a problem.
+ @Description		Moves each vertex to its new position.
+*****************************************************************************/
+EPVRTError PVRTVertexReorder(
+	char				* const pVtx,
+	const unsigned int	nVtxNum,
+	const unsigned int	nStride,
+	const unsigned int	* const pui32Remap)
+{
+	char *pVtxNew = (char*)malloc(nVtxNum * nStride);
+	if(!pVtxNew)
+		return PVR_FAIL;
+
+	for(unsigned int i = 0; i < nVtxNum; ++i)
+		memcpy(&pVtxNew[pui32Remap[i] * nStride], &pVtx[i * nStride], nStride);
+
+	memcpy(pVtx, pVtxNew, nVtxNum * nStride);
+	FREE(pVtxNew);
+	return PVR_SUCCESS;
+}
+
+/*!***************************************************************************
+ @Function			PVRTVertexCacheStatistics
+ @Output			pfACMR				Average cache miss ratio; vertices transformed per triangle
+ @Output			pfATVR				Average transformed vertex ratio; vertices transformed per vertex used
+ @Input				pui32Idx			Triangle list indices
+ @Input				nTriNum				Number of triangles
+ @Input				nVtxNum				Number of vertices
+ @Input				nCacheSize			Size of the simulated FIFO vertex cache
+ @Description		Simulates a FIFO post-transform vertex cache to measure
+					how often the vertices of a triangle list will need to
+					be transformed. An ACMR of 0.5 and an ATVR of 1.0 are
+					ideal for a large regular grid.
+*****************************************************************************/
+void PVRTVertexCacheStatistics(
+	float				* const pfACMR,
+	float				* const pfATVR,
+	const unsigned int	* const pui32Idx,
+	const unsigned int	nTriNum,
+	const unsigned int	nVtxNum,
+	const unsigned int	nCacheSize)
+{
+	unsigned int	*pnVtxStamp;
+	unsigned int	nMisses = 0, nUsed = 0, i, nVert;
+
+	*pfACMR = 0.0f;
+	*pfATVR = 0.0f;
+
+	pnVtxStamp = (unsigned int*)malloc((nVtxNum ? nVtxNum : 1) * sizeof(*pnVtxStamp));
+	if(!pnVtxStamp || !nTriNum)
+	{
+		FREE(pnVtxStamp);
+		return;
+	}
+
+	for(i = 0; i < nVtxNum; ++i)
+		pnVtxStamp[i] = PVRT_VCACHE_NONE;
+
+	for(i = 0; i < nTriNum * 3; ++i) {
+		nVert = pui32Idx[i];
+		if(nVert >= nVtxNum)
+			continue;
+		if(pnVtxStamp[nVert] == PVRT_VCACHE_NONE) {
+			++nUsed;
+			pnVtxStamp[nVert] = nMisses++;
+		} else if(nMisses - pnVtxStamp[nVert] >= nCacheSize) {
+			pnVtxStamp[nVert] = nMisses++;
+		}
+	}
+
+	*pfACMR = (float) nMisses / (float) nTriNum;
+	*pfATVR = nUsed ? (float) nMisses / (float) nUsed : 0.0f;
+	FREE(pnVtxStamp);
+}
+
 /*****************************************************************************
  End of file (PVRTVertex.cpp)
 *****************************************************************************/
@@ -42,6 +42,11 @@ enum EPVRTDataType {
 	EPODDataUnsignedInt
 };
 
+/****************************************************************************
+** Defines
+****************************************************************************/
+#define PVRT_VCACHE_SIZE	(16)	// Default size of the FIFO post-transform vertex cache to optimize for
+
 /*****************************************************************************
 ** Functions
 *****************************************************************************/
@@ -145,6 +150,7 @@ void PVRTVertexTangentBitangent(
  @Input				eTypeBin			Data type of the bitangent
  @Input				nTriNum				Number of triangles
  @Input				fSplitDifference	Split a vertex if the DP3 of tangents/bitangents are below this (range -1..1)
+ @Input				nThreadNum			Number of threads to use when calculating the triangle tangent frames
  @Return			PVR_FAIL if there was a problem.
  @Description		Calculates the tangent space for all supplied vertices.
 					Writes tangent and bitangent vectors to the output
@@ -155,8 +161,78 @@ void PVRTVertexTangentBitangent(
 					uses fSplitDifference - of the DP3 of two desired
 					tangents or two desired bitangents is higher than this,
 					the vertex will be split.
+
+					There is no limit on the number of triangles that may
+					share a vertex. Working memory is proportional to the
+					number of triangles, rather than reserving space for the
+					maximum possible sharing at every vertex. The output is
+					identical to that of PVRTVertexGenerateTangentSpaceLegacy.
+
+					This is an offline preprocessing step. It is not invoked
+					when a POD file is loaded; POD meshes are expected to carry
+					any tangent and bitangent data they need. It is exercised
+					at runtime only by CC3PODTangentSpaceBenchmark.
 *****************************************************************************/
 EPVRTError PVRTVertexGenerateTangentSpace(
+	unsigned int	* const pnVtxNumOut,
+	char			** const pVtxOut,
+	unsigned int	* const pui32Idx,
+	const unsigned int	nVtxNum,
+	const char		* const pVtx,
+	const unsigned int	nStride,
+	const unsigned int	nOffsetPos,
+	EPVRTDataType	eTypePos,
+	const unsigned int	nOffsetNor,
+	EPVRTDataType	eTypeNor,
+	const unsigned int	nOffsetTex,
+	EPVRTDataType	eTypeTex,
+	const unsigned int	nOffsetTan,
+	EPVRTDataType	eTypeTan,
+	const unsigned int	nOffsetBin,
+	EPVRTDataType	eTypeBin,
+	const unsigned int	nTriNum,
+	const float		fSplitDifference,
+	const unsigned int	nThreadNum = 1);
+
+
+
+/*!***************************************************************************
+ @Function			PVRTVertexGenerateTangentSpaceLegacy
+ @Output			pnVtxNumOut			Output vertex count
+ @Output			pVtxOut				Output vertices (program must free() this)
+ @Modified			pui32Idx			input AND output; index array for triangle list
+ @Input				nVtxNum				Input vertex count
+ @Input				pVtx				Input vertices
+ @Input				nStride				Size of a vertex (in bytes)
+ @Input				nOffsetPos			Offset in bytes to the vertex position
+ @Input				eTypePos			Data type of the position
+ @Input				nOffsetNor			Offset in bytes to the vertex normal
+ @Input				eTypeNor			Data type of the normal
+ @Input				nOffsetTex			Offset in bytes to the vertex texture coordinate to use
+ @Input				eTypeTex			Data type of the texture coordinate
+ @Input				nOffsetTan			Offset in bytes to the vertex tangent
+ @Input				eTypeTan			Data type of the tangent
+ @Input				nOffsetBin			Offset in bytes to the vertex bitangent
+ @Input				eTypeBin			Data type of the bitangent
+ @Input				nTriNum				Number of triangles
+ @Input				fSplitDifference	Split a vertex if the DP3 of tangents/bitangents are below this (range -1..1)
+ @Return			PVR_FAIL if there was a problem.
+ @Description		Calculates the tangent space for all supplied vertices.
+					Writes tangent and bitangent vectors to the output
+					vertices, copies all other elements from input vertices.
+					Will split vertices if necessary - i.e. if two triangles
+					sharing a vertex want to assign it different
+					tangent-space matrices. The decision whether to split
+					uses fSplitDifference - of the DP3 of two desired
+					tangents or two desired bitangents is higher than this,
+					the vertex will be split.
+
+					This is the original implementation, which fails if more
+					than 32 triangles share a vertex. It is retained so that
+					PVRTVertexGenerateTangentSpace can be validated and
+					benchmarked against it.
+*****************************************************************************/
+EPVRTError PVRTVertexGenerateTangentSpaceLegacy(
 	unsigned int	* const pnVtxNumOut,
 	char			** const pVtxOut,
 	unsigned int	* const pui32Idx,
@@ -177,6 +253,104 @@ EPVRTError PVRTVertexGenerateTangentSpace(
 	const float		fSplitDifference);
 
 
+/*!***************************************************************************
+ @Function			PVRTVertexCacheOptimize
+ @Modified			pui32Idx			Triangle list indices, reordered in place
+ @Input				nTriNum				Number of triangles
+ @Input				nVtxNum				Number of vertices referenced by the indices
+ @Input				nCacheSize			Size of the LRU vertex cache to simulate; must be greater than 3
+ @Return			PVR_FAIL if there was a problem.
+ @Description		Reorders the triangles of a triangle list to improve the
+					reuse of vertices in the post-transform vertex cache,
+					using Tom Forsyth's linear-speed greedy algorithm. The
+					winding of each triangle is preserved.
+*****************************************************************************/
+EPVRTError PVRTVertexCacheOptimize(
+	unsigned int		* const pui32Idx,
+	const unsigned int	nTriNum,
+	const unsigned int	nVtxNum,
+	const unsigned int	nCacheSize = PVRT_VCACHE_SIZE);
+
+/*!***************************************************************************
+ @Function			PVRTVertexOverdrawOptimize
+ @Modified			pui32Idx			Triangle list indices, reordered in place
+ @Input				nTriNum				Number of triangles
+ @Input				pVtx				Input vertices
+ @Input				nVtxNum				Number of vertices
+ @Input				nStride				Size of a vertex (in bytes)
+ @Input				nOffsetPos			Offset in bytes to the vertex position
+ @Input				eTypePos			Data type of the position
+ @Input				nCacheSize			Size of the FIFO vertex cache to preserve
+ @Return			PVR_FAIL if there was a problem.
+ @Description		Reorders clusters of triangles so that those facing
+					outwards from the centre of the mesh are drawn first,
+					reducing overdraw when the mesh occludes itself. Should
+					be used after PVRTVertexCacheOptimize, whose vertex cache
+					order is largely retained.
+*****************************************************************************/
+EPVRTError PVRTVertexOverdrawOptimize(
+	unsigned int		* const pui32Idx,
+	const unsigned int	nTriNum,
+	const char			* const pVtx,
+	const unsigned int	nVtxNum,
+	const unsigned int	nStride,
+	const unsigned int	nOffsetPos,
+	const EPVRTDataType	eTypePos,
+	const unsigned int	nCacheSize = PVRT_VCACHE_SIZE);
+
+/*!***************************************************************************
+ @Function			PVRTVertexFetchOptimize
+ @Output			pui32Remap			New index of each vertex (nVtxNum entries)
+ @Modified			pui32Idx			Triangle list indices, rewritten to the new vertex order
+ @Input				nTriNum				Number of triangles
+ @Input				nVtxNum				Number of vertices
+ @Return			PVR_FAIL if there was a problem.
+ @Description		Calculates a new vertex order in which vertices appear in
+					the order they are first used by the triangles. Use
+					PVRTVertexReorder to apply the new order to the vertices.
+*****************************************************************************/
+EPVRTError PVRTVertexFetchOptimize(
+	unsigned int		* const pui32Remap,
+	unsigned int		* const pui32Idx,
+	const unsigned int	nTriNum,
+	const unsigned int	nVtxNum);
+
+/*!***************************************************************************
+ @Function			PVRTVertexReorder
+ @Modified			pVtx				Vertices to reorder
+ @Input				nVtxNum				Number of vertices
+ @Input				nStride				Size of a vertex (in bytes)
+ @Input				pui32Remap			New index of each vertex, as from PVRTVertexFetchOptimize
+ @Return			PVR_FAIL if there was a problem.
+ @Description		Moves each vertex to its new position.
+*****************************************************************************/
+EPVRTError PVRTVertexReorder(
+	char				* const pVtx,
+	const unsigned int	nVtxNum,
+	const unsigned int	nStride,
+	const unsigned int	* const pui32Remap);
+
+/*!***************************************************************************
+ @Function			PVRTVertexCacheStatistics
+ @Output			pfACMR				Average cache miss ratio; vertices transformed per triangle
+ @Output			pfATVR				Average transformed vertex ratio; vertices transformed per vertex used
+ @Input				pui32Idx			Triangle list indices
+ @Input				nTriNum				Number of triangles
+ @Input				nVtxNum				Number of vertices
+ @Input				nCacheSize			Size of the simulated FIFO vertex cache
+ @Description		Simulates a FIFO post-transform vertex cache to measure
+					how often the vertices of a triangle list will need to
+					be transformed.
+*****************************************************************************/
+void PVRTVertexCacheStatistics(
+	float				* const pfACMR,
+	float				* const pfATVR,
+	const unsigned int	* const pui32Idx,
+	const unsigned int	nTriNum,
+	const unsigned int	nVtxNum,
+	const unsigned int	nCacheSize = PVRT_VCACHE_SIZE);
+
+
 #endif /* _PVRTVERTEX_H_ */
 
 /*****************************************************************************
@@ -0,0 +1,146 @@
+/*
+ * CC3AnimationLODPolicy.h
+ *
+ * cocos3d 2.0.0
+ * Author: Bill Hollings
+ * Copyright (c) 2011-2013 The Brenwill Workshop Ltd. All rights reserved.
+ * http://www.brenwill.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * http://en.wikipedia.org/wiki/MIT_License
+ */
+
+/** @file */	// Doxygen marker
+
+
+#import "CC3Camera.h"
+
+
+#pragma mark -
+#pragma mark CC3AnimationLODPolicy
+
+/**
+ * CC3AnimationLODPolicy determines the level of detail at which the skeleton of an animated
+ * soft-body character is animated, based on the size of the character on the screen, as seen
+ * from the active camera.
+ *
+ * A single policy instance can be shared by many characters, by setting it into the
+ * animationLODPolicy property of each CC3SoftBodyNode. Each frame, as the scene is updated,
+ * each soft-body node measures its size on the screen, and uses the policy to determine:
+ *   - How often its animation is applied. Characters that appear large on the screen are
+ *     animated every frame. Smaller characters are animated only every few frames, and hold
+ *     their pose in between, avoiding both the animation and the retransform of their bones.
+ *   - Which bones are animated. For characters that appear very small on the screen, minor
+ *     bones deep in the skeleton, such as fingers and toes, are not animated.
+ *   - Whether the character is animated at all. Characters that lie outside the camera frustum
+ *     can be frozen entirely, and resume animating when they return into view.
+ *
+ * Sizes on the screen are expressed as the fraction of the height of the viewport covered
+ * by the diameter of the bounding sphere of the character.
+ */
+@interface CC3AnimationLODPolicy : NSObject {
+	GLfloat fullDetailScreenFraction;
+	GLfloat minimumDetailScreenFraction;
+	GLfloat reducedBonesScreenFraction;
+	GLuint maximumFrameInterval;
+	GLuint reducedBoneDepth;
+	BOOL shouldFreezeWhenNotVisible : 1;
+}
+
+/**
+ * Characters that cover at least this fraction of the height of the viewport are animated
+ * every frame.
+ *
+ * The initial value of this property is 0.25.
+ */
+@property(nonatomic, assign) GLfloat fullDetailScreenFraction;
+
+/**
+ * Characters that cover no more than this fraction of the height of the viewport are animated
+ * every maximumFrameInterval frames. Characters whose size lies between this value and the
+ * fullDetailScreenFraction are animated at an interval proportionally between the two.
+ *
+ * The initial value of this property is 0.05.
+ */
+@property(nonatomic, assign) GLfloat minimumDetailScreenFraction;
+
+/**
+ * The largest number of frames between successive applications of the animation of a character.
+ *
+ * The initial value of this property is 4.
+ */
+@property(nonatomic, assign) GLuint maximumFrameInterval;
+
+/**
+ * Characters that cover no more than this fraction of the height of the viewport animate only
+ * those bones that lie no more than reducedBoneDepth levels below the soft-body node.
+ *
+ * The initial value of this property is 0.05.
+ */
+@property(nonatomic, assign) GLfloat reducedBonesScreenFraction;
+
+/**
+ * The number of levels below the soft-body node, within which bones continue to be animated
+ * when a character covers no more than the reducedBonesScreenFraction of the viewport.
+ *
+ * The initial value of this property is 6.
+ */
+@property(nonatomic, assign) GLuint reducedBoneDepth;
+
+/**
+ * Indicates whether characters whose bounding sphere lies completely outside the frustum
+ * of the camera should not be animated at all until they return into view.
+ *
+ * The initial value of this property is YES.
+ */
+@property(nonatomic, assign) BOOL shouldFreezeWhenNotVisible;
+
+/**
+ * Returns the fraction of the height of the viewport of the specified camera that is covered
+ * by the diameter of the specified sphere, which is specified in the global coordinate system.
+ *
+ * Returns one if the camera is using parallel projection, or if the camera lies within the sphere.
+ */
+-(GLfloat) screenFractionOfSphere: (CC3Sphere) aGlobalSphere fromCamera: (CC3Camera*) aCamera;
+
+/**
+ * Returns whether a character with the specified bounding sphere, which is specified in the
+ * global coordinate system, should be frozen, because it is not visible to the specified camera.
+ */
+-(BOOL) shouldFreezeSphere: (CC3Sphere) aGlobalSphere forCamera: (CC3Camera*) aCamera;
+
+/**
+ * Returns the number of frames between successive applications of the animation of
+ * a character that covers the specified fraction of the height of the viewport.
+ */
+-(GLuint) frameIntervalForScreenFraction: (GLfloat) screenFraction;
+
+/**
+ * Returns the number of levels below the soft-body node within which bones should be animated,
+ * for a character that covers the specified fraction of the height of the viewport.
+ *
+ * Returns kCC3MaxGLuint if all bones should be animated.
+ */
+-(GLuint) nodeDepthLimitForScreenFraction: (GLfloat) screenFraction;
+
+/** Allocates and initializes an autoreleased instance with default property values. */
++(id) policy;
+
+@end
@@ -0,0 +1,91 @@
+/*
+ * CC3AnimationLODPolicy.m
+ *
+ * cocos3d 2.0.0
+ * Author: Bill Hollings
+ * Copyright (c) 2011-2013 The Brenwill Workshop Ltd. All rights reserved.
+ * http://www.brenwill.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * http://en.wikipedia.org/wiki/MIT_License
+ * 
+ * See header file CC3AnimationLODPolicy.h for full API documentation.
+ */
+
+#import "CC3AnimationLODPolicy.h"
+
+
+@implementation CC3AnimationLODPolicy
+
+@synthesize fullDetailScreenFraction, minimumDetailScreenFraction, maximumFrameInterval;
+@synthesize reducedBonesScreenFraction, reducedBoneDepth, shouldFreezeWhenNotVisible;
+
+-(id) init {
+	if ( (self = [super init]) ) {
+		fullDetailScreenFraction = 0.25f;
+		minimumDetailScreenFraction = 0.05f;
+		maximumFrameInterval = 4;
+		reducedBonesScreenFraction = 0.05f;
+		reducedBoneDepth = 6;
+		shouldFreezeWhenNotVisible = YES;
+	}
+	return self;
+}
+
++(id) policy { return [[[self alloc] init] autorelease]; }
+
+/**
+ * The half-height of the view at unit distance from the camera is the ratio of the top of the
+ * frustum to its near clipping distance, which accounts for both field of view and zoom.
+ */
+-(GLfloat) screenFractionOfSphere: (CC3Sphere) aGlobalSphere fromCamera: (CC3Camera*) aCamera {
+	if ( !aCamera || aCamera.isUsingParallelProjection ) return 1.0f;
+
+	CC3Frustum* frustum = aCamera.frustum;
+	GLfloat dist = CC3VectorDistance(aGlobalSphere.center, aCamera.globalLocation);
+	if (dist <= aGlobalSphere.radius || frustum.near <= 0.0f) return 1.0f;
+
+	GLfloat viewHalfHeight = dist * (frustum.top / frustum.near);
+	return MIN(aGlobalSphere.radius / viewHalfHeight, 1.0f);
+}
+
+-(BOOL) shouldFreezeSphere: (CC3Sphere) aGlobalSphere forCamera: (CC3Camera*) aCamera {
+	return shouldFreezeWhenNotVisible && aCamera && ![aCamera.frustum doesIntersectSphere: aGlobalSphere];
+}
+
+-(GLuint) frameIntervalForScreenFraction: (GLfloat) screenFraction {
+	if (screenFraction >= fullDetailScreenFraction || maximumFrameInterval <= 1) return 1;
+	if (screenFraction <= minimumDetailScreenFraction) return maximumFrameInterval;
+
+	GLfloat reduction = (fullDetailScreenFraction - screenFraction) /
+						(fullDetailScreenFraction - minimumDetailScreenFraction);
+	return 1 + (GLuint)((reduction * (maximumFrameInterval - 1)) + 0.5f);
+}
+
+-(GLuint) nodeDepthLimitForScreenFraction: (GLfloat) screenFraction {
+	return (screenFraction <= reducedBonesScreenFraction) ? reducedBoneDepth : kCC3MaxGLuint;
+}
+
+-(NSString*) description {
+	return [NSString stringWithFormat: @"%@ full detail above %.3f, every %u frames below %.3f",
+			[self class], fullDetailScreenFraction, maximumFrameInterval, minimumDetailScreenFraction];
+}
+
+@end
@@ -286,3 +286,409 @@
 
 @end
 
+
+#pragma mark -
+#pragma mark CC3CompressedNodeAnimation
+
+/**
+ * The compressed animation content of a single animated property, such as location,
+ * quaternion or scale, as held by a CC3CompressedNodeAnimation.
+ *
+ * The content is held as a sequence of keys, each containing the value of the property at
+ * a particular frame. The value at frames between two keys is linearly interpolated from
+ * the values of those keys. If the keyFrames array is NULL, there is one key per frame.
+ *
+ * A channel with no keys indicates that the property is not animated. A channel with
+ * one key indicates that the property has the same value at every frame.
+ */
+typedef struct {
+	GLuint keyCount;			/**< The number of keys in this channel. */
+	GLushort* keyFrames;		/**< The frame index of each key, or NULL if every frame is a key. */
+	GLvoid* keyValues;			/**< The value of each key. */
+	GLuint cursor;				/**< The index of the key most recently sampled. */
+} CC3CompressedAnimationChannel;
+
+/**
+ * CC3CompressedNodeAnimation is a CC3NodeAnimation that holds the animation content of another
+ * CC3NodeAnimation in a compact form, which can substantially reduce the memory consumed by
+ * the animation of models that contain many animated nodes, such as skinned characters.
+ *
+ * The content is compressed as follows, within the tolerance specified when the instance
+ * is created:
+ *   - A property that does not change throughout the animation is held as a single value.
+ *   - Frames whose values can be linearly interpolated from the values of neighbouring frames
+ *     are removed, leaving only the key frames needed to reproduce the animation.
+ *   - Rotation quaternions are held as four normalized 16-bit integers instead of four floats.
+ *
+ * When the animation is played forward, sampling a frame involves only the key most recently
+ * sampled, or the one after it, and so is comparable in speed to retrieving the frame content
+ * from an uncompressed animation.
+ */
+@interface CC3CompressedNodeAnimation : CC3NodeAnimation {
+	CC3CompressedAnimationChannel locationChannel;
+	CC3CompressedAnimationChannel rotationChannel;
+	CC3CompressedAnimationChannel quaternionChannel;
+	CC3CompressedAnimationChannel scaleChannel;
+}
+
+/**
+ * The number of bytes of animation content held by this instance, including the key
+ * values and key frame indices.
+ */
+@property(nonatomic, readonly) GLuint byteCount;
+
+/**
+ * The number of bytes that would be used to hold the animation content of this instance
+ * if one CC3Vector or CC3Quaternion was held for each frame of each animated property.
+ */
+@property(nonatomic, readonly) GLuint uncompressedByteCount;
+
+/**
+ * The number of keys held for the animated properties, summed across those properties.
+ * Properties that are not animated do not contribute to this count.
+ */
+@property(nonatomic, readonly) GLuint keyCount;
+
+/**
+ * Initializes this instance with the animation content of the specified animation,
+ * compressed using the specified tolerance.
+ *
+ * The tolerance is relative to the range of values of each animated property. A frame
+ * is removed if its location, rotation or scale can be interpolated from the remaining
+ * keys to within the specified fraction of the extent of that property across all frames.
+ * A frame is removed if each component of its quaternion can be interpolated from the
+ * remaining keys to within the specified tolerance.
+ *
+ * The specified animation is not retained by this instance, and may be discarded once this
+ * method has completed.
+ */
+-(id) initFromAnimation: (CC3NodeAnimation*) anAnimation withTolerance: (GLfloat) tolerance;
+
+/**
+ * Allocates and initializes an autoreleased instance with the animation content of the
+ * specified animation, compressed using the specified tolerance.
+ *
+ * See the notes for the initFromAnimation:withTolerance: method for more information
+ * about how the tolerance is applied.
+ */
++(id) animationFromAnimation: (CC3NodeAnimation*) anAnimation withTolerance: (GLfloat) tolerance;
+
+/**
+ * The default tolerance used to compress animation, when no other tolerance is specified.
+ *
+ * The initial value of this property is 0.001.
+ */
++(GLfloat) defaultTolerance;
+
+/** Sets the default tolerance used to compress animation, when no other tolerance is specified. */
++(void) setDefaultTolerance: (GLfloat) tolerance;
+
+@end
+
+
+
+#pragma mark -
+#pragma mark CC3NodeAnimationBatch
+
+/**
+ * CC3NodeAnimationBatch animates all of the animated nodes within a node assembly, such as
+ * the bones of a skeleton, in a single pass, instead of having each node sample its own
+ * CC3NodeAnimation individually.
+ *
+ * When an instance is created, the animation content of each animated node in the assembly
+ * is copied into a single contiguous block of memory, organized by frame, so that the content
+ * of all of the nodes at a particular frame lies together. Sampling the animation at a time
+ * between two frames then interpolates the content of all nodes in one tight loop across two
+ * adjacent blocks of that memory. The resulting location, quaternion and scale of each node is
+ * written directly to that node, and the transform of the root node of the assembly is marked
+ * as dirty once, instead of once for each property of each animated node.
+ *
+ * Rotation quaternions are interpolated using normalized linear interpolation between adjacent
+ * frames, instead of the spherical linear interpolation used by CC3NodeAnimation. Because adjacent
+ * frames are close together, the difference is not visible.
+ *
+ * To be included in the batch, the animation of a node must have the same number of frames and
+ * the same shouldInterpolate setting as the animation of the other nodes in the batch, and must
+ * not animate rotation using Euler angles. Any animated nodes that do not meet these criteria
+ * are animated individually by their own CC3NodeAnimation, whenever the batch is animated.
+ *
+ * The batch is built from the structure and animation content of the node assembly at the time
+ * the batch is created. If nodes are subsequently added to or removed from the assembly, or the
+ * animation of any node is changed, a new batch should be created. Nodes whose animation has
+ * been disabled are skipped when the batch is animated.
+ *
+ * The animation content held by the batch is uncompressed. If the nodes in the assembly use
+ * CC3CompressedNodeAnimation, the memory savings of that compression are not realized by the batch.
+ */
+@interface CC3NodeAnimationBatch : NSObject {
+	CC3Node* rootNode;
+	CCArray* nodes;
+	CCArray* unbatchedNodes;
+	GLfloat* frameContent;
+	GLfloat* currentContent;
+	GLubyte* channels;
+	GLuint* nodeDepths;
+	GLuint frameCount;
+	GLuint nodeDepthLimit;
+	BOOL shouldInterpolate : 1;
+}
+
+/**
+ * The root node of the node assembly animated by this batch.
+ *
+ * This node is not retained by this batch, since it typically holds this batch.
+ */
+@property(nonatomic, assign, readonly) CC3Node* rootNode;
+
+/** The nodes whose animation content is held and sampled by this batch. */
+@property(nonatomic, readonly) CCArray* nodes;
+
+/**
+ * The animated nodes within the node assembly whose animation content could not be included
+ * in this batch, and which are animated individually when this batch is animated.
+ */
+@property(nonatomic, readonly) CCArray* unbatchedNodes;
+
+/** The number of frames of animation held by this batch. */
+@property(nonatomic, readonly) GLuint frameCount;
+
+/**
+ * Indicates whether this batch interpolates between frames, for accuracy.
+ *
+ * The value of this property is taken from the animation of the nodes in this batch.
+ */
+@property(nonatomic, readonly) BOOL shouldInterpolate;
+
+/**
+ * Nodes that lie more than this number of levels below the rootNode are not animated by
+ * this batch. The rootNode lies at level zero, and its children lie at level one.
+ *
+ * Reducing this value allows the animation of minor bones, such as fingers and toes, to be
+ * skipped for distant characters. See CC3AnimationLODPolicy for more information.
+ *
+ * The initial value of this property is kCC3MaxGLuint, indicating that all nodes are animated.
+ */
+@property(nonatomic, assign) GLuint nodeDepthLimit;
+
+/**
+ * Initializes this instance to animate the animated nodes within the structural assembly
+ * of the specified node, including the specified node itself.
+ */
+-(id) initForNode: (CC3Node*) aNode;
+
+/**
+ * Allocates and initializes an autoreleased instance to animate the animated nodes within the
+ * structural assembly of the specified node, including the specified node itself.
+ */
++(id) batchForNode: (CC3Node*) aNode;
+
+/**
+ * Initializes this instance to animate the nodes within the structural assembly of the
+ * specified node, including the specified node itself, using the animation held by the
+ * nodes of the same names within the structural assembly of the specified animation source.
+ *
+ * This allows several animation clips, each loaded with its own copy of the same skeleton,
+ * to be applied to a single skeleton. Animation in the animation source that cannot be
+ * batched is ignored.
+ */
+-(id) initForNode: (CC3Node*) aNode withAnimationFrom: (CC3Node*) animSource;
+
+/**
+ * Allocates and initializes an autoreleased instance to animate the nodes within the
+ * structural assembly of the specified node, including the specified node itself, using
+ * the animation held by the nodes of the same names within the structural assembly of
+ * the specified animation source.
+ *
+ * See the notes of the initForNode:withAnimationFrom: method for more information.
+ */
++(id) batchForNode: (CC3Node*) aNode withAnimationFrom: (CC3Node*) animSource;
+
+/**
+ * Updates the location, quaternion, and scale of each node in this batch, based on the
+ * animation frame located at the specified time, which should be a value between zero and
+ * one, with zero indicating the first animation frame, and one indicating the last animation
+ * frame. Frames are selected and interpolated in the same manner as by CC3NodeAnimation.
+ *
+ * Each node in the unbatchedNodes collection is animated by its own animation, and the
+ * transform of the rootNode is marked as dirty.
+ */
+-(void) establishFrameAt: (ccTime) t;
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3NodeAnimationLayer
+
+@class CC3NodeAnimationBlender;
+
+/**
+ * CC3NodeAnimationLayer is a single weighted animation clip contributing to the pose of a
+ * node assembly, such as a skeleton, that is animated by a CC3NodeAnimationBlender.
+ *
+ * Instances are created by the addLayer and addLayerWithAnimationFrom: methods of the blender,
+ * and should not be created directly. Each layer holds its animation content in a
+ * CC3NodeAnimationBatch, and has its own weight and animation time, so that layers can be
+ * cross-faded, and can play at different points within their animation.
+ *
+ * Layers are applied in the order they were added to the blender. A layer that is not additive
+ * blends the pose established by the layers below it towards the pose of its own animation, by
+ * its weight. The first layer is blended from the rest pose captured by the blender. An additive
+ * layer adds the difference between the pose of its animation and the first frame of that
+ * animation, scaled by its weight, to the pose established by the layers below it.
+ *
+ * The influence of a layer can be restricted to part of the node assembly, such as the upper
+ * body of a character, by setting a mask weight for individual nodes.
+ */
+@interface CC3NodeAnimationLayer : NSObject {
+	CC3NodeAnimationBatch* animationBatch;
+	GLuint* nodeIndices;
+	GLfloat* maskWeights;
+	GLfloat weight;
+	ccTime animationTime;
+	BOOL isAdditive : 1;
+}
+
+/** The animation batch that holds the animation content of this layer. */
+@property(nonatomic, readonly) CC3NodeAnimationBatch* animationBatch;
+
+/**
+ * The weight of the contribution of this layer to the pose of the node assembly, typically
+ * between zero and one. Layers with a weight of zero are skipped.
+ *
+ * The initial value of this property is one.
+ */
+@property(nonatomic, assign) GLfloat weight;
+
+/**
+ * The time within the animation of this layer, as a value between zero and one, with zero
+ * indicating the first animation frame, and one indicating the last animation frame.
+ *
+ * The initial value of this property is zero.
+ */
+@property(nonatomic, assign) ccTime animationTime;
+
+/**
+ * Indicates whether this layer is added to the pose established by the layers below it,
+ * instead of blending that pose towards the pose of this layer.
+ *
+ * The initial value of this property is NO.
+ */
+@property(nonatomic, assign) BOOL isAdditive;
+
+/**
+ * Returns the mask weight of the specified node within this layer, or zero if the specified
+ * node is not animated by this layer.
+ */
+-(GLfloat) maskWeightForNode: (CC3Node*) aNode;
+
+/**
+ * Sets the mask weight of the specified node, and all of its descendants, within this layer.
+ * The contribution of this layer to each node is scaled by both the weight of this layer and
+ * the mask weight of that node. Nodes that are not animated by this layer are ignored.
+ *
+ * The initial mask weight of each node is one.
+ */
+-(void) setMaskWeight: (GLfloat) maskWeight forNode: (CC3Node*) aNode;
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3NodeAnimationBlender
+
+/**
+ * CC3NodeAnimationBlender animates a node assembly, such as a skeleton, by blending several
+ * weighted animation clips, each held in a CC3NodeAnimationLayer.
+ *
+ * The contributions of all layers are accumulated in a single pass per layer into a scratch
+ * buffer holding the location, quaternion and scale of each node. Only once all layers have
+ * been accumulated are the resulting values written to the nodes, and the transform of the
+ * root node of the assembly is marked as dirty once. The cost of blending therefore scales
+ * with the number of layers and nodes, rather than with the number of node property updates.
+ *
+ * The blender captures the rest pose of the node assembly when it is created. Nodes that are
+ * not animated by any layer are not updated. Nodes that are animated by at least one layer,
+ * but whose layers all have zero weight, are returned to the rest pose.
+ *
+ * If nodes are subsequently added to or removed from the assembly, a new blender should be created.
+ */
+@interface CC3NodeAnimationBlender : NSObject {
+	CC3Node* rootNode;
+	CCArray* nodes;
+	CCArray* layers;
+	GLfloat* restContent;
+	GLfloat* blendContent;
+	GLubyte* channels;
+	GLuint* nodeDepths;
+	GLuint nodeDepthLimit;
+}
+
+/**
+ * The root node of the node assembly animated by this blender.
+ *
+ * This node is not retained by this blender, since it typically holds this blender.
+ */
+@property(nonatomic, assign, readonly) CC3Node* rootNode;
+
+/** The nodes in the node assembly animated by this blender. */
+@property(nonatomic, readonly) CCArray* nodes;
+
+/** The CC3NodeAnimationLayers blended by this blender, in the order they are applied. */
+@property(nonatomic, readonly) CCArray* layers;
+
+/**
+ * Nodes that lie more than this number of levels below the rootNode are not updated by
+ * this blender. The rootNode lies at level zero, and its children lie at level one.
+ *
+ * The initial value of this property is kCC3MaxGLuint, indicating that all nodes are updated.
+ */
+@property(nonatomic, assign) GLuint nodeDepthLimit;
+
+/**
+ * Initializes this instance to animate the nodes within the structural assembly of the
+ * specified node, including the specified node itself, and captures the rest pose of
+ * those nodes. The new instance contains no layers.
+ */
+-(id) initForNode: (CC3Node*) aNode;
+
+/**
+ * Allocates and initializes an autoreleased instance to animate the nodes within the
+ * structural assembly of the specified node, including the specified node itself, and
+ * captures the rest pose of those nodes. The new instance contains no layers.
+ */
++(id) blenderForNode: (CC3Node*) aNode;
+
+/**
+ * Adds and returns a new layer, using the animation held by the nodes of the rootNode assembly.
+ *
+ * Animation of nodes that cannot be included in a CC3NodeAnimationBatch is ignored by the layer.
+ */
+-(CC3NodeAnimationLayer*) addLayer;
+
+/**
+ * Adds and returns a new layer, using the animation held by the nodes of the same names within
+ * the structural assembly of the specified animation source. Typically, the animation source
+ * is a copy of the same skeleton, loaded from a file holding a different animation clip.
+ */
+-(CC3NodeAnimationLayer*) addLayerWithAnimationFrom: (CC3Node*) animSource;
+
+/** Removes the specified layer from this blender. */
+-(void) removeLayer: (CC3NodeAnimationLayer*) aLayer;
+
+/** Captures the current location, quaternion and scale of each node as the rest pose. */
+-(void) captureRestPose;
+
+/**
+ * Blends the layers, each at its own animation time, and updates the location, quaternion
+ * and scale of each node animated by any layer.
+ */
+-(void) establishFrame;
+
+/**
+ * Sets the animation time of each layer to the specified time, which should be a value
+ * between zero and one, and then invokes the establishFrame method.
+ */
+-(void) establishFrameAt: (ccTime) t;
+
+@end
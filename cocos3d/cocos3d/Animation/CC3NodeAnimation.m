@@ -133,11 +133,18 @@
 // used outright.
 #define kCC3AnimationLerpEpsilon 0.1
 
--(void) establishFrameAt: (ccTime) t forNode: (CC3Node*) aNode {
-	LogTrace(@"%@ animating frame at %.3f ms", self, t);
-	NSAssert2(t >= 0.0 && t <= 1.0, @"%@ animation frame time %f must be between 0.0 and 1.0", self, t);
-	currentFrame = t;
-	
+/**
+ * Returns the index of the concrete animation frame at the specified time, which is a value
+ * between zero and one, for an animation with the specified number of frames, and returns
+ * the fractional interpolation towards the next frame in the pFrameInterpolation pointer.
+ *
+ * The interpolation fraction will be zero if shouldInterpolate is NO, if the frame is the
+ * last frame, or if the time is close enough to a concrete frame that interpolation is not
+ * worthwhile. Used by both CC3NodeAnimation and CC3NodeAnimationBatch, so that both select
+ * frames identically.
+ */
+static GLuint CC3AnimationFrameIndexAt(ccTime t, GLuint frameCount, BOOL shouldInterpolate,
+									   GLfloat* pFrameInterpolation) {
 	// Determine the virtual frame index, based on proportional time.
 	// This is a float to allow interpolating between frames.
 	GLfloat virtualFrameIndex = MIN(t * frameCount, frameCount - 1);
@@ -158,9 +165,20 @@
 			frameInterpolation = 0.0f;
 			frameIndex++;					// use next frame
 		}
-		LogTrace(@"%@ separating virtual frame %.3f into concrete frame %u plus interpolation fraction %.3f",
-				 self, virtualFrameIndex, frameIndex, frameInterpolation);
+		LogTrace(@"Separating virtual frame %.3f into concrete frame %u plus interpolation fraction %.3f",
+				 virtualFrameIndex, frameIndex, frameInterpolation);
 	}
+	*pFrameInterpolation = frameInterpolation;
+	return frameIndex;
+}
+
+-(void) establishFrameAt: (ccTime) t forNode: (CC3Node*) aNode {
+	LogTrace(@"%@ animating frame at %.3f ms", self, t);
+	NSAssert2(t >= 0.0 && t <= 1.0, @"%@ animation frame time %f must be between 0.0 and 1.0", self, t);
+	currentFrame = t;
+	
+	GLfloat frameInterpolation;
+	GLuint frameIndex = CC3AnimationFrameIndexAt(t, frameCount, shouldInterpolate, &frameInterpolation);
 	[self establishFrame: frameIndex plusInterpolation: frameInterpolation forNode: aNode];
 }
 
@@ -425,3 +443,893 @@
 
 @end
 
+
+#pragma mark -
+#pragma mark CC3CompressedNodeAnimation
+
+/** Quaternion components are held as normalized signed 16-bit integers. */
+#define kCC3QuaternionComponentScale	32767.0f
+
+/** Frame indices are held as 16-bit integers, so longer animations are not reduced. */
+#define kCC3CompressedAnimationMaxReducibleFrames	(0xFFFF + 1)
+
+/** Returns the largest absolute difference between the corresponding components of the specified vectors. */
+static inline GLfloat CC3Vector4MaxComponentDifference(CC3Vector4 v1, CC3Vector4 v2) {
+	return MAX(MAX(fabsf(v1.x - v2.x), fabsf(v1.y - v2.y)), MAX(fabsf(v1.z - v2.z), fabsf(v1.w - v2.w)));
+}
+
+/**
+ * Returns the value interpolated between the specified values. Quaternions are linearly
+ * interpolated and then normalized, which reproduces a slerp closely between nearby keys.
+ */
+static inline CC3Vector4 CC3CompressedAnimationInterpolate(CC3Vector4 v1, CC3Vector4 v2,
+														   GLfloat blendFactor, BOOL isQuaternion) {
+	CC3Vector4 v = CC3Vector4Add(v1, CC3Vector4ScaleUniform(CC3Vector4Difference(v2, v1), blendFactor));
+	return isQuaternion ? CC3QuaternionNormalize(v) : v;
+}
+
+/**
+ * Returns whether each value between the specified first and last frames can be
+ * interpolated from the values at those frames, to within the specified tolerance.
+ */
+static BOOL CC3CompressedAnimationSegmentFits(CC3Vector4* values, GLuint firstFrame, GLuint lastFrame,
+											  GLfloat tolerance, BOOL isQuaternion) {
+	GLfloat frameSpan = (GLfloat)(lastFrame - firstFrame);
+	for (GLuint f = firstFrame + 1; f < lastFrame; f++) {
+		CC3Vector4 v = CC3CompressedAnimationInterpolate(values[firstFrame], values[lastFrame],
+														 ((GLfloat)(f - firstFrame) / frameSpan), isQuaternion);
+		if (CC3Vector4MaxComponentDifference(v, values[f]) > tolerance) return NO;
+	}
+	return YES;
+}
+
+/**
+ * Populates the specified channel from the specified per-frame values, removing any frames
+ * whose values can be interpolated from the remaining keys to within the specified tolerance.
+ */
+static void CC3CompressedAnimationChannelPopulate(CC3CompressedAnimationChannel* pChan, CC3Vector4* values,
+												  GLuint frameCount, GLfloat tolerance, BOOL isQuaternion) {
+	GLushort* keyFrames = NULL;
+	GLuint keyCount = 0;
+
+	// Determine whether the value changes at all throughout the animation
+	BOOL isConstant = YES;
+	for (GLuint f = 1; f < frameCount && isConstant; f++)
+		isConstant = (CC3Vector4MaxComponentDifference(values[f], values[0]) <= tolerance);
+
+	if (isConstant) {
+		keyCount = 1;
+	} else if (frameCount > kCC3CompressedAnimationMaxReducibleFrames) {
+		keyCount = frameCount;
+	} else {
+		// Extend each segment for as long as the frames it spans can be interpolated
+		keyFrames = malloc(frameCount * sizeof(GLushort));
+		GLuint anchorFrame = 0;
+		keyFrames[keyCount++] = anchorFrame;
+		for (GLuint f = anchorFrame + 2; f < frameCount; f++) {
+			if ( !CC3CompressedAnimationSegmentFits(values, anchorFrame, f, tolerance, isQuaternion) ) {
+				anchorFrame = f - 1;
+				keyFrames[keyCount++] = anchorFrame;
+			}
+		}
+		keyFrames[keyCount++] = frameCount - 1;
+
+		// If no frames could be removed, the frame indices are not needed
+		if (keyCount == frameCount) {
+			free(keyFrames);
+			keyFrames = NULL;
+		} else {
+			keyFrames = realloc(keyFrames, keyCount * sizeof(GLushort));
+		}
+	}
+
+	pChan->keyCount = keyCount;
+	pChan->keyFrames = keyFrames;
+	pChan->cursor = 0;
+	if (isQuaternion) {
+		GLshort* keyValues = malloc(keyCount * 4 * sizeof(GLshort));
+		for (GLuint k = 0; k < keyCount; k++) {
+			CC3Vector4 q = values[keyFrames ? keyFrames[k] : k];
+			keyValues[(k * 4) + 0] = (GLshort)roundf(CLAMP(q.x, -1.0f, 1.0f) * kCC3QuaternionComponentScale);
+			keyValues[(k * 4) + 1] = (GLshort)roundf(CLAMP(q.y, -1.0f, 1.0f) * kCC3QuaternionComponentScale);
+			keyValues[(k * 4) + 2] = (GLshort)roundf(CLAMP(q.z, -1.0f, 1.0f) * kCC3QuaternionComponentScale);
+			keyValues[(k * 4) + 3] = (GLshort)roundf(CLAMP(q.w, -1.0f, 1.0f) * kCC3QuaternionComponentScale);
+		}
+		pChan->keyValues = keyValues;
+	} else {
+		CC3Vector* keyValues = malloc(keyCount * sizeof(CC3Vector));
+		for (GLuint k = 0; k < keyCount; k++)
+			keyValues[k] = CC3VectorFromTruncatedCC3Vector4(values[keyFrames ? keyFrames[k] : k]);
+		pChan->keyValues = keyValues;
+	}
+}
+
+/** Frees the content of the specified channel, leaving it with no keys. */
+static void CC3CompressedAnimationChannelDeallocate(CC3CompressedAnimationChannel* pChan) {
+	free(pChan->keyFrames);
+	free(pChan->keyValues);
+	pChan->keyFrames = NULL;
+	pChan->keyValues = NULL;
+	pChan->keyCount = 0;
+	pChan->cursor = 0;
+}
+
+/** Returns the number of bytes of content held by the specified channel. */
+static GLuint CC3CompressedAnimationChannelByteCount(CC3CompressedAnimationChannel* pChan, GLuint valueSize) {
+	return pChan->keyCount * (valueSize + (pChan->keyFrames ? sizeof(GLushort) : 0));
+}
+
+/**
+ * Returns the index of the key at or immediately before the specified frame, and the
+ * fraction of the distance from that key to the next key, at which the frame lies.
+ *
+ * When frames are sampled in sequence, the frame usually lies in the same segment as
+ * the previous sample, or the one after it, so those are checked before searching.
+ */
+static GLuint CC3CompressedAnimationChannelKeyAt(CC3CompressedAnimationChannel* pChan,
+												 GLuint frameIndex, GLfloat* pBlend) {
+	*pBlend = 0.0f;
+	if (pChan->keyCount == 1) return 0;
+	if ( !pChan->keyFrames ) return frameIndex;
+
+	GLushort* keyFrames = pChan->keyFrames;
+	GLuint lastKey = pChan->keyCount - 1;
+	if (frameIndex >= keyFrames[lastKey]) return lastKey;
+
+	GLuint k = pChan->cursor;
+	if ( !(keyFrames[k] <= frameIndex && frameIndex < keyFrames[k + 1]) ) {
+		k++;
+		if ( !(k < lastKey && keyFrames[k] <= frameIndex && frameIndex < keyFrames[k + 1]) ) {
+			GLuint lo = 0, hi = lastKey;		// keyFrames[lo] <= frameIndex < keyFrames[hi]
+			while (hi - lo > 1) {
+				GLuint mid = (lo + hi) >> 1;
+				if (keyFrames[mid] <= frameIndex) lo = mid;
+				else hi = mid;
+			}
+			k = lo;
+		}
+	}
+	pChan->cursor = k;
+	*pBlend = (GLfloat)(frameIndex - keyFrames[k]) / (GLfloat)(keyFrames[k + 1] - keyFrames[k]);
+	return k;
+}
+
+/** Returns the vector value of the specified channel at the specified frame. */
+static CC3Vector CC3CompressedAnimationChannelVectorAt(CC3CompressedAnimationChannel* pChan, GLuint frameIndex) {
+	GLfloat blend;
+	GLuint k = CC3CompressedAnimationChannelKeyAt(pChan, frameIndex, &blend);
+	CC3Vector* keyValues = pChan->keyValues;
+	return (blend > 0.0f) ? CC3VectorLerp(keyValues[k], keyValues[k + 1], blend) : keyValues[k];
+}
+
+/** Returns the quaternion held by the specified channel in the key at the specified index. */
+static inline CC3Quaternion CC3CompressedAnimationChannelQuaternionKey(CC3CompressedAnimationChannel* pChan, GLuint keyIndex) {
+	GLshort* pq = (GLshort*)pChan->keyValues + (keyIndex * 4);
+	return CC3QuaternionMake(pq[0] / kCC3QuaternionComponentScale, pq[1] / kCC3QuaternionComponentScale,
+							 pq[2] / kCC3QuaternionComponentScale, pq[3] / kCC3QuaternionComponentScale);
+}
+
+/** Returns the quaternion value of the specified channel at the specified frame. */
+static CC3Quaternion CC3CompressedAnimationChannelQuaternionAt(CC3CompressedAnimationChannel* pChan, GLuint frameIndex) {
+	GLfloat blend;
+	GLuint k = CC3CompressedAnimationChannelKeyAt(pChan, frameIndex, &blend);
+	CC3Quaternion q = CC3CompressedAnimationChannelQuaternionKey(pChan, k);
+	if (blend > 0.0f) {
+		q = CC3CompressedAnimationInterpolate(q, CC3CompressedAnimationChannelQuaternionKey(pChan, k + 1), blend, YES);
+	}
+	return q;
+}
+
+@interface CC3CompressedNodeAnimation (TemplateMethods)
+-(void) populateChannel: (CC3CompressedAnimationChannel*) pChan
+		 withVectorsFrom: (CC3NodeAnimation*) anAnimation
+			usingSelector: (SEL) frameSelector
+			withTolerance: (GLfloat) tolerance;
+-(void) populateQuaternionsFrom: (CC3NodeAnimation*) anAnimation withTolerance: (GLfloat) tolerance;
+@end
+
+@implementation CC3CompressedNodeAnimation
+
+-(void) dealloc {
+	CC3CompressedAnimationChannelDeallocate(&locationChannel);
+	CC3CompressedAnimationChannelDeallocate(&rotationChannel);
+	CC3CompressedAnimationChannelDeallocate(&quaternionChannel);
+	CC3CompressedAnimationChannelDeallocate(&scaleChannel);
+	[super dealloc];
+}
+
+-(BOOL) isAnimatingLocation { return locationChannel.keyCount > 0; }
+
+-(BOOL) isAnimatingRotation { return rotationChannel.keyCount > 0; }
+
+-(BOOL) isAnimatingQuaternion { return quaternionChannel.keyCount > 0; }
+
+-(BOOL) isAnimatingScale { return scaleChannel.keyCount > 0; }
+
+-(GLuint) byteCount {
+	return (CC3CompressedAnimationChannelByteCount(&locationChannel, sizeof(CC3Vector)) +
+			CC3CompressedAnimationChannelByteCount(&rotationChannel, sizeof(CC3Vector)) +
+			CC3CompressedAnimationChannelByteCount(&quaternionChannel, (4 * sizeof(GLshort))) +
+			CC3CompressedAnimationChannelByteCount(&scaleChannel, sizeof(CC3Vector)));
+}
+
+-(GLuint) uncompressedByteCount {
+	GLuint frameByteCount = 0;
+	if (self.isAnimatingLocation) frameByteCount += sizeof(CC3Vector);
+	if (self.isAnimatingRotation) frameByteCount += sizeof(CC3Vector);
+	if (self.isAnimatingQuaternion) frameByteCount += sizeof(CC3Quaternion);
+	if (self.isAnimatingScale) frameByteCount += sizeof(CC3Vector);
+	return frameCount * frameByteCount;
+}
+
+-(GLuint) keyCount {
+	return locationChannel.keyCount + rotationChannel.keyCount + quaternionChannel.keyCount + scaleChannel.keyCount;
+}
+
+
+#pragma mark Allocation and initialization
+
+-(id) initWithFrameCount: (GLuint) numFrames {
+	if ( (self = [super initWithFrameCount: numFrames]) ) {
+		memset(&locationChannel, 0, sizeof(CC3CompressedAnimationChannel));
+		memset(&rotationChannel, 0, sizeof(CC3CompressedAnimationChannel));
+		memset(&quaternionChannel, 0, sizeof(CC3CompressedAnimationChannel));
+		memset(&scaleChannel, 0, sizeof(CC3CompressedAnimationChannel));
+	}
+	return self;
+}
+
+/**
+ * Populates the specified channel with the vectors returned by the specified frame accessor of
+ * the specified animation. The tolerance is scaled by the extent of the vectors across all frames.
+ */
+-(void) populateChannel: (CC3CompressedAnimationChannel*) pChan
+		 withVectorsFrom: (CC3NodeAnimation*) anAnimation
+			usingSelector: (SEL) frameSelector
+			withTolerance: (GLfloat) tolerance {
+	CC3Vector (*frameAccessor)(id, SEL, GLuint) = (CC3Vector(*)(id, SEL, GLuint))[anAnimation methodForSelector: frameSelector];
+	CC3Vector4* values = malloc(frameCount * sizeof(CC3Vector4));
+	CC3BoundingBox extent = kCC3BoundingBoxNull;
+	for (GLuint f = 0; f < frameCount; f++) {
+		CC3Vector v = frameAccessor(anAnimation, frameSelector, f);
+		values[f] = CC3Vector4FromCC3Vector(v, 0.0f);
+		extent = CC3BoundingBoxEngulfLocation(extent, v);
+	}
+	CC3Vector extentSize = CC3VectorDifference(extent.maximum, extent.minimum);
+	GLfloat extentSpan = MAX(MAX(extentSize.x, extentSize.y), extentSize.z);
+	CC3CompressedAnimationChannelPopulate(pChan, values, frameCount, (tolerance * extentSpan), NO);
+	free(values);
+}
+
+/**
+ * Populates the quaternion channel with the quaternions of the specified animation. Each
+ * quaternion is negated if needed, to keep it in the same hemisphere as the previous frame,
+ * so that interpolating between keys follows the shortest path.
+ */
+-(void) populateQuaternionsFrom: (CC3NodeAnimation*) anAnimation withTolerance: (GLfloat) tolerance {
+	CC3Vector4* values = malloc(frameCount * sizeof(CC3Vector4));
+	for (GLuint f = 0; f < frameCount; f++) {
+		CC3Quaternion q = CC3QuaternionNormalize([anAnimation quaternionAtFrame: f]);
+		if (f > 0 && CC3Vector4Dot(q, values[f - 1]) < 0.0f) q = CC3QuaternionNegate(q);
+		values[f] = q;
+	}
+	CC3CompressedAnimationChannelPopulate(&quaternionChannel, values, frameCount, tolerance, YES);
+	free(values);
+}
+
+-(id) initFromAnimation: (CC3NodeAnimation*) anAnimation withTolerance: (GLfloat) tolerance {
+	if ( (self = [self initWithFrameCount: anAnimation.frameCount]) ) {
+		shouldInterpolate = anAnimation.shouldInterpolate;
+		if (frameCount) {
+			if (anAnimation.isAnimatingLocation)
+				[self populateChannel: &locationChannel withVectorsFrom: anAnimation
+						usingSelector: @selector(locationAtFrame:) withTolerance: tolerance];
+			if (anAnimation.isAnimatingRotation)
+				[self populateChannel: &rotationChannel withVectorsFrom: anAnimation
+						usingSelector: @selector(rotationAtFrame:) withTolerance: tolerance];
+			if (anAnimation.isAnimatingQuaternion)
+				[self populateQuaternionsFrom: anAnimation withTolerance: tolerance];
+			if (anAnimation.isAnimatingScale)
+				[self populateChannel: &scaleChannel withVectorsFrom: anAnimation
+						usingSelector: @selector(scaleAtFrame:) withTolerance: tolerance];
+		}
+		LogTrace(@"%@ compressed %u bytes of animation into %u bytes in %u keys",
+				 self, self.uncompressedByteCount, self.byteCount, self.keyCount);
+	}
+	return self;
+}
+
++(id) animationFromAnimation: (CC3NodeAnimation*) anAnimation withTolerance: (GLfloat) tolerance {
+	return [[[self alloc] initFromAnimation: anAnimation withTolerance: tolerance] autorelease];
+}
+
+static GLfloat defaultTolerance = 0.001f;
+
++(GLfloat) defaultTolerance { return defaultTolerance; }
+
++(void) setDefaultTolerance: (GLfloat) tolerance { defaultTolerance = tolerance; }
+
+
+#pragma mark Accessing frame data
+
+-(CC3Vector) locationAtFrame: (GLuint) frameIndex {
+	frameIndex = MIN(frameIndex, frameCount - 1);
+	return CC3CompressedAnimationChannelVectorAt(&locationChannel, frameIndex);
+}
+
+-(CC3Vector) rotationAtFrame: (GLuint) frameIndex {
+	frameIndex = MIN(frameIndex, frameCount - 1);
+	return CC3CompressedAnimationChannelVectorAt(&rotationChannel, frameIndex);
+}
+
+-(CC3Quaternion) quaternionAtFrame: (GLuint) frameIndex {
+	frameIndex = MIN(frameIndex, frameCount - 1);
+	return CC3CompressedAnimationChannelQuaternionAt(&quaternionChannel, frameIndex);
+}
+
+-(CC3Vector) scaleAtFrame: (GLuint) frameIndex {
+	frameIndex = MIN(frameIndex, frameCount - 1);
+	return CC3CompressedAnimationChannelVectorAt(&scaleChannel, frameIndex);
+}
+
+-(NSString*) description {
+	return [NSString stringWithFormat: @"%@ with %u frames in %u keys", [self class], frameCount, self.keyCount];
+}
+
+@end
+
+
+
+#pragma mark -
+#pragma mark CC3NodeAnimationBatch
+
+/**
+ * The animation content of each node at each frame is held as twelve floats: the location
+ * and a padding float, the quaternion, and the scale and a padding float. The padding keeps
+ * each property aligned on a 16-byte boundary, for efficient vectorized interpolation.
+ */
+#define kCC3AnimationBatchNodeStride		12
+#define kCC3AnimationBatchLocationOffset	0
+#define kCC3AnimationBatchQuaternionOffset	4
+#define kCC3AnimationBatchScaleOffset		8
+
+/** Bit flags indicating which properties of a batched node are animated. */
+#define kCC3AnimationBatchChannelLocation	0x01
+#define kCC3AnimationBatchChannelQuaternion	0x02
+#define kCC3AnimationBatchChannelScale		0x04
+
+/**
+ * Linearly interpolates the specified number of floats from the two specified frames, into
+ * the specified destination. The arrays do not overlap, and the loop contains no branches,
+ * allowing the compiler to vectorize the loop.
+ */
+static void CC3AnimationBatchLerp(GLfloat* restrict dst, const GLfloat* restrict frame1,
+								  const GLfloat* restrict frame2, GLfloat blendFactor, GLuint floatCount) {
+	for (GLuint i = 0; i < floatCount; i++) dst[i] = frame1[i] + ((frame2[i] - frame1[i]) * blendFactor);
+}
+
+/** Returns the number of levels that the specified node lies below the specified ancestor node. */
+static GLuint CC3NodeAnimationDepthBelow(CC3Node* aNode, CC3Node* ancestor) {
+	GLuint depth = 0;
+	for (CC3Node* n = aNode; n && n != ancestor; n = n.parent) depth++;
+	return depth;
+}
+
+@interface CC3NodeAnimationBatch (TemplateMethods)
+-(void) addAnimatedNodesFrom: (CC3Node*) aNode withAnimationFrom: (CC3Node*) animSource into: (CCArray*) anims;
+-(BOOL) canBatchAnimation: (CC3NodeAnimation*) anim;
+-(void) populateFrameContentFrom: (CCArray*) anims;
+-(GLfloat*) sampleFrameAt: (ccTime) t;
+-(GLfloat*) frameContentAt: (GLuint) frameIndex;
+-(GLubyte*) channels;
+@end
+
+@implementation CC3NodeAnimationBatch
+
+@synthesize rootNode, nodes, unbatchedNodes, frameCount, shouldInterpolate, nodeDepthLimit;
+
+-(void) dealloc {
+	rootNode = nil;			// Weak reference
+	[nodes release];
+	[unbatchedNodes release];
+	free(frameContent);
+	free(currentContent);
+	free(channels);
+	free(nodeDepths);
+	[super dealloc];
+}
+
+
+#pragma mark Allocation and initialization
+
+-(id) init {
+	NSAssert1(NO, @"%@ cannot be initialized without a node", self);
+	return nil;
+}
+
+-(id) initForNode: (CC3Node*) aNode { return [self initForNode: aNode withAnimationFrom: aNode]; }
+
+-(id) initForNode: (CC3Node*) aNode withAnimationFrom: (CC3Node*) animSource {
+	if ( (self = [super init]) ) {
+		rootNode = aNode;			// Weak reference
+		nodes = [[CCArray array] retain];
+		unbatchedNodes = [[CCArray array] retain];
+		frameContent = NULL;
+		currentContent = NULL;
+		channels = NULL;
+		nodeDepths = NULL;
+		frameCount = 0;
+		nodeDepthLimit = kCC3MaxGLuint;
+		shouldInterpolate = YES;
+		CCArray* anims = [CCArray array];
+		[self addAnimatedNodesFrom: aNode withAnimationFrom: animSource into: anims];
+		[self populateFrameContentFrom: anims];
+	}
+	return self;
+}
+
++(id) batchForNode: (CC3Node*) aNode { return [[[self alloc] initForNode: aNode] autorelease]; }
+
++(id) batchForNode: (CC3Node*) aNode withAnimationFrom: (CC3Node*) animSource {
+	return [[[self alloc] initForNode: aNode withAnimationFrom: animSource] autorelease];
+}
+
+/**
+ * Adds the specified node, if it is animated, and its animated descendants, to either the
+ * batched or unbatched nodes. The animation of each node is taken from the node of the same
+ * name within the specified animation source, and batched animations are added to the
+ * specified array. Nodes whose animation is currently disabled are included, since their
+ * animation may be enabled later.
+ */
+-(void) addAnimatedNodesFrom: (CC3Node*) aNode withAnimationFrom: (CC3Node*) animSource into: (CCArray*) anims {
+	CC3Node* srcNode = aNode;
+	if (animSource != rootNode)
+		srcNode = [aNode.name isEqual: animSource.name] ? animSource : [animSource getNodeNamed: aNode.name];
+	CC3NodeAnimation* anim = srcNode.animation;
+	if (anim) {
+		if ( [self canBatchAnimation: anim] ) {
+			[nodes addObject: aNode];
+			[anims addObject: anim];
+		} else if (srcNode == aNode) {
+			[unbatchedNodes addObject: aNode];
+		} else {
+			LogInfo(@"%@ cannot batch animation %@ from %@ for %@", self, anim, srcNode, aNode);
+		}
+	}
+	for (CC3Node* child in aNode.children) [self addAnimatedNodesFrom: child withAnimationFrom: animSource into: anims];
+}
+
+/**
+ * Returns whether the specified animation can be included in this batch. The first
+ * batchable animation establishes the frame count and interpolation of this batch.
+ */
+-(BOOL) canBatchAnimation: (CC3NodeAnimation*) anim {
+	if (anim.frameCount == 0 || anim.isAnimatingRotation) return NO;
+	if (nodes.count == 0) {
+		frameCount = anim.frameCount;
+		shouldInterpolate = anim.shouldInterpolate;
+		return YES;
+	}
+	return (anim.frameCount == frameCount) && (anim.shouldInterpolate == shouldInterpolate);
+}
+
+/**
+ * Copies the animation content of each batched node into the frame content. Quaternions
+ * are aligned to the same hemisphere as the quaternion in the previous frame, so that
+ * interpolating between adjacent frames takes the shortest path.
+ */
+-(void) populateFrameContentFrom: (CCArray*) anims {
+	GLuint nodeCount = nodes.count;
+	if (nodeCount == 0) return;
+	
+	GLuint rowLength = nodeCount * kCC3AnimationBatchNodeStride;
+	frameContent = calloc(frameCount * rowLength, sizeof(GLfloat));
+	currentContent = calloc(rowLength, sizeof(GLfloat));
+	channels = calloc(nodeCount, sizeof(GLubyte));
+	nodeDepths = calloc(nodeCount, sizeof(GLuint));
+	
+	for (GLuint nodeIdx = 0; nodeIdx < nodeCount; nodeIdx++) {
+		nodeDepths[nodeIdx] = CC3NodeAnimationDepthBelow([nodes objectAtIndex: nodeIdx], rootNode);
+		CC3NodeAnimation* anim = [anims objectAtIndex: nodeIdx];
+		GLubyte nodeChannels = 0;
+		if (anim.isAnimatingLocation) nodeChannels |= kCC3AnimationBatchChannelLocation;
+		if (anim.isAnimatingQuaternion) nodeChannels |= kCC3AnimationBatchChannelQuaternion;
+		if (anim.isAnimatingScale) nodeChannels |= kCC3AnimationBatchChannelScale;
+		channels[nodeIdx] = nodeChannels;
+
+		CC3Quaternion prevQuat = kCC3QuaternionIdentity;
+		for (GLuint frameIdx = 0; frameIdx < frameCount; frameIdx++) {
+			GLfloat* pNode = frameContent + (frameIdx * rowLength) + (nodeIdx * kCC3AnimationBatchNodeStride);
+			if (nodeChannels & kCC3AnimationBatchChannelLocation)
+				*(CC3Vector*)(pNode + kCC3AnimationBatchLocationOffset) = [anim locationAtFrame: frameIdx];
+			if (nodeChannels & kCC3AnimationBatchChannelQuaternion) {
+				CC3Quaternion quat = [anim quaternionAtFrame: frameIdx];
+				if (frameIdx > 0 && CC3Vector4Dot(quat, prevQuat) < 0.0f) quat = CC3QuaternionNegate(quat);
+				*(CC3Quaternion*)(pNode + kCC3AnimationBatchQuaternionOffset) = quat;
+				prevQuat = quat;
+			}
+			if (nodeChannels & kCC3AnimationBatchChannelScale)
+				*(CC3Vector*)(pNode + kCC3AnimationBatchScaleOffset) = [anim scaleAtFrame: frameIdx];
+		}
+	}
+	LogTrace(@"%@ populated %u frames of animation content for %u nodes", self, frameCount, nodeCount);
+}
+
+
+#pragma mark Animating
+
+-(GLubyte*) channels { return channels; }
+
+/** Returns the content of all batched nodes at the specified frame. */
+-(GLfloat*) frameContentAt: (GLuint) frameIndex {
+	return frameContent + (frameIndex * nodes.count * kCC3AnimationBatchNodeStride);
+}
+
+/**
+ * Returns the content of all batched nodes at the specified animation time. This is either
+ * the content of a single frame, or the content interpolated between two adjacent frames,
+ * in which case the returned content is only valid until this method is next invoked.
+ */
+-(GLfloat*) sampleFrameAt: (ccTime) t {
+	GLuint nodeCount = nodes.count;
+	GLfloat frameInterpolation;
+	GLuint frameIndex = CC3AnimationFrameIndexAt(t, frameCount, shouldInterpolate, &frameInterpolation);
+	GLfloat* pContent = [self frameContentAt: frameIndex];
+	
+	// Interpolate all nodes in one pass. Interpolation is never required at the last frame.
+	if (frameInterpolation != 0.0f) {
+		GLuint rowLength = nodeCount * kCC3AnimationBatchNodeStride;
+		CC3AnimationBatchLerp(currentContent, pContent, pContent + rowLength, frameInterpolation, rowLength);
+		pContent = currentContent;
+		
+		// Interpolated quaternions must be renormalized
+		for (GLuint nodeIdx = 0; nodeIdx < nodeCount; nodeIdx++) {
+			if (channels[nodeIdx] & kCC3AnimationBatchChannelQuaternion) {
+				CC3Quaternion* pQuat = (CC3Quaternion*)(pContent + (nodeIdx * kCC3AnimationBatchNodeStride) +
+														kCC3AnimationBatchQuaternionOffset);
+				*pQuat = CC3QuaternionNormalize(*pQuat);
+			}
+		}
+	}
+	return pContent;
+}
+
+-(void) establishFrameAt: (ccTime) t {
+	LogTrace(@"%@ animating frame at %.3f ms", self, t);
+	NSAssert2(t >= 0.0 && t <= 1.0, @"%@ animation frame time %f must be between 0.0 and 1.0", self, t);
+
+	GLuint nodeCount = nodes.count;
+	if (nodeCount) {
+		GLfloat* pContent = [self sampleFrameAt: t];
+		for (GLuint nodeIdx = 0; nodeIdx < nodeCount; nodeIdx++) {
+			if (nodeDepths[nodeIdx] > nodeDepthLimit) continue;
+
+			CC3Node* aNode = (CC3Node*)[nodes objectAtIndex: nodeIdx];
+			if ( !aNode.isAnimationEnabled ) continue;
+			
+			GLubyte nodeChannels = channels[nodeIdx];
+			GLfloat* pNode = pContent + (nodeIdx * kCC3AnimationBatchNodeStride);
+			[aNode setAnimatedLocation: ((nodeChannels & kCC3AnimationBatchChannelLocation)
+										 ? (CC3Vector*)(pNode + kCC3AnimationBatchLocationOffset) : NULL)
+							quaternion: ((nodeChannels & kCC3AnimationBatchChannelQuaternion)
+										 ? (CC3Quaternion*)(pNode + kCC3AnimationBatchQuaternionOffset) : NULL)
+								 scale: ((nodeChannels & kCC3AnimationBatchChannelScale)
+										 ? (CC3Vector*)(pNode + kCC3AnimationBatchScaleOffset) : NULL)];
+		}
+	}
+
+	for (CC3Node* aNode in unbatchedNodes)
+		if (aNode.isAnimationEnabled && CC3NodeAnimationDepthBelow(aNode, rootNode) <= nodeDepthLimit)
+			[aNode.animation establishFrameAt: t forNode: aNode];
+
+	[rootNode markTransformDirty];
+}
+
+-(NSString*) description {
+	return [NSString stringWithFormat: @"%@ with %u frames for %u batched and %u unbatched nodes",
+			[self class], frameCount, nodes.count, unbatchedNodes.count];
+}
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3NodeAnimationLayer
+
+/** Returns the Hamilton product of the specified quaternions. */
+static inline CC3Quaternion CC3AnimationQuaternionMultiply(CC3Quaternion q1, CC3Quaternion q2) {
+	return CC3QuaternionMake((q1.w * q2.x) + (q1.x * q2.w) + (q1.y * q2.z) - (q1.z * q2.y),
+							 (q1.w * q2.y) - (q1.x * q2.z) + (q1.y * q2.w) + (q1.z * q2.x),
+							 (q1.w * q2.z) + (q1.x * q2.y) - (q1.y * q2.x) + (q1.z * q2.w),
+							 (q1.w * q2.w) - (q1.x * q2.x) - (q1.y * q2.y) - (q1.z * q2.z));
+}
+
+/** Returns the conjugate of the specified quaternion, which is its inverse if it is normalized. */
+static inline CC3Quaternion CC3AnimationQuaternionConjugate(CC3Quaternion q) {
+	return CC3QuaternionMake(-q.x, -q.y, -q.z, q.w);
+}
+
+/** Returns the normalized linear interpolation between the specified quaternions. */
+static inline CC3Quaternion CC3AnimationQuaternionNlerp(CC3Quaternion q1, CC3Quaternion q2, GLfloat blendFactor) {
+	return CC3QuaternionNormalize(CC3Vector4Add(q1, CC3Vector4ScaleUniform(CC3Vector4Difference(q2, q1), blendFactor)));
+}
+
+/** Moves the specified vector content towards the target content by the specified weight. */
+static inline void CC3AnimationBlendVector(GLfloat* dst, const GLfloat* src, GLfloat weight) {
+	dst[0] += (src[0] - dst[0]) * weight;
+	dst[1] += (src[1] - dst[1]) * weight;
+	dst[2] += (src[2] - dst[2]) * weight;
+}
+
+/** Adds the difference between the specified vector content and reference content, scaled by the weight. */
+static inline void CC3AnimationAddVector(GLfloat* dst, const GLfloat* src, const GLfloat* ref, GLfloat weight) {
+	dst[0] += (src[0] - ref[0]) * weight;
+	dst[1] += (src[1] - ref[1]) * weight;
+	dst[2] += (src[2] - ref[2]) * weight;
+}
+
+/**
+ * Blends the specified sampled content of the nodes of a layer into the blend content.
+ *
+ * Each node in the sample is mapped to a node in the blend content by the node indices.
+ * If the layer is additive, the difference between the sample and the reference content
+ * is added to the blend content. Otherwise, the blend content is moved towards the sample.
+ * Quaternions are kept normalized, and are aligned to the same hemisphere before blending.
+ */
+static void CC3AnimationBlendLayer(GLfloat* blend, const GLfloat* sample, const GLfloat* reference,
+								   const GLubyte* channels, const GLuint* nodeIndices,
+								   const GLfloat* maskWeights, GLuint nodeCount,
+								   GLfloat layerWeight, BOOL isAdditive) {
+	for (GLuint nodeIdx = 0; nodeIdx < nodeCount; nodeIdx++) {
+		GLfloat weight = layerWeight * maskWeights[nodeIdx];
+		if (weight <= 0.0f) continue;
+
+		GLubyte nodeChannels = channels[nodeIdx];
+		GLuint srcOfst = nodeIdx * kCC3AnimationBatchNodeStride;
+		GLfloat* pDst = blend + (nodeIndices[nodeIdx] * kCC3AnimationBatchNodeStride);
+		const GLfloat* pSrc = sample + srcOfst;
+		const GLfloat* pRef = reference + srcOfst;
+		CC3Quaternion* pDstQuat = (CC3Quaternion*)(pDst + kCC3AnimationBatchQuaternionOffset);
+		CC3Quaternion srcQuat = *(CC3Quaternion*)(pSrc + kCC3AnimationBatchQuaternionOffset);
+
+		if (isAdditive) {
+			if (nodeChannels & kCC3AnimationBatchChannelLocation)
+				CC3AnimationAddVector(pDst + kCC3AnimationBatchLocationOffset,
+									  pSrc + kCC3AnimationBatchLocationOffset,
+									  pRef + kCC3AnimationBatchLocationOffset, weight);
+			if (nodeChannels & kCC3AnimationBatchChannelQuaternion) {
+				CC3Quaternion refQuat = *(CC3Quaternion*)(pRef + kCC3AnimationBatchQuaternionOffset);
+				CC3Quaternion delta = CC3AnimationQuaternionMultiply(CC3AnimationQuaternionConjugate(refQuat), srcQuat);
+				if (delta.w < 0.0f) delta = CC3QuaternionNegate(delta);
+				delta = CC3AnimationQuaternionNlerp(kCC3QuaternionIdentity, delta, weight);
+				*pDstQuat = CC3QuaternionNormalize(CC3AnimationQuaternionMultiply(*pDstQuat, delta));
+			}
+			if (nodeChannels & kCC3AnimationBatchChannelScale)
+				CC3AnimationAddVector(pDst + kCC3AnimationBatchScaleOffset,
+									  pSrc + kCC3AnimationBatchScaleOffset,
+									  pRef + kCC3AnimationBatchScaleOffset, weight);
+		} else {
+			if (nodeChannels & kCC3AnimationBatchChannelLocation)
+				CC3AnimationBlendVector(pDst + kCC3AnimationBatchLocationOffset,
+										pSrc + kCC3AnimationBatchLocationOffset, weight);
+			if (nodeChannels & kCC3AnimationBatchChannelQuaternion) {
+				if (CC3Vector4Dot(*pDstQuat, srcQuat) < 0.0f) srcQuat = CC3QuaternionNegate(srcQuat);
+				*pDstQuat = CC3AnimationQuaternionNlerp(*pDstQuat, srcQuat, weight);
+			}
+			if (nodeChannels & kCC3AnimationBatchChannelScale)
+				CC3AnimationBlendVector(pDst + kCC3AnimationBatchScaleOffset,
+										pSrc + kCC3AnimationBatchScaleOffset, weight);
+		}
+	}
+}
+
+@interface CC3NodeAnimationLayer (TemplateMethods)
+-(id) initWithAnimationBatch: (CC3NodeAnimationBatch*) aBatch forBlender: (CC3NodeAnimationBlender*) aBlender;
+-(void) blendInto: (GLfloat*) blend;
+-(void) addChannelsInto: (GLubyte*) blendChannels;
+@end
+
+@implementation CC3NodeAnimationLayer
+
+@synthesize animationBatch, weight, animationTime, isAdditive;
+
+-(void) dealloc {
+	[animationBatch release];
+	free(nodeIndices);
+	free(maskWeights);
+	[super dealloc];
+}
+
+-(id) init {
+	NSAssert1(NO, @"%@ must be created by a CC3NodeAnimationBlender", self);
+	return nil;
+}
+
+/** Maps each node in the specified batch to the index of that node within the specified blender. */
+-(id) initWithAnimationBatch: (CC3NodeAnimationBatch*) aBatch forBlender: (CC3NodeAnimationBlender*) aBlender {
+	if ( (self = [super init]) ) {
+		animationBatch = [aBatch retain];
+		weight = 1.0f;
+		animationTime = 0.0f;
+		isAdditive = NO;
+
+		CCArray* batchNodes = aBatch.nodes;
+		GLuint nodeCount = batchNodes.count;
+		nodeIndices = calloc(MAX(nodeCount, 1), sizeof(GLuint));
+		maskWeights = calloc(MAX(nodeCount, 1), sizeof(GLfloat));
+		for (GLuint nodeIdx = 0; nodeIdx < nodeCount; nodeIdx++) {
+			nodeIndices[nodeIdx] = [aBlender.nodes indexOfObjectIdenticalTo: [batchNodes objectAtIndex: nodeIdx]];
+			maskWeights[nodeIdx] = 1.0f;
+		}
+		if (aBatch.unbatchedNodes.count)
+			LogInfo(@"%@ ignores animation of %u nodes that could not be batched", self, aBatch.unbatchedNodes.count);
+	}
+	return self;
+}
+
+-(GLfloat) maskWeightForNode: (CC3Node*) aNode {
+	NSUInteger nodeIdx = [animationBatch.nodes indexOfObjectIdenticalTo: aNode];
+	return (nodeIdx != NSNotFound) ? maskWeights[nodeIdx] : 0.0f;
+}
+
+-(void) setMaskWeight: (GLfloat) maskWeight forNode: (CC3Node*) aNode {
+	NSUInteger nodeIdx = [animationBatch.nodes indexOfObjectIdenticalTo: aNode];
+	if (nodeIdx != NSNotFound) maskWeights[nodeIdx] = maskWeight;
+	for (CC3Node* child in aNode.children) [self setMaskWeight: maskWeight forNode: child];
+}
+
+/** Samples the animation of this layer at its animation time, and blends it into the specified content. */
+-(void) blendInto: (GLfloat*) blend {
+	GLuint nodeCount = animationBatch.nodes.count;
+	if (weight <= 0.0f || nodeCount == 0) return;
+
+	CC3AnimationBlendLayer(blend, [animationBatch sampleFrameAt: animationTime],
+						   [animationBatch frameContentAt: 0], animationBatch.channels,
+						   nodeIndices, maskWeights, nodeCount, weight, isAdditive);
+}
+
+/** Adds the channels animated by this layer to the specified channels of the blender nodes. */
+-(void) addChannelsInto: (GLubyte*) blendChannels {
+	GLubyte* batchChannels = animationBatch.channels;
+	GLuint nodeCount = animationBatch.nodes.count;
+	for (GLuint nodeIdx = 0; nodeIdx < nodeCount; nodeIdx++)
+		blendChannels[nodeIndices[nodeIdx]] |= batchChannels[nodeIdx];
+}
+
+-(NSString*) description {
+	return [NSString stringWithFormat: @"%@ with weight %.3f%@", [self class], weight, (isAdditive ? @" additive" : @"")];
+}
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3NodeAnimationBlender
+
+@interface CC3NodeAnimationBlender (TemplateMethods)
+-(CC3NodeAnimationLayer*) addLayerWithBatch: (CC3NodeAnimationBatch*) aBatch;
+-(void) updateChannels;
+@end
+
+@implementation CC3NodeAnimationBlender
+
+@synthesize rootNode, nodes, layers, nodeDepthLimit;
+
+-(void) dealloc {
+	rootNode = nil;			// Weak reference
+	[nodes release];
+	[layers release];
+	free(restContent);
+	free(blendContent);
+	free(channels);
+	free(nodeDepths);
+	[super dealloc];
+}
+
+
+#pragma mark Allocation and initialization
+
+-(id) init {
+	NSAssert1(NO, @"%@ cannot be initialized without a node", self);
+	return nil;
+}
+
+-(id) initForNode: (CC3Node*) aNode {
+	if ( (self = [super init]) ) {
+		rootNode = aNode;			// Weak reference
+		nodes = [[aNode flatten] retain];
+		layers = [[CCArray array] retain];
+		GLuint contentLength = MAX(nodes.count, 1) * kCC3AnimationBatchNodeStride;
+		restContent = calloc(contentLength, sizeof(GLfloat));
+		blendContent = calloc(contentLength, sizeof(GLfloat));
+		channels = calloc(MAX(nodes.count, 1), sizeof(GLubyte));
+		nodeDepths = calloc(MAX(nodes.count, 1), sizeof(GLuint));
+		for (GLuint nodeIdx = 0; nodeIdx < nodes.count; nodeIdx++)
+			nodeDepths[nodeIdx] = CC3NodeAnimationDepthBelow([nodes objectAtIndex: nodeIdx], aNode);
+		nodeDepthLimit = kCC3MaxGLuint;
+		[self captureRestPose];
+	}
+	return self;
+}
+
++(id) blenderForNode: (CC3Node*) aNode { return [[[self alloc] initForNode: aNode] autorelease]; }
+
+-(void) captureRestPose {
+	GLuint nodeCount = nodes.count;
+	for (GLuint nodeIdx = 0; nodeIdx < nodeCount; nodeIdx++) {
+		CC3Node* aNode = [nodes objectAtIndex: nodeIdx];
+		GLfloat* pNode = restContent + (nodeIdx * kCC3AnimationBatchNodeStride);
+		*(CC3Vector*)(pNode + kCC3AnimationBatchLocationOffset) = aNode.location;
+		*(CC3Quaternion*)(pNode + kCC3AnimationBatchQuaternionOffset) = aNode.quaternion;
+		*(CC3Vector*)(pNode + kCC3AnimationBatchScaleOffset) = aNode.scale;
+	}
+}
+
+
+#pragma mark Layers
+
+-(CC3NodeAnimationLayer*) addLayerWithBatch: (CC3NodeAnimationBatch*) aBatch {
+	CC3NodeAnimationLayer* layer = [[CC3NodeAnimationLayer alloc] initWithAnimationBatch: aBatch forBlender: self];
+	[layers addObject: layer];
+	[layer release];
+	[self updateChannels];
+	return layer;
+}
+
+-(CC3NodeAnimationLayer*) addLayer {
+	return [self addLayerWithBatch: [CC3NodeAnimationBatch batchForNode: rootNode]];
+}
+
+-(CC3NodeAnimationLayer*) addLayerWithAnimationFrom: (CC3Node*) animSource {
+	return [self addLayerWithBatch: [CC3NodeAnimationBatch batchForNode: rootNode withAnimationFrom: animSource]];
+}
+
+-(void) removeLayer: (CC3NodeAnimationLayer*) aLayer {
+	[layers removeObjectIdenticalTo: aLayer];
+	[self updateChannels];
+}
+
+/** Determines which properties of each node are animated by any layer. */
+-(void) updateChannels {
+	memset(channels, 0, MAX(nodes.count, 1) * sizeof(GLubyte));
+	for (CC3NodeAnimationLayer* layer in layers) [layer addChannelsInto: channels];
+}
+
+
+#pragma mark Animating
+
+-(void) establishFrame {
+	GLuint nodeCount = nodes.count;
+	memcpy(blendContent, restContent, nodeCount * kCC3AnimationBatchNodeStride * sizeof(GLfloat));
+
+	for (CC3NodeAnimationLayer* layer in layers) [layer blendInto: blendContent];
+
+	for (GLuint nodeIdx = 0; nodeIdx < nodeCount; nodeIdx++) {
+		GLubyte nodeChannels = channels[nodeIdx];
+		if ( !nodeChannels || nodeDepths[nodeIdx] > nodeDepthLimit ) continue;
+
+		CC3Node* aNode = [nodes objectAtIndex: nodeIdx];
+		if ( !aNode.isAnimationEnabled ) continue;
+
+		GLfloat* pNode = blendContent + (nodeIdx * kCC3AnimationBatchNodeStride);
+		[aNode setAnimatedLocation: ((nodeChannels & kCC3AnimationBatchChannelLocation)
+									 ? (CC3Vector*)(pNode + kCC3AnimationBatchLocationOffset) : NULL)
+						quaternion: ((nodeChannels & kCC3AnimationBatchChannelQuaternion)
+									 ? (CC3Quaternion*)(pNode + kCC3AnimationBatchQuaternionOffset) : NULL)
+							 scale: ((nodeChannels & kCC3AnimationBatchChannelScale)
+									 ? (CC3Vector*)(pNode + kCC3AnimationBatchScaleOffset) : NULL)];
+	}
+	[rootNode markTransformDirty];
+}
+
+-(void) establishFrameAt: (ccTime) t {
+	LogTrace(@"%@ animating frame at %.3f ms", self, t);
+	for (CC3NodeAnimationLayer* layer in layers) layer.animationTime = t;
+	[self establishFrame];
+}
+
+-(NSString*) description {
+	return [NSString stringWithFormat: @"%@ blending %u layers across %u nodes", [self class], layers.count, nodes.count];
+}
+
+@end
@@ -172,6 +172,7 @@ static const GLfloat kCC3MaximumMaterialShininess = 128.0;
 	GLenum _alphaTestFunction;
 	GLfloat _alphaTestReference;
 	ccBlendFunc _blendFunc;
+	GLuint _drawingVersion;
 	BOOL _shouldUseLighting : 1;
 }
 
@@ -727,6 +728,30 @@ static const GLfloat kCC3MaximumMaterialShininess = 128.0;
  */
 -(void) drawWithVisitor: (CC3NodeDrawingVisitor*) visitor;
 
+/**
+ * Populates the specified draw command with this material, the shader program and context
+ * used by this material, the blending, alpha testing, lighting and color state of this
+ * material, and the binding of each texture to its texture unit. This method makes no GL calls.
+ *
+ * When the command is replayed, the state and texture bindings held in the command are
+ * applied directly to the GL engine, without messaging this material or its textures.
+ * If any texture has a texture unit, the command is marked to be populated again on each
+ * frame, because a texture unit can be changed without notifying this material.
+ *
+ * This method is invoked automatically from the populateDrawCommand:withVisitor: method of
+ * the CC3MeshNode that is using this material. Usually, the application never needs to
+ * invoke this method directly.
+ */
+-(void) populateDrawCommand: (CC3DrawCommand*) aCommand withVisitor: (CC3NodeDrawingVisitor*) visitor;
+
+/**
+ * A version number that changes whenever the content captured by the populateDrawCommand:withVisitor:
+ * method changes, such as when a color, blending or lighting property is changed, or when a
+ * texture is added, removed or changed. Draw commands that were populated from this material
+ * are populated again when this version changes.
+ */
+@property(nonatomic, readonly) GLuint drawingVersion;
+
 /**
  * Unbinds all materials from the GL engine.
  * 
@@ -754,7 +779,20 @@ static const GLfloat kCC3MaximumMaterialShininess = 128.0;
  *
  * This is invoked automatically by the CC3Scene at the beginning of each frame
  * drawing cycle. Usually, the application never needs to invoke this method directly.
+ *
+ * Material switching tracks the state of the GL engine, and is therefore only reset when
+ * this method is invoked from the rendering thread. Invocations from other threads are ignored.
  */
 +(void) resetSwitching;
 
+/**
+ * Returns whether the material with the specified tag is different than the material that was
+ * most recently drawn to the GL engine, and records the specified tag as the most recently
+ * drawn material.
+ *
+ * This is invoked automatically when a draw command is replayed, and by the drawWithVisitor:
+ * method of each material. Usually, the application never needs to invoke this method directly.
+ */
++(BOOL) switchingToMaterialTag: (GLuint) aTag;
+
 @end
@@ -38,9 +38,9 @@
 
 @interface CC3Material (TemplateMethods)
 -(void) texturesHaveChanged;
--(void) applyAlphaTest;
--(void) applyBlend;
--(void) applyColors;
+-(void) markDrawingChanged;
+-(void) markDrawingChangedFromTexture: (CC3Texture*) oldTexture;
+-(void) populateDrawState: (CC3DrawState*) state;
 -(void) drawTexturesWithVisitor: (CC3NodeDrawingVisitor*) visitor;
 -(void) applyShaderProgramWithVisitor: (CC3NodeDrawingVisitor*) visitor;
 -(BOOL) switchingMaterial;
@@ -63,16 +63,72 @@
 
 -(NSString*) nameSuffix { return @"Material"; }
 
+-(void) setAmbientColor: (ccColor4F) aColor {
+	_ambientColor = aColor;
+	[self markDrawingChanged];
+}
+
+-(void) setDiffuseColor: (ccColor4F) aColor {
+	_diffuseColor = aColor;
+	[self markDrawingChanged];
+}
+
+-(void) setSpecularColor: (ccColor4F) aColor {
+	_specularColor = aColor;
+	[self markDrawingChanged];
+}
+
+-(void) setEmissionColor: (ccColor4F) aColor {
+	_emissionColor = aColor;
+	[self markDrawingChanged];
+}
+
 // Clamp to allowed range
--(void) setShininess: (GLfloat) aValue { _shininess = CLAMP(aValue, 0.0, kCC3MaximumMaterialShininess); }
+-(void) setShininess: (GLfloat) aValue {
+	_shininess = CLAMP(aValue, 0.0, kCC3MaximumMaterialShininess);
+	[self markDrawingChanged];
+}
+
+-(void) setShouldUseLighting: (BOOL) shouldUseLighting {
+	_shouldUseLighting = shouldUseLighting;
+	[self markDrawingChanged];
+}
+
+-(void) setAlphaTestFunction: (GLenum) alphaTestFunction {
+	_alphaTestFunction = alphaTestFunction;
+	[self markDrawingChanged];
+}
+
+-(void) setAlphaTestReference: (GLfloat) alphaTestReference {
+	_alphaTestReference = alphaTestReference;
+	[self markDrawingChanged];
+}
+
+-(void) setShaderContext: (CC3GLProgramContext*) shaderContext {
+	if (shaderContext == _shaderContext) return;
+	[_shaderContext release];
+	_shaderContext = [shaderContext retain];
+	[self markDrawingChanged];
+}
+
+-(void) setBlendFunc: (ccBlendFunc) aBlendFunc {
+	_blendFunc = aBlendFunc;
+	[self markDrawingChanged];
+}
 
 -(GLenum) sourceBlend { return _blendFunc.src; }
 
--(void) setSourceBlend: (GLenum) aBlend { _blendFunc.src = aBlend; }
+-(void) setSourceBlend: (GLenum) aBlend {
+	_blendFunc.src = aBlend;
+	[self markDrawingChanged];
+}
 
 -(GLenum) destinationBlend { return _blendFunc.dst; }
 
--(void) setDestinationBlend: (GLenum) aBlend { _blendFunc.dst = aBlend; }
+-(void) setDestinationBlend: (GLenum) aBlend {
+	_blendFunc.dst = aBlend;
+	[self markDrawingChanged];
+}
 
 -(BOOL) isOpaque { return (_blendFunc.src == GL_ONE && _blendFunc.dst == GL_ZERO); }
 
@@ -94,6 +150,7 @@
 		// If destination blend has not yet been set, set it a destination alpha blend.
 		if (_blendFunc.dst == GL_ZERO) _blendFunc.dst = GL_ONE_MINUS_SRC_ALPHA;
 	}
+	[self markDrawingChanged];
 }
 
 -(BOOL) shouldDrawLowAlpha {
@@ -109,6 +166,7 @@
 
 -(void) setShouldDrawLowAlpha: (BOOL) shouldDraw {
 	_alphaTestFunction = shouldDraw ? GL_ALWAYS : GL_GREATER;
+	[self markDrawingChanged];
 }
 
 
@@ -129,6 +187,8 @@
 	_diffuseColor.r = rf;
 	_diffuseColor.g = gf;
 	_diffuseColor.b = bf;
+
+	[self markDrawingChanged];
 }
 
 -(GLubyte) opacity { return CCColorByteFromFloat(_diffuseColor.a); }
@@ -144,6 +204,7 @@
 	_diffuseColor.a = af;
 	_specularColor.a = af;
 	_emissionColor.a = af;
+	[self markDrawingChanged];
 
 	// As a convenience, if we're trying to reduce opacity, make sure the isOpaque
 	// flag is compatible with that. We do NOT force it the other way, because the
@@ -166,6 +227,7 @@ static ccBlendFunc defaultBlendFunc = {GL_ONE, GL_ZERO};
 
 -(void) setTexture: (CC3Texture*) aTexture {
 	if (aTexture == _texture) return;
+	[self markDrawingChangedFromTexture: _texture];
 	[_texture release];
 	_texture = [aTexture retain];
 	[self texturesHaveChanged];
@@ -197,7 +259,8 @@ static ccBlendFunc defaultBlendFunc = {GL_ONE, GL_ZERO};
 	if (_texture == aTexture) {
 		self.texture = nil;
 	} else {
-		if (_textureOverlays && aTexture) {
+		if (_textureOverlays && aTexture && [_textureOverlays containsObject: aTexture]) {
+			[self markDrawingChangedFromTexture: aTexture];
 			[_textureOverlays removeObjectIdenticalTo: aTexture];
 			[self texturesHaveChanged];
 			if (_textureOverlays.count == 0) {
@@ -229,6 +292,7 @@ static ccBlendFunc defaultBlendFunc = {GL_ONE, GL_ZERO};
 		self.texture = aTexture;
 	} else if (texUnit < self.textureCount) {
 		NSAssert1(aTexture, @"%@ cannot set an overlay texture to nil", self);
+		[self markDrawingChangedFromTexture: [_textureOverlays objectAtIndex: (texUnit - 1)]];
 		[_textureOverlays fastReplaceObjectAtIndex: (texUnit - 1) withObject: aTexture];
 		[self texturesHaveChanged];
 	} else {
@@ -266,6 +330,27 @@ static ccBlendFunc defaultBlendFunc = {GL_ONE, GL_ZERO};
  */
 -(void) texturesHaveChanged { self.isOpaque = self.isOpaque; }
 
+
+#pragma mark Drawing versions
+
+-(void) markDrawingChanged { CC3IncrementChangeCounter(&_drawingVersion); }
+
+/**
+ * The drawingVersion of this material includes the versions of its textures. When a texture
+ * is replaced or removed, its version no longer contributes, so the version of this material
+ * is advanced by more than the contribution of the old texture, to ensure the total does not
+ * return to a value that a draw command may have been populated with.
+ */
+-(void) markDrawingChangedFromTexture: (CC3Texture*) oldTexture {
+	CC3AddToChangeCounter(&_drawingVersion, (oldTexture.drawingVersion + 1));
+}
+
+-(GLuint) drawingVersion {
+	GLuint version = _drawingVersion + _texture.drawingVersion;
+	for (CC3Texture* ot in _textureOverlays) version += ot.drawingVersion;
+	return version;
+}
+
 -(BOOL) hasPremultipliedAlpha {
 	// Check the first texture.
 	if (_texture && _texture.hasPremultipliedAlpha) return YES;
@@ -325,6 +410,7 @@ static ccBlendFunc defaultBlendFunc = {GL_ONE, GL_ZERO};
 		_alphaTestFunction = GL_ALWAYS;
 		_alphaTestReference = 0.0f;
 		_shouldUseLighting = YES;
+		_drawingVersion = 0;
 		[self makeShaderProgram];
 	}
 	return self;
@@ -407,7 +493,7 @@ static ccBlendFunc defaultBlendFunc = {GL_ONE, GL_ZERO};
 // This class variable is automatically incremented whenever the method nextTag is called.
 static GLuint lastAssignedMaterialTag;
 
--(GLuint) nextTag { return ++lastAssignedMaterialTag; }
+-(GLuint) nextTag { return CC3IncrementTagCounter(&lastAssignedMaterialTag); }
 
 +(void) resetTagAllocation { lastAssignedMaterialTag = 0; }
 
@@ -417,9 +503,9 @@ static GLuint lastAssignedMaterialTag;
 -(void) drawWithVisitor: (CC3NodeDrawingVisitor*) visitor {
 	if ([self switchingMaterial]) {
 		LogTrace(@"Drawing %@", self);
-		[self applyAlphaTest];
-		[self applyBlend];
-		[self applyColors];
+		CC3DrawState state;
+		[self populateDrawState: &state];
+		CC3DrawStateApplyMaterial(&state);
 		[self drawTexturesWithVisitor: visitor];
 	} else {
 		LogTrace(@"Reusing currently bound %@", self);
@@ -428,61 +514,59 @@ static GLuint lastAssignedMaterialTag;
 }
 
 /**
- * Enables or disables alpha testing in the GL engine, depending on the whether or not
- * the alphaTestFunction indicates that alpha testing should occur, and applies the
- * alphaTestFunction and alphaTestReference properties.
+ * The texture bindings are allocated in a single block, so that the binding of each
+ * texture unit can be located from the textureBindingsOffset of the command.
  */
--(void) applyAlphaTest {
-	CC3OpenGLESEngine* glesEngine = [CC3OpenGLESEngine engine];
-	BOOL shouldAlphaTest = (_alphaTestFunction != GL_ALWAYS);
-	glesEngine.capabilities.alphaTest.value = shouldAlphaTest;
-	if (shouldAlphaTest) [glesEngine.materials.alphaFunc applyFunction: _alphaTestFunction
-														  andReference: _alphaTestReference];
-}
-
-/**
- * Enables or disables blending in the GL engine, depending on the whether or not this
- * instance is opaque or not, and applies the sourceBlend and destinationBlend properties.
- */
--(void) applyBlend {
-	CC3OpenGLESEngine* glesEngine = [CC3OpenGLESEngine engine];
-	BOOL shouldBlend = !self.isOpaque;
-	glesEngine.capabilities.blend.value = shouldBlend;
-	if (shouldBlend) [glesEngine.materials.blendFunc applySource: _blendFunc.src
-												  andDestination: _blendFunc.dst];
+-(void) populateDrawCommand: (CC3DrawCommand*) aCommand withVisitor: (CC3NodeDrawingVisitor*) visitor {
+	aCommand->material = self;
+	aCommand->materialTag = tag;
+	aCommand->shaderContext = _shaderContext;
+	aCommand->shaderProgram = _shaderContext.program;
+	[self populateDrawState: &aCommand->state];
+
+	GLuint texCount = self.textureCount;
+	aCommand->textureBindingCount = texCount;
+	if ( !texCount ) return;
+
+	CC3DrawCommandList* cmdList = visitor.commandList;
+	aCommand->textureBindingsOffset = [cmdList allocateContent: (texCount * sizeof(CC3DrawTextureBinding))
+													forCommand: aCommand];
+	CC3DrawTextureBinding* texBindings = [cmdList contentAt: aCommand->textureBindingsOffset
+												  ofCommand: aCommand];
+	GLuint tu = 0;
+	if (_texture) {
+		[_texture populateDrawTextureBinding: &texBindings[tu++]];
+		if (_texture.textureUnit) aCommand->isVolatile = YES;
+	}
+	for (CC3Texture* ot in _textureOverlays) {
+		[ot populateDrawTextureBinding: &texBindings[tu++]];
+		if (ot.textureUnit) aCommand->isVolatile = YES;
+	}
 }
 
 /**
- * If the shouldUseLighting property is YES, applies the color and shininess properties to
- * the GL engine, otherwise turns lighting off and applies diffuse color as a flat color.
+ * Populates the blending, alpha test and lighting content of the specified drawing state.
+ * If the material has a texture with pre-multiplied alpha, the opacity is applied to the colors.
  */
--(void) applyColors {
-	CC3OpenGLESEngine* glesEngine = CC3OpenGLESEngine.engine;
-	if (_shouldUseLighting) {
-		[glesEngine.capabilities.lighting enable];
-
-		ccColor4F ambColor = _ambientColor;
-		ccColor4F difColor = _diffuseColor;
-		ccColor4F spcColor = _specularColor;
-		ccColor4F emsColor = _emissionColor;
-		if (self.shouldApplyOpacityToColor) {
-			ambColor = CCC4FBlendAlpha(ambColor);
-			difColor = CCC4FBlendAlpha(difColor);
-			spcColor = CCC4FBlendAlpha(spcColor);
-			emsColor = CCC4FBlendAlpha(emsColor);
-		}
-		CC3OpenGLESMaterials* glesMaterials = glesEngine.materials;
-		glesMaterials.ambientColor.value = ambColor;
-		glesMaterials.diffuseColor.value = difColor;
-		glesMaterials.specularColor.value = spcColor;
-		glesMaterials.emissionColor.value = emsColor;
-		glesMaterials.shininess.value = _shininess;
+-(void) populateDrawState: (CC3DrawState*) state {
+	state->shouldBlend = !self.isOpaque;
+	state->sourceBlend = _blendFunc.src;
+	state->destinationBlend = _blendFunc.dst;
+	state->alphaTestFunction = _alphaTestFunction;
+	state->alphaTestReference = _alphaTestReference;
+	state->shouldUseLighting = _shouldUseLighting;
+	state->shininess = _shininess;
+
+	if (self.shouldApplyOpacityToColor) {
+		state->ambientColor = CCC4FBlendAlpha(_ambientColor);
+		state->diffuseColor = CCC4FBlendAlpha(_diffuseColor);
+		state->specularColor = CCC4FBlendAlpha(_specularColor);
+		state->emissionColor = CCC4FBlendAlpha(_emissionColor);
 	} else {
-		[glesEngine.capabilities.lighting disable];
-
-		ccColor4F difColor = _diffuseColor;
-		if (self.shouldApplyOpacityToColor) difColor = CCC4FBlendAlpha(difColor);
-		glesEngine.state.color.value = difColor;
+		state->ambientColor = _ambientColor;
+		state->diffuseColor = _diffuseColor;
+		state->specularColor = _specularColor;
+		state->emissionColor = _emissionColor;
 	}
 }
 
@@ -527,13 +611,15 @@ static GLuint lastAssignedMaterialTag;
 static GLuint currentMaterialTag = 0;
 
 +(void) resetSwitching {
-	currentMaterialTag = 0;
+	if (CC3OpenGLESEngine.isRenderThread) currentMaterialTag = 0;
 }
 
--(BOOL) switchingMaterial {
-	BOOL shouldSwitch = currentMaterialTag != tag;
-	currentMaterialTag = tag;		// Set anyway - either it changes or it doesn't.
++(BOOL) switchingToMaterialTag: (GLuint) aTag {
+	BOOL shouldSwitch = currentMaterialTag != aTag;
+	currentMaterialTag = aTag;		// Set anyway - either it changes or it doesn't.
 	return shouldSwitch;
 }
 
+-(BOOL) switchingMaterial { return [[self class] switchingToMaterialTag: tag]; }
+
 @end
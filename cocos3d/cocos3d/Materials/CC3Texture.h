@@ -93,6 +93,7 @@
 	GLenum _magnifyingFunction;
 	GLenum _horizontalWrappingFunction;
 	GLenum _verticalWrappingFunction;
+	GLuint _drawingVersion;
 	BOOL _texParametersAreDirty : 1;
 }
 
@@ -133,6 +134,18 @@
  */
 @property(nonatomic, retain) CC3TextureUnit* textureUnit;
 
+/**
+ * A counter that changes whenever this texture changes in a way that affects how it is
+ * bound to the GL engine, including when the texture, textureUnit or any of the texture
+ * parameter properties are set.
+ *
+ * Draw commands that were populated from this texture are reused only while this value
+ * remains unchanged. Changes made directly to the properties of the textureUnit are not
+ * reflected in this value, and so a draw command that contains a texture with a texture
+ * unit is populated again on each frame.
+ */
+@property(nonatomic, readonly) GLuint drawingVersion;
+
 /**
  * Returns the proportional size of the usable image in the contained CCTexture2D,
  * relative to its physical size.
@@ -277,6 +290,48 @@
  */
 +(void) setShouldGenerateMipmaps: (BOOL) shouldMipmap;
 
+/**
+ * Returns whether texture files loaded via the loadTextureFile: method of this instance,
+ * or through one of the instance initialization methods that load a texture, are loaded
+ * in the background by the sharedLoader of CC3TextureLoader.
+ *
+ * When this property is set to YES, loading a texture file does not wait for the file to
+ * be decoded and uploaded to the GL engine. Instead, the texture property is set to a
+ * placeholder texture, and is replaced with the loaded texture on a subsequent frame.
+ * See the notes for the loadTextureFileInBackground: method for more information.
+ *
+ * This property affects all textures loaded through CC3Texture. You can set this
+ * property to the desired value prior to loading one or more textures.
+ *
+ * The default value of this class-side property is NO, indicating that texture files
+ * are loaded immediately.
+ */
++(BOOL) shouldLoadInBackground;
+
+/**
+ * Sets whether texture files loaded via the loadTextureFile: method of this instance,
+ * or through one of the instance initialization methods that load a texture, are loaded
+ * in the background by the sharedLoader of CC3TextureLoader.
+ *
+ * This property affects all textures loaded through CC3Texture. You can set this
+ * property to the desired value prior to loading one or more textures.
+ *
+ * The default value of this class-side property is NO, indicating that texture files
+ * are loaded immediately.
+ */
++(void) setShouldLoadInBackground: (BOOL) shouldLoadInBackground;
+
+/**
+ * Returns a count that is incremented whenever the texture property of any instance is changed
+ * from one texture to another that has a different mapSize or vertical orientation, such as
+ * when a texture that was loaded in the background replaces its placeholder texture.
+ *
+ * Each CC3MeshNode compares this value to the value it held when the node last aligned its
+ * texture coordinates, and if it has changed, realigns its texture coordinates with its
+ * textures before it is next drawn.
+ */
++(GLuint) alignmentChangeCount;
+
 
 #pragma mark Texture parameters
 
@@ -611,6 +666,23 @@
  */
 -(BOOL) loadTextureFile: (NSString*) aFilePath;
 
+/**
+ * Starts loading the texture file at the specified file path in the background, using the
+ * sharedLoader of CC3TextureLoader, and returns whether the file exists.
+ *
+ * The texture property is immediately set to the placeholderTexture of the loader. Once the
+ * file has been decoded on a worker thread, its content is uploaded to the GL engine over
+ * one or more frames, and the texture property is set to the loaded texture. Depending on
+ * the configuration of the loader, the texture property may first be set to a lower
+ * resolution preview of the texture. See CC3TextureLoader for more information.
+ *
+ * If the class-side shouldLoadInBackground property is set to YES, this method is invoked
+ * automatically by the loadTextureFile: method.
+ *
+ * This method should be invoked on the GL thread.
+ */
+-(BOOL) loadTextureFileInBackground: (NSString*) aFilePath;
+
 
 #pragma mark Drawing
 
@@ -628,6 +700,16 @@
  */
 -(void) drawWithVisitor: (CC3NodeDrawingVisitor*) visitor;
 
+/**
+ * Populates the specified texture binding with the GL texture name, the texture parameters,
+ * and the texture environment of the textureUnit, so that this texture can be bound when a
+ * draw command is replayed, without messaging this texture.
+ *
+ * If the texture parameters have changed since they were last bound, the shouldBindParameters
+ * flag of the binding is set, and the parameters of this texture are then considered bound.
+ */
+-(void) populateDrawTextureBinding: (CC3DrawTextureBinding*) texBinding;
+
 /**
  * Disables the specified texture unit in the GL engine.
  *
@@ -813,4 +895,23 @@
  */
 +(void) PVRImagesHavePremultipliedAlpha: (BOOL) haveAlphaPremultiplied;
 
+/**
+ * Initializes this instance to wrap the GL texture with the specified name, whose content
+ * has already been uploaded to the GL engine in 32-bit RGBA format with premultiplied alpha.
+ *
+ * The specified width and height are the dimensions of the GL texture, and the specified
+ * content size is the size of the usable image within the GL texture. The usable image
+ * is assumed to occupy the first rows of the texture content, so the isFlippedVertically
+ * property of this instance is set to YES.
+ *
+ * The GL texture will be deleted when this instance is deallocated.
+ *
+ * This initializer is used by CC3TextureLoader to wrap textures uploaded in the background.
+ */
+-(id) initWithTextureName: (GLuint) texName
+			   pixelsWide: (GLuint) width
+			   pixelsHigh: (GLuint) height
+			  contentSize: (CGSize) size
+				hasMipmap: (BOOL) hasMipmap;
+
 @end
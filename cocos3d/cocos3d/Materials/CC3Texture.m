@@ -35,6 +35,7 @@
 #import "CC3OpenGLESEngine.h"
 #import "CCFileUtils.h"
 #import "CCTexturePVR.h"
+#import "CC3TextureLoader.h"
 
 
 #pragma mark -
@@ -43,16 +44,12 @@
 @interface CC3Texture (TemplateMethods)
 -(void) markTextureParametersDirty;
 -(void) bindGLWithVisitor: (CC3NodeDrawingVisitor*) visitor;
--(void) bindTextureParametersTo: (CC3OpenGLESTextureUnit*) glesTexUnit
-					withVisitor: (CC3NodeDrawingVisitor*) visitor;
--(void) bindTextureEnvironmentTo: (CC3OpenGLESTextureUnit*) glesTexUnit
-					 withVisitor: (CC3NodeDrawingVisitor*) visitor;
 @end
 
 
 @implementation CC3Texture
 
-@synthesize textureUnit=_textureUnit;
+@synthesize textureUnit=_textureUnit, drawingVersion=_drawingVersion;
 
 -(void) dealloc {
 	[_texture release];
@@ -62,11 +59,25 @@
 
 -(CCTexture2D*) texture { return _texture; }
 
+/** Incremented when a texture is replaced by one that requires texture coordinates to be realigned. */
+static GLuint _alignmentChangeCount = 0;
+
 -(void) setTexture:(CCTexture2D *)texture {
 	if (texture == _texture) return;
+	BOOL needsRealignment = (_texture && texture &&
+							 (texture.maxS != _texture.maxS || texture.maxT != _texture.maxT ||
+							  !texture.cc3IsFlippedVertically != !_texture.cc3IsFlippedVertically));
 	[_texture release];
 	_texture = [texture retain];
 	[self markTextureParametersDirty];		// params depend on texture POT/NPOT
+	if (needsRealignment) _alignmentChangeCount++;
+}
+
+-(void) setTextureUnit: (CC3TextureUnit*) textureUnit {
+	if (textureUnit == _textureUnit) return;
+	[_textureUnit release];
+	_textureUnit = [textureUnit retain];
+	CC3IncrementChangeCounter(&_drawingVersion);
 }
 
 -(CGSize) mapSize { return _texture ? CGSizeMake(_texture.maxS, _texture.maxT) : CGSizeZero; }
@@ -90,6 +101,15 @@ static BOOL _shouldGenerateMipmaps = YES;
 
 +(void) setShouldGenerateMipmaps: (BOOL) shouldMipmap  { _shouldGenerateMipmaps = shouldMipmap; }
 
+/** Indicates whether texture files should be loaded in the background. */
+static BOOL _shouldLoadInBackground = NO;
+
++(BOOL) shouldLoadInBackground { return _shouldLoadInBackground; }
+
++(void) setShouldLoadInBackground: (BOOL) shouldLoadInBackground  { _shouldLoadInBackground = shouldLoadInBackground; }
+
++(GLuint) alignmentChangeCount { return _alignmentChangeCount; }
+
 -(GLenum) minifyingFunction {
 	if (self.hasMipmap) return _minifyingFunction;
 	
@@ -155,7 +175,10 @@ static BOOL _shouldGenerateMipmaps = YES;
 	[self markTextureParametersDirty];
 }
 
--(void) markTextureParametersDirty { _texParametersAreDirty = YES; }
+-(void) markTextureParametersDirty {
+	_texParametersAreDirty = YES;
+	CC3IncrementChangeCounter(&_drawingVersion);
+}
 
 /** Default texture parameters. */
 static ccTexParams _defaultTextureParameters = { GL_LINEAR_MIPMAP_NEAREST, GL_LINEAR, GL_REPEAT, GL_REPEAT };
@@ -205,12 +228,14 @@ static ccTexParams _defaultTextureParameters = { GL_LINEAR_MIPMAP_NEAREST, GL_LI
 	if ( (self = [super initWithTag: aTag withName: aName]) ) {
 		_texture = nil;
 		_textureUnit = nil;
+		_drawingVersion = 0;
 		self.textureParameters = [[self class] defaultTextureParameters];
 	}
 	return self;
 }
 
 -(BOOL) loadTextureFile: (NSString*) aFilePath {
+	if (_shouldLoadInBackground) return [self loadTextureFileInBackground: aFilePath];
 	
 	// Ensure the path is absolute, converting it if needed.
 	NSString* absFilePath = CC3EnsureAbsoluteFilePath(aFilePath);
@@ -236,6 +261,11 @@ static ccTexParams _defaultTextureParameters = { GL_LINEAR_MIPMAP_NEAREST, GL_LI
 	}
 }
 
+-(BOOL) loadTextureFileInBackground: (NSString*) aFilePath {
+	if (!name) self.name = aFilePath.lastPathComponent;
+	return [CC3TextureLoader.sharedLoader loadFile: aFilePath intoTexture: self];
+}
+
 -(void) generateMipmap { [_texture cc3GenerateMipmapIfNeeded]; }
 
 // Protected methods for copying
@@ -275,43 +305,26 @@ static ccTexParams _defaultTextureParameters = { GL_LINEAR_MIPMAP_NEAREST, GL_LI
 }
 
 -(void) bindGLWithVisitor: (CC3NodeDrawingVisitor*) visitor {
-	CC3OpenGLESTextureUnit* glesTexUnit = [CC3OpenGLESEngine.engine.textures textureUnitAt: visitor.textureUnit];
-	[glesTexUnit.texture2D enable];
-	glesTexUnit.textureBinding.value = _texture.name;
-	[self bindTextureParametersTo: glesTexUnit withVisitor: visitor];
-	[self bindTextureEnvironmentTo: glesTexUnit withVisitor: visitor];
-	
-	LogTrace(@"%@ bound to %@", self, glesTexUnit);
-}
-
-/** If the texture parameters are dirty, binds them to the GL texture unit state. */
--(void) bindTextureParametersTo: (CC3OpenGLESTextureUnit*) glesTexUnit
-					withVisitor: (CC3NodeDrawingVisitor*) visitor {
-	if ( !_texParametersAreDirty ) return;
-
-	LogTrace(@"Setting parameters for %@ minifying: %@, magnifying: %@, horiz wrap: %@, vert wrap: %@, ",
-			 self.fullDescription,
-			 NSStringFromGLEnum(self.minifyingFunction),
-			 NSStringFromGLEnum(self.magnifyingFunction),
-			 NSStringFromGLEnum(self.horizontalWrappingFunction),
-			 NSStringFromGLEnum(self.verticalWrappingFunction));
-	
-	// Use property access to allow adjustments from the raw values
-	glesTexUnit.minifyingFunction.value = self.minifyingFunction;
-	glesTexUnit.magnifyingFunction.value = self.magnifyingFunction;
-	glesTexUnit.horizontalWrappingFunction.value = self.horizontalWrappingFunction;
-	glesTexUnit.verticalWrappingFunction.value = self.verticalWrappingFunction;
-
+	CC3DrawTextureBinding texBinding;
+	[self populateDrawTextureBinding: &texBinding];
+	CC3DrawTextureBindingApply(&texBinding, visitor.textureUnit);
+	LogTrace(@"%@ bound to texture unit %u", self, visitor.textureUnit);
+}
+
+/** Use property access to allow adjustments from the raw texture parameter values. */
+-(void) populateDrawTextureBinding: (CC3DrawTextureBinding*) texBinding {
+	texBinding->textureName = _texture.name;
+	texBinding->minifyingFunction = self.minifyingFunction;
+	texBinding->magnifyingFunction = self.magnifyingFunction;
+	texBinding->horizontalWrappingFunction = self.horizontalWrappingFunction;
+	texBinding->verticalWrappingFunction = self.verticalWrappingFunction;
+	texBinding->shouldBindParameters = _texParametersAreDirty;
 	_texParametersAreDirty = NO;
-}
 
-/** Binds the texture unit environment to the specified GL texture unit state. */
--(void) bindTextureEnvironmentTo: (CC3OpenGLESTextureUnit*) glesTexUnit
-					 withVisitor: (CC3NodeDrawingVisitor*) visitor {
 	if (_textureUnit) {
-		[_textureUnit bindTo: glesTexUnit withVisitor: visitor];
+		[_textureUnit populateDrawTextureBinding: texBinding];
 	} else {
-		[CC3TextureUnit bindDefaultTo: glesTexUnit];
+		[CC3TextureUnit populateDefaultDrawTextureBinding: texBinding];
 	}
 }
 
@@ -333,7 +346,7 @@ static ccTexParams _defaultTextureParameters = { GL_LINEAR_MIPMAP_NEAREST, GL_LI
 // This class variable is automatically incremented whenever the method nextTag is called.
 static GLuint lastAssignedTextureTag;
 
--(GLuint) nextTag { return ++lastAssignedTextureTag; }
+-(GLuint) nextTag { return CC3IncrementTagCounter(&lastAssignedTextureTag); }
 
 +(void) resetTagAllocation { lastAssignedTextureTag = 0; }
 
@@ -600,4 +613,25 @@ static BOOL PVRHaveAlphaPremultiplied_ = NO;
 	PVRHaveAlphaPremultiplied_ = haveAlphaPremultiplied;
 }
 
+-(id) initWithTextureName: (GLuint) texName
+			   pixelsWide: (GLuint) width
+			   pixelsHigh: (GLuint) height
+			  contentSize: (CGSize) size
+				hasMipmap: (BOOL) hasMipmap {
+	if( (self = [super init]) ) {
+		name_ = texName;
+		width_ = width;
+		height_ = height;
+		size_ = size;
+		maxS_ = size.width / (GLfloat)width;
+		maxT_ = size.height / (GLfloat)height;
+		format_ = kCCTexture2DPixelFormat_RGBA8888;
+		hasPremultipliedAlpha_ = YES;
+
+		self.cc3HasMipmap = hasMipmap;
+		self.cc3IsFlippedVertically = YES;
+	}
+	return self;
+}
+
 @end
@@ -0,0 +1,306 @@
+/*
+ * CC3TextureLoader.h
+ *
+ * cocos3d 2.0.0
+ * Author: Bill Hollings
+ * Copyright (c) 2011-2013 The Brenwill Workshop Ltd. All rights reserved.
+ * http://www.brenwill.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * http://en.wikipedia.org/wiki/MIT_License
+ */
+
+/** @file */	// Doxygen marker
+
+
+#import "CC3Texture.h"
+
+
+#pragma mark -
+#pragma mark CC3TextureUploader
+
+/**
+ * CC3TextureUploader defines the behaviour of an object that can submit decoded texture
+ * content to the GL engine on behalf of a CC3TextureLoader.
+ *
+ * All content passed to an uploader is in 32-bit RGBA format, with premultiplied alpha.
+ * The methods of an uploader are only ever invoked from the thread that invokes the
+ * uploadWithinBudget method of the CC3TextureLoader, which should be the GL thread.
+ */
+@protocol CC3TextureUploader <NSObject>
+
+/**
+ * Indicates whether this uploader operates without a GL engine.
+ *
+ * A headless uploader can be used to exercise a CC3TextureLoader without a GL engine,
+ * for example, to record or measure the uploads that would be made.
+ */
+@property(nonatomic, readonly) BOOL isHeadless;
+
+/**
+ * Creates a new GL texture to hold the specified number of mipmap levels, of which level
+ * zero has the specified dimensions, and returns its texture name.
+ */
+-(GLuint) generateTextureNameWithWidth: (GLuint) width
+								height: (GLuint) height
+							levelCount: (GLuint) levelCount;
+
+/**
+ * Submits the specified RGBA content as the specified mipmap level of the GL texture
+ * with the specified name. The content is tightly packed, four bytes per pixel.
+ */
+-(void) uploadLevel: (GLuint) level
+		  ofTexture: (GLuint) texName
+		  withWidth: (GLuint) width
+		  andHeight: (GLuint) height
+			 pixels: (const GLvoid*) pixels;
+
+/**
+ * Invoked once all levels of the GL texture with the specified name have been uploaded,
+ * to allow the texture parameters of the GL texture to be established.
+ */
+-(void) completeTexture: (GLuint) texName withLevelCount: (GLuint) levelCount;
+
+/**
+ * Copies the specified number of mipmap levels, starting at the specified level, from the
+ * GL texture with the specified source name into the levels with the same dimensions in the
+ * GL texture with the specified destination name, and returns whether the levels were copied.
+ *
+ * This allows levels that have already been uploaded to one texture to be used in another,
+ * without submitting their content again. If this uploader cannot copy levels between
+ * textures, this method does nothing and returns NO, and the levels must be uploaded.
+ */
+-(BOOL) copyLevels: (GLuint) levelCount
+		startingAt: (GLuint) srcLevel
+		 ofTexture: (GLuint) srcTexName
+	   intoTexture: (GLuint) dstTexName;
+
+/** Deletes the GL texture with the specified name. */
+-(void) deleteTextureName: (GLuint) texName;
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3TextureLoader
+
+/**
+ * CC3TextureLoader loads texture files into CC3Textures in the background, so that loading
+ * many textures, such as when a level is loaded, does not stall the application.
+ *
+ * Loading a texture file is separated into two stages:
+ *   - The file is decoded into RGBA content by one of several worker threads. If mipmaps
+ *     are to be generated, the mipmap levels are built from the decoded content on the same
+ *     worker thread, rather than by the GL engine.
+ *   - The decoded content is submitted to the GL engine, one mipmap level at a time, by the
+ *     uploadWithinBudget method, which is invoked on the GL thread once per frame. The number
+ *     of bytes submitted on each frame is limited by the uploadBudget property.
+ *
+ * While a texture file is loading, the CC3Textures waiting on it hold the placeholderTexture.
+ * The placeholder does not have the same mapSize as the loaded texture, so when the loaded
+ * texture replaces it, each CC3MeshNode realigns its texture coordinates before it is next
+ * drawn. See the alignmentChangeCount class-side method of CC3Texture. To allow this, the
+ * texture coordinates of meshes that use textures that are loading must not be released
+ * from memory. Invoke the retainVertexTextureCoordinates method on such meshes before
+ * invoking the releaseRedundantData method.
+ *
+ * Loading can be progressive. If a texture is to have a mipmap, the smaller levels of
+ * the mipmap are first uploaded as a separate preview texture, which replaces the placeholder
+ * in the waiting CC3Textures while the full-size levels are uploaded. Preview textures are
+ * uploaded for all textures that are waiting to be uploaded before any full-size texture.
+ * When the full-size texture reaches the levels that were uploaded in the preview, they are
+ * copied from the preview texture by the uploader, instead of being uploaded again. The
+ * default uploader can copy levels if the GL engine supports the APPLE_copy_texture_levels
+ * and EXT_texture_storage extensions, and otherwise uploads those levels again.
+ * See the progressiveLevel property for more information.
+ *
+ * Files in PNG and JPEG format are decoded in the background. Files in other formats, such
+ * as PVR, are loaded through the CCTextureCache by the uploadWithinBudget method, in the
+ * same manner as the loadTextureFile: method of CC3Texture.
+ *
+ * Loading a file that is already being loaded adds the CC3Texture to those waiting on that
+ * file, and loading a file that has already been loaded by this loader shares the loaded
+ * texture, without loading the file again.
+ *
+ * When the CC3Texture class-side property shouldLoadInBackground is set to YES, CC3Texture
+ * loads texture files through the sharedLoader, and CC3Scene invokes the uploadWithinBudget
+ * method of the sharedLoader at the start of each frame.
+ */
+@interface CC3TextureLoader : NSObject {
+	id<CC3TextureUploader> uploader;
+	CCTexture2D* placeholderTexture;
+	NSOperationQueue* decodingQueue;
+	NSMutableDictionary* requestsByPath;
+	NSMutableDictionary* loadedTextures;
+	NSMutableArray* decodedRequests;
+	CCArray* uploadingRequests;
+	GLuint uploadBudget;
+	GLuint progressiveLevel;
+	GLuint bytesUploaded;
+	GLuint levelsUploaded;
+	GLuint texturesLoaded;
+	GLuint previewsLoaded;
+	GLuint lastFrameBytesUploaded;
+}
+
+/**
+ * The uploader used to submit decoded texture content to the GL engine.
+ *
+ * The initial value of this property is an uploader that submits the content to the GL
+ * engine. This property may be set to a headless uploader to operate this loader without
+ * a GL engine. This property should not be changed while textures are being loaded.
+ */
+@property(nonatomic, retain) id<CC3TextureUploader> uploader;
+
+/**
+ * The texture held by each CC3Texture whose file is being loaded, until the texture, or
+ * a preview of the texture, has been uploaded to the GL engine.
+ *
+ * If this property has not been set, it is lazily initialized to a small opaque grey
+ * texture, created through the uploader, the first time it is accessed.
+ */
+@property(nonatomic, retain) CCTexture2D* placeholderTexture;
+
+/**
+ * The maximum number of bytes of texture content to submit to the GL engine on each
+ * invocation of the uploadWithinBudget method.
+ *
+ * A mipmap level is never divided across frames. If the first mipmap level to be submitted
+ * on a frame is larger than this budget, that level alone is submitted on that frame.
+ *
+ * The initial value of this property is 1 MB.
+ */
+@property(nonatomic, assign) GLuint uploadBudget;
+
+/**
+ * The mipmap level at which the preview texture begins, when loading progressively.
+ *
+ * When a texture is to have a mipmap, the levels from this level to the smallest level are
+ * first uploaded as a preview texture. For example, with a value of 2, the preview texture
+ * is one quarter the width and height of the full texture. Setting this property to zero
+ * disables progressive loading, and the placeholderTexture is held until the full texture
+ * has been uploaded.
+ *
+ * Textures without a mipmap, or whose mipmap contains no more than this number of levels,
+ * are not loaded progressively.
+ *
+ * The initial value of this property is 2.
+ */
+@property(nonatomic, assign) GLuint progressiveLevel;
+
+/**
+ * The maximum number of files decoded concurrently by the worker threads.
+ *
+ * The initial value of this property is 2.
+ */
+@property(nonatomic, assign) GLuint maxConcurrentDecodes;
+
+/** The number of files that are being decoded, or whose content is waiting to be uploaded. */
+@property(nonatomic, readonly) GLuint pendingCount;
+
+/** Indicates whether there are no files being decoded or waiting to be uploaded. */
+@property(nonatomic, readonly) BOOL isIdle;
+
+/** The total number of bytes of texture content submitted to the GL engine by this loader. */
+@property(nonatomic, readonly) GLuint bytesUploaded;
+
+/**
+ * The total number of mipmap levels submitted to the GL engine by this loader.
+ *
+ * Levels that are copied from a preview texture into the full-size texture are not included.
+ */
+@property(nonatomic, readonly) GLuint levelsUploaded;
+
+/** The number of textures that have been completely loaded by this loader. */
+@property(nonatomic, readonly) GLuint texturesLoaded;
+
+/** The number of preview textures that have been uploaded while loading progressively. */
+@property(nonatomic, readonly) GLuint previewsLoaded;
+
+/** The number of bytes submitted to the GL engine by the most recent invocation of uploadWithinBudget. */
+@property(nonatomic, readonly) GLuint lastFrameBytesUploaded;
+
+
+#pragma mark Allocation and initialization
+
+/** Allocates and initializes an autoreleased instance. */
++(id) loader;
+
+/**
+ * Returns the loader used by CC3Texture when the CC3Texture class-side property
+ * shouldLoadInBackground is set to YES.
+ *
+ * The shared loader is created lazily when this property is first accessed.
+ */
++(CC3TextureLoader*) sharedLoader;
+
+/** Sets the loader used by CC3Texture when the CC3Texture class-side property shouldLoadInBackground is set to YES. */
++(void) setSharedLoader: (CC3TextureLoader*) aLoader;
+
+/**
+ * Indicates whether the sharedLoader has been created.
+ *
+ * This can be used to avoid creating the shared loader when it is not otherwise being used.
+ */
++(BOOL) hasSharedLoader;
+
+
+#pragma mark Loading
+
+/**
+ * Starts loading the texture file at the specified file path into the specified CC3Texture,
+ * and returns whether the file exists.
+ *
+ * The specified file path may be either an absolute path, or a path relative to the
+ * application resource directory.
+ *
+ * If the file has already been loaded by this loader, the texture property of the
+ * specified CC3Texture is set to the loaded texture immediately. Otherwise, the texture
+ * property of the CC3Texture is set to the placeholderTexture, and is set to the loaded
+ * texture once it has been decoded and uploaded.
+ *
+ * This method must be invoked on the same thread as the uploadWithinBudget method.
+ */
+-(BOOL) loadFile: (NSString*) aFilePath intoTexture: (CC3Texture*) aTexture;
+
+/**
+ * Submits decoded texture content to the GL engine, up to the number of bytes specified by
+ * the uploadBudget property, and sets the texture property of any CC3Textures whose preview
+ * or full-size texture has been completely uploaded.
+ *
+ * This method should be invoked on the GL thread once per frame, and must be invoked on
+ * the same thread as the loadFile:intoTexture: method.
+ */
+-(void) uploadWithinBudget;
+
+/**
+ * Waits for all pending files to be decoded, and submits all of their content to the GL
+ * engine, ignoring the uploadBudget.
+ *
+ * This method can be used when loading time is more important than frame rate, for example,
+ * behind a loading screen. This method must be invoked on the same thread as the
+ * uploadWithinBudget method.
+ */
+-(void) finishLoading;
+
+/** Discards any textures that were loaded by this loader and are retained for sharing. */
+-(void) removeAllLoadedTextures;
+
+@end
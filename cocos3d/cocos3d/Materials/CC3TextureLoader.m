@@ -0,0 +1,724 @@
+/*
+ * CC3TextureLoader.m
+ *
+ * cocos3d 2.0.0
+ * Author: Bill Hollings
+ * Copyright (c) 2011-2013 The Brenwill Workshop Ltd. All rights reserved.
+ * http://www.brenwill.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * http://en.wikipedia.org/wiki/MIT_License
+ * 
+ * See header file CC3TextureLoader.h for full API documentation.
+ */
+
+#import "CC3TextureLoader.h"
+#import "CC3OpenGLESEngine.h"
+#import "CC3CC2Extensions.h"
+
+
+// Whether the GL headers declare the functions needed to copy levels between textures.
+#if defined(GL_APPLE_copy_texture_levels) && defined(GL_EXT_texture_storage)
+#	define CC3_GL_CAN_COPY_TEXTURE_LEVELS	1
+#else
+#	define CC3_GL_CAN_COPY_TEXTURE_LEVELS	0
+#endif
+
+
+#pragma mark -
+#pragma mark CC3TextureLoadRequest
+
+/** A single mipmap level of decoded texture content, held until it is uploaded to the GL engine. */
+typedef struct {
+	GLuint width;			/**< The width of the level, in pixels. */
+	GLuint height;			/**< The height of the level, in pixels. */
+	GLuint byteCount;		/**< The number of bytes of RGBA content in the level. */
+	GLubyte* pixels;		/**< The RGBA content of the level. */
+} CC3TextureStagingLevel;
+
+/**
+ * Populates the specified destination with the RGBA content of the next smaller mipmap level
+ * of the specified source content, by averaging each 2x2 block of source pixels. A dimension
+ * that is already a single pixel is not reduced.
+ */
+static void CC3TextureDownsampleLevel(const GLubyte* restrict src, GLuint srcWidth, GLuint srcHeight,
+									  GLubyte* restrict dst) {
+	GLuint dstWidth = (srcWidth > 1) ? (srcWidth >> 1) : 1;
+	GLuint dstHeight = (srcHeight > 1) ? (srcHeight >> 1) : 1;
+	GLuint colStep = (srcWidth > 1) ? 4 : 0;
+	GLuint rowStep = (srcHeight > 1) ? (srcWidth << 2) : 0;
+	for (GLuint y = 0; y < dstHeight; y++) {
+		const GLubyte* srcRow = src + ((y << 1) * (srcWidth << 2));
+		for (GLuint x = 0; x < dstWidth; x++) {
+			const GLubyte* s = srcRow + (x << 3);
+			for (GLuint c = 0; c < 4; c++)
+				*dst++ = (GLubyte)((s[c] + s[c + colStep] + s[c + rowStep] + s[c + rowStep + colStep] + 2) >> 2);
+		}
+	}
+}
+
+/**
+ * Tracks the loading of a single texture file, on behalf of the CC3Textures that are waiting
+ * on it. The file is decoded, and the mipmap levels are built, by the decode method on a worker
+ * thread. The remaining methods are only invoked on the thread that uploads the content.
+ *
+ * When loading progressively, the upload is divided into two stages, each uploading a separate
+ * GL texture. The preview stage uploads the levels from the progressive level down, and the
+ * final stage uploads the larger levels, and then copies the levels already uploaded in the
+ * preview stage from the preview texture, if the uploader can copy them.
+ */
+@interface CC3TextureLoadRequest : NSObject {
+	CC3TextureLoader* loader;				// Weak reference
+	NSString* filePath;
+	CCArray* textures;
+	CCTexture2D* previewTexture;
+	CC3TextureStagingLevel* levels;
+	GLuint levelCount;
+	GLuint firstStageLevel;
+	GLuint nextLevel;
+	GLuint previewLevel;
+	GLuint stageTextureName;
+	GLuint fileByteCount;
+	CGSize contentSize;
+	BOOL shouldGenerateMipmap : 1;
+	BOOL wasDecoded : 1;
+}
+@property(nonatomic, readonly) NSString* filePath;
+@property(nonatomic, readonly) CCArray* textures;
+@property(nonatomic, readonly) CCTexture2D* previewTexture;
+@property(nonatomic, readonly) BOOL wasDecoded;
+@property(nonatomic, readonly) BOOL isPreviewStage;
+@property(nonatomic, readonly) BOOL isStageComplete;
+@property(nonatomic, readonly) GLuint nextLevelByteCount;
+@property(nonatomic, readonly) GLuint fileByteCount;
+-(id) initForFile: (NSString*) absFilePath forLoader: (CC3TextureLoader*) aLoader withMipmap: (BOOL) shouldMipmap;
++(id) requestForFile: (NSString*) absFilePath forLoader: (CC3TextureLoader*) aLoader withMipmap: (BOOL) shouldMipmap;
+-(void) decode;
+-(void) beginUploadingFromLevel: (GLuint) progressiveLevel;
+-(BOOL) uploadNextLevelWith: (id<CC3TextureUploader>) uploader;
+-(CCTexture2D*) completeStageWith: (id<CC3TextureUploader>) uploader;
+-(CCTexture2D*) loadSynchronously;
+-(void) discardStageWith: (id<CC3TextureUploader>) uploader;
+@end
+
+@interface CC3TextureLoader (TemplateMethods)
+-(void) requestWasDecoded: (CC3TextureLoadRequest*) aRequest;
+-(void) collectDecodedRequests;
+-(void) uploadRequestsInPreviewStage: (BOOL) isPreview withinBudget: (GLuint) budget;
+-(BOOL) uploadRequest: (CC3TextureLoadRequest*) aRequest withinBudget: (GLuint) budget;
+-(void) request: (CC3TextureLoadRequest*) aRequest didLoadTexture: (CCTexture2D*) aTexture;
+-(CCTexture2D*) makePlaceholderTexture;
+@end
+
+@interface CC3TextureLoadRequest (TemplateMethods)
+-(BOOL) decodeFile;
+-(BOOL) buildMipmapLevels;
+-(void) freeLevels;
+@end
+
+@implementation CC3TextureLoadRequest
+
+@synthesize filePath, textures, previewTexture, wasDecoded, fileByteCount;
+
+-(void) dealloc {
+	loader = nil;				// not retained
+	[filePath release];
+	[textures release];
+	[previewTexture release];
+	[self freeLevels];
+	[super dealloc];
+}
+
+-(id) initForFile: (NSString*) absFilePath forLoader: (CC3TextureLoader*) aLoader withMipmap: (BOOL) shouldMipmap {
+	if ( (self = [super init]) ) {
+		loader = aLoader;
+		filePath = [absFilePath retain];
+		textures = [[CCArray array] retain];
+		previewTexture = nil;
+		levels = NULL;
+		levelCount = 0;
+		firstStageLevel = 0;
+		nextLevel = 0;
+		previewLevel = 0;
+		stageTextureName = 0;
+		fileByteCount = 0;
+		contentSize = CGSizeZero;
+		shouldGenerateMipmap = shouldMipmap;
+		wasDecoded = NO;
+	}
+	return self;
+}
+
++(id) requestForFile: (NSString*) absFilePath forLoader: (CC3TextureLoader*) aLoader withMipmap: (BOOL) shouldMipmap {
+	return [[[self alloc] initForFile: absFilePath forLoader: aLoader withMipmap: shouldMipmap] autorelease];
+}
+
+-(void) freeLevels {
+	for (GLuint i = 0; i < levelCount; i++) free(levels[i].pixels);
+	free(levels);
+	levels = NULL;
+	levelCount = 0;
+}
+
+-(NSString*) description { return [NSString stringWithFormat: @"%@ for %@", [self class], filePath.lastPathComponent]; }
+
+
+#pragma mark Decoding
+
+/** Invoked on a worker thread. */
+-(void) decode {
+	NSAutoreleasePool* pool = [NSAutoreleasePool new];
+	fileByteCount = [[[NSFileManager defaultManager] attributesOfItemAtPath: filePath error: NULL] fileSize];
+	wasDecoded = [self decodeFile];
+	[loader requestWasDecoded: self];
+	[pool drain];
+}
+
+/**
+ * Decodes the PNG or JPEG file into RGBA content with premultiplied alpha, padded to
+ * power-of-two dimensions, and builds the remaining mipmap levels if needed. The image
+ * occupies the first rows of the content, as with CCTexture2D, so the texture is flipped
+ * vertically. Returns NO if the file is not in a format that can be decoded here.
+ */
+-(BOOL) decodeFile {
+	NSString* fileExt = filePath.pathExtension.lowercaseString;
+	BOOL isPNG = [fileExt isEqualToString: @"png"];
+	BOOL isJPEG = [fileExt isEqualToString: @"jpg"] || [fileExt isEqualToString: @"jpeg"];
+	if ( !(isPNG || isJPEG) ) return NO;
+
+	CGDataProviderRef provider = CGDataProviderCreateWithFilename(filePath.fileSystemRepresentation);
+	if ( !provider ) return NO;
+	CGImageRef image = (isPNG
+						? CGImageCreateWithPNGDataProvider(provider, NULL, false, kCGRenderingIntentDefault)
+						: CGImageCreateWithJPEGDataProvider(provider, NULL, false, kCGRenderingIntentDefault));
+	CGDataProviderRelease(provider);
+	if ( !image ) return NO;
+
+	GLuint imgWidth = CGImageGetWidth(image);
+	GLuint imgHeight = CGImageGetHeight(image);
+	contentSize = CGSizeMake(imgWidth, imgHeight);
+
+	levels = calloc(1, sizeof(CC3TextureStagingLevel));
+	if ( !levels ) {
+		CGImageRelease(image);
+		return NO;
+	}
+	levelCount = 1;
+	CC3TextureStagingLevel* lvl = levels;
+	lvl->width = ccNextPOT(imgWidth);
+	lvl->height = ccNextPOT(imgHeight);
+	lvl->byteCount = lvl->width * lvl->height * 4;
+	lvl->pixels = calloc(lvl->byteCount, 1);
+
+	CGContextRef context = NULL;
+	if (lvl->pixels) {
+		CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+		context = CGBitmapContextCreate(lvl->pixels, lvl->width, lvl->height, 8, lvl->width * 4, colorSpace,
+										kCGImageAlphaPremultipliedLast | kCGBitmapByteOrder32Big);
+		CGColorSpaceRelease(colorSpace);
+	}
+	if (context) {
+		CGContextTranslateCTM(context, 0, lvl->height - imgHeight);
+		CGContextDrawImage(context, CGRectMake(0, 0, imgWidth, imgHeight), image);
+		CGContextRelease(context);
+	}
+	CGImageRelease(image);
+
+	if ( !context ) {
+		LogError(@"%@ could not allocate %u bytes to decode texture content", self, lvl->byteCount);
+		[self freeLevels];
+		return NO;
+	}
+	if (shouldGenerateMipmap && ![self buildMipmapLevels]) {
+		[self freeLevels];
+		return NO;
+	}
+	return YES;
+}
+
+/** Builds each successively smaller mipmap level from the previous level, down to a single pixel. */
+-(BOOL) buildMipmapLevels {
+	GLuint mmCount = 1;
+	for (GLuint w = levels[0].width, h = levels[0].height; w > 1 || h > 1; w >>= 1, h >>= 1) mmCount++;
+
+	CC3TextureStagingLevel* mmLevels = realloc(levels, mmCount * sizeof(CC3TextureStagingLevel));
+	if ( !mmLevels ) return NO;
+	levels = mmLevels;
+
+	for (GLuint i = 1; i < mmCount; i++) {
+		CC3TextureStagingLevel* prev = levels + (i - 1);
+		CC3TextureStagingLevel* lvl = levels + i;
+		lvl->width = MAX(prev->width >> 1, 1);
+		lvl->height = MAX(prev->height >> 1, 1);
+		lvl->byteCount = lvl->width * lvl->height * 4;
+		lvl->pixels = malloc(lvl->byteCount);
+		if ( !lvl->pixels ) return NO;
+		levelCount = i + 1;
+		CC3TextureDownsampleLevel(prev->pixels, prev->width, prev->height, lvl->pixels);
+	}
+	return YES;
+}
+
+
+#pragma mark Uploading
+
+-(void) beginUploadingFromLevel: (GLuint) progressiveLevel {
+	firstStageLevel = (progressiveLevel && levelCount > progressiveLevel) ? progressiveLevel : 0;
+	nextLevel = firstStageLevel;
+}
+
+-(BOOL) isPreviewStage { return firstStageLevel > 0; }
+
+-(BOOL) isStageComplete { return nextLevel >= levelCount; }
+
+-(GLuint) nextLevelByteCount { return self.isStageComplete ? 0 : levels[nextLevel].byteCount; }
+
+/**
+ * Uploads the next level of the current stage and returns YES. If the final stage has reached
+ * the levels that were uploaded in the preview stage, and the uploader can copy them from the
+ * preview texture, they are copied instead, completing the stage, and NO is returned.
+ */
+-(BOOL) uploadNextLevelWith: (id<CC3TextureUploader>) uploader {
+	if ( !stageTextureName ) {
+		CC3TextureStagingLevel* firstLvl = levels + firstStageLevel;
+		stageTextureName = [uploader generateTextureNameWithWidth: firstLvl->width
+														   height: firstLvl->height
+													   levelCount: (levelCount - firstStageLevel)];
+	}
+	if (previewLevel && nextLevel == previewLevel &&
+		[uploader copyLevels: (levelCount - previewLevel)
+				  startingAt: 0
+				   ofTexture: previewTexture.name
+				 intoTexture: stageTextureName]) {
+		nextLevel = levelCount;
+		return NO;
+	}
+	CC3TextureStagingLevel* lvl = levels + nextLevel;
+	[uploader uploadLevel: (nextLevel - firstStageLevel)
+				ofTexture: stageTextureName
+				withWidth: lvl->width
+				andHeight: lvl->height
+				   pixels: lvl->pixels];
+	nextLevel++;
+	return YES;
+}
+
+/**
+ * Wraps the GL texture of the current stage in a CC3Texture2D and returns it. If the current
+ * stage is the preview stage, the final stage is started, and the preview texture is retained
+ * so that it can be shared with CC3Textures that subsequently wait on this request. Otherwise,
+ * the decoded content is no longer needed, and is released.
+ */
+-(CCTexture2D*) completeStageWith: (id<CC3TextureUploader>) uploader {
+	GLuint stageLevelCount = levelCount - firstStageLevel;
+	[uploader completeTexture: stageTextureName withLevelCount: stageLevelCount];
+
+	CC3TextureStagingLevel* lvl = levels + firstStageLevel;
+	CGSize stageSize = CGSizeMake(contentSize.width * lvl->width / levels[0].width,
+								  contentSize.height * lvl->height / levels[0].height);
+	CCTexture2D* tex = [[[CC3Texture2D alloc] initWithTextureName: stageTextureName
+													   pixelsWide: lvl->width
+													   pixelsHigh: lvl->height
+													  contentSize: stageSize
+														hasMipmap: (stageLevelCount > 1)] autorelease];
+	stageTextureName = 0;
+
+	if (self.isPreviewStage) {
+		[previewTexture release];
+		previewTexture = [tex retain];
+		previewLevel = firstStageLevel;
+		firstStageLevel = 0;
+		nextLevel = 0;
+	} else {
+		[previewTexture release];
+		previewTexture = nil;
+		previewLevel = 0;
+		[self freeLevels];
+	}
+	return tex;
+}
+
+/** Loads a file that could not be decoded in the background through the CCTextureCache. */
+-(CCTexture2D*) loadSynchronously {
+	CCTexture2D.instantiationClass = CC3Texture2D.class;
+	CCTexture2D* tex = [[CCTextureCache sharedTextureCache] addImage: filePath];
+	CCTexture2D.instantiationClass = nil;
+	if (shouldGenerateMipmap) [tex cc3GenerateMipmapIfNeeded];
+	return tex;
+}
+
+-(void) discardStageWith: (id<CC3TextureUploader>) uploader {
+	if (stageTextureName) [uploader deleteTextureName: stageTextureName];
+	stageTextureName = 0;
+}
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3GLTextureUploader
+
+/**
+ * The default CC3TextureUploader, which submits texture content to the GL engine.
+ *
+ * If the GL engine supports copying levels between textures, each texture is allocated
+ * with immutable storage for all of its levels when it is created, as required by the
+ * APPLE_copy_texture_levels extension, and each level is then uploaded into that storage.
+ */
+@interface CC3GLTextureUploader : NSObject <CC3TextureUploader> {
+	BOOL hasCheckedExtensions : 1;
+	BOOL canCopyLevels : 1;
+}
++(id) uploader;
+@end
+
+@implementation CC3GLTextureUploader
+
++(id) uploader { return [[[self alloc] init] autorelease]; }
+
+-(id) init {
+	if ( (self = [super init]) ) {
+		hasCheckedExtensions = NO;
+		canCopyLevels = NO;
+	}
+	return self;
+}
+
+-(BOOL) isHeadless { return NO; }
+
+/** Checks the GL extensions lazily, because a GL context may not be current when this instance is created. */
+-(BOOL) canCopyLevels {
+	if ( !hasCheckedExtensions ) {
+		const char* glExts = (const char*)glGetString(GL_EXTENSIONS);
+		canCopyLevels = (CC3_GL_CAN_COPY_TEXTURE_LEVELS && glExts &&
+						 strstr(glExts, "GL_APPLE_copy_texture_levels") &&
+						 strstr(glExts, "GL_EXT_texture_storage"));
+		hasCheckedExtensions = YES;
+		LogTrace(@"%@ %@ copy texture levels", self, (canCopyLevels ? @"can" : @"cannot"));
+	}
+	return canCopyLevels;
+}
+
+/** Binds through the state tracker of the first texture unit, to keep the tracker synchronized. */
+-(void) bindTexture: (GLuint) texName {
+	[CC3OpenGLESEngine.engine.textures textureUnitAt: 0].textureBinding.value = texName;
+}
+
+-(GLuint) generateTextureNameWithWidth: (GLuint) width
+								height: (GLuint) height
+							levelCount: (GLuint) levelCount {
+	GLuint texName = 0;
+	glGenTextures(1, &texName);
+#if CC3_GL_CAN_COPY_TEXTURE_LEVELS
+	if (self.canCopyLevels) {
+		[self bindTexture: texName];
+		glTexStorage2DEXT(GL_TEXTURE_2D, levelCount, GL_RGBA8_OES, width, height);
+		LogGLErrorState(@"allocating %u levels of texture %u", levelCount, texName);
+	}
+#endif
+	return texName;
+}
+
+-(void) uploadLevel: (GLuint) level
+		  ofTexture: (GLuint) texName
+		  withWidth: (GLuint) width
+		  andHeight: (GLuint) height
+			 pixels: (const GLvoid*) pixels {
+	[self bindTexture: texName];
+	if (self.canCopyLevels) {
+		glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+	} else {
+		glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+	}
+	LogGLErrorState(@"uploading level %u of texture %u", level, texName);
+}
+
+-(BOOL) copyLevels: (GLuint) levelCount
+		startingAt: (GLuint) srcLevel
+		 ofTexture: (GLuint) srcTexName
+	   intoTexture: (GLuint) dstTexName {
+#if CC3_GL_CAN_COPY_TEXTURE_LEVELS
+	if ( !self.canCopyLevels ) return NO;
+	glCopyTextureLevelsAPPLE(dstTexName, srcTexName, srcLevel, levelCount);
+	LogGLErrorState(@"copying %u levels of texture %u into texture %u", levelCount, srcTexName, dstTexName);
+	return YES;
+#else
+	return NO;
+#endif
+}
+
+-(void) completeTexture: (GLuint) texName withLevelCount: (GLuint) levelCount {
+	[self bindTexture: texName];
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, ((levelCount > 1) ? GL_LINEAR_MIPMAP_NEAREST : GL_LINEAR));
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+}
+
+-(void) deleteTextureName: (GLuint) texName { glDeleteTextures(1, &texName); }
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3TextureLoader
+
+@implementation CC3TextureLoader
+
+@synthesize uploader, uploadBudget, progressiveLevel;
+@synthesize bytesUploaded, levelsUploaded, texturesLoaded, previewsLoaded, lastFrameBytesUploaded;
+
+-(void) dealloc {
+	[decodingQueue cancelAllOperations];
+	[decodingQueue waitUntilAllOperationsAreFinished];
+	for (CC3TextureLoadRequest* req in uploadingRequests) [req discardStageWith: uploader];
+	[decodingQueue release];
+	[requestsByPath release];
+	[loadedTextures release];
+	[decodedRequests release];
+	[uploadingRequests release];
+	[placeholderTexture release];
+	[uploader release];
+	[super dealloc];
+}
+
+-(CCTexture2D*) placeholderTexture {
+	if ( !placeholderTexture ) placeholderTexture = [[self makePlaceholderTexture] retain];
+	return placeholderTexture;
+}
+
+-(void) setPlaceholderTexture: (CCTexture2D*) aTexture {
+	if (aTexture == placeholderTexture) return;
+	[placeholderTexture release];
+	placeholderTexture = [aTexture retain];
+}
+
+/** Creates a 2x2 opaque grey texture through the uploader. */
+-(CCTexture2D*) makePlaceholderTexture {
+	GLubyte pixels[2 * 2 * 4];
+	memset(pixels, 0x80, sizeof(pixels));
+	for (GLuint i = 3; i < sizeof(pixels); i += 4) pixels[i] = 0xFF;
+
+	GLuint texName = [uploader generateTextureNameWithWidth: 2 height: 2 levelCount: 1];
+	[uploader uploadLevel: 0 ofTexture: texName withWidth: 2 andHeight: 2 pixels: pixels];
+	[uploader completeTexture: texName withLevelCount: 1];
+	return [[[CC3Texture2D alloc] initWithTextureName: texName
+										   pixelsWide: 2
+										   pixelsHigh: 2
+										  contentSize: CGSizeMake(2, 2)
+											hasMipmap: NO] autorelease];
+}
+
+-(GLuint) maxConcurrentDecodes { return decodingQueue.maxConcurrentOperationCount; }
+
+-(void) setMaxConcurrentDecodes: (GLuint) maxDecodes {
+	decodingQueue.maxConcurrentOperationCount = MAX(maxDecodes, 1);
+}
+
+-(GLuint) pendingCount { return requestsByPath.count; }
+
+-(BOOL) isIdle { return (requestsByPath.count == 0); }
+
+
+#pragma mark Allocation and initialization
+
+-(id) init {
+	if ( (self = [super init]) ) {
+		uploader = [[CC3GLTextureUploader uploader] retain];
+		placeholderTexture = nil;
+		decodingQueue = [NSOperationQueue new];
+		decodingQueue.maxConcurrentOperationCount = 2;
+		requestsByPath = [NSMutableDictionary new];
+		loadedTextures = [NSMutableDictionary new];
+		decodedRequests = [NSMutableArray new];
+		uploadingRequests = [[CCArray array] retain];
+		uploadBudget = 1024 * 1024;
+		progressiveLevel = 2;
+		bytesUploaded = 0;
+		levelsUploaded = 0;
+		texturesLoaded = 0;
+		previewsLoaded = 0;
+		lastFrameBytesUploaded = 0;
+	}
+	return self;
+}
+
++(id) loader { return [[[self alloc] init] autorelease]; }
+
+static CC3TextureLoader* _sharedLoader = nil;
+
++(CC3TextureLoader*) sharedLoader {
+	if ( !_sharedLoader ) _sharedLoader = [CC3TextureLoader new];		// retained
+	return _sharedLoader;
+}
+
++(void) setSharedLoader: (CC3TextureLoader*) aLoader {
+	if (aLoader == _sharedLoader) return;
+	[_sharedLoader release];
+	_sharedLoader = [aLoader retain];
+}
+
++(BOOL) hasSharedLoader { return (_sharedLoader != nil); }
+
+-(NSString*) description {
+	return [NSString stringWithFormat: @"%@ with %u pending textures", [self class], self.pendingCount];
+}
+
+
+#pragma mark Loading
+
+-(BOOL) loadFile: (NSString*) aFilePath intoTexture: (CC3Texture*) aTexture {
+	NSString* absFilePath = CC3EnsureAbsoluteFilePath(aFilePath);
+
+	CCTexture2D* loadedTex = [loadedTextures objectForKey: absFilePath];
+	if (loadedTex) {
+		aTexture.texture = loadedTex;
+		return YES;
+	}
+
+	CC3TextureLoadRequest* req = [requestsByPath objectForKey: absFilePath];
+	if ( !req ) {
+		if ( ![[NSFileManager defaultManager] fileExistsAtPath: absFilePath] ) {
+			LogError(@"%@ could not find texture file %@", self, absFilePath);
+			return NO;
+		}
+		req = [CC3TextureLoadRequest requestForFile: absFilePath
+										  forLoader: self
+										 withMipmap: CC3Texture.shouldGenerateMipmaps];
+		[requestsByPath setObject: req forKey: absFilePath];
+
+		NSInvocationOperation* decodeOp = [[NSInvocationOperation alloc] initWithTarget: req
+																			   selector: @selector(decode)
+																				 object: nil];
+		[decodingQueue addOperation: decodeOp];
+		[decodeOp release];
+		LogTrace(@"%@ started loading %@", self, req);
+	}
+	[req.textures addObject: aTexture];
+	aTexture.texture = req.previewTexture ? req.previewTexture : self.placeholderTexture;
+	return YES;
+}
+
+/** Invoked on a worker thread when the specified request has been decoded. */
+-(void) requestWasDecoded: (CC3TextureLoadRequest*) aRequest {
+	@synchronized(decodedRequests) {
+		[decodedRequests addObject: aRequest];
+	}
+}
+
+/** Moves the requests that have been decoded by the worker threads to the list of requests to upload. */
+-(void) collectDecodedRequests {
+	@synchronized(decodedRequests) {
+		for (CC3TextureLoadRequest* req in decodedRequests) {
+			[req beginUploadingFromLevel: progressiveLevel];
+			[uploadingRequests addObject: req];
+		}
+		[decodedRequests removeAllObjects];
+	}
+}
+
+-(void) uploadWithinBudget {
+	lastFrameBytesUploaded = 0;
+	[self collectDecodedRequests];
+	if (uploadingRequests.count == 0) return;
+
+	[self uploadRequestsInPreviewStage: YES withinBudget: uploadBudget];
+	[self uploadRequestsInPreviewStage: NO withinBudget: uploadBudget];
+
+	bytesUploaded += lastFrameBytesUploaded;
+	LogTrace(@"%@ uploaded %u bytes", self, lastFrameBytesUploaded);
+}
+
+/**
+ * Uploads the requests that are in the specified stage, in the order in which they were
+ * decoded, stopping when the budget has been used.
+ */
+-(void) uploadRequestsInPreviewStage: (BOOL) isPreview withinBudget: (GLuint) budget {
+	GLuint reqIdx = 0;
+	while (reqIdx < uploadingRequests.count) {
+		CC3TextureLoadRequest* req = [uploadingRequests objectAtIndex: reqIdx];
+		if ( (req.wasDecoded && req.isPreviewStage) != isPreview ) {
+			reqIdx++;
+			continue;
+		}
+		[[req retain] autorelease];		// Survive removal from the uploading requests
+		if ( ![self uploadRequest: req withinBudget: budget] ) return;
+		if ([uploadingRequests indexOfObjectIdenticalTo: req] == reqIdx) reqIdx++;
+	}
+}
+
+/**
+ * Uploads as many levels of the current stage of the specified request as the budget allows,
+ * and completes the stage if all of its levels have been uploaded. At least one level is
+ * uploaded on each frame. Returns whether the budget remains available for further requests.
+ */
+-(BOOL) uploadRequest: (CC3TextureLoadRequest*) aRequest withinBudget: (GLuint) budget {
+	if ( !aRequest.wasDecoded ) {
+		GLuint fileBytes = aRequest.fileByteCount;
+		if (lastFrameBytesUploaded && (lastFrameBytesUploaded + fileBytes > budget)) return NO;
+		lastFrameBytesUploaded += fileBytes;
+		CCTexture2D* tex = uploader.isHeadless ? nil : [aRequest loadSynchronously];
+		if ( !tex ) LogError(@"%@ could not load texture file %@", self, aRequest.filePath);
+		[self request: aRequest didLoadTexture: tex];
+		return YES;
+	}
+
+	while ( !aRequest.isStageComplete ) {
+		GLuint levelBytes = aRequest.nextLevelByteCount;
+		if (lastFrameBytesUploaded && (lastFrameBytesUploaded + levelBytes > budget)) return NO;
+		if ( [aRequest uploadNextLevelWith: uploader] ) {
+			lastFrameBytesUploaded += levelBytes;
+			levelsUploaded++;
+		}
+	}
+	[self request: aRequest didLoadTexture: [aRequest completeStageWith: uploader]];
+	return YES;
+}
+
+/**
+ * Sets the specified texture into each CC3Texture waiting on the specified request. If the
+ * texture is the completed full-size texture, it is retained for sharing and the request is
+ * removed. The request may be deallocated by this method.
+ */
+-(void) request: (CC3TextureLoadRequest*) aRequest didLoadTexture: (CCTexture2D*) aTexture {
+	for (CC3Texture* tex in aRequest.textures) tex.texture = aTexture;
+
+	if (aRequest.previewTexture) {
+		previewsLoaded++;
+		LogTrace(@"%@ uploaded preview of %@", self, aRequest);
+		return;
+	}
+
+	texturesLoaded++;
+	if (aTexture) [loadedTextures setObject: aTexture forKey: aRequest.filePath];
+	[uploadingRequests removeObjectIdenticalTo: aRequest];
+	[requestsByPath removeObjectForKey: aRequest.filePath];
+	LogTrace(@"%@ finished loading %@", self, aRequest);
+}
+
+-(void) finishLoading {
+	[decodingQueue waitUntilAllOperationsAreFinished];
+	GLuint budget = uploadBudget;
+	uploadBudget = kCC3MaxGLuint;
+	[self uploadWithinBudget];
+	uploadBudget = budget;
+}
+
+-(void) removeAllLoadedTextures { [loadedTextures removeAllObjects]; }
+
+@end
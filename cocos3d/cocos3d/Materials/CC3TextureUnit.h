@@ -197,11 +197,9 @@ typedef enum {
  * Template method that binds the configuration of this texture unit to the
  * specified GL texture unit.
  *
- * This implementation simply sets the combining function to the default value of
- * GL_MODULATE, and sets the texture constant color to that of the constantColor
- * property. This is the same functionality provided by the unbindFrom: method when
- * no texture unit configuration is present. Subclasses will override to provide
- * more interesting combining techniques.
+ * This implementation populates a CC3DrawTextureBinding using the
+ * populateDrawTextureBinding: method, and applies the texture environment of
+ * that binding to the specified GL texture unit.
  *
  * The visitor provides additional configuration information that can be
  * used by subclass overrides of this method.
@@ -209,6 +207,18 @@ typedef enum {
 -(void) bindTo: (CC3OpenGLESTextureUnit*) glesTexUnit
    withVisitor: (CC3NodeDrawingVisitor*) visitor;
 
+/**
+ * Template method that populates the texture environment of the specified texture binding
+ * from the configuration of this texture unit, so that it can be applied when a draw command
+ * is replayed, without messaging this texture unit.
+ *
+ * This implementation simply sets the combining function to the value of the
+ * textureEnvironmentMode property, and sets the texture constant color to that of the
+ * constantColor property. Subclasses will override to provide more interesting
+ * combining techniques.
+ */
+-(void) populateDrawTextureBinding: (CC3DrawTextureBinding*) texBinding;
+
 /**
  * Automatically invoked from CC3Texture when no texture unit configuration is
  * provided in that texture.
@@ -218,6 +228,16 @@ typedef enum {
  */
 +(void) bindDefaultTo: (CC3OpenGLESTextureUnit*) glesTexUnit;
 
+/**
+ * Populates the texture environment of the specified texture binding with the default
+ * combining function of GL_MODULATE, and the default texture constant color of
+ * kCCC4FBlackTransparent.
+ *
+ * Automatically invoked from CC3Texture when no texture unit configuration is
+ * provided in that texture.
+ */
++(void) populateDefaultDrawTextureBinding: (CC3DrawTextureBinding*) texBinding;
+
 @end
 
 
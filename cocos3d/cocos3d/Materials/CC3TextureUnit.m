@@ -153,13 +153,28 @@
 #pragma mark Drawing
 
 -(void) bindTo: (CC3OpenGLESTextureUnit*) glesTexUnit withVisitor: (CC3NodeDrawingVisitor*) visitor {
-	glesTexUnit.textureEnvironmentMode.value = textureEnvironmentMode;
-	glesTexUnit.color.value = constantColor;
+	CC3DrawTextureBinding texBinding;
+	[self populateDrawTextureBinding: &texBinding];
+	CC3DrawTextureBindingApplyEnvironment(&texBinding, glesTexUnit);
+	LogTrace(@"%@ bound to %@", self, glesTexUnit);
+}
+
+-(void) populateDrawTextureBinding: (CC3DrawTextureBinding*) texBinding {
+	texBinding->environmentMode = textureEnvironmentMode;
+	texBinding->constantColor = constantColor;
+	texBinding->isCombining = NO;
 }
 
 +(void) bindDefaultTo: (CC3OpenGLESTextureUnit*) glesTexUnit {
-	glesTexUnit.textureEnvironmentMode.value = GL_MODULATE;
-	glesTexUnit.color.value = kCCC4FBlackTransparent;
+	CC3DrawTextureBinding texBinding;
+	[self populateDefaultDrawTextureBinding: &texBinding];
+	CC3DrawTextureBindingApplyEnvironment(&texBinding, glesTexUnit);
+}
+
++(void) populateDefaultDrawTextureBinding: (CC3DrawTextureBinding*) texBinding {
+	texBinding->environmentMode = GL_MODULATE;
+	texBinding->constantColor = kCCC4FBlackTransparent;
+	texBinding->isCombining = NO;
 }
 
 @end
@@ -241,25 +256,24 @@
 
 #pragma mark Drawing
 
--(void) bindTo: (CC3OpenGLESTextureUnit*) glesTexUnit withVisitor: (CC3NodeDrawingVisitor*) visitor {
-	[super bindTo: glesTexUnit withVisitor: visitor];
+-(void) populateDrawTextureBinding: (CC3DrawTextureBinding*) texBinding {
+	[super populateDrawTextureBinding: texBinding];
 	
-	glesTexUnit.combineRGBFunction.value = combineRGBFunction;
-	glesTexUnit.rgbSource0.value = rgbSource0;
-	glesTexUnit.rgbSource1.value = rgbSource1;
-	glesTexUnit.rgbSource2.value = rgbSource2;
-	glesTexUnit.rgbOperand0.value = rgbOperand0;
-	glesTexUnit.rgbOperand1.value = rgbOperand1;
-	glesTexUnit.rgbOperand2.value = rgbOperand2;
-	glesTexUnit.combineAlphaFunction.value = combineAlphaFunction;
-	glesTexUnit.alphaSource0.value = alphaSource0;
-	glesTexUnit.alphaSource1.value = alphaSource1;
-	glesTexUnit.alphaSource2.value = alphaSource2;
-	glesTexUnit.alphaOperand0.value = alphaOperand0;
-	glesTexUnit.alphaOperand1.value = alphaOperand1;
-	glesTexUnit.alphaOperand2.value = alphaOperand2;
-	
-	LogTrace(@"%@ bound to %@", self, glesTexUnit);
+	texBinding->isCombining = YES;
+	texBinding->combineRGBFunction = combineRGBFunction;
+	texBinding->rgbSource0 = rgbSource0;
+	texBinding->rgbSource1 = rgbSource1;
+	texBinding->rgbSource2 = rgbSource2;
+	texBinding->rgbOperand0 = rgbOperand0;
+	texBinding->rgbOperand1 = rgbOperand1;
+	texBinding->rgbOperand2 = rgbOperand2;
+	texBinding->combineAlphaFunction = combineAlphaFunction;
+	texBinding->alphaSource0 = alphaSource0;
+	texBinding->alphaSource1 = alphaSource1;
+	texBinding->alphaSource2 = alphaSource2;
+	texBinding->alphaOperand0 = alphaOperand0;
+	texBinding->alphaOperand1 = alphaOperand1;
+	texBinding->alphaOperand2 = alphaOperand2;
 }
 
 @end
@@ -275,21 +289,25 @@
 
 #pragma mark Drawing
 
--(void) bindTo: (CC3OpenGLESTextureUnit*) glesTexUnit withVisitor: (CC3NodeDrawingVisitor*) visitor {
-	glesTexUnit.textureEnvironmentMode.value = GL_COMBINE;
-	glesTexUnit.combineRGBFunction.value = GL_DOT3_RGB;
-	glesTexUnit.rgbSource0.value = GL_TEXTURE;
-	glesTexUnit.rgbSource1.value = GL_CONSTANT;
-	glesTexUnit.rgbOperand0.value = GL_SRC_COLOR;
-	glesTexUnit.rgbOperand1.value = GL_SRC_COLOR;
-	glesTexUnit.combineAlphaFunction.value = GL_MODULATE;
-	glesTexUnit.alphaSource0.value = GL_TEXTURE;
-	glesTexUnit.alphaSource1.value = GL_CONSTANT;
-	glesTexUnit.alphaOperand0.value = GL_SRC_ALPHA;
-	glesTexUnit.alphaOperand1.value = GL_SRC_ALPHA;
-	glesTexUnit.color.value = constantColor;
-	
-	LogTrace(@"%@ bound to %@", self, glesTexUnit);
+/** The third combiner sources and operands are not used by GL_DOT3_RGB, and are left at their defaults. */
+-(void) populateDrawTextureBinding: (CC3DrawTextureBinding*) texBinding {
+	texBinding->environmentMode = GL_COMBINE;
+	texBinding->constantColor = constantColor;
+	texBinding->isCombining = YES;
+	texBinding->combineRGBFunction = GL_DOT3_RGB;
+	texBinding->rgbSource0 = GL_TEXTURE;
+	texBinding->rgbSource1 = GL_CONSTANT;
+	texBinding->rgbSource2 = GL_CONSTANT;
+	texBinding->rgbOperand0 = GL_SRC_COLOR;
+	texBinding->rgbOperand1 = GL_SRC_COLOR;
+	texBinding->rgbOperand2 = GL_SRC_ALPHA;
+	texBinding->combineAlphaFunction = GL_MODULATE;
+	texBinding->alphaSource0 = GL_TEXTURE;
+	texBinding->alphaSource1 = GL_CONSTANT;
+	texBinding->alphaSource2 = GL_CONSTANT;
+	texBinding->alphaOperand0 = GL_SRC_ALPHA;
+	texBinding->alphaOperand1 = GL_SRC_ALPHA;
+	texBinding->alphaOperand2 = GL_SRC_ALPHA;
 }
 
 @end
\ No newline at end of file
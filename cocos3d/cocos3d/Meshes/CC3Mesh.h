@@ -355,6 +355,33 @@ static inline CC3MeshIntersection* CC3NearestMeshIntersection(CC3MeshIntersectio
  */
 @property(nonatomic, assign) CC3VertexContent vertexContentTypes;
 
+/**
+ * Returns whether the vertex locations of this mesh are stored in a quantized form, that must
+ * be converted to mesh coordinates by the transform returned by populateVertexLocationUnpackMatrix:.
+ *
+ * This implementation always returns NO. Subclasses that support quantized vertex content,
+ * such as CC3VertexArrayMesh, will override.
+ */
+@property(nonatomic, readonly) BOOL hasQuantizedVertexLocations;
+
+/**
+ * Returns whether the vertex normals of this mesh are stored in a quantized form, and will not
+ * be exactly unit length when submitted to the GL engine.
+ *
+ * This implementation always returns NO. Subclasses that support quantized vertex content,
+ * such as CC3VertexArrayMesh, will override.
+ */
+@property(nonatomic, readonly) BOOL hasQuantizedVertexNormals;
+
+/**
+ * Populates the specified matrix with the transform that converts the vertex locations
+ * submitted to the GL engine to mesh coordinates.
+ *
+ * If the hasQuantizedVertexLocations property returns NO, the matrix is populated as an
+ * identity matrix. The CC3MeshNode that draws this mesh invokes this method automatically.
+ */
+-(void) populateVertexLocationUnpackMatrix: (CC3Matrix4x4*) mtx;
+
 
 /** @deprecated Renamed to ensureVertexCapacity on CC3VertexArrayMesh subclass. */
 -(BOOL) ensureCapacity: (GLuint) vtxCount DEPRECATED_ATTRIBUTE;
@@ -364,6 +391,12 @@ static inline CC3MeshIntersection* CC3NearestMeshIntersection(CC3MeshIntersectio
  *
  * This method may safely be called more than once, or on more than one mesh that shares
  * vertex arrays, since vertex array GL buffers are only created if they don't already exist.
+ *
+ * The vertex content of a mesh may be loaded, built and modified on a background thread,
+ * as long as the mesh is not being drawn while it is being modified. If this method is
+ * invoked from a thread other than the thread that is rendering the scene, the GL buffers
+ * are created when the mesh is next drawn, and any subsequent updates to the GL buffers
+ * are copied to the GL engine as the mesh is drawn.
  */
 -(void) createGLBuffers;
 
@@ -906,6 +939,33 @@ static inline CC3MeshIntersection* CC3NearestMeshIntersection(CC3MeshIntersectio
 		forCount: (GLuint) vertexCount
 	 withVisitor: (CC3NodeDrawingVisitor*) visitor;
 
+/**
+ * Populates the specified draw command with this mesh, its tag and drawing mode, and with the
+ * vertex bindings and draw ranges needed to draw this mesh without consulting it. Populating
+ * the command does not make any GL calls.
+ *
+ * This abstract implementation captures this mesh, its tag, drawing mode and vertex counts,
+ * and sets the shouldDrawLive field of the command, since an abstract mesh cannot capture its
+ * vertex content. Subclasses that can capture their vertex content will override to add
+ * their vertex bindings and draw ranges, and to leave the shouldDrawLive field clear.
+ *
+ * This is invoked automatically from the populateDrawCommand:withVisitor: method of the
+ * CC3MeshNode instance that is using this mesh. Usually, the application never needs to
+ * invoke this method directly.
+ */
+-(void) populateDrawCommand: (CC3DrawCommand*) aCommand withVisitor: (CC3NodeDrawingVisitor*) visitor;
+
+/**
+ * A version number that changes whenever the content captured by the populateDrawCommand:withVisitor:
+ * method changes, such as when vertex arrays are added, removed or rebuffered, or when the vertex
+ * content or drawing mode changes. Draw commands that were populated from this mesh are populated
+ * again when this version changes.
+ *
+ * This abstract implementation always returns zero. Subclasses that capture content will
+ * override to track changes to that content.
+ */
+@property(nonatomic, readonly) GLuint drawingVersion;
+
 /**
  * Returns an allocated, initialized, autorelease instance of the bounding volume to
  * be used by the CC3MeshNode that wraps this mesh. This method is invoked automatically
@@ -1513,9 +1573,22 @@ static inline CC3MeshIntersection* CC3NearestMeshIntersection(CC3MeshIntersectio
  *
  * This is invoked automatically by the CC3Scene at the beginning of each frame drawing cycle.
  * Usually, the application never needs to invoke this method directly.
+ *
+ * Mesh switching tracks the state of the GL engine, and is therefore only reset when this
+ * method is invoked from the rendering thread. Invocations from other threads, such as a
+ * background thread that is building meshes, are ignored.
  */
 +(void) resetSwitching;
 
+/**
+ * Returns whether the mesh with the specified tag is different than the mesh that was most
+ * recently drawn to the GL engine, and records the specified tag as the most recently drawn mesh.
+ *
+ * This is invoked automatically when a draw command is replayed, and by the draw method of each
+ * mesh. Usually, the application never needs to invoke this method directly.
+ */
++(BOOL) switchingToMeshTag: (GLuint) aTag;
+
 @end
 
 
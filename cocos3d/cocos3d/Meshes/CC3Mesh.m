@@ -30,6 +30,7 @@
  */
 
 #import "CC3Mesh.h"
+#import "CC3OpenGLESEngine.h"
 
 @interface CC3Mesh (TemplateMethods)
 -(void) bindGLWithVisitor: (CC3NodeDrawingVisitor*) visitor;
@@ -37,6 +38,7 @@
 -(void) drawVerticesFrom: (GLuint) vertexIndex
 				forCount: (GLuint) vertexCount
 			 withVisitor: (CC3NodeDrawingVisitor*) visitor;
+-(void) populateDrawRange: (CC3DrawRange*) aRange from: (GLuint) vertexIndex forCount: (GLuint) vertexCount;
 -(CC3FaceIndices) uncachedFaceIndicesAt: (GLuint) faceIndex;
 -(BOOL) switchingMesh;
 @end
@@ -124,6 +126,12 @@
 -(BOOL) shouldInterleaveVertices { return NO; }
 -(void) setShouldInterleaveVertices: (BOOL) shouldInterleave {}
 
+-(BOOL) hasQuantizedVertexLocations { return NO; }
+
+-(BOOL) hasQuantizedVertexNormals { return NO; }
+
+-(void) populateVertexLocationUnpackMatrix: (CC3Matrix4x4*) mtx { CC3Matrix4x4PopulateIdentity(mtx); }
+
 -(void) createGLBuffers {}
 
 -(void) deleteGLBuffers {}
@@ -209,7 +217,7 @@
 static GLuint lastAssignedMeshTag;
 
 -(GLuint) nextTag {
-	return ++lastAssignedMeshTag;
+	return CC3IncrementTagCounter(&lastAssignedMeshTag);
 }
 
 +(void) resetTagAllocation {
@@ -243,6 +251,17 @@ static GLuint lastAssignedMeshTag;
 	[self drawVerticesFrom: vertexIndex forCount: vertexCount withVisitor: visitor];
 }
 
+-(void) populateDrawCommand: (CC3DrawCommand*) aCommand withVisitor: (CC3NodeDrawingVisitor*) visitor {
+	aCommand->mesh = self;
+	aCommand->meshTag = tag;
+	aCommand->drawingMode = self.drawingMode;
+	aCommand->vertexCount = self.vertexCount;
+	aCommand->vertexIndexCount = self.vertexIndexCount;
+	aCommand->shouldDrawLive = YES;
+}
+
+-(GLuint) drawingVersion { return 0; }
+
 /**
  * Template method that binds the mesh arrays to the GL engine prior to drawing.
  * The specified visitor encapsulates the frustum of the currently active camera,
@@ -267,6 +286,13 @@ static GLuint lastAssignedMeshTag;
 				forCount: (GLuint) vertexCount
 			 withVisitor: (CC3NodeDrawingVisitor*) visitor {}
 
+/**
+ * Populates the specified draw range to draw a portion of the mesh vertices, in the same
+ * way as the drawVerticesFrom:forCount:withVisitor: method would draw them.
+ * Default implementation does nothing. Subclasses will override.
+ */
+-(void) populateDrawRange: (CC3DrawRange*) aRange from: (GLuint) vertexIndex forCount: (GLuint) vertexCount {}
+
 -(CC3NodeBoundingVolume*) defaultBoundingVolume { return nil; }
 
 
@@ -468,14 +494,17 @@ static GLuint currentMeshTag = 0;
  * This method is invoked automatically by the draw method to test whether this mesh needs
  * to be bound to the GL engine before drawing.
  */
--(BOOL) switchingMesh {
-	BOOL shouldSwitch = currentMeshTag != tag;
-	currentMeshTag = tag;		// Set anyway - either it changes or it doesn't.
+-(BOOL) switchingMesh { return [[self class] switchingToMeshTag: tag]; }
+
++(BOOL) switchingToMeshTag: (GLuint) aTag {
+	BOOL shouldSwitch = currentMeshTag != aTag;
+	currentMeshTag = aTag;		// Set anyway - either it changes or it doesn't.
 	return shouldSwitch;
 }
 
+/** Only the rendering thread draws meshes, so other threads must not disturb the switching state. */
 +(void) resetSwitching {
-	currentMeshTag = 0;
+	if (CC3OpenGLESEngine.isRenderThread) currentMeshTag = 0;
 }
 
 @end
@@ -96,6 +96,9 @@
 	CCArray* overlayTextureCoordinates;
 	CC3VertexIndices* vertexIndices;
 	GLfloat capacityExpansionFactor;
+	GLuint drawingVersion;
+	OSSpinLock glStateLock;					// Guards the deferred creation of the GL buffers
+	BOOL shouldCreateGLBuffersWhenBound;	// Not a bitfield, because it is guarded by glStateLock
 	BOOL shouldInterleaveVertices : 1;
 }
 
@@ -542,6 +545,51 @@
 			 offsettingBy: (GLint) offset;
 
 
+#pragma mark Quantizing vertex content
+
+/**
+ * Converts the vertex content of this mesh to compact quantized forms, reducing both the memory
+ * consumed by the mesh, and the bandwidth required to submit the mesh to the GL engine.
+ *
+ * The content is converted as follows:
+ *   - Vertex locations are converted to 16-bit integers, scaled to the bounding box of the mesh.
+ *     The conversion back to mesh coordinates is folded into the transform applied by the
+ *     CC3MeshNode that draws this mesh. Vertex locations are not quantized in skinned meshes,
+ *     because they are transformed by bone matrices that do not include that conversion.
+ *   - Vertex normals are converted to normalized 8-bit integers.
+ *   - Under OpenGL ES 2, texture coordinates that all lie within the range [0, 1] are converted
+ *     to normalized 16-bit integers. Texture coordinates are left unchanged under OpenGL ES 1.
+ *   - All other vertex content, such as vertex colors, is left unchanged.
+ *
+ * To keep each vertex element four-byte aligned, quantized locations carry a W component of one,
+ * and quantized normals carry a padding byte. A mesh containing locations, normals and texture
+ * coordinates is reduced from 32 to 16 bytes per vertex.
+ *
+ * Accessor methods such as vertexLocationAt:, vertexNormalAt: and vertexTexCoord2FForTextureUnit:at:,
+ * and the methods that depend on them, convert quantized content automatically. Since quantization
+ * loses some precision, this method should be invoked only once, after the mesh has been populated.
+ *
+ * Only the vertices up to the value of the vertexCount property are quantized, and any allocated
+ * capacity beyond that is released. Point particle meshes, whose content is updated dynamically,
+ * are not quantized.
+ *
+ * The vertex content must not have already been released by the releaseRedundantData method. If
+ * GL buffers have already been created for this mesh, they are recreated with the quantized content.
+ * Since the vertex arrays are modified in place, any other meshes that share them are affected too.
+ *
+ * The changes to memory usage are logged at the info level. Returns YES if any vertex content was
+ * quantized, or NO if there was nothing that could be quantized.
+ */
+-(BOOL) quantizeVertexContent;
+
+/**
+ * Returns the number of bytes of memory used by the vertex content of this mesh, excluding
+ * vertex indices. This is also the number of bytes submitted to the GL engine each time all
+ * of the vertices of this mesh are drawn.
+ */
+@property(nonatomic, readonly) GLuint vertexContentByteCount;
+
+
 #pragma mark Updating
 
 /**
@@ -578,7 +626,24 @@
  * The values of the centerOfGeometry and radius properties are automatically calculated
  * from the vertex location data by the buildVolume method of this instance.
  */
-@interface CC3VertexLocationsSphericalBoundingVolume : CC3NodeSphericalBoundingVolume
+@interface CC3VertexLocationsSphericalBoundingVolume : CC3NodeSphericalBoundingVolume {
+	BOOL shouldUseMinimalSphere : 1;
+}
+
+/**
+ * Indicates whether this bounding volume should use a sphere that is close to the smallest
+ * sphere that encompasses all of the vertices, as determined by the minimalBoundingSphere
+ * method of the vertex locations.
+ *
+ * If this property is set to NO, the sphere is centered on the centerOfGeometry of the vertex
+ * locations, which is faster to determine, but can be noticeably larger than necessary for
+ * asymmetric meshes. Setting this property to YES results in tighter culling of the node,
+ * at the cost of an extra pass through the vertices each time the volume is rebuilt.
+ *
+ * The initial value of this property is NO.
+ */
+@property(nonatomic, assign) BOOL shouldUseMinimalSphere;
+
 @end
 
 
@@ -47,6 +47,16 @@
 -(void) bindPointSizesWithVisitor: (CC3NodeDrawingVisitor*) visitor;
 -(void) bindBoneMatrixIndicesWithVisitor: (CC3NodeDrawingVisitor*) visitor;
 -(void) bindBoneWeightsWithVisitor: (CC3NodeDrawingVisitor*) visitor;
+-(void) populateVertexBindingsOf: (CC3DrawCommand*) aCommand withVisitor: (CC3NodeDrawingVisitor*) visitor;
+-(void) addVertexArray: (CC3VertexArray*) vtxArray
+		 toDrawCommand: (CC3DrawCommand*) aCommand
+		   withVisitor: (CC3NodeDrawingVisitor*) visitor;
+-(void) markDrawingChangedFromVertexArray: (CC3VertexArray*) oldArray;
+-(CCArray*) vertexContentArrays;
+-(BOOL) canQuantizeVertexLocations;
+@end
+
+@interface CC3VertexArrayMesh (PendingGLUpdates) <CC3PendingGLUpdateProtocol>
 @end
 
 
@@ -79,6 +89,7 @@
 -(CC3VertexLocations*) vertexLocations { return vertexLocations; }
 
 -(void) setVertexLocations: (CC3VertexLocations*) vtxLocs {
+	[self markDrawingChangedFromVertexArray: vertexLocations];
 	[vertexLocations autorelease];
 	vertexLocations = [vtxLocs retain];
 	[vertexLocations deriveNameFrom: self];
@@ -89,6 +100,7 @@
 -(CC3VertexNormals*) vertexNormals { return vertexNormals; }
 
 -(void) setVertexNormals: (CC3VertexNormals*) vtxNorms {
+	[self markDrawingChangedFromVertexArray: vertexNormals];
 	[vertexNormals autorelease];
 	vertexNormals = [vtxNorms retain];
 	[vertexNormals deriveNameFrom: self];
@@ -99,6 +111,7 @@
 -(CC3VertexColors*) vertexColors { return vertexColors; }
 
 -(void) setVertexColors: (CC3VertexColors*) vtxCols {
+	[self markDrawingChangedFromVertexArray: vertexColors];
 	[vertexColors autorelease];
 	vertexColors = [vtxCols retain];
 	[vertexColors deriveNameFrom: self];
@@ -111,6 +124,7 @@
 -(CC3VertexTextureCoordinates*) vertexTextureCoordinates { return vertexTextureCoordinates; }
 
 -(void) setVertexTextureCoordinates: (CC3VertexTextureCoordinates*) vtxTexCoords {
+	[self markDrawingChangedFromVertexArray: vertexTextureCoordinates];
 	[vertexTextureCoordinates autorelease];
 	vertexTextureCoordinates = [vtxTexCoords retain];
 	[vertexTextureCoordinates deriveNameFrom: self];
@@ -121,6 +135,7 @@
 -(CC3VertexIndices*) vertexIndices { return vertexIndices; }
 
 -(void) setVertexIndices: (CC3VertexIndices*) vtxInd {
+	[self markDrawingChangedFromVertexArray: vertexIndices];
 	[vertexIndices autorelease];
 	vertexIndices = [vtxInd retain];
 	[vertexIndices deriveNameFrom: self];
@@ -185,6 +200,7 @@
 		}
 		[overlayTextureCoordinates addObject: vtxTexCoords];
 		[vtxTexCoords deriveNameFrom: self];
+		[self markDrawingChangedFromVertexArray: nil];
 	}
 }
 
@@ -198,6 +214,9 @@
 		// Otherwise, find it in the array of overlays and remove it,
 		// and remove the overlay array if it is now empty
 		if (overlayTextureCoordinates && aTexCoord) {
+			if ([overlayTextureCoordinates containsObject: aTexCoord]) {
+				[self markDrawingChangedFromVertexArray: aTexCoord];
+			}
 			[overlayTextureCoordinates removeObjectIdenticalTo: aTexCoord];
 			if (overlayTextureCoordinates.count == 0) {
 				[overlayTextureCoordinates release];
@@ -259,6 +278,7 @@
 	if (texUnit == 0) {
 		self.vertexTextureCoordinates = aTexCoords;
 	} else if (texUnit < self.textureCoordinatesArrayCount) {
+		[self markDrawingChangedFromVertexArray: [overlayTextureCoordinates objectAtIndex: (texUnit - 1)]];
 		[overlayTextureCoordinates fastReplaceObjectAtIndex: (texUnit - 1) withObject: aTexCoords];
 	} else {
 		[self addTextureCoordinates: aTexCoords];
@@ -288,8 +308,10 @@
 	[self textureCoordinatesForTextureUnit: texUnit].expectsVerticallyFlippedTextures = expectsFlipped;
 }
 
+/** Texture coordinates whose content has been released from memory cannot be aligned. */
 -(void) alignTextureUnit: (GLuint) texUnit withTexture: (CC3Texture*) aTexture {
-	[[self textureCoordinatesForTextureUnit: texUnit] alignWithTexture: aTexture];
+	CC3VertexTextureCoordinates* texCoords = [self textureCoordinatesForTextureUnit: texUnit];
+	if (texCoords.vertices) [texCoords alignWithTexture: aTexture];
 }
 
 // Deprecated
@@ -379,6 +401,9 @@
 		overlayTextureCoordinates = nil;
 		vertexIndices = nil;
 		capacityExpansionFactor = 1.25;
+		drawingVersion = 0;
+		glStateLock = OS_SPINLOCK_INIT;
+		shouldCreateGLBuffersWhenBound = NO;
 	}
 	return self;
 }
@@ -419,8 +444,24 @@
  * shared across the contained vertex arrays, this method invokes createGLBuffer only on the
  * vertexLocations and vertexIndices vertex arrays, and copies the bufferID property from
  * the vertexLocations vertex array to the other vertex arrays (except vertexIndicies).
+ *
+ * If this method is invoked from a thread other than the rendering thread, this mesh is added
+ * to the queue of pending GL updates of the CC3OpenGLESEngine, and the GL buffers are created
+ * by the rendering thread at the start of the next frame, or when this mesh is next bound to
+ * the GL engine for drawing, whichever comes first. Subclasses that override this method must
+ * return immediately after invoking this superclass implementation from any other thread.
  */
 -(void) createGLBuffers {
+	BOOL isRenderThread = CC3OpenGLESEngine.isRenderThread;
+	OSSpinLockLock(&glStateLock);
+	BOOL shouldQueue = !isRenderThread && !shouldCreateGLBuffersWhenBound;
+	shouldCreateGLBuffersWhenBound = !isRenderThread;
+	OSSpinLockUnlock(&glStateLock);
+	if ( !isRenderThread ) {
+		LogTrace(@"%@ deferring creation of GL server buffers to the rendering thread", self);
+		if (shouldQueue) [CC3OpenGLESEngine queuePendingGLUpdate: self];
+		return;
+	}
 	[vertexLocations createGLBuffer];
 	if (shouldInterleaveVertices) {
 		GLuint commonBufferId = vertexLocations.bufferID;
@@ -442,6 +483,9 @@
 }
 
 -(void) deleteGLBuffers {
+	OSSpinLockLock(&glStateLock);
+	shouldCreateGLBuffersWhenBound = NO;
+	OSSpinLockUnlock(&glStateLock);
 	[vertexLocations deleteGLBuffer];
 	[vertexNormals deleteGLBuffer];
 	[vertexColors deleteGLBuffer];
@@ -452,6 +496,14 @@
 	[vertexIndices deleteGLBuffer];
 }
 
+/** Creates the GL buffers on the render thread, if their creation was requested from another thread. */
+-(void) performPendingGLUpdates {
+	OSSpinLockLock(&glStateLock);
+	BOOL shouldCreate = shouldCreateGLBuffersWhenBound;
+	OSSpinLockUnlock(&glStateLock);
+	if (shouldCreate) [self createGLBuffers];
+}
+
 -(BOOL) isUsingGLBuffers {
 	if (vertexLocations && vertexLocations.isUsingGLBuffer) return YES;
 	if (vertexNormals && vertexNormals.isUsingGLBuffer) return YES;
@@ -543,7 +595,15 @@
 
 -(void) updateGLBuffersStartingAt: (GLuint) offsetIndex forLength: (GLuint) vertexCount {
 	[vertexLocations updateGLBufferStartingAt: offsetIndex forLength: vertexCount];
-	if ( !shouldInterleaveVertices ) {
+	if (shouldInterleaveVertices) {
+		// The vertex locations update covered the interleaved content of the other arrays
+		[vertexNormals markVerticesCleanStartingAt: offsetIndex forLength: vertexCount];
+		[vertexColors markVerticesCleanStartingAt: offsetIndex forLength: vertexCount];
+		[vertexTextureCoordinates markVerticesCleanStartingAt: offsetIndex forLength: vertexCount];
+		for (CC3VertexTextureCoordinates* otc in overlayTextureCoordinates) {
+			[otc markVerticesCleanStartingAt: offsetIndex forLength: vertexCount];
+		}
+	} else {
 		[vertexNormals updateGLBufferStartingAt: offsetIndex forLength: vertexCount];
 		[vertexColors updateGLBufferStartingAt: offsetIndex forLength: vertexCount];
 		[vertexTextureCoordinates updateGLBufferStartingAt: offsetIndex forLength: vertexCount];
@@ -581,8 +641,98 @@
 	vertexLocations.drawingMode = aMode;
 }
 
+/**
+ * The drawing version of this mesh is the sum of its own version and the versions of its
+ * vertex arrays. Whenever a vertex array is replaced or removed, the version of that vertex
+ * array is added to the version of this mesh, so the sum never returns to an earlier value.
+ */
+-(GLuint) drawingVersion {
+	GLuint version = drawingVersion;
+	version += vertexLocations.drawingVersion;
+	version += vertexNormals.drawingVersion;
+	version += vertexColors.drawingVersion;
+	version += vertexTextureCoordinates.drawingVersion;
+	for (CC3VertexTextureCoordinates* otc in overlayTextureCoordinates) version += otc.drawingVersion;
+	version += vertexIndices.drawingVersion;
+	return version;
+}
+
+/** Template method that records that the specified vertex array, which may be nil, is being replaced or removed. */
+-(void) markDrawingChangedFromVertexArray: (CC3VertexArray*) oldArray {
+	CC3AddToChangeCounter(&drawingVersion, oldArray.drawingVersion + 1);
+}
+
+// The number of vertex arrays, other than texture coordinates, that can be bound by a mesh.
+#define kCC3MaxNonTextureVertexBindings 6
+
+/**
+ * If there are no vertex locations, the mesh is left to be drawn live. If the vertex indices
+ * cannot be bound, the mesh is also drawn live, which draws nothing, as it always has.
+ */
+-(void) populateDrawCommand: (CC3DrawCommand*) aCommand withVisitor: (CC3NodeDrawingVisitor*) visitor {
+	[super populateDrawCommand: aCommand withVisitor: visitor];
+	if ( !vertexLocations ) return;
+
+	aCommand->vertexBufferID = vertexLocations.bufferID;
+	aCommand->indexBufferID = vertexIndices.bufferID;
+
+	GLuint maxBindings = kCC3MaxNonTextureVertexBindings + visitor.textureUnitCount;
+	aCommand->vertexBindingsOffset = [visitor.commandList allocateContent: (maxBindings * sizeof(CC3DrawVertexBinding))
+															   forCommand: aCommand];
+	[self populateVertexBindingsOf: aCommand withVisitor: visitor];
+	NSAssert3(aCommand->vertexBindingCount <= maxBindings, @"%@ populated %u vertex bindings into space for %u",
+			  self, aCommand->vertexBindingCount, maxBindings);
+
+	if (vertexIndices) {
+		if ( ![vertexIndices populateDrawVertexBinding: &aCommand->indexBinding withVisitor: visitor] ) return;
+		aCommand->isIndexed = YES;
+		aCommand->indexType = vertexIndices.elementType;
+		[vertexIndices populateDrawRangesOf: aCommand withVisitor: visitor];
+	} else {
+		[vertexLocations populateDrawRangesOf: aCommand withVisitor: visitor];
+	}
+	aCommand->shouldDrawLive = NO;
+}
+
+/**
+ * Template method that populates the vertex bindings of the specified command, in the same
+ * order in which the bindGLWithVisitor: method binds the vertex arrays. Subclasses with
+ * additional vertex arrays will extend.
+ *
+ * As when binding, the last texture coordinates array is reused for any remaining texture units.
+ */
+-(void) populateVertexBindingsOf: (CC3DrawCommand*) aCommand withVisitor: (CC3NodeDrawingVisitor*) visitor {
+	[self addVertexArray: vertexLocations toDrawCommand: aCommand withVisitor: visitor];
+	[self addVertexArray: vertexNormals toDrawCommand: aCommand withVisitor: visitor];
+	[self addVertexArray: vertexColors toDrawCommand: aCommand withVisitor: visitor];
+
+	CC3VertexTextureCoordinates* vtc = nil;
+	GLuint tuCount = visitor.textureUnitCount;
+	for (GLuint tu = 0; tu < tuCount; tu++) {
+		if (tu < self.textureCoordinatesArrayCount) vtc = [self textureCoordinatesForTextureUnit: tu];
+		if (vtc) {
+			visitor.textureUnit = tu;
+			[self addVertexArray: vtc toDrawCommand: aCommand withVisitor: visitor];
+		}
+	}
+}
+
+/** Appends a binding for the specified vertex array, if it is not nil and has content to bind. */
+-(void) addVertexArray: (CC3VertexArray*) vtxArray
+		 toDrawCommand: (CC3DrawCommand*) aCommand
+		   withVisitor: (CC3NodeDrawingVisitor*) visitor {
+	if ( !vtxArray ) return;
+	CC3DrawVertexBinding* vtxBindings = [visitor.commandList contentAt: aCommand->vertexBindingsOffset
+															 ofCommand: aCommand];
+	if ([vtxArray populateDrawVertexBinding: &vtxBindings[aCommand->vertexBindingCount] withVisitor: visitor]) {
+		aCommand->vertexBindingCount++;
+	}
+}
+
 -(void) bindGLWithVisitor: (CC3NodeDrawingVisitor*) visitor {
 	LogTrace(@"Binding %@", self);
+	[self performPendingGLUpdates];		// deferred from another thread
+
 	CC3OpenGLESVertexArrays* glesVtxArrays = CC3OpenGLESEngine.engine.vertices;
 	[glesVtxArrays clearUnboundVertexPointers];
 
@@ -702,6 +852,14 @@
 	}
 }
 
+-(void) populateDrawRange: (CC3DrawRange*) aRange from: (GLuint) vertexIndex forCount: (GLuint) vertexCount {
+	if (vertexIndices) {
+		[vertexIndices populateDrawRange: aRange from: vertexIndex forCount: vertexCount];
+	} else {
+		[vertexLocations populateDrawRange: aRange from: vertexIndex forCount: vertexCount];
+	}
+}
+
 /**
  * Returns a bounding volume that first checks against the spherical boundary, and then checks
  * against a bounding box. The spherical boundary is fast to check, but is not as accurate as
@@ -958,7 +1116,8 @@
 	// the copying can be optimized to a memory copy.
 	if ((self.vertexContentTypes == srcMesh.vertexContentTypes) &&
 		self.vertexStride == srcMesh.vertexStride &&
-		(self.shouldInterleaveVertices && srcMesh.shouldInterleaveVertices)) {
+		(self.shouldInterleaveVertices && srcMesh.shouldInterleaveVertices) &&
+		!(self.hasQuantizedVertexLocations || srcMesh.hasQuantizedVertexLocations)) {
 			LogTrace(@"%@ using optimized memory copy from %@ due to identical vertex content.", self, srcMesh);
 			[self.vertexLocations copyVertices: vtxCount
 								   fromAddress: srcMesh.interleavedVertices
@@ -1020,6 +1179,163 @@
 }
 
 
+#pragma mark Quantizing vertex content
+
+-(BOOL) hasQuantizedVertexLocations { return vertexLocations.isQuantized; }
+
+-(BOOL) hasQuantizedVertexNormals { return vertexNormals.isQuantized; }
+
+-(void) populateVertexLocationUnpackMatrix: (CC3Matrix4x4*) mtx {
+	if (vertexLocations)
+		[vertexLocations populateUnpackMatrix: mtx];
+	else
+		CC3Matrix4x4PopulateIdentity(mtx);
+}
+
+/**
+ * Template method that returns the vertex arrays that hold per-vertex content, excluding
+ * the vertex indices. Subclasses that add other vertex arrays will override to append them.
+ */
+-(CCArray*) vertexContentArrays {
+	CCArray* vcArrays = [CCArray array];
+	if (vertexLocations) [vcArrays addObject: vertexLocations];
+	if (vertexNormals) [vcArrays addObject: vertexNormals];
+	if (vertexColors) [vcArrays addObject: vertexColors];
+	if (vertexTextureCoordinates) [vcArrays addObject: vertexTextureCoordinates];
+	for (CC3VertexTextureCoordinates* otc in overlayTextureCoordinates) {
+		[vcArrays addObject: otc];
+	}
+	return vcArrays;
+}
+
+/**
+ * Template method that returns whether the vertex locations can be quantized. Subclasses
+ * whose vertex locations are transformed or updated dynamically will override to return NO.
+ */
+-(BOOL) canQuantizeVertexLocations {
+	return (vertexLocations.elementType == GL_FLOAT && vertexLocations.elementSize <= 3);
+}
+
+-(GLuint) vertexContentByteCount {
+	GLuint vtxCount = self.vertexCount;
+	if (shouldInterleaveVertices) return vertexLocations.vertexStride * vtxCount;
+
+	GLuint byteCount = 0;
+	for (CC3VertexArray* va in self.vertexContentArrays) {
+		byteCount += va.vertexStride * vtxCount;
+	}
+	return byteCount;
+}
+
+-(BOOL) quantizeVertexContent {
+	GLuint vtxCount = self.vertexCount;
+	if ( !(vtxCount && vertexLocations.vertices) ) {
+		LogError(@"%@ cannot quantize vertex content that is empty or has been released", self);
+		return NO;
+	}
+
+	// Determine which vertex content will be quantized
+	BOOL shouldQuantizeLocs = self.canQuantizeVertexLocations;
+	BOOL shouldQuantizeNorms = (vertexNormals && vertexNormals.elementType == GL_FLOAT);
+	CCArray* quantTexCoords = [CCArray array];
+	if (vertexTextureCoordinates.canQuantize) [quantTexCoords addObject: vertexTextureCoordinates];
+	for (CC3VertexTextureCoordinates* otc in overlayTextureCoordinates) {
+		if (otc.canQuantize) [quantTexCoords addObject: otc];
+	}
+	if ( !(shouldQuantizeLocs || shouldQuantizeNorms || quantTexCoords.count) ) return NO;
+
+	GLuint oldByteCount = self.vertexContentByteCount;
+	CC3BoundingBox bb = vertexLocations.boundingBox;
+	BOOL wasUsingGLBuffers = self.isUsingGLBuffers;
+	[self deleteGLBuffers];
+
+	// Extract the current content of each vertex array. Content that is to be quantized is
+	// extracted in decoded form. All other content is extracted exactly as it is stored.
+	CCArray* vcArrays = self.vertexContentArrays;
+	GLuint vaCount = vcArrays.count;
+	GLvoid* vaContent[vaCount];
+	for (GLuint vaIdx = 0; vaIdx < vaCount; vaIdx++) {
+		CC3VertexArray* va = [vcArrays objectAtIndex: vaIdx];
+		if (va == vertexLocations && shouldQuantizeLocs) {
+			CC3Vector* locs = malloc(vtxCount * sizeof(CC3Vector));
+			for (GLuint i = 0; i < vtxCount; i++) locs[i] = [vertexLocations locationAt: i];
+			vaContent[vaIdx] = locs;
+		} else if (va == vertexNormals && shouldQuantizeNorms) {
+			CC3Vector* norms = malloc(vtxCount * sizeof(CC3Vector));
+			for (GLuint i = 0; i < vtxCount; i++) norms[i] = [vertexNormals normalAt: i];
+			vaContent[vaIdx] = norms;
+		} else if ([quantTexCoords containsObject: va]) {
+			ccTex2F* texCoords = malloc(vtxCount * sizeof(ccTex2F));
+			for (GLuint i = 0; i < vtxCount; i++) texCoords[i] = [(CC3VertexTextureCoordinates*)va texCoord2FAt: i];
+			vaContent[vaIdx] = texCoords;
+		} else {
+			GLuint elemLen = va.elementLength;
+			GLubyte* elems = malloc(vtxCount * elemLen);
+			for (GLuint i = 0; i < vtxCount; i++) memcpy(elems + (i * elemLen), [va addressOfElement: i], elemLen);
+			vaContent[vaIdx] = elems;
+		}
+	}
+
+	// Release the existing vertex storage, and change the element format of the quantized content.
+	// Locations are scaled so that the largest dimension of the bounding box uses the full range of
+	// a GL_SHORT. Four components are used for locations and normals to keep them four-byte aligned.
+	for (CC3VertexArray* va in vcArrays) va.vertices = NULL;
+	if (shouldQuantizeLocs) {
+		CC3Vector halfSize = CC3VectorScaleUniform(CC3VectorDifference(bb.maximum, bb.minimum), 0.5f);
+		GLfloat maxHalfSize = MAX(MAX(halfSize.x, halfSize.y), halfSize.z);
+		vertexLocations.unpackScale = (maxHalfSize > 0.0f) ? (maxHalfSize / kCC3MaxGLshort) : 1.0f;
+		vertexLocations.unpackOffset = CC3BoundingBoxCenter(bb);
+		vertexLocations.elementType = GL_SHORT;
+		vertexLocations.elementSize = 4;
+	}
+	if (shouldQuantizeNorms) {
+		vertexNormals.elementType = GL_BYTE;
+		vertexNormals.elementSize = 4;
+		vertexNormals.shouldNormalizeContent = YES;
+	}
+	for (CC3VertexTextureCoordinates* tc in quantTexCoords) {
+		tc.elementType = GL_UNSIGNED_SHORT;
+		tc.shouldNormalizeContent = YES;
+	}
+	if (shouldInterleaveVertices) {
+		[self updateVertexStride];
+	} else {
+		for (CC3VertexArray* va in vcArrays) {
+			va.vertexStride = 0;		// Pack each array tightly
+			va.elementOffset = 0;
+		}
+	}
+	self.allocatedVertexCapacity = vtxCount;
+
+	// Write the extracted content back into the new vertex storage
+	for (GLuint vaIdx = 0; vaIdx < vaCount; vaIdx++) {
+		CC3VertexArray* va = [vcArrays objectAtIndex: vaIdx];
+		if (va == vertexLocations && shouldQuantizeLocs) {
+			CC3Vector* locs = vaContent[vaIdx];
+			for (GLuint i = 0; i < vtxCount; i++) [vertexLocations setLocation: locs[i] at: i];
+		} else if (va == vertexNormals && shouldQuantizeNorms) {
+			CC3Vector* norms = vaContent[vaIdx];
+			for (GLuint i = 0; i < vtxCount; i++) [vertexNormals setNormal: norms[i] at: i];
+		} else if ([quantTexCoords containsObject: va]) {
+			ccTex2F* texCoords = vaContent[vaIdx];
+			for (GLuint i = 0; i < vtxCount; i++) [(CC3VertexTextureCoordinates*)va setTexCoord2F: texCoords[i] at: i];
+		} else {
+			GLuint elemLen = va.elementLength;
+			GLubyte* elems = vaContent[vaIdx];
+			for (GLuint i = 0; i < vtxCount; i++) memcpy([va addressOfElement: i], elems + (i * elemLen), elemLen);
+		}
+		free(vaContent[vaIdx]);
+	}
+
+	if (wasUsingGLBuffers) [self createGLBuffers];
+
+	GLuint newByteCount = self.vertexContentByteCount;
+	LogInfo(@"%@ quantized vertex content from %u to %u bytes (%u to %u bytes per vertex)",
+			self, oldByteCount, newByteCount, (oldByteCount / vtxCount), (newByteCount / vtxCount));
+	return YES;
+}
+
+
 #pragma mark Faces
 
 -(GLuint) faceCount {
@@ -1097,6 +1413,23 @@
 
 @implementation CC3VertexLocationsSphericalBoundingVolume
 
+@synthesize shouldUseMinimalSphere;
+
+-(id) init {
+	if ( (self = [super init]) ) {
+		shouldUseMinimalSphere = NO;
+	}
+	return self;
+}
+
+// Template method that populates this instance from the specified other instance.
+// This method is invoked automatically during object copying via the copyWithZone: method.
+-(void) populateFrom: (CC3VertexLocationsSphericalBoundingVolume*) another {
+	[super populateFrom: another];
+	
+	shouldUseMinimalSphere = another.shouldUseMinimalSphere;
+}
+
 /**
  * Find the sphere that currently encompasses all the vertices. Then, if we should maximize
  * the boundary, find the sphere that is the union of that sphere, and the sphere that
@@ -1104,8 +1437,11 @@
  */
 -(void) buildVolume {
 	CC3VertexLocations* vtxLocs = self.vertexLocations;
-	CC3Vector newCOG = vtxLocs.centerOfGeometry;
-	GLfloat newRadius = vtxLocs.radius + self.node.boundingVolumePadding;
+	CC3Sphere vtxSphere = shouldUseMinimalSphere
+							? [vtxLocs minimalBoundingSphere]
+							: CC3SphereMake(vtxLocs.centerOfGeometry, vtxLocs.radius);
+	CC3Vector newCOG = vtxSphere.center;
+	GLfloat newRadius = vtxSphere.radius + self.node.boundingVolumePadding;
 	
 	if (shouldMaximize) {
 		CC3Sphere unionSphere = CC3SphereUnion(CC3SphereMake(newCOG, newRadius),
@@ -56,6 +56,8 @@
 @interface CC3VertexArrayContent : NSObject {
 @public
 	GLvoid* _vertices;
+	GLuint _vertexStorageLength;			// Bytes allocated at _vertices by this instance. Guarded by _glStateLock
+	NSMutableArray* _retiredVertexStorage;	// Replaced storage awaiting the render thread. Guarded by _glStateLock
 	GLuint _vertexCount;
 //	GLuint _allocatedVertexCapacity;
 	GLuint _vertexStride;
@@ -140,16 +142,25 @@
 	GLenum _elementType;
 	GLuint _allocatedVertexCapacity;
 
-//	NSRange _dirtyVertexRange;
+	NSRange _dirtyVertexRange;
 	GLvoid* _vertices;
 	GLuint _vertexCount;
 	GLuint _bufferID;
+	GLuint _streamBufferID;
+	GLuint _streamOffset;
+	GLuint _streamFrame;
+	GLuint _streamGeneration;
 	GLenum _bufferUsage;
 	GLenum _semantic;
+	GLuint _drawingVersion;
+	OSSpinLock _glStateLock;				// Guards the vertex storage, the dirty vertex range and the pending GL work
+	BOOL _shouldCreateGLBufferWhenBound;	// Guarded fields are not bitfields, so they never share a word
+	BOOL _isQueuedForGLUpdate;
 	GLuint _vertexStride : 8;
 	BOOL _shouldNormalizeContent : 1;
 	BOOL _shouldAllowVertexBuffering : 1;
 	BOOL _shouldReleaseRedundantData : 1;
+	BOOL _shouldStreamVertices : 1;
 	BOOL _wasVertexCapacityChanged : 1;		// Future use to track dirty vertex range
 }
 
@@ -454,6 +465,15 @@
  * After allocating on one CC3VertexArray instances, set the vertices property of the other
  * instances to be equal to the vertices property of the CC3VertexArray instance on which this
  * method was invoked (or just simply to the pointer returned by this method).
+ *
+ * The render thread may be copying the vertex content to the GL engine while this property
+ * is set on another thread, such as a background thread that is loading or building the mesh.
+ * For this reason, memory is never reallocated in place. New memory is allocated, the preserved
+ * vertex content is copied to it, and the new memory and capacity are published together under
+ * the lock held by this instance. When this property is set on a thread other than the render
+ * thread, the old memory is not freed immediately, but is retired until the render thread next
+ * performs the pending GL updates of this instance, at the start of the next frame. The same
+ * applies to memory released by setting the vertices property.
  */
 @property(nonatomic, assign) GLuint allocatedVertexCapacity;
 
@@ -492,6 +512,36 @@
  */
 @property(nonatomic, assign) BOOL shouldAllowVertexBuffering;
 
+/**
+ * Indicates whether the vertex content should be streamed to the GL engine, through the shared
+ * vertex stream of the CC3OpenGLESEngine, each time the content is drawn during a new frame.
+ *
+ * This is appropriate for dynamic content that changes on most frames, such as that of particles,
+ * billboards, shadow volumes or deformed meshes. Updating a dedicated GL buffer on each frame can
+ * force the GL engine to wait until the draw calls of the previous frame that use the buffer have
+ * completed. Instead, a CC3OpenGLESVertexStream copies the content into a ring of GL buffers, so
+ * that the content is never written to GL buffer memory that is still in use.
+ *
+ * When this property is set to YES, this vertex array does not create its own GL buffer, and any
+ * existing GL buffer is deleted. Instead, when this vertex array is first bound for drawing during
+ * a frame, its content is copied into the vertex stream. If it is drawn again during the same frame,
+ * the content is copied again only if it was changed through the accessor methods of this instance,
+ * or marked as changed using the addDirtyVertexRange: method. If the content is too large for the
+ * vertex stream, it is passed to the GL engine from application memory instead.
+ *
+ * The vertex content must remain in application memory, so the releaseRedundantData method
+ * has no effect while this property is set to YES.
+ *
+ * The initial value of this property is NO.
+ */
+@property(nonatomic, assign) BOOL shouldStreamVertices;
+
+/**
+ * Returns whether the vertex content was streamed to the GL engine, through the shared vertex stream,
+ * the last time this vertex array was bound for drawing.
+ */
+@property(nonatomic, readonly) BOOL isUsingStream;
+
 /** 
  * If the shouldAllowVertexBuffering property is set to YES, creates a vertex buffer
  * object (VBO) within the GL engine, copies the content referenced by the vertices into
@@ -522,6 +572,14 @@
  * This method is invoked automatically by the createGLBuffers method of the mesh class, which
  * also coordinates the invocations across multiple CC3VertexArray instances when interleaved
  * content is shared between them, along with the subsequent copying of the bufferID's.
+ *
+ * The GL engine may only be accessed from the thread that is rendering the scene. If this
+ * method is invoked from any other thread, such as a background thread that is loading or
+ * building the mesh, the GL buffer is not created immediately. Instead, this vertex array is
+ * added to the queue of pending GL updates of the CC3OpenGLESEngine, and the GL buffer is
+ * created by the render thread at the start of the next frame, or when this vertex array is
+ * next bound for drawing, whichever comes first. Until that happens, the isUsingGLBuffer
+ * property returns NO, and the releaseRedundantData method has no effect.
  */
 -(void) createGLBuffer;
 
@@ -537,6 +595,10 @@
  * This would be the case if the allocatedVertexCapacity property was not set.
  *
  * This method is invoked automatically when this instance is deallocated.
+ *
+ * This method may be invoked from any thread. If it is invoked from a thread other than
+ * the thread that is rendering the scene, the deletion of the GL buffer is queued, and is
+ * performed by the rendering thread at the start of the next frame.
  */
 -(void) deleteGLBuffer;
 
@@ -544,12 +606,129 @@
  * Updates the GL engine buffer with the element content contained in this array,
  * starting at the vertex at the specified offsetIndex, and extending for
  * the specified number of vertices.
+ *
+ * If this method is invoked from a thread other than the thread that is rendering the scene,
+ * the GL buffer is not updated immediately. Instead, the vertices are added to the range in
+ * the dirtyVertexRange property, this vertex array is added to the queue of pending GL updates
+ * of the CC3OpenGLESEngine, and the vertices are copied to the GL buffer by the render thread
+ * at the start of the next frame, or when this vertex array is next bound for drawing.
+ *
+ * If this instance is streaming its vertices, the vertices are marked as changed, so that
+ * they are streamed again the next time this vertex array is bound for drawing.
  */
 -(void) updateGLBufferStartingAt: (GLuint) offsetIndex forLength: (GLuint) vertexCount;
 
 /** Updates the GL engine buffer with all of the element content contained in this array. */
 -(void) updateGLBuffer;
 
+/**
+ * The range of vertices whose content has been changed since it was last copied to the GL
+ * engine buffer. If no vertices have been changed, the length of this range is zero.
+ *
+ * This range is expanded automatically when vertex content is changed through the accessor
+ * methods of this instance, such as setLocation:at:, setColor4F:at: or copyVertices:from:to:.
+ * If you change the vertex content directly, through the pointer returned by the vertices
+ * property or the addressOfElement: method, you can mark the changed vertices using the
+ * addDirtyVertexRange: method, or update the GL buffer directly using the
+ * updateGLBufferStartingAt:forLength: method.
+ *
+ * When this vertex array is bound to the GL engine for drawing, if this range is not empty,
+ * the changed vertices are copied to the GL engine buffer, and this range is cleared.
+ * Changes to several vertices between draws are therefore coalesced into a single update
+ * of the GL buffer. See the dirtyBufferReloadThreshold class-side property for more
+ * information about how the vertices are copied to the GL buffer.
+ *
+ * This range is also cleared when the GL buffer is created, and when the GL buffer is
+ * updated with content that covers the entire range.
+ *
+ * This range is tracked only while this instance is using a GL buffer. If the vertex content
+ * is being passed to the GL engine on each draw call, the length of this range remains zero.
+ *
+ * This range may be changed from any thread. Access to it is guarded by a lock held by this
+ * instance, so that vertices marked dirty on a loader or simulation thread are not lost while
+ * the render thread copies the dirty vertices to the GL buffer.
+ *
+ * The render thread takes and clears this range before it copies the vertices. A vertex that
+ * is written on another thread while it is being copied may reach the GL buffer partially
+ * written, but because the writer marks it dirty after writing it, the complete vertex is
+ * copied again when this vertex array is next bound for drawing.
+ */
+@property(nonatomic, readonly) NSRange dirtyVertexRange;
+
+/**
+ * Marks the specified range of vertices as having content that needs to be copied to the
+ * GL engine buffer, by expanding the range in the dirtyVertexRange property to include it.
+ *
+ * It is not necessary to invoke this method when vertex content is changed through the
+ * accessor methods of this instance. You can use this method to mark vertex content that
+ * you have changed directly, through the pointer returned by the vertices property or the
+ * addressOfElement: method.
+ *
+ * This method does nothing if this instance is not using a GL buffer.
+ */
+-(void) addDirtyVertexRange: (NSRange) aRange;
+
+/**
+ * Marks the specified vertex as having content that needs to be copied to the GL engine buffer,
+ * by expanding the range in the dirtyVertexRange property to include it.
+ *
+ * This method does nothing if this instance is not using a GL buffer.
+ */
+-(void) addDirtyVertex: (GLuint) vtxIdx;
+
+/**
+ * Marks the content of the vertices in the specified range as having been copied to the
+ * GL engine buffer. If the specified range covers the range in the dirtyVertexRange property,
+ * that property is cleared.
+ *
+ * This method is invoked automatically by the updateGLBufferStartingAt:forLength: method.
+ * When vertex content is interleaved, the mesh invokes this method on the vertex arrays that
+ * share the GL buffer of the vertex array that was updated. Usually, the application never
+ * needs to invoke this method directly.
+ */
+-(void) markVerticesCleanStartingAt: (GLuint) offsetIndex forLength: (GLuint) vertexCount;
+
+/**
+ * If this instance is using a GL buffer, and the dirtyVertexRange property is not empty,
+ * copies the content of the vertices in that range to the GL buffer, and clears that range.
+ *
+ * If the dirty fraction of the GL buffer is at least the value of the class-side
+ * dirtyBufferReloadThreshold property, the entire GL buffer is reloaded, allowing the GL
+ * engine to orphan the existing buffer memory. Otherwise, only the dirty range is updated.
+ *
+ * This method is invoked automatically when this vertex array is bound to the GL engine
+ * for drawing. Usually, the application never needs to invoke this method directly.
+ */
+-(void) updateGLBufferFromDirtyVertexRange;
+
+/** Clears the range in the dirtyVertexRange property, without updating the GL engine buffer. */
+-(void) clearDirtyVertexRange;
+
+/**
+ * Returns the fraction of the vertex capacity of the GL buffer that must be dirty before
+ * the entire GL buffer is reloaded, instead of updating only the dirty vertex range.
+ *
+ * When a vertex array is bound for drawing, and its dirtyVertexRange property is not empty,
+ * the vertex content is copied to the GL buffer. If the fraction of the buffer that is dirty
+ * is below this threshold, only the dirty vertex range is copied, using glBufferSubData.
+ * Otherwise, the entire content is reloaded using glBufferData, which allows the GL engine to
+ * orphan the existing buffer memory instead of waiting for pending draw calls that use it.
+ *
+ * Setting this value to zero will always cause the entire buffer to be reloaded. Setting
+ * this value above one will always cause only the dirty vertex range to be updated.
+ *
+ * The initial value of this property is 0.5.
+ */
++(GLfloat) dirtyBufferReloadThreshold;
+
+/**
+ * Sets the fraction of the vertex capacity of the GL buffer that must be dirty before
+ * the entire GL buffer is reloaded, instead of updating only the dirty vertex range.
+ *
+ * The initial value of this property is 0.5.
+ */
++(void) setDirtyBufferReloadThreshold: (GLfloat) aFraction;
+
 /**
  * Returns whether the underlying vertex content has been loaded into a GL engine vertex
  * buffer object. Vertex buffer objects are engaged via the createGLBuffer method.
@@ -599,6 +778,44 @@
  */
 -(void) bindWithVisitor: (CC3NodeDrawingVisitor*) visitor;
 
+/**
+ * Indicates the version of the content of this vertex array that is captured into draw
+ * commands. The value of this property changes whenever the vertices, the layout of the
+ * vertex content, or the GL buffer of this vertex array changes.
+ *
+ * Changes to the values of the vertices themselves do not change this property, because
+ * the GL engine reads those values when the draw command is replayed.
+ */
+@property(nonatomic, readonly) GLuint drawingVersion;
+
+/**
+ * Populates the specified vertex binding with the layout and location of the content of
+ * this vertex array, as captured into a draw command, and returns whether this vertex
+ * array has content to bind. This method makes no GL calls.
+ *
+ * If the content must be synchronized with the GL engine when the command is replayed,
+ * because it is held in a GL buffer, is streamed, or a GL buffer is waiting to be created,
+ * this vertex array is set into the vertexArray field of the binding, and the
+ * resolveDrawVertexBinding: method must be invoked before the binding is applied.
+ *
+ * This method is invoked automatically when a mesh populates a draw command.
+ * Usually, the application never needs to invoke this method directly.
+ */
+-(BOOL) populateDrawVertexBinding: (CC3DrawVertexBinding*) vtxBinding
+					  withVisitor: (CC3NodeDrawingVisitor*) visitor;
+
+/**
+ * Synchronizes the content of this vertex array with the GL engine, by creating any pending
+ * GL buffer, copying any dirty vertices to the GL buffer, or streaming the vertices, and
+ * updates the bufferID and pointer fields of the specified vertex binding, which must have
+ * been populated by the populateDrawVertexBinding:withVisitor: method. Returns whether
+ * this vertex array has content to bind.
+ *
+ * This method must be invoked on the rendering thread, and is invoked automatically when
+ * a draw command is replayed. Usually, the application never needs to invoke this method.
+ */
+-(BOOL) resolveDrawVertexBinding: (CC3DrawVertexBinding*) vtxBinding;
+
 
 #pragma mark Accessing vertices
 
@@ -793,6 +1010,22 @@
 		forCount: (GLuint) vertexCount
 	 withVisitor: (CC3NodeDrawingVisitor*) visitor;
 
+/**
+ * Allocates the draw ranges of the specified draw command, and populates one range for
+ * each strip, or a single range if drawing is not performed in strips. The number of faces
+ * drawn by the ranges is added to the faceCount field of the command.
+ *
+ * This method is invoked automatically when a mesh populates a draw command.
+ */
+-(void) populateDrawRangesOf: (CC3DrawCommand*) aCommand withVisitor: (CC3NodeDrawingVisitor*) visitor;
+
+/**
+ * Populates the specified draw range to draw the specified number of vertices, starting at
+ * the specified vertex index, in a single GL draw call, in the same way that the
+ * drawFrom:forCount:withVisitor: method draws them.
+ */
+-(void) populateDrawRange: (CC3DrawRange*) aRange from: (GLuint) vertexIndex forCount: (GLuint) vertexCount;
+
 /**
  * Sets the specified number of strips into the stripCount property, then allocates an
  * array of Gluints of that length, and sets that array in the stripLengths property.
@@ -882,6 +1115,8 @@
 	CC3BoundingBox _boundingBox;
 	CC3Vector _centerOfGeometry;
 	GLfloat _radius;
+	CC3Vector _unpackOffset;
+	GLfloat _unpackScale;
 	BOOL _boundaryIsDirty : 1;
 	BOOL _radiusIsDirty : 1;
 }
@@ -912,9 +1147,65 @@
  */
 @property(nonatomic, readonly) GLfloat radius;
 
+/**
+ * Returns a spherical boundary that encompasses all the vertices of this mesh, and that is
+ * close to the smallest such sphere.
+ *
+ * Unlike the radius property, the center of the returned sphere is not constrained to the
+ * centerOfGeometry, and so the returned sphere is often noticeably tighter for asymmetric
+ * meshes. The returned sphere is never larger than the sphere defined by the centerOfGeometry
+ * and radius properties.
+ *
+ * The sphere is calculated each time this method is invoked, and is not cached.
+ */
+-(CC3Sphere) minimalBoundingSphere;
+
 /** Marks the boundary, including bounding box and radius, as dirty, and need of recalculation. */
 -(void) markBoundaryDirty;
 
+
+#pragma mark Quantization
+
+/**
+ * Returns whether the vertex locations are stored in a quantized form.
+ *
+ * Returns YES if the elementType property is GL_SHORT, in which case each stored component
+ * is converted to a location value by multiplying it by the value of the unpackScale property,
+ * and adding the corresponding component of the unpackOffset property.
+ *
+ * The locationAt: and setLocation:at: methods, and the methods that depend on them, such as
+ * those that calculate the boundingBox and radius, perform this conversion automatically.
+ * Quantized locations are passed to the GL engine unconverted. The CC3MeshNode that draws
+ * the mesh applies the transform returned by the populateUnpackMatrix: method during drawing.
+ *
+ * Vertex locations are usually quantized by the quantizeVertexContent method of CC3VertexArrayMesh.
+ */
+@property(nonatomic, readonly) BOOL isQuantized;
+
+/**
+ * The uniform scale applied to each stored location component when the locations are quantized.
+ *
+ * This property has no effect unless the isQuantized property returns YES.
+ * The initial value is one.
+ */
+@property(nonatomic, assign) GLfloat unpackScale;
+
+/**
+ * The offset added to each scaled location when the locations are quantized.
+ *
+ * This property has no effect unless the isQuantized property returns YES.
+ * The initial value is kCC3VectorZero.
+ */
+@property(nonatomic, assign) CC3Vector unpackOffset;
+
+/**
+ * Populates the specified matrix with the transform that converts the stored location
+ * content to mesh coordinates, as determined by the unpackScale and unpackOffset properties.
+ *
+ * If the isQuantized property returns NO, the matrix is populated as an identity matrix.
+ */
+-(void) populateUnpackMatrix: (CC3Matrix4x4*) mtx;
+
 /**
  * Returns the location element at the specified index in the underlying vertex content.
  *
@@ -1113,6 +1404,15 @@
  */
 -(void) setNormal: (CC3Vector) aNormal at: (GLuint) index;
 
+/**
+ * Returns whether the normals are stored in a quantized form.
+ *
+ * Returns YES if the elementType property is GL_BYTE, in which case each normal component is
+ * stored as a signed byte that the GL engine normalizes to the range [-1, 1]. The normalAt:
+ * and setNormal:at: methods perform this conversion automatically.
+ */
+@property(nonatomic, readonly) BOOL isQuantized;
+
 @end
 
 
@@ -1273,6 +1573,27 @@ static const CGRect kCC3UnitTextureRectangle = { {0.0, 0.0}, {1.0, 1.0} };
  */
 -(void) setTexCoord2F: (ccTex2F) aTex2F at: (GLuint) index;
 
+/**
+ * Returns whether the texture coordinates are stored in a quantized form.
+ *
+ * Returns YES if the elementType property is GL_UNSIGNED_SHORT, in which case each component
+ * is stored as an unsigned short that the GL engine normalizes to the range [0, 1]. The
+ * texCoord2FAt: and setTexCoord2F:at: methods perform this conversion automatically, and
+ * values set outside the range [0, 1] are clamped. Because of this, repeating textures
+ * cannot be applied to quantized texture coordinates.
+ */
+@property(nonatomic, readonly) BOOL isQuantized;
+
+/**
+ * Returns whether the texture coordinates can be quantized without loss of range.
+ *
+ * Returns YES if the GL engine supports normalized vertex attributes of type
+ * GL_UNSIGNED_SHORT, which is the case under OpenGL ES 2, the texture coordinates
+ * are currently stored as two GL_FLOAT components, and all of the texture coordinates
+ * lie within the range [0, 1].
+ */
+@property(nonatomic, readonly) BOOL canQuantize;
+
 /**
  * Indicates whether the texture coordinates of this mesh expects that the texture
  * was flipped upside-down during texture loading.
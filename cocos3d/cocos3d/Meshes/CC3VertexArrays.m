@@ -35,6 +35,31 @@
 #import "CC3OpenGLESEngine.h"
 
 
+#pragma mark -
+#pragma mark Quantization functions
+
+/** Rounds the specified value to the nearest GLshort, clamped to the symmetric range of a GLshort. */
+static inline GLshort CC3QuantizeToGLshort(GLfloat val) {
+	return (GLshort)CLAMP(roundf(val), -kCC3MaxGLshort, kCC3MaxGLshort);
+}
+
+/** Converts the specified value in the range [-1, 1] to a normalized GLbyte. */
+static inline GLbyte CC3QuantizeToGLbyte(GLfloat val) {
+	return (GLbyte)CLAMP(roundf(val * kCC3MaxGLbyte), -kCC3MaxGLbyte, kCC3MaxGLbyte);
+}
+
+/** Converts the specified normalized GLbyte to a value in the range [-1, 1], as the GL engine does. */
+static inline GLfloat CC3DequantizeGLbyte(GLbyte val) { return MAX((GLfloat)val / kCC3MaxGLbyte, -1.0f); }
+
+/** Converts the specified value in the range [0, 1] to a normalized GLushort. */
+static inline GLushort CC3QuantizeToGLushort(GLfloat val) {
+	return (GLushort)roundf(CLAMP(val, 0.0f, 1.0f) * kCC3MaxGLushort);
+}
+
+/** Converts the specified normalized GLushort to a value in the range [0, 1], as the GL engine does. */
+static inline GLfloat CC3DequantizeGLushort(GLushort val) { return (GLfloat)val / kCC3MaxGLushort; }
+
+
 #pragma mark -
 #pragma mark CC3VertexArrayContent
 
@@ -66,23 +91,48 @@
 @interface CC3VertexArray (TemplateMethods)
 -(BOOL) allocateVertexCapacity: (GLuint) vtxCount;
 -(void) bindGLWithVisitor: (CC3NodeDrawingVisitor*) visitor;
--(void) bindPointer: (GLvoid*) pointer withVisitor: (CC3NodeDrawingVisitor*) visitor;
+-(void) markDrawingChanged;
 -(void) verticesWereChanged;
+-(void) addDirtyVertices: (GLuint) vtxCount atAddress: (GLvoid*) vtxPtr;
+-(BOOL) streamVertices;
+-(void) createPendingGLBuffer;
+-(void) queuePendingGLUpdates;
+-(GLvoid*) vertexStorageOfLength: (GLuint*) pLength;
+-(void) publishVertexStorage: (GLvoid*) vtxs ofLength: (GLuint) vtxLen;
+-(void) retireVertexStorage: (GLvoid*) vtxs;
+-(void) freeRetiredVertexStorage;
 @property(nonatomic, readonly) GLuint availableVertexCount;
 @end
 
+@interface CC3VertexArray (PendingGLUpdates) <CC3PendingGLUpdateProtocol>
+@end
+
+/** Expands the specified range to include the specified range of vertices. */
+static inline void CC3ExpandDirtyVertexRange(NSRange* pRange, GLuint vtxIdx, GLuint vtxCount) {
+	if (vtxCount == 0) return;
+	if (pRange->length == 0) {
+		*pRange = NSMakeRange(vtxIdx, vtxCount);
+	} else {
+		*pRange = NSUnionRange(*pRange, NSMakeRange(vtxIdx, vtxCount));
+	}
+}
+
 
 @implementation CC3VertexArray
 
 @synthesize vertexCount=_vertexCount, bufferID=_bufferID, bufferUsage=_bufferUsage;
 @synthesize elementOffset=_elementOffset, semantic=_semantic;
 @synthesize shouldAllowVertexBuffering=_shouldAllowVertexBuffering;
+@synthesize shouldStreamVertices=_shouldStreamVertices;
 @synthesize shouldReleaseRedundantData=_shouldReleaseRedundantData;
 @synthesize shouldNormalizeContent=_shouldNormalizeContent;
+@synthesize drawingVersion=_drawingVersion;
 
 -(void) dealloc {
 	[self deleteGLBuffer];
-	self.allocatedVertexCapacity = 0;
+	if (_allocatedVertexCapacity) free(_vertices);	// No longer queued for GL updates, so free directly
+	[self freeRetiredVertexStorage];
+	[_retiredVertexStorage release];
 //	[_vertexContent release];
 	[super dealloc];
 }
@@ -98,8 +148,9 @@
 	if (vtxs != _vertices) {
 		GLuint currVtxCount = _vertexCount;
 		self.allocatedVertexCapacity = 0;		// Safely disposes existing vertices
-		_vertices = vtxs;
+		[self publishVertexStorage: vtxs ofLength: 0];
 		if (_vertices) _vertexCount = currVtxCount;
+		[self markDrawingChanged];
 		[self verticesWereChanged];
 	}
 }
@@ -107,6 +158,34 @@
 /** The vertices array has been changed. Default is to do nothing. Some subclasses may want to react. */
 -(void) verticesWereChanged {}
 
+-(void) setVertexCount: (GLuint) vtxCount {
+	_vertexCount = vtxCount;
+	[self markDrawingChanged];
+}
+
+-(void) setElementOffset: (GLuint) elemOffset {
+	_elementOffset = elemOffset;
+	[self markDrawingChanged];
+}
+
+-(void) setSemantic: (GLenum) aSemantic {
+	_semantic = aSemantic;
+	[self markDrawingChanged];
+}
+
+-(void) setShouldNormalizeContent: (BOOL) shouldNormalize {
+	_shouldNormalizeContent = shouldNormalize;
+	[self markDrawingChanged];
+}
+
+-(void) setBufferID: (GLuint) buffID {
+	_bufferID = buffID;
+	[self markDrawingChanged];
+}
+
+/** Draw commands that captured the layout or location of the vertex content must be populated again. */
+-(void) markDrawingChanged { CC3IncrementChangeCounter(&_drawingVersion); }
+
 -(GLint) elementSize { return _elementSize; }
 
 /**
@@ -117,6 +196,7 @@
 	GLint currSize = _elementSize;
 	_elementSize = elemSize;
 	if ( ![self allocateVertexCapacity: _allocatedVertexCapacity] ) _elementSize = currSize;
+	[self markDrawingChanged];
 }
 
 -(GLenum) elementType { return _elementType; }
@@ -129,6 +209,7 @@
 	GLenum currType = _elementType;
 	_elementType = elemType;
 	if ( ![self allocateVertexCapacity: _allocatedVertexCapacity] ) _elementType = currType;
+	[self markDrawingChanged];
 }
 
 -(GLuint) elementLength { return GLElementTypeSize(_elementType) * _elementSize; }
@@ -143,6 +224,7 @@
 	GLuint currStride = _vertexStride;
 	_vertexStride = stride;
 	if ( ![self allocateVertexCapacity: _allocatedVertexCapacity] ) _vertexStride = currStride;
+	[self markDrawingChanged];
 }
 
 /**
@@ -177,6 +259,8 @@
 	if ( (self = [super initWithTag: aTag withName: aName]) ) {
 //		vertexContent = [CC3VertexArrayContent new];
 		_vertices = NULL;
+		_vertexStorageLength = 0;
+		_retiredVertexStorage = nil;
 		_vertexCount = 0;
 		_allocatedVertexCapacity = 0;
 		_elementType = GL_FLOAT;
@@ -185,9 +269,18 @@
 		_bufferID = 0;
 		_bufferUsage = GL_STATIC_DRAW;
 		_elementOffset = 0;
+		_drawingVersion = 0;
+		_streamBufferID = 0;
+		_streamOffset = 0;
+		_streamFrame = 0;
+		_streamGeneration = 0;
 		_shouldNormalizeContent = NO;
 		_shouldAllowVertexBuffering = YES;
 		_shouldReleaseRedundantData = YES;
+		_shouldStreamVertices = NO;
+		_glStateLock = OS_SPINLOCK_INIT;
+		_shouldCreateGLBufferWhenBound = NO;
+		_isQueuedForGLUpdate = NO;
 		_semantic = self.class.defaultSemantic;
 	}
 	return self;
@@ -227,6 +320,7 @@
 	_shouldNormalizeContent = another.shouldNormalizeContent;
 	_shouldAllowVertexBuffering = another.shouldAllowVertexBuffering;
 	_shouldReleaseRedundantData = another.shouldReleaseRedundantData;
+	_shouldStreamVertices = another.shouldStreamVertices;
 
 	[self deleteGLBuffer];		// Data has yet to be buffered. Get rid of old buffer if necessary.
 
@@ -237,7 +331,7 @@
 		self.allocatedVertexCapacity = another.allocatedVertexCapacity;
 		memcpy(_vertices, another.vertices, (_allocatedVertexCapacity * self.vertexStride));
 	} else {
-		_vertices = another.vertices;
+		[self publishVertexStorage: another.vertices ofLength: 0];
 	}
 	_vertexCount = another.vertexCount;
 }
@@ -254,33 +348,32 @@
 /**
  * Allocates new vertex memory, reallocates existing vertex memory, or deallocates existing vertex memory.
  *
- * If vtxCount is non-zero, and the vertices property is NULL, memory is allocated, and the vertices
- * property is set to point to it. If vtxCount is non-zero, and the vertices property is non-NULL,
- * the existing memory is reallocated, possibly changing the value of the vertices property in the
- * process. If vtxCount is zero, any previously allocated vertices are safely deallocated.
+ * If vtxCount is non-zero, new memory is allocated, any existing vertex content that fits is copied
+ * to it, and the vertices property is set to point to it. If vtxCount is zero, the vertices property
+ * is set to NULL. In either case, any previously allocated memory is retired or freed.
+ *
+ * Existing memory is not reallocated in place, because the render thread may be copying it to the
+ * GL engine. It remains readable until the render thread next performs its pending GL updates.
  *
  * Returns NO if an error occurs, otherwise returns YES.
  */
 -(BOOL) allocateVertexCapacity: (GLuint) vtxCount {
 	if (_allocatedVertexCapacity == vtxCount) return YES;
 	
-	// If nothing has been allocated yet, ensure that we don't reallocate an externally set pointer
-	if (_allocatedVertexCapacity == 0) _vertices = NULL;
-	
+	// If nothing has been allocated yet, ensure that we don't copy or free an externally set pointer
+	GLvoid* oldVertices = (_allocatedVertexCapacity > 0) ? _vertices : NULL;
+	GLuint newLength = vtxCount * self.vertexStride;
 	GLvoid* newVertices = NULL;
 	
-	// Don't use realloc to free memory that was previously allocated. Behaviour of realloc is
-	// undefined and implementation dependent when the requested size is zero.
 	if (vtxCount > 0) {
 		// Returned pointer will be non-NULL on successful allocation and NULL on failed allocation.
 		// If we fail, log an error and return without changing anything.
-		newVertices = realloc(_vertices, (vtxCount * self.vertexStride));
+		newVertices = malloc(newLength);
 		if ( !newVertices ) {
 			LogError(@"%@ could not allocate space for %u vertices", self, vtxCount);
 			return NO;
 		}
-	} else {
-		free(_vertices);
+		if (oldVertices) memcpy(newVertices, oldVertices, MIN(_vertexStorageLength, newLength));
 	}
 	
 	LogTrace(@"%@ changed vertex allocation from %u vertices at %p to %u vertices at %p",
@@ -288,9 +381,11 @@
 	
 	// Don't use vertices setter, because it will attempt to deallocate again.
 	// But do notify subclasses that the vertices have changed.
-	_vertices = newVertices;
+	[self publishVertexStorage: newVertices ofLength: newLength];
+	[self retireVertexStorage: oldVertices];
 	_allocatedVertexCapacity = vtxCount;
 	_vertexCount = vtxCount;
+	[self markDrawingChanged];
 	[self verticesWereChanged];
 	
 	return YES;
@@ -339,7 +434,7 @@
 // This class variable is automatically incremented whenever the method nextTag is called.
 static GLuint lastAssignedVertexArrayTag;
 
--(GLuint) nextTag { return ++lastAssignedVertexArrayTag; }
+-(GLuint) nextTag { return CC3IncrementTagCounter(&lastAssignedVertexArrayTag); }
 
 +(void) resetTagAllocation { lastAssignedVertexArrayTag = 0; }
 
@@ -347,15 +442,32 @@ static GLuint lastAssignedVertexArrayTag;
 #pragma mark Binding GL artifacts
 
 -(void) createGLBuffer {
-	if (_shouldAllowVertexBuffering && !_bufferID) {
+	if (_shouldAllowVertexBuffering && !_shouldStreamVertices && !_bufferID && !CC3OpenGLESEngine.isRenderThread) {
+		LogTrace(@"%@ deferring creation of GL server buffer to the rendering thread", self);
+		OSSpinLockLock(&_glStateLock);
+		_shouldCreateGLBufferWhenBound = YES;
+		OSSpinLockUnlock(&_glStateLock);
+		[self markDrawingChanged];
+		[self queuePendingGLUpdates];
+	} else if (_shouldAllowVertexBuffering && !_shouldStreamVertices && !_bufferID) {
 		CC3OpenGLESVertexArrays* glesVertices = [CC3OpenGLESEngine engine].vertices;
 		CC3OpenGLESStateTrackerArrayBufferBinding* bufferBinding = [glesVertices bufferBinding: self.bufferTarget];
 		
-		_bufferID = [glesVertices generateBuffer];
+		// Publish the buffer ID and clear the dirty range before loading the content, so that
+		// vertices changed by other threads while the content is being loaded are marked dirty.
+		GLuint buffID = [glesVertices generateBuffer];
+		OSSpinLockLock(&_glStateLock);
+		_bufferID = buffID;
+		_shouldCreateGLBufferWhenBound = NO;
+		_dirtyVertexRange = NSMakeRange(0, 0);
+		OSSpinLockUnlock(&_glStateLock);
+		[self markDrawingChanged];
+
 		LogTrace(@"%@ creating GL server buffer with ID %i", self, _bufferID);
-		GLsizeiptr buffSize = self.vertexStride * self.availableVertexCount;
+		GLuint buffSize;
+		GLvoid* vtxs = [self vertexStorageOfLength: &buffSize];
 		bufferBinding.value = _bufferID;
-		[bufferBinding loadBufferData: _vertices ofLength: buffSize forUse: _bufferUsage];
+		[bufferBinding loadBufferData: vtxs ofLength: buffSize forUse: _bufferUsage];
 		GLenum errCode = glGetError();
 		if (errCode) {
 			LogInfo(@"%@ could not create GL buffer with ID %i of type %@ because of %@. Using local memory arrays instead.",
@@ -364,40 +476,296 @@ static GLuint lastAssignedVertexArrayTag;
 		}
 		[bufferBinding unbind];
 	} else {
-		LogTrace(@"%@ NOT creating GL server buffer because shouldAllowVertexBuffering is %@ or buffer ID already set to %i",
-				 self, NSStringFromBoolean(_shouldAllowVertexBuffering), _bufferID);
+		LogTrace(@"%@ NOT creating GL server buffer because shouldAllowVertexBuffering is %@, shouldStreamVertices is %@, or buffer ID already set to %i",
+				 self, NSStringFromBoolean(_shouldAllowVertexBuffering), NSStringFromBoolean(_shouldStreamVertices), _bufferID);
 	}
 }
 
 -(void) updateGLBufferStartingAt: (GLuint) offsetIndex forLength: (GLuint) vtxCount {
-	if (_bufferID) {
-		CC3OpenGLESStateTrackerArrayBufferBinding* bufferBinding;
+	if (_bufferID && !CC3OpenGLESEngine.isRenderThread) {
+		[self addDirtyVertexRange: NSMakeRange(offsetIndex, vtxCount)];
+		[self queuePendingGLUpdates];
+	} else if (_bufferID) {
+		// Mark the vertices clean before copying them, so that vertices changed by other threads
+		// while they are being copied remain dirty, and are copied again when next bound.
+		[self markVerticesCleanStartingAt: offsetIndex forLength: vtxCount];
+
 		GLuint vtxStride = self.vertexStride;
+		GLuint vtxLen;
+		GLvoid* vtxs = [self vertexStorageOfLength: &vtxLen];
+		GLuint startByte = MIN(offsetIndex * vtxStride, vtxLen);
+		GLuint byteCount = MIN(vtxCount * vtxStride, vtxLen - startByte);
+		if ( !(vtxs && byteCount) ) return;
+
+		CC3OpenGLESStateTrackerArrayBufferBinding* bufferBinding;
 		bufferBinding = [[CC3OpenGLESEngine engine].vertices bufferBinding: self.bufferTarget];
 		bufferBinding.value = _bufferID;
-		[bufferBinding updateBufferData: _vertices
-							 startingAt: (offsetIndex * vtxStride)
-							  forLength: (vtxCount * vtxStride)];
+		[bufferBinding updateBufferData: vtxs startingAt: startByte forLength: byteCount];
 		[bufferBinding unbind];
-		LogTrace(@"%@ updated GL server buffer with %i bytes starting at %i",
-				 self, (vtxCount * vtxStride), (offsetIndex * vtxStride));
+		LogTrace(@"%@ updated GL server buffer with %i bytes starting at %i", self, byteCount, startByte);
+	} else if (_shouldStreamVertices) {
+		// Streamed content is copied when next drawn. Mark it changed, so an earlier copy is not reused.
+		OSSpinLockLock(&_glStateLock);
+		CC3ExpandDirtyVertexRange(&_dirtyVertexRange, offsetIndex, vtxCount);
+		OSSpinLockUnlock(&_glStateLock);
 	}
 }
 
 -(void) updateGLBuffer { [self updateGLBufferStartingAt: 0 forLength: _vertexCount]; }
 
 -(void) deleteGLBuffer {
-	if (_bufferID) {
-		LogTrace(@"%@ deleting GL server buffer ID %i", self, bufferID);
-		[[CC3OpenGLESEngine engine].vertices deleteBuffer: _bufferID];
-		_bufferID = 0;
+	OSSpinLockLock(&_glStateLock);
+	GLuint buffID = _bufferID;
+	_bufferID = 0;
+	_shouldCreateGLBufferWhenBound = NO;
+	_dirtyVertexRange = NSMakeRange(0, 0);
+	OSSpinLockUnlock(&_glStateLock);
+
+	if (buffID) {
+		LogTrace(@"%@ deleting GL server buffer ID %i", self, buffID);
+		[[CC3OpenGLESEngine engine].vertices deleteBuffer: buffID];
+		[self markDrawingChanged];
 	}
 }
 
 -(BOOL) isUsingGLBuffer { return _bufferID != 0; }
 
+
+#pragma mark Pending GL updates
+
+/** Creates the GL buffer on the render thread, if its creation was requested from another thread. */
+-(void) createPendingGLBuffer {
+	OSSpinLockLock(&_glStateLock);
+	BOOL shouldCreate = _shouldCreateGLBufferWhenBound;
+	_shouldCreateGLBufferWhenBound = NO;
+	OSSpinLockUnlock(&_glStateLock);
+	if (shouldCreate) [self createGLBuffer];
+}
+
+/** Adds this instance to the queue of pending GL updates of the GL engine, unless it is already queued. */
+-(void) queuePendingGLUpdates {
+	OSSpinLockLock(&_glStateLock);
+	BOOL shouldQueue = !_isQueuedForGLUpdate;
+	_isQueuedForGLUpdate = YES;
+	OSSpinLockUnlock(&_glStateLock);
+	if (shouldQueue) [CC3OpenGLESEngine queuePendingGLUpdate: self];
+}
+
+-(void) performPendingGLUpdates {
+	OSSpinLockLock(&_glStateLock);
+	_isQueuedForGLUpdate = NO;
+	OSSpinLockUnlock(&_glStateLock);
+	[self createPendingGLBuffer];
+	[self updateGLBufferFromDirtyVertexRange];
+	[self freeRetiredVertexStorage];
+}
+
+
+#pragma mark Vertex storage
+
+/**
+ * Returns the vertex storage, and sets the number of bytes of it that may be read into pLength.
+ * Both are read together under the lock, so that they remain consistent while another thread
+ * replaces the storage. The storage may be read by the render thread until it next performs the
+ * pending GL updates of this instance, even if another thread replaces it in the meantime.
+ */
+-(GLvoid*) vertexStorageOfLength: (GLuint*) pLength {
+	OSSpinLockLock(&_glStateLock);
+	GLvoid* vtxs = _vertices;
+	GLuint vtxLen = _vertexStorageLength;
+	OSSpinLockUnlock(&_glStateLock);
+
+	// Storage set externally through the vertices property is assumed to hold vertexCount vertices
+	*pLength = (vtxs && !vtxLen) ? (self.vertexStride * _vertexCount) : vtxLen;
+	return vtxs;
+}
+
+/** Replaces the vertex storage and its allocated length together under the lock. */
+-(void) publishVertexStorage: (GLvoid*) vtxs ofLength: (GLuint) vtxLen {
+	OSSpinLockLock(&_glStateLock);
+	_vertices = vtxs;
+	_vertexStorageLength = vtxLen;
+	OSSpinLockUnlock(&_glStateLock);
+}
+
+/**
+ * Frees the specified vertex storage, which has been replaced. On a thread other than the render
+ * thread, the render thread may still be copying the storage to the GL engine, so the storage is
+ * retired instead, and is freed by the render thread when it next performs the pending GL updates.
+ */
+-(void) retireVertexStorage: (GLvoid*) vtxs {
+	if ( !vtxs ) return;
+	if (CC3OpenGLESEngine.isRenderThread) {
+		free(vtxs);
+		return;
+	}
+	NSValue* retiredVtxs = [NSValue valueWithPointer: vtxs];
+	OSSpinLockLock(&_glStateLock);
+	if ( !_retiredVertexStorage ) _retiredVertexStorage = [[NSMutableArray alloc] init];
+	[_retiredVertexStorage addObject: retiredVtxs];
+	OSSpinLockUnlock(&_glStateLock);
+	LogTrace(@"%@ retiring vertex storage at %p until the render thread frees it", self, vtxs);
+	[self queuePendingGLUpdates];
+}
+
+/** Frees any retired vertex storage. The retired storage is swapped out under the lock. */
+-(void) freeRetiredVertexStorage {
+	OSSpinLockLock(&_glStateLock);
+	NSMutableArray* retiredStorage = _retiredVertexStorage;
+	_retiredVertexStorage = nil;
+	OSSpinLockUnlock(&_glStateLock);
+	for (NSValue* retiredVtxs in retiredStorage) free(retiredVtxs.pointerValue);
+	[retiredStorage release];
+}
+
+
+#pragma mark Streaming vertices
+
+-(void) setShouldStreamVertices: (BOOL) shouldStream {
+	_shouldStreamVertices = shouldStream;
+	if (_shouldStreamVertices) [self deleteGLBuffer];
+	_streamBufferID = 0;
+	[self clearDirtyVertexRange];
+	[self markDrawingChanged];
+}
+
+-(BOOL) isUsingStream { return _streamBufferID != 0; }
+
+/**
+ * Streams the vertex content to the GL engine through the shared vertex stream, unless it has
+ * already been streamed during the current frame and has not changed since, and the storage of
+ * the stream buffer has not been orphaned since it was streamed. The stream buffer
+ * is left bound to the GL engine. Returns whether the content is available in the stream buffer,
+ * in which case the offset of the content within that buffer is held in the _streamOffset ivar.
+ */
+-(BOOL) streamVertices {
+	CC3OpenGLESVertexStream* vtxStream = [CC3OpenGLESEngine.engine.vertices streamForTarget: self.bufferTarget];
+
+	// Take and clear the dirty range together, so that changes made by other threads are not lost
+	OSSpinLockLock(&_glStateLock);
+	BOOL isChanged = (_dirtyVertexRange.length > 0);
+	_dirtyVertexRange = NSMakeRange(0, 0);
+	OSSpinLockUnlock(&_glStateLock);
+
+	if (_streamBufferID && _streamFrame == vtxStream.frameCount &&
+		_streamGeneration == vtxStream.generation && !isChanged) {
+		LogTrace(@"%@ reusing streamed content at offset %u", self, _streamOffset);
+		[CC3OpenGLESEngine.engine.vertices bufferBinding: self.bufferTarget].value = _streamBufferID;
+		return YES;
+	}
+
+	GLuint vtxLen;
+	GLvoid* vtxs = [self vertexStorageOfLength: &vtxLen];
+	if ( !vtxs ) return NO;
+
+	GLintptr offset = 0;
+	_streamBufferID = [vtxStream streamData: vtxs
+								   ofLength: MIN(self.vertexStride * _vertexCount, vtxLen)
+								   toOffset: &offset
+								   canReuse: !isChanged];
+	_streamOffset = offset;
+	_streamFrame = vtxStream.frameCount;
+	_streamGeneration = vtxStream.generation;
+	LogTrace(@"%@ streamed %u vertices to GL buffer %u at offset %u", self, _vertexCount, _streamBufferID, _streamOffset);
+	return (_streamBufferID != 0);
+}
+
+
+#pragma mark Tracking dirty vertices
+
+-(NSRange) dirtyVertexRange {
+	OSSpinLockLock(&_glStateLock);
+	NSRange dirtyRange = _dirtyVertexRange;
+	OSSpinLockUnlock(&_glStateLock);
+	return dirtyRange;
+}
+
+-(void) addDirtyVertexRange: (NSRange) aRange {
+	OSSpinLockLock(&_glStateLock);
+	if (_bufferID || _streamBufferID) CC3ExpandDirtyVertexRange(&_dirtyVertexRange, aRange.location, aRange.length);
+	OSSpinLockUnlock(&_glStateLock);
+}
+
+-(void) addDirtyVertex: (GLuint) vtxIdx {
+	OSSpinLockLock(&_glStateLock);
+	if (_bufferID || _streamBufferID) CC3ExpandDirtyVertexRange(&_dirtyVertexRange, vtxIdx, 1);
+	OSSpinLockUnlock(&_glStateLock);
+}
+
+/**
+ * If the specified address lies within the vertex content of this instance, marks the
+ * specified number of vertices, starting at the vertex containing that address, as dirty.
+ */
+-(void) addDirtyVertices: (GLuint) vtxCount atAddress: (GLvoid*) vtxPtr {
+	if ( !((_bufferID || _streamBufferID) && _vertices) ) return;
+	GLuint vtxStride = self.vertexStride;
+	GLbyte* basePtr = (GLbyte*)_vertices;
+	GLbyte* endPtr = basePtr + (vtxStride * self.availableVertexCount);
+	if ((GLbyte*)vtxPtr < basePtr || (GLbyte*)vtxPtr >= endPtr) return;
+	OSSpinLockLock(&_glStateLock);
+	CC3ExpandDirtyVertexRange(&_dirtyVertexRange, ((GLbyte*)vtxPtr - basePtr) / vtxStride, vtxCount);
+	OSSpinLockUnlock(&_glStateLock);
+}
+
+-(void) markVerticesCleanStartingAt: (GLuint) offsetIndex forLength: (GLuint) vtxCount {
+	OSSpinLockLock(&_glStateLock);
+	if (_dirtyVertexRange.location >= offsetIndex &&
+		NSMaxRange(_dirtyVertexRange) <= (offsetIndex + vtxCount)) _dirtyVertexRange = NSMakeRange(0, 0);
+	OSSpinLockUnlock(&_glStateLock);
+}
+
+-(void) clearDirtyVertexRange {
+	OSSpinLockLock(&_glStateLock);
+	_dirtyVertexRange = NSMakeRange(0, 0);
+	OSSpinLockUnlock(&_glStateLock);
+}
+
+static GLfloat dirtyBufferReloadThreshold = 0.5f;
+
++(GLfloat) dirtyBufferReloadThreshold { return dirtyBufferReloadThreshold; }
+
++(void) setDirtyBufferReloadThreshold: (GLfloat) aFraction { dirtyBufferReloadThreshold = aFraction; }
+
+-(void) updateGLBufferFromDirtyVertexRange {
+	if ( !_bufferID ) return;
+
+	// Take and clear the dirty range together, so that changes made by other threads are not lost
+	OSSpinLockLock(&_glStateLock);
+	NSRange dirtyRange = _dirtyVertexRange;
+	_dirtyVertexRange = NSMakeRange(0, 0);
+	OSSpinLockUnlock(&_glStateLock);
+	if ( !dirtyRange.length ) return;
+
+	// Only the render thread may copy to the GL buffer. Leave the range for it to copy.
+	if ( !CC3OpenGLESEngine.isRenderThread ) {
+		[self addDirtyVertexRange: dirtyRange];
+		return;
+	}
+
+	GLuint vtxStride = self.vertexStride;
+	GLuint vtxLen;
+	GLvoid* vtxs = [self vertexStorageOfLength: &vtxLen];
+	GLuint vtxCap = vtxStride ? (vtxLen / vtxStride) : 0;
+	GLuint startIdx = MIN(dirtyRange.location, vtxCap);
+	GLuint vtxCount = MIN(NSMaxRange(dirtyRange), vtxCap) - startIdx;
+	if ( !(vtxs && vtxCount) ) return;
+
+	CC3OpenGLESStateTrackerArrayBufferBinding* bufferBinding;
+	bufferBinding = [CC3OpenGLESEngine.engine.vertices bufferBinding: self.bufferTarget];
+	bufferBinding.value = _bufferID;
+	if ((GLfloat)vtxCount >= (GLfloat)vtxCap * dirtyBufferReloadThreshold) {
+		LogTrace(@"%@ reloading GL buffer with %i vertices", self, vtxCap);
+		[bufferBinding loadBufferData: vtxs ofLength: (vtxStride * vtxCap) forUse: _bufferUsage];
+	} else {
+		LogTrace(@"%@ updating GL buffer with %i vertices starting at %i", self, vtxCount, startIdx);
+		[bufferBinding updateBufferData: vtxs
+							 startingAt: (startIdx * vtxStride)
+							  forLength: (vtxCount * vtxStride)];
+	}
+}
+
 -(void) releaseRedundantData {
-	if (_bufferID && _shouldReleaseRedundantData) {
+	if (_bufferID && _shouldReleaseRedundantData && !_shouldStreamVertices) {
 		GLuint currVtxCount = _vertexCount;
 		self.allocatedVertexCapacity = 0;
 		_vertexCount = currVtxCount;		// Maintain vertexCount for drawing
@@ -410,40 +778,78 @@ static GLuint lastAssignedVertexArrayTag;
  * Template method that binds the GL engine to the underlying vertex data,
  * in preparation for drawing.
  *
- * If the data has been copied into a VBO in GL memory, binds the GL engine to the bufferID
- * property, and invokes bindPointer: with the value of the elementOffset property.
- * If a VBO is not used, unbinds the GL from any VBO's, and invokes bindPointer: with a pointer
- * to the first data element managed by this vertex array instance.
+ * The binding is populated in the same way as when it is captured into a draw command,
+ * and is then resolved and applied immediately.
  */
 -(void) bindGLWithVisitor: (CC3NodeDrawingVisitor*) visitor {
-	if (_bufferID) {											// use GL buffer if it exists
-		LogTrace(@"%@ binding GL buffer containing %u vertices", self, _vertexCount);
-		[CC3OpenGLESEngine.engine.vertices bufferBinding: self.bufferTarget].value = _bufferID;
-		[self bindPointer: (GLvoid*)_elementOffset withVisitor: visitor];
-	} else if (_vertexCount && _vertices) {					// use local client array if it exists
-		LogTrace(@"%@ using local array containing %u vertices", self, _vertexCount);
-		[[CC3OpenGLESEngine.engine.vertices bufferBinding: self.bufferTarget] unbind];
-		[self bindPointer: (GLvoid*)((GLuint)_vertices + _elementOffset) withVisitor: visitor];
+	CC3DrawVertexBinding vtxBinding;
+	if ([self populateDrawVertexBinding: &vtxBinding withVisitor: visitor] &&
+		(!vtxBinding.vertexArray || [self resolveDrawVertexBinding: &vtxBinding])) {
+		CC3DrawVertexBindingApply(&vtxBinding);
 	} else {
 		LogTrace(@"%@ no vertices to bind", self);
 	}
 }
 
--(CC3OpenGLESStateTrackerVertexPointer*) vertexPointer {
-	return [CC3OpenGLESEngine.engine.vertices vertexPointerForSemantic: _semantic];
+/**
+ * If the content is held in a GL buffer, is streamed, or is waiting for a GL buffer to be
+ * created on the rendering thread, this vertex array must synchronize the content when the
+ * command is replayed, and is set into the binding. Otherwise, the binding points directly
+ * to the content in application memory.
+ */
+-(BOOL) populateDrawVertexBinding: (CC3DrawVertexBinding*) vtxBinding
+					  withVisitor: (CC3NodeDrawingVisitor*) visitor {
+	vtxBinding->bufferTarget = self.bufferTarget;
+	vtxBinding->semantic = _semantic;
+	vtxBinding->elementSize = _elementSize;
+	vtxBinding->elementType = _elementType;
+	vtxBinding->vertexStride = _vertexStride;
+	vtxBinding->shouldNormalize = _shouldNormalizeContent;
+
+	OSSpinLockLock(&_glStateLock);
+	BOOL isBufferPending = _shouldCreateGLBufferWhenBound;
+	OSSpinLockUnlock(&_glStateLock);
+
+	BOOL hasContent = (_vertexCount && _vertices);
+	if (_bufferID || isBufferPending || (_shouldStreamVertices && hasContent)) {
+		vtxBinding->vertexArray = self;
+		vtxBinding->bufferID = _bufferID;
+		vtxBinding->pointer = (GLvoid*)_elementOffset;
+		return YES;
+	}
+	vtxBinding->vertexArray = nil;
+	vtxBinding->bufferID = 0;
+	vtxBinding->pointer = (GLvoid*)((GLuint)_vertices + _elementOffset);
+	return hasContent;
 }
 
 /**
- * Template method that binds the GL engine to the values of the elementSize, elementType
- * and vertexStride properties, along with the specified data pointer, and enables the
- * type of aspect managed by this instance (locations, normals...) in the GL engine.
+ * If the creation of a VBO was requested from a thread other than the rendering thread,
+ * the VBO is created first.
+ *
+ * If the data has been copied into a VBO in GL memory, first copies any vertices in the
+ * dirtyVertexRange property to the VBO, and points the binding at the elementOffset within
+ * that VBO. If the content is streamed, points the binding at the content within the stream
+ * buffer. Otherwise, points the binding at the first element in application memory.
  */
--(void) bindPointer: (GLvoid*) pointer withVisitor: (CC3NodeDrawingVisitor*) visitor {
-	[self.vertexPointer bindElementsAt: pointer
-							  withSize: _elementSize
-							  withType: _elementType
-							withStride: _vertexStride
-				   withShouldNormalize: _shouldNormalizeContent];
+-(BOOL) resolveDrawVertexBinding: (CC3DrawVertexBinding*) vtxBinding {
+	[self createPendingGLBuffer];								// deferred from another thread
+	if (_bufferID) {											// use GL buffer if it exists
+		LogTrace(@"%@ binding GL buffer containing %u vertices", self, _vertexCount);
+		[self updateGLBufferFromDirtyVertexRange];
+		vtxBinding->bufferID = _bufferID;
+		vtxBinding->pointer = (GLvoid*)_elementOffset;
+	} else if (_shouldStreamVertices && _vertexCount && _vertices && [self streamVertices]) {	// stream content
+		vtxBinding->bufferID = _streamBufferID;
+		vtxBinding->pointer = (GLvoid*)(_streamOffset + _elementOffset);
+	} else if (_vertexCount && _vertices) {					// use local client array if it exists
+		LogTrace(@"%@ using local array containing %u vertices", self, _vertexCount);
+		vtxBinding->bufferID = 0;
+		vtxBinding->pointer = (GLvoid*)((GLuint)_vertices + _elementOffset);
+	} else {
+		return NO;
+	}
+	return YES;
 }
 
 
@@ -480,6 +886,7 @@ static GLuint lastAssignedVertexArrayTag;
 -(void) copyVertices: (GLuint) vtxCount fromAddress: (GLvoid*) srcPtr toAddress: (GLvoid*) dstPtr {
 	if (vtxCount == 0) return;	// Fail safe. Vertex address may be NULL if no vertices to copy.
 	memcpy(dstPtr, srcPtr, (vtxCount * self.vertexStride));
+	[self addDirtyVertices: vtxCount atAddress: dstPtr];
 }
 
 -(NSString*) describeVertices { return [self describeVertices: _vertexCount]; }
@@ -547,6 +954,21 @@ static GLuint lastAssignedVertexArrayTag;
 
 @synthesize drawingMode=_drawingMode, stripCount=_stripCount, stripLengths=_stripLengths;
 
+-(void) setDrawingMode: (GLenum) drawMode {
+	_drawingMode = drawMode;
+	[self markDrawingChanged];
+}
+
+-(void) setStripCount: (GLuint) sCount {
+	_stripCount = sCount;
+	[self markDrawingChanged];
+}
+
+-(void) setStripLengths: (GLuint*) sLengths {
+	_stripLengths = sLengths;
+	[self markDrawingChanged];
+}
+
 -(void) dealloc {
 	[self deallocateStripLengths];
 	[super dealloc];
@@ -592,6 +1014,34 @@ static GLuint lastAssignedVertexArrayTag;
 	[visitor.performanceStatistics addSingleCallFacesPresented: [self faceCountFromVertexIndexCount: vtxCount]];
 }
 
+/** All ranges are allocated together, because the size of each range is not a multiple of the content alignment. */
+-(void) populateDrawRangesOf: (CC3DrawCommand*) aCommand withVisitor: (CC3NodeDrawingVisitor*) visitor {
+	CC3DrawCommandList* cmdList = visitor.commandList;
+	GLuint rngCount = _stripCount ? _stripCount : 1;
+	aCommand->drawRangesOffset = [cmdList allocateContent: (rngCount * sizeof(CC3DrawRange))
+											   forCommand: aCommand];
+	aCommand->drawRangeCount = rngCount;
+
+	CC3DrawRange* ranges = [cmdList contentAt: aCommand->drawRangesOffset ofCommand: aCommand];
+	if (_stripCount) {
+		GLuint startOfStrip = 0;
+		for (GLuint i = 0; i < _stripCount; i++) {
+			GLuint stripLen = _stripLengths[i];
+			[self populateDrawRange: &ranges[i] from: startOfStrip forCount: stripLen];
+			startOfStrip += stripLen;
+		}
+	} else {
+		[self populateDrawRange: &ranges[0] from: 0 forCount: _vertexCount];
+	}
+	for (GLuint i = 0; i < rngCount; i++) aCommand->faceCount += ranges[i].faceCount;
+}
+
+-(void) populateDrawRange: (CC3DrawRange*) aRange from: (GLuint) vtxIdx forCount: (GLuint) vtxCount {
+	aRange->start = vtxIdx;
+	aRange->count = vtxCount;
+	aRange->faceCount = [self faceCountFromVertexIndexCount: vtxCount];
+}
+
 -(void) allocateStripLengths: (GLuint) sCount {
 	[self deallocateStripLengths];			// get rid of any existing array
 	
@@ -599,6 +1049,7 @@ static GLuint lastAssignedVertexArrayTag;
 		_stripCount = sCount;
 		_stripLengths = calloc(_stripCount, sizeof(GLuint));
 		_stripLengthsAreRetained = YES;
+		[self markDrawingChanged];
 	}
 }
 
@@ -609,6 +1060,7 @@ static GLuint lastAssignedVertexArrayTag;
 	}
 	_stripLengths = NULL;
 	_stripCount = 0;
+	[self markDrawingChanged];
 }
 
 /** Converts the specified vertex count to a face count, based on the drawingMode property. */
@@ -777,6 +1229,9 @@ static GLuint lastAssignedVertexArrayTag;
 -(void) buildBoundingBoxIfNecessary;
 -(void) calcRadius;
 -(void) calcRadiusIfNecessary;
+-(BOOL) canMeasureLocationsDirectly;
+-(CC3Vector) quantizedLocationAt: (GLuint) index;
+-(void) setQuantizedLocation: (CC3Vector) aLocation at: (GLuint) index;
 @end
 
 
@@ -784,6 +1239,11 @@ static GLuint lastAssignedVertexArrayTag;
 
 @synthesize firstElement=_firstElement;
 
+-(void) setFirstElement: (GLuint) firstElem {
+	_firstElement = firstElem;
+	[self markDrawingChanged];
+}
+
 -(void) markBoundaryDirty {
 	_boundaryIsDirty = YES;
 	_radiusIsDirty = YES;
@@ -810,11 +1270,61 @@ static GLuint lastAssignedVertexArrayTag;
 	_boundingBox = another.boundingBox;
 	_centerOfGeometry = another.centerOfGeometry;
 	_radius = another.radius;
+	_unpackScale = another.unpackScale;
+	_unpackOffset = another.unpackOffset;
 	_boundaryIsDirty = another.boundaryIsDirty;
 	_radiusIsDirty = another.radiusIsDirty;
 }
 
+
+#pragma mark Quantization
+
+@synthesize unpackScale=_unpackScale, unpackOffset=_unpackOffset;
+
+-(BOOL) isQuantized { return (_elementType == GL_SHORT); }
+
+-(void) setUnpackScale: (GLfloat) scale {
+	_unpackScale = scale;
+	[self markBoundaryDirty];
+}
+
+-(void) setUnpackOffset: (CC3Vector) offset {
+	_unpackOffset = offset;
+	[self markBoundaryDirty];
+}
+
+-(void) populateUnpackMatrix: (CC3Matrix4x4*) mtx {
+	if (self.isQuantized) {
+		CC3Matrix4x4PopulateFromScale(mtx, cc3v(_unpackScale, _unpackScale, _unpackScale));
+		mtx->c4r1 = _unpackOffset.x;
+		mtx->c4r2 = _unpackOffset.y;
+		mtx->c4r3 = _unpackOffset.z;
+	} else {
+		CC3Matrix4x4PopulateIdentity(mtx);
+	}
+}
+
+/** Returns the quantized location at the specified index, converted to mesh coordinates. */
+-(CC3Vector) quantizedLocationAt: (GLuint) index {
+	GLshort* qLoc = (GLshort*)[self addressOfElement: index];
+	CC3Vector loc = cc3v(qLoc[0], qLoc[1], ((_elementSize > 2) ? qLoc[2] : 0));
+	return CC3VectorAdd(CC3VectorScaleUniform(loc, _unpackScale), _unpackOffset);
+}
+
+/** Converts the specified location to quantized form and stores it at the specified index. */
+-(void) setQuantizedLocation: (CC3Vector) aLocation at: (GLuint) index {
+	GLshort* qLoc = (GLshort*)[self addressOfElement: index];
+	CC3Vector loc = CC3VectorScaleUniform(CC3VectorDifference(aLocation, _unpackOffset), (1.0f / _unpackScale));
+	qLoc[0] = CC3QuantizeToGLshort(loc.x);
+	qLoc[1] = CC3QuantizeToGLshort(loc.y);
+	if (_elementSize > 2) qLoc[2] = CC3QuantizeToGLshort(loc.z);
+	if (_elementSize > 3) qLoc[3] = 1;
+	[self addDirtyVertex: index];
+}
+
 -(CC3Vector) locationAt: (GLuint) index {
+	if (self.isQuantized) return [self quantizedLocationAt: index];
+
 	CC3Vector loc = *(CC3Vector*)[self addressOfElement: index];
 	switch (_elementSize) {
 		case 2:
@@ -828,6 +1338,12 @@ static GLuint lastAssignedVertexArrayTag;
 }
 
 -(void) setLocation: (CC3Vector) aLocation at: (GLuint) index {
+	if (self.isQuantized) {
+		[self setQuantizedLocation: aLocation at: index];
+		[self markBoundaryDirty];
+		return;
+	}
+
 	GLvoid* elemAddr = [self addressOfElement: index];
 	switch (_elementSize) {
 		case 2:		// Just store X & Y
@@ -841,10 +1357,13 @@ static GLuint lastAssignedVertexArrayTag;
 			*(CC3Vector*)elemAddr = aLocation;
 			break;
 	}
+	[self addDirtyVertex: index];
 	[self markBoundaryDirty];
 }
 
 -(CC3Vector4) homogeneousLocationAt: (GLuint) index {
+	if (self.isQuantized) return CC3Vector4FromLocation([self quantizedLocationAt: index]);
+
 	CC3Vector4 hLoc = *(CC3Vector4*)[self addressOfElement: index];
 	switch (_elementSize) {
 		case 2:
@@ -859,6 +1378,12 @@ static GLuint lastAssignedVertexArrayTag;
 }
 
 -(void) setHomogeneousLocation: (CC3Vector4) aLocation at: (GLuint) index {
+	if (self.isQuantized) {
+		[self setQuantizedLocation: CC3VectorFromTruncatedCC3Vector4(aLocation) at: index];
+		[self markBoundaryDirty];
+		return;
+	}
+
 	GLvoid* elemAddr = [self addressOfElement: index];
 	switch (_elementSize) {
 		case 2:		// Just store X & Y
@@ -872,6 +1397,7 @@ static GLuint lastAssignedVertexArrayTag;
 			*(CC3Vector4*)elemAddr = aLocation;
 			break;
 	}
+	[self addDirtyVertex: index];
 	[self markBoundaryDirty];
 }
 
@@ -917,19 +1443,23 @@ static GLuint lastAssignedVertexArrayTag;
 -(void) buildBoundingBox {
 	// If we don't have vertices, but do have a non-zero vertexCount, raise an assertion
 	NSAssert1( !( !_vertices && _vertexCount ), @"%@ bounding box requested after vertex data have been released", self);
-	NSAssert1(_elementType == GL_FLOAT, @"%@ must have elementType GLFLOAT to build the bounding box", self);
-
-	CC3Vector vl, vlMin, vlMax;
-	vl = (_vertexCount > 0) ? [self locationAt: 0] : kCC3VectorZero;
-	vlMin = vl;
-	vlMax = vl;
-	for (GLuint i = 1; i < _vertexCount; i++) {
-		vl = [self locationAt: i];
-		vlMin = CC3VectorMinimize(vlMin, vl);
-		vlMax = CC3VectorMaximize(vlMax, vl);
-	}
-	_boundingBox.minimum = vlMin;
-	_boundingBox.maximum = vlMax;
+	NSAssert1(_elementType == GL_FLOAT || self.isQuantized, @"%@ must have elementType GLFLOAT or GL_SHORT to build the bounding box", self);
+
+	if (self.canMeasureLocationsDirectly) {
+		_boundingBox = CC3BoundingBoxFromLocations([self addressOfElement: 0], _vertexCount, self.vertexStride);
+	} else {
+		CC3Vector vl, vlMin, vlMax;
+		vl = (_vertexCount > 0) ? [self locationAt: 0] : kCC3VectorZero;
+		vlMin = vl;
+		vlMax = vl;
+		for (GLuint i = 1; i < _vertexCount; i++) {
+			vl = [self locationAt: i];
+			vlMin = CC3VectorMinimize(vlMin, vl);
+			vlMax = CC3VectorMaximize(vlMax, vl);
+		}
+		_boundingBox.minimum = vlMin;
+		_boundingBox.maximum = vlMax;
+	}
 	_centerOfGeometry = CC3BoundingBoxCenter(_boundingBox);
 	_boundaryIsDirty = NO;
 	LogTrace(@"%@ bounding box: (%@, %@) and center of geometry: %@", self,
@@ -946,25 +1476,51 @@ static GLuint lastAssignedVertexArrayTag;
  * for the first time after the boundary has been marked dirty.
  */
 -(void) calcRadius {
-	NSAssert1(_elementType == GL_FLOAT, @"%@ must have elementType GLFLOAT to calculate mesh radius", [self class]);
+	NSAssert1(_elementType == GL_FLOAT || self.isQuantized, @"%@ must have elementType GLFLOAT or GL_SHORT to calculate mesh radius", [self class]);
 
 	CC3Vector cog = self.centerOfGeometry;		// Will measure it if necessary
 	if (_vertices && _vertexCount) {
-		// Work with the square of the radius so that all distances can be compared
-		// without having to run expensive square-root calculations.
-		GLfloat radiusSq = 0.0;
-		for (GLuint i=0; i < _vertexCount; i++) {
-			CC3Vector vl = [self locationAt: i];
-			GLfloat distSq = CC3VectorDistanceSquared(vl, cog);
-			radiusSq = MAX(radiusSq, distSq);
+		if (self.canMeasureLocationsDirectly) {
+			_radius = CC3RadiusOfLocationsFromCenter(cog, [self addressOfElement: 0], _vertexCount, self.vertexStride);
+		} else {
+			// Work with the square of the radius so that all distances can be compared
+			// without having to run expensive square-root calculations.
+			GLfloat radiusSq = 0.0;
+			for (GLuint i=0; i < _vertexCount; i++) {
+				CC3Vector vl = [self locationAt: i];
+				GLfloat distSq = CC3VectorDistanceSquared(vl, cog);
+				radiusSq = MAX(radiusSq, distSq);
+			}
+			_radius = sqrtf(radiusSq);		// Now finally take the square-root
 		}
-		_radius = sqrtf(radiusSq);		// Now finally take the square-root
 		_radiusIsDirty = NO;
 		LogTrace(@"%@ setting radius to %.2f", self, radius);
 	}
 }
 
+/**
+ * Returns whether the locations are stored as floats with at least three components,
+ * and can therefore be measured in bulk, directly from the vertex content.
+ */
+-(BOOL) canMeasureLocationsDirectly {
+	return _vertices && _vertexCount && _elementType == GL_FLOAT && _elementSize >= 3;
+}
+
+-(CC3Sphere) minimalBoundingSphere {
+	CC3Sphere cogSphere = CC3SphereMake(self.centerOfGeometry, self.radius);
+	if ( !self.canMeasureLocationsDirectly ) return cogSphere;
+
+	CC3Sphere minSphere = CC3SphereFromLocations([self addressOfElement: 0], _vertexCount, self.vertexStride);
+	return (minSphere.radius < cogSphere.radius) ? minSphere : cogSphere;
+}
+
 -(void) moveMeshOriginTo: (CC3Vector) aLocation {
+	// Quantized locations can be moved without loss by shifting the unpack offset
+	if (self.isQuantized) {
+		self.unpackOffset = CC3VectorDifference(_unpackOffset, aLocation);
+		return;
+	}
+
 	for (GLuint i = 0; i < _vertexCount; i++) {
 		CC3Vector locOld = [self locationAt: i];
 		CC3Vector locNew = CC3VectorDifference(locOld, aLocation);
@@ -983,13 +1539,6 @@ static GLuint lastAssignedVertexArrayTag;
 
 #pragma mark Drawing
 
--(CC3OpenGLESStateTrackerVertexPointer*) vertexPointer {
-	CC3OpenGLESStateTrackerVertexPointer* vtxPtr = super.vertexPointer;
-	NSAssert2(vtxPtr, @"%@ could not retrieve the vertex pointer for semantic %@. Vertex locations are required for drawing.",
-			  self, NSStringFromCC3Semantic(_semantic));
-	return vtxPtr;
-}
-
 /** Overridden to ensure the bounding box and radius are built before releasing the vertices. */
 -(void) releaseRedundantData {
 	[self buildBoundingBoxIfNecessary];
@@ -1002,10 +1551,16 @@ static GLuint lastAssignedVertexArrayTag;
 	 withVisitor: (CC3NodeDrawingVisitor*) visitor {
 	[super drawFrom: vtxIdx forCount: vtxCount withVisitor: visitor];
 
-	GLuint firstVertex = self.firstElement + (self.vertexStride * vtxIdx);
+	CC3DrawRange range;
+	[self populateDrawRange: &range from: vtxIdx forCount: vtxCount];
 	[[CC3OpenGLESEngine engine].vertices drawVerticiesAs: _drawingMode
-												startingAt: firstVertex
-												withLength: vtxCount];
+												startingAt: range.start
+												withLength: range.count];
+}
+
+-(void) populateDrawRange: (CC3DrawRange*) aRange from: (GLuint) vtxIdx forCount: (GLuint) vtxCount {
+	[super populateDrawRange: aRange from: vtxIdx forCount: vtxCount];
+	aRange->start = _firstElement + (self.vertexStride * vtxIdx);
 }
 
 
@@ -1019,6 +1574,8 @@ static GLuint lastAssignedVertexArrayTag;
 		_centerOfGeometry = kCC3VectorZero;
 		_boundingBox = kCC3BoundingBoxZero;
 		_radius = 0.0;
+		_unpackScale = 1.0f;
+		_unpackOffset = kCC3VectorZero;
 		[self markBoundaryDirty];
 	}
 	return self;
@@ -1034,10 +1591,27 @@ static GLuint lastAssignedVertexArrayTag;
 
 @implementation CC3VertexNormals
 
--(CC3Vector) normalAt: (GLuint) index { return *(CC3Vector*)[self addressOfElement: index]; }
+-(BOOL) isQuantized { return (_elementType == GL_BYTE); }
+
+-(CC3Vector) normalAt: (GLuint) index {
+	if (self.isQuantized) {
+		GLbyte* qNorm = (GLbyte*)[self addressOfElement: index];
+		return cc3v(CC3DequantizeGLbyte(qNorm[0]), CC3DequantizeGLbyte(qNorm[1]), CC3DequantizeGLbyte(qNorm[2]));
+	}
+	return *(CC3Vector*)[self addressOfElement: index];
+}
 
 -(void) setNormal: (CC3Vector) aNormal at: (GLuint) index {
-	*(CC3Vector*)[self addressOfElement: index] = aNormal;
+	if (self.isQuantized) {
+		GLbyte* qNorm = (GLbyte*)[self addressOfElement: index];
+		qNorm[0] = CC3QuantizeToGLbyte(aNormal.x);
+		qNorm[1] = CC3QuantizeToGLbyte(aNormal.y);
+		qNorm[2] = CC3QuantizeToGLbyte(aNormal.z);
+		if (_elementSize > 3) qNorm[3] = 0;
+	} else {
+		*(CC3Vector*)[self addressOfElement: index] = aNormal;
+	}
+	[self addDirtyVertex: index];
 }
 
 
@@ -1081,6 +1655,7 @@ static GLuint lastAssignedVertexArrayTag;
 		default:
 			*(ccColor4F*)[self addressOfElement: index] = aColor;
 	}
+	[self addDirtyVertex: index];
 }
 
 -(ccColor4B) color4BAt: (GLuint) index {
@@ -1104,19 +1679,7 @@ static GLuint lastAssignedVertexArrayTag;
 		default:
 			*(ccColor4B*)[self addressOfElement: index] = aColor;
 	}
-}
-
-/**
- * Since material color tracking mucks with both ambient and diffuse material colors under
- * the covers, we won't really know what the ambient and diffuse material color values will
- * be when we get back to setting them...so indicate that to the corresponding trackers.
- */
--(void) bindPointer: (GLvoid*) pointer withVisitor: (CC3NodeDrawingVisitor*) visitor {
-	[super bindPointer:pointer withVisitor:visitor];
-	
-	CC3OpenGLESMaterials* glesMaterials = CC3OpenGLESEngine.engine.materials;
-	glesMaterials.ambientColor.valueIsKnown = NO;
-	glesMaterials.diffuseColor.valueIsKnown = NO;
+	[self addDirtyVertex: index];
 }
 
 
@@ -1227,23 +1790,46 @@ static BOOL defaultExpectsVerticallyFlippedTextures = YES;
 	defaultExpectsVerticallyFlippedTextures = expectsFlipped;
 }
 
+-(BOOL) isQuantized { return (_elementType == GL_UNSIGNED_SHORT); }
+
+-(BOOL) canQuantize {
+#if CC3_OGLES_2
+	if ( !(_elementType == GL_FLOAT && _elementSize == 2) ) return NO;
+	for (GLuint i = 0; i < _vertexCount; i++) {
+		ccTex2F tc = [self texCoord2FAt: i];
+		if (tc.u < 0.0f || tc.u > 1.0f || tc.v < 0.0f || tc.v > 1.0f) return NO;
+	}
+	return YES;
+#else
+	return NO;		// OpenGL ES 1 does not support normalized texture coordinates
+#endif
+}
+
 -(ccTex2F) texCoord2FAt: (GLuint) index {
+	if (self.isQuantized) {
+		GLushort* qTex = (GLushort*)[self addressOfElement: index];
+		return (ccTex2F){ CC3DequantizeGLushort(qTex[0]), CC3DequantizeGLushort(qTex[1]) };
+	}
 	return *(ccTex2F*)[self addressOfElement: index];
 }
 
 -(void) setTexCoord2F: (ccTex2F) aTex2F at: (GLuint) index {
-	*(ccTex2F*)[self addressOfElement: index] = aTex2F;
+	if (self.isQuantized) {
+		GLushort* qTex = (GLushort*)[self addressOfElement: index];
+		qTex[0] = CC3QuantizeToGLushort(aTex2F.u);
+		qTex[1] = CC3QuantizeToGLushort(aTex2F.v);
+	} else {
+		*(ccTex2F*)[self addressOfElement: index] = aTex2F;
+	}
+	[self addDirtyVertex: index];
 }
 
 /** Offsets the semantic by the texture unit index. */
--(void) bindPointer: (GLvoid*) pointer withVisitor: (CC3NodeDrawingVisitor*) visitor {
-	CC3OpenGLESStateTrackerVertexPointer* vtxPtr;
-	vtxPtr = [CC3OpenGLESEngine.engine.vertices vertexPointerForSemantic: (_semantic + visitor.textureUnit)];
-	[vtxPtr bindElementsAt: pointer
-				  withSize: _elementSize
-				  withType: _elementType
-				withStride: _vertexStride
-	   withShouldNormalize: _shouldNormalizeContent];
+-(BOOL) populateDrawVertexBinding: (CC3DrawVertexBinding*) vtxBinding
+					  withVisitor: (CC3NodeDrawingVisitor*) visitor {
+	BOOL hasContent = [super populateDrawVertexBinding: vtxBinding withVisitor: visitor];
+	vtxBinding->semantic = _semantic + visitor.textureUnit;
+	return hasContent;
 }
 
 /**
@@ -1273,19 +1859,20 @@ static BOOL defaultExpectsVerticallyFlippedTextures = YES;
 	// the mapSize and the old texture rectangle. Then, convert to the new coordinate, taking into
 	// consideration the mapSize and the new texture rectangle.
 	for (GLuint i = 0; i < _vertexCount; i++) {
-		ccTex2F* ptc = (ccTex2F*)[self addressOfElement: i];
+		ccTex2F tc = [self texCoord2FAt: i];
 		
-		GLfloat origU = ((ptc->u / mw) - ox) / ow;			// Revert to original value
-		ptc->u = (nx + (origU * nw)) * mw;					// Calc new value
+		GLfloat origU = ((tc.u / mw) - ox) / ow;			// Revert to original value
+		tc.u = (nx + (origU * nw)) * mw;					// Calc new value
 		
 		// Take into consideration whether the texture is flipped.
 		if (_expectsVerticallyFlippedTextures) {
-			GLfloat origV = (1.0f - (ptc->v / mh) - oy) / oh;	// Revert to original value
-			ptc->v = (1.0f - (ny + (origV * nh))) * mh;			// Calc new value
+			GLfloat origV = (1.0f - (tc.v / mh) - oy) / oh;	// Revert to original value
+			tc.v = (1.0f - (ny + (origV * nh))) * mh;			// Calc new value
 		} else {
-			GLfloat origV = ((ptc->v / mh) - oy) / oh;			// Revert to original value
-			ptc->v = (ny + (origV * nh)) * mh;					// Calc new value
+			GLfloat origV = ((tc.v / mh) - oy) / oh;			// Revert to original value
+			tc.v = (ny + (origV * nh)) * mh;					// Calc new value
 		}
+		[self setTexCoord2F: tc at: i];
 	}
 }
 
@@ -1304,9 +1891,10 @@ static BOOL defaultExpectsVerticallyFlippedTextures = YES;
 	CGSize mapRatio = CGSizeMake(texMapSize.width / _mapSize.width, texMapSize.height / _mapSize.height);
 	
 	for (GLuint i = 0; i < _vertexCount; i++) {
-		ccTex2F* ptc = (ccTex2F*)[self addressOfElement: i];
-		ptc->u *= mapRatio.width;
-		ptc->v *= mapRatio.height;
+		ccTex2F tc = [self texCoord2FAt: i];
+		tc.u *= mapRatio.width;
+		tc.v *= mapRatio.height;
+		[self setTexCoord2F: tc at: i];
 	}
 	_mapSize = texMapSize;	// Remember what we've set the map size to
 
@@ -1322,9 +1910,10 @@ static BOOL defaultExpectsVerticallyFlippedTextures = YES;
 	CGSize mapRatio = CGSizeMake(texMapSize.width / _mapSize.width, texMapSize.height / _mapSize.height);
 	
 	for (GLuint i = 0; i < _vertexCount; i++) {
-		ccTex2F* ptc = (ccTex2F*)[self addressOfElement: i];
-		ptc->u *= mapRatio.width;
-		ptc->v = texMapSize.height - (ptc->v * mapRatio.height);
+		ccTex2F tc = [self texCoord2FAt: i];
+		tc.u *= mapRatio.width;
+		tc.v = texMapSize.height - (tc.v * mapRatio.height);
+		[self setTexCoord2F: tc at: i];
 	}
 
 	// Remember that we've flipped and what we've set the map size to
@@ -1352,13 +1941,14 @@ static BOOL defaultExpectsVerticallyFlippedTextures = YES;
 	GLfloat minV = kCC3MaxGLfloat;
 	GLfloat maxV = -kCC3MaxGLfloat;
 	for (GLuint i = 0; i < _vertexCount; i++) {
-		ccTex2F* ptc = (ccTex2F*)[self addressOfElement: i];
-		minV = MIN(ptc->v, minV);
-		maxV = MAX(ptc->v, maxV);
+		ccTex2F tc = [self texCoord2FAt: i];
+		minV = MIN(tc.v, minV);
+		maxV = MAX(tc.v, maxV);
 	}
 	for (GLuint i = 0; i < _vertexCount; i++) {
-		ccTex2F* ptc = (ccTex2F*)[self addressOfElement: i];
-		ptc->v = minV + maxV - ptc->v;
+		ccTex2F tc = [self texCoord2FAt: i];
+		tc.v = minV + maxV - tc.v;
+		[self setTexCoord2F: tc at: i];
 	}
 }
 
@@ -1366,13 +1956,14 @@ static BOOL defaultExpectsVerticallyFlippedTextures = YES;
 	GLfloat minU = kCC3MaxGLfloat;
 	GLfloat maxU = -kCC3MaxGLfloat;
 	for (GLuint i = 0; i < _vertexCount; i++) {
-		ccTex2F* ptc = (ccTex2F*)[self addressOfElement: i];
-		minU = MIN(ptc->u, minU);
-		maxU = MAX(ptc->u, maxU);
+		ccTex2F tc = [self texCoord2FAt: i];
+		minU = MIN(tc.u, minU);
+		maxU = MAX(tc.u, maxU);
 	}
 	for (GLuint i = 0; i < _vertexCount; i++) {
-		ccTex2F* ptc = (ccTex2F*)[self addressOfElement: i];
-		ptc->u = minU + maxU - ptc->u;
+		ccTex2F tc = [self texCoord2FAt: i];
+		tc.u = minU + maxU - tc.u;
+		[self setTexCoord2F: tc at: i];
 	}
 }
 
@@ -1409,7 +2000,11 @@ static BOOL defaultExpectsVerticallyFlippedTextures = YES;
 
 -(GLenum) bufferTarget { return GL_ELEMENT_ARRAY_BUFFER; }
 
--(GLuint) firstElement { return _bufferID ? _elementOffset : ((GLuint)_vertices + _elementOffset); }
+-(GLuint) firstElement {
+	if (_bufferID) return _elementOffset;
+	if (_streamBufferID) return _streamOffset + _elementOffset;
+	return (GLuint)_vertices + _elementOffset;
+}
 
 // Deprecated
 -(GLuint*) allocateTriangles: (GLuint) triangleCount {
@@ -1431,6 +2026,7 @@ static BOOL defaultExpectsVerticallyFlippedTextures = YES;
 	} else {
 		*(GLushort*)ptr = vtxIdx;
 	}
+	[self addDirtyVertex: index];
 }
 
 -(CC3FaceIndices) faceIndicesAt: (GLuint) faceIndex {
@@ -1440,31 +2036,27 @@ static BOOL defaultExpectsVerticallyFlippedTextures = YES;
 							  [self indexAt: idxIndices.vertices[2]]);
 }
 
--(void) bindGLWithVisitor: (CC3NodeDrawingVisitor*) visitor {
-	if (_bufferID) {									// use GL buffer if it exists
-		LogTrace(@"%@ binding GL buffer", self);
-		[[CC3OpenGLESEngine engine].vertices bufferBinding: self.bufferTarget].value = _bufferID;
-	} else if (_vertexCount && _vertices) {			// use local client array if it exists
-		LogTrace(@"%@ using local array", self);
-		[[[CC3OpenGLESEngine engine].vertices bufferBinding: self.bufferTarget] unbind];
-	} else {
-		LogTrace(@"%@ no vertices to bind", self);
-	}
-}
-
 //+(void) unbind { [self resetSwitching]; }
 
 -(void) drawFrom: (GLuint) vtxIdx
 		forCount: (GLuint) vtxCount
 	 withVisitor: (CC3NodeDrawingVisitor*) visitor {
 	[super drawFrom: vtxIdx forCount: vtxCount withVisitor: visitor];
-	GLuint firstVertex = self.firstElement + (self.vertexStride * vtxIdx);
-	[[CC3OpenGLESEngine engine].vertices drawIndicies: (GLvoid*)firstVertex
-											   ofLength: vtxCount
+
+	CC3DrawRange range;
+	[self populateDrawRange: &range from: vtxIdx forCount: vtxCount];
+	[[CC3OpenGLESEngine engine].vertices drawIndicies: (GLvoid*)(self.firstElement + range.start)
+											   ofLength: range.count
 												andType: _elementType
 													 as: _drawingMode];
 }
 
+/** The start of the range is the offset in bytes from the start of the indices. */
+-(void) populateDrawRange: (CC3DrawRange*) aRange from: (GLuint) vtxIdx forCount: (GLuint) vtxCount {
+	[super populateDrawRange: aRange from: vtxIdx forCount: vtxCount];
+	aRange->start = self.vertexStride * vtxIdx;
+}
+
 -(void) populateFromRunLengthArray: (GLushort*) runLenArray ofLength: (GLuint) rlaLen {
 	GLuint elemNum, rlaIdx, runNum;
 	
@@ -1531,6 +2123,7 @@ static BOOL defaultExpectsVerticallyFlippedTextures = YES;
 			dstShort[vtxIdx] = srcShort[vtxIdx] + offset;
 		}
 	}
+	[self addDirtyVertices: vtxCount atAddress: dstPtr];
 }
 
 
@@ -1560,6 +2153,7 @@ static BOOL defaultExpectsVerticallyFlippedTextures = YES;
 
 -(void) setPointSize: (GLfloat) aSize at: (GLuint) index {
 	*(GLfloat*)[self addressOfElement: index] = aSize;
+	[self addDirtyVertex: index];
 }
 
 
@@ -1593,6 +2187,7 @@ static BOOL defaultExpectsVerticallyFlippedTextures = YES;
 	for (int i = 0; i < numWts; i++) {
 		vertexWeights[i] = weights[i];
 	}
+	[self addDirtyVertex: index];
 }
 
 -(GLfloat) weightForVertexUnit: (GLuint) vertexUnit at: (GLuint) index {
@@ -1601,6 +2196,7 @@ static BOOL defaultExpectsVerticallyFlippedTextures = YES;
 
 -(void) setWeight: (GLfloat) aWeight forVertexUnit: (GLuint) vertexUnit at: (GLuint) index {
 	[self weightsAt: index][vertexUnit] = aWeight;
+	[self addDirtyVertex: index];
 }
 
 
@@ -1641,6 +2237,7 @@ static BOOL defaultExpectsVerticallyFlippedTextures = YES;
 			vertexMatrices[i] = ((GLushort*)mtxIndices)[i];
 		}
 	}
+	[self addDirtyVertex: index];
 }
 
 -(GLuint) matrixIndexForVertexUnit: (GLuint) vertexUnit at: (GLuint) index {
@@ -1661,6 +2258,7 @@ static BOOL defaultExpectsVerticallyFlippedTextures = YES;
 		GLushort* vertexMatrices = (GLushort*)[self addressOfElement: index];
 		vertexMatrices[vertexUnit] = aMatrixIndex;
 	}
+	[self addDirtyVertex: index];
 }
 
 
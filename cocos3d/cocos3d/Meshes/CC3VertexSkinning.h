@@ -35,7 +35,8 @@
 #import "CC3VertexArrayMesh.h"
 #import "CC3VertexArrays.h"
 
-@class CC3SkinMesh, CC3Bone, CC3SkinSection, CC3SoftBodyNode, CC3DeformedFaceArray;
+@class CC3SkinMesh, CC3Bone, CC3SkinSection, CC3SoftBodyNode, CC3DeformedFaceArray, CC3NodeAnimationBatch,
+		CC3NodeAnimationBlender, CC3AnimationLODPolicy;
 
 
 #pragma mark -
@@ -120,8 +121,119 @@
  *
  * If the CC3SoftBodyNode has been assembled from a file loader, the bindRestPose method
  * will usually be invoked automatically, and you do not need to invoke it explicitly.
+ *
+ * A soft-body object typically contains many animated bones. To reduce the cost of animating
+ * those bones, you can invoke the batchAnimation method to have all of the bones sampled
+ * together in a single pass by a CC3NodeAnimationBatch. To blend several weighted animation
+ * clips, you can set a CC3NodeAnimationBlender into the animationBlender property. To reduce
+ * the cost of animating characters that appear small on the screen, or are not visible, you
+ * can set a CC3AnimationLODPolicy into the animationLODPolicy property.
+ */
+@interface CC3SoftBodyNode : CC3Node {
+	CC3NodeAnimationBatch* animationBatch;
+	CC3NodeAnimationBlender* animationBlender;
+	CC3AnimationLODPolicy* animationLODPolicy;
+	CC3BoundingBox animationLODBoundingBox;
+	ccTime pendingAnimationTime;
+	GLuint animationFrameInterval;
+	GLuint animationNodeDepthLimit;
+	GLuint animationLODFrameCount;
+	GLuint animatedBoneCount;
+	GLuint animatedBoneDepthLimit;
+	GLuint animatedBoneCountWithinDepthLimit;
+	BOOL hasPendingAnimationFrame : 1;
+	BOOL isAnimationFrozen : 1;
+	BOOL isAnimationLODBoundaryDirty : 1;
+}
+
+/**
+ * The animation batch used to animate the animated nodes within this soft-body node,
+ * including the bones of the skeleton.
+ *
+ * When this property is not nil, the establishAnimationFrameAt: method delegates to this
+ * animation batch, instead of having each descendant node animate itself individually.
+ * Set this property to nil to revert to animating each descendant node individually.
+ *
+ * The initial value of this property is nil. When this node is copied, the copy will create
+ * its own animation batch if this node has an animation batch.
  */
-@interface CC3SoftBodyNode : CC3Node
+@property(nonatomic, retain) CC3NodeAnimationBatch* animationBatch;
+
+/**
+ * Creates a new CC3NodeAnimationBatch from the animated nodes within this soft-body node,
+ * and sets it into the animationBatch property.
+ *
+ * Invoke this method once the skeleton and its animation have been assembled, typically
+ * after loading from a file. If the structure of the skeleton, or the animation of any of
+ * its bones is subsequently changed, invoke this method again.
+ */
+-(void) batchAnimation;
+
+/**
+ * The animation blender used to animate the nodes within this soft-body node, by blending
+ * several weighted animation clips.
+ *
+ * When this property is not nil, the establishAnimationFrameAt: method delegates to the
+ * establishFrameAt: method of this animation blender, in preference to the animationBatch.
+ * The animation blender should be created for this node, using the blenderForNode: method.
+ *
+ * The initial value of this property is nil. The animation blender is not copied when this
+ * node is copied, because its layers may draw on animation held outside this node.
+ */
+@property(nonatomic, retain) CC3NodeAnimationBlender* animationBlender;
+
+
+#pragma mark Animation level of detail
+
+/**
+ * The policy used to reduce the level of detail of the animation of this soft-body node,
+ * based on its size on the screen, as seen from the active camera.
+ *
+ * When this property is not nil, the establishAnimationFrameAt: method does not apply the
+ * animation immediately. Instead, the requested animation time is held until this node is
+ * next updated by the CC3NodeUpdatingVisitor. At that point, this node measures its size on
+ * the screen, uses this policy to determine the animationFrameInterval, animationNodeDepthLimit
+ * and isAnimationFrozen properties, and applies the held animation time if it is due, before
+ * the transforms of the skeleton are rebuilt. If the held animation time is not applied, the
+ * skeleton holds its current pose, and its transforms are not rebuilt.
+ *
+ * The number of bones whose animation was applied or skipped is added to the bonesUpdated
+ * and bonesSkipped properties of the performance statistics of the scene.
+ *
+ * A single policy may be shared by many soft-body nodes.
+ *
+ * The initial value of this property is nil, indicating that animation is applied
+ * immediately, at full detail.
+ */
+@property(nonatomic, retain) CC3AnimationLODPolicy* animationLODPolicy;
+
+/**
+ * The number of updates between successive applications of the animation of this node,
+ * as most recently determined by the animationLODPolicy.
+ */
+@property(nonatomic, readonly) GLuint animationFrameInterval;
+
+/**
+ * The number of levels below this node within which bones are animated, as most recently
+ * determined by the animationLODPolicy, or kCC3MaxGLuint if all bones are animated.
+ */
+@property(nonatomic, readonly) GLuint animationNodeDepthLimit;
+
+/**
+ * Indicates whether the animation of this node is frozen because this node is not visible,
+ * as most recently determined by the animationLODPolicy.
+ */
+@property(nonatomic, readonly) BOOL isAnimationFrozen;
+
+/**
+ * Marks the boundary used to measure the size of this node on the screen as dirty, so that it
+ * will be rebuilt from the boundingBox of this node when the level of detail is next evaluated.
+ *
+ * The boundary is built once, the first time the level of detail is evaluated. Invoke this
+ * method if the structure or meshes of this node change significantly.
+ */
+-(void) markAnimationLODBoundaryDirty;
+
 @end
 
 
@@ -677,6 +789,9 @@
  */
 @property(nonatomic, retain, readonly) CCArray* bones;
 
+/** Returns the number of bones in this skin section. */
+@property(nonatomic, readonly) GLuint boneCount;
+
 /**
  * An index that indicates which vertex in the mesh begins this skin section.
  *
@@ -780,6 +895,18 @@
  */
 -(void) reattachBonesFrom: (CC3Node*) aNode;
 
+/**
+ * Attaches this skin section to a new skeleton, by replacing each bone with the node found
+ * in the specified C array of nodes, at the index found at the same position in the specified
+ * C array of bone indices. The boneIndices array must contain at least boneCount entries.
+ *
+ * This method performs the same function as the reattachBonesFrom: method, but avoids
+ * searching the skeleton for each bone by name, when the position of each bone in the new
+ * skeleton is already known. This method is invoked automatically when a CC3NodePrefab
+ * creates an instance of a skinned node, and you do not need to invoke it directly.
+ */
+-(void) reattachBonesFromNodes: (CC3Node**) nodes atIndices: (GLuint*) boneIndices;
+
 
 #pragma mark Drawing
 
@@ -844,6 +971,28 @@
  */
 -(void) drawVerticesOfMesh: (CC3Mesh*) mesh withVisitor: (CC3NodeDrawingVisitor*) visitor;
 
+/**
+ * Appends the palette matrices of the bones of this skin section to the content of the
+ * specified draw command, and populates the specified draw range to draw the vertices of
+ * this skin section from the specified mesh, using those palette matrices.
+ *
+ * Each palette matrix is the drawTransformMatrix of the bone, preceded by the specified
+ * matrix that unpacks quantized vertex locations, if it is not NULL. When the command is
+ * replayed, each palette matrix is applied to the modelview matrix, as in the
+ * drawVerticesOfMesh:withVisitor: method.
+ *
+ * Since allocating the palette matrices can move the content of the command, the draw range
+ * is identified by its index within the draw ranges of the command.
+ *
+ * This method is invoked automatically when a CC3SkinMeshNode populates a draw command.
+ * Usually, the application never needs to invoke this method directly.
+ */
+-(void) populateDrawRangeAt: (GLuint) rangeIndex
+				  ofCommand: (CC3DrawCommand*) aCommand
+				   fromMesh: (CC3Mesh*) mesh
+		 withUnpackMatrix: (CC3Matrix4x4*) unpackMtx
+				withVisitor: (CC3NodeDrawingVisitor*) visitor;
+
 /** Returns a description of this skin section that includes a list of the bones. */
 -(NSString*) fullDescription;
 
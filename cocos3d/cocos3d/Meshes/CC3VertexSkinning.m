@@ -34,6 +34,7 @@
 #import "CC3Camera.h"
 #import "CC3Scene.h"
 #import "CC3NodeAnimation.h"
+#import "CC3AnimationLODPolicy.h"
 #import "CC3AffineMatrix.h"
 #import "CC3OpenGLESEngine.h"
 
@@ -42,12 +43,20 @@
 -(void) copyChildrenFrom: (CC3Node*) another;
 -(void) cacheRestPoseMatrix;
 -(void) transformMatrixChanged;
+-(void) processUpdateBeforeTransform: (CC3NodeUpdatingVisitor*) visitor;
 @end
 
 @interface CC3MeshNode (TemplateMethods)
 -(void) drawMeshWithVisitor: (CC3NodeDrawingVisitor*) visitor;
 @end
 
+@interface CC3Mesh (TemplateMethods)
+-(void) drawVerticesFrom: (GLuint) vertexIndex
+				forCount: (GLuint) vertexCount
+			 withVisitor: (CC3NodeDrawingVisitor*) visitor;
+-(void) populateDrawRange: (CC3DrawRange*) aRange from: (GLuint) vertexIndex forCount: (GLuint) vertexCount;
+@end
+
 @interface CC3FaceArray (TemplateMethods)
 -(CC3Face) faceAt: (GLuint) faceIndex;
 @end
@@ -56,12 +65,198 @@
 #pragma mark -
 #pragma mark CC3SoftBodyNode
 
+@interface CC3SoftBodyNode (TemplateMethods)
+-(void) applyAnimationFrameAt: (ccTime) t;
+-(void) establishAnimationFrameAt: (ccTime) t forNode: (CC3Node*) aNode atDepth: (GLuint) depth;
+-(void) updateAnimationLOD: (CC3NodeUpdatingVisitor*) visitor;
+-(CC3Sphere) animationLODGlobalSphere;
+-(GLuint) animatedBoneCountWithinDepth: (GLuint) depthLimit;
+-(GLuint) animatedBoneCountIn: (CC3Node*) aNode atDepth: (GLuint) depth withinDepth: (GLuint) depthLimit;
+@end
+
 @implementation CC3SoftBodyNode
 
-/** Attaches any contained skin sections to the new skeleton copy under this soft body node. */
+@synthesize animationBatch, animationBlender, animationLODPolicy;
+@synthesize animationFrameInterval, animationNodeDepthLimit, isAnimationFrozen;
+
+-(void) dealloc {
+	[animationBatch release];
+	[animationBlender release];
+	[animationLODPolicy release];
+	[super dealloc];
+}
+
+-(id) initWithTag: (GLuint) aTag withName: (NSString*) aName {
+	if ( (self = [super initWithTag: aTag withName: aName]) ) {
+		animationLODPolicy = nil;
+		animationLODBoundingBox = kCC3BoundingBoxNull;
+		pendingAnimationTime = 0.0f;
+		animationFrameInterval = 1;
+		animationNodeDepthLimit = kCC3MaxGLuint;
+		animationLODFrameCount = 0;
+		animatedBoneCount = 0;
+		animatedBoneDepthLimit = 0;
+		animatedBoneCountWithinDepthLimit = 0;
+		hasPendingAnimationFrame = NO;
+		isAnimationFrozen = NO;
+		isAnimationLODBoundaryDirty = YES;
+	}
+	return self;
+}
+
+-(void) populateFrom: (CC3SoftBodyNode*) another {
+	[super populateFrom: another];
+	self.animationLODPolicy = another.animationLODPolicy;		// Policy may be shared
+}
+
+/**
+ * Attaches any contained skin sections to the new skeleton copy under this soft body node.
+ * If the original was animated in a batch, batches the animation of the new skeleton copy.
+ */
 -(void) copyChildrenFrom: (CC3Node*) another {
 	[super copyChildrenFrom: another];
 	[self reattachBonesFrom: self];
+	if ( [another isKindOfClass: [CC3SoftBodyNode class]] && ((CC3SoftBodyNode*)another).animationBatch )
+		[self batchAnimation];
+}
+
+-(void) batchAnimation { self.animationBatch = [CC3NodeAnimationBatch batchForNode: self]; }
+
+-(void) establishAnimationFrameAt: (ccTime) t {
+	if (animationLODPolicy) {
+		pendingAnimationTime = t;			// Applied during the next update
+		hasPendingAnimationFrame = YES;
+	} else {
+		[self applyAnimationFrameAt: t];
+	}
+}
+
+/** Applies the animation at the specified time, to those bones within the current node depth limit. */
+-(void) applyAnimationFrameAt: (ccTime) t {
+	if (animationBlender) {
+		animationBlender.nodeDepthLimit = animationNodeDepthLimit;
+		[animationBlender establishFrameAt: t];
+	} else if (animationBatch) {
+		animationBatch.nodeDepthLimit = animationNodeDepthLimit;
+		[animationBatch establishFrameAt: t];
+	} else if (animationNodeDepthLimit == kCC3MaxGLuint) {
+		[super establishAnimationFrameAt: t];
+	} else {
+		[self establishAnimationFrameAt: t forNode: self atDepth: 0];
+	}
+}
+
+-(void) establishAnimationFrameAt: (ccTime) t forNode: (CC3Node*) aNode atDepth: (GLuint) depth {
+	if (depth > animationNodeDepthLimit) return;
+	if (aNode.animation && aNode.isAnimationEnabled) [aNode.animation establishFrameAt: t forNode: aNode];
+	for (CC3Node* child in aNode.children) [self establishAnimationFrameAt: t forNode: child atDepth: (depth + 1)];
+}
+
+
+#pragma mark Animation level of detail
+
+/** If the policy is removed, any animation frame still being held is applied immediately. */
+-(void) setAnimationLODPolicy: (CC3AnimationLODPolicy*) aPolicy {
+	if (aPolicy == animationLODPolicy) return;
+	[animationLODPolicy release];
+	animationLODPolicy = [aPolicy retain];
+
+	animationFrameInterval = 1;
+	animationNodeDepthLimit = kCC3MaxGLuint;
+	animationLODFrameCount = 0;
+	isAnimationFrozen = NO;
+	if ( !animationLODPolicy && hasPendingAnimationFrame ) {
+		hasPendingAnimationFrame = NO;
+		[self applyAnimationFrameAt: pendingAnimationTime];
+	}
+}
+
+-(void) markAnimationLODBoundaryDirty {
+	isAnimationLODBoundaryDirty = YES;
+	animatedBoneCount = 0;
+}
+
+/** Evaluate the animation level of detail before the transforms of the skeleton are rebuilt. */
+-(void) processUpdateBeforeTransform: (CC3NodeUpdatingVisitor*) visitor {
+	[super processUpdateBeforeTransform: visitor];
+	if (animationLODPolicy) [self updateAnimationLOD: visitor];
+}
+
+/**
+ * Determines the level of detail of the animation from the size of this node on the screen,
+ * and applies any animation frame being held, if it is due. The animation frame is held
+ * until it has been held for the current frame interval, or while this node is frozen.
+ */
+-(void) updateAnimationLOD: (CC3NodeUpdatingVisitor*) visitor {
+	CC3Camera* cam = visitor.camera;
+	CC3Sphere gSphere = self.animationLODGlobalSphere;
+	GLfloat screenFraction = [animationLODPolicy screenFractionOfSphere: gSphere fromCamera: cam];
+	isAnimationFrozen = [animationLODPolicy shouldFreezeSphere: gSphere forCamera: cam];
+	animationFrameInterval = [animationLODPolicy frameIntervalForScreenFraction: screenFraction];
+	animationNodeDepthLimit = [animationLODPolicy nodeDepthLimitForScreenFraction: screenFraction];
+
+	if ( !hasPendingAnimationFrame ) return;
+
+	CC3PerformanceStatistics* stats = visitor.performanceStatistics;
+	GLuint boneCount = [self animatedBoneCountWithinDepth: kCC3MaxGLuint];
+	animationLODFrameCount++;
+	if (isAnimationFrozen || animationLODFrameCount < animationFrameInterval) {
+		[stats addBonesSkipped: boneCount];
+		return;
+	}
+
+	animationLODFrameCount = 0;
+	hasPendingAnimationFrame = NO;
+	[self applyAnimationFrameAt: pendingAnimationTime];
+
+	GLuint updatedCount = [self animatedBoneCountWithinDepth: animationNodeDepthLimit];
+	[stats addBonesUpdated: updatedCount];
+	[stats addBonesSkipped: (boneCount - updatedCount)];
+}
+
+/**
+ * Returns the bounding sphere of this node in the global coordinate system. The sphere is
+ * derived from the boundingBox of this node, which is measured once, and then transformed.
+ */
+-(CC3Sphere) animationLODGlobalSphere {
+	if (isAnimationLODBoundaryDirty) {
+		animationLODBoundingBox = self.boundingBox;
+		isAnimationLODBoundaryDirty = NO;
+	}
+	if (CC3BoundingBoxIsNull(animationLODBoundingBox)) return CC3SphereMake(self.globalLocation, 0.0f);
+
+	CC3Vector gs = self.globalScale;
+	GLfloat maxScale = MAX(MAX(fabsf(gs.x), fabsf(gs.y)), fabsf(gs.z));
+	return CC3SphereMake([self.transformMatrix transformLocation: CC3BoundingBoxCenter(animationLODBoundingBox)],
+						 (CC3VectorDistance(animationLODBoundingBox.minimum, animationLODBoundingBox.maximum) *
+						  0.5f * maxScale));
+}
+
+/**
+ * Returns the number of animated nodes within the specified number of levels below this node.
+ * The counts of all animated nodes, and of those within the most recently requested depth
+ * limit, are cached, since the structure of the skeleton does not change between updates.
+ */
+-(GLuint) animatedBoneCountWithinDepth: (GLuint) depthLimit {
+	if ( !animatedBoneCount ) {
+		animatedBoneCount = [self animatedBoneCountIn: self atDepth: 0 withinDepth: kCC3MaxGLuint];
+		animatedBoneDepthLimit = kCC3MaxGLuint;
+		animatedBoneCountWithinDepthLimit = animatedBoneCount;
+	}
+	if (depthLimit == kCC3MaxGLuint) return animatedBoneCount;
+	if (depthLimit != animatedBoneDepthLimit) {
+		animatedBoneCountWithinDepthLimit = [self animatedBoneCountIn: self atDepth: 0 withinDepth: depthLimit];
+		animatedBoneDepthLimit = depthLimit;
+	}
+	return animatedBoneCountWithinDepthLimit;
+}
+
+-(GLuint) animatedBoneCountIn: (CC3Node*) aNode atDepth: (GLuint) depth withinDepth: (GLuint) depthLimit {
+	if (depth > depthLimit) return 0;
+	GLuint boneCount = (aNode.animation && aNode.isAnimationEnabled) ? 1 : 0;
+	for (CC3Node* child in aNode.children)
+		boneCount += [self animatedBoneCountIn: child atDepth: (depth + 1) withinDepth: depthLimit];
+	return boneCount;
 }
 
 /** Release a visitor to calculate the bind pose transforms relative to this soft-body node. */
@@ -318,6 +513,41 @@
 	[visitor draw: self];
 }
 
++(Class) drawingTemplateClass { return [CC3SkinMeshNode class]; }
+
+/**
+ * Overridden to replace the draw ranges populated by the mesh with one draw range for each
+ * skin section, each loading the palette matrices of the bones of that skin section, in place
+ * of the modelMatrix of the command. Since the bones move independently of this node, the
+ * command is populated again on each frame.
+ */
+-(void) populateDrawCommand: (CC3DrawCommand*) aCommand withVisitor: (CC3NodeDrawingVisitor*) visitor {
+	[super populateDrawCommand: aCommand withVisitor: visitor];
+	if (aCommand->shouldDrawLive) return;
+
+	aCommand->shouldUsePalette = YES;
+	aCommand->isVolatile = YES;
+	aCommand->faceCount = 0;
+
+	GLuint rngCount = skinSections.count;
+	aCommand->drawRangesOffset = [visitor.commandList allocateContent: (rngCount * sizeof(CC3DrawRange))
+														   forCommand: aCommand];
+	aCommand->drawRangeCount = rngCount;
+
+	CC3Matrix4x4 unpackMtx;
+	BOOL shouldUnpack = mesh.hasQuantizedVertexLocations;
+	if (shouldUnpack) [mesh populateVertexLocationUnpackMatrix: &unpackMtx];
+
+	GLuint rngIdx = 0;
+	for (CC3SkinSection* skinSctn in skinSections) {
+		[skinSctn populateDrawRangeAt: rngIdx++
+							ofCommand: aCommand
+							 fromMesh: mesh
+				   withUnpackMatrix: (shouldUnpack ? &unpackMtx : NULL)
+						  withVisitor: visitor];
+	}
+}
+
 /** 
  * Draws the mesh vertices to the GL engine.
  *
@@ -344,14 +574,14 @@
 #pragma mark -
 #pragma mark CC3SkinMesh
 
-@interface CC3Mesh (TemplateMethods)
--(void) drawVerticesFrom: (GLuint) vertexIndex
-				forCount: (GLuint) vertexCount
-			 withVisitor: (CC3NodeDrawingVisitor*) visitor;
-@end
-
 @interface CC3VertexArrayMesh (TemplateMethods)
 -(void) createVertexContent: (CC3VertexContent) vtxContentTypes;
+-(CCArray*) vertexContentArrays;
+-(void) populateVertexBindingsOf: (CC3DrawCommand*) aCommand withVisitor: (CC3NodeDrawingVisitor*) visitor;
+-(void) addVertexArray: (CC3VertexArray*) vtxArray
+		 toDrawCommand: (CC3DrawCommand*) aCommand
+		   withVisitor: (CC3NodeDrawingVisitor*) visitor;
+-(void) markDrawingChangedFromVertexArray: (CC3VertexArray*) oldArray;
 @end
 
 @implementation CC3SkinMesh
@@ -371,6 +601,7 @@
 -(CC3VertexWeights*) vertexWeights { return vertexWeights; }
 
 -(void) setVertexWeights: (CC3VertexWeights*) vtxWgts {
+	[self markDrawingChangedFromVertexArray: vertexWeights];
 	[vertexWeights autorelease];
 	vertexWeights = [vtxWgts retain];
 	[vertexWeights deriveNameFrom: self];
@@ -381,6 +612,7 @@
 -(CC3VertexMatrixIndices*) vertexMatrixIndices { return vertexMatrixIndices; }
 
 -(void) setVertexMatrixIndices: (CC3VertexMatrixIndices*) vtxMtxInd {
+	[self markDrawingChangedFromVertexArray: vertexMatrixIndices];
 	[vertexMatrixIndices autorelease];
 	vertexMatrixIndices = [vtxMtxInd retain];
 	[vertexMatrixIndices deriveNameFrom: self];
@@ -479,6 +711,16 @@
 	vertexMatrixIndices.vertexCount = vCount;
 }
 
+-(CCArray*) vertexContentArrays {
+	CCArray* vcArrays = [super vertexContentArrays];
+	if (vertexWeights) [vcArrays addObject: vertexWeights];
+	if (vertexMatrixIndices) [vcArrays addObject: vertexMatrixIndices];
+	return vcArrays;
+}
+
+/** Skinned vertex locations are transformed by the bone matrices, which do not include the unpack transform. */
+-(BOOL) canQuantizeVertexLocations { return NO; }
+
 -(GLuint) vertexUnitCount {
 	return vertexWeights ? vertexWeights.elementSize : 0;
 }
@@ -583,6 +825,7 @@
 
 -(void) createGLBuffers {
 	[super createGLBuffers];
+	if ( !CC3OpenGLESEngine.isRenderThread ) return;		// Deferred to the rendering thread
 	if (shouldInterleaveVertices) {
 		GLuint commonBufferId = vertexLocations.bufferID;
 		vertexMatrixIndices.bufferID = commonBufferId;
@@ -653,7 +896,10 @@
 
 -(void) updateGLBuffersStartingAt: (GLuint) offsetIndex forLength: (GLuint) vertexCount {
 	[super updateGLBuffersStartingAt: offsetIndex forLength: vertexCount];
-	if (!shouldInterleaveVertices) {
+	if (shouldInterleaveVertices) {
+		[vertexMatrixIndices markVerticesCleanStartingAt: offsetIndex forLength: vertexCount];
+		[vertexWeights markVerticesCleanStartingAt: offsetIndex forLength: vertexCount];
+	} else {
 		[vertexMatrixIndices updateGLBufferStartingAt: offsetIndex forLength: vertexCount];
 		[vertexWeights updateGLBufferStartingAt: offsetIndex forLength: vertexCount];
 	}
@@ -672,6 +918,16 @@
 	[vertexWeights bindWithVisitor:visitor];
 }
 
+-(void) populateVertexBindingsOf: (CC3DrawCommand*) aCommand withVisitor: (CC3NodeDrawingVisitor*) visitor {
+	[super populateVertexBindingsOf: aCommand withVisitor: visitor];
+	[self addVertexArray: vertexMatrixIndices toDrawCommand: aCommand withVisitor: visitor];
+	[self addVertexArray: vertexWeights toDrawCommand: aCommand withVisitor: visitor];
+}
+
+-(GLuint) drawingVersion {
+	return super.drawingVersion + vertexMatrixIndices.drawingVersion + vertexWeights.drawingVersion;
+}
+
 /** Overridden to do nothing. Skinned meshes are drawn by the CC3SkinSections. */
 -(void) drawVerticesWithVisitor: (CC3NodeDrawingVisitor*) visitor {}
 
@@ -699,6 +955,8 @@
 	return bones;
 }
 
+-(GLuint) boneCount { return skinnedBones.count; }
+
 -(void) addBone: (CC3Bone*) aBone {
 	[skinnedBones addObject: [CC3SkinnedBone skinnedBoneWithSkin: node onBone: aBone]];
 }
@@ -771,6 +1029,14 @@
 	}
 }
 
+-(void) reattachBonesFromNodes: (CC3Node**) nodes atIndices: (GLuint*) boneIndices {
+	GLuint boneCnt = skinnedBones.count;
+	[skinnedBones removeAllObjects];
+	for (GLuint i = 0; i < boneCnt; i++) {
+		[self addBone: (CC3Bone*)nodes[boneIndices[i]]];
+	}
+}
+
 // Template method that populates this instance from the specified other instance.
 // This method is invoked automatically during object copying via the copyWithZone: method.
 -(void) populateFrom: (CC3SkinSection*) another {
@@ -820,6 +1086,37 @@
 	[mesh drawVerticesFrom: vertexStart forCount: vertexCount withVisitor: visitor];
 }
 
+-(void) populateDrawRangeAt: (GLuint) rangeIndex
+				  ofCommand: (CC3DrawCommand*) aCommand
+				   fromMesh: (CC3Mesh*) mesh
+		 withUnpackMatrix: (CC3Matrix4x4*) unpackMtx
+				withVisitor: (CC3NodeDrawingVisitor*) visitor {
+	CC3DrawCommandList* cmdList = visitor.commandList;
+	GLuint palMtxCount = skinnedBones.count;
+	GLuint palMtxsOffset = [cmdList allocateContent: (palMtxCount * sizeof(CC3Matrix4x4)) forCommand: aCommand];
+	CC3Matrix4x4* palMtxs = [cmdList contentAt: palMtxsOffset ofCommand: aCommand];
+
+	CC3Matrix4x4 boneMtx;
+	GLuint boneNum = 0;
+	for (CC3SkinnedBone* sb in skinnedBones) {
+		CC3Matrix4x4* palMtx = &palMtxs[boneNum++];
+		if (unpackMtx) {
+			[sb.drawTransformMatrix populateCC3Matrix4x4: &boneMtx];
+			CC3Matrix4x4Multiply(palMtx, unpackMtx, &boneMtx);
+		} else {
+			[sb.drawTransformMatrix populateCC3Matrix4x4: palMtx];
+		}
+	}
+
+	// Retrieve the range after the palette matrices are allocated, since allocation can move the content.
+	CC3DrawRange* ranges = [cmdList contentAt: aCommand->drawRangesOffset ofCommand: aCommand];
+	CC3DrawRange* range = &ranges[rangeIndex];
+	[mesh populateDrawRange: range from: vertexStart forCount: vertexCount];
+	range->paletteMatrixCount = palMtxCount;
+	range->paletteMatricesOffset = palMtxsOffset;
+	aCommand->faceCount += range->faceCount;
+}
+
 -(NSString*) description {
 	return [NSString stringWithFormat: @"%@ with %i bones, vertices from %u to %u for %@",
 			[self class], skinnedBones.count, vertexStart, (vertexStart + vertexCount - 1), node];
@@ -33,6 +33,7 @@
 #import "CC3BoundingVolumes.h"
 #import "CC3MeshNode.h"
 #import "CCNode.h"
+#import "CCSpriteBatchNode.h"
 
 
 /**
@@ -105,6 +106,7 @@
 	BOOL shouldMaximizeBillboardBoundingRect : 1;
 	BOOL _shouldUpdateUnseenBillboard : 1;
 	BOOL _billboardIsPaused : 1;
+	BOOL _isProjectedBehindCamera : 1;
 }
 
 /** Returns whether this node is a billboard. Returns YES. */
@@ -521,6 +523,28 @@
  */
 -(void) alignToCamera: (CC3Camera*) camera;
 
+/**
+ * Aligns this billboard to the specified camera, as described for the alignToCamera: method
+ * when the value of the shouldDrawAs2DOverlay property is YES, using the specified location
+ * as the projection of the globalLocation of this node by the camera. The specified location
+ * is set into the projectedLocation property of this node.
+ *
+ * If the specified projected location is behind the camera, the isProjectedBehindCamera
+ * property is set to YES, the scale of the 2D node is left unchanged, and the 2D node will
+ * not be drawn.
+ *
+ * This method is invoked automatically by CC3BillboardBatch, which projects the locations of
+ * all of the 2D overlay billboards in the scene together, using the projectLocations:into:count:
+ * method of the camera. Usually, the application never needs to invoke this method directly.
+ */
+-(void) align2DToCamera: (CC3Camera*) camera atProjectedLocation: (CC3Vector) pLoc;
+
+/**
+ * Returns whether this node was found to be behind the camera when it was last aligned to the
+ * camera as a 2D overlay. When this property is YES, the 2D node is culled and is not drawn.
+ */
+@property(nonatomic, readonly) BOOL isProjectedBehindCamera;
+
 
 #pragma mark Drawing
 
@@ -560,6 +584,83 @@
 @end
 
 
+#pragma mark -
+#pragma mark CC3BillboardBatch
+
+/**
+ * CC3BillboardBatch aligns and draws the 2D overlay billboards of a CC3Scene as a group.
+ *
+ * When aligning billboards to the camera, the global locations of all of the billboards
+ * that are drawn as 2D overlays are collected into a single array and projected by the
+ * camera in one pass, using the combined view and projection matrix of the camera.
+ * Billboards that are projected behind the camera are culled, and are neither scaled nor drawn.
+ *
+ * When drawing billboards, any billboard whose 2D node lies outside the drawing bounds is culled.
+ * Billboards are drawn in the order in which they appear in the collection of billboards. If the
+ * shouldBatchSprites property is YES, each run of consecutive visible billboards whose 2D nodes are
+ * CCSprites without children, and that share the same texture and blending function, is drawn as a
+ * single batch of quads, at the position of that run. All other billboards are drawn individually.
+ *
+ * A CC3Scene holds an instance of this class, and uses it automatically in the updateBillboards:
+ * and draw2DBillboards methods. Usually, the application never needs to use this class directly.
+ */
+@interface CC3BillboardBatch : NSObject {
+	CC3Vector* locations;
+	GLuint locationCapacity;
+	void* spriteEntries;
+	GLuint spriteEntryCapacity;
+	CCSpriteBatchNode* spriteBatchNode;
+	GLuint billboardsCulled;
+	GLuint spriteBatchesDrawn;
+	BOOL shouldBatchSprites : 1;
+}
+
+/**
+ * Indicates whether consecutive billboards whose 2D node is a CCSprite, with no children, and that
+ * share the same texture and blending function, should be drawn together as a single batch of quads.
+ *
+ * Batching never changes the order in which billboards are drawn. Since 2D overlay billboards are
+ * not depth-tested, and are often translucent, that order determines which of two overlapping
+ * billboards appears on top, and how they are composited. A batch therefore only ever contains a
+ * run of sprites that are adjacent in the order in which billboards are drawn, and any billboard
+ * that cannot join the batch, because it is not a sprite, or uses a different texture or blending
+ * function, ends the batch and is drawn after it. Billboards that are culled or invisible do not
+ * end a batch.
+ *
+ * Batching is most effective when billboards that are drawn consecutively use the same texture
+ * atlas and blending function.
+ *
+ * The initial value of this property is NO.
+ */
+@property(nonatomic, assign) BOOL shouldBatchSprites;
+
+/** The number of billboards that were culled during the most recent alignment and drawing. */
+@property(nonatomic, readonly) GLuint billboardsCulled;
+
+/** The number of batches of sprite quads that were drawn during the most recent drawing. */
+@property(nonatomic, readonly) GLuint spriteBatchesDrawn;
+
+/**
+ * Aligns each of the CC3Billboards in the specified collection to the specified camera.
+ *
+ * The locations of the billboards that are drawn as 2D overlays are projected by the camera
+ * together, and each such billboard is then aligned using its align2DToCamera:atProjectedLocation:
+ * method. All other billboards are aligned using their alignToCamera: method.
+ */
+-(void) alignBillboards: (CCArray*) billboards toCamera: (CC3Camera*) camera;
+
+/**
+ * Draws each of the CC3Billboards in the specified collection that are drawn as 2D overlays,
+ * and that are visible within the specified bounds.
+ */
+-(void) drawBillboards: (CCArray*) billboards withinBounds: (CGRect) bounds;
+
+/** Allocates and initializes an autoreleased instance. */
++(id) batch;
+
+@end
+
+
 #pragma mark -
 #pragma mark CC3BillboardBoundingBoxArea interface
 
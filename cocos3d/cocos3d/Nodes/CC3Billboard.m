@@ -33,6 +33,7 @@
 #import "CC3OpenGLESEngine.h"
 #import "CC3VertexArrayMesh.h"
 #import "CC3CC2Extensions.h"
+#import "CCSprite.h"
 
 
 @interface CC3MeshNode (TemplateMethods)
@@ -45,6 +46,7 @@
 -(CGRect) measureBillboardBoundingRect;
 -(void) align2DToCamera:(CC3Camera*) camera;
 -(void) align3DToCamera:(CC3Camera*) camera;
+-(BOOL) shouldDraw2dWithinBounds: (CGRect) bounds;
 -(void) updateBoundingMesh;
 -(void) normalizeBillboardScaleToDevice;
 @property(nonatomic, readonly) BOOL hasDynamicBoundingRect;
@@ -57,6 +59,7 @@
 @synthesize shouldNormalizeScaleToDevice, shouldDrawAs2DOverlay, textureUnitIndex;
 @synthesize shouldAlwaysMeasureBillboardBoundingRect, shouldMaximizeBillboardBoundingRect;
 @synthesize shouldUpdateUnseenBillboard=_shouldUpdateUnseenBillboard;
+@synthesize isProjectedBehindCamera=_isProjectedBehindCamera;
 
 -(void) dealloc {
 	self.billboard = nil;		// Use setter to cleanup and release the 2D billboard.
@@ -229,6 +232,7 @@
 		textureUnitIndex = 0;
 		_shouldUpdateUnseenBillboard = YES;
 		_billboardIsPaused = NO;
+		_isProjectedBehindCamera = NO;
 	}
 	return self;
 }
@@ -362,7 +366,16 @@
 -(void) align2DToCamera:(CC3Camera*) camera {
 	// Use the camera to project the 3D location of this node
 	// into 2D and then set the billboard to that position
-	[camera projectNode: self];
+	[self align2DToCamera: camera atProjectedLocation: [camera projectLocation: self.globalLocation]];
+}
+
+-(void) align2DToCamera: (CC3Camera*) camera atProjectedLocation: (CC3Vector) pLoc {
+	self.projectedLocation = pLoc;
+
+	// Don't bother positioning or scaling if the 2D node won't be drawn.
+	_isProjectedBehindCamera = (pLoc.z <= 0.0f);
+	if (_isProjectedBehindCamera) return;
+
 	CGPoint pPos = self.projectedPosition;
 	billboard.position = ccpAdd(pPos, offsetPosition);
 	
@@ -611,9 +624,21 @@ static GLfloat deviceScaleFactor = 0.0f;
 }
 
 -(void) draw2dWithinBounds: (CGRect) bounds {
-	if(shouldDrawAs2DOverlay && self.visible && [self doesIntersectBounds: bounds ]) {
-		[billboard visit];
-	}
+	if ([self shouldDraw2dWithinBounds: bounds]) [billboard visit];
+}
+
+/**
+ * Returns whether the 2D node should be drawn as an overlay within the specified bounds.
+ *
+ * In addition to testing the bounding volume, the 2D node is culled if it was projected
+ * behind the camera, or if it has no children, and its own bounding box, at its projected
+ * position and scale, lies outside the specified bounds.
+ */
+-(BOOL) shouldDraw2dWithinBounds: (CGRect) bounds {
+	if ( !(shouldDrawAs2DOverlay && self.visible) || _isProjectedBehindCamera ) return NO;
+	if ( !(billboard.children.count || CGSizeEqualToSize(billboard.contentSize, CGSizeZero)) &&
+		 !CGRectIntersectsRect(billboard.boundingBox, bounds) ) return NO;
+	return [self doesIntersectBounds: bounds];
 }
 
 
@@ -646,6 +671,206 @@ static GLfloat deviceScaleFactor = 0.0f;
 @end
 
 
+#pragma mark -
+#pragma mark CC3BillboardBatch
+
+/** A 2D sprite billboard that is to be drawn as part of a batch, along with its batching key. */
+typedef struct {
+	CCSprite* sprite;			/**< The sprite to draw. Not retained. */
+	GLuint textureName;			/**< The GL name of the texture of the sprite. */
+	ccBlendFunc blendFunc;		/**< The blending function of the sprite. */
+} CC3BillboardSpriteEntry;
+
+/** Returns whether the two sprite entries can be drawn in the same batch. */
+static inline BOOL CC3BillboardSpriteEntriesShareBatch(CC3BillboardSpriteEntry* ea, CC3BillboardSpriteEntry* eb) {
+	return (ea->textureName == eb->textureName &&
+			ea->blendFunc.src == eb->blendFunc.src &&
+			ea->blendFunc.dst == eb->blendFunc.dst);
+}
+
+/** Transforms the X & Y components of the specified quad vertex by the specified 2D transform. */
+static inline void CC3BillboardTransformQuadVertex(ccVertex3F* vtx, CGAffineTransform t) {
+	CGPoint pt = CGPointApplyAffineTransform(CGPointMake(vtx->x, vtx->y), t);
+	vtx->x = pt.x;
+	vtx->y = pt.y;
+}
+
+@interface CC3BillboardBatch (TemplateMethods)
+-(BOOL) isBatchableBillboard: (CC3Billboard*) bb;
+-(void) drawSpriteBatch: (CC3BillboardSpriteEntry*) entries count: (GLuint) count;
+@end
+
+@implementation CC3BillboardBatch
+
+@synthesize shouldBatchSprites, billboardsCulled, spriteBatchesDrawn;
+
+-(void) dealloc {
+	free(locations);
+	free(spriteEntries);
+	[spriteBatchNode release];
+	[super dealloc];
+}
+
+-(id) init {
+	if ( (self = [super init]) ) {
+		locations = NULL;
+		locationCapacity = 0;
+		spriteEntries = NULL;
+		spriteEntryCapacity = 0;
+		spriteBatchNode = nil;
+		billboardsCulled = 0;
+		spriteBatchesDrawn = 0;
+		shouldBatchSprites = NO;
+	}
+	return self;
+}
+
++(id) batch { return [[[self alloc] init] autorelease]; }
+
+
+#pragma mark Aligning
+
+/**
+ * Collects the global locations of the 2D overlay billboards into a single array, aligning
+ * all other billboards individually, then projects the collected locations in one pass,
+ * and finally aligns each 2D overlay billboard to its projected location.
+ */
+-(void) alignBillboards: (CCArray*) billboards toCamera: (CC3Camera*) camera {
+	billboardsCulled = 0;
+	if ( !camera ) return;
+
+	GLuint bbCount = billboards.count;
+	if (bbCount > locationCapacity) {
+		locationCapacity = bbCount;
+		locations = realloc(locations, locationCapacity * sizeof(CC3Vector));
+		NSAssert1(locations, @"Could not allocate space for %u billboard locations", locationCapacity);
+	}
+
+	GLuint locCount = 0;
+	for (CC3Billboard* bb in billboards) {
+		if (bb.shouldDrawAs2DOverlay && bb.billboard) {
+			locations[locCount++] = bb.globalLocation;
+		} else {
+			[bb alignToCamera: camera];
+		}
+	}
+	if ( !locCount ) return;
+
+	[camera projectLocations: locations into: locations count: locCount];
+
+	GLuint locIdx = 0;
+	for (CC3Billboard* bb in billboards) {
+		if (bb.shouldDrawAs2DOverlay && bb.billboard) {
+			[bb align2DToCamera: camera atProjectedLocation: locations[locIdx++]];
+			if (bb.isProjectedBehindCamera) billboardsCulled++;
+		}
+	}
+	LogTrace(@"%@ projected %u 2D billboards, of which %u are behind the camera", self, locCount, billboardsCulled);
+}
+
+
+#pragma mark Drawing
+
+/** Returns whether the specified billboard holds a 2D node that can be drawn as part of a batch of sprites. */
+-(BOOL) isBatchableBillboard: (CC3Billboard*) bb {
+	CCNode* bbNode = bb.billboard;
+	return (shouldBatchSprites &&
+			[bbNode isKindOfClass: [CCSprite class]] &&
+			((CCSprite*)bbNode).texture &&
+			bbNode.children.count == 0);
+}
+
+/**
+ * Draws each visible billboard in its original order. If batching sprites, each visible batchable
+ * sprite is added to the current run of sprites, unless it does not share the batching key of that
+ * run, in which case the run is drawn as a batch and a new run is started. Any other billboard that
+ * is drawn also ends the current run, so that batching never changes the order of drawing.
+ */
+-(void) drawBillboards: (CCArray*) billboards withinBounds: (CGRect) bounds {
+	spriteBatchesDrawn = 0;
+
+	if (shouldBatchSprites) {
+		GLuint bbCount = billboards.count;
+		if (bbCount > spriteEntryCapacity) {
+			spriteEntryCapacity = bbCount;
+			spriteEntries = realloc(spriteEntries, spriteEntryCapacity * sizeof(CC3BillboardSpriteEntry));
+			NSAssert1(spriteEntries, @"Could not allocate space for %u billboard sprites", spriteEntryCapacity);
+		}
+	}
+
+	CC3BillboardSpriteEntry* entries = spriteEntries;
+	GLuint entryCount = 0;
+	GLuint spriteCount = 0;
+	for (CC3Billboard* bb in billboards) {
+		if ( ![bb shouldDraw2dWithinBounds: bounds] ) {
+			if (bb.shouldDrawAs2DOverlay && bb.visible && !bb.isProjectedBehindCamera) billboardsCulled++;
+			continue;
+		}
+
+		if ([self isBatchableBillboard: bb]) {
+			CCSprite* sprite = (CCSprite*)bb.billboard;
+			if ( !sprite.visible ) continue;
+
+			CC3BillboardSpriteEntry entry;
+			entry.sprite = sprite;
+			entry.textureName = sprite.texture.name;
+			entry.blendFunc = sprite.blendFunc;
+			if (entryCount && !CC3BillboardSpriteEntriesShareBatch(&entries[0], &entry)) {
+				[self drawSpriteBatch: entries count: entryCount];
+				entryCount = 0;
+			}
+			entries[entryCount++] = entry;
+			spriteCount++;
+		} else {
+			if (entryCount) {
+				[self drawSpriteBatch: entries count: entryCount];
+				entryCount = 0;
+			}
+			[bb.billboard visit];
+		}
+	}
+	if (entryCount) [self drawSpriteBatch: entries count: entryCount];
+
+	LogTrace(@"%@ drew %u sprites in %u batches, and culled %u billboards",
+			 self, spriteCount, spriteBatchesDrawn, billboardsCulled);
+}
+
+/**
+ * Copies the quad of each of the specified sprites, which all share the same texture and blending
+ * function, into the texture atlas of a reusable CCSpriteBatchNode, transforming each quad from
+ * the local coordinates of the sprite into the 2D drawing space, then draws them all at once.
+ */
+-(void) drawSpriteBatch: (CC3BillboardSpriteEntry*) entries count: (GLuint) count {
+	CCSprite* firstSprite = entries[0].sprite;
+	if (spriteBatchNode) {
+		spriteBatchNode.texture = firstSprite.texture;
+	} else {
+		spriteBatchNode = [[CCSpriteBatchNode alloc] initWithTexture: firstSprite.texture capacity: count];
+	}
+	spriteBatchNode.blendFunc = entries[0].blendFunc;		// After setting texture, which resets blending
+
+	CCTextureAtlas* atlas = spriteBatchNode.textureAtlas;
+	[atlas removeAllQuads];
+	if (count > atlas.capacity) [atlas resizeCapacity: count];
+
+	for (GLuint i = 0; i < count; i++) {
+		CCSprite* sprite = entries[i].sprite;
+		ccV3F_C4B_T2F_Quad quad = sprite.quad;
+		CGAffineTransform xfm = [sprite nodeToParentTransform];
+		CC3BillboardTransformQuadVertex(&quad.bl.vertices, xfm);
+		CC3BillboardTransformQuadVertex(&quad.br.vertices, xfm);
+		CC3BillboardTransformQuadVertex(&quad.tl.vertices, xfm);
+		CC3BillboardTransformQuadVertex(&quad.tr.vertices, xfm);
+		[atlas updateQuad: &quad atIndex: i];
+	}
+
+	[spriteBatchNode visit];
+	spriteBatchesDrawn++;
+}
+
+@end
+
+
 #pragma mark -
 #pragma mark CC3BillboardBoundingBoxArea
 
@@ -274,6 +274,27 @@
 -(BOOL) doesIntersectSphere: (CC3Sphere) aSphere
 					   from: (CC3BoundingVolume*) otherBoundingVolume;
 
+/**
+ * Returns whether the volume swept out by the specified sphere, as it is moved along the
+ * specified direction for the specified distance, intersects this bounding volume.
+ *
+ * The direction must be a unit vector. The distance may be INFINITY. As the sphere is swept,
+ * its radius grows by the specified expansion for each unit of distance, so the swept volume
+ * is a tapered capsule. For example, with an appropriate expansion, this volume encloses the
+ * shadow cast by the sphere from a light, or the cone of light projected through an aperture.
+ *
+ * The swept volume will be outside this bounding volume if it lies in front of any one of
+ * the planes in the planes property of this bounding volume. This test is conservative, and
+ * may return YES for some swept volumes that lie outside a corner of this bounding volume.
+ *
+ * Subclasses whose bounding volumes are not described in terms of a hull of
+ * vertices and planes must override this method to perform some other test.
+ */
+-(BOOL) doesIntersectSphere: (CC3Sphere) aSphere
+				 sweptAlong: (CC3Vector) aDirection
+				forDistance: (GLfloat) aDistance
+				expandingBy: (GLfloat) expansion;
+
 /**
  * Returns whether a convex hull composed of the specified global planes intersects
  * this bounding volume. The planes may be the face planes of a mesh, or they may
@@ -292,6 +292,33 @@
 	return YES;
 }
 
+/**
+ * The swept volume is the convex hull of the spheres at the start and end of the sweep, so
+ * its smallest distance in front of a plane is the smaller of the distances of those spheres.
+ * That distance changes linearly along the sweep, so only its start value and rate are needed.
+ */
+-(BOOL) doesIntersectSphere: (CC3Sphere) aSphere
+				 sweptAlong: (CC3Vector) aDirection
+				forDistance: (GLfloat) aDistance
+				expandingBy: (GLfloat) expansion {
+	NSAssert1(self.planes, @"%@ does not use planes. You must add planes or override method doesIntersectSphere:sweptAlong:forDistance:expandingBy:", self);
+	GLuint pCnt = self.planeCount;
+	CC3Plane* pArray = self.planes;
+	for (GLuint pIdx = 0; pIdx < pCnt; pIdx++) {
+		CC3Plane p = pArray[pIdx];
+		GLfloat startDist = CC3DistanceFromPlane(aSphere.center, p) - aSphere.radius;
+		if (startDist <= 0.0f) continue;
+		GLfloat distRate = CC3VectorDot(CC3PlaneNormal(p), aDirection) - expansion;
+		if (distRate >= 0.0f || (startDist + (distRate * aDistance)) > 0.0f) {
+			LogTrace(@"Sphere %@ swept along %@ is in front of plane %@ and does not intersect %@",
+					 NSStringFromCC3Spere(aSphere), NSStringFromCC3Vector(aDirection),
+					 NSStringFromCC3Plane(p), self.fullDescription);
+			return NO;
+		}
+	}
+	return YES;
+}
+
 -(BOOL) doesIntersectConvexHullOf: (GLuint) numOtherPlanes planes: (CC3Plane*) otherPlanes {
 	return [self doesIntersectConvexHullOf: numOtherPlanes planes: otherPlanes from: nil];
 }
@@ -550,7 +577,17 @@
 
 -(BOOL) isTransformDirty { return isTransformDirty; }
 
--(void) markTransformDirty { isTransformDirty = YES; }
+/** A change to the volume can change whether the node is culled, so it marks the drawing changed. */
+-(void) markTransformDirty {
+	isTransformDirty = YES;
+	[node markDrawingChanged];
+}
+
+/** A change to the volume can change whether the node is culled, so it marks the drawing changed. */
+-(void) markDirty {
+	[super markDirty];
+	[node markDrawingChanged];
+}
 
 /**
  * Builds the volume if needed, then transforms it with the node's transformMatrix.
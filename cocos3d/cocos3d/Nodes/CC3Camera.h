@@ -1040,6 +1040,23 @@ static const GLfloat kCC3DefaultFrustumFitPadding = 0.02f;
  */
 -(CC3Vector) projectNode: (CC3Node*) aNode;
 
+/**
+ * Projects each of the specified number of global locations in the locations array onto a 2D
+ * position in the viewport coordinate space, and places the results in the corresponding
+ * elements of the projectedLocations array. Each result is the same as would be returned by
+ * the projectLocation: method for the corresponding location.
+ *
+ * Unlike invoking projectLocation: for each location, this method combines the view and
+ * projection matrices only once, and then projects all of the locations in a single pass.
+ * Use this method when many locations need to be projected on each frame, such as when
+ * positioning many 2D overlay billboards.
+ *
+ * The locations and projectedLocations arrays must each contain at least the specified
+ * number of elements. They may be the same array, in which case each location is
+ * replaced by its projection.
+ */
+-(void) projectLocations: (CC3Vector*) locations into: (CC3Vector*) projectedLocations count: (GLuint) count;
+
 /**
  * Projects a 2D point, which is specified in the local coordinates of the CC3Layer,
  * into a ray extending from the camera into the 3D scene. The returned ray contains
@@ -48,6 +48,11 @@
 @property(nonatomic, readonly) CC3Matrix* globalRotationMatrix;
 @end
 
+@interface CC3ViewportManager (TemplateMethods)
+@property(nonatomic, readonly) CC3Vector glToCC2PointMapX;
+@property(nonatomic, readonly) CC3Vector glToCC2PointMapY;
+@end
+
 @interface CC3Camera (TemplateMethods)
 @property(nonatomic, readonly) CC3ViewportManager* viewportManager;
 -(void) buildModelViewMatrix;
@@ -299,6 +304,7 @@
 					  andZoom: self.uniformScale];
 
 		_isProjectionDirty = NO;
+		[self markDrawingChanged];
 		
 		// Notify the transform listeners that the projection has changed
 		[self notifyTransformListeners];
@@ -768,6 +774,49 @@
 	return pLoc;
 }
 
+/**
+ * Combines the view and projection matrices, and then performs the same projection, viewport
+ * mapping, and device orientation mapping as the projectLocation: method, for each location.
+ */
+-(void) projectLocations: (CC3Vector*) locations into: (CC3Vector*) projectedLocations count: (GLuint) count {
+	CC3Matrix4x4 viewMtx, projMtx, vpMtx;
+	[_viewMatrix populateCC3Matrix4x4: &viewMtx];
+	[frustum.projectionMatrix populateCC3Matrix4x4: &projMtx];
+	CC3Matrix4x4Multiply(&vpMtx, &projMtx, &viewMtx);
+
+	CC3ViewportManager* vpMgr = self.viewportManager;
+	CC3Viewport vp = vpMgr.viewport;
+	GLfloat halfW = vp.w * 0.5f;
+	GLfloat halfH = vp.h * 0.5f;
+	CC3Vector mapX = vpMgr.glToCC2PointMapX;
+	CC3Vector mapY = vpMgr.glToCC2PointMapY;
+	CC3Vector camLoc = self.globalLocation;
+	CC3Vector camFwd = self.globalForwardDirection;
+
+	for (GLuint i = 0; i < count; i++) {
+		CC3Vector loc = locations[i];
+
+		// Transform to clip space, and homogenize to normalized device coordinates.
+		GLfloat x = (vpMtx.c1r1 * loc.x) + (vpMtx.c2r1 * loc.y) + (vpMtx.c3r1 * loc.z) + vpMtx.c4r1;
+		GLfloat y = (vpMtx.c1r2 * loc.x) + (vpMtx.c2r2 * loc.y) + (vpMtx.c3r2 * loc.z) + vpMtx.c4r2;
+		GLfloat w = (vpMtx.c1r4 * loc.x) + (vpMtx.c2r4 * loc.y) + (vpMtx.c3r4 * loc.z) + vpMtx.c4r4;
+		if (w != 0.0f) {
+			GLfloat wInv = 1.0f / w;
+			x *= wInv;
+			y *= wInv;
+		}
+
+		// Map to the viewport, then to the device orientation.
+		CC3Vector glPt = cc3v(vp.x + (halfW * (x + 1.0f)), vp.y + (halfH * (y + 1.0f)), 1.0f);
+
+		// Signed distance from the camera, positive in front of the camera.
+		CC3Vector camToLoc = CC3VectorDifference(loc, camLoc);
+		GLfloat z = SIGN(CC3VectorDot(camToLoc, camFwd)) * CC3VectorLength(camToLoc);
+
+		projectedLocations[i] = cc3v(CC3VectorDot(mapX, glPt), CC3VectorDot(mapY, glPt), z);
+	}
+}
+
 -(CC3Ray) unprojectPoint: (CGPoint) cc2Point {
 
 	// CC_CONTENT_SCALE_FACTOR = 2.0 if Retina display active, or 1.0 otherwise.
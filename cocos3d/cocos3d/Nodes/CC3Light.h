@@ -34,7 +34,7 @@
 #import "CC3MeshNode.h"
 
 @protocol CC3ShadowProtocol;
-@class CC3ShadowCastingVolume, CC3CameraShadowVolume, CC3StencilledShadowPainterNode;
+@class CC3ShadowCastingVolume, CC3CameraShadowVolume, CC3StencilledShadowPainterNode, CC3ShadowMap;
 
 /** Constant indicating that the light is not directional. */
 static const GLfloat kCC3SpotCutoffNone = 180.0f;
@@ -51,6 +51,18 @@ static const ccColor4F kCC3DefaultLightColorSpecular = { 1.0, 1.0, 1.0, 1.0 };
 /** Default light attenuation coefficients */
 static const CC3AttenuationCoefficients kCC3DefaultLightAttenuationCoefficients = {1.0, 0.0, 0.0};
 
+/**
+ * Light index value indicating that a light has not been assigned its own GL light.
+ * See the notes for the CC3Light shouldAllowUnpooledLights class-side property.
+ */
+#define kCC3LightIndexNone	(kCC3MaxGLuint - 1)
+
+/** The techniques that can be used to render the shadows cast by a light. */
+typedef enum {
+	kCC3ShadowTechniqueShadowVolumes,	/**< Shadows are rendered by stencilling shadow volumes. */
+	kCC3ShadowTechniqueShadowMap,		/**< Shadows are rendered by sampling a shadow depth map. */
+} CC3ShadowTechnique;
+
 #pragma mark -
 #pragma mark CC3Light
 
@@ -86,6 +98,7 @@ static const CC3AttenuationCoefficients kCC3DefaultLightAttenuationCoefficients
 	CC3ShadowCastingVolume* shadowCastingVolume;
 	CC3CameraShadowVolume* cameraShadowVolume;
 	CC3StencilledShadowPainterNode* stencilledShadowPainter;
+	CC3ShadowMap* shadowMap;
 	CCArray* shadows;
 	CC3Vector4 homogeneousLocation;
 	ccColor4F ambientColor;
@@ -95,7 +108,9 @@ static const CC3AttenuationCoefficients kCC3DefaultLightAttenuationCoefficients
 	GLfloat spotExponent;
 	GLfloat spotCutoffAngle;
 	GLfloat shadowIntensityFactor;
+	GLfloat shadowCullingThreshold;
 	GLuint lightIndex;
+	CC3ShadowTechnique shadowTechnique;
 	BOOL isDirectionalOnly : 1;
 	BOOL shouldCopyLightIndex : 1;
 	BOOL shouldCastShadowsWhenInvisible : 1;
@@ -191,6 +206,19 @@ static const CC3AttenuationCoefficients kCC3DefaultLightAttenuationCoefficients
  */
 @property(nonatomic, assign) CC3AttenuationCoefficients attenuation;
 
+/**
+ * Returns the distance from this light at which its attenuated intensity falls to the
+ * specified intensity.
+ *
+ * The intensity of this light is taken as the largest component of its diffuse color plus
+ * the largest component of its ambient color, and is attenuated by the attenuation property.
+ *
+ * Returns INFINITY if this light is directional, or is not attenuated by distance, and so
+ * the intensity of this light never falls below the specified intensity. Returns zero if
+ * the intensity of this light is already below the specified intensity at the light itself.
+ */
+-(GLfloat) rangeForIntensity: (GLfloat) anIntensity;
+
 /** @deprecated Property renamed to attenuation */
 @property(nonatomic, assign) CC3AttenuationCoefficients attenuationCoefficients DEPRECATED_ATTRIBUTE;
 
@@ -482,7 +510,13 @@ static const CC3AttenuationCoefficients kCC3DefaultLightAttenuationCoefficients
 /** Update the shadows that are cast by this light. */
 -(void) updateShadows;
 
-/** Draws any shadows cast by this light. */
+/**
+ * Draws any shadows cast by this light.
+ *
+ * Shadows that are not visible within the camera frustum are not drawn, and are counted in
+ * the shadowVolumesCulled property of the performanceStatistics of the visitor. If none of
+ * the shadows are visible, the stencilled shadow painter is not drawn either.
+ */
 -(void) drawShadowsWithVisitor: (CC3NodeDrawingVisitor*) visitor;
 
 /**
@@ -528,6 +562,47 @@ static const CC3AttenuationCoefficients kCC3DefaultLightAttenuationCoefficients
  */
 @property(nonatomic, retain) CC3StencilledShadowPainterNode* stencilledShadowPainter;
 
+/**
+ * The technique used to render the shadows cast by this light.
+ *
+ * With the kCC3ShadowTechniqueShadowVolumes technique, the shadow volumes that have been
+ * added to the shadow-casting nodes are used to build a stencil, through which the shadows
+ * are painted by the stencilledShadowPainter.
+ *
+ * With the kCC3ShadowTechniqueShadowMap technique, the depth of those same shadow-casting
+ * nodes, as seen from this light, is rendered into the shadowMap, which is then sampled by
+ * the shaders when the scene is drawn. The shadow volumes remain attached to the nodes, but
+ * are neither updated nor drawn. Shadow maps require OpenGL ES 2. Under OpenGL ES 1, the
+ * shadow volumes continue to be used, regardless of the value of this property.
+ *
+ * Because both techniques use the same shadow-casting nodes, this property can be changed at
+ * any time, allowing the cost of the two techniques to be compared on the same scene.
+ * See the notes for the CC3ShadowMap class for more information about shadow maps.
+ *
+ * Setting this property to kCC3ShadowTechniqueShadowMap creates the shadowMap, if needed.
+ *
+ * The initial value of this property is kCC3ShadowTechniqueShadowVolumes.
+ */
+@property(nonatomic, assign) CC3ShadowTechnique shadowTechnique;
+
+/**
+ * The shadow map used to render the shadows cast by this light when the shadowTechnique
+ * property is set to kCC3ShadowTechniqueShadowMap.
+ *
+ * If not set directly, this property is lazily created when the shadowTechnique property
+ * is set to kCC3ShadowTechniqueShadowMap. Otherwise, the initial value is nil.
+ */
+@property(nonatomic, retain) CC3ShadowMap* shadowMap;
+
+/**
+ * Returns whether this light is currently rendering its shadows using its shadowMap.
+ *
+ * Returns YES if the shadowTechnique property is kCC3ShadowTechniqueShadowMap, this
+ * light has shadows, and the shadowMap property is not nil. Always returns NO when
+ * running under OpenGL ES 1, which does not support shadow maps.
+ */
+@property(nonatomic, readonly) BOOL isUsingShadowMap;
+
 /**
  * This property is used to adjust the shadow intensity as calculated when the
  * updateRelativeIntensityFrom: method is invoked. This property increases
@@ -558,6 +633,38 @@ static const CC3AttenuationCoefficients kCC3DefaultLightAttenuationCoefficients
  */
 @property(nonatomic, assign) GLfloat shadowIntensityFactor;
 
+/**
+ * The attenuated intensity of this light below which the shadows cast by this light
+ * are considered to be invisible.
+ *
+ * Shadows are only updated and drawn within the shadowRange of this light, which is the
+ * distance at which the attenuated intensity of this light falls to the value of this
+ * property. This allows the shadows of a light that has a limited range to be culled when
+ * that range does not reach into the camera frustum, or when the shadow cast by a node
+ * cannot reach the camera frustum before the light has faded away.
+ *
+ * The initial value of this property is 1/256. Setting this property to zero will cause
+ * shadows to be considered visible at any distance from this light.
+ */
+@property(nonatomic, assign) GLfloat shadowCullingThreshold;
+
+/**
+ * The distance from this light, beyond which its shadows are considered to be invisible.
+ *
+ * This is the distance at which the attenuated intensity of this light falls to the value
+ * of the shadowCullingThreshold property. If this light is directional, or is not attenuated
+ * by distance, the value of this property is INFINITY.
+ */
+@property(nonatomic, readonly) GLfloat shadowRange;
+
+/**
+ * Returns whether any part of the specified frustum lies within the shadowRange of this light.
+ *
+ * If this method returns NO, the shadows cast by this light cannot be visible within the
+ * frustum, and do not need to be updated or drawn. Always returns YES if the frustum is nil.
+ */
+-(BOOL) doesShadowRangeIntersectFrustum: (CC3Frustum*) aFrustum;
+
 /**
  * Updates the relative intensity of this light, as compared to the specified
  * total scene illumination.
@@ -598,6 +705,17 @@ static const CC3AttenuationCoefficients kCC3DefaultLightAttenuationCoefficients
  */
 -(void) turnOn;
 
+/**
+ * If this light is visible, turns it on by enabling the GL light at the specified index,
+ * and then applies the properties of this light to that GL light, instead of to the GL
+ * light identified by the lightIndex property.
+ *
+ * This method is used by CC3LightAssigner to bind the lights it selects for each node to
+ * the available GL lights, and can be used with lights whose lightIndex is kCC3LightIndexNone.
+ * Usually, the application never needs to invoke this method directly.
+ */
+-(void) turnOnAt: (GLuint) ltIndx;
+
 
 #pragma mark Managing the pool of available GL lights
 
@@ -638,6 +756,26 @@ static const CC3AttenuationCoefficients kCC3DefaultLightAttenuationCoefficients
  */
 +(void) disableReservedLights;
 
+/**
+ * Indicates whether lights may be created after all of the GL lights supported by the
+ * platform have been assigned to other lights.
+ *
+ * If this property is set to YES, a light that is created once all of the GL light indexes
+ * are in use will have a lightIndex of kCC3LightIndexNone, and will not be turned on by the
+ * turnOn method. Such lights can only illuminate the scene when the scene uses a
+ * CC3LightAssigner to bind the most influential lights to the available GL lights for each
+ * node as it is drawn.
+ *
+ * If this property is set to NO, attempting to create more lights than the platform supports
+ * raises an assertion error, and the light will not be created.
+ *
+ * The initial value of this property is NO.
+ */
++(BOOL) shouldAllowUnpooledLights;
+
+/** Sets whether lights may be created after all of the GL lights have been assigned to other lights. */
++(void) setShouldAllowUnpooledLights: (BOOL) shouldAllow;
+
 @end
 
 
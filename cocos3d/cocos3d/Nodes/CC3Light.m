@@ -32,6 +32,7 @@
 #import "CC3Light.h"
 #import "CC3Camera.h"
 #import "CC3ShadowVolumes.h"
+#import "CC3ShadowMaps.h"
 #import "CC3Scene.h"
 #import "CC3OpenGLESEngine.h"
 #import "CC3CC2Extensions.h"
@@ -76,13 +77,16 @@
 
 @synthesize lightIndex, shouldCopyLightIndex;
 @synthesize shadows, shadowCastingVolume, cameraShadowVolume;
-@synthesize stencilledShadowPainter, shadowIntensityFactor;
+@synthesize stencilledShadowPainter, shadowIntensityFactor, shadowCullingThreshold;
+@synthesize shadowMap, shadowTechnique;
 @synthesize ambientColor, diffuseColor, specularColor;
 @synthesize spotExponent, spotCutoffAngle, isDirectionalOnly;
 @synthesize homogeneousLocation, attenuation=_attenuation;
 
 -(void) dealloc {
 	[self cleanupShadows];		// Includes releasing the shadows array, camera shadow volume & shadow painter
+	shadowMap.light = nil;		// So it can't call back here if I'm gone
+	[shadowMap release];
 	[glesLight release];
 	[self returnLightIndex: lightIndex];
 	[super dealloc];
@@ -118,6 +122,23 @@
 	[self.scene updateRelativeLightIntensities];
 }
 
+/**
+ * The range is the positive root of (c * d * d) + (b * d) + a = (intensity / anIntensity),
+ * where a, b and c are the attenuation coefficients.
+ */
+-(GLfloat) rangeForIntensity: (GLfloat) anIntensity {
+	if (isDirectionalOnly || anIntensity <= 0.0f) return INFINITY;
+
+	GLfloat intensity = MAX(MAX(diffuseColor.r, diffuseColor.g), diffuseColor.b) +
+						MAX(MAX(ambientColor.r, ambientColor.g), ambientColor.b);
+	GLfloat a = _attenuation.a, b = _attenuation.b, c = _attenuation.c;
+	GLfloat k = a - (intensity / anIntensity);
+	if (k >= 0.0f) return 0.0f;
+	if (c > 0.0f) return (-b + sqrtf((b * b) - (4.0f * c * k))) / (2.0f * c);
+	if (b > 0.0f) return -k / b;
+	return INFINITY;
+}
+
 // Deprecated property
 -(CC3AttenuationCoefficients) attenuationCoefficients { return self.attenuation; }
 -(void) setAttenuationCoefficients: (CC3AttenuationCoefficients) attenuationCoefficients {
@@ -165,11 +186,15 @@
 			return nil;
 		}
 		lightIndex = ltIndx;
-		glesLight = [[CC3OpenGLESEngine.engine.lighting lightAt: lightIndex] retain];
+		glesLight = (lightIndex == kCC3LightIndexNone)
+						? nil
+						: [[CC3OpenGLESEngine.engine.lighting lightAt: lightIndex] retain];
 		shadows = nil;
 		shadowCastingVolume = nil;
 		cameraShadowVolume = nil;
 		stencilledShadowPainter = nil;
+		shadowMap = nil;
+		shadowTechnique = kCC3ShadowTechniqueShadowVolumes;
 		homogeneousLocation = kCC3Vector4Zero;
 		ambientColor = kCC3DefaultLightColorAmbient;
 		diffuseColor = kCC3DefaultLightColorDiffuse;
@@ -178,6 +203,7 @@
 		spotCutoffAngle = kCC3SpotCutoffNone;
 		_attenuation = kCC3DefaultLightAttenuationCoefficients;
 		shadowIntensityFactor = 1.0;
+		shadowCullingThreshold = 1.0f / 256.0f;
 		isDirectionalOnly = YES;
 		shouldCopyLightIndex = NO;
 		shouldCastShadowsWhenInvisible = NO;
@@ -243,9 +269,14 @@
 	spotCutoffAngle = another.spotCutoffAngle;
 	_attenuation = another.attenuation;
 	shadowIntensityFactor = another.shadowIntensityFactor;
+	shadowCullingThreshold = another.shadowCullingThreshold;
 	isDirectionalOnly = another.isDirectionalOnly;
 	shouldCopyLightIndex = another.shouldCopyLightIndex;
 	shouldCastShadowsWhenInvisible = another.shouldCastShadowsWhenInvisible;
+
+	// The shadow map is not copied, because it holds GL resources
+	// and is recreated when the shadow technique is set.
+	self.shadowTechnique = another.shadowTechnique;
 }
 
 /**
@@ -319,6 +350,14 @@
 	}
 }
 
+/** Temporarily redirects this light to the GL light at the specified index while turning it on. */
+-(void) turnOnAt: (GLuint) ltIndx {
+	CC3OpenGLESLight* myGLESLight = glesLight;
+	glesLight = [CC3OpenGLESEngine.engine.lighting lightAt: ltIndx];
+	[self turnOn];
+	glesLight = myGLESLight;
+}
+
 /**
  * Template method that sets the position of this light in the GL engine to the value of
  * the homogeneousLocation property of this node.
@@ -403,12 +442,50 @@
 
 -(BOOL) hasShadows { return shadows && shadows.count > 0; }
 
+/** When using a shadow map, the shadow volumes are not needed, and are left untouched. */
 -(void) updateShadows {
+	if (self.isUsingShadowMap) {
+		[shadowMap updateWithCamera: self.activeCamera];
+		return;
+	}
 	for (id<CC3ShadowProtocol> sv in shadows) {
 		[sv updateShadow];
 	}
 }
 
+-(void) setShadowTechnique: (CC3ShadowTechnique) aTechnique {
+	shadowTechnique = aTechnique;
+	if (shadowTechnique == kCC3ShadowTechniqueShadowMap && !shadowMap) {
+		self.shadowMap = [CC3ShadowMap shadowMapForLight: self];
+		[self.scene updateRelativeLightIntensities];	//  Must be done after the ivar is set.
+	}
+}
+
+-(void) setShadowMap: (CC3ShadowMap*) aShadowMap {
+	if (aShadowMap == shadowMap) return;
+	shadowMap.light = nil;
+	[shadowMap release];
+	shadowMap = [aShadowMap retain];
+	shadowMap.light = self;
+}
+
+/** Shadow maps require OpenGL ES 2. Under OpenGL ES 1, the shadow volumes are used instead. */
+-(BOOL) isUsingShadowMap {
+#if CC3_OGLES_2
+	return (shadowTechnique == kCC3ShadowTechniqueShadowMap) && shadowMap && self.hasShadows;
+#else
+	return NO;
+#endif
+}
+
+-(GLfloat) shadowRange { return [self rangeForIntensity: shadowCullingThreshold]; }
+
+-(BOOL) doesShadowRangeIntersectFrustum: (CC3Frustum*) aFrustum {
+	GLfloat range = self.shadowRange;
+	if ( !aFrustum || isinf(range) ) return YES;
+	return [aFrustum doesIntersectSphere: CC3SphereMake(self.globalLocation, range)];
+}
+
 /** Detaches old as camera listener, attaches new as camera listener, and attaches light. */
 -(void) setShadowCastingVolume: (CC3ShadowCastingVolume*) scVolume {
 	if (scVolume != shadowCastingVolume) {
@@ -499,29 +576,39 @@
 }
 
 -(void) updateRelativeIntensityFrom: (ccColor4F) totalLight {
-	if (stencilledShadowPainter) {
+	if (stencilledShadowPainter || shadowMap) {
 		GLfloat dIntensity = CCC4FIntensity(self.diffuseColor);
 		GLfloat totIntensity = CCC4FIntensity(totalLight);
 		GLfloat shadowIntensity =  (dIntensity / totIntensity) * shadowIntensityFactor;
 		stencilledShadowPainter.opacity = CCColorByteFromFloat(shadowIntensity);
+		shadowMap.intensity = CLAMP(shadowIntensity, 0.0f, 1.0f);
 		LogTrace(@"%@ updated shadow intensity to %u from light illumination %@ against total illumination %@ and shadow intensity factor %.3f",
 					  self, stencilledShadowPainter.opacity,
 					  NSStringFromCCC4F(self.diffuseColor), NSStringFromCCC4F(self.scene.totalIllumination), shadowIntensityFactor);
 	}
 }
 
-// TODO - combine with other shadow techniques - how to make polymorphic?
+/**
+ * Shadows rendered with a shadow map are applied by the shaders while the scene is drawn,
+ * so nothing is drawn here when this light is using a shadow map.
+ */
 -(void) drawShadowsWithVisitor: (CC3NodeDrawingVisitor*) visitor {
+	if (self.isUsingShadowMap) return;
 	if ( shadows && (self.visible || self.shouldCastShadowsWhenInvisible) ) {
 		LogTrace(@"%@ drawing %u shadows", self, shadows.count);
-		[self configureStencilParameters: visitor];
-		
+		GLuint visibleCount = 0;
 		for (CC3ShadowVolumeMeshNode* sv in shadows) {
+			if ( !sv.isShadowVisible ) continue;
+			if (visibleCount++ == 0) [self configureStencilParameters: visitor];
 			[sv drawToStencilWithVisitor: visitor];
 		}
-		
-		[self paintStenciledShadowsWithVisitor: visitor];
-		[self cleanupStencilParameters: visitor];
+		[visitor.performanceStatistics addShadowVolumesCulled: (shadows.count - visibleCount)];
+
+		// Painting covers the whole viewport, so skip it if no shadow volumes were drawn
+		if (visibleCount > 0) {
+			[self paintStenciledShadowsWithVisitor: visitor];
+			[self cleanupStencilParameters: visitor];
+		}
 	}
 }
 
@@ -606,9 +693,13 @@ static BOOL* _lightIndexPool = NULL;
 // Indicates the staring index to use when instantiating new lights.
 static GLuint lightPoolStartIndex = 0;
 
+// Indicates whether lights may be instantiated once the pool of light indexes is exhausted.
+static BOOL shouldAllowUnpooledLights = NO;
+
 /**
  * Assigns and returns the next available light index from the pool.
- * If no more lights are available, returns UINT_MAX.
+ * If no more lights are available, returns kCC3LightIndexNone if unpooled
+ * lights are allowed, otherwise returns UINT_MAX.
  */
 -(GLuint) nextLightIndex {
 	BOOL* indexPool = [[self class] lightIndexPool];
@@ -620,12 +711,14 @@ static GLuint lightPoolStartIndex = 0;
 			return lgtIdx;
 		}
 	}
+	if (shouldAllowUnpooledLights) return kCC3LightIndexNone;
 	NSAssert1(NO, @"Too many lights. Only %u lights may be created.", platformMaxLights);
 	return UINT_MAX;
 }
 
 /** Returns the specified light index to the pool. */
 -(void) returnLightIndex: (GLuint) aLightIndex {
+	if (aLightIndex == kCC3LightIndexNone) return;
 	LogTrace(@"Returning light index %u", aLightIndex);
 	BOOL* indexPool = [[self class] lightIndexPool];
 	indexPool[aLightIndex] = NO;
@@ -658,6 +751,10 @@ static GLuint lightPoolStartIndex = 0;
 	}
 }
 
++(BOOL) shouldAllowUnpooledLights { return shouldAllowUnpooledLights; }
+
++(void) setShouldAllowUnpooledLights: (BOOL) shouldAllow { shouldAllowUnpooledLights = shouldAllow; }
+
 @end
 
 
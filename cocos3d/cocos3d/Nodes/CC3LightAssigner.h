@@ -0,0 +1,210 @@
+/*
+ * CC3LightAssigner.h
+ *
+ * cocos3d 2.0.0
+ * Author: Bill Hollings
+ * Copyright (c) 2010-2013 The Brenwill Workshop Ltd. All rights reserved.
+ * http://www.brenwill.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * http://en.wikipedia.org/wiki/MIT_License
+ */
+
+/** @file */	// Doxygen marker
+
+
+#import "CC3Light.h"
+
+/** The maximum number of lights that a CC3LightAssigner can select for a single node. */
+#define kCC3LightAssignerMaxLightsPerNode	8
+
+
+#pragma mark -
+#pragma mark CC3LightAssigner
+
+/**
+ * CC3LightAssigner selects the lights that most influence each node that is drawn, and binds
+ * only those lights to the GL engine while that node is drawn, instead of turning on every
+ * light in the scene for every node. This allows a scene to contain more lights than the GL
+ * engine supports, and avoids the cost of lighting each node with lights that are too distant
+ * to illuminate it.
+ *
+ * To use per-node light selection, set the lightAssigner property of the CC3Scene to an
+ * instance of this class. If the scene contains more lights than the platform supports, also
+ * set the CC3Light class-side shouldAllowUnpooledLights property to YES, before creating the
+ * lights, so that lights can be created once all of the GL light indexes are in use.
+ *
+ * At the start of each frame, the prepareLights: method extracts the position, range and
+ * intensity of each visible light into a compact table. The range of each positional light
+ * is the distance at which its attenuated intensity falls below the influenceThreshold.
+ * Lights that are not attenuated, including directional lights, are considered to influence
+ * every node.
+ *
+ * For each node, the selectLightsForSphere: method finds the lights whose range reaches the
+ * bounding sphere of the node, and selects up to maxLightsPerNode of them, in order of their
+ * attenuated intensity at the surface of that sphere. To avoid testing every light against
+ * every node, the attenuated lights are held sorted along the X-axis, and only those lights
+ * whose range can overlap the sphere along that axis are tested.
+ *
+ * The bindLightsForNode: method then binds the selected lights to the GL lights from the
+ * lightPoolStartIndex of CC3Light upwards, and disables any remaining GL lights. A light that
+ * was bound to a GL light for a previous node remains bound to that GL light, so the state of
+ * each GL light only changes when a different light must be bound to it.
+ *
+ * Spot light cones are not considered when selecting lights, so a spot light may be selected
+ * for a node that lies within its range, but outside its cone.
+ */
+@interface CC3LightAssigner : NSObject {
+	struct CC3AssignableLight* lightTable;
+	CC3Light* selectedLights[kCC3LightAssignerMaxLightsPerNode];
+	GLfloat selectedInfluences[kCC3LightAssignerMaxLightsPerNode];
+	CC3Light* boundLights[kCC3LightAssignerMaxLightsPerNode];
+	GLuint lightTableCapacity;
+	GLuint unboundedLightCount;
+	GLuint attenuatedLightCount;
+	GLuint selectedLightCount;
+	GLuint maxLightsPerNode;
+	GLfloat influenceThreshold;
+	GLfloat maxAttenuatedRange;
+	GLuint lightsTested;
+	GLuint lightsSelected;
+	GLuint lightBindings;
+}
+
+/**
+ * The maximum number of lights to select for each node.
+ *
+ * When binding lights, this is further limited by the number of GL lights supported by
+ * the platform, less the lightPoolStartIndex of CC3Light. This value cannot be set larger
+ * than kCC3LightAssignerMaxLightsPerNode.
+ *
+ * The initial value of this property is 4.
+ */
+@property(nonatomic, assign) GLuint maxLightsPerNode;
+
+/**
+ * The attenuated intensity below which a light is considered to have no influence on a node.
+ *
+ * The intensity of each light is taken as the largest component of its diffuse color plus the
+ * largest component of its ambient color. This intensity is attenuated by the attenuation of
+ * the light at the distance from the light to the nearest surface of the bounding sphere of
+ * the node. Lights whose attenuated intensity at that distance is below this value are not
+ * selected for the node.
+ *
+ * The initial value of this property is 1/256.
+ */
+@property(nonatomic, assign) GLfloat influenceThreshold;
+
+/** The number of lights selected for the most recent node, which is never more than maxLightsPerNode. */
+@property(nonatomic, readonly) GLuint selectedLightCount;
+
+/**
+ * Returns the selected light at the specified index, for the most recent node. Lights are
+ * ordered by decreasing influence. The index must be less than the selectedLightCount.
+ */
+-(CC3Light*) selectedLightAt: (GLuint) index;
+
+/**
+ * The total number of lights tested against nodes, since the last invocation of the
+ * resetStatistics method. Lights that are not attenuated are not counted.
+ */
+@property(nonatomic, readonly) GLuint lightsTested;
+
+/** The total number of lights selected for nodes, since the last invocation of the resetStatistics method. */
+@property(nonatomic, readonly) GLuint lightsSelected;
+
+/**
+ * The total number of times a light was bound to a GL light that held a different light,
+ * since the last invocation of the resetStatistics method.
+ */
+@property(nonatomic, readonly) GLuint lightBindings;
+
+/** Resets the values of the lightsTested, lightsSelected and lightBindings properties to zero. */
+-(void) resetStatistics;
+
+
+#pragma mark Allocation and initialization
+
+/** Allocates and initializes an autoreleased instance. */
++(id) assigner;
+
+
+#pragma mark Assigning lights
+
+/**
+ * Extracts the location, range and intensity of each of the visible lights in the specified
+ * collection, for use when selecting lights for nodes during the current frame.
+ *
+ * This method is invoked automatically by the CC3Scene at the start of each frame. This method
+ * does not make any GL calls.
+ */
+-(void) prepareLights: (CCArray*) lights;
+
+/**
+ * Selects the lights that most influence a node with the specified global bounding sphere,
+ * from the lights extracted by the most recent invocation of the prepareLights: method,
+ * and returns the number of lights selected.
+ *
+ * The selected lights can be retrieved using the selectedLightAt: method. This method does
+ * not make any GL calls.
+ */
+-(GLuint) selectLightsForSphere: (CC3Sphere) aGlobalSphere;
+
+/**
+ * Returns the global sphere used to select the lights that illuminate the specified node.
+ *
+ * This is the global bounding sphere of the node. If the node does not have a spherical
+ * bounding volume, the global location of the node is used, with a zero radius.
+ */
+-(CC3Sphere) lightingSphereForNode: (CC3Node*) aNode;
+
+/**
+ * Selects the lights that most influence the specified node, using the sphere returned by
+ * the lightingSphereForNode: method, and returns the number of lights selected.
+ */
+-(GLuint) selectLightsForNode: (CC3Node*) aNode;
+
+/**
+ * Selects the lights that most influence the specified node, and binds them to the GL engine.
+ *
+ * This method is invoked automatically by the CC3NodeDrawingVisitor before each node that
+ * uses lighting is transformed and drawn, so that the locations of the lights are interpreted
+ * relative to the camera view.
+ */
+-(void) bindLightsForNode: (CC3Node*) aNode;
+
+/**
+ * Selects the lights that most influence a node with the specified global bounding sphere,
+ * and binds them to the GL engine.
+ *
+ * This method is invoked automatically by the CC3NodeDrawingVisitor when replaying a draw
+ * command, using the sphere that was captured in the command.
+ */
+-(void) bindLightsForSphere: (CC3Sphere) aGlobalSphere;
+
+/**
+ * Disables each of the GL lights available to this assigner, so that the next invocation of
+ * the bindLightsForNode: method binds all of the lights that it selects.
+ *
+ * This method is invoked automatically by the CC3Scene at the start of each frame.
+ */
+-(void) unbindLights;
+
+@end
@@ -0,0 +1,337 @@
+/*
+ * CC3LightAssigner.m
+ *
+ * cocos3d 2.0.0
+ * Author: Bill Hollings
+ * Copyright (c) 2010-2013 The Brenwill Workshop Ltd. All rights reserved.
+ * http://www.brenwill.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * http://en.wikipedia.org/wiki/MIT_License
+ * 
+ * See header file CC3LightAssigner.h for full API documentation.
+ */
+
+#import "CC3LightAssigner.h"
+#import "CC3BoundingVolumes.h"
+#import "CC3OpenGLESEngine.h"
+
+
+#pragma mark -
+#pragma mark CC3LightAssigner
+
+/** The location, range and intensity of a light, extracted once per frame by prepareLights:. */
+struct CC3AssignableLight {
+	CC3Light* light;							// not retained
+	CC3Vector location;
+	CC3AttenuationCoefficients attenuation;
+	GLfloat intensity;
+	GLfloat range;
+};
+typedef struct CC3AssignableLight CC3AssignableLight;
+
+/** Compares the X-axis locations of two attenuated lights, for sorting by qsort. */
+static int CC3AssignableLightCompareX(const void* a, const void* b) {
+	GLfloat ax = ((const CC3AssignableLight*)a)->location.x;
+	GLfloat bx = ((const CC3AssignableLight*)b)->location.x;
+	return (ax < bx) ? -1 : ((ax > bx) ? 1 : 0);
+}
+
+@interface CC3LightAssigner (TemplateMethods)
+-(void) ensureLightTableCapacity: (GLuint) capacity;
+-(BOOL) extractLight: (CC3Light*) aLight into: (CC3AssignableLight*) aLightEntry;
+-(void) selectLight: (CC3Light*) aLight withInfluence: (GLfloat) influence;
+-(GLuint) availableLightSlots;
+@end
+
+@implementation CC3LightAssigner
+
+@synthesize maxLightsPerNode, influenceThreshold, selectedLightCount;
+@synthesize lightsTested, lightsSelected, lightBindings;
+
+-(void) dealloc {
+	free(lightTable);
+	[super dealloc];
+}
+
+-(void) setMaxLightsPerNode: (GLuint) maxLights {
+	maxLightsPerNode = MIN(maxLights, kCC3LightAssignerMaxLightsPerNode);
+}
+
+-(CC3Light*) selectedLightAt: (GLuint) index {
+	NSAssert2(index < selectedLightCount, @"%@ selected light index %u is out of bounds", self, index);
+	return selectedLights[index];
+}
+
+-(void) resetStatistics {
+	lightsTested = 0;
+	lightsSelected = 0;
+	lightBindings = 0;
+}
+
+
+#pragma mark Allocation and initialization
+
+-(id) init {
+	if ( (self = [super init]) ) {
+		lightTable = NULL;
+		lightTableCapacity = 0;
+		unboundedLightCount = 0;
+		attenuatedLightCount = 0;
+		selectedLightCount = 0;
+		maxLightsPerNode = 4;
+		influenceThreshold = 1.0f / 256.0f;
+		maxAttenuatedRange = 0.0f;
+		for (GLuint i = 0; i < kCC3LightAssignerMaxLightsPerNode; i++) boundLights[i] = nil;
+		[self resetStatistics];
+	}
+	return self;
+}
+
++(id) assigner { return [[[self alloc] init] autorelease]; }
+
+-(NSString*) description {
+	return [NSString stringWithFormat: @"%@ selecting %u of %u lights per node", [self class],
+			maxLightsPerNode, (unboundedLightCount + attenuatedLightCount)];
+}
+
+
+#pragma mark Assigning lights
+
+-(void) ensureLightTableCapacity: (GLuint) capacity {
+	if (capacity <= lightTableCapacity) return;
+	CC3AssignableLight* newTable = realloc(lightTable, capacity * sizeof(CC3AssignableLight));
+	if ( !newTable ) {
+		LogError(@"%@ could not allocate space for %u lights", self, capacity);
+		return;
+	}
+	lightTable = newTable;
+	lightTableCapacity = capacity;
+}
+
+/**
+ * Extracts the location, intensity and range of the specified light into the specified entry,
+ * and returns whether the light can influence any node. The range is the distance at which
+ * the attenuated intensity falls to the influenceThreshold, and is infinite for lights that
+ * are not attenuated by distance.
+ */
+-(BOOL) extractLight: (CC3Light*) aLight into: (CC3AssignableLight*) aLightEntry {
+	if ( !aLight.visible ) return NO;
+
+	ccColor4F dc = aLight.diffuseColor;
+	ccColor4F ac = aLight.ambientColor;
+	GLfloat intensity = MAX(MAX(dc.r, dc.g), dc.b) + MAX(MAX(ac.r, ac.g), ac.b);
+
+	CC3AttenuationCoefficients att = aLight.isDirectionalOnly
+										? kCC3DefaultLightAttenuationCoefficients
+										: aLight.attenuation;
+	GLfloat attIntensity = intensity / MAX(att.a, 1.0e-6f);
+	if (attIntensity < influenceThreshold) return NO;
+
+	aLightEntry->light = aLight;
+	aLightEntry->location = aLight.globalLocation;
+	aLightEntry->attenuation = att;
+	aLightEntry->intensity = intensity;
+	aLightEntry->range = [aLight rangeForIntensity: influenceThreshold];
+	return YES;
+}
+
+/**
+ * Lights that are not attenuated are held at the front of the table. Attenuated lights follow
+ * them, sorted by their X-axis location, so that selection can skip lights that are out of range.
+ */
+-(void) prepareLights: (CCArray*) lights {
+	GLuint lightCount = lights.count;
+	[self ensureLightTableCapacity: lightCount];
+
+	unboundedLightCount = 0;
+	attenuatedLightCount = 0;
+	maxAttenuatedRange = 0.0f;
+	if (lightTableCapacity < lightCount) return;
+
+	// Lights that are not attenuated are placed at the front of the table, and attenuated lights
+	// are placed at the back, then moved up against the unattenuated lights before sorting.
+	GLuint backIdx = lightCount;
+	for (CC3Light* lgt in lights) {
+		CC3AssignableLight entry;
+		if ( ![self extractLight: lgt into: &entry] ) continue;
+		if (isinf(entry.range)) {
+			lightTable[unboundedLightCount++] = entry;
+		} else {
+			lightTable[--backIdx] = entry;
+			maxAttenuatedRange = MAX(maxAttenuatedRange, entry.range);
+		}
+	}
+	attenuatedLightCount = lightCount - backIdx;
+	memmove(&lightTable[unboundedLightCount], &lightTable[backIdx],
+			attenuatedLightCount * sizeof(CC3AssignableLight));
+	qsort(&lightTable[unboundedLightCount], attenuatedLightCount,
+		  sizeof(CC3AssignableLight), CC3AssignableLightCompareX);
+
+	LogTrace(@"%@ prepared %u unattenuated and %u attenuated lights with maximum range %.3f",
+			 self, unboundedLightCount, attenuatedLightCount, maxAttenuatedRange);
+}
+
+/** Inserts the specified light into the selected lights, which are held in order of decreasing influence. */
+-(void) selectLight: (CC3Light*) aLight withInfluence: (GLfloat) influence {
+	GLuint pos;
+	if (selectedLightCount < maxLightsPerNode) {
+		pos = selectedLightCount++;
+	} else if (maxLightsPerNode > 0 && influence > selectedInfluences[maxLightsPerNode - 1]) {
+		pos = maxLightsPerNode - 1;
+	} else {
+		return;
+	}
+	while (pos > 0 && influence > selectedInfluences[pos - 1]) {
+		selectedLights[pos] = selectedLights[pos - 1];
+		selectedInfluences[pos] = selectedInfluences[pos - 1];
+		pos--;
+	}
+	selectedLights[pos] = aLight;
+	selectedInfluences[pos] = influence;
+}
+
+-(GLuint) selectLightsForSphere: (CC3Sphere) aGlobalSphere {
+	selectedLightCount = 0;
+
+	for (GLuint i = 0; i < unboundedLightCount; i++) {
+		CC3AssignableLight* le = &lightTable[i];
+		[self selectLight: le->light withInfluence: (le->intensity / MAX(le->attenuation.a, 1.0e-6f))];
+	}
+
+	if (attenuatedLightCount > 0) {
+		CC3AssignableLight* attLights = &lightTable[unboundedLightCount];
+		CC3Vector center = aGlobalSphere.center;
+		GLfloat radius = aGlobalSphere.radius;
+		GLfloat minX = center.x - radius - maxAttenuatedRange;
+		GLfloat maxX = center.x + radius + maxAttenuatedRange;
+
+		// Binary search for the first light that might be within range along the X-axis
+		GLuint lo = 0, hi = attenuatedLightCount;
+		while (lo < hi) {
+			GLuint mid = (lo + hi) >> 1;
+			if (attLights[mid].location.x < minX) lo = mid + 1;
+			else hi = mid;
+		}
+
+		for (GLuint i = lo; i < attenuatedLightCount && attLights[i].location.x <= maxX; i++) {
+			CC3AssignableLight* le = &attLights[i];
+			lightsTested++;
+			GLfloat dist = CC3VectorDistance(le->location, center) - radius;
+			if (dist > le->range) continue;
+			dist = MAX(dist, 0.0f);
+			CC3AttenuationCoefficients att = le->attenuation;
+			GLfloat influence = le->intensity / (att.a + (att.b * dist) + (att.c * dist * dist));
+			if (influence >= influenceThreshold) [self selectLight: le->light withInfluence: influence];
+		}
+	}
+
+	lightsSelected += selectedLightCount;
+	return selectedLightCount;
+}
+
+-(CC3Sphere) lightingSphereForNode: (CC3Node*) aNode {
+	CC3NodeBoundingVolume* bv = aNode.boundingVolume;
+	if ([bv isKindOfClass: [CC3NodeSphereThenBoxBoundingVolume class]]) {
+		bv = ((CC3NodeSphereThenBoxBoundingVolume*)bv).sphericalBoundingVolume;
+	}
+	if ([bv isKindOfClass: [CC3NodeSphericalBoundingVolume class]]) {
+		return ((CC3NodeSphericalBoundingVolume*)bv).globalSphere;
+	}
+	return CC3SphereMake(aNode.globalLocation, 0.0f);
+}
+
+-(GLuint) selectLightsForNode: (CC3Node*) aNode {
+	return [self selectLightsForSphere: [self lightingSphereForNode: aNode]];
+}
+
+/** Returns the number of GL lights available to this assigner, above the reserved lights. */
+-(GLuint) availableLightSlots {
+	GLint platformMaxLights = [CC3OpenGLESEngine engine].platform.maxLights.value;
+	GLint slotCount = platformMaxLights - (GLint)[CC3Light lightPoolStartIndex];
+	return (GLuint)MIN(MAX(slotCount, 0), kCC3LightAssignerMaxLightsPerNode);
+}
+
+-(void) bindLightsForNode: (CC3Node*) aNode {
+	[self bindLightsForSphere: [self lightingSphereForNode: aNode]];
+}
+
+/**
+ * Lights that are already bound to one of the GL lights remain bound to that GL light.
+ * The remaining selected lights are bound to the GL lights that are not needed by the
+ * lights that remain bound, and any GL lights that are left over are disabled.
+ */
+-(void) bindLightsForSphere: (CC3Sphere) aGlobalSphere {
+	[self selectLightsForSphere: aGlobalSphere];
+
+	GLuint slotCount = MIN([self availableLightSlots], maxLightsPerNode);
+	GLuint bindCount = MIN(selectedLightCount, slotCount);
+	GLuint poolStart = [CC3Light lightPoolStartIndex];
+	BOOL isLightBound[kCC3LightAssignerMaxLightsPerNode];
+	BOOL isSlotInUse[kCC3LightAssignerMaxLightsPerNode];
+	for (GLuint k = 0; k < kCC3LightAssignerMaxLightsPerNode; k++) {
+		isLightBound[k] = NO;
+		isSlotInUse[k] = NO;
+	}
+
+	// Keep lights that are already bound in their current GL lights
+	for (GLuint i = 0; i < bindCount; i++) {
+		for (GLuint k = 0; k < slotCount; k++) {
+			if (boundLights[k] == selectedLights[i]) {
+				isLightBound[i] = YES;
+				isSlotInUse[k] = YES;
+				break;
+			}
+		}
+	}
+
+	// Bind the remaining selected lights to the GL lights that are not in use
+	GLuint slot = 0;
+	for (GLuint i = 0; i < bindCount; i++) {
+		if (isLightBound[i]) continue;
+		while (isSlotInUse[slot]) slot++;
+		CC3Light* lgt = selectedLights[i];
+		[lgt turnOnAt: (poolStart + slot)];
+		boundLights[slot] = lgt;
+		isSlotInUse[slot] = YES;
+		lightBindings++;
+	}
+
+	// Disable any GL lights that are no longer needed
+	CC3OpenGLESLighting* glesLighting = [CC3OpenGLESEngine engine].lighting;
+	for (GLuint k = 0; k < slotCount; k++) {
+		if ( !isSlotInUse[k] && boundLights[k] ) {
+			[[glesLighting lightAt: (poolStart + k)].light disable];
+			boundLights[k] = nil;
+		}
+	}
+}
+
+/** Disables all of the GL lights above the reserved lights, including any not used by this assigner. */
+-(void) unbindLights {
+	GLint platformMaxLights = [CC3OpenGLESEngine engine].platform.maxLights.value;
+	CC3OpenGLESLighting* glesLighting = [CC3OpenGLESEngine engine].lighting;
+	for (GLint i = [CC3Light lightPoolStartIndex]; i < platformMaxLights; i++) {
+		[[glesLighting lightAt: i].light disable];
+	}
+	for (GLuint k = 0; k < kCC3LightAssignerMaxLightsPerNode; k++) boundLights[k] = nil;
+}
+
+@end
@@ -84,6 +84,8 @@
  * but the mesh is simply assigned by reference, and is not copied. The result is that the the new and
  * original nodes will have different materials, but will share the same mesh. This design avoids
  * creating multiple copies of volumnious and static mesh data when creating copies of nodes.
+ * If the isMaterialShared property is set to YES, the material is also assigned by reference,
+ * and is copied only when one of the nodes modifies it.
  *
  * Normally, the front faces of a mesh are displayed, and the back faces are culled and not displayed.
  * You can change this behaviour if you need to be changing the values of the shouldCullFrontFaces and
@@ -105,6 +107,7 @@
 	GLubyte normalScalingMethod;
 	GLfloat lineWidth;
 	GLenum lineSmoothingHint;
+	GLuint textureAlignmentCount;
 	BOOL shouldSmoothLines : 1;
 	BOOL shouldDisableDepthMask : 1;
 	BOOL shouldDisableDepthTest : 1;
@@ -114,6 +117,7 @@
 	BOOL shouldUseSmoothShading : 1;
 	BOOL shouldCastShadowsWhenInvisible : 1;
 	BOOL shouldApplyOpacityAndColorToMeshContent : 1;
+	BOOL isMaterialShared : 1;
 }
 
 /**
@@ -143,6 +147,27 @@
  */
 @property(nonatomic, retain) CC3Material* material;
 
+/**
+ * Indicates whether the material of this node is shared with other mesh nodes, and should be
+ * copied before it is modified.
+ *
+ * While this property is set to YES, copies of this node are assigned the same material by
+ * reference, instead of receiving their own copy of it, and the copies will also have this
+ * property set to YES. The first time any of these nodes modifies the material through one of
+ * its own properties, such as color, opacity, diffuseColor, blendFunc or texture, that node
+ * replaces the shared material with a copy, and sets this property to NO, leaving the material
+ * of the other nodes unchanged. This allows many copies of a node to share a single material
+ * until they need to differ, as is done for instances created by a CC3NodePrefab.
+ *
+ * Properties of the shared material that are changed by accessing the material directly,
+ * through the material property, will affect all of the nodes sharing that material.
+ *
+ * Setting the material property sets this property to NO.
+ *
+ * The initial value of this property is NO.
+ */
+@property(nonatomic, assign) BOOL isMaterialShared;
+
 /**
  * The pure, solid color used to paint the mesh if no material is established for this node.
  * This color is not not be affected by the lighting conditions. The mesh will always appear
@@ -766,6 +791,19 @@
  */
 -(void) drawWithVisitor: (CC3NodeDrawingVisitor*) visitor;
 
+/**
+ * Returns the class whose drawing template methods are captured by the populateDrawCommand:withVisitor:
+ * method. Instances of a subclass that overrides any of the drawing template methods of the class
+ * returned by this method, such as drawWithVisitor:, configureDrawingParameters:,
+ * configureMaterialWithVisitor: or drawMeshWithVisitor:, are drawn live when a draw command
+ * list is replayed, instead of having their drawing captured in a draw command.
+ *
+ * This implementation returns CC3MeshNode. Subclasses that customize drawing, and that also
+ * override populateDrawCommand:withVisitor: to capture that customized drawing, will override
+ * this method to return the subclass itself.
+ */
++(Class) drawingTemplateClass;
+
 
 #pragma mark Vertex management
 
@@ -44,18 +44,18 @@
 @end
 
 @interface CC3MeshNode (TemplateMethods)
+-(void) populateDrawState: (CC3DrawState*) state;
+-(CC3NormalScaling) resolvedNormalScalingMethod;
++(BOOL) overridesDrawing;
 -(void) configureDrawingParameters: (CC3NodeDrawingVisitor*) visitor;
--(void) configureFaceCulling: (CC3NodeDrawingVisitor*) visitor;
--(void) configureNormalization: (CC3NodeDrawingVisitor*) visitor;
--(void) configureColoring: (CC3NodeDrawingVisitor*) visitor;
--(void) configureDepthTesting: (CC3NodeDrawingVisitor*) visitor;
--(void) configureDecalParameters: (CC3NodeDrawingVisitor*) visitor;
 -(void) cleanupDrawingParameters: (CC3NodeDrawingVisitor*) visitor;
--(void) configureLineProperties: (CC3NodeDrawingVisitor*) visitor;
+-(void) pushVertexLocationUnpackMatrix;
 -(void) configureMaterialWithVisitor: (CC3NodeDrawingVisitor*) visitor;
 -(void) drawMeshWithVisitor: (CC3NodeDrawingVisitor*) visitor;
 -(void) alignTextureUnit: (GLuint) texUnit;
+-(void) realignTextures;
 -(void) ensureMaterial;
+-(void) ensureOwnMaterial;
 -(void) makeMaterial;
 -(void) ensureMesh;
 -(void) makeMesh;
@@ -69,7 +69,7 @@
 
 @implementation CC3MeshNode
 
-@synthesize mesh, material, pureColor;
+@synthesize mesh, material, isMaterialShared;
 @synthesize lineWidth, shouldSmoothLines, lineSmoothingHint;
 
 -(void) dealloc {
@@ -84,6 +84,13 @@
 	[material deriveNameFrom: self];
 }
 
+-(ccColor4F) pureColor { return pureColor; }
+
+-(void) setPureColor: (ccColor4F) aColor {
+	pureColor = aColor;
+	[self markDrawingContentChanged];
+}
+
 // Sets the name of the mesh if needed then, if a bounding volume exists, forces it to
 // rebuild using the new mesh data, or creates a default bounding volume from the mesh.
 -(void) setMesh:(CC3Mesh *) aMesh {
@@ -99,6 +106,7 @@
 	} else {
 		self.boundingVolume = [self defaultBoundingVolume];
 	}
+	[self markDrawingContentChanged];
 }
 
 /** If a mesh does not yet exist, create it as a CC3VertexArrayMesh with interleaved vertices. */
@@ -117,6 +125,7 @@
  * coordinates for each texture unit against the corresponding texture in the material.
  */
 -(void) setMaterial: (CC3Material*) aMaterial {
+	isMaterialShared = NO;
 	[material autorelease];
 	material = [aMaterial retain];
 	[material deriveNameFrom: self];
@@ -128,11 +137,21 @@
 	for (GLuint texUnit = 0; texUnit < texCount; texUnit++) {
 		[self alignTextureUnit: texUnit];
 	}
+	[self markDrawingContentChanged];
 }
 
 /** If a material does not yet exist, create it by invoking the makeMaterial method. */
 -(void) ensureMaterial { if ( !material ) [self makeMaterial]; }
 
+/**
+ * Ensures that a material exists, and that it is not shared with any other mesh node, before
+ * it is modified. If the material is shared, it is replaced with a copy owned by this node.
+ */
+-(void) ensureOwnMaterial {
+	if (isMaterialShared) self.material = [material autoreleasedCopy];	// Clears isMaterialShared
+	[self ensureMaterial];
+}
+
 /**
  * Template method to create a material for this mesh node.
  *
@@ -178,6 +197,7 @@
 -(void) setShouldCullBackFaces: (BOOL) shouldCull {
 	shouldCullBackFaces = shouldCull;
 	super.shouldCullBackFaces = shouldCull;
+	[self markDrawingContentChanged];
 }
 
 -(BOOL) shouldCullFrontFaces { return shouldCullFrontFaces; }
@@ -185,6 +205,7 @@
 -(void) setShouldCullFrontFaces: (BOOL) shouldCull {
 	shouldCullFrontFaces = shouldCull;
 	super.shouldCullFrontFaces = shouldCull;
+	[self markDrawingContentChanged];
 }
 
 -(BOOL) shouldUseClockwiseFrontFaceWinding { return shouldUseClockwiseFrontFaceWinding; }
@@ -192,6 +213,7 @@
 -(void) setShouldUseClockwiseFrontFaceWinding: (BOOL) shouldWindCW {
 	shouldUseClockwiseFrontFaceWinding = shouldWindCW;
 	super.shouldUseClockwiseFrontFaceWinding = shouldWindCW;
+	[self markDrawingContentChanged];
 }
 
 -(BOOL) shouldUseSmoothShading { return shouldUseSmoothShading; }
@@ -199,6 +221,7 @@
 -(void) setShouldUseSmoothShading: (BOOL) shouldSmooth {
 	shouldUseSmoothShading = shouldSmooth;
 	super.shouldUseSmoothShading = shouldSmooth;
+	[self markDrawingContentChanged];
 }
 
 -(BOOL) shouldCastShadowsWhenInvisible { return shouldCastShadowsWhenInvisible; }
@@ -213,6 +236,7 @@
 -(void) setNormalScalingMethod: (CC3NormalScaling) nsMethod {
 	normalScalingMethod = nsMethod;
 	super.normalScalingMethod = nsMethod;
+	[self markDrawingContentChanged];
 }
 
 -(BOOL) shouldDisableDepthMask { return shouldDisableDepthMask; }
@@ -220,6 +244,7 @@
 -(void) setShouldDisableDepthMask: (BOOL) shouldDisable {
 	shouldDisableDepthMask = shouldDisable;
 	super.shouldDisableDepthMask = shouldDisable;
+	[self markDrawingContentChanged];
 }
 
 -(BOOL) shouldDisableDepthTest { return shouldDisableDepthTest; }
@@ -227,6 +252,7 @@
 -(void) setShouldDisableDepthTest: (BOOL) shouldDisable {
 	shouldDisableDepthTest = shouldDisable;
 	super.shouldDisableDepthTest = shouldDisable;
+	[self markDrawingContentChanged];
 }
 
 -(GLenum) depthFunction { return (depthFunction != GL_NEVER) ? depthFunction : super.depthFunction; }
@@ -234,6 +260,7 @@
 -(void) setDepthFunction: (GLenum) depthFunc {
 	depthFunction = depthFunc;
 	super.depthFunction = depthFunc;
+	[self markDrawingContentChanged];
 }
 
 -(GLfloat) decalOffsetFactor { return decalOffsetFactor ? decalOffsetFactor : super.decalOffsetFactor; }
@@ -241,6 +268,7 @@
 -(void) setDecalOffsetFactor: (GLfloat) factor {
 	decalOffsetFactor = factor;
 	super.decalOffsetFactor = factor;
+	[self markDrawingContentChanged];
 }
 
 -(GLfloat) decalOffsetUnits { return decalOffsetUnits ? decalOffsetUnits : super.decalOffsetUnits; }
@@ -248,6 +276,7 @@
 -(void) setDecalOffsetUnits: (GLfloat) units {
 	decalOffsetUnits = units;
 	super.decalOffsetUnits = units;
+	[self markDrawingContentChanged];
 }
 
 
@@ -256,7 +285,7 @@
 -(BOOL) shouldUseLighting { return material ? material.shouldUseLighting : NO; }
 
 -(void) setShouldUseLighting: (BOOL) useLighting {
-	if (useLighting) [self ensureMaterial];
+	if (useLighting || isMaterialShared) [self ensureOwnMaterial];
 	material.shouldUseLighting = useLighting;
 	[super setShouldUseLighting: useLighting];	// pass along to any children
 }
@@ -267,7 +296,7 @@
 }
 
 -(void) setAmbientColor:(ccColor4F) aColor {
-	[self ensureMaterial];
+	[self ensureOwnMaterial];
 	material.ambientColor = aColor;
 	[super setAmbientColor: aColor];	// pass along to any children
 }
@@ -278,7 +307,7 @@
 }
 
 -(void) setDiffuseColor:(ccColor4F) aColor {
-	[self ensureMaterial];
+	[self ensureOwnMaterial];
 	material.diffuseColor = aColor;
 	[super setDiffuseColor: aColor];	// pass along to any children
 }
@@ -289,7 +318,7 @@
 }
 
 -(void) setSpecularColor:(ccColor4F) aColor {
-	[self ensureMaterial];
+	[self ensureOwnMaterial];
 	material.specularColor = aColor;
 	[super setSpecularColor: aColor];	// pass along to any children
 }
@@ -300,7 +329,7 @@
 }
 
 -(void) setEmissionColor:(ccColor4F) aColor {
-	[self ensureMaterial];
+	[self ensureOwnMaterial];
 	material.emissionColor = aColor;
 	[super setEmissionColor: aColor];	// pass along to any children
 }
@@ -313,7 +342,7 @@
 }
 
 -(void) setGlobalLightLocation: (CC3Vector) aLocation {
-	[self ensureMaterial];
+	[self ensureOwnMaterial];
 	material.lightDirection = [self.transformMatrixInverted transformDirection: aLocation];
 	[super setGlobalLightLocation: aLocation];
 }
@@ -324,7 +353,7 @@
 }
 
 -(void) setShaderContext: (CC3GLProgramContext*) shaderContext {
-	[self ensureMaterial];
+	[self ensureOwnMaterial];
 	material.shaderContext = shaderContext;
 	[super setShaderContext: shaderContext];	// pass along to any children
 }
@@ -338,13 +367,14 @@
 }
 
 -(void) setColor: (ccColor3B) color {
-	[self ensureMaterial];
+	[self ensureOwnMaterial];
 	material.color = color;
 	if (shouldApplyOpacityAndColorToMeshContent) mesh.color = color;	// for meshes with colored vertices
 
 	pureColor.r = CCColorFloatFromByte(color.r);
 	pureColor.g = CCColorFloatFromByte(color.g);
 	pureColor.b = CCColorFloatFromByte(color.b);
+	[self markDrawingContentChanged];
 
 	[super setColor: color];	// pass along to any children
 }
@@ -355,10 +385,11 @@
 }
 
 -(void) setOpacity: (GLubyte) opacity {
-	[self ensureMaterial];
+	[self ensureOwnMaterial];
 	material.opacity = opacity;
 	if (shouldApplyOpacityAndColorToMeshContent) mesh.opacity = opacity;	// for meshes with colored vertices
 	pureColor.a = CCColorFloatFromByte(opacity);
+	[self markDrawingContentChanged];
 
 	[super setOpacity: opacity];	// pass along to any children
 }
@@ -366,9 +397,10 @@
 -(BOOL) isOpaque { return material ? material.isOpaque : YES; }
 
 -(void) setIsOpaque: (BOOL) opaque {
-	[self ensureMaterial];
+	[self ensureOwnMaterial];
 	material.isOpaque = opaque;
 	if (opaque) pureColor.a = 1.0f;
+	[self markDrawingContentChanged];
 	
 	[super setIsOpaque: opaque];	// pass along to any children
 }
@@ -379,7 +411,7 @@
 }
 
 -(void) setBlendFunc: (ccBlendFunc) aBlendFunc {
-	[self ensureMaterial];
+	[self ensureOwnMaterial];
 	material.blendFunc = aBlendFunc;
 	[super setBlendFunc: aBlendFunc];
 }
@@ -390,7 +422,7 @@
 }
 
 -(void) setShouldDrawLowAlpha: (BOOL) shouldDraw {
-	[self ensureMaterial];
+	[self ensureOwnMaterial];
 	material.shouldDrawLowAlpha = shouldDraw;
 }
 
@@ -408,6 +440,7 @@
 -(void) setLineWidth: (GLfloat) aLineWidth {
 	lineWidth = aLineWidth;
 	super.lineWidth = aLineWidth;
+	[self markDrawingContentChanged];
 }
 
 -(BOOL) shouldSmoothLines { return shouldSmoothLines; }
@@ -415,6 +448,7 @@
 -(void) setShouldSmoothLines: (BOOL) shouldSmooth {
 	shouldSmoothLines = shouldSmooth;
 	super.shouldSmoothLines = shouldSmooth;
+	[self markDrawingContentChanged];
 }
 
 -(GLenum) lineSmoothingHint { return lineSmoothingHint; }
@@ -422,6 +456,7 @@
 -(void) setLineSmoothingHint: (GLenum) aHint {
 	lineSmoothingHint = aHint;
 	super.lineSmoothingHint = aHint;
+	[self markDrawingContentChanged];
 }
 
 
@@ -432,26 +467,29 @@
 -(CC3Texture*) texture { return material.texture; }
 
 -(void) setTexture: (CC3Texture*) aTexture {
-	if (aTexture) [self ensureMaterial];
+	if (aTexture || isMaterialShared) [self ensureOwnMaterial];
 	material.texture = aTexture;
 	[self alignTextureUnit: 0];
 }
 
 -(void) addTexture: (CC3Texture*) aTexture {
-	[self ensureMaterial];
+	[self ensureOwnMaterial];
 	[material addTexture: aTexture];
 	GLuint texCount = self.textureCount;
 	if (texCount > 0) [self alignTextureUnit: (self.textureCount - 1)];
 }
 
--(void) removeAllTextures { [material removeAllTextures]; }
+-(void) removeAllTextures {
+	if (isMaterialShared) [self ensureOwnMaterial];
+	[material removeAllTextures];
+}
 
 -(CC3Texture*) textureForTextureUnit: (GLuint) texUnit {
 	return [material textureForTextureUnit: texUnit];
 }
 
 -(void) setTexture: (CC3Texture*) aTexture forTextureUnit: (GLuint) texUnit {
-	[self ensureMaterial];
+	[self ensureOwnMaterial];
 	[material setTexture: aTexture forTextureUnit: texUnit];
 	[self alignTextureUnit: texUnit];
 }
@@ -475,6 +513,19 @@
 	[mesh alignTextureUnit: texUnit withTexture: [self textureForTextureUnit: texUnit]];
 }
 
+/**
+ * Realigns the texture coordinates of each texture unit with the corresponding texture, after
+ * a texture somewhere has been replaced with one with a different mapSize or orientation, such
+ * as when a texture loaded in the background replaces its placeholder. Aligning texture
+ * coordinates that are already aligned with their texture has no effect. Texture coordinates
+ * whose content has been released by the releaseRedundantData method are not realigned.
+ */
+-(void) realignTextures {
+	GLuint texCount = self.textureCount;
+	for (GLuint texUnit = 0; texUnit < texCount; texUnit++) [self alignTextureUnit: texUnit];
+	textureAlignmentCount = CC3Texture.alignmentChangeCount;
+}
+
 // Deprecated
 -(void) alignTextures {
 	[mesh deprecatedAlignWithTexturesIn: material];
@@ -552,20 +603,28 @@
 		shouldSmoothLines = NO;
 		lineSmoothingHint = GL_DONT_CARE;
 		shouldApplyOpacityAndColorToMeshContent = NO;
+		isMaterialShared = NO;
+		textureAlignmentCount = CC3Texture.alignmentChangeCount;
 	}
 	return self;
 }
 
 // Template method that populates this instance from the specified other instance.
 // This method is invoked automatically during object copying via the copyWithZone: method.
-// A copy is made of the material.
+// A copy is made of the material, unless the material of the other node is shared,
+// in which case both nodes share the material until either one modifies it.
 // The mesh is simply retained, without creating a copy.
 // Both this node and the other node will share the mesh.
 -(void) populateFrom: (CC3MeshNode*) another {
 	[super populateFrom: another];
 	
 	self.mesh = another.mesh;								// retained but not copied
-	self.material = [another.material autoreleasedCopy];	// retained
+	if (another.isMaterialShared) {
+		self.material = another.material;					// retained but not copied
+		isMaterialShared = YES;
+	} else {
+		self.material = [another.material autoreleasedCopy];	// retained
+	}
 	
 	pureColor = another.pureColor;
 	shouldUseSmoothShading = another.shouldUseSmoothShading;
@@ -678,155 +737,173 @@
  * and the material, draws the mesh, and cleans up the drawing state.
  */
 -(void) drawWithVisitor: (CC3NodeDrawingVisitor*) visitor {
+	if (textureAlignmentCount != CC3Texture.alignmentChangeCount) [self realignTextures];
+
+	BOOL shouldUnpackLocations = mesh.hasQuantizedVertexLocations;
+	if (shouldUnpackLocations) [self pushVertexLocationUnpackMatrix];
+
 	[self configureDrawingParameters: visitor];		// Before material is configured.
 	[self configureMaterialWithVisitor: visitor];
 
 	[self drawMeshWithVisitor: visitor];
 	
 	[self cleanupDrawingParameters: visitor];
+
+	if (shouldUnpackLocations) [[CC3OpenGLESEngine engine].matrices.modelview pop];
 }
 
 /**
- * Template method to configure the drawing parameters.
- *
- * Subclasses may override to add additional drawing parameters.
+ * Template method that pushes the modelview matrix stack, and applies the transform that
+ * converts the quantized vertex locations of the mesh to mesh coordinates. The stack is
+ * popped once drawing is complete.
  */
--(void) configureDrawingParameters: (CC3NodeDrawingVisitor*) visitor {
-	[self configureFaceCulling: visitor];
-	[self configureNormalization: visitor];
-	[self configureColoring: visitor];
-	[self configureDepthTesting: visitor];
-	[self configureDecalParameters: visitor];
-	[self configureLineProperties: visitor];
+-(void) pushVertexLocationUnpackMatrix {
+	CC3OpenGLESMatrixStack* glesMatrixStack = [CC3OpenGLESEngine engine].matrices.modelview;
+	CC3Matrix4x4 unpackMtx;
+
+	[glesMatrixStack push];
+	[mesh populateVertexLocationUnpackMatrix: &unpackMtx];
+	[glesMatrixStack multiply: &unpackMtx];
 }
 
 /**
- * Template method configures GL face culling based on the shouldCullBackFaces,
- * shouldCullBackFaces, and shouldUseClockwiseFrontFaceWinding properties.
+ * If the drawing of this node can be captured, populates the draw command with the drawing
+ * state of this node, and then lets the material, mesh and shader program add their own
+ * content to the command. Otherwise, the command is left to be drawn live.
+ *
+ * The drawing of this node cannot be captured if the visitor is not decorating nodes, or if
+ * a subclass has customized any of the drawing template methods. The shouldDrawLive field
+ * is restored by the mesh if it cannot capture its drawing.
  */
--(void) configureFaceCulling: (CC3NodeDrawingVisitor*) visitor {
-	CC3OpenGLESEngine* glesEngine = [CC3OpenGLESEngine engine];
-	CC3OpenGLESCapabilities* glesServCaps = glesEngine.capabilities;
-	CC3OpenGLESState* glesState = glesEngine.state;
+-(void) populateDrawCommand: (CC3DrawCommand*) aCommand withVisitor: (CC3NodeDrawingVisitor*) visitor {
+	[super populateDrawCommand: aCommand withVisitor: visitor];
+	if ( !(mesh && visitor.shouldDecorateNode) || [[self class] overridesDrawing] ) return;
+
+	if (textureAlignmentCount != CC3Texture.alignmentChangeCount) [self realignTextures];
+
+	aCommand->shouldDrawLive = NO;
+	if (mesh.hasQuantizedVertexLocations) {
+		CC3Matrix4x4 nodeMtx = aCommand->modelMatrix;
+		CC3Matrix4x4 unpackMtx;
+		[mesh populateVertexLocationUnpackMatrix: &unpackMtx];
+		CC3Matrix4x4Multiply(&aCommand->modelMatrix, &nodeMtx, &unpackMtx);
+	}
 
-	// Enable culling if either back or front should be culled.
-	glesServCaps.cullFace.value = (shouldCullBackFaces || shouldCullFrontFaces);
+	[self populateDrawState: &aCommand->state];
+	aCommand->meshVersion = mesh.drawingVersion;
+	if (material) {
+		aCommand->materialVersion = material.drawingVersion;
+		[material populateDrawCommand: aCommand withVisitor: visitor];
+	} else {
+		aCommand->state.diffuseColor = pureColor;
+		aCommand->shaderProgram = [CC3OpenGLESEngine engine].shaders.pureColorProgram;
+	}
 
-	// Set whether back, front or both should be culled.
-	// If neither should be culled, handled by capability so leave it as back culling.
-	glesState.cullFace.value = shouldCullBackFaces
-									? (shouldCullFrontFaces ? GL_FRONT_AND_BACK : GL_BACK)
-									: (shouldCullFrontFaces ? GL_FRONT : GL_BACK);
+	visitor.textureUnitCount = aCommand->textureBindingCount;
+	[mesh populateDrawCommand: aCommand withVisitor: visitor];
+	[aCommand->shaderProgram populateDrawCommand: aCommand withVisitor: visitor];
+}
 
-	// Set the front face winding
-	glesState.frontFace.value = shouldUseClockwiseFrontFaceWinding ? GL_CW : GL_CCW;
+-(BOOL) canReuseDrawCommand: (CC3DrawCommand*) aCommand {
+	if ( ![super canReuseDrawCommand: aCommand] ) return NO;
+	if (aCommand->shouldDrawLive) return YES;
+	return (aCommand->meshVersion == mesh.drawingVersion)
+			&& (aCommand->materialVersion == material.drawingVersion)
+			&& (textureAlignmentCount == CC3Texture.alignmentChangeCount);
 }
 
++(Class) drawingTemplateClass { return [CC3MeshNode class]; }
+
 /**
- * Template method configures GL scaling of normals, based on
- * whether the scaling of this node is uniform or not.
+ * Returns whether this class overrides any of the template methods used to draw the node,
+ * relative to the class returned by the drawingTemplateClass method, in which case, the
+ * drawing of instances of this class cannot be captured in a draw command.
  */
--(void) configureNormalization: (CC3NodeDrawingVisitor*) visitor {
-	CC3OpenGLESCapabilities* glesServCaps = [CC3OpenGLESEngine engine].capabilities;
-
-	if (mesh && mesh.hasVertexNormals) {
-		switch (normalScalingMethod) {
-
-			// Enable normalizing & disable re-scaling
-			case kCC3NormalScalingNormalize:
-				[glesServCaps.rescaleNormal disable];
-				[glesServCaps.normalize enable];
-				break;
-
-			// Enable rescaling & disable normalizing
-			case kCC3NormalScalingRescale:
-				[glesServCaps.rescaleNormal enable];
-				[glesServCaps.normalize disable];
-				break;
-
-			// Choose one of the others, based on scaling characteristics
-			case kCC3NormalScalingAutomatic:	
-
-				// If no scaling, disable both normalizing and re-scaling
-				if (self.isTransformRigid) {
-					[glesServCaps.rescaleNormal disable];
-					[glesServCaps.normalize disable];
-
-				// If uniform scaling, enable re-scaling & disable normalizing
-				} else if (self.isUniformlyScaledGlobally) {
-					[glesServCaps.rescaleNormal enable];
-					[glesServCaps.normalize disable];
-
-				// If non-uniform scaling, enable normalizing & disable re-scaling
-				} else {
-					[glesServCaps.rescaleNormal disable];
-					[glesServCaps.normalize enable];
-				}
-				break;
-			
-			// Disable both rescaling & normalizing
-			case kCC3NormalScalingNone:
-			default:
-				[glesServCaps.rescaleNormal disable];
-				[glesServCaps.normalize disable];
-				break;
-		}
-	} else {
-		// No normals...so disable both rescaling & normalizing
-		[glesServCaps.rescaleNormal disable];
-		[glesServCaps.normalize disable];
++(BOOL) overridesDrawing {
+	static SEL drawingSelectors[6];
+	if ( !drawingSelectors[0] ) {
+		drawingSelectors[0] = @selector(transformAndDrawWithVisitor:);
+		drawingSelectors[1] = @selector(drawWithVisitor:);
+		drawingSelectors[2] = @selector(configureDrawingParameters:);
+		drawingSelectors[3] = @selector(configureMaterialWithVisitor:);
+		drawingSelectors[4] = @selector(drawMeshWithVisitor:);
+		drawingSelectors[5] = @selector(cleanupDrawingParameters:);
 	}
+	Class tmplClass = [self drawingTemplateClass];
+	for (GLuint i = 0; i < 6; i++) {
+		SEL drawSel = drawingSelectors[i];
+		if ([self instanceMethodForSelector: drawSel] != [tmplClass instanceMethodForSelector: drawSel]) return YES;
+	}
+	return NO;
 }
 
 /**
- * Configures the GL state for smooth shading, and to support vertex coloring.
- * This must be invoked every time, because both the material and mesh influence
- * the colorMaterial property, and the mesh will not be re-bound if it does not
- * need to be switched. And this method must be invoked before material colors
- * are set, otherwise material colors will not stick.
+ * Template method that populates the specified drawing state from the properties of this node.
+ * Blending, lighting, alpha testing and colors are populated from the material, and are
+ * initialized here for the case where this node has no material.
  */
--(void) configureColoring: (CC3NodeDrawingVisitor*) visitor {
-	CC3OpenGLESEngine* glesEngine = [CC3OpenGLESEngine engine];
-
-	// Set the smoothing model
-	glesEngine.state.shadeModel.value = shouldUseSmoothShading ? GL_SMOOTH : GL_FLAT;
-
-	// If per-vertex coloring is being used, attach it to the material
-	glesEngine.capabilities.colorMaterial.value = (mesh ? mesh.hasVertexColors : NO);
+-(void) populateDrawState: (CC3DrawState*) state {
+	state->cullFace = shouldCullBackFaces
+							? (shouldCullFrontFaces ? GL_FRONT_AND_BACK : GL_BACK)
+							: (shouldCullFrontFaces ? GL_FRONT : GL_NONE);
+	state->frontFace = shouldUseClockwiseFrontFaceWinding ? GL_CW : GL_CCW;
+	state->normalScalingMethod = self.resolvedNormalScalingMethod;
+	state->shadeModel = shouldUseSmoothShading ? GL_SMOOTH : GL_FLAT;
+	state->shouldColorMaterial = (mesh ? mesh.hasVertexColors : NO);
+	state->shouldTestDepth = !shouldDisableDepthTest;
+	state->shouldWriteDepth = !shouldDisableDepthMask;
+	state->depthFunction = depthFunction;
+	state->decalOffsetFactor = decalOffsetFactor;
+	state->decalOffsetUnits = decalOffsetUnits;
+	state->lineWidth = lineWidth;
+	state->shouldSmoothLines = shouldSmoothLines;
+	state->lineSmoothingHint = lineSmoothingHint;
+	state->shouldBlend = NO;
+	state->sourceBlend = GL_ONE;
+	state->destinationBlend = GL_ZERO;
+	state->alphaTestFunction = GL_ALWAYS;
+	state->alphaTestReference = 0.0f;
+	state->shouldUseLighting = NO;
 }
 
 /**
- * Template method disables depth testing and/or writing to the depth buffer if the
- * shouldDisableDepthTest and shouldDisableDepthMask property is set to YES, respectively,
- * and set the depth function.
+ * Returns the normal scaling method to use, resolving kCC3NormalScalingAutomatic
+ * based on whether the scaling of this node is uniform or not.
+ *
+ * The transform that unpacks quantized vertex locations adds a uniform scale, and quantized
+ * normals are not exactly unit length, so must be normalized.
  */
--(void) configureDepthTesting: (CC3NodeDrawingVisitor*) visitor {
-	CC3OpenGLESEngine* glesEngine = [CC3OpenGLESEngine engine];
-	CC3OpenGLESState* glesState = glesEngine.state;
-	glesEngine.capabilities.depthTest.value = !shouldDisableDepthTest;
-	glesState.depthMask.value = !shouldDisableDepthMask;
-	glesState.depthFunction.value = depthFunction;
+-(CC3NormalScaling) resolvedNormalScalingMethod {
+	if ( !(mesh && mesh.hasVertexNormals) ) return kCC3NormalScalingNone;
+
+	switch (normalScalingMethod) {
+		case kCC3NormalScalingNormalize:
+		case kCC3NormalScalingRescale:
+			return normalScalingMethod;
+		case kCC3NormalScalingAutomatic:
+			if (self.isTransformRigid && !mesh.hasQuantizedVertexLocations && !mesh.hasQuantizedVertexNormals) {
+				return kCC3NormalScalingNone;
+			} else if (self.isUniformlyScaledGlobally && !mesh.hasQuantizedVertexNormals) {
+				return kCC3NormalScalingRescale;
+			} else {
+				return kCC3NormalScalingNormalize;
+			}
+		case kCC3NormalScalingNone:
+		default:
+			return kCC3NormalScalingNone;
+	}
 }
 
 /**
- * Template method that establishes the decal offset parameters to cause the depth
- * of the content being drawn to be offset relative to the depth of the content
- * that has already been drawn.
+ * Template method to configure the drawing parameters, by populating a drawing state from
+ * the properties of this node, and applying it to the GL engine.
+ *
+ * Subclasses may override to add additional drawing parameters.
  */
--(void) configureDecalParameters: (CC3NodeDrawingVisitor*) visitor {
-	CC3OpenGLESEngine* glesEngine = [CC3OpenGLESEngine engine];
-	
-	BOOL hasDecalOffset = decalOffsetFactor || decalOffsetUnits;
-	glesEngine.capabilities.polygonOffsetFill.value = hasDecalOffset;
-	[glesEngine.state.polygonOffset applyFactor: decalOffsetFactor andUnits: decalOffsetUnits];
-}
-
-/** Template method to configure line drawing properties. */
--(void) configureLineProperties: (CC3NodeDrawingVisitor*) visitor {
-	CC3OpenGLESEngine* glesEngine = [CC3OpenGLESEngine engine];
-	glesEngine.state.lineWidth.value = lineWidth;
-	glesEngine.capabilities.lineSmooth.value = shouldSmoothLines;
-	glesEngine.hints.lineSmooth.value = lineSmoothingHint;
+-(void) configureDrawingParameters: (CC3NodeDrawingVisitor*) visitor {
+	CC3DrawState state;
+	[self populateDrawState: &state];
+	CC3DrawStateApplyDrawingParameters(&state);
 }
 
 /**
@@ -849,9 +926,9 @@
 			CC3OpenGLESEngine.engine.state.color.value = pureColor;
 			[CC3OpenGLESEngine.engine.shaders bindPureColorProgramWithVisitor: visitor];
 		}
-	} else {	// Probably node picking
+	} else {	// Probably node picking or shadow mapping
 		[CC3Material unbind];
-		[CC3OpenGLESEngine.engine.shaders bindPureColorProgramWithVisitor: visitor];
+		[visitor bindUndecoratedProgram];
 	}
 }
 
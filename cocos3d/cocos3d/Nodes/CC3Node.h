@@ -39,7 +39,7 @@
 #import "CC3GLProgramContext.h"
 
 @class CC3NodeDrawingVisitor, CC3Scene, CC3Camera, CC3Frustum;
-@class CC3NodeAnimation, CC3NodeDescriptor, CC3WireframeBoundingBoxNode;
+@class CC3NodeAnimation, CC3NodeDescriptor, CC3WireframeBoundingBoxNode, CC3NodePool;
 
 /**
  * Enumeration of options for scaling normals after they have been transformed during
@@ -219,12 +219,14 @@ typedef enum {
 	CC3Rotator* rotator;
 	CC3NodeBoundingVolume* boundingVolume;
 	CC3NodeAnimation* animation;
+	CC3NodePool* pool;
 	CC3Vector location;
 	CC3Vector globalLocation;
 	CC3Vector projectedLocation;
 	CC3Vector scale;
 	CC3Vector globalScale;
 	GLfloat boundingVolumePadding;
+	GLuint drawingVersion;
 	BOOL isTransformDirty : 1;
 	BOOL isTransformInvertedDirty : 1;
 	BOOL isGlobalRotationDirty : 1;
@@ -237,6 +239,7 @@ typedef enum {
 	BOOL shouldAutoremoveWhenEmpty : 1;
 	BOOL shouldUseFixedBoundingVolume : 1;
 	BOOL shouldStopActionsWhenRemoved : 1;
+	BOOL shouldRecycleWhenRemoved : 1;
 }
 
 /**
@@ -2306,6 +2309,40 @@ typedef enum {
  */
 -(void) transformAndDrawWithVisitor: (CC3NodeDrawingVisitor*) visitor;
 
+/**
+ * Populates the specified draw command with the content needed to draw this node, so that
+ * the command can be replayed without consulting this node, or any of its content.
+ *
+ * This implementation sets the modelMatrix of the command to the current transformMatrix
+ * of this node, and sets the shouldDrawLive field of the command to YES, so that a node
+ * whose drawing cannot be captured in a command is drawn by invoking its
+ * transformAndDrawWithVisitor: method when the command is replayed. Subclasses that can
+ * capture their drawing will override to add their resolved drawing state, program uniforms,
+ * vertex and texture bindings, and draw ranges, and to clear the shouldDrawLive field.
+ *
+ * Variable-length content is allocated from the command list of the specified visitor.
+ *
+ * This method is invoked automatically, on the rendering thread, when a CC3NodeDrawingVisitor
+ * records a CC3DrawCommandList, and again whenever the drawingVersion of this node, or of its
+ * mesh or material, has changed since the command was last populated. The application should
+ * never have need to used this method.
+ */
+-(void) populateDrawCommand: (CC3DrawCommand*) aCommand withVisitor: (CC3NodeDrawingVisitor*) visitor;
+
+/**
+ * Returns whether the specified draw command, which was populated for this node on a previous
+ * frame, still reflects the drawing of this node, and can be drawn again without being populated.
+ *
+ * This implementation returns YES if the drawingVersion of this node has not changed since the
+ * command was populated, and the command was not marked as volatile. Subclasses that capture
+ * the content of other objects, such as meshes and materials, will override to also compare
+ * the versions of those objects.
+ *
+ * This method is invoked automatically when a CC3NodeDrawingVisitor records a CC3DrawCommandList.
+ * The application should never have need to used this method.
+ */
+-(BOOL) canReuseDrawCommand: (CC3DrawCommand*) aCommand;
+
 /**
  * Returns whether the bounding volume of this node intersects the specified camera frustum.
  * This check does not include checking children, only the local content.
@@ -2340,6 +2377,41 @@ typedef enum {
  */
 -(void) drawWithVisitor: (CC3NodeDrawingVisitor*) visitor;
 
+/**
+ * Returns a count that is incremented whenever the drawing of this node changes.
+ *
+ * A CC3DrawCommandList compares this value to the value it had when the draw command for this
+ * node was last populated, to determine whether that command can be reused on the next frame.
+ */
+@property(nonatomic, readonly) GLuint drawingVersion;
+
+/**
+ * Indicates that the drawing of this node has changed in a way that can affect which nodes
+ * are drawn, or the order in which they are drawn.
+ *
+ * This implementation increments the drawingVersion of this node, and then invokes this method
+ * on the CC3Scene that contains this node, if any. CC3Scene overrides this method to increment
+ * its drawingChangeCount, which it uses to decide whether the scene must be traversed again.
+ *
+ * This is invoked automatically whenever the transformMatrix, bounding volume or visibility of
+ * this node is changed. The application can invoke this method when it makes any other change
+ * that affects which nodes should be drawn. This method may be invoked from any thread.
+ */
+-(void) markDrawingChanged;
+
+/**
+ * Indicates that the drawing of this node has changed in a way that does not affect which
+ * nodes are drawn, such as a change to the drawing state of a mesh node.
+ *
+ * This implementation increments the drawingVersion of this node, so that the draw command
+ * for this node is populated again on the next frame, without traversing the scene again.
+ *
+ * This is invoked automatically when the drawing properties of this node are changed. Changes
+ * to meshes and materials are tracked by those objects, and do not require this method to be
+ * invoked. This method may be invoked from any thread.
+ */
+-(void) markDrawingContentChanged;
+
 /**
  * Checks that the child nodes of this node are in the correct drawing order relative
  * to other nodes. This implementation forwards this request to all descendants.
@@ -2584,12 +2656,18 @@ typedef enum {
 /**
  * Retrieves the first node found with the specified name, anywhere in the structural hierarchy
  * of descendants of this node (not just direct children). The hierarchy search is depth-first.
+ *
+ * If this node has been added to a CC3Scene, the name index maintained by the scene is used
+ * to locate the node without traversing the hierarchy. See the nodesNamed: method of CC3Scene.
  */
 -(CC3Node*) getNodeNamed: (NSString*) aName;
 
 /**
  * Retrieves the first node found with the specified tag, anywhere in the structural hierarchy
  * of descendants of this node (not just direct children). The hierarchy search is depth-first.
+ *
+ * If this node has been added to a CC3Scene, the tag index maintained by the scene is used
+ * to locate the node without traversing the hierarchy. See the nodesTagged: method of CC3Scene.
  */
 -(CC3Node*) getNodeTagged: (GLuint) aTag;
 
@@ -2599,6 +2677,16 @@ typedef enum {
  */
 -(BOOL) isDescendantOf: (CC3Node*) aNode;
 
+/**
+ * Returns whether this node is visited before the specified node in a depth-first
+ * traversal of the structural hierarchy that contains both nodes. A node is visited
+ * before its descendants, and before the later children of its parent.
+ *
+ * Returns NO if the specified node is this node, or is not in the same structural
+ * hierarchy as this node.
+ */
+-(BOOL) precedesInDepthFirstOrder: (CC3Node*) aNode;
+
 /**
  * Returns an autoreleased array containing this node and all its descendants.
  * This is done by invoking flattenInto: with a newly-created array, and returning the array. 
@@ -2713,6 +2801,39 @@ typedef enum {
  */
 @property(nonatomic, assign) BOOL shouldStopActionsWhenRemoved;
 
+/**
+ * The CC3NodePool from which this node was acquired, and into which this node is recycled when
+ * it is removed from its parent, if the shouldRecycleWhenRemoved property is set to YES.
+ *
+ * This property is set automatically when this node is acquired from a node pool, and is cleared
+ * automatically when this node is recycled into that pool. The value of this property is not
+ * copied when this node is copied.
+ *
+ * The initial value of this property is nil.
+ */
+@property(nonatomic, retain) CC3NodePool* pool;
+
+/**
+ * Indicates whether this node should be recycled into the node pool indicated by the pool
+ * property when this node is removed from its parent.
+ *
+ * If this property is set to YES, once this node has been removed from its parent, using the
+ * remove or removeChild: method, it is reset and held by the node pool for reuse. The application
+ * must not continue to use this node once it has been removed. If the pool property is nil, this
+ * property has no effect.
+ *
+ * Like the shouldStopActionsWhenRemoved property, this property is temporarily set to NO by the
+ * addChild: method when this node is moved from one parent to another, so that it is not recycled
+ * during the move.
+ *
+ * This property is set to YES automatically when this node is acquired from a node pool. If you
+ * want to remove a pooled node from its parent and keep using it, set this property to NO before
+ * removing it. The value of this property is not copied when this node is copied.
+ *
+ * The initial value of this property is NO.
+ */
+@property(nonatomic, assign) BOOL shouldRecycleWhenRemoved;
+
 /** @deprecated Renamed to shouldStopActionsWhenRemoved. */
 @property(nonatomic, assign) BOOL shouldCleanupActionsWhenRemoved DEPRECATED_ATTRIBUTE;
 
@@ -3172,6 +3293,23 @@ typedef enum {
  */
 -(void) establishAnimationFrameAt: (ccTime) t;
 
+/**
+ * Sets the location, rotation quaternion, and scale of this node from animation content,
+ * without marking the transform of this node as dirty. Any of the specified pointers may
+ * be NULL, in which case the corresponding property of this node is left unchanged. As with
+ * the quaternion property, the quaternion is ignored if this node is tracking a target.
+ *
+ * Because the transform of this node is not marked as dirty, the invoker must ensure that
+ * this node, or one of its ancestors, is marked as dirty once all animated nodes have been
+ * updated. This allows all of the nodes of a skeleton to be updated in bulk, as is done by
+ * the CC3NodeAnimationBatch class.
+ *
+ * Usually, the application never needs to invoke this method directly.
+ */
+-(void) setAnimatedLocation: (const CC3Vector*) pLocation
+				 quaternion: (const CC3Quaternion*) pQuaternion
+					  scale: (const CC3Vector*) pScale;
+
 
 #pragma mark Developer support
 
@@ -44,6 +44,7 @@
 #import "CC3LinearMatrix.h"
 #import "CC3CC2Extensions.h"
 #import "CC3IOSExtensions.h"
+#import "CC3NodePool.h"
 
 
 #pragma mark CC3Node
@@ -73,6 +74,11 @@
 -(CC3Vector) rotationallyRestrictTargetLocation: (CC3Vector) aLocation;
 -(void) convertRotatorGlobalToLocal;
 -(void) didSetTargetInDescendant: (CC3Node*) aNode;
+-(void) willChangeIdentityOfDescendant: (CC3Node*) aNode;
+-(void) didChangeIdentityOfDescendant: (CC3Node*) aNode;
+-(CC3Node*) findNodeNamed: (NSString*) aName;
+-(CC3Node*) findNodeTagged: (GLuint) aTag;
+-(CC3Node*) firstDescendantIn: (CCArray*) depthFirstNodes;
 -(void) applyScaling;
 -(void) transformMatrixChanged;
 -(void) notifyTransformListeners;
@@ -97,7 +103,7 @@
 @synthesize transformMatrix, transformListeners, animation, isRunning, isAnimationEnabled;
 @synthesize shouldInheritTouchability, shouldAllowTouchableWhenInvisible;
 @synthesize parent, children, shouldAutoremoveWhenEmpty, shouldUseFixedBoundingVolume;
-@synthesize shouldStopActionsWhenRemoved, isTransformDirty;
+@synthesize shouldStopActionsWhenRemoved, isTransformDirty, pool, shouldRecycleWhenRemoved;
 
 -(void) dealloc {
 	self.target = nil;							// Removes myself as listener
@@ -109,6 +115,7 @@
 	[rotator release];
 	[boundingVolume release];
 	[animation release];
+	[pool release];
 	[self notifyDestructionListeners];			// Must do before releasing listeners.
 	[transformListeners releaseAsUnretained];	// Clears without releasing each element.
 	[super dealloc];
@@ -940,6 +947,7 @@
 		boundingVolume = nil;
 		boundingVolumePadding = 0.0f;
 		shouldUseFixedBoundingVolume = NO;
+		drawingVersion = 0;
 		location = kCC3VectorZero;
 		globalLocation = kCC3VectorZero;
 		projectedLocation = kCC3VectorZero;
@@ -954,6 +962,8 @@
 		isRunning = NO;
 		shouldStopActionsWhenRemoved = YES;
 		shouldAutoremoveWhenEmpty = NO;
+		pool = nil;
+		shouldRecycleWhenRemoved = NO;
 		self.transformMatrix = [CC3AffineMatrix matrix];		// Has side effects...so do last (transformMatrixInverted is built in some subclasses)
 	}
 	return self;
@@ -1206,7 +1216,7 @@
 static GLuint lastAssignedNodeTag;
 
 -(GLuint) nextTag {
-	return ++lastAssignedNodeTag;
+	return CC3IncrementTagCounter(&lastAssignedNodeTag);
 }
 
 +(void) resetTagAllocation {
@@ -1220,6 +1230,11 @@ static GLuint lastAssignedNodeTag;
 
 -(BOOL) visible { return visible && (!parent || parent.visible); }
 
+-(void) setVisible: (BOOL) isVisible {
+	if ( !isVisible != !visible ) [self markDrawingChanged];
+	visible = isVisible;
+}
+
 -(void) show { self.visible = YES; }
 
 -(void) hide { self.visible = NO; }
@@ -1559,6 +1574,7 @@ static GLuint lastAssignedNodeTag;
 	[self transformBoundingVolume];
 	isTransformDirty = NO;
 	isTransformInvertedDirty = YES;
+	[self markDrawingChanged];
 }
 
 /** Notify the transform listeners that the node has been transformed. */
@@ -1655,7 +1671,14 @@ static GLuint lastAssignedNodeTag;
  */
 -(void) transformBoundingVolume { [boundingVolume markTransformDirty]; }
 
--(void) markBoundingVolumeDirty { if (!shouldUseFixedBoundingVolume) [boundingVolume markDirty]; }
+/**
+ * Marks the drawing as changed even when the bounding volume is fixed, because a change
+ * to the content of this node can also change whether it is culled.
+ */
+-(void) markBoundingVolumeDirty {
+	if (!shouldUseFixedBoundingVolume) [boundingVolume markDirty];
+	[self markDrawingChanged];
+}
 
 // Deprecated method
 -(void) rebuildBoundingVolume { [self markBoundingVolumeDirty]; }
@@ -1665,6 +1688,15 @@ static GLuint lastAssignedNodeTag;
 
 -(void) drawWithVisitor: (CC3NodeDrawingVisitor*) visitor {}
 
+-(GLuint) drawingVersion { return drawingVersion; }
+
+-(void) markDrawingChanged {
+	[self markDrawingContentChanged];
+	[self.scene markDrawingChanged];
+}
+
+-(void) markDrawingContentChanged { CC3IncrementChangeCounter(&drawingVersion); }
+
 -(BOOL) doesIntersectFrustum: (CC3Frustum*) aFrustum {
 	return [self doesIntersectBoundingVolume: aFrustum];
 }
@@ -1685,6 +1717,15 @@ static GLuint lastAssignedNodeTag;
 	[glesMatrixStack pop];
 }
 
+-(void) populateDrawCommand: (CC3DrawCommand*) aCommand withVisitor: (CC3NodeDrawingVisitor*) visitor {
+	[transformMatrix populateCC3Matrix4x4: &aCommand->modelMatrix];
+	aCommand->shouldDrawLive = YES;
+}
+
+-(BOOL) canReuseDrawCommand: (CC3DrawCommand*) aCommand {
+	return (aCommand->nodeVersion == drawingVersion) && !aCommand->isVolatile;
+}
+
 -(void) checkDrawingOrder {
 	for (CC3Node* child in children) {
 		[child checkDrawingOrder];
@@ -1718,11 +1759,15 @@ static GLuint lastAssignedNodeTag;
 	NSAssert(aNode, @"Child CC3Node cannot be nil");
 	if(aNode.parent == self) return;
 
-	// Remove node from its existing parent after temporarily clearing the action cleanup flag.
+	// Remove node from its existing parent after temporarily clearing the action cleanup
+	// and recycling flags.
 	BOOL origCleanupFlag = aNode.shouldStopActionsWhenRemoved;
+	BOOL origRecycleFlag = aNode.shouldRecycleWhenRemoved;
 	aNode.shouldStopActionsWhenRemoved = NO;
+	aNode.shouldRecycleWhenRemoved = NO;
 	[aNode remove];
 	aNode.shouldStopActionsWhenRemoved = origCleanupFlag;
+	aNode.shouldRecycleWhenRemoved = origRecycleFlag;
 
 	// Lazily create the children array if needed
 	if(!children) children = [[CCArray array] retain];
@@ -1812,6 +1857,13 @@ static GLuint lastAssignedNodeTag;
 			}
 			[aNode wasRemoved];						// Invoke before didRemoveDesc notification
 			[self didRemoveDescendant: aNode];
+			// Recycling clears the back-reference from the node to its pool. If the node holds
+			// the last reference to the pool, the pool would be deallocated while it is still
+			// recycling the node. Retain the pool until we're done with it.
+			if (aNode.shouldRecycleWhenRemoved) {
+				CC3NodePool* aPool = [[aNode.pool retain] autorelease];
+				[aPool recycleNode: aNode];
+			}
 		}
 		LogTrace(@"After removing %@, %@ now has children: %@", aNode, self, children);
 		
@@ -1850,6 +1902,34 @@ static GLuint lastAssignedNodeTag;
 	return (aNode == self) || (parent && [parent isDescendantOf: aNode]);
 }
 
+/**
+ * Both nodes are brought up to the same depth. If they meet, one is the ancestor of the other.
+ * Otherwise, they are brought up together until they are siblings, and the order of those
+ * siblings within their common parent determines the order.
+ */
+-(BOOL) precedesInDepthFirstOrder: (CC3Node*) aNode {
+	if ( !aNode || aNode == self ) return NO;
+
+	GLuint myDepth = 0, otherDepth = 0;
+	for (CC3Node* n = parent; n; n = n.parent) myDepth++;
+	for (CC3Node* n = aNode.parent; n; n = n.parent) otherDepth++;
+
+	CC3Node* mine = self;
+	CC3Node* other = aNode;
+	for ( ; myDepth > otherDepth; myDepth--) mine = mine.parent;
+	for ( ; otherDepth > myDepth; otherDepth--) other = other.parent;
+
+	if (mine == other) return (mine == self);		// An ancestor precedes its descendants
+
+	while (mine.parent != other.parent) {
+		mine = mine.parent;
+		other = other.parent;
+	}
+	CCArray* siblings = mine.parent.children;
+	if ( !siblings ) return NO;						// Not in the same hierarchy
+	return [siblings indexOfObjectIdenticalTo: mine] < [siblings indexOfObjectIdenticalTo: other];
+}
+
 /**
  * Invoked automatically when a node is added as a child somewhere in the descendant structural
  * hierarchy of this node. The method is not only invoked on the immediate parent of the newly
@@ -1881,12 +1961,41 @@ static GLuint lastAssignedNodeTag;
 /** Pass indication up the ancestor chain that a node has had its target set. */
 -(void) didSetTargetInDescendant: (CC3Node*) aNode { [parent didSetTargetInDescendant: aNode]; }
 
+/** Overridden to keep the name index of the scene up to date. */
+-(void) setName: (NSString*) aName {
+	[parent willChangeIdentityOfDescendant: self];
+	super.name = aName;
+	[parent didChangeIdentityOfDescendant: self];
+}
+
+/** Overridden to keep the tag index of the scene up to date. */
+-(void) setTag: (GLuint) aTag {
+	[parent willChangeIdentityOfDescendant: self];
+	super.tag = aTag;
+	[parent didChangeIdentityOfDescendant: self];
+}
+
+/** Pass indication up the ancestor chain that a node is about to change its name or tag. */
+-(void) willChangeIdentityOfDescendant: (CC3Node*) aNode { [parent willChangeIdentityOfDescendant: aNode]; }
+
+/** Pass indication up the ancestor chain that a node has changed its name or tag. */
+-(void) didChangeIdentityOfDescendant: (CC3Node*) aNode { [parent didChangeIdentityOfDescendant: aNode]; }
+
+/** If this node is in a scene, the first descendant is retrieved from the scene's name index. */
 -(CC3Node*) getNodeNamed: (NSString*) aName {
+	CC3Scene* myScene = self.scene;
+	if ( !(aName && myScene) ) return [self findNodeNamed: aName];
+	if ([name isEqual: aName]) return self;		// The scene is not in its own index
+	return [self firstDescendantIn: [myScene nodesNamed: aName]];
+}
+
+/** Searches this node and its descendants, depth-first, for the first node with the specified name. */
+-(CC3Node*) findNodeNamed: (NSString*) aName {
 	if ([name isEqual: aName] || (!name && !aName)) {	// my name equal or both nil
 		return self;
 	}
 	for (CC3Node* child in children) {
-		CC3Node* childResult = [child getNodeNamed: aName];
+		CC3Node* childResult = [child findNodeNamed: aName];
 		if (childResult) {
 			return childResult;
 		}
@@ -1894,12 +2003,45 @@ static GLuint lastAssignedNodeTag;
 	return nil;
 }
 
+/** If this node is in a scene, the first descendant is retrieved from the scene's tag index. */
 -(CC3Node*) getNodeTagged: (GLuint) aTag {
+	CC3Scene* myScene = self.scene;
+	if ( !myScene ) return [self findNodeTagged: aTag];
+	if (tag == aTag) return self;				// The scene is not in its own index
+	return [self firstDescendantIn: [myScene nodesTagged: aTag]];
+}
+
+/**
+ * Returns the first of the specified nodes that is this node or one of its descendants, or nil
+ * if none are. The nodes must be in depth-first order, as maintained by the index of the scene.
+ *
+ * In depth-first order, this node is immediately followed by all of its descendants. So the
+ * first of the nodes that does not precede this node is found by a binary search, and that
+ * is the only candidate that needs to be checked.
+ */
+-(CC3Node*) firstDescendantIn: (CCArray*) depthFirstNodes {
+	NSUInteger lo = 0, hi = depthFirstNodes.count;
+	while (lo < hi) {
+		NSUInteger mid = (lo + hi) / 2;
+		if ([[depthFirstNodes objectAtIndex: mid] precedesInDepthFirstOrder: self]) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	if (lo == depthFirstNodes.count) return nil;
+
+	CC3Node* aNode = [depthFirstNodes objectAtIndex: lo];
+	return [aNode isDescendantOf: self] ? aNode : nil;
+}
+
+/** Searches this node and its descendants, depth-first, for the first node with the specified tag. */
+-(CC3Node*) findNodeTagged: (GLuint) aTag {
 	if (tag == aTag) {
 		return self;
 	}
 	for (CC3Node* child in children) {
-		CC3Node* childResult = [child getNodeTagged: aTag];
+		CC3Node* childResult = [child findNodeTagged: aTag];
 		if (childResult) {
 			return childResult;
 		}
@@ -2115,6 +2257,14 @@ static GLuint lastAssignedNodeTag;
 	}
 }
 
+-(void) setAnimatedLocation: (const CC3Vector*) pLocation
+				 quaternion: (const CC3Quaternion*) pQuaternion
+					  scale: (const CC3Vector*) pScale {
+	if (pLocation) location = *pLocation;
+	if (pQuaternion && !self.shouldTrackTarget) self.mutableRotator.quaternion = *pQuaternion;
+	if (pScale) scale = *pScale;
+}
+
 
 #pragma mark Developer support
 
@@ -0,0 +1,116 @@
+/*
+ * CC3NodePool.h
+ *
+ * cocos3d 2.0.0
+ * Author: Bill Hollings
+ * Copyright (c) 2010-2013 The Brenwill Workshop Ltd. All rights reserved.
+ * http://www.brenwill.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * http://en.wikipedia.org/wiki/MIT_License
+ */
+
+/** @file */	// Doxygen marker
+
+
+#import "CC3ObjectPool.h"
+#import "CC3NodePrefab.h"
+
+
+#pragma mark -
+#pragma mark CC3NodePool
+
+/**
+ * CC3NodePool is a CC3ObjectPool that holds instances of a node assembly, such as a projectile
+ * or a hit effect, that are frequently added to and removed from a scene, so that removed
+ * instances can be reused instead of being deallocated.
+ *
+ * A node pool is created from a template node. New instances are created through a CC3NodePrefab
+ * of the template, and so share the meshes, materials and animations of the template. When an
+ * instance is recycled, the same prefab returns each node of the instance to the state of the
+ * corresponding template node, in place, without allocating new nodes.
+ *
+ * Nodes acquired from this pool using the acquireNode or acquireNodeWithName: method have their
+ * pool property set to this pool, and their shouldRecycleWhenRemoved property set to YES. When
+ * such a node is removed from its parent, using the remove or removeChild: method, or through the
+ * requestRemovalOf: method of a node visitor, it is automatically recycled into this pool, after
+ * the scene has processed the removal. The application must not continue to use the node once
+ * it has been removed. To remove such a node from its parent without recycling it, set its
+ * shouldRecycleWhenRemoved property to NO before removing it.
+ *
+ * An instance whose node assembly has been structurally changed, by adding or removing nodes,
+ * cannot be reset, and is discarded instead of being recycled.
+ */
+@interface CC3NodePool : CC3ObjectPool {
+	CC3NodePrefab* prefab;
+}
+
+/** The prefab used to create new instances, and to reset recycled instances. */
+@property(nonatomic, retain, readonly) CC3NodePrefab* prefab;
+
+
+#pragma mark Acquiring and recycling nodes
+
+/**
+ * Returns an autoreleased instance of the template node, either by removing a free instance
+ * from this pool, or by creating a new instance from the prefab. The root node of the returned
+ * instance has the same name as the template node.
+ */
+-(CC3Node*) acquireNode;
+
+/**
+ * Returns an autoreleased instance of the template node, either by removing a free instance
+ * from this pool, or by creating a new instance from the prefab, and sets the name of the root
+ * node of that instance to the specified name.
+ */
+-(CC3Node*) acquireNodeWithName: (NSString*) aName;
+
+/**
+ * Returns the specified node to this pool, once the application no longer needs it.
+ *
+ * If the node still has a parent, it is first removed from that parent. The node is reset to the
+ * state of the template node, and is held for reuse. If this pool is full, or the node cannot be
+ * reset, the node is discarded instead.
+ *
+ * The application must not continue to use the node once it has been recycled.
+ */
+-(void) recycleNode: (CC3Node*) aNode;
+
+
+#pragma mark Allocation and initialization
+
+/**
+ * Initializes this instance to hold instances of the specified template node.
+ *
+ * A CC3NodePrefab is created from the specified node. See the notes for that
+ * class for more information about how the template node is copied.
+ */
+-(id) initFromNode: (CC3Node*) aNode;
+
+/**
+ * Allocates and initializes an autoreleased instance to hold instances of the
+ * specified template node.
+ *
+ * A CC3NodePrefab is created from the specified node. See the notes for that
+ * class for more information about how the template node is copied.
+ */
++(id) poolFromNode: (CC3Node*) aNode;
+
+@end
@@ -0,0 +1,105 @@
+/*
+ * CC3NodePool.m
+ *
+ * cocos3d 2.0.0
+ * Author: Bill Hollings
+ * Copyright (c) 2010-2013 The Brenwill Workshop Ltd. All rights reserved.
+ * http://www.brenwill.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * http://en.wikipedia.org/wiki/MIT_License
+ * 
+ * See header file CC3NodePool.h for full API documentation.
+ */
+
+#import "CC3NodePool.h"
+
+
+#pragma mark -
+#pragma mark CC3NodePool
+
+@implementation CC3NodePool
+
+@synthesize prefab;
+
+-(void) dealloc {
+	[prefab release];
+	[super dealloc];
+}
+
+
+#pragma mark Acquiring and recycling nodes
+
+-(CC3Node*) acquireNode {
+	CC3Node* aNode = [self acquireObject];
+	aNode.pool = self;
+	aNode.shouldRecycleWhenRemoved = YES;
+	return aNode;
+}
+
+-(CC3Node*) acquireNodeWithName: (NSString*) aName {
+	CC3Node* aNode = [self acquireNode];
+	aNode.name = aName;
+	return aNode;
+}
+
+-(void) recycleNode: (CC3Node*) aNode {
+	if (aNode.parent) {
+		aNode.shouldRecycleWhenRemoved = NO;		// Avoid recycling twice
+		[aNode remove];
+	}
+	[self recycleObject: aNode];
+}
+
+/** Creates a new instance through the prefab. */
+-(id) makeObject { return [prefab instance]; }
+
+/**
+ * Resets the node through the prefab, and detaches it from this pool while it is held, so
+ * that the free nodes held by this pool do not retain this pool.
+ */
+-(BOOL) resetObject: (CC3Node*) aNode {
+	aNode.pool = nil;
+	aNode.shouldRecycleWhenRemoved = NO;
+	if ( ![prefab resetInstance: aNode] ) return NO;
+	aNode.name = prefab.prototype.name;
+	return YES;
+}
+
+
+#pragma mark Allocation and initialization
+
+-(id) init { return [self initFromNode: nil]; }
+
+-(id) initFromNode: (CC3Node*) aNode {
+	NSAssert1(aNode, @"%@ must be initialized with a template node.", [self class]);
+	if ( (self = [super init]) ) {
+		prefab = [[CC3NodePrefab alloc] initFromNode: aNode];		// retained
+	}
+	return self;
+}
+
++(id) poolFromNode: (CC3Node*) aNode { return [[[self alloc] initFromNode: aNode] autorelease]; }
+
+-(NSString*) description {
+	return [NSString stringWithFormat: @"%@ of %@", [super description], prefab.prototype];
+}
+
+@end
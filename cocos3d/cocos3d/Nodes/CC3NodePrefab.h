@@ -0,0 +1,139 @@
+/*
+ * CC3NodePrefab.h
+ *
+ * cocos3d 2.0.0
+ * Author: Bill Hollings
+ * Copyright (c) 2010-2013 The Brenwill Workshop Ltd. All rights reserved.
+ * http://www.brenwill.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * http://en.wikipedia.org/wiki/MIT_License
+ */
+
+/** @file */	// Doxygen marker
+
+
+#import "CC3Node.h"
+
+
+#pragma mark -
+#pragma mark CC3NodePrefab
+
+/**
+ * CC3NodePrefab creates many instances of a template node assembly, such as a character loaded
+ * from a POD file, faster than copying the template with the copy or copyWithName: methods.
+ *
+ * When a prefab is created from a template node, it makes a private copy of the template, held in
+ * the prototype property, and flattens the node assembly of that prototype into a compact table
+ * that records, for each node, the index of its parent, and, for each bone of each skin section,
+ * the index of that bone within the table. Only nodes whose shouldIncludeInDeepCopy property
+ * returns YES are included, as when copying.
+ *
+ * Each invocation of the instanceWithName: method creates a new node for each entry in the table,
+ * populates it from the corresponding prototype node, and adds it to the node created for its
+ * parent. This avoids the recursive copying of child nodes, and each skin section is attached to
+ * the bones of the new instance by index, instead of searching the new skeleton for each bone by
+ * name. If a soft-body node in the prototype animates its bones through a CC3NodeAnimationBatch,
+ * the corresponding soft-body node of each instance is given its own batch.
+ *
+ * All instances share the meshes and animations of the prototype, as they would when copying.
+ * In addition, the isMaterialShared property of each mesh node in the prototype is set to YES,
+ * so all instances share the materials of the prototype until an instance modifies the material
+ * of one of its mesh nodes, at which point that mesh node receives its own copy of the material.
+ *
+ * The node assembly of the prototype must not be structurally changed once the prefab has been
+ * created. The properties of the prototype nodes may be changed, and will be propagated to any
+ * instances created subsequently.
+ */
+@interface CC3NodePrefab : NSObject {
+	CC3Node* prototype;
+	CC3Node** prototypeNodes;
+	CC3Node** instanceNodes;
+	GLuint* parentIndices;
+	GLubyte* nodeTraits;
+	GLuint* boneIndices;
+	GLuint nodeCount;
+	GLuint boneIndexCount;
+	GLuint instanceCount;
+}
+
+/**
+ * The private copy of the template node from which this prefab creates instances.
+ *
+ * Properties of the nodes in this node assembly may be changed, and will be propagated to
+ * instances created subsequently, but nodes must not be added to or removed from it.
+ */
+@property(nonatomic, retain, readonly) CC3Node* prototype;
+
+/** The number of nodes in each instance created by this prefab. */
+@property(nonatomic, readonly) GLuint nodeCount;
+
+/** The number of instances created by this prefab. */
+@property(nonatomic, readonly) GLuint instanceCount;
+
+
+#pragma mark Allocation and initialization
+
+/**
+ * Initializes this instance to create instances of the specified template node.
+ *
+ * A copy is made of the specified node, and held in the prototype property. The specified node
+ * itself is not retained, and subsequent changes to it are not reflected in the instances.
+ */
+-(id) initFromNode: (CC3Node*) aNode;
+
+/**
+ * Allocates and initializes an autoreleased instance to create instances of the
+ * specified template node.
+ *
+ * See the notes for the initFromNode: method for more information.
+ */
++(id) prefabFromNode: (CC3Node*) aNode;
+
+
+#pragma mark Instantiation
+
+/**
+ * Returns a new autoreleased instance of the prototype node assembly, whose root node has the
+ * specified name. The descendant nodes of the instance have the same names as the
+ * corresponding nodes of the prototype.
+ */
+-(id) instanceWithName: (NSString*) aName;
+
+/**
+ * Returns a new instance of the prototype node assembly, whose root node has the same name
+ * as the prototype.
+ */
+-(id) instance;
+
+/**
+ * Returns the specified instance, previously created by this prefab, to the state of a newly
+ * created instance, by populating each of its nodes from the corresponding prototype node, and
+ * reattaching its skin sections to its own bones. The names of the nodes are not changed.
+ *
+ * Returns whether the instance could be reset. Returns NO, and leaves the instance unchanged,
+ * if nodes have been added to or removed from the instance, or have been replaced with nodes
+ * of a different class, so that the instance no longer corresponds to the prototype.
+ *
+ * This method is invoked automatically when a node is recycled into a CC3NodePool.
+ */
+-(BOOL) resetInstance: (CC3Node*) anInstance;
+
+@end
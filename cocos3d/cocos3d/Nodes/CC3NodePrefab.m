@@ -0,0 +1,235 @@
+/*
+ * CC3NodePrefab.m
+ *
+ * cocos3d 2.0.0
+ * Author: Bill Hollings
+ * Copyright (c) 2010-2013 The Brenwill Workshop Ltd. All rights reserved.
+ * http://www.brenwill.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * http://en.wikipedia.org/wiki/MIT_License
+ * 
+ * See header file CC3NodePrefab.h for full API documentation.
+ */
+
+#import "CC3NodePrefab.h"
+#import "CC3MeshNode.h"
+#import "CC3VertexSkinning.h"
+
+
+/** Indicates that a node is a CC3SkinMeshNode, whose skin sections must be attached to the instance bones. */
+#define kCC3PrefabNodeTraitSkin		1
+
+/** Indicates that a node is a CC3SoftBodyNode whose animation is batched. */
+#define kCC3PrefabNodeTraitBatch	2
+
+
+#pragma mark -
+#pragma mark CC3NodePrefab
+
+@interface CC3NodePrefab (TemplateMethods)
+-(void) collectNodesFrom: (CC3Node*) aNode into: (CCArray*) nodes;
+-(void) flattenPrototype;
+-(GLuint) collectInstanceNodesFrom: (CC3Node*) aNode at: (GLuint) nodeIdx;
+-(void) attachInstanceNodes;
+@end
+
+
+@implementation CC3NodePrefab
+
+@synthesize prototype, nodeCount, instanceCount;
+
+-(void) dealloc {
+	[prototype release];
+	free(prototypeNodes);
+	free(instanceNodes);
+	free(parentIndices);
+	free(nodeTraits);
+	free(boneIndices);
+	[super dealloc];
+}
+
+
+#pragma mark Allocation and initialization
+
+-(id) initFromNode: (CC3Node*) aNode {
+	if ( (self = [super init]) ) {
+		prototype = [aNode copy];				// retained
+		prototypeNodes = NULL;
+		instanceNodes = NULL;
+		parentIndices = NULL;
+		nodeTraits = NULL;
+		boneIndices = NULL;
+		nodeCount = 0;
+		boneIndexCount = 0;
+		instanceCount = 0;
+		[self flattenPrototype];
+	}
+	return self;
+}
+
++(id) prefabFromNode: (CC3Node*) aNode {
+	return [[[self alloc] initFromNode: aNode] autorelease];
+}
+
+-(NSString*) description {
+	return [NSString stringWithFormat: @"%@ of %@ with %u nodes", [self class], prototype, nodeCount];
+}
+
+/** Adds the specified node, and those descendants that are included in copies, in depth-first order. */
+-(void) collectNodesFrom: (CC3Node*) aNode into: (CCArray*) nodes {
+	[nodes addObject: aNode];
+	for (CC3Node* child in aNode.children) {
+		if (child.shouldIncludeInDeepCopy) [self collectNodesFrom: child into: nodes];
+	}
+}
+
+/**
+ * Flattens the prototype node assembly into the node table, recording the index of the parent
+ * of each node, and the index of each bone of each skin section. Because nodes are collected in
+ * depth-first order, the parent of each node always appears in the table before that node.
+ *
+ * The materials of the prototype mesh nodes are marked as shared, so that instances share them.
+ */
+-(void) flattenPrototype {
+	CCArray* nodes = [CCArray array];
+	[self collectNodesFrom: prototype into: nodes];
+
+	nodeCount = nodes.count;
+	prototypeNodes = calloc(nodeCount, sizeof(CC3Node*));
+	instanceNodes = calloc(nodeCount, sizeof(CC3Node*));
+	parentIndices = calloc(nodeCount, sizeof(GLuint));
+	nodeTraits = calloc(nodeCount, sizeof(GLubyte));
+
+	boneIndexCount = 0;
+	for (GLuint i = 0; i < nodeCount; i++) {
+		CC3Node* aNode = [nodes objectAtIndex: i];
+		prototypeNodes[i] = aNode;					// not retained...held by the prototype
+		parentIndices[i] = i ? [nodes indexOfObjectIdenticalTo: aNode.parent] : 0;
+
+		if ( [aNode isKindOfClass: [CC3MeshNode class]] ) {
+			CC3MeshNode* meshNode = (CC3MeshNode*)aNode;
+			if (meshNode.material) meshNode.isMaterialShared = YES;
+		}
+		if ( [aNode isKindOfClass: [CC3SkinMeshNode class]] ) {
+			nodeTraits[i] |= kCC3PrefabNodeTraitSkin;
+			for (CC3SkinSection* skinSctn in ((CC3SkinMeshNode*)aNode).skinSections)
+				boneIndexCount += skinSctn.boneCount;
+		}
+		if ( [aNode isKindOfClass: [CC3SoftBodyNode class]] && ((CC3SoftBodyNode*)aNode).animationBatch )
+			nodeTraits[i] |= kCC3PrefabNodeTraitBatch;
+	}
+
+	boneIndices = calloc(MAX(boneIndexCount, 1), sizeof(GLuint));
+	GLuint boneIdx = 0;
+	for (GLuint i = 0; i < nodeCount; i++) {
+		if ( !(nodeTraits[i] & kCC3PrefabNodeTraitSkin) ) continue;
+		for (CC3SkinSection* skinSctn in ((CC3SkinMeshNode*)prototypeNodes[i]).skinSections) {
+			for (CC3Bone* bone in skinSctn.bones) {
+				NSUInteger nodeIdx = [nodes indexOfObjectIdenticalTo: bone];
+				NSAssert3(nodeIdx != NSNotFound, @"%@ cannot attach %@ to bone %@, which lies outside the prototype",
+						  self, prototypeNodes[i], bone);
+				boneIndices[boneIdx++] = nodeIdx;
+			}
+		}
+	}
+	LogTrace(@"%@ flattened %u nodes with %u skinned bones", self, nodeCount, boneIndexCount);
+}
+
+
+#pragma mark Instantiation
+
+/**
+ * Creates and populates a node for each entry in the node table, adding each to the node created
+ * for its parent, then attaches the skin sections to the new bones, and batches the animation
+ * of any soft-body nodes whose prototypes are batched. Skin sections and animation batches are
+ * handled once all nodes exist, since bones may follow the skin mesh nodes in the table.
+ */
+-(id) instanceWithName: (NSString*) aName {
+	for (GLuint i = 0; i < nodeCount; i++) {
+		CC3Node* protoNode = prototypeNodes[i];
+		CC3Node* instNode = [[[protoNode class] alloc] initWithName: (i ? protoNode.name : aName)];
+		[instNode populateFrom: protoNode];
+		instanceNodes[i] = instNode;
+		if (i) {
+			[instanceNodes[parentIndices[i]] addChild: instNode];
+			[instNode release];						// retained by parent
+		}
+	}
+
+	[self attachInstanceNodes];
+
+	CC3Node* instRoot = instanceNodes[0];
+	memset(instanceNodes, 0, nodeCount * sizeof(CC3Node*));		// Don't keep references to the instance
+	instanceCount++;
+	return [instRoot autorelease];
+}
+
+-(id) instance { return [self instanceWithName: prototype.name]; }
+
+/**
+ * Attaches the skin sections of the nodes in the instance node table to the bones in that
+ * table, and batches the animation of any soft-body nodes whose prototypes are batched,
+ * and which are not already batched.
+ */
+-(void) attachInstanceNodes {
+	GLuint* nodeBoneIndices = boneIndices;
+	for (GLuint i = 0; i < nodeCount; i++) {
+		if (nodeTraits[i] & kCC3PrefabNodeTraitSkin) {
+			for (CC3SkinSection* skinSctn in ((CC3SkinMeshNode*)instanceNodes[i]).skinSections) {
+				[skinSctn reattachBonesFromNodes: instanceNodes atIndices: nodeBoneIndices];
+				nodeBoneIndices += skinSctn.boneCount;
+			}
+		}
+	}
+	for (GLuint i = 0; i < nodeCount; i++) {
+		CC3SoftBodyNode* sbNode = (CC3SoftBodyNode*)instanceNodes[i];
+		if ( (nodeTraits[i] & kCC3PrefabNodeTraitBatch) && !sbNode.animationBatch ) [sbNode batchAnimation];
+	}
+}
+
+/**
+ * Adds the specified instance node, and those descendants that are included in copies, to the
+ * instance node table, in depth-first order, starting at the specified index. Returns the index
+ * following the last node added, or kCC3MaxGLuint if the nodes do not correspond to the nodes
+ * of the prototype in number and class.
+ */
+-(GLuint) collectInstanceNodesFrom: (CC3Node*) aNode at: (GLuint) nodeIdx {
+	if (nodeIdx >= nodeCount || [aNode class] != [prototypeNodes[nodeIdx] class]) return kCC3MaxGLuint;
+	instanceNodes[nodeIdx++] = aNode;
+	for (CC3Node* child in aNode.children) {
+		if ( !child.shouldIncludeInDeepCopy ) continue;
+		nodeIdx = [self collectInstanceNodesFrom: child at: nodeIdx];
+		if (nodeIdx == kCC3MaxGLuint) break;
+	}
+	return nodeIdx;
+}
+
+-(BOOL) resetInstance: (CC3Node*) anInstance {
+	BOOL canReset = ([self collectInstanceNodesFrom: anInstance at: 0] == nodeCount);
+	if (canReset) {
+		for (GLuint i = 0; i < nodeCount; i++) [instanceNodes[i] populateFrom: prototypeNodes[i]];
+		[self attachInstanceNodes];
+	}
+	memset(instanceNodes, 0, nodeCount * sizeof(CC3Node*));		// Don't keep references to the instance
+	return canReset;
+}
+
+@end
@@ -34,7 +34,9 @@
 #import "CC3PerformanceStatistics.h"
 
 @class CC3Node, CC3MeshNode, CC3Camera, CC3Light, CC3Scene;
-@class CC3Material, CC3Mesh, CC3NodeSequencer;
+@class CC3Material, CC3Mesh, CC3NodeSequencer, CC3DrawCommandList, CC3LightAssigner;
+@class CC3ShadowMap, CC3GLProgram, CC3GLProgramContext, CC3VertexArray, CC3OpenGLESTextureUnit;
+typedef struct CC3DrawCommand CC3DrawCommand;
 
 
 #pragma mark -
@@ -305,10 +307,16 @@
  */
 @interface CC3NodeDrawingVisitor : CC3NodeVisitor {
 	CC3NodeSequencer* drawingSequencer;
+	CC3DrawCommandList* commandList;
+	CC3LightAssigner* lightAssigner;
+	CC3ShadowMap* shadowMap;
 	GLuint textureUnitCount;
 	GLuint textureUnit;
+	double cullingTime;
+	double submissionTime;
 	BOOL shouldDecorateNode : 1;
 	BOOL shouldClearDepthBuffer : 1;
+	BOOL shouldTimeDrawingPhases : 1;
 }
 
 /**
@@ -322,6 +330,28 @@
  */
 @property(nonatomic, assign) CC3NodeSequencer* drawingSequencer;
 
+/**
+ * The light assigner that selects the lights to be bound to the GL engine for each node.
+ *
+ * If this property is not nil, before each node that uses lighting is transformed and
+ * drawn, the light assigner binds the lights that most influence that node. If this
+ * property is nil, the lights turned on by the CC3Scene illuminate every node.
+ *
+ * This property is automatically set to the value of the lightAssigner property of the
+ * CC3Scene. The light assigner is not retained by this visitor.
+ */
+@property(nonatomic, assign) CC3LightAssigner* lightAssigner;
+
+/**
+ * The shadow map that is sampled by the shaders while the nodes are drawn, or nil if
+ * no shadow map is in use.
+ *
+ * This property is automatically set by the CC3Scene to the shadow map of the first light
+ * whose shadowTechnique is kCC3ShadowTechniqueShadowMap, after that shadow map has been
+ * drawn. The shadow map is not retained by this visitor.
+ */
+@property(nonatomic, assign) CC3ShadowMap* shadowMap;
+
 /**
  * The number of texture units being drawn.
  *
@@ -356,6 +386,28 @@
  */
 @property(nonatomic, assign) BOOL shouldClearDepthBuffer;
 
+/**
+ * Indicates whether this visitor should time the kCC3PerformancePhaseCulling and
+ * kCC3PerformancePhaseSubmission phases in the performance statistics of the scene.
+ *
+ * Each phase is recorded once for each visitation run. When a command list is in use,
+ * each phase is timed around the corresponding pass. Otherwise, culling and drawing are
+ * interleaved, and the time spent deciding whether to draw each node, and the time spent
+ * drawing each node, are each accumulated across the run, and recorded when this visitor
+ * is closed.
+ *
+ * The phases are only timed while the scene has a performanceStatistics instance to record
+ * them into. When the scene is not collecting performance statistics, this property has
+ * no effect, and the clock is not read while nodes are culled and drawn.
+ *
+ * This property is set to YES for the drawVisitor of the CC3Scene. Other drawing visitors,
+ * such as those used for shadows and node picking, leave it at NO, so that those phases
+ * describe only the drawing of the main view of the scene.
+ *
+ * The initial value of this property is NO.
+ */
+@property(nonatomic, assign) BOOL shouldTimeDrawingPhases;
+
 /**
  * Draws the specified node. Invoked by the node itself when the node's local
  * content is to be drawn.
@@ -369,6 +421,72 @@
  */
 -(void) draw: (CC3Node*) aNode;
 
+/**
+ * Binds the GL program used to draw a node when the shouldDecorateNode property is set to NO.
+ *
+ * This implementation binds the GL program that paints nodes with a pure color, as used during
+ * node picking. Subclasses that draw undecorated nodes for other purposes may override.
+ */
+-(void) bindUndecoratedProgram;
+
+
+#pragma mark Draw command lists
+
+/**
+ * The command list into which this visitor records the nodes to be drawn.
+ *
+ * If this property is nil, each node is drawn to the GL engine as it is encountered
+ * during the visitation run, interleaving culling, sequencing and drawing in one pass.
+ *
+ * If this property is not nil, the visitation run is split into two phases. During the
+ * traversal, each node that passes the visibility and frustum tests is recorded into the
+ * command list, without making any GL calls. Then, when the traversal is complete, the
+ * close method hands the command list to the executor held in the executor property of
+ * the command list, to be replayed to the GL engine.
+ *
+ * Each command captures everything needed to draw its node, resolved when the command is
+ * populated: the transform, the fixed-function drawing state, the material colors, the texture
+ * and vertex bindings, the draw ranges, and the values of the shader uniforms that depend on
+ * the node. When the command list is replayed, the commands are applied directly to the GL
+ * engine, without messaging the nodes, meshes or materials.
+ *
+ * If the command list has already been recorded, and has not been invalidated since, the
+ * traversal, including culling and sequencing, is skipped entirely, and the nodes recorded
+ * on the previous frame are drawn again, in the same order. The CC3Scene invalidates the
+ * command list of its drawVisitor whenever the transform, bounding volume or visibility of
+ * any node in the scene, the camera projection, or the structure of the scene changes.
+ *
+ * Whether or not the scene is traversed, the command for each node is reused from the previous
+ * frame, unless the node, its mesh or its material has changed since that command was populated,
+ * as indicated by their drawingVersion properties, in which case the command is populated again.
+ *
+ * The initial value of this property is nil.
+ */
+@property(nonatomic, retain) CC3DrawCommandList* commandList;
+
+/**
+ * Populates the specified draw command for the specified node, by making the node the
+ * currentNode, and invoking the populateDrawCommand:withVisitor: method of the node.
+ *
+ * If the node uses lighting, the global sphere used to select the lights for the node
+ * is also captured in the command.
+ *
+ * This method is invoked by the commandList when a command must be populated. This method does
+ * not make any GL calls. The application should never have need to used this method.
+ */
+-(void) populateDrawCommand: (CC3DrawCommand*) aCommand forNode: (CC3Node*) aNode;
+
+/**
+ * Draws the specified command, which must be held by the commandList of this visitor,
+ * by applying the content captured in the command directly to the GL engine.
+ *
+ * If the shouldDrawLive field of the command is set, the node could not capture its drawing
+ * in the command, and is transformed and drawn in the same way as when no command list is used.
+ *
+ * This method is invoked by a draw command executor when replaying a command list.
+ */
+-(void) drawCommand: (CC3DrawCommand*) aCommand;
+
 
 #pragma mark Accessing node contents
 
@@ -427,6 +545,422 @@
 @end
 
 
+#pragma mark -
+#pragma mark CC3DrawCommand
+
+/**
+ * The fixed-function GL state that is established before a node is drawn, as captured
+ * into a CC3DrawCommand. Blending, lighting, alpha testing and the material colors are
+ * captured from the material of the node. If the node has no material, the pure color
+ * of the node is captured in the diffuseColor field.
+ */
+typedef struct {
+	GLenum cullFace;				/**< The faces to cull, or GL_NONE if face culling is disabled. */
+	GLenum frontFace;				/**< The winding of front faces, either GL_CW or GL_CCW. */
+	GLubyte normalScalingMethod;	/**< The resolved normal scaling method, which is never kCC3NormalScalingAutomatic. */
+	GLenum shadeModel;				/**< The shading model, either GL_SMOOTH or GL_FLAT. */
+	GLenum depthFunction;			/**< The depth test function. */
+	GLenum sourceBlend;				/**< The source blending function. */
+	GLenum destinationBlend;		/**< The destination blending function. */
+	GLenum alphaTestFunction;		/**< The alpha test function, which is GL_ALWAYS if alpha testing is disabled. */
+	GLfloat alphaTestReference;		/**< The alpha test reference value. */
+	ccColor4F ambientColor;			/**< The ambient color of the material, with any opacity applied. */
+	ccColor4F diffuseColor;			/**< The diffuse color of the material, with any opacity applied. */
+	ccColor4F specularColor;		/**< The specular color of the material, with any opacity applied. */
+	ccColor4F emissionColor;		/**< The emission color of the material, with any opacity applied. */
+	GLfloat shininess;				/**< The shininess of the material. */
+	GLfloat decalOffsetFactor;		/**< The polygon offset factor. */
+	GLfloat decalOffsetUnits;		/**< The polygon offset units. */
+	GLfloat lineWidth;				/**< The width of lines. */
+	GLenum lineSmoothingHint;		/**< The line smoothing hint. */
+	BOOL shouldTestDepth : 1;		/**< Whether depth testing is enabled. */
+	BOOL shouldWriteDepth : 1;		/**< Whether the depth buffer is written. */
+	BOOL shouldBlend : 1;			/**< Whether blending is enabled. */
+	BOOL shouldUseLighting : 1;		/**< Whether lighting is enabled. */
+	BOOL shouldColorMaterial : 1;	/**< Whether vertex colors are applied to the material. */
+	BOOL shouldSmoothLines : 1;		/**< Whether lines are smoothed. */
+} CC3DrawState;
+
+/**
+ * The binding of a single vertex array to the GL engine, as captured into the content of a
+ * CC3DrawCommand.
+ *
+ * If the content of the vertex array must be copied to the GL engine when the command is
+ * replayed, because the content is streamed, or because the GL buffer holds a dirty range
+ * of vertices, the vertexArray field holds that vertex array, which resolves the bufferID
+ * and pointer fields when the command is replayed. Otherwise, the vertexArray field is nil.
+ */
+typedef struct {
+	CC3VertexArray* vertexArray;	/**< The vertex array to synchronize when replayed, or nil. Retained by the command list. */
+	GLenum bufferTarget;			/**< The GL buffer target, either GL_ARRAY_BUFFER or GL_ELEMENT_ARRAY_BUFFER. */
+	GLuint bufferID;				/**< The GL buffer to bind, or zero if the content is in application memory. */
+	GLvoid* pointer;				/**< The offset into the GL buffer, or the address of the content in application memory. */
+	GLenum semantic;				/**< The vertex pointer semantic, offset by the texture unit for texture coordinates. */
+	GLint elementSize;				/**< The number of components in each element. */
+	GLenum elementType;				/**< The type of each component. */
+	GLsizei vertexStride;			/**< The number of bytes between consecutive elements. */
+	BOOL shouldNormalize;			/**< Whether integer components are normalized. */
+} CC3DrawVertexBinding;
+
+/**
+ * The binding of a texture to a GL texture unit, and the environment of that texture unit,
+ * as captured into the content of a CC3DrawCommand.
+ */
+typedef struct {
+	GLuint textureName;					/**< The GL name of the texture. */
+	GLenum minifyingFunction;			/**< The texture minifying function. */
+	GLenum magnifyingFunction;			/**< The texture magnifying function. */
+	GLenum horizontalWrappingFunction;	/**< The texture horizontal wrapping function. */
+	GLenum verticalWrappingFunction;	/**< The texture vertical wrapping function. */
+	GLenum environmentMode;				/**< The texture environment mode. */
+	ccColor4F constantColor;			/**< The constant color of the texture environment. */
+	GLenum combineRGBFunction;			/**< The RGB combiner function, used if isCombining is set. */
+	GLenum rgbSource0;					/**< The RGB combiner source 0. */
+	GLenum rgbSource1;					/**< The RGB combiner source 1. */
+	GLenum rgbSource2;					/**< The RGB combiner source 2. */
+	GLenum rgbOperand0;					/**< The RGB combiner operand 0. */
+	GLenum rgbOperand1;					/**< The RGB combiner operand 1. */
+	GLenum rgbOperand2;					/**< The RGB combiner operand 2. */
+	GLenum combineAlphaFunction;		/**< The alpha combiner function, used if isCombining is set. */
+	GLenum alphaSource0;				/**< The alpha combiner source 0. */
+	GLenum alphaSource1;				/**< The alpha combiner source 1. */
+	GLenum alphaSource2;				/**< The alpha combiner source 2. */
+	GLenum alphaOperand0;				/**< The alpha combiner operand 0. */
+	GLenum alphaOperand1;				/**< The alpha combiner operand 1. */
+	GLenum alphaOperand2;				/**< The alpha combiner operand 2. */
+	BOOL shouldBindParameters : 1;		/**< Whether the texture parameters must be applied to the texture. */
+	BOOL isCombining : 1;				/**< Whether the combiner functions, sources and operands are applied. */
+} CC3DrawTextureBinding;
+
+/** A range of vertices drawn with a single GL draw call, as captured into the content of a CC3DrawCommand. */
+typedef struct {
+	GLuint start;					/**< The first vertex, or the byte offset of the first index from the pointer of the index binding. */
+	GLuint count;					/**< The number of vertices or indices to draw. */
+	GLuint faceCount;				/**< The number of faces drawn. */
+	GLuint paletteMatrixCount;		/**< The number of palette matrices loaded before drawing, when the command uses the matrix palette. */
+	GLuint paletteMatricesOffset;	/**< The offset of the CC3Matrix4x4 palette matrices within the content of the command. */
+} CC3DrawRange;
+
+/**
+ * The header of the value of a shader uniform, as captured into the content of a CC3DrawCommand.
+ * The bytes of the value immediately follow this header.
+ */
+typedef struct {
+	GLuint uniformIndex;			/**< The index of the uniform within the uniforms of the shader program. */
+	GLuint valueLength;				/**< The length of the value, in bytes. */
+} CC3DrawUniformValue;
+
+/** Returns the length of a captured uniform value of the specified length, including its header and padding. */
+static inline GLuint CC3DrawUniformValueSize(GLuint valueLength) {
+	return (GLuint)((sizeof(CC3DrawUniformValue) + valueLength + 7) & ~7);
+}
+
+/**
+ * A compact record of a single node to be drawn, as recorded by a CC3NodeDrawingVisitor into
+ * a CC3DrawCommandList.
+ *
+ * Each command is populated by the populateDrawCommand:withVisitor: method of its node, and
+ * holds everything needed to draw that node without messaging the node, its mesh or its
+ * material: the global transform of the node, the fixed-function drawing state and material
+ * colors, the shader program and the values of the uniforms that depend on the node, and the
+ * texture bindings, vertex bindings and draw ranges. Populating a command does not make any
+ * GL calls.
+ *
+ * Variable-length content is held in the content memory of the command list, and is located
+ * by offsets relative to the contentOffset of the command. Use the contentAt:ofCommand: method
+ * of the command list to access it.
+ *
+ * The node, mesh, material, program and shader context are retained by the command list,
+ * as are the vertex arrays referenced by the vertex bindings.
+ */
+struct CC3DrawCommand {
+	CC3Node* node;					/**< The node to be drawn. */
+	CC3Mesh* mesh;					/**< The mesh of the node, or nil if the node is not a mesh node. */
+	CC3Material* material;			/**< The material of the node, or nil if the node has no material. */
+	CC3GLProgram* shaderProgram;	/**< The shader program used to draw the node, or nil if none. */
+	CC3GLProgramContext* shaderContext;	/**< The context whose uniform overrides are applied when replayed, or nil. */
+	GLuint nodeVersion;				/**< The drawingVersion of the node when this command was populated. */
+	GLuint meshVersion;				/**< The drawingVersion of the mesh when this command was populated. */
+	GLuint materialVersion;			/**< The drawingVersion of the material when this command was populated. */
+	GLuint meshTag;					/**< The tag of the mesh, used to avoid rebinding the same mesh. */
+	GLuint materialTag;				/**< The tag of the material, used to avoid reapplying the same material. */
+	CC3Matrix4x4 modelMatrix;		/**< The global transform of the node, including any transform that unpacks quantized vertex locations. */
+	CC3Sphere lightingSphere;		/**< The global sphere used to select the lights that illuminate the node. */
+	CC3DrawState state;				/**< The fixed-function GL state used to draw the node. */
+	CC3DrawVertexBinding indexBinding;	/**< The binding of the vertex indices, if isIndexed is set. */
+	GLenum drawingMode;				/**< The GL primitive drawing mode of the mesh. */
+	GLenum indexType;				/**< The type of the vertex indices, if isIndexed is set. */
+	GLuint vertexCount;				/**< The number of vertices in the mesh. */
+	GLuint vertexIndexCount;		/**< The number of vertex indices in the mesh. */
+	GLuint faceCount;				/**< The number of faces drawn by this command. */
+	GLuint vertexBufferID;			/**< The GL buffer holding the vertex locations, or zero if not buffered. */
+	GLuint indexBufferID;			/**< The GL buffer holding the vertex indices, or zero if not buffered. */
+	GLuint contentOffset;			/**< The location of the variable-length content within the content memory of the command list. */
+	GLuint contentLength;			/**< The length of the variable-length content. */
+	GLuint vertexBindingsOffset;	/**< The offset of the CC3DrawVertexBindings within the content. */
+	GLuint vertexBindingCount;		/**< The number of CC3DrawVertexBindings. */
+	GLuint textureBindingsOffset;	/**< The offset of the CC3DrawTextureBindings within the content. */
+	GLuint textureBindingCount;		/**< The number of CC3DrawTextureBindings, which is the number of texture units used. */
+	GLuint drawRangesOffset;		/**< The offset of the CC3DrawRanges within the content. */
+	GLuint drawRangeCount;			/**< The number of CC3DrawRanges. */
+	GLuint uniformValuesOffset;		/**< The offset of the first CC3DrawUniformValue within the content. */
+	GLuint uniformValueCount;		/**< The number of CC3DrawUniformValues. */
+	BOOL shouldDrawLive : 1;		/**< Whether the node must be drawn by the node itself, because its drawing could not be captured. */
+	BOOL isVolatile : 1;			/**< Whether this command must be populated again on each frame. */
+	BOOL isIndexed : 1;				/**< Whether the vertices are drawn through the vertex indices. */
+	BOOL shouldUsePalette : 1;		/**< Whether the matrix palette is used, in place of the modelMatrix. */
+};
+
+/** Returns a string description of the specified draw command. */
+NSString* NSStringFromCC3DrawCommand(CC3DrawCommand* aCommand);
+
+/**
+ * Applies the face culling, normal scaling, shading, vertex coloring, depth testing,
+ * decal offset and line drawing content of the specified drawing state to the GL engine.
+ */
+void CC3DrawStateApplyDrawingParameters(CC3DrawState* state);
+
+/**
+ * Applies the alpha testing, blending, lighting and color content of the specified drawing
+ * state to the GL engine. If lighting is used, the material colors are applied. Otherwise,
+ * the diffuse color is applied as a flat color.
+ */
+void CC3DrawStateApplyMaterial(CC3DrawState* state);
+
+/** Binds the specified texture, and its texture environment, to the GL texture unit with the specified index. */
+void CC3DrawTextureBindingApply(CC3DrawTextureBinding* texBinding, GLuint texUnit);
+
+/** Applies the texture environment mode, constant color and any combiner content of the specified binding to the specified texture unit. */
+void CC3DrawTextureBindingApplyEnvironment(CC3DrawTextureBinding* texBinding, CC3OpenGLESTextureUnit* glesTexUnit);
+
+/**
+ * Binds the GL buffer of the specified vertex binding and, unless the binding holds vertex
+ * indices, binds the vertex pointer for the semantic of the binding.
+ *
+ * If the vertexArray field of the binding is not nil, that vertex array must have already
+ * resolved the bufferID and pointer fields of the binding, for the current frame.
+ */
+void CC3DrawVertexBindingApply(CC3DrawVertexBinding* vtxBinding);
+
+
+#pragma mark -
+#pragma mark CC3DrawCommandExecutor
+
+/** 
+ * CC3DrawCommandExecutor defines the behaviour of an object that can replay the
+ * draw commands that were recorded into a CC3DrawCommandList.
+ */
+@protocol CC3DrawCommandExecutor <NSObject>
+
+/**
+ * Indicates whether this executor operates without a GL engine.
+ *
+ * When a CC3NodeDrawingVisitor is using a headless executor, the visitor does not make
+ * any GL calls, including clearing the depth buffer, when opening a visitation run.
+ */
+@property(nonatomic, readonly) BOOL isHeadless;
+
+/** Replays the commands in the specified command list, using the specified visitor. */
+-(void) executeCommandList: (CC3DrawCommandList*) cmdList withVisitor: (CC3NodeDrawingVisitor*) visitor;
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3DrawCommandList
+
+/**
+ * CC3DrawCommandList holds the sequence of CC3DrawCommands recorded by a CC3NodeDrawingVisitor
+ * during the traversal of a node assembly, in the order in which the nodes are to be drawn.
+ *
+ * The commands, and the variable-length content of each command, such as its vertex and
+ * texture bindings, draw ranges and uniform values, are held in two contiguous blocks of
+ * memory. The blocks are double-buffered, so that, while a frame is being recorded, the
+ * commands recorded on the previous frame remain available. When a command is added for a
+ * node whose command on the previous frame is still current, the previous command and its
+ * content are copied into the new frame, instead of populating the command from the node
+ * again. Once the list has grown to accommodate the scene, no further allocation occurs
+ * while recording.
+ *
+ * Once recorded, the command list can be replayed any number of times via the
+ * executeWithVisitor: method.
+ */
+@interface CC3DrawCommandList : NSObject {
+	CC3DrawCommand* commands;
+	GLubyte* content;
+	CC3DrawCommand* previousCommands;
+	GLubyte* previousContent;
+	GLuint commandCount;
+	GLuint commandCapacity;
+	GLuint contentLength;
+	GLuint contentCapacity;
+	GLuint previousCommandCount;
+	GLuint previousCommandCapacity;
+	GLuint previousContentCapacity;
+	GLuint previousCommandIndex;
+	GLuint populatedCommandCount;
+	id<CC3DrawCommandExecutor> executor;
+	BOOL isRecorded : 1;
+}
+
+/** The number of commands currently held in this command list. */
+@property(nonatomic, readonly) GLuint commandCount;
+
+/** Returns a pointer to the command at the specified index, which must be less than commandCount. */
+-(CC3DrawCommand*) commandAt: (GLuint) index;
+
+/**
+ * The number of commands that were populated from their nodes during the most recent recording.
+ * The remaining commands were reused from the previous recording.
+ */
+@property(nonatomic, readonly) GLuint populatedCommandCount;
+
+/**
+ * Indicates whether this command list contains a complete recording of a visitation
+ * run, and can be replayed without traversing the node assembly again.
+ *
+ * This property is set to YES by the visitor once a traversal has been completely
+ * recorded, and is set back to NO by the invalidate method.
+ */
+@property(nonatomic, assign) BOOL isRecorded;
+
+/**
+ * The executor that is used to replay the commands to the GL engine.
+ *
+ * The initial value of this property is an instance of CC3GLDrawCommandExecutor.
+ * For testing and benchmarking without a GL engine, this property can be set to
+ * an instance of CC3RecordingDrawCommandExecutor.
+ */
+@property(nonatomic, retain) id<CC3DrawCommandExecutor> executor;
+
+
+#pragma mark Recording
+
+/**
+ * Starts a new recording. The commands already in this list become the commands of the
+ * previous recording, from which commands can be reused, and this list is emptied.
+ *
+ * This is invoked automatically by the visitor when it is opened.
+ */
+-(void) beginRecording;
+
+/**
+ * Appends a command to draw the specified node to the end of this command list.
+ *
+ * If the command for the node in the previous recording is still current, as determined by
+ * the canReuseDrawCommand: method of the node, that command is reused. Otherwise, the command
+ * is populated by invoking the populateDrawCommand:forNode: method of the specified visitor.
+ *
+ * Commands from the previous recording are matched to nodes in the order in which they were
+ * recorded, so that reusing the commands of a scene whose drawing order has not changed much
+ * does not require searching.
+ */
+-(void) addCommandForNode: (CC3Node*) aNode withVisitor: (CC3NodeDrawingVisitor*) visitor;
+
+/**
+ * Appends a command for each node that was drawn in the previous recording, in the same order,
+ * by invoking the addCommandForNode:withVisitor: method for each node.
+ *
+ * This is invoked automatically by the visitor when a recorded command list is drawn again,
+ * without traversing the node assembly.
+ */
+-(void) addPreviousCommandsWithVisitor: (CC3NodeDrawingVisitor*) visitor;
+
+/**
+ * Completes the current recording, releasing any commands from the previous recording
+ * that were not reused.
+ *
+ * This is invoked automatically by the visitor when it is closed.
+ */
+-(void) endRecording;
+
+/**
+ * Allocates the specified number of bytes of variable-length content for the specified command,
+ * which must be the command that is currently being populated, and returns the offset of that
+ * content, relative to the contentOffset of the command. The allocated content is zeroed, and
+ * is aligned to eight bytes.
+ *
+ * Allocating content can move the content of all commands, so pointers returned by the
+ * contentAt:ofCommand: method are only valid until the next allocation.
+ */
+-(GLuint) allocateContent: (GLuint) length forCommand: (CC3DrawCommand*) aCommand;
+
+/** Returns a pointer to the content at the specified offset, relative to the contentOffset of the specified command. */
+-(GLvoid*) contentAt: (GLuint) offset ofCommand: (CC3DrawCommand*) aCommand;
+
+/**
+ * Removes all commands from this list, including the commands of the previous recording,
+ * and sets the isRecorded property to NO. The memory that holds the commands is retained for
+ * reuse on the next recording.
+ */
+-(void) reset;
+
+/**
+ * Marks this command list as requiring a fresh traversal, by setting the isRecorded
+ * property to NO. The commands remain available for reuse during the next recording.
+ */
+-(void) invalidate;
+
+/** Replays the commands in this list, by passing this list to the executor, along with the visitor. */
+-(void) executeWithVisitor: (CC3NodeDrawingVisitor*) visitor;
+
+
+#pragma mark Allocation and initialization
+
+/** Allocates and initializes an autoreleased instance, using a CC3GLDrawCommandExecutor. */
++(id) commandList;
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3GLDrawCommandExecutor
+
+/**
+ * CC3GLDrawCommandExecutor replays the commands in a CC3DrawCommandList to the GL engine,
+ * by asking the visitor to draw each command in turn, using the content captured in the command.
+ */
+@interface CC3GLDrawCommandExecutor : NSObject <CC3DrawCommandExecutor>
+
+/** Allocates and initializes an autoreleased instance. */
++(id) executor;
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3RecordingDrawCommandExecutor
+
+/**
+ * CC3RecordingDrawCommandExecutor is a headless executor that does not draw anything.
+ * Instead, each time a command list is executed, it records a description of each
+ * command, so that the command lists generated on different frames, or by different
+ * versions of an application, can be compared in tests and benchmarks without a GL engine.
+ */
+@interface CC3RecordingDrawCommandExecutor : NSObject <CC3DrawCommandExecutor> {
+	NSMutableArray* recordedFrames;
+}
+
+/**
+ * The command lists that have been executed, in the order in which they were executed.
+ *
+ * Each element is an NSArray containing the NSString description of each command,
+ * as returned by the NSStringFromCC3DrawCommand function.
+ */
+@property(nonatomic, readonly) NSArray* recordedFrames;
+
+/** Returns the most recent element of the recordedFrames array, or nil if nothing has been executed. */
+@property(nonatomic, readonly) NSArray* lastRecordedFrame;
+
+/** Removes all recorded frames. */
+-(void) clear;
+
+/** Allocates and initializes an autoreleased instance. */
++(id) executor;
+
+@end
+
+
 #pragma mark -
 #pragma mark CC3NodePickingVisitor
 
@@ -32,11 +32,14 @@
 #import "CC3NodeVisitor.h"
 #import "CC3Scene.h"
 #import "CC3Layer.h"
+#import "CC3MeshNode.h"
 #import "CC3VertexArrayMesh.h"
 #import "CC3OpenGLESEngine.h"
 #import "CC3GLView.h"
 #import "CC3EAGLView.h"
 #import "CC3NodeSequencer.h"
+#import "CC3LightAssigner.h"
+#import "CC3GLProgram.h"
 
 @interface CC3Node (TemplateMethods)
 -(void) processUpdateBeforeTransform: (CC3NodeUpdatingVisitor*) visitor;
@@ -379,16 +382,24 @@
 @interface CC3NodeDrawingVisitor (TemplateMethods)
 -(BOOL) shouldDrawNode: (CC3Node*) aNode;
 -(BOOL) isNodeVisibleForDrawing: (CC3Node*) aNode;
+-(void) transformAndDraw: (CC3Node*) aNode;
+-(void) drawContentOfCommand: (CC3DrawCommand*) aCommand;
+-(void) bindMaterialOfCommand: (CC3DrawCommand*) aCommand;
+-(void) bindMeshOfCommand: (CC3DrawCommand*) aCommand;
+-(void) drawRangesOfCommand: (CC3DrawCommand*) aCommand;
 @end
 
 @implementation CC3NodeDrawingVisitor
 
-@synthesize drawingSequencer;
-@synthesize shouldDecorateNode, shouldClearDepthBuffer;
+@synthesize drawingSequencer, commandList, lightAssigner, shadowMap;
+@synthesize shouldDecorateNode, shouldClearDepthBuffer, shouldTimeDrawingPhases;
 @synthesize textureUnit, textureUnitCount;
 
 -(void) dealloc {
 	drawingSequencer = nil;		// not retained
+	lightAssigner = nil;		// not retained
+	shadowMap = nil;			// not retained
+	[commandList release];
 	[super dealloc];
 }
 
@@ -396,6 +407,9 @@
 	if ( (self = [super init]) ) {
 		shouldDecorateNode = YES;
 		shouldClearDepthBuffer = YES;
+		shouldTimeDrawingPhases = NO;
+		cullingTime = 0.0;
+		submissionTime = 0.0;
 	}
 	return self;
 }
@@ -406,10 +420,30 @@
 			NSStringFromBoolean(shouldDecorateNode), NSStringFromBoolean(shouldClearDepthBuffer)];
 }
 
+/**
+ * If a command list is being recorded, the node is recorded into it, to be drawn when
+ * the visitor is closed. Otherwise, the node is drawn immediately, and, if drawing phases
+ * are being timed, and the scene is collecting performance statistics, the time taken to
+ * test and to draw the node is accumulated.
+ */
 -(void) processBeforeChildren: (CC3Node*) aNode {
-	[self.performanceStatistics incrementNodesVisitedForDrawing];
-	if ([self shouldDrawNode: aNode]) {
-		[aNode transformAndDrawWithVisitor: self];
+	CC3PerformanceStatistics* stats = self.performanceStatistics;
+	[stats incrementNodesVisitedForDrawing];
+	if (commandList) {
+		if ( !commandList.isRecorded && [self shouldDrawNode: aNode] ) {
+			[commandList addCommandForNode: aNode withVisitor: self];
+		}
+	} else if (shouldTimeDrawingPhases && stats) {
+		double startTime = CC3PerformanceTimeNow();
+		BOOL shouldDraw = [self shouldDrawNode: aNode];
+		double drawStartTime = CC3PerformanceTimeNow();
+		cullingTime += drawStartTime - startTime;
+		if (shouldDraw) {
+			[self transformAndDraw: aNode];
+			submissionTime += CC3PerformanceTimeNow() - drawStartTime;
+		}
+	} else if ([self shouldDrawNode: aNode]) {
+		[self transformAndDraw: aNode];
 	}
 }
 
@@ -421,7 +455,13 @@
 
 -(BOOL) isNodeVisibleForDrawing: (CC3Node*) aNode { return aNode.visible; }
 
+/**
+ * If the command list has already been recorded, it will simply be replayed
+ * when the visitor is closed, so there is no need to traverse the children.
+ */
 -(void) processChildrenOf: (CC3Node*) aNode {
+	if (commandList.isRecorded) return;
+
 	if (drawingSequencer) {
 		CC3Node* currNode = currentNode;	// Remember current node
 
@@ -438,6 +478,10 @@
  * Initializes mesh and material context switching, and optionally clears the depth
  * buffer every time drawing begins so that 3D rendering will occur over top of any
  * previously rendered 3D or 2D artifacts.
+ *
+ * If a command list is in use, a new recording is started. If the command list has
+ * already been recorded, the traversal will be skipped, so the nodes drawn on the
+ * previous frame are added to the new recording immediately.
  */
 -(void) open {
 	[super open];
@@ -445,16 +489,220 @@
 	[CC3Material resetSwitching];
 	[CC3VertexArrayMesh resetSwitching];
 	
-	if (shouldClearDepthBuffer) {
+	cullingTime = 0.0;
+	submissionTime = 0.0;
+	if (commandList) {
+		if (shouldTimeDrawingPhases) [self.performanceStatistics beginPhase: kCC3PerformancePhaseCulling];
+		[commandList beginRecording];
+		if (commandList.isRecorded) [commandList addPreviousCommandsWithVisitor: self];
+	}
+
+	if (shouldClearDepthBuffer && !commandList.executor.isHeadless) {
 		[[CC3OpenGLESEngine engine].state clearDepthBuffer];
 	}
 }
 
+/**
+ * If a command list is in use, it now contains the full traversal,
+ * so mark it as recorded, and replay it to the executor. Otherwise,
+ * record the culling and drawing times accumulated during the traversal.
+ */
+-(void) close {
+	CC3PerformanceStatistics* stats = shouldTimeDrawingPhases ? self.performanceStatistics : nil;
+	if (commandList) {
+		[commandList endRecording];
+		[stats endPhase: kCC3PerformancePhaseCulling];
+
+		commandList.isRecorded = YES;
+
+		[stats beginPhase: kCC3PerformancePhaseSubmission];
+		[commandList executeWithVisitor: self];
+		[stats endPhase: kCC3PerformancePhaseSubmission];
+	} else {
+		[stats addTime: cullingTime toPhase: kCC3PerformancePhaseCulling];
+		[stats addTime: submissionTime toPhase: kCC3PerformancePhaseSubmission];
+	}
+	[super close];
+}
+
+/**
+ * Lights are bound before the node is transformed, while the modelview matrix holds only
+ * the camera view, so that the light locations are interpreted in the global coordinates.
+ */
+-(void) transformAndDraw: (CC3Node*) aNode {
+	if (lightAssigner && aNode.shouldUseLighting) [lightAssigner bindLightsForNode: aNode];
+	[aNode transformAndDrawWithVisitor: self];
+}
+
 -(void) draw: (CC3Node*) aNode {
 	[aNode drawWithVisitor: self];
 	[self.performanceStatistics incrementNodesDrawn];
 }
 
+-(void) bindUndecoratedProgram {
+	[CC3OpenGLESEngine.engine.shaders bindPureColorProgramWithVisitor: self];
+}
+
+
+#pragma mark Draw commands
+
+/**
+ * The texture unit count is used by the mesh while the command is being populated,
+ * and is restored afterwards, so that it reflects the drawing that is in progress.
+ */
+-(void) populateDrawCommand: (CC3DrawCommand*) aCommand forNode: (CC3Node*) aNode {
+	CC3Node* currNode = currentNode;			// Remember current node
+	GLuint currTexUnitCount = textureUnitCount;	// Remember current texture unit count
+
+	currentNode = aNode;
+	[aNode populateDrawCommand: aCommand withVisitor: self];
+	if (lightAssigner && !aCommand->shouldDrawLive && aCommand->state.shouldUseLighting) {
+		aCommand->lightingSphere = [lightAssigner lightingSphereForNode: aNode];
+	}
+
+	textureUnitCount = currTexUnitCount;		// Restore current texture unit count
+	currentNode = currNode;						// Restore current node
+}
+
+/**
+ * The node of the command is made the currentNode while the command is drawn, for the
+ * benefit of shader semantic delegates that are consulted for uniforms that were not
+ * captured in the command, but the node itself is only messaged if it must be drawn live.
+ */
+-(void) drawCommand: (CC3DrawCommand*) aCommand {
+	CC3Node* currNode = currentNode;	// Remember current node
+
+	currentNode = aCommand->node;
+	if (aCommand->shouldDrawLive) {
+		[self transformAndDraw: currentNode];
+	} else {
+		[self drawContentOfCommand: aCommand];
+	}
+
+	currentNode = currNode;				// Restore current node
+}
+
+/**
+ * Lights are bound before the transform is applied, for the same reason as in the
+ * transformAndDraw: method. A skinned command loads its transforms into the matrix
+ * palette instead, so the modelview matrix is left holding only the camera view.
+ */
+-(void) drawContentOfCommand: (CC3DrawCommand*) aCommand {
+	CC3OpenGLESMatrixStack* glesMatrixStack = [CC3OpenGLESEngine engine].matrices.modelview;
+
+	if (lightAssigner && aCommand->state.shouldUseLighting) {
+		[lightAssigner bindLightsForSphere: aCommand->lightingSphere];
+	}
+
+	if ( !aCommand->shouldUsePalette ) {
+		[glesMatrixStack push];
+		[glesMatrixStack multiply: &aCommand->modelMatrix];
+	}
+
+	CC3DrawStateApplyDrawingParameters(&aCommand->state);		// Before material is applied.
+	[self bindMaterialOfCommand: aCommand];
+	[aCommand->shaderProgram bindDrawCommand: aCommand withVisitor: self];
+	[self bindMeshOfCommand: aCommand];
+	[self drawRangesOfCommand: aCommand];
+
+	if ( !aCommand->shouldUsePalette ) [glesMatrixStack pop];
+
+	[self.performanceStatistics incrementNodesDrawn];
+}
+
+/**
+ * Applies the material state and texture bindings of the specified command, unless the
+ * material of the command is already bound. If the command has no material, the material
+ * state is unbound, and the pure color captured in the command is applied.
+ */
+-(void) bindMaterialOfCommand: (CC3DrawCommand*) aCommand {
+	if ( !aCommand->material ) {
+		[CC3Material unbind];
+		CC3DrawStateApplyMaterial(&aCommand->state);
+		textureUnitCount = 0;
+		return;
+	}
+
+	if ( ![CC3Material switchingToMaterialTag: aCommand->materialTag] ) return;
+
+	CC3DrawStateApplyMaterial(&aCommand->state);
+
+	GLuint texCount = aCommand->textureBindingCount;
+	CC3DrawTextureBinding* texBindings = [commandList contentAt: aCommand->textureBindingsOffset
+													  ofCommand: aCommand];
+	for (GLuint tu = 0; tu < texCount; tu++) CC3DrawTextureBindingApply(&texBindings[tu], tu);
+	[CC3Texture unbindRemainingFrom: texCount];
+	textureUnitCount = texCount;
+}
+
+/**
+ * Binds the vertex arrays of the specified command, unless the mesh of the command is
+ * already bound. Vertex arrays whose content must be copied to the GL engine first resolve
+ * their bindings. The index binding is resolved even if the mesh is already bound, since
+ * the draw ranges are located relative to it.
+ */
+-(void) bindMeshOfCommand: (CC3DrawCommand*) aCommand {
+	CC3DrawVertexBinding* idxBinding = &aCommand->indexBinding;
+	BOOL hasIndices = aCommand->isIndexed;
+	if (hasIndices && idxBinding->vertexArray) [idxBinding->vertexArray resolveDrawVertexBinding: idxBinding];
+
+	if ( ![CC3Mesh switchingToMeshTag: aCommand->meshTag] ) return;
+
+	CC3OpenGLESVertexArrays* glesVertices = [CC3OpenGLESEngine engine].vertices;
+	[glesVertices clearUnboundVertexPointers];
+
+	GLuint vtxCount = aCommand->vertexBindingCount;
+	CC3DrawVertexBinding* vtxBindings = [commandList contentAt: aCommand->vertexBindingsOffset
+													 ofCommand: aCommand];
+	for (GLuint i = 0; i < vtxCount; i++) {
+		CC3DrawVertexBinding* vtxBinding = &vtxBindings[i];
+		if ( !vtxBinding->vertexArray || [vtxBinding->vertexArray resolveDrawVertexBinding: vtxBinding] ) {
+			CC3DrawVertexBindingApply(vtxBinding);
+		}
+	}
+	if (hasIndices) CC3DrawVertexBindingApply(idxBinding);
+
+	[glesVertices disableUnboundVertexPointers];
+}
+
+/**
+ * Issues a GL draw call for each draw range of the specified command. If the command uses
+ * the matrix palette, the palette matrices of each range are loaded before it is drawn.
+ */
+-(void) drawRangesOfCommand: (CC3DrawCommand*) aCommand {
+	CC3OpenGLESEngine* glesEngine = [CC3OpenGLESEngine engine];
+	CC3OpenGLESVertexArrays* glesVertices = glesEngine.vertices;
+	CC3PerformanceStatistics* stats = self.performanceStatistics;
+	BOOL usesPalette = aCommand->shouldUsePalette;
+	GLenum drawMode = aCommand->drawingMode;
+
+	if (usesPalette) [glesEngine.capabilities.matrixPalette enable];
+
+	GLuint rngCount = aCommand->drawRangeCount;
+	CC3DrawRange* ranges = [commandList contentAt: aCommand->drawRangesOffset ofCommand: aCommand];
+	for (GLuint i = 0; i < rngCount; i++) {
+		CC3DrawRange* range = &ranges[i];
+		if (usesPalette) {
+			CC3Matrix4x4* palMtxs = [commandList contentAt: range->paletteMatricesOffset ofCommand: aCommand];
+			for (GLuint pmIdx = 0; pmIdx < range->paletteMatrixCount; pmIdx++) {
+				CC3OpenGLESMatrixStack* glesPaletteMatrix = [glesEngine.matrices paletteAt: pmIdx];
+				[glesPaletteMatrix loadFromModelView];
+				[glesPaletteMatrix multiply: &palMtxs[pmIdx]];
+			}
+		}
+		if (aCommand->isIndexed) {
+			GLvoid* firstIndex = (GLbyte*)aCommand->indexBinding.pointer + range->start;
+			[glesVertices drawIndicies: firstIndex ofLength: range->count
+							   andType: aCommand->indexType as: drawMode];
+		} else {
+			[glesVertices drawVerticiesAs: drawMode startingAt: range->start withLength: range->count];
+		}
+		[stats addSingleCallFacesPresented: range->faceCount];
+	}
+
+	if (usesPalette) [glesEngine.capabilities.matrixPalette disable];
+}
+
 
 #pragma mark Accessing node contents
 
@@ -475,6 +723,457 @@
 @end
 
 
+#pragma mark -
+#pragma mark CC3DrawCommand
+
+NSString* NSStringFromCC3DrawCommand(CC3DrawCommand* aCommand) {
+	CC3DrawState* state = &aCommand->state;
+	if (aCommand->shouldDrawLive) return [NSString stringWithFormat: @"%@ drawn live", aCommand->node];
+	return [NSString stringWithFormat: @"%@ mesh: %@ material: %@ program: %@ buffers: %u/%u mode: %@ vertices: %u indices: %u bindings: %u/%u ranges: %u uniforms: %u cull: %@ depth: %@%@ blend: %@ lighting: %@",
+			aCommand->node, aCommand->mesh, aCommand->material, aCommand->shaderProgram,
+			aCommand->vertexBufferID, aCommand->indexBufferID,
+			NSStringFromGLEnum(aCommand->drawingMode),
+			aCommand->vertexCount, aCommand->vertexIndexCount,
+			aCommand->vertexBindingCount, aCommand->textureBindingCount,
+			aCommand->drawRangeCount, aCommand->uniformValueCount,
+			NSStringFromGLEnum(state->cullFace),
+			(state->shouldTestDepth ? NSStringFromGLEnum(state->depthFunction) : @"off"),
+			(state->shouldWriteDepth ? @"" : @" (no write)"),
+			(state->shouldBlend ? [NSString stringWithFormat: @"%@/%@",
+								   NSStringFromGLEnum(state->sourceBlend),
+								   NSStringFromGLEnum(state->destinationBlend)] : @"off"),
+			NSStringFromBoolean(state->shouldUseLighting)];
+}
+
+void CC3DrawStateApplyDrawingParameters(CC3DrawState* state) {
+	CC3OpenGLESEngine* glesEngine = [CC3OpenGLESEngine engine];
+	CC3OpenGLESCapabilities* glesServCaps = glesEngine.capabilities;
+	CC3OpenGLESState* glesState = glesEngine.state;
+
+	// Enable culling if either back or front should be culled.
+	// If neither should be culled, handled by capability so leave it as back culling.
+	BOOL shouldCull = (state->cullFace != GL_NONE);
+	glesServCaps.cullFace.value = shouldCull;
+	glesState.cullFace.value = shouldCull ? state->cullFace : GL_BACK;
+	glesState.frontFace.value = state->frontFace;
+
+	glesServCaps.rescaleNormal.value = (state->normalScalingMethod == kCC3NormalScalingRescale);
+	glesServCaps.normalize.value = (state->normalScalingMethod == kCC3NormalScalingNormalize);
+
+	// Both the material and mesh influence vertex coloring, and the mesh will not be
+	// rebound if it is not switched, so this must be applied every time, and must be
+	// applied before material colors are set, otherwise material colors will not stick.
+	glesState.shadeModel.value = state->shadeModel;
+	glesServCaps.colorMaterial.value = state->shouldColorMaterial;
+
+	glesServCaps.depthTest.value = state->shouldTestDepth;
+	glesState.depthMask.value = state->shouldWriteDepth;
+	glesState.depthFunction.value = state->depthFunction;
+
+	BOOL hasDecalOffset = state->decalOffsetFactor || state->decalOffsetUnits;
+	glesServCaps.polygonOffsetFill.value = hasDecalOffset;
+	[glesState.polygonOffset applyFactor: state->decalOffsetFactor andUnits: state->decalOffsetUnits];
+
+	glesState.lineWidth.value = state->lineWidth;
+	glesServCaps.lineSmooth.value = state->shouldSmoothLines;
+	glesEngine.hints.lineSmooth.value = state->lineSmoothingHint;
+}
+
+void CC3DrawStateApplyMaterial(CC3DrawState* state) {
+	CC3OpenGLESEngine* glesEngine = [CC3OpenGLESEngine engine];
+	CC3OpenGLESCapabilities* glesServCaps = glesEngine.capabilities;
+	CC3OpenGLESMaterials* glesMaterials = glesEngine.materials;
+
+	BOOL shouldAlphaTest = (state->alphaTestFunction != GL_ALWAYS);
+	glesServCaps.alphaTest.value = shouldAlphaTest;
+	if (shouldAlphaTest) [glesMaterials.alphaFunc applyFunction: state->alphaTestFunction
+												   andReference: state->alphaTestReference];
+
+	glesServCaps.blend.value = state->shouldBlend;
+	if (state->shouldBlend) [glesMaterials.blendFunc applySource: state->sourceBlend
+												  andDestination: state->destinationBlend];
+
+	if (state->shouldUseLighting) {
+		[glesServCaps.lighting enable];
+		glesMaterials.ambientColor.value = state->ambientColor;
+		glesMaterials.diffuseColor.value = state->diffuseColor;
+		glesMaterials.specularColor.value = state->specularColor;
+		glesMaterials.emissionColor.value = state->emissionColor;
+		glesMaterials.shininess.value = state->shininess;
+	} else {
+		[glesServCaps.lighting disable];
+		glesEngine.state.color.value = state->diffuseColor;
+	}
+}
+
+void CC3DrawTextureBindingApply(CC3DrawTextureBinding* texBinding, GLuint texUnit) {
+	CC3OpenGLESTextureUnit* glesTexUnit = [[CC3OpenGLESEngine engine].textures textureUnitAt: texUnit];
+	[glesTexUnit.texture2D enable];
+	glesTexUnit.textureBinding.value = texBinding->textureName;
+	if (texBinding->shouldBindParameters) {
+		glesTexUnit.minifyingFunction.value = texBinding->minifyingFunction;
+		glesTexUnit.magnifyingFunction.value = texBinding->magnifyingFunction;
+		glesTexUnit.horizontalWrappingFunction.value = texBinding->horizontalWrappingFunction;
+		glesTexUnit.verticalWrappingFunction.value = texBinding->verticalWrappingFunction;
+	}
+	CC3DrawTextureBindingApplyEnvironment(texBinding, glesTexUnit);
+}
+
+void CC3DrawTextureBindingApplyEnvironment(CC3DrawTextureBinding* texBinding, CC3OpenGLESTextureUnit* glesTexUnit) {
+	glesTexUnit.textureEnvironmentMode.value = texBinding->environmentMode;
+	if (texBinding->isCombining) {
+		glesTexUnit.combineRGBFunction.value = texBinding->combineRGBFunction;
+		glesTexUnit.rgbSource0.value = texBinding->rgbSource0;
+		glesTexUnit.rgbSource1.value = texBinding->rgbSource1;
+		glesTexUnit.rgbSource2.value = texBinding->rgbSource2;
+		glesTexUnit.rgbOperand0.value = texBinding->rgbOperand0;
+		glesTexUnit.rgbOperand1.value = texBinding->rgbOperand1;
+		glesTexUnit.rgbOperand2.value = texBinding->rgbOperand2;
+		glesTexUnit.combineAlphaFunction.value = texBinding->combineAlphaFunction;
+		glesTexUnit.alphaSource0.value = texBinding->alphaSource0;
+		glesTexUnit.alphaSource1.value = texBinding->alphaSource1;
+		glesTexUnit.alphaSource2.value = texBinding->alphaSource2;
+		glesTexUnit.alphaOperand0.value = texBinding->alphaOperand0;
+		glesTexUnit.alphaOperand1.value = texBinding->alphaOperand1;
+		glesTexUnit.alphaOperand2.value = texBinding->alphaOperand2;
+	}
+	glesTexUnit.color.value = texBinding->constantColor;
+}
+
+/**
+ * Binding vertex colors changes the material colors in the GL engine, so the
+ * tracked material colors are marked as unknown once vertex colors are bound.
+ */
+void CC3DrawVertexBindingApply(CC3DrawVertexBinding* vtxBinding) {
+	CC3OpenGLESEngine* glesEngine = [CC3OpenGLESEngine engine];
+	CC3OpenGLESVertexArrays* glesVertices = glesEngine.vertices;
+
+	[glesVertices bufferBinding: vtxBinding->bufferTarget].value = vtxBinding->bufferID;
+	if (vtxBinding->bufferTarget == GL_ELEMENT_ARRAY_BUFFER) return;
+
+	[[glesVertices vertexPointerForSemantic: vtxBinding->semantic] bindElementsAt: vtxBinding->pointer
+																		 withSize: vtxBinding->elementSize
+																		 withType: vtxBinding->elementType
+																	   withStride: vtxBinding->vertexStride
+																  withShouldNormalize: vtxBinding->shouldNormalize];
+
+	if (vtxBinding->semantic == kCC3SemanticVertexColors) {
+		CC3OpenGLESMaterials* glesMaterials = glesEngine.materials;
+		glesMaterials.ambientColor.valueIsKnown = NO;
+		glesMaterials.diffuseColor.valueIsKnown = NO;
+	}
+}
+
+
+#pragma mark -
+#pragma mark CC3DrawCommandList
+
+// The number of commands for which space is allocated when the first command is added.
+#define kCC3DrawCommandListInitialCapacity 64
+
+// The number of bytes of command content for which space is allocated when content is first allocated.
+#define kCC3DrawCommandListInitialContentCapacity 4096
+
+// The number of commands of the previous recording, beyond the last one matched,
+// that are searched for the command of a node before the node is populated afresh.
+#define kCC3DrawCommandListReuseLookAhead 8
+
+@interface CC3DrawCommandList (TemplateMethods)
+-(CC3DrawCommand*) appendCommand;
+-(void) ensureContentCapacity: (GLuint) length;
+-(CC3DrawCommand*) previousCommandForNode: (CC3Node*) aNode;
+-(void) retainContentOfCommand: (CC3DrawCommand*) aCommand inContent: (GLubyte*) cmdContent;
+-(void) releaseContentOfCommand: (CC3DrawCommand*) aCommand inContent: (GLubyte*) cmdContent;
+-(void) releasePreviousCommands;
+@end
+
+@implementation CC3DrawCommandList
+
+@synthesize commandCount, populatedCommandCount, isRecorded, executor;
+
+-(void) dealloc {
+	[self reset];
+	free(commands);
+	free(content);
+	free(previousCommands);
+	free(previousContent);
+	[executor release];
+	[super dealloc];
+}
+
+-(CC3DrawCommand*) commandAt: (GLuint) index {
+	NSAssert2(index < commandCount, @"Command index %u must be less than command count %u", index, commandCount);
+	return &commands[index];
+}
+
+
+#pragma mark Recording
+
+/** Swaps the command and content memory blocks, so the commands just drawn become the previous commands. */
+-(void) beginRecording {
+	[self releasePreviousCommands];
+
+	CC3DrawCommand* cmds = previousCommands;
+	previousCommands = commands;
+	commands = cmds;
+
+	GLubyte* cont = previousContent;
+	previousContent = content;
+	content = cont;
+
+	GLuint cap = previousCommandCapacity;
+	previousCommandCapacity = commandCapacity;
+	commandCapacity = cap;
+
+	cap = previousContentCapacity;
+	previousContentCapacity = contentCapacity;
+	contentCapacity = cap;
+
+	previousCommandCount = commandCount;
+	previousCommandIndex = 0;
+	commandCount = 0;
+	contentLength = 0;
+	populatedCommandCount = 0;
+}
+
+/**
+ * A reused command is copied, along with its content, from the previous recording, and the
+ * node of the previous command is cleared, to indicate that the objects it retains are now
+ * retained by the new command.
+ */
+-(void) addCommandForNode: (CC3Node*) aNode withVisitor: (CC3NodeDrawingVisitor*) visitor {
+	CC3DrawCommand* cmd = [self appendCommand];
+
+	CC3DrawCommand* prevCmd = [self previousCommandForNode: aNode];
+	if (prevCmd && [aNode canReuseDrawCommand: prevCmd]) {
+		GLuint cmdContentLength = prevCmd->contentLength;
+		[self ensureContentCapacity: contentLength + cmdContentLength];
+		*cmd = *prevCmd;
+		cmd->contentOffset = contentLength;
+		memcpy(content + contentLength, previousContent + prevCmd->contentOffset, cmdContentLength);
+		contentLength += cmdContentLength;
+		prevCmd->node = nil;		// Ownership of retained objects transferred to new command
+		return;
+	}
+
+	memset(cmd, 0, sizeof(CC3DrawCommand));
+	cmd->node = aNode;
+	cmd->nodeVersion = aNode.drawingVersion;
+	cmd->contentOffset = contentLength;
+	cmd->drawingMode = GL_TRIANGLES;
+	[visitor populateDrawCommand: cmd forNode: aNode];
+	[self retainContentOfCommand: cmd inContent: content];
+	populatedCommandCount++;
+	LogTrace(@"%@ populated %@", self, NSStringFromCC3DrawCommand(cmd));
+}
+
+-(void) addPreviousCommandsWithVisitor: (CC3NodeDrawingVisitor*) visitor {
+	for (GLuint i = 0; i < previousCommandCount; i++) {
+		CC3Node* aNode = previousCommands[i].node;
+		if (aNode) [self addCommandForNode: aNode withVisitor: visitor];
+	}
+}
+
+-(void) endRecording { [self releasePreviousCommands]; }
+
+/** Appends an uninitialized command to the end of this list, and returns it. */
+-(CC3DrawCommand*) appendCommand {
+	if (commandCount == commandCapacity) {
+		commandCapacity = MAX(commandCapacity * 2, kCC3DrawCommandListInitialCapacity);
+		commands = realloc(commands, commandCapacity * sizeof(CC3DrawCommand));
+		NSAssert1(commands, @"Could not allocate space for %u draw commands", commandCapacity);
+	}
+	return &commands[commandCount++];
+}
+
+/** Ensures the content memory can hold at least the specified number of bytes. */
+-(void) ensureContentCapacity: (GLuint) length {
+	if (length <= contentCapacity) return;
+	contentCapacity = MAX(MAX(contentCapacity * 2, length), kCC3DrawCommandListInitialContentCapacity);
+	content = realloc(content, contentCapacity);
+	NSAssert1(content, @"Could not allocate %u bytes of draw command content", contentCapacity);
+}
+
+/**
+ * Returns the command for the specified node from the previous recording, or NULL if no
+ * such command lies within a short distance of the last command that was matched.
+ */
+-(CC3DrawCommand*) previousCommandForNode: (CC3Node*) aNode {
+	GLuint endIdx = MIN(previousCommandIndex + kCC3DrawCommandListReuseLookAhead, previousCommandCount);
+	for (GLuint i = previousCommandIndex; i < endIdx; i++) {
+		CC3DrawCommand* prevCmd = &previousCommands[i];
+		if (prevCmd->node == aNode) {
+			previousCommandIndex = i + 1;
+			return prevCmd;
+		}
+	}
+	return NULL;
+}
+
+-(GLuint) allocateContent: (GLuint) length forCommand: (CC3DrawCommand*) aCommand {
+	NSAssert(commandCount && aCommand == &commands[commandCount - 1],
+			 @"Content can only be allocated for the command that is being populated");
+
+	GLuint alignedLength = (length + 7) & ~7;
+	[self ensureContentCapacity: contentLength + alignedLength];
+	memset(content + contentLength, 0, alignedLength);
+
+	GLuint offset = contentLength - aCommand->contentOffset;
+	contentLength += alignedLength;
+	aCommand->contentLength = contentLength - aCommand->contentOffset;
+	return offset;
+}
+
+-(GLvoid*) contentAt: (GLuint) offset ofCommand: (CC3DrawCommand*) aCommand {
+	return content + aCommand->contentOffset + offset;
+}
+
+/** Retains the objects referenced by the specified command, whose content is held in the specified memory. */
+-(void) retainContentOfCommand: (CC3DrawCommand*) aCommand inContent: (GLubyte*) cmdContent {
+	[aCommand->node retain];
+	[aCommand->mesh retain];
+	[aCommand->material retain];
+	[aCommand->shaderProgram retain];
+	[aCommand->shaderContext retain];
+	[aCommand->indexBinding.vertexArray retain];
+	CC3DrawVertexBinding* vtxBindings = (CC3DrawVertexBinding*)(cmdContent + aCommand->contentOffset +
+																aCommand->vertexBindingsOffset);
+	for (GLuint i = 0; i < aCommand->vertexBindingCount; i++) [vtxBindings[i].vertexArray retain];
+}
+
+/** Releases the objects referenced by the specified command, whose content is held in the specified memory. */
+-(void) releaseContentOfCommand: (CC3DrawCommand*) aCommand inContent: (GLubyte*) cmdContent {
+	CC3DrawVertexBinding* vtxBindings = (CC3DrawVertexBinding*)(cmdContent + aCommand->contentOffset +
+																aCommand->vertexBindingsOffset);
+	for (GLuint i = 0; i < aCommand->vertexBindingCount; i++) [vtxBindings[i].vertexArray release];
+	[aCommand->indexBinding.vertexArray release];
+	[aCommand->shaderContext release];
+	[aCommand->shaderProgram release];
+	[aCommand->material release];
+	[aCommand->mesh release];
+	[aCommand->node release];
+	aCommand->node = nil;
+}
+
+/** Releases any commands from the previous recording that were not reused. */
+-(void) releasePreviousCommands {
+	for (GLuint i = 0; i < previousCommandCount; i++) {
+		CC3DrawCommand* prevCmd = &previousCommands[i];
+		if (prevCmd->node) [self releaseContentOfCommand: prevCmd inContent: previousContent];
+	}
+	previousCommandCount = 0;
+	previousCommandIndex = 0;
+}
+
+-(void) reset {
+	[self releasePreviousCommands];
+	for (GLuint i = 0; i < commandCount; i++) {
+		[self releaseContentOfCommand: &commands[i] inContent: content];
+	}
+	commandCount = 0;
+	contentLength = 0;
+	populatedCommandCount = 0;
+	isRecorded = NO;
+}
+
+-(void) invalidate { isRecorded = NO; }
+
+-(void) executeWithVisitor: (CC3NodeDrawingVisitor*) visitor {
+	[executor executeCommandList: self withVisitor: visitor];
+}
+
+
+#pragma mark Allocation and initialization
+
+-(id) init {
+	if ( (self = [super init]) ) {
+		commands = NULL;
+		content = NULL;
+		previousCommands = NULL;
+		previousContent = NULL;
+		commandCount = 0;
+		commandCapacity = 0;
+		contentLength = 0;
+		contentCapacity = 0;
+		previousCommandCount = 0;
+		previousCommandCapacity = 0;
+		previousContentCapacity = 0;
+		previousCommandIndex = 0;
+		populatedCommandCount = 0;
+		isRecorded = NO;
+		self.executor = [CC3GLDrawCommandExecutor executor];
+	}
+	return self;
+}
+
++(id) commandList { return [[[self alloc] init] autorelease]; }
+
+-(NSString*) description {
+	return [NSString stringWithFormat: @"%@ with %u commands (%u populated)%@", [self class],
+			commandCount, populatedCommandCount, (isRecorded ? @" (recorded)" : @"")];
+}
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3GLDrawCommandExecutor
+
+@implementation CC3GLDrawCommandExecutor
+
+-(BOOL) isHeadless { return NO; }
+
+-(void) executeCommandList: (CC3DrawCommandList*) cmdList withVisitor: (CC3NodeDrawingVisitor*) visitor {
+	GLuint cmdCount = cmdList.commandCount;
+	for (GLuint i = 0; i < cmdCount; i++) {
+		[visitor drawCommand: [cmdList commandAt: i]];
+	}
+}
+
++(id) executor { return [[[self alloc] init] autorelease]; }
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3RecordingDrawCommandExecutor
+
+@implementation CC3RecordingDrawCommandExecutor
+
+@synthesize recordedFrames;
+
+-(void) dealloc {
+	[recordedFrames release];
+	[super dealloc];
+}
+
+-(BOOL) isHeadless { return YES; }
+
+-(NSArray*) lastRecordedFrame { return [recordedFrames lastObject]; }
+
+-(void) executeCommandList: (CC3DrawCommandList*) cmdList withVisitor: (CC3NodeDrawingVisitor*) visitor {
+	GLuint cmdCount = cmdList.commandCount;
+	NSMutableArray* frame = [NSMutableArray arrayWithCapacity: cmdCount];
+	for (GLuint i = 0; i < cmdCount; i++) {
+		[frame addObject: NSStringFromCC3DrawCommand([cmdList commandAt: i])];
+	}
+	[recordedFrames addObject: frame];
+}
+
+-(void) clear { [recordedFrames removeAllObjects]; }
+
+-(id) init {
+	if ( (self = [super init]) ) {
+		recordedFrames = [[NSMutableArray array] retain];
+	}
+	return self;
+}
+
++(id) executor { return [[[self alloc] init] autorelease]; }
+
+@end
+
+
 #pragma mark -
 #pragma mark CC3NodePickingVisitor
 
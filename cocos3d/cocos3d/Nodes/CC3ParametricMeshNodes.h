@@ -776,6 +776,17 @@
 #pragma mark -
 #pragma mark CC3BitmapLabelNode
 
+/**
+ * The layout of a single character glyph within the mesh of a CC3BitmapLabelNode. The content of the
+ * vertices of the glyph is completely determined by the character and its location, along with the
+ * font, line height and tessellation of the label.
+ */
+typedef struct {
+	unichar character;			/**< The character displayed by the glyph. */
+	GLfloat lineWidth;			/**< The width of the line of text containing the glyph. */
+	CGPoint location;			/**< The top-left corner of the glyph within the mesh. */
+} CC3BitmapGlyph;
+
 /**
  * CC3BitmapLabelNode displays a rectangular mesh displaying the text of a specified string,
  * built from bitmap character images taken from a texture atlas as defined by a bitmpped font
@@ -804,7 +815,20 @@
  *
  * The properties of this class can be changed at any time to display a different text string, or to
  * change the visual aspects of the label. Changing any of the properties in this class causes the
- * underlying mesh to be automatically rebuilt.
+ * underlying mesh to be automatically updated.
+ *
+ * This node caches the layout of each character glyph in the mesh. When the labelString property
+ * is changed, the new string is laid out against that cache, and only the vertices of those glyphs
+ * whose character or position has changed are rewritten, in place, and only the range of vertices
+ * that was rewritten is copied to the GL buffers. A label whose text changes frequently, such as a
+ * score or a timer, therefore only rewrites the few characters that actually changed. Changing the
+ * fontFileName, lineHeight or tessellation properties rebuilds the entire mesh.
+ *
+ * Mesh memory is expanded as needed, but is not released when the label becomes shorter. For a label
+ * whose length varies, you can use the ensureCharacterCapacity: method to reserve space for the longest
+ * expected string, so that the mesh memory and GL buffers are not reallocated as the label changes.
+ *
+ * Because the mesh is updated in place, a copy of this node does not share the mesh of the original.
  *
  * The vertexContentType property of this mesh may be set to define the content type for each vertex.
  * Content types kCC3VertexContentLocation, kCC3VertexContentNormal, and kCC3VertexContentTextureCoordinate
@@ -818,10 +842,15 @@
 	NSString* labelString;
 	NSString* fontFileName;
 	CC3BMFontConfiguration* fontConfig;
+	CC3BitmapGlyph* glyphs;
+	CC3BitmapGlyph* layoutGlyphs;
 	UITextAlignment textAlignment;
 	CGPoint relativeOrigin;
 	ccGridSize tessellation;
 	GLfloat lineHeight;
+	GLuint glyphCount;
+	GLuint glyphCapacity;
+	BOOL isLabelMeshDirty : 1;
 }
 
 /**
@@ -925,6 +954,18 @@
  */
 @property(nonatomic, readonly) GLfloat baseline;
 
+/**
+ * Ensures that the mesh of this label has space for the specified number of characters, using
+ * the current tessellation, expanding the underlying memory and GL buffers if necessary.
+ *
+ * Memory is otherwise expanded automatically as the labelString property grows. Invoking this
+ * method with the length of the longest string expected to be displayed avoids reallocating
+ * the mesh content, and recreating the GL buffers, as the label changes.
+ *
+ * Returns whether the underlying memory had to be expanded.
+ */
+-(BOOL) ensureCharacterCapacity: (GLuint) charCount;
+
 @end
 
 
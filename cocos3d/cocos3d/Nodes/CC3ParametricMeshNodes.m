@@ -372,6 +372,13 @@
 
 @interface CC3BitmapLabelNode (TemplateMethods)
 -(void) populateLabelMesh;
+-(void) ensureGlyphCapacity: (GLuint) glyphCnt;
+-(BOOL) expandMeshCapacityTo: (GLuint) charCount;
+-(GLuint) layoutGlyphs;
+-(void) populateGlyph: (CC3BitmapGlyph*) glyph at: (GLuint) glyphIdx withScale: (GLfloat) fontScale;
+-(void) populateGlyphFacesAt: (GLuint) glyphIdx;
+@property(nonatomic, readonly) GLuint vertexCountPerGlyph;
+@property(nonatomic, readonly) GLuint vertexIndexCountPerGlyph;
 @end
 
 @implementation CC3BitmapLabelNode
@@ -380,6 +387,8 @@
 	[labelString release];
 	[fontFileName release];
 	[fontConfig release];
+	free(glyphs);
+	free(layoutGlyphs);
 	[super dealloc];
 }
 
@@ -388,6 +397,7 @@
 -(void) setLineHeight: (GLfloat) lineHt {
 	if (lineHt != lineHeight) {
 		lineHeight = lineHt;
+		isLabelMeshDirty = YES;
 		[self populateLabelMesh];
 	}
 }
@@ -412,6 +422,7 @@
 		[fontConfig release];
 		fontConfig = [[CC3BMFontConfiguration configurationFromFontFile: fontFileName] retain];
 
+		isLabelMeshDirty = YES;
 		[self populateLabelMesh];
 	}
 }
@@ -439,6 +450,7 @@
 -(void) setTessellation: (ccGridSize) aGrid {
 	if ( !((aGrid.x == tessellation.x) && (aGrid.y == tessellation.y)) ) {
 		tessellation = aGrid;
+		isLabelMeshDirty = YES;
 		[self populateLabelMesh];
 	}
 }
@@ -450,22 +462,277 @@
 	return 1.0f - (GLfloat)fontConfig->baseline / (GLfloat)fontConfig->commonHeight_;
 }
 
+/** Overridden to invalidate the glyph cache, since it describes the content of the old mesh. */
+-(void) setMesh: (CC3Mesh*) aMesh {
+	[super setMesh: aMesh];
+	isLabelMeshDirty = YES;
+}
+
+-(GLuint) vertexCountPerGlyph { return (GLuint)((tessellation.x + 1) * (tessellation.y + 1)); }
+
+-(GLuint) vertexIndexCountPerGlyph { return (GLuint)(tessellation.x * tessellation.y * 6); }
+
 #pragma mark Mesh population
 
+/** Ensures that the glyph cache and layout arrays can each hold the specified number of glyphs. */
+-(void) ensureGlyphCapacity: (GLuint) glyphCnt {
+	if (glyphCnt <= glyphCapacity) return;
+	glyphCapacity = glyphCnt;
+	glyphs = realloc(glyphs, glyphCapacity * sizeof(CC3BitmapGlyph));
+	layoutGlyphs = realloc(layoutGlyphs, glyphCapacity * sizeof(CC3BitmapGlyph));
+}
+
+/**
+ * Expands the vertex and vertex index memory of the mesh to hold the specified number of
+ * characters, if needed, preserving the existing mesh content and the number of vertices
+ * and vertex indices drawn. GL buffers are not affected. Returns whether memory was expanded.
+ */
+-(BOOL) expandMeshCapacityTo: (GLuint) charCount {
+	CC3VertexArrayMesh* vaMesh = [self prepareParametricMesh];
+	GLuint vtxCount = vaMesh.vertexCount;
+	GLuint vtxIdxCount = vaMesh.vertexIndices ? vaMesh.vertexIndexCount : 0;
+	BOOL wasExpanded = NO;
+
+	GLuint vtxCap = charCount * self.vertexCountPerGlyph;
+	if (vtxCap > vaMesh.allocatedVertexCapacity) {
+		vaMesh.allocatedVertexCapacity = vtxCap;
+		wasExpanded = YES;
+	}
+	GLuint vtxIdxCap = charCount * self.vertexIndexCountPerGlyph;
+	if (vtxIdxCap > vaMesh.allocatedVertexIndexCapacity) {
+		vaMesh.allocatedVertexIndexCapacity = vtxIdxCap;
+		wasExpanded = YES;
+	}
+
+	// Allocation resets the vertex counts to the new capacity
+	if (wasExpanded) {
+		vaMesh.vertexCount = vtxCount;
+		vaMesh.vertexIndexCount = vtxIdxCount;
+	}
+	return wasExpanded;
+}
+
+-(BOOL) ensureCharacterCapacity: (GLuint) charCount {
+	[self ensureGlyphCapacity: charCount];
+	BOOL wasExpanded = [self expandMeshCapacityTo: charCount];
+	if (wasExpanded && mesh.isUsingGLBuffers) {
+		[mesh deleteGLBuffers];
+		[mesh createGLBuffers];
+	}
+	return wasExpanded;
+}
+
+/**
+ * Lays out the characters of the label string into the layoutGlyphs array, and returns the
+ * number of glyphs laid out. Newline characters start a new line, and do not create a glyph.
+ *
+ * Each line is first laid out from the left, taking into consideration the character offsets
+ * and the kerning between characters. Once the width of the overall layout is known, each
+ * glyph is moved to align its line, and to position the layout around the relative origin.
+ */
+-(GLuint) layoutGlyphs {
+	GLfloat lineHt = self.lineHeight;
+	GLfloat fontScale = lineHt / (GLfloat)fontConfig->commonHeight_;
+	NSUInteger strLen = labelString.length;
+
+	// Line count needs to be calculated before laying out the lines to get Y position
+	NSUInteger lineCount = 1;
+	for (NSUInteger i = 0; i < strLen; i++) if ([labelString characterAtIndex: i] == '\n') lineCount++;
+
+	// Start at the top-left corner of the label, above the first line.
+	CGPoint charPos = ccp(0, lineCount * lineHt);
+	GLfloat layoutWidth = 0.0f;
+	GLfloat lineWidth = 0.0f;
+	GLuint lineStartGlyph = 0;
+	GLuint glyphCnt = 0;
+	unichar prevChar = -1;
+
+	// Iterate through the characters, treating the end of the string as the end of the last line
+	for (NSUInteger i = 0; i <= strLen; i++) {
+		unichar c = (i < strLen) ? [labelString characterAtIndex: i] : '\n';
+
+		// At the end of a line, record its width in each of its glyphs, and move down a line
+		if (c == '\n') {
+			for (GLuint g = lineStartGlyph; g < glyphCnt; g++) layoutGlyphs[g].lineWidth = lineWidth;
+			layoutWidth = MAX(layoutWidth, lineWidth);
+			lineWidth = 0.0f;
+			lineStartGlyph = glyphCnt;
+			charPos.x = 0;
+			charPos.y -= lineHt;
+			continue;
+		}
+
+		ccBMFontDef* charSpec = [fontConfig characterSpecFor: c];
+		NSAssert2(charSpec, @"%@: no font specification loaded for character %i", self, c);
+
+		NSInteger kerningAmount = [fontConfig kerningBetween: prevChar and: c] * fontScale;
+		CC3BitmapGlyph* glyph = &layoutGlyphs[glyphCnt++];
+		glyph->character = c;
+		glyph->location.x = charPos.x + (charSpec->xOffset * fontScale) + kerningAmount;
+		glyph->location.y = charPos.y - (charSpec->yOffset * fontScale);
+		lineWidth = MAX(lineWidth, glyph->location.x + (charSpec->rect.size.width * fontScale));
+
+		// Horizontal position of the next character
+		charPos.x += (charSpec->xAdvance * fontScale) + kerningAmount;
+		prevChar = c;
+	}
+
+	// Align each glyph within its line, and move it so that the origin of the mesh is
+	// aligned with a location derived from the relative origin.
+	CGPoint originLoc = ccp(layoutWidth * relativeOrigin.x, lineHt * lineCount * relativeOrigin.y);
+	for (GLuint g = 0; g < glyphCnt; g++) {
+		CC3BitmapGlyph* glyph = &layoutGlyphs[g];
+		GLfloat widthAdj;
+		switch (textAlignment) {
+			case UITextAlignmentCenter:
+				widthAdj = (layoutWidth - glyph->lineWidth) * 0.5f;
+				break;
+			case UITextAlignmentRight:
+				widthAdj = layoutWidth - glyph->lineWidth;
+				break;
+			case UITextAlignmentLeft:
+			default:
+				widthAdj = 0.0f;
+				break;
+		}
+		glyph->location.x += widthAdj - originLoc.x;
+		glyph->location.y -= originLoc.y;
+	}
+	return glyphCnt;
+}
+
+/**
+ * Populates the vertex locations and texture coordinates of the specified glyph, at the
+ * specified glyph position in the mesh, by iterating through the rows and columns of the
+ * tessellation grid, from the top-left corner downwards.
+ */
+-(void) populateGlyph: (CC3BitmapGlyph*) glyph at: (GLuint) glyphIdx withScale: (GLfloat) fontScale {
+	ccBMFontDef* charSpec = [fontConfig characterSpecFor: glyph->character];
+	CGSize divSize = CGSizeMake(charSpec->rect.size.width / tessellation.x,
+								charSpec->rect.size.height / tessellation.y);
+	GLuint vIdx = glyphIdx * self.vertexCountPerGlyph;
+	for (NSInteger iy = 0; iy <= tessellation.y; iy++) {
+		for (NSInteger ix = 0; ix <= tessellation.x; ix++, vIdx++) {
+			GLfloat vx = glyph->location.x + (divSize.width * ix * fontScale);
+			GLfloat vy = glyph->location.y - (divSize.height * iy * fontScale);
+			[mesh setVertexLocation: cc3v(vx, vy, 0.0) at: vIdx];
+
+			// Texture coordinates, inverted vertically, because we're working top-down.
+			GLfloat u = (charSpec->rect.origin.x + (divSize.width * ix)) / fontConfig->textureSize.x;
+			GLfloat v = (charSpec->rect.origin.y + (divSize.height * iy)) / fontConfig->textureSize.y;
+			[mesh setVertexTexCoord2F: cc3tc(u, v) at: vIdx];
+		}
+	}
+}
+
+/**
+ * Populates the vertex normals and vertex indices of the glyph at the specified glyph position in
+ * the mesh. This content does not depend on the character, and so only needs to be populated once
+ * for each glyph position. Each division of the tessellation grid is broken into two triangles.
+ */
+-(void) populateGlyphFacesAt: (GLuint) glyphIdx {
+	NSInteger divsX = tessellation.x;
+	GLuint vIdx = glyphIdx * self.vertexCountPerGlyph;
+	GLuint iIdx = glyphIdx * self.vertexIndexCountPerGlyph;
+	for (NSInteger iy = 0; iy <= tessellation.y; iy++) {
+		for (NSInteger ix = 0; ix <= divsX; ix++, vIdx++) {
+			[mesh setVertexNormal: kCC3VectorUnitZPositive at: vIdx];
+			if (iy < tessellation.y && ix < divsX) {
+				[mesh setVertexIndex: vIdx at: iIdx++];						// TL
+				[mesh setVertexIndex: (vIdx + divsX + 1) at: iIdx++];		// BL
+				[mesh setVertexIndex: (vIdx + divsX + 2) at: iIdx++];		// BR
+				[mesh setVertexIndex: (vIdx + divsX + 2) at: iIdx++];		// BR
+				[mesh setVertexIndex: (vIdx + 1) at: iIdx++];				// TR
+				[mesh setVertexIndex: vIdx at: iIdx++];						// TL
+			}
+		}
+	}
+}
+
+/**
+ * Lays out the label string, and compares each glyph against the glyph cache, rewriting only
+ * those glyphs whose character or location has changed. Only the range of vertices that was
+ * rewritten, and the vertex indices of any glyphs added, are copied to the GL buffers.
+ *
+ * If the font, line height or tessellation has changed, or the mesh has been replaced, the glyph
+ * cache is invalidated and the entire mesh is rewritten.
+ */
 -(void) populateLabelMesh {
-	if (fontFileName && labelString) {
-		[self populateAsBitmapFontLabelFromString: self.labelString
-									 fromFontFile: self.fontFileName
-									andLineHeight: self.lineHeight
-								 andTextAlignment: self.textAlignment
-								andRelativeOrigin: self.relativeOrigin
-								  andTessellation: self.tessellation];
-		[self markBoundingVolumeDirty];
-		if (mesh.isUsingGLBuffers) {
-			[mesh deleteGLBuffers];
-			[mesh createGLBuffers];
+	if ( !(fontFileName && labelString) ) return;
+
+	CC3VertexArrayMesh* vaMesh = [self prepareParametricMesh];
+	if (isLabelMeshDirty) {
+		glyphCount = 0;
+
+		// Set texture after mesh to avoid mesh setter from clearing texture
+		self.texture = [CC3Texture textureFromFile: fontConfig.atlasName];
+
+		// By definition, characters have significant transparency, so turn alpha blending on.
+		// Since characters can overlap with kerning, don't draw the transparent parts to avoid
+		// Z-fighting between the characters. Set the alpha tolerance higher than zero so that
+		// non-zero alpha at character edges due to anti-aliasing won't be drawn.
+		self.isOpaque = NO;
+		self.shouldDrawLowAlpha = NO;
+		self.material.alphaTestReference = 0.05;
+	}
+
+	[self ensureGlyphCapacity: labelString.length];
+	GLuint newGlyphCount = [self layoutGlyphs];
+
+	GLuint vtxCountPerGlyph = self.vertexCountPerGlyph;
+	GLuint vtxIdxCountPerGlyph = self.vertexIndexCountPerGlyph;
+	BOOL wasExpanded = NO;
+	if (newGlyphCount * vtxCountPerGlyph > vaMesh.allocatedVertexCapacity ||
+		newGlyphCount * vtxIdxCountPerGlyph > vaMesh.allocatedVertexIndexCapacity) {
+		wasExpanded = [self expandMeshCapacityTo: (GLuint)(newGlyphCount * vaMesh.capacityExpansionFactor)];
+	}
+
+	// Rewrite only the glyphs that have changed, and keep track of the range rewritten
+	GLfloat fontScale = self.lineHeight / (GLfloat)fontConfig->commonHeight_;
+	GLuint firstDirtyGlyph = newGlyphCount;
+	GLuint endDirtyGlyph = 0;
+	for (GLuint g = 0; g < newGlyphCount; g++) {
+		CC3BitmapGlyph* newGlyph = &layoutGlyphs[g];
+		if (g < glyphCount) {
+			CC3BitmapGlyph* oldGlyph = &glyphs[g];
+			if (newGlyph->character == oldGlyph->character &&
+				CGPointEqualToPoint(newGlyph->location, oldGlyph->location)) continue;
+		} else {
+			[self populateGlyphFacesAt: g];
 		}
+		[self populateGlyph: newGlyph at: g withScale: fontScale];
+		firstDirtyGlyph = MIN(firstDirtyGlyph, g);
+		endDirtyGlyph = g + 1;
 	}
+	LogTrace(@"%@ rewrote glyphs %u to %u of %u", self, firstDirtyGlyph, endDirtyGlyph, newGlyphCount);
+
+	// The new layout becomes the glyph cache
+	GLuint firstNewGlyph = glyphCount;
+	BOOL didChangeGlyphCount = (newGlyphCount != glyphCount);
+	CC3BitmapGlyph* prevGlyphs = glyphs;
+	glyphs = layoutGlyphs;
+	layoutGlyphs = prevGlyphs;
+	glyphCount = newGlyphCount;
+
+	vaMesh.vertexCount = newGlyphCount * vtxCountPerGlyph;
+	vaMesh.vertexIndexCount = newGlyphCount * vtxIdxCountPerGlyph;
+
+	if (vaMesh.isUsingGLBuffers) {
+		if (wasExpanded) {
+			[vaMesh deleteGLBuffers];
+			[vaMesh createGLBuffers];
+		} else {
+			if (endDirtyGlyph > firstDirtyGlyph)
+				[vaMesh updateGLBuffersStartingAt: (firstDirtyGlyph * vtxCountPerGlyph)
+										forLength: ((endDirtyGlyph - firstDirtyGlyph) * vtxCountPerGlyph)];
+			if (newGlyphCount > firstNewGlyph)
+				[vaMesh.vertexIndices updateGLBufferStartingAt: (firstNewGlyph * vtxIdxCountPerGlyph)
+													 forLength: ((newGlyphCount - firstNewGlyph) * vtxIdxCountPerGlyph)];
+		}
+	}
+
+	if (endDirtyGlyph > firstDirtyGlyph || didChangeGlyphCount) [self markBoundingVolumeDirty];
+	isLabelMeshDirty = NO;
 }
 
 
@@ -476,6 +743,11 @@
 		labelString = @"hello, world";		// Fail-safe to display if nothing set
 		fontFileName = nil;
 		fontConfig = nil;
+		glyphs = NULL;
+		layoutGlyphs = NULL;
+		glyphCount = 0;
+		glyphCapacity = 0;
+		isLabelMeshDirty = YES;
 		lineHeight = 0;
 		textAlignment = UITextAlignmentLeft;
 		relativeOrigin = ccp(0,0);
@@ -484,9 +756,12 @@
 	return self;
 }
 
+/** The mesh is updated in place, so it is not shared with the original. */
 -(void) populateFrom: (CC3BitmapLabelNode*) another {
 	[super populateFrom: another];
 
+	self.mesh = nil;										// Labels can't share meshes
+	self.vertexContentTypes = another.vertexContentTypes;	// Use setter to establish a new mesh
 	relativeOrigin = another.relativeOrigin;
 	textAlignment = another.textAlignment;
 	tessellation = another.tessellation;
@@ -42,6 +42,36 @@
 #import "CC3OpenGLESShaders.h"
 
 
+#pragma mark -
+#pragma mark CC3PendingGLUpdateProtocol
+
+/**
+ * CC3PendingGLUpdateProtocol is implemented by objects, such as meshes and vertex arrays, whose
+ * content may be built or changed on threads other than the render thread, and which therefore
+ * need to defer the corresponding work on their GL resources to the render thread.
+ *
+ * Such an object records the work it needs performed, and adds itself to the queue of pending
+ * GL updates, using the queuePendingGLUpdate: class method of CC3OpenGLESEngine. At the start
+ * of each frame, the render thread drains that queue, and invokes the performPendingGLUpdates
+ * method on each object in it.
+ */
+@protocol CC3PendingGLUpdateProtocol <NSObject>
+
+/**
+ * Performs any GL work that was requested from a thread other than the render thread.
+ *
+ * This method is invoked on the render thread, and must be safe to invoke even if there
+ * is no pending work, since the pending work may already have been performed when this
+ * object was bound for drawing.
+ */
+-(void) performPendingGLUpdates;
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3OpenGLESEngine
+
 /**
  * CC3OpenGLESEngine manages the state of the OpenGL ES engine.
  *
@@ -96,6 +126,7 @@
  *      which is nil, unless your application sets a tracker manager there.
  */
 @interface CC3OpenGLESEngine : CC3OpenGLESStateTracker {
+	CCArray* _trackers;
 	CCArray* _trackersToOpen;
 	CCArray* _trackersToClose;
 	CC3OpenGLESPlatform* _platform;
@@ -110,6 +141,7 @@
 	CC3OpenGLESHints* _hints;
 	CC3OpenGLESShaders* _shaders;
 	CC3OpenGLESStateTrackerManager* _appExtensions;
+	NSThread* _renderThread;
 	BOOL _isClosing;
 	BOOL _trackerToOpenWasAdded;
 }
@@ -187,6 +219,45 @@
 /** Returns the CC3OpenGLESEngine engine singleton. */
 +(CC3OpenGLESEngine*) engine;
 
+/**
+ * The thread on which GL calls are made. This is the thread on which this instance was
+ * created, and is updated to the current thread each time the open method is invoked.
+ *
+ * Mesh content, including vertex arrays, may be built and changed on other threads, such as
+ * background loader or simulation threads. Operations on GL resources that are requested
+ * from any thread other than this one, such as creating, updating or deleting GL buffers,
+ * are deferred until they can be performed on this thread.
+ */
+@property(nonatomic, readonly) NSThread* renderThread;
+
+/**
+ * Returns whether the current thread is the thread on which GL calls are made.
+ *
+ * If the engine singleton has not yet been created, GL calls have yet to be made through it,
+ * and this method returns whether the current thread is the main thread. This method does not
+ * create the engine singleton.
+ */
++(BOOL) isRenderThread;
+
+/**
+ * Adds the specified object to the queue of objects with GL work that has been requested from
+ * a thread other than the render thread. The object is retained until that work is performed.
+ *
+ * This method may be invoked from any thread, and does not create the engine singleton.
+ */
++(void) queuePendingGLUpdate: (id<CC3PendingGLUpdateProtocol>) anObject;
+
+/**
+ * Drains the queue of pending GL updates, by invoking the performPendingGLUpdates method on
+ * each object that has been added to the queue using the queuePendingGLUpdate: method.
+ *
+ * This method does nothing if it is not invoked on the render thread.
+ *
+ * This method is invoked automatically by the CC3Scene at the start of each frame.
+ * Usually, the application never needs to invoke this method directly.
+ */
++(void) performPendingGLUpdates;
+
 /**
  * Template method that initializes the tracker managers.
  *
@@ -216,6 +287,16 @@
  */
 -(void) close;
 
+/**
+ * Registers the specified primitive tracker with this engine, and adds it to the
+ * collection of trackers that are to be opened, using the addTrackerToOpen: method.
+ *
+ * Invoked automatically when a primitive tracker (CC3OpenGLESStateTrackerPrimitive) has been
+ * added somewhere in the hierarchy. The registered trackers are retained by this engine,
+ * so that they can be reset by the invalidateTrackedState method.
+ */
+-(void) addTracker: (CC3OpenGLESStateTracker*) aTracker;
+
 /**
  * Adds the specified tracker to the collection of trackers that are to be opened.
  *
@@ -245,4 +326,24 @@
  */
 -(void) addTrackerToClose: (CC3OpenGLESStateTracker*) aTracker;
 
+/**
+ * Discards the GL state that has been cached by the trackers in this engine, so that it is
+ * no longer assumed to reflect the state of the GL engine.
+ *
+ * The value of each registered primitive tracker is marked as unknown, and each tracker is
+ * scheduled to be opened again, so that any original value it reads from the GL engine is
+ * read again when this engine is next opened, and the next value set in each tracker is
+ * passed to the GL engine. The active program, and the uniform values cached by the GLSL
+ * programs, are also discarded, by invoking the invalidateProgramState method of the
+ * shaders tracker manager.
+ *
+ * Because the values of the trackers were set without a check against the GL engine, this
+ * method should be invoked whenever GL calls may have been made through this engine without
+ * reaching the GL context that is subsequently rendered to, such as while a GL context was
+ * not current, or while rendering to a different GL context.
+ *
+ * This method must be invoked on the rendering thread, outside of the open and close methods.
+ */
+-(void) invalidateTrackedState;
+
 @end
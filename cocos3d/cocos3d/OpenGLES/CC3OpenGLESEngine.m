@@ -70,6 +70,8 @@
 	[_hints release];
 	[_shaders release];
 	[_appExtensions release];
+	[_renderThread release];
+	[_trackers release];
 	[_trackersToOpen release];
 	[_trackersToClose releaseAsUnretained];		// Clears without releasing each element.
 
@@ -81,9 +83,11 @@
 
 -(id) init {
 	if ( (self = [super init]) ) {
+		_trackers = [[CCArray arrayWithCapacity: 200] retain];
 		_trackersToClose = [[CCArray arrayWithCapacity: 200] retain];
 		_isClosing = NO;
 		_trackerToOpenWasAdded = NO;
+		_renderThread = [[NSThread currentThread] retain];
 		[self initializeTrackers];
 	}
 	return self;
@@ -106,9 +110,44 @@ static CC3OpenGLESEngine* _engine;
 	return _engine;
 }
 
++(BOOL) isRenderThread {
+	return _engine ? (_engine->_renderThread == [NSThread currentThread]) : [NSThread isMainThread];
+}
+
+-(NSThread*) renderThread { return _renderThread; }
+
+// Objects whose GL work was requested from a thread other than the render thread.
+// Guarded by synchronizing on this class.
+static NSMutableArray* _pendingGLUpdates = nil;
+
++(void) queuePendingGLUpdate: (id<CC3PendingGLUpdateProtocol>) anObject {
+	@synchronized(self) {
+		if ( !_pendingGLUpdates ) _pendingGLUpdates = [[NSMutableArray alloc] init];
+		[_pendingGLUpdates addObject: anObject];
+	}
+}
+
+/** Swaps the queue out while synchronized, so that objects can be queued while the updates are performed. */
++(void) performPendingGLUpdates {
+	if ( !self.isRenderThread ) return;
+	NSMutableArray* pendingUpdates;
+	@synchronized(self) {
+		pendingUpdates = _pendingGLUpdates;
+		_pendingGLUpdates = nil;
+	}
+	LogTrace(@"%@ performing %u pending GL updates", self, pendingUpdates.count);
+	for (id<CC3PendingGLUpdateProtocol> obj in pendingUpdates) [obj performPendingGLUpdates];
+	[pendingUpdates release];
+}
+
 -(void) initializeTrackers {}
 
 -(void) open {
+	NSThread* currThread = [NSThread currentThread];
+	if (currThread != _renderThread) {
+		[_renderThread release];
+		_renderThread = [currThread retain];
+	}
 	
 	// Open each tracker that is to be opened.
 	LogTrace(@"%@ opening %i trackers", [self class], _trackersToOpen.count);
@@ -150,6 +189,11 @@ static CC3OpenGLESEngine* _engine;
 	_isClosing = NO;
 }
 
+-(void) addTracker: (CC3OpenGLESStateTracker*) aTracker {
+	[_trackers addObject: aTracker];
+	[self addTrackerToOpen: aTracker];
+}
+
 // Lazily init the trackersToOpen array so that it can be nilled out
 // if it is empty, but recreated if other trackers are added later.
 -(void) addTrackerToOpen: (CC3OpenGLESStateTracker*) aTracker {
@@ -169,6 +213,16 @@ static CC3OpenGLESEngine* _engine;
 	}
 }
 
+// Trackers that always read their original value are already scheduled to be opened.
+-(void) invalidateTrackedState {
+	LogTrace(@"%@ invalidating %i trackers", [self class], _trackers.count);
+	for (CC3OpenGLESStateTrackerPrimitive* tracker in _trackers) {
+		tracker.valueIsKnown = NO;
+		if ( !tracker.shouldAlwaysReadOriginal ) [self addTrackerToOpen: tracker];
+	}
+	[_shaders invalidateProgramState];
+}
+
 -(NSString*) description {
 	NSMutableString* desc = [NSMutableString stringWithCapacity: 600];
 	[desc appendFormat: @"%@:", [self class]];
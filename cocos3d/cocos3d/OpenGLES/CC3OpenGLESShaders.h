@@ -121,10 +121,35 @@
 
 #pragma mark Binding
 
+/**
+ * Returns the GL program used for painting nodes with a pure color, including during node picking.
+ *
+ * When using OpenGL ES 1, this property returns nil.
+ */
+@property(nonatomic, readonly) CC3GLProgram* pureColorProgram;
+
 /** Binds the GL program used for painting nodes with a pure color, including during node picking. */
 -(void) bindPureColorProgramWithVisitor: (CC3NodeDrawingVisitor*) visitor;
 
+/**
+ * Binds the GL program used for rendering the depth of shadow-casting nodes into a shadow map.
+ *
+ * The depth of each fragment, as seen from the light, is packed into the four components
+ * of the fragment color. Under OpenGL ES 1, this method does nothing.
+ */
+-(void) bindShadowMapDepthProgramWithVisitor: (CC3NodeDrawingVisitor*) visitor;
+
 /** Unbinds all GL programs from the GL engine. */
 -(void) unbind;
 
+/**
+ * Discards the active program, and the uniform values that have been cached by each GLSL
+ * program, so that each program is bound to the GL engine, and all of its uniform values
+ * are set in the GL engine, the next time the program is used.
+ *
+ * This method is invoked automatically by the invalidateTrackedState method of the
+ * CC3OpenGLESEngine. Usually, the application never needs to invoke this method directly.
+ */
+-(void) invalidateProgramState;
+
 @end
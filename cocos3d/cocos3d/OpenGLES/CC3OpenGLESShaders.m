@@ -70,10 +70,19 @@
 
 #pragma mark Binding
 
+-(CC3GLProgram*) pureColorProgram { return nil; }
+
 -(void) bindPureColorProgramWithVisitor: (CC3NodeDrawingVisitor*) visitor {}
 
+-(void) bindShadowMapDepthProgramWithVisitor: (CC3NodeDrawingVisitor*) visitor {}
+
 -(void) unbind {}
 
+-(void) invalidateProgramState {
+	_activeProgram = nil;
+	[CC3GLProgram invalidateUniformState];
+}
+
 
 #pragma mark Allocation and initialization
 
@@ -164,8 +164,8 @@ typedef enum {
 /**
  * Invoked automatically when a tracker is added to its parent.
  *
- * This implementation adds this tracker to the collection of trackers
- * to be opened by the CC3OpenGLESEngine.
+ * This implementation registers this tracker with the CC3OpenGLESEngine, and adds
+ * it to the collection of trackers to be opened by the CC3OpenGLESEngine.
  */
 -(void) notifyTrackerAdded;
 
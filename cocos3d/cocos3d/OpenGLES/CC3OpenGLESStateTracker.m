@@ -67,7 +67,7 @@
 
 -(void) close { isScheduledForClose = NO; }
 
--(void) notifyTrackerAdded { [self.engine addTrackerToOpen: self]; }
+-(void) notifyTrackerAdded { [self.engine addTracker: self]; }
 
 -(void) notifyGLChanged {
 	if (!isScheduledForClose) {
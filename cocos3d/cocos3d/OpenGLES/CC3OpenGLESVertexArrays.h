@@ -56,6 +56,7 @@
  */
 @interface CC3OpenGLESStateTrackerArrayBufferBinding : CC3OpenGLESStateTrackerInteger {
 	GLenum queryName;
+	GLuint bytesLoaded;
 }
 
 /** The enumerated name under which the GL engine reads this state. */
@@ -79,6 +80,27 @@
 			  startingAt: (GLintptr) offset
 			   forLength: (GLsizeiptr) length;
 
+/**
+ * The number of bytes that have been copied to GL buffers by the loadBufferData:ofLength:forUse:
+ * and updateBufferData:startingAt:forLength: methods, since this value was last reset.
+ *
+ * This value can be used to measure how much vertex content is being transferred to the
+ * GL engine. It can be reset to zero using the resetBytesLoaded method.
+ */
+@property(nonatomic, readonly) GLuint bytesLoaded;
+
+/**
+ * Copies the specified length of data, starting at the specified data pointer, into the
+ * currently bound GL buffer, starting at the specified offset within the GL buffer.
+ *
+ * Unlike the updateBufferData:startingAt:forLength: method, the offset is applied only to
+ * the GL buffer, and not to the data pointer.
+ */
+-(void) loadBufferData: (GLvoid*) dataPtr ofLength: (GLsizeiptr) length atOffset: (GLintptr) offset;
+
+/** Resets the value of the bytesLoaded property to zero. */
+-(void) resetBytesLoaded;
+
 @end
 
 
@@ -213,6 +235,210 @@
 @end
 
 
+#pragma mark -
+#pragma mark CC3OpenGLESVertexStream
+
+/**
+ * CC3OpenGLESVertexStream is a ring of GL buffers into which vertex content that changes on every
+ * frame, such as that of particles, billboards, shadow volumes or deformed meshes, is streamed.
+ *
+ * Updating a GL buffer whose previous content is still being used by pending draw calls forces
+ * the GL engine to wait for those draw calls to complete before the buffer can be updated. To
+ * avoid this, this stream holds several GL buffers, and sub-allocates space from a different
+ * buffer on each frame. The content streamed during a frame is therefore written to a buffer
+ * that was last used several frames earlier, and that pending draw calls are no longer using.
+ *
+ * The beginFrame method must be invoked at the start of each frame, to move to the next buffer
+ * in the ring. This is handled automatically by the CC3Scene when it opens the 3D drawing
+ * environment. The content of each vertex array that is streamed during a frame remains valid
+ * until the same buffer is reused, after the number of frames indicated by the bufferCount
+ * property.
+ *
+ * If the shouldOrphanOnReuse property is set to YES, the storage of each buffer is orphaned
+ * when it is reused, by reloading it without content, which allows the GL engine to allocate
+ * fresh storage if the previous storage is still in use, even if the GL engine is rendering
+ * more frames behind the application than the number of buffers in the ring. Storage is also
+ * orphaned if the content streamed during a single frame overflows the capacity of the buffer.
+ *
+ * Vertex arrays make use of a vertex stream when their shouldStreamVertices property is set to YES.
+ * The stream for each GL buffer target is available from the streamForTarget: method of the
+ * CC3OpenGLESVertexArrays instance held by the CC3OpenGLESEngine.
+ */
+@interface CC3OpenGLESVertexStream : NSObject {
+	CC3OpenGLESStateTrackerArrayBufferBinding* bufferBinding;		// not retained
+	GLuint* bufferIDs;
+	GLuint bufferCount;
+	GLuint bufferIndex;
+	GLsizeiptr capacity;
+	GLintptr writeOffset;
+	GLvoid* lastData;
+	GLsizeiptr lastLength;
+	GLintptr lastOffset;
+	GLuint lastGeneration;
+	GLuint frameCount;
+	GLuint generation;
+	GLuint bytesStreamed;
+	GLuint copyCount;
+	GLuint reuseCount;
+	GLuint stallsAvoided;
+	GLuint orphanCount;
+	GLuint overflowCount;
+	BOOL shouldOrphanOnReuse : 1;
+	BOOL needsOrphaning : 1;
+	BOOL didStreamInPreviousFrame : 1;
+}
+
+/** The number of GL buffers in the ring. */
+@property(nonatomic, readonly) GLuint bufferCount;
+
+/** The capacity of each GL buffer in the ring, in bytes. */
+@property(nonatomic, readonly) GLsizeiptr capacity;
+
+/**
+ * Indicates whether the storage of each GL buffer should be orphaned when the buffer is reused
+ * by a later frame, so that the GL engine can allocate fresh storage if the previous storage
+ * is still in use by pending draw calls.
+ *
+ * The initial value of this property is YES.
+ */
+@property(nonatomic, assign) BOOL shouldOrphanOnReuse;
+
+/**
+ * The number of frames that have begun since this instance was created.
+ *
+ * This value is incremented by the beginFrame method, and can be used to determine
+ * whether content was streamed during the current frame.
+ */
+@property(nonatomic, readonly) GLuint frameCount;
+
+/**
+ * The number of times the storage of the GL buffers has been replaced since this instance was created.
+ *
+ * This value is incremented whenever the storage of the current GL buffer is orphaned, or the
+ * GL buffers are deleted. Content streamed before that point is no longer held in the storage
+ * of the current GL buffer, even if it was streamed during the current frame. Content streamed
+ * earlier can be reused only if both the frameCount and the value of this property are unchanged.
+ */
+@property(nonatomic, readonly) GLuint generation;
+
+/** The GL buffer into which content is being streamed during the current frame, or zero if none has been created. */
+@property(nonatomic, readonly) GLuint currentBufferID;
+
+/**
+ * Initializes this instance to stream content into a ring of the specified number of GL buffers,
+ * each of the specified capacity in bytes, using the specified buffer binding tracker to bind
+ * the GL buffers. The GL buffers are created lazily, when content is first streamed.
+ *
+ * The buffer binding tracker is not retained.
+ */
+-(id) initWithBufferBinding: (CC3OpenGLESStateTrackerArrayBufferBinding*) aBinding
+				bufferCount: (GLuint) buffCount
+				   capacity: (GLsizeiptr) buffCapacity;
+
+/**
+ * Allocates and initializes an autoreleased instance to stream content into a ring of the
+ * specified number of GL buffers, each of the specified capacity in bytes, using the specified
+ * buffer binding tracker to bind the GL buffers.
+ */
++(id) streamWithBufferBinding: (CC3OpenGLESStateTrackerArrayBufferBinding*) aBinding
+				  bufferCount: (GLuint) buffCount
+					 capacity: (GLsizeiptr) buffCapacity;
+
+/**
+ * Moves to the next GL buffer in the ring, and starts sub-allocating space from the beginning
+ * of that buffer. This method must be invoked at the start of each frame.
+ */
+-(void) beginFrame;
+
+/**
+ * Copies the specified length of data, starting at the specified data pointer, into space
+ * allocated from the GL buffer of the current frame. The GL buffer is left bound to the
+ * GL engine, and its ID is returned. The offset of the content within the GL buffer is
+ * returned in the specified offset pointer.
+ *
+ * If the specified data is the same data that was most recently streamed during the current
+ * frame, and canReuse is YES, the data is not copied again, and the offset of the previous copy
+ * is returned. This allows interleaved vertex arrays, which share the same content, to stream
+ * that content only once per frame. Pass NO for canReuse if the content might have changed
+ * since it was last streamed. The previous copy is never reused if the storage of the GL buffer
+ * has been orphaned since it was made.
+ *
+ * If the specified length is larger than the capacity of the GL buffers, nothing is copied,
+ * and this method returns zero, in which case the content should be passed to the GL engine
+ * from application memory instead.
+ */
+-(GLuint) streamData: (GLvoid*) dataPtr
+			ofLength: (GLsizeiptr) length
+			toOffset: (GLintptr*) pOffset
+			canReuse: (BOOL) canReuse;
+
+/** Deletes the GL buffers in the ring. They will be recreated if content is streamed again. */
+-(void) deleteGLBuffers;
+
+
+#pragma mark Statistics
+
+/** The number of bytes that have been copied into the GL buffers since the statistics were last reset. */
+@property(nonatomic, readonly) GLuint bytesStreamed;
+
+/** The number of times content has been copied into the GL buffers since the statistics were last reset. */
+@property(nonatomic, readonly) GLuint copyCount;
+
+/**
+ * The number of times content was requested to be streamed, but the copy that was already
+ * streamed during the same frame was reused instead, since the statistics were last reset.
+ */
+@property(nonatomic, readonly) GLuint reuseCount;
+
+/**
+ * The number of copies into the GL buffers that were made while content streamed during the
+ * previous frame might still be in use by pending draw calls, since the statistics were last reset.
+ *
+ * Had a single GL buffer been updated in place, each of these copies would have forced the GL
+ * engine to wait for the draw calls of the previous frame to complete.
+ */
+@property(nonatomic, readonly) GLuint stallsAvoided;
+
+/**
+ * The number of times the storage of a GL buffer has been orphaned, either when the buffer was
+ * reused, or because the content streamed during a frame overflowed the capacity of the buffer,
+ * since the statistics were last reset.
+ */
+@property(nonatomic, readonly) GLuint orphanCount;
+
+/**
+ * The number of times content could not be streamed because it was larger than the capacity
+ * of the GL buffers, since the statistics were last reset.
+ */
+@property(nonatomic, readonly) GLuint overflowCount;
+
+/** Resets the statistics counters to zero. */
+-(void) resetStatistics;
+
+/**
+ * The number of GL buffers in the ring of each vertex stream created by CC3OpenGLESVertexArrays.
+ *
+ * The initial value of this property is 3.
+ */
++(GLuint) defaultBufferCount;
+
+/** Sets the number of GL buffers in the ring of each vertex stream created by CC3OpenGLESVertexArrays. */
++(void) setDefaultBufferCount: (GLuint) buffCount;
+
+/**
+ * The capacity, in bytes, of each GL buffer in the ring of each vertex stream created by
+ * CC3OpenGLESVertexArrays.
+ *
+ * The initial value of this property is 1MB.
+ */
++(GLsizeiptr) defaultCapacity;
+
+/** Sets the capacity, in bytes, of each GL buffer in the ring of each vertex stream created by CC3OpenGLESVertexArrays. */
++(void) setDefaultCapacity: (GLsizeiptr) buffCapacity;
+
+@end
+
+
 #pragma mark -
 #pragma mark CC3OpenGLESVertexArrays
 
@@ -220,6 +446,9 @@
 @interface CC3OpenGLESVertexArrays : CC3OpenGLESStateTrackerManager {
 	CC3OpenGLESStateTrackerArrayBufferBinding* arrayBuffer;
 	CC3OpenGLESStateTrackerElementArrayBufferBinding* indexBuffer;
+	CC3OpenGLESVertexStream* arrayStream;
+	CC3OpenGLESVertexStream* indexStream;
+	NSMutableArray* pendingBufferDeletions;
 }
 
 /** Tracks vertex array buffer binding. */
@@ -236,6 +465,38 @@
  */
 -(CC3OpenGLESStateTrackerArrayBufferBinding*) bufferBinding: (GLenum) bufferTarget;
 
+/**
+ * The vertex stream used to stream vertex content that changes on every frame.
+ *
+ * The stream is created lazily the first time this property is accessed, using the values of
+ * the defaultBufferCount and defaultCapacity class-side properties of CC3OpenGLESVertexStream.
+ */
+@property(nonatomic, readonly) CC3OpenGLESVertexStream* arrayStream;
+
+/**
+ * The vertex stream used to stream vertex index content that changes on every frame.
+ *
+ * The stream is created lazily the first time this property is accessed, using the values of
+ * the defaultBufferCount and defaultCapacity class-side properties of CC3OpenGLESVertexStream.
+ */
+@property(nonatomic, readonly) CC3OpenGLESVertexStream* indexStream;
+
+/**
+ * Returns the vertex stream for the specified bufferTarget value.
+ *   - returns the stream in the arrayStream property if bufferTarget is GL_ARRAY_BUFFER
+ *   - returns the stream in the indexStream property if bufferTarget is GL_ELEMENT_ARRAY_BUFFER
+ *   - raises an assertion error if bufferTarget is any other value.
+ */
+-(CC3OpenGLESVertexStream*) streamForTarget: (GLenum) bufferTarget;
+
+/**
+ * Invokes the beginFrame method on each vertex stream that has been created.
+ *
+ * This method is invoked automatically by the CC3Scene at the start of each frame.
+ * Usually, the application never needs to invoke this method directly.
+ */
+-(void) beginStreamFrame;
+
 /**
  * Generates and returns a GL buffer ID.
  *
@@ -247,9 +508,22 @@
  * Deletes the GL buffer with the specifid buffer ID.
  *
  * This is a wrapper for the GL function glDeleteBuffers.
+ *
+ * This method may be invoked from any thread. If it is invoked from a thread other than the
+ * render thread of the CC3OpenGLESEngine, such as when a mesh is deallocated on a background
+ * thread, the buffer is queued, and is deleted when the deletePendingBuffers method is next
+ * invoked on the render thread.
  */
 -(void) deleteBuffer: (GLuint) buffID;
 
+/**
+ * Deletes any GL buffers whose deletion was requested from a thread other than the render thread.
+ *
+ * This method is invoked automatically by the CC3Scene at the start of each frame.
+ * Usually, the application never needs to invoke this method directly.
+ */
+-(void) deletePendingBuffers;
+
 /** Returns the vertex pointer tracker for the specified vertex array semantic. */
 -(CC3OpenGLESStateTrackerVertexPointer*) vertexPointerForSemantic: (GLenum) semantic;
 
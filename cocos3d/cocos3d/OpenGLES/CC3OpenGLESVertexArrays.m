@@ -30,6 +30,7 @@
  */
 
 #import "CC3OpenGLESVertexArrays.h"
+#import "CC3OpenGLESEngine.h"
 #import "CC3CC2Extensions.h"
 
 #pragma mark -
@@ -37,7 +38,7 @@
 
 @implementation CC3OpenGLESStateTrackerArrayBufferBinding
 
-@synthesize queryName;
+@synthesize queryName, bytesLoaded;
 
 +(CC3GLESStateOriginalValueHandling) defaultOriginalValueHandling {
 	return kCC3GLESStateOriginalValueReadOnceAndRestore;
@@ -60,6 +61,7 @@
 -(void) loadBufferData: (GLvoid*) buffPtr  ofLength: (GLsizeiptr) buffLen forUse: (GLenum) buffUsage {
 	ccGLBindVAO(0);		// Ensure that a VAO was not left in place by cocos2d
 	glBufferData(name, buffLen, buffPtr, buffUsage);
+	if (buffPtr) bytesLoaded += buffLen;
 	LogGLErrorTrace(@"while loading buffer data of length %i from %p for use %@ for %@",
 					buffLen, buffPtr, NSStringFromGLEnum(buffUsage), self);
 }
@@ -68,11 +70,22 @@
 			  startingAt: (GLintptr) offset
 			   forLength: (GLsizeiptr) length {
 	ccGLBindVAO(0);		// Ensure that a VAO was not left in place by cocos2d
-	glBufferSubData(name, offset, length, buffPtr);
-	LogGLErrorTrace(@"while updating buffer data of length %i at offset %i from %p for",
+	glBufferSubData(name, offset, length, ((GLbyte*)buffPtr + offset));
+	bytesLoaded += length;
+	LogGLErrorTrace(@"while updating buffer data of length %i at offset %i from %p for %@",
 					length, offset, buffPtr, self);
 }
 
+-(void) loadBufferData: (GLvoid*) dataPtr ofLength: (GLsizeiptr) length atOffset: (GLintptr) offset {
+	ccGLBindVAO(0);		// Ensure that a VAO was not left in place by cocos2d
+	glBufferSubData(name, offset, length, dataPtr);
+	bytesLoaded += length;
+	LogGLErrorTrace(@"while loading buffer data of length %i at offset %i from %p for %@",
+					length, offset, dataPtr, self);
+}
+
+-(void) resetBytesLoaded { bytesLoaded = 0; }
+
 @end
 
 
@@ -242,6 +255,177 @@
 @end
 
 
+#pragma mark -
+#pragma mark CC3OpenGLESVertexStream
+
+/** Aligns streamed content within the GL buffers, so that each vertex array starts on a word boundary. */
+#define kCC3VertexStreamAlignment	16
+
+@implementation CC3OpenGLESVertexStream
+
+@synthesize bufferCount, capacity, shouldOrphanOnReuse, frameCount, generation;
+@synthesize bytesStreamed, copyCount, reuseCount, stallsAvoided, orphanCount, overflowCount;
+
+-(void) dealloc {
+	[self deleteGLBuffers];
+	free(bufferIDs);
+	[super dealloc];
+}
+
+-(GLuint) currentBufferID { return bufferIDs[bufferIndex]; }
+
+-(id) initWithBufferBinding: (CC3OpenGLESStateTrackerArrayBufferBinding*) aBinding
+				bufferCount: (GLuint) buffCount
+				   capacity: (GLsizeiptr) buffCapacity {
+	if ( (self = [super init]) ) {
+		bufferBinding = aBinding;
+		bufferCount = MAX(buffCount, 1);
+		bufferIDs = calloc(bufferCount, sizeof(GLuint));
+		bufferIndex = 0;
+		capacity = buffCapacity;
+		writeOffset = 0;
+		lastData = NULL;
+		lastLength = 0;
+		lastOffset = 0;
+		lastGeneration = 0;
+		frameCount = 0;
+		generation = 0;
+		shouldOrphanOnReuse = YES;
+		needsOrphaning = NO;
+		didStreamInPreviousFrame = NO;
+		[self resetStatistics];
+	}
+	return self;
+}
+
++(id) streamWithBufferBinding: (CC3OpenGLESStateTrackerArrayBufferBinding*) aBinding
+				  bufferCount: (GLuint) buffCount
+					 capacity: (GLsizeiptr) buffCapacity {
+	return [[[self alloc] initWithBufferBinding: aBinding
+									bufferCount: buffCount
+									   capacity: buffCapacity] autorelease];
+}
+
+-(void) beginFrame {
+	didStreamInPreviousFrame = (writeOffset > 0);
+	bufferIndex = (bufferIndex + 1) % bufferCount;
+	needsOrphaning = shouldOrphanOnReuse && (bufferIDs[bufferIndex] != 0);
+	writeOffset = 0;
+	lastData = NULL;
+	lastLength = 0;
+	frameCount++;
+}
+
+/** Binds the GL buffer of the current frame, creating it first if necessary. */
+-(void) bindCurrentBuffer {
+	GLuint buffID = bufferIDs[bufferIndex];
+	if ( !buffID ) {
+		glGenBuffers(1, &buffID);
+		LogGLErrorTrace(@"%@ generate buffer ID", self);
+		bufferIDs[bufferIndex] = buffID;
+		bufferBinding.value = buffID;
+		[bufferBinding loadBufferData: NULL ofLength: capacity forUse: GL_DYNAMIC_DRAW];
+		needsOrphaning = NO;
+		LogTrace(@"%@ created GL buffer %u of %i bytes", self, buffID, capacity);
+	} else {
+		bufferBinding.value = buffID;
+	}
+}
+
+/** Orphans the storage of the currently bound GL buffer, so that the GL engine can allocate fresh storage. */
+-(void) orphanCurrentBuffer {
+	[bufferBinding loadBufferData: NULL ofLength: capacity forUse: GL_DYNAMIC_DRAW];
+	needsOrphaning = NO;
+	generation++;
+	orphanCount++;
+}
+
+-(GLuint) streamData: (GLvoid*) dataPtr
+			ofLength: (GLsizeiptr) length
+			toOffset: (GLintptr*) pOffset
+			canReuse: (BOOL) canReuse {
+	if (length > capacity) {
+		LogTrace(@"%@ cannot stream %i bytes, which exceeds its capacity of %i bytes", self, length, capacity);
+		overflowCount++;
+		return 0;
+	}
+
+	[self bindCurrentBuffer];
+
+	// Reuse the most recent copy if it holds the same content, such as interleaved vertex content
+	if (canReuse && dataPtr == lastData && length == lastLength && lastGeneration == generation) {
+		*pOffset = lastOffset;
+		reuseCount++;
+		return bufferIDs[bufferIndex];
+	}
+
+	if (needsOrphaning) [self orphanCurrentBuffer];
+
+	// If the content won't fit in the remaining space, orphan the buffer and start again from
+	// its beginning. Draw calls that have already been issued will continue to use the old storage.
+	GLintptr offset = (writeOffset + kCC3VertexStreamAlignment - 1) & ~(kCC3VertexStreamAlignment - 1);
+	if (offset + length > capacity) {
+		[self orphanCurrentBuffer];
+		offset = 0;
+	}
+
+	[bufferBinding loadBufferData: dataPtr ofLength: length atOffset: offset];
+	writeOffset = offset + length;
+	lastData = dataPtr;
+	lastLength = length;
+	lastOffset = offset;
+	lastGeneration = generation;
+
+	bytesStreamed += length;
+	copyCount++;
+	if (didStreamInPreviousFrame) stallsAvoided++;
+
+	*pOffset = offset;
+	return bufferIDs[bufferIndex];
+}
+
+-(void) deleteGLBuffers {
+	for (GLuint i = 0; i < bufferCount; i++) {
+		if (bufferIDs[i]) {
+			glDeleteBuffers(1, &bufferIDs[i]);
+			LogGLErrorTrace(@"%@ delete buffer %i", self, bufferIDs[i]);
+			bufferIDs[i] = 0;
+		}
+	}
+	writeOffset = 0;
+	lastData = NULL;
+	lastLength = 0;
+	generation++;
+}
+
+-(void) resetStatistics {
+	bytesStreamed = 0;
+	copyCount = 0;
+	reuseCount = 0;
+	stallsAvoided = 0;
+	orphanCount = 0;
+	overflowCount = 0;
+}
+
+static GLuint defaultBufferCount = 3;
+
++(GLuint) defaultBufferCount { return defaultBufferCount; }
+
++(void) setDefaultBufferCount: (GLuint) buffCount { defaultBufferCount = buffCount; }
+
+static GLsizeiptr defaultCapacity = (1 << 20);
+
++(GLsizeiptr) defaultCapacity { return defaultCapacity; }
+
++(void) setDefaultCapacity: (GLsizeiptr) buffCapacity { defaultCapacity = buffCapacity; }
+
+-(NSString*) description {
+	return [NSString stringWithFormat: @"%@ with %u buffers of %i bytes", [self class], bufferCount, capacity];
+}
+
+@end
+
+
 #pragma mark -
 #pragma mark CC3OpenGLESVertexArrays
 
@@ -253,9 +437,47 @@
 -(void) dealloc {
 	[arrayBuffer release];
 	[indexBuffer release];
+	[arrayStream release];
+	[indexStream release];
+	[pendingBufferDeletions release];
 	[super dealloc];
 }
 
+-(CC3OpenGLESVertexStream*) arrayStream {
+	if ( !arrayStream ) {
+		arrayStream = [[CC3OpenGLESVertexStream alloc] initWithBufferBinding: self.arrayBuffer
+																 bufferCount: [CC3OpenGLESVertexStream defaultBufferCount]
+																	capacity: [CC3OpenGLESVertexStream defaultCapacity]];
+	}
+	return arrayStream;
+}
+
+-(CC3OpenGLESVertexStream*) indexStream {
+	if ( !indexStream ) {
+		indexStream = [[CC3OpenGLESVertexStream alloc] initWithBufferBinding: self.indexBuffer
+																 bufferCount: [CC3OpenGLESVertexStream defaultBufferCount]
+																	capacity: [CC3OpenGLESVertexStream defaultCapacity]];
+	}
+	return indexStream;
+}
+
+-(CC3OpenGLESVertexStream*) streamForTarget: (GLenum) bufferTarget {
+	switch (bufferTarget) {
+		case GL_ARRAY_BUFFER:
+			return self.arrayStream;
+		case GL_ELEMENT_ARRAY_BUFFER:
+			return self.indexStream;
+		default:
+			NSAssert1(NO, @"Illegal buffer target %u", bufferTarget);
+			return nil;
+	}
+}
+
+-(void) beginStreamFrame {
+	[arrayStream beginFrame];
+	[indexStream beginFrame];
+}
+
 -(CC3OpenGLESStateTrackerArrayBufferBinding*) bufferBinding: (GLenum) bufferTarget {
 	switch (bufferTarget) {
 		case GL_ARRAY_BUFFER:
@@ -276,10 +498,30 @@
 }
 
 -(void) deleteBuffer: (GLuint) buffID  {
+	if ( ![CC3OpenGLESEngine isRenderThread] ) {
+		LogTrace(@"%@ deferring deletion of buffer %i to the render thread", self, buffID);
+		@synchronized(self) {
+			if ( !pendingBufferDeletions ) pendingBufferDeletions = [[NSMutableArray alloc] init];
+			[pendingBufferDeletions addObject: [NSNumber numberWithUnsignedInt: buffID]];
+		}
+		return;
+	}
 	glDeleteBuffers(1, &buffID);
 	LogGLErrorTrace(@"%@ delete buffer %i", self, buffID);
 }
 
+-(void) deletePendingBuffers {
+	@synchronized(self) {
+		if ( !pendingBufferDeletions.count ) return;
+		for (NSNumber* buffNum in pendingBufferDeletions) {
+			GLuint buffID = buffNum.unsignedIntValue;
+			glDeleteBuffers(1, &buffID);
+			LogGLErrorTrace(@"%@ delete pending buffer %i", self, buffID);
+		}
+		[pendingBufferDeletions removeAllObjects];
+	}
+}
+
 -(CC3OpenGLESStateTrackerVertexPointer*) vertexPointerForSemantic: (GLenum) semantic { return nil; }
 
 -(void) clearUnboundVertexPointers {}
@@ -42,6 +42,7 @@
 /** CC3OpenGLES2Shaders manages a tracker for each GLSL program object. */
 @interface CC3OpenGLES2Shaders : CC3OpenGLESShaders {
 	CC3GLProgram* _pureColorProgram;
+	CC3GLProgram* _shadowMapDepthProgram;
 }
 @end
 
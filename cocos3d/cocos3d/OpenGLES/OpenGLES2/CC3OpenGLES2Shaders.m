@@ -42,6 +42,10 @@
 #define kCC3PureColorVertexShaderSourceFile		@"CC3PureColor.vsh"
 #define kCC3PureColorFragmentShaderSourceFile	@"CC3PureColor.fsh"
 
+#define kCC3ShadowMapDepthGLProgramName				@"CC3ShadowMapDepthGLProgram"
+#define kCC3ShadowMapDepthVertexShaderSourceFile	@"CC3ShadowMapDepth.vsh"
+#define kCC3ShadowMapDepthFragmentShaderSourceFile	@"CC3ShadowMapDepth.fsh"
+
 
 #pragma mark -
 #pragma mark CC3OpenGLES2Shaders
@@ -50,6 +54,7 @@
 
 -(void) dealloc {
 	[_pureColorProgram release];
+	[_shadowMapDepthProgram release];
 	[super dealloc];
 }
 
@@ -82,15 +87,38 @@
 	[_pureColorProgram link];
 }
 
+-(void) makeShadowMapDepthProgram {
+	// retained
+	_shadowMapDepthProgram = [[CC3GLProgram alloc] initWithName: kCC3ShadowMapDepthGLProgramName
+											fromVertexShaderFile: kCC3ShadowMapDepthVertexShaderSourceFile
+										   andFragmentShaderFile: kCC3ShadowMapDepthFragmentShaderSourceFile];
+	_shadowMapDepthProgram.semanticDelegate = [CC3GLProgramSemanticsDelegateByVarNames sharedDefaultDelegate];
+	[_shadowMapDepthProgram link];
+}
+
 
 #pragma mark Binding
 
+-(CC3GLProgram*) pureColorProgram { return _pureColorProgram; }
+
 -(void) bindPureColorProgramWithVisitor: (CC3NodeDrawingVisitor*) visitor {
 	[_pureColorProgram bindWithVisitor: visitor fromContext: nil];
 }
 
+/** The shadow map depth program is created lazily, since most scenes do not use shadow maps. */
+-(void) bindShadowMapDepthProgramWithVisitor: (CC3NodeDrawingVisitor*) visitor {
+	if ( !_shadowMapDepthProgram ) [self makeShadowMapDepthProgram];
+	[_shadowMapDepthProgram bindWithVisitor: visitor fromContext: nil];
+}
+
 -(void) unbind { ccGLUseProgram(0); }
 
+/** Also discards the program that cocos2d caches as being in use. */
+-(void) invalidateProgramState {
+	[super invalidateProgramState];
+	ccGLInvalidateStateCache();
+}
+
 
 #pragma mark Allocation and initialization
 
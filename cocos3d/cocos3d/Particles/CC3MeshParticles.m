@@ -369,7 +369,7 @@
 -(CC3MeshParticleEmitter*) emitter { return (CC3MeshParticleEmitter*)emitter; }
 
 -(void) setEmitter: (CC3MeshParticleEmitter*) anEmitter {
-	NSAssert1([anEmitter isKindOfClass: [CC3MeshParticleEmitter class]], @"%@ may only be emitted by a CC3MeshParticleEmitter.", self);
+	NSAssert1(!anEmitter || [anEmitter isKindOfClass: [CC3MeshParticleEmitter class]], @"%@ may only be emitted by a CC3MeshParticleEmitter.", self);
 	super.emitter = anEmitter;
 }
 
@@ -31,9 +31,10 @@
 
 #import "CC3MeshNode.h"
 #import "CC3VertexArrayMesh.h"
+#import "CC3ObjectPool.h"
 
 
-@class CC3ParticleEmitter, CC3ParticleNavigator;
+@class CC3ParticleEmitter, CC3ParticleNavigator, CC3ParticlePool;
 
 
 #pragma mark -
@@ -384,6 +385,7 @@ static const NSUInteger kCC3ParticlesNoMax = UINT_MAX;
 	CCArray* particles;
 	CC3ParticleNavigator* particleNavigator;
 	Class particleClass;
+	CC3ParticlePool* particlePool;
 	NSUInteger maximumParticleCapacity;
 	NSUInteger particleCapacityExpansionIncrement;
 	NSUInteger particleCount;
@@ -419,6 +421,26 @@ static const NSUInteger kCC3ParticlesNoMax = UINT_MAX;
  */
 @property(nonatomic, assign) Class particleClass;
 
+/**
+ * An optional pool of particles, from which this emitter acquires new particles, and into which
+ * this emitter recycles its particles when it no longer needs them.
+ *
+ * Expired particles are always cached by this emitter for reuse by subsequent emissions. However,
+ * when this emitter is stopped or deallocated, those cached particles are normally discarded. If
+ * this property is set, they are instead returned to this pool, so that they can be reused by
+ * other emitters, such as short-lived emitters of explosions or impacts that are frequently added
+ * to and removed from the scene. Expired particles discarded by this emitter to make room for
+ * particles injected from outside this emitter are also returned to this pool.
+ *
+ * The same pool may be shared by any number of emitters, as long as the particleClass of the
+ * pool is compatible with the requiredParticleProtocol of each emitter and particle navigator.
+ * This property is copied by reference when this emitter is copied.
+ *
+ * The initial value of this property is nil, and particles are created directly from the
+ * particleClass property.
+ */
+@property(nonatomic, retain) CC3ParticlePool* particlePool;
+
 /**
  * The protocol required for particles emitted by this emitter.
  *
@@ -647,6 +669,9 @@ static const NSUInteger kCC3ParticlesNoMax = UINT_MAX;
  * Particles that have already been emitted will no longer be updated and displayed,
  * effectively causing those particles to abruptly disappear from view.
  *
+ * All particles held by this emitter are released. If the particlePool property is set,
+ * those particles are recycled into that pool.
+ *
  * Particle emission can be restarted by invoking the play method again.
  *
  * In most cases, for best visual effect, you should use the pause method instead
@@ -814,7 +839,9 @@ static const NSUInteger kCC3ParticlesNoMax = UINT_MAX;
  * The returned particle can subsequently be emitted from this emitter using the emitParticle: method.
  *
  * Distinct from the acquireParticle method, this method bypasses the reuse of expired particles
- * and always creates a new autoreleased particle instance.
+ * within this emitter and always returns a particle that is not held by this emitter. If the
+ * particlePool property is set, the particle is acquired from that pool, otherwise a new
+ * autoreleased particle instance is created.
  */
 -(id<CC3ParticleProtocol>) makeParticle;
 
@@ -1287,3 +1314,53 @@ static const NSUInteger kCC3ParticlesNoMax = UINT_MAX;
 
 @end
 
+
+#pragma mark -
+#pragma mark CC3ParticlePool
+
+/**
+ * CC3ParticlePool is a CC3ObjectPool that holds particles of a particular class, so that particles
+ * released by one CC3ParticleEmitter can be reused by the same or another emitter, instead of
+ * being deallocated and reinstantiated.
+ *
+ * To use a particle pool, set it into the particlePool property of one or more emitters. Each
+ * emitter will acquire new particles from the pool, and will recycle its particles into the pool
+ * when it is stopped or deallocated.
+ *
+ * When a particle is recycled into this pool, it is detached from its emitter, and its isAlive
+ * property is set to NO. All other particle state is established by the emitter when the
+ * particle is emitted again.
+ */
+@interface CC3ParticlePool : CC3ObjectPool {
+	Class particleClass;
+}
+
+/**
+ * The class of particle created by this pool when there are no free particles available.
+ *
+ * This class must implement the CC3ParticleProtocol, as well as the protocols required by
+ * each emitter and particle navigator that acquires particles from this pool.
+ */
+@property(nonatomic, assign, readonly) Class particleClass;
+
+/**
+ * Returns an autoreleased particle, either by removing a free particle from this pool, or by
+ * instantiating a new particle of the class indicated by the particleClass property.
+ */
+-(id<CC3ParticleProtocol>) acquireParticle;
+
+/**
+ * Returns the specified particle to this pool, once it is no longer held by an emitter.
+ *
+ * The particle is detached from its emitter, and is held for reuse. If this pool is full,
+ * the particle is discarded instead.
+ */
+-(void) recycleParticle: (id<CC3ParticleProtocol>) aParticle;
+
+/** Initializes this instance to hold particles of the specified class. */
+-(id) initForClass: (Class) aParticleClass;
+
+/** Allocates and initializes an autoreleased instance to hold particles of the specified class. */
++(id) poolForClass: (Class) aParticleClass;
+
+@end
@@ -55,6 +55,7 @@
 -(void) updateParticlesAfterTransform: (CC3NodeUpdatingVisitor*) visitor;
 -(void) finalizeAndRemoveParticle: (id<CC3ParticleProtocol>) aParticle atIndex: (NSUInteger) anIndex;
 -(void) removeParticle: (id<CC3ParticleProtocol>) aParticle atIndex: (NSUInteger) anIndex;
+-(void) recycleAllParticles;
 @end
 
 @implementation CC3ParticleEmitter
@@ -63,10 +64,12 @@
 @synthesize maximumParticleCapacity, particleCapacityExpansionIncrement;
 @synthesize emissionDuration, emissionInterval, elapsedTime;
 @synthesize isEmitting, shouldRemoveOnFinish;
-@synthesize shouldUpdateParticlesBeforeTransform, shouldUpdateParticlesAfterTransform;
+@synthesize shouldUpdateParticlesBeforeTransform, shouldUpdateParticlesAfterTransform, particlePool;
 
 -(void) dealloc {
+	[self recycleAllParticles];
 	[particles release];
+	[particlePool release];
 	[particleNavigator release];
 	particleClass = nil;		// not retained
 	[super dealloc];
@@ -150,11 +153,12 @@
 		shouldUpdateParticlesBeforeTransform = YES;
 		shouldUpdateParticlesAfterTransform = NO;
 		particleClass = nil;
+		particlePool = nil;
 	}
 	return self;
 }
 
-/** Particles are not copied. */
+/** Particles are not copied. The particle pool is shared. */
 -(void) populateFrom: (CC3ParticleEmitter*) another {
 	[super populateFrom: another];
 
@@ -170,6 +174,7 @@
 	shouldUpdateParticlesBeforeTransform = another.shouldUpdateParticlesBeforeTransform;
 	shouldUpdateParticlesAfterTransform = another.shouldUpdateParticlesAfterTransform;
 	self.particleClass = another.particleClass;
+	self.particlePool = another.particlePool;
 }
 
 -(NSString*) fullDescription {
@@ -324,14 +329,19 @@
 
 	// Avoid expanding unless necessary, by removing an expired particle if we're at capacity. This allows
 	// us to efficiently reuse expired particles, while allowing new particles to be injected from outside.
-	if (particles.count == particles.capacity && particleCount < particles.count) [particles removeLastObject];
+	if (particles.count == particles.capacity && particleCount < particles.count) {
+		[particlePool recycleParticle: [particles lastObject]];
+		[particles removeLastObject];
+	}
 	[particles insertObject: aParticle atIndex: particleCount];
 	
 	aParticle.emitter = self;
 }
 
-/** Template method to create a new particle using the particleClass property. */
--(id<CC3ParticleProtocol>) makeParticle { return [particleClass particle]; }
+/** Template method to create a new particle using the particle pool or the particleClass property. */
+-(id<CC3ParticleProtocol>) makeParticle {
+	return particlePool ? [particlePool acquireParticle] : [particleClass particle];
+}
 
 -(void) initializeParticle: (id<CC3ParticleProtocol>) aParticle {}
 
@@ -399,9 +409,16 @@
 -(void) stop {
 	[self pause];						// Stop emitting particles...
 	[self removeAllParticles];			// ...and kill those already emitted.
+	[self recycleAllParticles];
 	[particles removeAllObjects];
 }
 
+/** If a particle pool is in use, recycles all particles, living or expired, into that pool. */
+-(void) recycleAllParticles {
+	if ( !particlePool ) return;
+	for (id<CC3ParticleProtocol> aParticle in particles) [particlePool recycleParticle: aParticle];
+}
+
 -(BOOL) isActive { return isEmitting || particleCount > 0; }
 
 // Check for wasStarted needed so it doesn't indicate finished before it starts.
@@ -961,3 +978,52 @@
 -(void) updateAfterTransform: (CC3NodeUpdatingVisitor*) visitor {}
 
 @end
+
+
+#pragma mark -
+#pragma mark CC3ParticlePool
+
+@implementation CC3ParticlePool
+
+-(void) dealloc {
+	particleClass = nil;		// not retained
+	[super dealloc];
+}
+
+-(Class) particleClass { return particleClass; }
+
+-(id<CC3ParticleProtocol>) acquireParticle { return [self acquireObject]; }
+
+-(void) recycleParticle: (id<CC3ParticleProtocol>) aParticle { [self recycleObject: aParticle]; }
+
+/** Creates a new particle of the class indicated by the particleClass property. */
+-(id) makeObject { return [particleClass particle]; }
+
+/** Detaches the particle from its emitter. */
+-(BOOL) resetObject: (id<CC3ParticleProtocol>) aParticle {
+	aParticle.isAlive = NO;
+	aParticle.emitter = nil;
+	return YES;
+}
+
+
+#pragma mark Allocation and initialization
+
+-(id) init { return [self initForClass: nil]; }
+
+-(id) initForClass: (Class) aParticleClass {
+	NSAssert2([aParticleClass conformsToProtocol: @protocol(CC3ParticleProtocol)],
+			  @"%@ does not conform to the CC3ParticleProtocol protocol, and cannot be held by %@.", aParticleClass, [self class]);
+	if ( (self = [super init]) ) {
+		particleClass = aParticleClass;
+	}
+	return self;
+}
+
++(id) poolForClass: (Class) aParticleClass { return [[[self alloc] initForClass: aParticleClass] autorelease]; }
+
+-(NSString*) description {
+	return [NSString stringWithFormat: @"%@ of %@", [super description], particleClass];
+}
+
+@end
@@ -469,6 +469,11 @@ static GLfloat deviceScaleFactor = 0.0f;
 @interface CC3VertexArrayMesh (TemplateMethods)
 -(void) createVertexContent: (CC3VertexContent) vtxContentTypes;
 -(void) updateGLBuffersStartingAt: (GLuint) offsetIndex forLength: (GLuint) elemCount;
+-(void) populateVertexBindingsOf: (CC3DrawCommand*) aCommand withVisitor: (CC3NodeDrawingVisitor*) visitor;
+-(void) addVertexArray: (CC3VertexArray*) vtxArray
+		 toDrawCommand: (CC3DrawCommand*) aCommand
+		   withVisitor: (CC3NodeDrawingVisitor*) visitor;
+-(void) markDrawingChangedFromVertexArray: (CC3VertexArray*) oldArray;
 @end
 
 @implementation CC3PointParticleMesh
@@ -486,6 +491,7 @@ static GLfloat deviceScaleFactor = 0.0f;
 -(CC3VertexPointSizes*) vertexPointSizes { return vertexPointSizes; }
 
 -(void) setVertexPointSizes: (CC3VertexPointSizes*) vtxSizes {
+	[self markDrawingChangedFromVertexArray: vertexPointSizes];
 	[vertexPointSizes autorelease];
 	vertexPointSizes = [vtxSizes retain];
 	[vertexPointSizes deriveNameFrom: self];
@@ -566,6 +572,7 @@ static GLfloat deviceScaleFactor = 0.0f;
  */
 -(void) createGLBuffers {
 	[super createGLBuffers];
+	if ( !CC3OpenGLESEngine.isRenderThread ) return;		// Deferred to the rendering thread
 	if (shouldInterleaveVertices) {
 		vertexPointSizes.bufferID = vertexLocations.bufferID;
 	} else {
@@ -642,6 +649,9 @@ static GLfloat deviceScaleFactor = 0.0f;
 	vertexPointSizes.vertexCount = vCount;
 }
 
+/** Particle content is updated dynamically, and only partially in use, so it is not quantized. */
+-(BOOL) quantizeVertexContent { return NO; }
+
 -(GLfloat) vertexPointSizeAt: (GLuint) vtxIndex {
 	return vertexPointSizes ? [vertexPointSizes pointSizeAt: vtxIndex] : 0.0f;
 }
@@ -662,7 +672,9 @@ static GLfloat deviceScaleFactor = 0.0f;
 
 -(void) updateGLBuffersStartingAt: (GLuint) offsetIndex forLength: (GLuint) vertexCount {
 	[super updateGLBuffersStartingAt: offsetIndex forLength: vertexCount];
-	if (!shouldInterleaveVertices) {
+	if (shouldInterleaveVertices) {
+		[vertexPointSizes markVerticesCleanStartingAt: offsetIndex forLength: vertexCount];
+	} else {
 		[vertexPointSizes updateGLBufferStartingAt: offsetIndex forLength: vertexCount];
 	}
 }
@@ -675,6 +687,13 @@ static GLfloat deviceScaleFactor = 0.0f;
 	[vertexPointSizes bindWithVisitor: visitor];
 }
 
+-(void) populateVertexBindingsOf: (CC3DrawCommand*) aCommand withVisitor: (CC3NodeDrawingVisitor*) visitor {
+	[super populateVertexBindingsOf: aCommand withVisitor: visitor];
+	[self addVertexArray: vertexPointSizes toDrawCommand: aCommand withVisitor: visitor];
+}
+
+-(GLuint) drawingVersion { return super.drawingVersion + vertexPointSizes.drawingVersion; }
+
 @end
 
 
@@ -691,7 +710,7 @@ static GLfloat deviceScaleFactor = 0.0f;
 -(CC3PointParticleEmitter*) emitter { return (CC3PointParticleEmitter*)emitter; }
 
 -(void) setEmitter: (CC3PointParticleEmitter*) anEmitter {
-	NSAssert1([anEmitter isKindOfClass: [CC3PointParticleEmitter class]], @"%@ may only be emitted by a CC3PointParticleEmitter.", self);
+	NSAssert1(!anEmitter || [anEmitter isKindOfClass: [CC3PointParticleEmitter class]], @"%@ may only be emitted by a CC3PointParticleEmitter.", self);
 	super.emitter = anEmitter;
 }
 
@@ -128,7 +128,7 @@ static BOOL defaultExpectsVerticallyFlippedTextures = YES;
 static GLuint lastAssignedResourceTag;
 
 -(GLuint) nextTag {
-	return ++lastAssignedResourceTag;
+	return CC3IncrementTagCounter(&lastAssignedResourceTag);
 }
 
 +(void) resetTagAllocation {
@@ -45,7 +45,7 @@ static const ccTime kCC3DefaultMaximumUpdateInterval = (1.0 / 15.0);
 /** Default color for the ambient scene light. */
 static const ccColor4F kCC3DefaultLightColorAmbientScene = { 0.2, 0.2, 0.2, 1.0 };
 
-@class CC3Layer, CC3TouchedNodePicker, CC3ViewportManager;
+@class CC3Layer, CC3TouchedNodePicker, CC3ViewportManager, CC3BillboardBatch, CC3LightAssigner;
 
 
 #pragma mark -
@@ -233,6 +233,8 @@ static const ccColor4F kCC3DefaultLightColorAmbientScene = { 0.2, 0.2, 0.2, 1.0
 	CCArray* targettingNodes;
 	CCArray* lights;
 	CCArray* billboards;
+	NSMutableDictionary* nodesByName;
+	NSMutableDictionary* nodesByTag;
 	CC3Layer* cc3Layer;
 	CC3ViewportManager* viewportManager;
 	CC3Camera* activeCamera;
@@ -242,12 +244,17 @@ static const ccColor4F kCC3DefaultLightColorAmbientScene = { 0.2, 0.2, 0.2, 1.0
 	CC3NodeUpdatingVisitor* updateVisitor;
 	CC3NodeDrawingVisitor* drawVisitor;
 	CC3NodeDrawingVisitor* shadowVisitor;
+	CC3NodeDrawingVisitor* shadowMapVisitor;
 	CC3NodeTransformingVisitor* transformVisitor;
 	CC3NodeSequencerVisitor* drawingSequenceVisitor;
+	CC3BillboardBatch* billboardBatch;
 	CC3Fog* fog;
+	CC3LightAssigner* lightAssigner;
 	ccColor4F ambientLight;
 	ccTime minUpdateInterval;
 	ccTime maxUpdateInterval;
+	GLuint drawingChangeCount;
+	GLuint lastDrawingChangeCount;
 	BOOL shouldClearDepthBufferBefore3D : 1;
 	BOOL shouldClearDepthBufferBefore2D : 1;
 }
@@ -309,6 +316,36 @@ static const ccColor4F kCC3DefaultLightColorAmbientScene = { 0.2, 0.2, 0.2, 1.0
  */
 @property(nonatomic, readonly) CCArray* lights;
 
+/**
+ * Returns the descendant nodes of this scene that have the specified name, in the order in
+ * which they are visited in a depth-first traversal, or nil if no descendant has that name.
+ *
+ * This method does not traverse the node hierarchy. This scene maintains an index of its
+ * descendant nodes by name, which is updated automatically as nodes are added to and
+ * removed from this scene, and whenever the name of a descendant node is changed.
+ *
+ * This index is used by the getNodeNamed: method to locate nodes without a full traversal,
+ * when that method is invoked on this scene, or on any of its descendants.
+ *
+ * This is a read-only convenience method. You should not change the contents of the returned array.
+ */
+-(CCArray*) nodesNamed: (NSString*) aName;
+
+/**
+ * Returns the descendant nodes of this scene that have the specified tag, in the order in
+ * which they are visited in a depth-first traversal, or nil if no descendant has that tag.
+ *
+ * This method does not traverse the node hierarchy. This scene maintains an index of its
+ * descendant nodes by tag, which is updated automatically as nodes are added to and
+ * removed from this scene, and whenever the tag of a descendant node is changed.
+ *
+ * This index is used by the getNodeTagged: method to locate nodes without a full traversal,
+ * when that method is invoked on this scene, or on any of its descendants.
+ *
+ * This is a read-only convenience method. You should not change the contents of the returned array.
+ */
+-(CCArray*) nodesTagged: (GLuint) aTag;
+
 /**
  * The touchedNodePicker picks the node under the point at which a touch event occurred.
  *
@@ -386,6 +423,19 @@ static const ccColor4F kCC3DefaultLightColorAmbientScene = { 0.2, 0.2, 0.2, 1.0
  */
 @property(nonatomic, retain) CC3Fog* fog;
 
+/**
+ * If set, selects the lights that most influence each node, and binds only those lights
+ * to the GL engine while that node is drawn.
+ *
+ * Setting this property allows the scene to contain more lights than the platform supports,
+ * and avoids lighting each node with lights that are too distant to illuminate it. See the
+ * notes for CC3LightAssigner for more information.
+ *
+ * The initial value is nil, indicating that every visible light in the scene will be turned
+ * on at the start of each frame, and will illuminate every node.
+ */
+@property(nonatomic, retain) CC3LightAssigner* lightAssigner;
+
 
 #pragma mark Allocation and initialization
 
@@ -736,6 +786,57 @@ static const ccColor4F kCC3DefaultLightColorAmbientScene = { 0.2, 0.2, 0.2, 1.0
  */
 -(id) drawVisitorClass;
 
+/**
+ * Indicates whether the drawVisitor should record the nodes to be drawn into a draw command
+ * list, and replay that list to the GL engine once the traversal is complete.
+ *
+ * When this property is set to YES, if nothing that affects which nodes are drawn, or the
+ * order in which they are drawn, has changed since the previous frame, the command list
+ * recorded on the previous frame is replayed without traversing the scene, and without
+ * performing culling or sequencing again. This is a significant saving for scenes with
+ * many nodes that are viewed from a static camera.
+ *
+ * Changes to the transform, bounding volume or visibility of any node in this scene (see
+ * the drawingChangeCount property), to the camera projection, or to the structure or drawing
+ * sequence of this scene, cause the scene to be traversed again on the next frame. Changes to
+ * the drawing state of a node, or to its mesh or material, do not require the scene to be
+ * traversed again. Instead, only the commands for the nodes that have changed are populated
+ * again, and the commands for the remaining nodes are reused from the previous frame.
+ *
+ * Setting this property to YES sets the commandList property of the drawVisitor to a new
+ * CC3DrawCommandList. Setting this property to NO sets the commandList property of the
+ * drawVisitor to nil. See the notes for the commandList property of CC3NodeDrawingVisitor
+ * for more information, including using a headless executor to record command lists
+ * for comparison in tests.
+ *
+ * The initial value of this property is NO.
+ */
+@property(nonatomic, assign) BOOL shouldUseDrawCommandList;
+
+/**
+ * Returns a count that is incremented whenever the transform, bounding volume or visibility
+ * of any node in this scene changes, or when any other change that affects which nodes are
+ * drawn is indicated by invoking the markDrawingChanged method on a node in this scene.
+ *
+ * This scene compares this value from frame to frame, to determine whether the draw command
+ * list of the drawVisitor can be replayed without traversing this scene again.
+ */
+@property(nonatomic, readonly) GLuint drawingChangeCount;
+
+/**
+ * The billboard batch that is used to align the billboards in this scene to the active camera
+ * during each update, and to draw the 2D overlay billboards after the 3D scene has been drawn.
+ *
+ * The batch projects the locations of all 2D overlay billboards in a single pass, and culls
+ * those that are behind the camera or outside the layer. To also draw 2D overlay billboards
+ * whose 2D nodes are sprites sharing a texture atlas as a single batch of quads, set the
+ * shouldBatchSprites property of this batch to YES. See the notes of the CC3BillboardBatch
+ * class for more information.
+ *
+ * This property defaults to an instance of CC3BillboardBatch.
+ */
+@property(nonatomic, retain) CC3BillboardBatch* billboardBatch;
+
 /**
  * The visitor that is used to visit shadow nodes to draw them to the GL engine.
  *
@@ -744,6 +845,16 @@ static const ccColor4F kCC3DefaultLightColorAmbientScene = { 0.2, 0.2, 0.2, 1.0
  */
 @property(nonatomic, retain) CC3NodeDrawingVisitor* shadowVisitor;
 
+/**
+ * The visitor that is used to draw the shadow-casting nodes into the shadow maps of
+ * any lights whose shadowTechnique is set to kCC3ShadowTechniqueShadowMap.
+ *
+ * If not set directly, this property is lazily set to an instance of the
+ * CC3ShadowMapDrawingVisitor class the first time a shadow map is drawn.
+ * The application can set a different visitor if desired.
+ */
+@property(nonatomic, retain) CC3NodeDrawingVisitor* shadowMapVisitor;
+
 /**
  * The sequencer visitor used to visit the drawing sequencer during operations
  * on the drawing sequencer, such as adding or removing individual nodes.
@@ -768,6 +879,9 @@ static const ccColor4F kCC3DefaultLightColorAmbientScene = { 0.2, 0.2, 0.2, 1.0
  * corresponding state change tracker in the CC3OpenGLESEngine singleton. Route the
  * state change request through the CC3OpenGLESEngine singleton instead.
  *
+ * Before drawing, if the sharedLoader of CC3TextureLoader is in use, this method invokes its
+ * uploadWithinBudget method, to upload texture content that has been loaded in the background.
+ *
  * This method is invoked automatically during each rendering frame. Usually, the application
  * never needs to invoke this method directly.
  */
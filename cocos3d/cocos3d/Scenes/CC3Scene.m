@@ -34,9 +34,12 @@
 #import "CC3MeshNode.h"
 #import "CC3VertexArrayMesh.h"
 #import "CC3Material.h"
+#import "CC3TextureLoader.h"
 #import "CC3Light.h"
+#import "CC3LightAssigner.h"
 #import "CC3Billboard.h"
 #import "CC3ShadowVolumes.h"
+#import "CC3ShadowMaps.h"
 #import "CC3AffineMatrix.h"
 #import "CC3OpenGLESEngine.h"
 #import "CC3CC2Extensions.h"
@@ -68,13 +71,19 @@
 -(void) close3DCamera;
 -(void) illuminate;
 -(void) drawFog;
+-(void) drawShadowMaps;
 -(void) drawShadows;
 -(void) draw2DBillboards;
 -(void) visitForDrawingWithVisitor: (CC3NodeDrawingVisitor*) visitor;
+-(void) checkDrawCommandList;
+-(void) syncDrawCommandList;
 -(void) checkNeedShadowVisitor;
 -(void) updateDrawSequence;
 -(BOOL) addToDrawingSequencer: (CC3Node*) aNode;
 -(BOOL) removeFromDrawingSequencer: (CC3Node*) aNode;
+-(void) addToNodeIndex: (CC3Node*) aNode;
+-(void) removeFromNodeIndex: (CC3Node*) aNode;
+-(void) insertNode: (CC3Node*) aNode intoIndexedNodes: (CCArray*) indexedNodes;
 @end
 
 
@@ -82,8 +91,8 @@
 
 @synthesize cc3Layer, activeCamera, ambientLight, minUpdateInterval, maxUpdateInterval;
 @synthesize touchedNodePicker, drawingSequencer, drawingSequenceVisitor;
-@synthesize drawVisitor, shadowVisitor, updateVisitor, transformVisitor;
-@synthesize viewportManager, performanceStatistics, fog, lights;
+@synthesize drawVisitor, shadowVisitor, shadowMapVisitor, updateVisitor, transformVisitor;
+@synthesize viewportManager, performanceStatistics, billboardBatch, fog, lights, lightAssigner;
 @synthesize shouldClearDepthBufferBefore3D, shouldClearDepthBufferBefore2D;
 
 /**
@@ -99,16 +108,23 @@
 	self.touchedNodePicker = nil;			// Use setter to release and make nil
 	self.drawVisitor = nil;					// Use setter to release and make nil
 	self.shadowVisitor = nil;				// Use setter to release and make nil
+	self.shadowMapVisitor = nil;			// Use setter to release and make nil
 	self.updateVisitor = nil;				// Use setter to release and make nil
 	self.transformVisitor = nil;			// Use setter to release and make nil
 	self.drawingSequenceVisitor = nil;		// Use setter to release and make nil
+	self.billboardBatch = nil;				// Use setter to release and make nil
 	self.fog = nil;							// Use setter to stop any actions
+	self.lightAssigner = nil;				// Use setter to release and make nil
 	[targettingNodes release];
 	targettingNodes = nil;
 	[lights release];
 	lights = nil;
 	[billboards release];
 	billboards = nil;
+	[nodesByName release];
+	nodesByName = nil;
+	[nodesByTag release];
+	nodesByTag = nil;
 	
     [super dealloc];
 }
@@ -166,17 +182,22 @@
 		targettingNodes = [[CCArray array] retain];
 		lights = [[CCArray array] retain];
 		billboards = [[CCArray array] retain];
+		nodesByName = [[NSMutableDictionary dictionary] retain];
+		nodesByTag = [[NSMutableDictionary dictionary] retain];
 		shouldClearDepthBufferBefore3D = YES;
 		shouldClearDepthBufferBefore2D = YES;
 		self.touchedNodePicker = [CC3TouchedNodePicker pickerOnScene: self];
 		self.drawingSequencer = [CC3BTreeNodeSequencer sequencerLocalContentOpaqueFirst];
 		self.viewportManager = [CC3ViewportManager viewportManagerOnScene: self];
 		self.drawVisitor = [[self drawVisitorClass] visitor];
+		drawVisitor.shouldTimeDrawingPhases = YES;
 		self.shadowVisitor = nil;
 		self.updateVisitor = [[self updateVisitorClass] visitor];
 		self.transformVisitor = [[self transformVisitorClass] visitor];
 		self.drawingSequenceVisitor = [CC3NodeSequencerVisitor visitorWithScene: self];
+		self.billboardBatch = [CC3BillboardBatch batch];
 		fog = nil;
+		lightAssigner = nil;
 		activeCamera = nil;
 		ambientLight = kCC3DefaultLightColorAmbientScene;
 		minUpdateInterval = kCC3DefaultMinimumUpdateInterval;
@@ -208,14 +229,22 @@
 	performanceStatistics = [another.performanceStatistics copy];		// retained
 
 	self.drawVisitor = [[another.drawVisitor class] visitor];			// retained
+	drawVisitor.shouldTimeDrawingPhases = YES;
 	self.shadowVisitor = [[another.shadowVisitor class] visitor];		// retained
 	self.updateVisitor = [[another.updateVisitor class] visitor];		// retained
 	self.transformVisitor = [[another.transformVisitor class] visitor];	// retained
 	self.drawingSequenceVisitor = [[another.drawingSequenceVisitor class] visitorWithScene: self];	// retained
+	self.shouldUseDrawCommandList = another.shouldUseDrawCommandList;
 	self.touchedNodePicker = [[another.touchedNodePicker class] pickerOnScene: self];		// retained
+	self.billboardBatch = [[another.billboardBatch class] batch];		// retained
+	billboardBatch.shouldBatchSprites = another.billboardBatch.shouldBatchSprites;
 
 	[fog release];
 	fog = [another.fog copy];											// retained
+
+	self.lightAssigner = [[another.lightAssigner class] assigner];		// retained
+	lightAssigner.maxLightsPerNode = another.lightAssigner.maxLightsPerNode;
+	lightAssigner.influenceThreshold = another.lightAssigner.influenceThreshold;
 	
 	ambientLight = another.ambientLight;
 	minUpdateInterval = another.minUpdateInterval;
@@ -261,17 +290,40 @@
 	LogTrace(@"******* %@ starting update: %.2f ms (clamped from %.2f ms)",
 			 self, dtClamped * 1000.0, dt * 1000.0);
 	
+	[performanceStatistics beginPhase: kCC3PerformancePhaseUpdate];
+
 	[touchedNodePicker dispatchPickedNode];
 	
+	[performanceStatistics beginPhase: kCC3PerformancePhaseUpdateNodes];
 	updateVisitor.deltaTime = dtClamped;
 	[updateVisitor visit: self];
+	[performanceStatistics endPhase: kCC3PerformancePhaseUpdateNodes];
 	
+	[performanceStatistics beginPhase: kCC3PerformancePhaseUpdateTargets];
 	[self updateTargets: dtClamped];
+	[performanceStatistics endPhase: kCC3PerformancePhaseUpdateTargets];
+
+	[performanceStatistics beginPhase: kCC3PerformancePhaseUpdateCamera];
 	[self updateCamera: dtClamped];
+	[performanceStatistics endPhase: kCC3PerformancePhaseUpdateCamera];
+
+	[performanceStatistics beginPhase: kCC3PerformancePhaseUpdateBillboards];
 	[self updateBillboards: dtClamped];
+	[performanceStatistics endPhase: kCC3PerformancePhaseUpdateBillboards];
+
+	[performanceStatistics beginPhase: kCC3PerformancePhaseUpdateFog];
 	[self updateFog: dtClamped];
+	[performanceStatistics endPhase: kCC3PerformancePhaseUpdateFog];
+
+	[performanceStatistics beginPhase: kCC3PerformancePhaseUpdateShadows];
 	[self updateShadows: dtClamped];
+	[performanceStatistics endPhase: kCC3PerformancePhaseUpdateShadows];
+
+	[performanceStatistics beginPhase: kCC3PerformancePhaseUpdateDrawSequence];
 	[self updateDrawSequence];
+	[performanceStatistics endPhase: kCC3PerformancePhaseUpdateDrawSequence];
+
+	[performanceStatistics endPhase: kCC3PerformancePhaseUpdate];
 	
 	LogTrace(@"******* %@ exiting update", self);
 }
@@ -305,21 +357,25 @@
 	[fog update: dt];
 }
 
-/** Template method to update shadows cast by the lights. */
+/**
+ * Template method to update shadows cast by the lights.
+ * Lights whose shadows cannot reach the camera frustum are skipped.
+ */
 -(void) updateShadows: (ccTime) dt {
+	CC3Frustum* frustum = activeCamera.frustum;
 	for (CC3Light* lgt in lights) {
+		if ( ![lgt doesShadowRangeIntersectFrustum: frustum] ) continue;
 		[lgt updateShadows];
+		if (lgt.isUsingShadowMap) [performanceStatistics addShadowCastersCulled: lgt.shadowMap.castersCulled];
 	}
 }
 
 /**
  * Template method to update any billboards.
- * Iterates through all billboards, instructing them to align with the camera if needed.
+ * Uses the billboard batch to align all billboards with the camera.
  */
 -(void) updateBillboards: (ccTime) dt {
-	for (CC3Billboard* bb in billboards) {
-		[bb alignToCamera: activeCamera];
-	}
+	[billboardBatch alignBillboards: billboards toCamera: activeCamera];
 	LogTrace(@"%@ updated %u billboards", self, billboards.count);
 }
 
@@ -343,20 +399,52 @@
 	LogTrace(@"******* %@ starting drawing visit", self);
 
 	[self collectFrameInterval];	// Collect the frame interval in the performance statistics.
+
+	[performanceStatistics beginPhase: kCC3PerformancePhaseTextureUpload];
+	if (CC3TextureLoader.hasSharedLoader) [CC3TextureLoader.sharedLoader uploadWithinBudget];
+	[performanceStatistics endPhase: kCC3PerformancePhaseTextureUpload];
 	
 	if (self.visible) {
+		[performanceStatistics beginPhase: kCC3PerformancePhaseDraw];
+
+		[performanceStatistics beginPhase: kCC3PerformancePhaseDrawSetup];
 		[self open3D];
 		[self openViewport];
 		[self open3DCamera];
+		[performanceStatistics endPhase: kCC3PerformancePhaseDrawSetup];
+
+		[performanceStatistics beginPhase: kCC3PerformancePhaseDrawShadowMaps];
+		[self drawShadowMaps];
+		[performanceStatistics endPhase: kCC3PerformancePhaseDrawShadowMaps];
+
+		[performanceStatistics beginPhase: kCC3PerformancePhaseNodePicking];
 		[touchedNodePicker pickTouchedNode];
+		[performanceStatistics endPhase: kCC3PerformancePhaseNodePicking];
+
+		[performanceStatistics beginPhase: kCC3PerformancePhaseIllumination];
 		[self illuminate];
 		[self drawFog];
+		[performanceStatistics endPhase: kCC3PerformancePhaseIllumination];
+
+		[performanceStatistics beginPhase: kCC3PerformancePhaseDrawNodes];
+		[self checkDrawCommandList];
 		[self visitForDrawingWithVisitor: drawVisitor];
+		[self syncDrawCommandList];
+		[performanceStatistics endPhase: kCC3PerformancePhaseDrawNodes];
+
+		[performanceStatistics beginPhase: kCC3PerformancePhaseDrawShadows];
 		[self drawShadows];
+		[performanceStatistics endPhase: kCC3PerformancePhaseDrawShadows];
+
 		[self close3DCamera];
 		[self closeViewport];
 		[self close3D];
+
+		[performanceStatistics beginPhase: kCC3PerformancePhaseDraw2DBillboards];
 		[self draw2DBillboards];	// Back to 2D now
+		[performanceStatistics endPhase: kCC3PerformancePhaseDraw2DBillboards];
+
+		[performanceStatistics endPhase: kCC3PerformancePhaseDraw];
 	}
 	
 	// Check and clear any GL error that occurred during 3D code
@@ -387,6 +475,13 @@
 	// Open tracking of GL state. Where needed, will cache current 2D GL state items
 	// for later reinstatement in the close3D method.
 	[glesEngine open];
+
+	// Move the vertex streams on to fresh GL buffers for the content streamed during this frame,
+	// delete any GL buffers released by meshes on other threads since the last frame, and
+	// perform the GL buffer work requested by meshes that were built or changed on other threads.
+	[glesEngine.vertices beginStreamFrame];
+	[glesEngine.vertices deletePendingBuffers];
+	[CC3OpenGLESEngine performPendingGLUpdates];
 	
 	// Ensure drawing is not slowed down by unexpected alpha testing and logic ops
 	CC3OpenGLESCapabilities* glesServCaps = glesEngine.capabilities;
@@ -443,8 +538,14 @@
 	// Set the ambient light for the whole scene
 	[CC3OpenGLESEngine engine].lighting.sceneAmbientLight.value = ambientLight;
 
-	// Turn on any individual lights
-	for (CC3Light* lgt in lights) [lgt turnOn];
+	// Turn on any individual lights, or, if a light assigner is in use, let it
+	// bind the most influential lights to the GL engine as each node is drawn.
+	if (lightAssigner) {
+		[lightAssigner prepareLights: lights];
+		[lightAssigner unbindLights];
+	} else {
+		for (CC3Light* lgt in lights) [lgt turnOn];
+	}
 }
 
 -(ccColor4F) totalIllumination {
@@ -473,12 +574,43 @@
 
 -(BOOL) doesContainShadows { return shadowVisitor != nil; }
 
+/**
+ * Template method to draw the shadow maps of the lights that use them. The first shadow map is
+ * bound to the last texture unit, and set into the drawVisitor, to be sampled by the shaders.
+ * Lights whose shadow range does not reach the camera frustum are counted by drawShadows.
+ */
+-(void) drawShadowMaps {
+	drawVisitor.shadowMap = nil;
+	if ( !self.doesContainShadows ) return;
+
+	CC3Frustum* frustum = activeCamera.frustum;
+	for (CC3Light* lgt in lights) {
+		if ( !lgt.isUsingShadowMap ) continue;
+		if ( !(lgt.visible || lgt.shouldCastShadowsWhenInvisible) ) continue;
+		if ( ![lgt doesShadowRangeIntersectFrustum: frustum] ) continue;
+
+		if ( !shadowMapVisitor ) self.shadowMapVisitor = [CC3ShadowMapDrawingVisitor visitor];
+		CC3ShadowMap* sm = lgt.shadowMap;
+		[sm drawWithVisitor: shadowMapVisitor];
+		if ( !drawVisitor.shadowMap && sm.textureID ) {
+			[sm bindToTextureUnit: (CC3OpenGLESEngine.engine.platform.maxTextureUnits.value - 1)];
+			drawVisitor.shadowMap = sm;
+		}
+	}
+}
+
 /** Template method to draw shadows cast by the lights. */
 -(void) drawShadows {
 	if (self.doesContainShadows) {
 		[CC3OpenGLESEngine engine].state.clearStencil = 0;
+		CC3Frustum* frustum = activeCamera.frustum;
 		for (CC3Light* lgt in lights) {
-			[lgt drawShadowsWithVisitor: shadowVisitor];
+			if ( !lgt.hasShadows ) continue;
+			if ([lgt doesShadowRangeIntersectFrustum: frustum]) {
+				[lgt drawShadowsWithVisitor: shadowVisitor];
+			} else {
+				[performanceStatistics incrementShadowLightsCulled];
+			}
 		}
 	}
 }
@@ -519,10 +651,7 @@
 			glesScissor.value = vp;
 		}
 		
-		CGRect lb = viewportManager.layerBoundsLocal;
-		for (CC3Billboard* bb in billboards) {
-			[bb draw2dWithinBounds: lb];
-		}
+		[billboardBatch drawBillboards: billboards withinBounds: viewportManager.layerBoundsLocal];
 		
 		// All done...turn scissoring back off now. This is happening after the
 		// close3D method, so we need to close the scissor trackers manually.
@@ -537,6 +666,7 @@
 -(void) visitForDrawingWithVisitor: (CC3NodeDrawingVisitor*) visitor {
 	visitor.shouldClearDepthBuffer = shouldClearDepthBufferBefore3D;
 	visitor.drawingSequencer = drawingSequencer;
+	visitor.lightAssigner = lightAssigner;
 	visitor.shouldVisitChildren = YES;
 	[visitor visit: self];
 }
@@ -545,6 +675,42 @@
 	return [CC3NodeDrawingVisitor class];
 }
 
+-(BOOL) shouldUseDrawCommandList { return (drawVisitor.commandList != nil); }
+
+-(void) setShouldUseDrawCommandList: (BOOL) shouldUse {
+	if (shouldUse == self.shouldUseDrawCommandList) return;
+	drawVisitor.commandList = shouldUse ? [CC3DrawCommandList commandList] : nil;
+}
+
+/**
+ * Template method that invalidates the command list of the drawVisitor if any node has
+ * been transformed, or has changed visibility, since the command list was last recorded.
+ */
+-(void) checkDrawCommandList {
+	GLuint changeCount = drawingChangeCount;
+	if (changeCount != lastDrawingChangeCount) {
+		[drawVisitor.commandList invalidate];
+		lastDrawingChangeCount = changeCount;
+	}
+}
+
+/**
+ * Bounding volumes are lazily rebuilt while the nodes are culled, which marks the drawing
+ * as changed. The command list recorded by that traversal already reflects those changes.
+ */
+-(void) syncDrawCommandList { lastDrawingChangeCount = drawingChangeCount; }
+
+-(GLuint) drawingChangeCount { return drawingChangeCount; }
+
+/**
+ * Overridden to count the change, instead of notifying the scene, since this is the scene.
+ * Nodes in this scene may be changed on any thread, so the count is incremented atomically.
+ */
+-(void) markDrawingChanged {
+	[self markDrawingContentChanged];
+	CC3IncrementChangeCounter(&drawingChangeCount);
+}
+
 
 #pragma mark Drawing sequencer
 
@@ -578,6 +744,7 @@
  * drawingSequencer and then re-add it.
  */
 -(void) descendantDidModifySequencingCriteria: (CC3Node*) aNode {
+	[drawVisitor.commandList invalidate];
 	if (drawingSequencer) {
 		if ([drawingSequencer remove: aNode withVisitor: drawingSequenceVisitor]) {
 			[drawingSequencer add: aNode withVisitor: drawingSequenceVisitor];
@@ -600,6 +767,8 @@
 -(void) didAddDescendant: (CC3Node*) aNode {
 	LogTrace(@"Adding %@ as descendant to %@", aNode, self);
 	
+	[drawVisitor.commandList invalidate];
+	
 	// Collect all the nodes being added, including all descendants,
 	// and see if they require special treatment
 	CCArray* allAdded = [aNode flatten];
@@ -608,6 +777,9 @@
 		// Attempt to add the node to the draw sequence sorter.
 		[drawingSequencer add: addedNode withVisitor: drawingSequenceVisitor];
 		
+		// Index the node by name and tag
+		[self addToNodeIndex: addedNode];
+		
 		// If the node has a target, add it to the collection of such nodes
 		if (addedNode.hasTarget) {
 			LogTrace(@"Adding targetting node %@", addedNode.fullDescription);
@@ -637,6 +809,9 @@
 -(void) didRemoveDescendant: (CC3Node*) aNode {
 	LogTrace(@"Removing %@ as descendant of %@", aNode, self);
 	
+	// The command list does not retain its nodes, so it must not be replayed.
+	[drawVisitor.commandList invalidate];
+	
 	// Collect all the nodes being removed, including all descendants,
 	// and see if they require special treatment
 	CCArray* allRemoved = [aNode flatten];
@@ -645,6 +820,9 @@
 		// Attempt to remove the node to the draw sequence sorter.
 		[drawingSequencer remove: removedNode withVisitor: drawingSequenceVisitor];
 		
+		// Remove the node from the name and tag index
+		[self removeFromNodeIndex: removedNode];
+		
 		// If the node has a target, remove it from the collection of such nodes
 		if (removedNode.hasTarget) {
 			LogTrace(@"Removing targetting node %@", removedNode);
@@ -679,6 +857,73 @@
 	}
 }
 
+/** The name or tag of a descendant is about to change. Remove it from the index under the old values. */
+-(void) willChangeIdentityOfDescendant: (CC3Node*) aNode { [self removeFromNodeIndex: aNode]; }
+
+/** The name or tag of a descendant has changed. Add it to the index under the new values. */
+-(void) didChangeIdentityOfDescendant: (CC3Node*) aNode { [self addToNodeIndex: aNode]; }
+
+/**
+ * Adds the specified node to the name and tag index, under its current name and tag.
+ * The nodes under each name and tag are kept in depth-first order.
+ */
+-(void) addToNodeIndex: (CC3Node*) aNode {
+	NSString* aName = aNode.name;
+	if (aName) {
+		CCArray* namedNodes = [nodesByName objectForKey: aName];
+		if ( !namedNodes ) {
+			namedNodes = [CCArray arrayWithCapacity: 1];
+			[nodesByName setObject: namedNodes forKey: aName];
+		}
+		[self insertNode: aNode intoIndexedNodes: namedNodes];
+	}
+
+	NSNumber* tagKey = [NSNumber numberWithUnsignedInt: aNode.tag];
+	CCArray* taggedNodes = [nodesByTag objectForKey: tagKey];
+	if ( !taggedNodes ) {
+		taggedNodes = [CCArray arrayWithCapacity: 1];
+		[nodesByTag setObject: taggedNodes forKey: tagKey];
+	}
+	[self insertNode: aNode intoIndexedNodes: taggedNodes];
+}
+
+/** Inserts the specified node into the specified depth-ordered array, using a binary search. */
+-(void) insertNode: (CC3Node*) aNode intoIndexedNodes: (CCArray*) indexedNodes {
+	NSUInteger lo = 0, hi = indexedNodes.count;
+	while (lo < hi) {
+		NSUInteger mid = (lo + hi) / 2;
+		if ([[indexedNodes objectAtIndex: mid] precedesInDepthFirstOrder: aNode]) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	[indexedNodes insertObject: aNode atIndex: lo];
+}
+
+/** Removes the specified node from the name and tag index, under its current name and tag. */
+-(void) removeFromNodeIndex: (CC3Node*) aNode {
+	NSString* aName = aNode.name;
+	if (aName) {
+		CCArray* namedNodes = [nodesByName objectForKey: aName];
+		[namedNodes removeObjectIdenticalTo: aNode];
+		if (namedNodes && namedNodes.count == 0) [nodesByName removeObjectForKey: aName];
+	}
+
+	NSNumber* tagKey = [NSNumber numberWithUnsignedInt: aNode.tag];
+	CCArray* taggedNodes = [nodesByTag objectForKey: tagKey];
+	[taggedNodes removeObjectIdenticalTo: aNode];
+	if (taggedNodes && taggedNodes.count == 0) [nodesByTag removeObjectForKey: tagKey];
+}
+
+-(CCArray*) nodesNamed: (NSString*) aName {
+	return aName ? [nodesByName objectForKey: aName] : nil;
+}
+
+-(CCArray*) nodesTagged: (GLuint) aTag {
+	return [nodesByTag objectForKey: [NSNumber numberWithUnsignedInt: aTag]];
+}
+
 /**
  * Check to see if any lights are casting shadows. If they are, ensure the shadowVisitor
  * exists. If no lights are casting a shadow, and the shadowVisitor exists, remove it.
@@ -33,6 +33,7 @@
 #import "CC3CC2Extensions.h"
 #import "CC3GLSLVariable.h"
 #import "CC3GLProgramSemantics.h"
+#import "CC3NodeVisitor.h"
 
 #if CC3_OGLES_2
 #import "CCGLProgram.h"
@@ -49,8 +50,10 @@
 	id<CC3GLProgramSemanticsDelegate> _semanticDelegate;
 	CCArray* _uniforms;
 	CCArray* _attributes;
+	CCArray* _scratchUniforms;
 	GLint _maxUniformNameLength;
 	GLint _maxAttributeNameLength;
+	GLuint _uniformStateVersion;
 }
 
 /**
@@ -104,6 +107,41 @@
  */
 -(void) bindWithVisitor: (CC3NodeDrawingVisitor*) visitor fromContext: (CC3GLProgramContext*) context;
 
+/**
+ * Captures the values of the uniforms whose values are derived from the node being drawn, such
+ * as the model matrix and the vertex content qualifiers, into the content of the specified draw
+ * command, so that the command can be replayed without messaging the node.
+ *
+ * Uniforms that are overridden by the shaderContext of the command, and uniforms whose values
+ * are derived from the GL engine state or the scene, are not captured, and are resolved when
+ * the command is replayed.
+ *
+ * The node must be the currentNode of the specified visitor. This method is invoked automatically
+ * when a draw command is populated. Usually, the application never needs to invoke this method
+ * directly. When using OpenGL ES 1, this method does nothing.
+ */
+-(void) populateDrawCommand: (CC3DrawCommand*) aCommand withVisitor: (CC3NodeDrawingVisitor*) visitor;
+
+/**
+ * Binds the program, and applies the uniforms for the specified draw command, using the uniform
+ * values captured in the command by the populateDrawCommand:withVisitor: method, and resolving the
+ * remaining uniforms from the shaderContext of the command, and then from the semanticDelegate.
+ *
+ * This method is invoked automatically when a draw command is replayed. Usually, the application
+ * never needs to invoke this method directly. When using OpenGL ES 1, this method does nothing.
+ */
+-(void) bindDrawCommand: (CC3DrawCommand*) aCommand withVisitor: (CC3NodeDrawingVisitor*) visitor;
+
+/**
+ * Marks the uniform values that have been cached by all programs as no longer reflecting the
+ * state of the GL engine. The next time each program is used, all of its cached uniform values
+ * are set in the GL engine, before the uniforms are populated for drawing.
+ *
+ * This method is invoked automatically by the invalidateProgramState method of the shaders
+ * tracker manager. Usually, the application never needs to invoke this method directly.
+ */
++(void) invalidateUniformState;
+
 /**
  * Links this program and uses the delegate in the semanticDelegate property to map
  * each uniform and attribute to its semantic meaning.
@@ -40,6 +40,10 @@
 -(void) setActiveProgram: (CC3GLProgram*) aProgram;
 @end
 
+@interface CC3OpenGLESStateTrackerGLSLUniform (TemplateMethods)
+-(void) setGLValue;
+@end
+
 @implementation CC3GLProgram
 
 @synthesize semanticDelegate=_semanticDelegate;
@@ -50,6 +54,7 @@
 	[_name release];
 	[_uniforms release];
 	[_attributes release];
+	[_scratchUniforms release];
 	[super dealloc];
 }
 
@@ -98,10 +103,27 @@
 	return nil;
 }
 
+// Incremented whenever the uniform values cached by programs no longer reflect the GL engine.
+static GLuint _currentUniformStateVersion = 0;
+
++(void) invalidateUniformState { _currentUniformStateVersion++; }
+
 #if CC3_OGLES_2
 
 #pragma mark Binding and linking
 
+/**
+ * Overridden to set all cached uniform values in the GL engine if they have been invalidated since
+ * this program was last used, so that uniforms whose values are unchanged are still set correctly.
+ */
+-(void) use {
+	[super use];
+	if (_uniformStateVersion != _currentUniformStateVersion) {
+		for (CC3OpenGLESStateTrackerGLSLUniform* var in _uniforms) [var setGLValue];
+		_uniformStateVersion = _currentUniformStateVersion;
+	}
+}
+
 // Cache this program in the GL state tracker, bind the program to the GL engine,
 // and populate the uniforms into the GL engine, allowing the context to override first.
 // Raise an assertion error if the uniform cannot be resolved by either context or delegate!
@@ -115,6 +137,99 @@
 			NSAssert3(NO, @"Could not resolve value of uniform %@ for %@ within context %@", var, self, context);
 }
 
+/**
+ * Returns whether the value of the specified uniform is derived from the node being drawn.
+ * The values of all other uniforms are derived from the GL engine state, or from the scene,
+ * and can be resolved by the semanticDelegate when a draw command is replayed.
+ */
+-(BOOL) isNodeUniform: (CC3GLSLUniform*) uniform {
+	switch (uniform.semantic) {
+		case kCC3SemanticHasVertexNormal:
+		case kCC3SemanticHasVertexColor:
+		case kCC3SemanticHasVertexTextureCoordinate:
+		case kCC3SemanticHasVertexPointSize:
+		case kCC3SemanticIsDrawingPoints:
+		case kCC3SemanticModelMatrix:
+		case kCC3SemanticModelMatrixInv:
+			return YES;
+		default:
+			return NO;
+	}
+}
+
+/**
+ * Returns the uniform, at the specified index, into which node values are populated when a draw
+ * command is populated. These are copies of the uniforms of this program that are not GL state
+ * trackers, so populating them does not change the GL engine. They are created lazily, since
+ * most programs are only ever bound live.
+ */
+-(CC3GLSLUniform*) scratchUniformAt: (GLuint) uIdx {
+	if ( !_scratchUniforms ) {
+		_scratchUniforms = [CCArray new];		// retained
+		for (CC3GLSLUniform* var in _uniforms) {
+			CC3GLSLUniform* scratchVar = [var copyAsClass: CC3GLSLUniform.class];
+			[_scratchUniforms addObject: scratchVar];
+			[scratchVar release];
+		}
+	}
+	return [_scratchUniforms objectAtIndex: uIdx];
+}
+
+/**
+ * The values are appended to the command one after the other, so that they can be located from
+ * the uniformValuesOffset of the command, and are recorded in the order of the uniforms.
+ */
+-(void) populateDrawCommand: (CC3DrawCommand*) aCommand withVisitor: (CC3NodeDrawingVisitor*) visitor {
+	CC3DrawCommandList* cmdList = visitor.commandList;
+	CC3GLProgramContext* context = aCommand->shaderContext;
+	aCommand->uniformValueCount = 0;
+
+	GLuint uCnt = _uniforms.count;
+	for (GLuint uIdx = 0; uIdx < uCnt; uIdx++) {
+		CC3GLSLUniform* var = [_uniforms objectAtIndex: uIdx];
+		if ( ![self isNodeUniform: var] ) continue;
+
+		CC3GLSLUniform* scratchVar = [self scratchUniformAt: uIdx];
+		if ( [context populateUniform: scratchVar withVisitor: visitor] ) continue;		// Resolved on replay
+		if ( ![_semanticDelegate populateUniform: scratchVar withVisitor: visitor] ) continue;
+
+		GLuint valLen = scratchVar.valueLength;
+		GLuint uvOffset = [cmdList allocateContent: CC3DrawUniformValueSize(valLen) forCommand: aCommand];
+		if (aCommand->uniformValueCount == 0) aCommand->uniformValuesOffset = uvOffset;
+		CC3DrawUniformValue* uv = [cmdList contentAt: uvOffset ofCommand: aCommand];
+		uv->uniformIndex = uIdx;
+		uv->valueLength = valLen;
+		[scratchVar copyValueTo: (GLubyte*)uv + sizeof(CC3DrawUniformValue)];
+		aCommand->uniformValueCount++;
+	}
+}
+
+// Raise an assertion error if a uniform that was not captured cannot be resolved by either context or delegate!
+-(void) bindDrawCommand: (CC3DrawCommand*) aCommand withVisitor: (CC3NodeDrawingVisitor*) visitor {
+	LogTrace(@"Binding program %@ for %@", self, aCommand->node);
+	CC3OpenGLESEngine.engine.shaders.activeProgram = self;
+	[self use];
+
+	CC3GLProgramContext* context = aCommand->shaderContext;
+	GLuint uvCnt = aCommand->uniformValueCount;
+	GLubyte* uvBytes = uvCnt ? [visitor.commandList contentAt: aCommand->uniformValuesOffset ofCommand: aCommand] : NULL;
+	GLuint uvIdx = 0;
+
+	GLuint uCnt = _uniforms.count;
+	for (GLuint uIdx = 0; uIdx < uCnt; uIdx++) {
+		CC3GLSLUniform* var = [_uniforms objectAtIndex: uIdx];
+		CC3DrawUniformValue* uv = (CC3DrawUniformValue*)uvBytes;
+		if (uvIdx < uvCnt && uv->uniformIndex == uIdx) {
+			[var setValueFromBytes: uvBytes + sizeof(CC3DrawUniformValue)];
+			uvBytes += CC3DrawUniformValueSize(uv->valueLength);
+			uvIdx++;
+		} else if ( !([context populateUniform: var withVisitor: visitor] ||
+					  [_semanticDelegate populateUniform: var withVisitor: visitor]) ) {
+			NSAssert3(NO, @"Could not resolve value of uniform %@ for %@ within context %@", var, self, context);
+		}
+	}
+}
+
 -(BOOL) compileShader: (GLuint*) shader type: (GLenum) type byteArray: (const GLchar*) source {
     GLint status;
 	
@@ -165,6 +280,8 @@
 
 -(void) configureUniforms {
 	[_uniforms removeAllObjects];
+	[_scratchUniforms release];
+	_scratchUniforms = nil;
 	
 	GLint varCnt;
 	glGetProgramiv(program_, GL_ACTIVE_UNIFORMS, &varCnt);
@@ -200,6 +317,8 @@
 
 #if CC3_OGLES_1
 -(void) bindWithVisitor: (CC3NodeDrawingVisitor*) visitor fromContext: (CC3GLProgramContext*) context {}
+-(void) populateDrawCommand: (CC3DrawCommand*) aCommand withVisitor: (CC3NodeDrawingVisitor*) visitor {}
+-(void) bindDrawCommand: (CC3DrawCommand*) aCommand withVisitor: (CC3NodeDrawingVisitor*) visitor {}
 -(BOOL) link { return NO; }
 #endif
 
@@ -232,6 +351,8 @@
 		self.name = name;				// retained
 		_uniforms = [CCArray new];		// retained
 		_attributes = [CCArray new];	// retained
+		_scratchUniforms = nil;
+		_uniformStateVersion = _currentUniformStateVersion;
 		_maxUniformNameLength = 0;
 		_maxAttributeNameLength = 0;
 	}
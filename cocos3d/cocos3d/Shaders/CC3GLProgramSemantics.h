@@ -359,6 +359,15 @@ typedef enum {
 	kCC3SemanticPointSizeFadeThreshold,			/**< Points will be allowed to grow to. */
 	kCC3SemanticPointSpritesIsEnabled,			/**< Whether points should be interpeted as textured sprites. */
 	
+	// SHADOW MAPS ------------
+	kCC3SemanticShadowMapIsEnabled,				/**< Whether a shadow map is being sampled. */
+	kCC3SemanticShadowMapCascadeCount,			/**< The number of cascades in the shadow map. */
+	kCC3SemanticShadowMapMatrices,				/**< Array of matrices mapping eye space to each cascade of the shadow map. */
+	kCC3SemanticShadowMapSplitDistances,		/**< The eye-space depth at the far end of each cascade of the shadow map. */
+	kCC3SemanticShadowMapDepthBias,				/**< The depth bias applied when comparing against the shadow map. */
+	kCC3SemanticShadowMapIntensity,				/**< The fraction of fragment color removed when in shadow. */
+	kCC3SemanticShadowMapSampler,				/**< The texture unit to which the shadow map is bound. */
+	
 	kCC3SemanticAppBase,						/**< First semantic of app-specific custom semantics. */
 	kCC3SemanticMax = 0xFFFF					/**< The maximum value for an app-specific custom semantic. */
 } CC3Semantic;
@@ -37,6 +37,7 @@
 #import "CC3Camera.h"
 #import "CC3Light.h"
 #import "CC3PointParticles.h"
+#import "CC3ShadowMaps.h"
 
 NSString* NSStringFromCC3Semantic(CC3Semantic semantic) {
 	switch (semantic) {
@@ -346,6 +347,15 @@ NSString* NSStringFromCC3Semantic(CC3Semantic semantic) {
 		case kCC3SemanticPointSizeFadeThreshold: return @"kCC3SemanticPointSizeFadeThreshold";
 		case kCC3SemanticPointSpritesIsEnabled: return @"kCC3SemanticPointSpritesIsEnabled";
 			
+		// SHADOW MAPS ------------
+		case kCC3SemanticShadowMapIsEnabled: return @"kCC3SemanticShadowMapIsEnabled";
+		case kCC3SemanticShadowMapCascadeCount: return @"kCC3SemanticShadowMapCascadeCount";
+		case kCC3SemanticShadowMapMatrices: return @"kCC3SemanticShadowMapMatrices";
+		case kCC3SemanticShadowMapSplitDistances: return @"kCC3SemanticShadowMapSplitDistances";
+		case kCC3SemanticShadowMapDepthBias: return @"kCC3SemanticShadowMapDepthBias";
+		case kCC3SemanticShadowMapIntensity: return @"kCC3SemanticShadowMapIntensity";
+		case kCC3SemanticShadowMapSampler: return @"kCC3SemanticShadowMapSampler";
+			
 			
 		case kCC3SemanticAppBase: return @"kCC3SemanticAppBase";
 		case kCC3SemanticMax: return @"kCC3SemanticMax";
@@ -412,14 +422,27 @@ NSString* NSStringFromCC3Semantic(CC3Semantic semantic) {
 
 		// ENVIRONMENT MATRICES --------------
 		case kCC3SemanticModelMatrix: {
-			CC3Matrix4x4 mtx;
+			// Include the transform that unpacks any quantized vertex locations
+			CC3Matrix4x4 mtx, unpackMtx, modelMtx;
 			[visitor.currentMeshNode.transformMatrix populateCC3Matrix4x4: &mtx];
+			if (visitor.currentMesh.hasQuantizedVertexLocations) {
+				[visitor.currentMesh populateVertexLocationUnpackMatrix: &unpackMtx];
+				CC3Matrix4x4Multiply(&modelMtx, &mtx, &unpackMtx);
+				mtx = modelMtx;
+			}
 			[uniform setMatrices4x4: &mtx];
 			return YES;
 		}
 		case kCC3SemanticModelMatrixInv: {
-			CC3Matrix4x4 mtx;
+			// Include the inverse of the transform that unpacks any quantized vertex locations
+			CC3Matrix4x4 mtx, unpackMtx, modelMtxInv;
 			[visitor.currentMeshNode.transformMatrixInverted populateCC3Matrix4x4: &mtx];
+			if (visitor.currentMesh.hasQuantizedVertexLocations) {
+				[visitor.currentMesh populateVertexLocationUnpackMatrix: &unpackMtx];
+				CC3Matrix4x4InvertAdjoint(&unpackMtx);
+				CC3Matrix4x4Multiply(&modelMtxInv, &unpackMtx, &mtx);
+				mtx = modelMtxInv;
+			}
 			[uniform setMatrices4x4: &mtx];
 			return YES;
 		}
@@ -840,6 +863,32 @@ NSString* NSStringFromCC3Semantic(CC3Semantic semantic) {
 			[uniform setBoolean: CC3OpenGLESEngine.engine.capabilities.pointSprites.value];
 			return YES;
 		}
+
+		// SHADOW MAPS ------------
+		case kCC3SemanticShadowMapIsEnabled:
+			[uniform setBoolean: (visitor.shadowMap != nil)];
+			return YES;
+		case kCC3SemanticShadowMapCascadeCount:
+			[uniform setInteger: visitor.shadowMap.activeCascadeCount];
+			return YES;
+		case kCC3SemanticShadowMapMatrices:
+			if (visitor.shadowMap) [uniform setMatrices4x4: visitor.shadowMap.shadowMatrices];
+			return YES;
+		case kCC3SemanticShadowMapSplitDistances: {
+			CC3ShadowMap* sm = visitor.shadowMap;
+			if (sm) [uniform setVector4: CC3Vector4Make([sm splitDistanceAt: 0], [sm splitDistanceAt: 1],
+														 [sm splitDistanceAt: 2], [sm splitDistanceAt: 3])];
+			return YES;
+		}
+		case kCC3SemanticShadowMapDepthBias:
+			[uniform setFloat: visitor.shadowMap.depthBias];
+			return YES;
+		case kCC3SemanticShadowMapIntensity:
+			[uniform setFloat: visitor.shadowMap.intensity];
+			return YES;
+		case kCC3SemanticShadowMapSampler:
+			[uniform setInteger: visitor.shadowMap.textureUnit];
+			return YES;
 			
 		default: return NO;
 	}
@@ -921,6 +970,16 @@ NSString* NSStringFromCC3Semantic(CC3Semantic semantic) {
 	[self mapVariableName: @"u_cc3Points.sizeFadeThreshold" toSemantic: kCC3SemanticPointSizeFadeThreshold];
 	[self mapVariableName: @"u_cc3Points.shouldDisplayAsSprites" toSemantic: kCC3SemanticPointSpritesIsEnabled];
 	
+	// SHADOW MAPS ------------
+	[self mapVariableName: @"u_cc3ShadowMap.isEnabled" toSemantic: kCC3SemanticShadowMapIsEnabled];
+	[self mapVariableName: @"u_cc3ShadowMap.cascadeCount" toSemantic: kCC3SemanticShadowMapCascadeCount];
+	[self mapVariableName: @"u_cc3ShadowMap.splitDistances" toSemantic: kCC3SemanticShadowMapSplitDistances];
+	[self mapVariableName: @"u_cc3ShadowMap.depthBias" toSemantic: kCC3SemanticShadowMapDepthBias];
+	[self mapVariableName: @"u_cc3ShadowMap.intensity" toSemantic: kCC3SemanticShadowMapIntensity];
+	[self mapVariableName: @"u_cc3ShadowMatrices" toSemantic: kCC3SemanticShadowMapMatrices];		// alias for u_cc3ShadowMatrices[0]
+	[self mapVariableName: @"u_cc3ShadowMatrices[0]" toSemantic: kCC3SemanticShadowMapMatrices];	// alias for u_cc3ShadowMatrices
+	[self mapVariableName: @"s_cc3ShadowMap" toSemantic: kCC3SemanticShadowMapSampler];
+	
 	// ENVIRONMENT MATRICES --------------
 	[self mapVariableName: @"u_cc3MtxM" toSemantic: kCC3SemanticModelMatrix];
 	[self mapVariableName: @"u_cc3MtxMI" toSemantic: kCC3SemanticModelMatrixInv];
@@ -472,6 +472,19 @@
 /** Sets the value of the specified uniform from the value of this uniform. */
 -(void) setValueInto: (CC3GLSLUniform*) uniform;
 
+/** Returns the length of the value of this uniform, in bytes, as determined by the type and size properties. */
+@property(nonatomic, readonly) GLuint valueLength;
+
+/** Copies the value of this uniform into the specified memory, which must hold at least valueLength bytes. */
+-(void) copyValueTo: (GLvoid*) bytes;
+
+/**
+ * Sets the value of this uniform from the specified memory, which must hold at least valueLength
+ * bytes, in the layout produced by the copyValueTo: method. The value is sent to the GL engine
+ * if it is different than previously set.
+ */
+-(void) setValueFromBytes: (const GLvoid*) bytes;
+
 @end
 
 
@@ -218,6 +218,12 @@
 	[uniform updateValue: _varValue];
 }
 
+-(GLuint) valueLength { return (GLuint)_varLen; }
+
+-(void) copyValueTo: (GLvoid*) bytes { memcpy(bytes, _varValue, _varLen); }
+
+-(void) setValueFromBytes: (const GLvoid*) bytes { [self updateValue: bytes]; }
+
 /**
  * Checks whether the specified new content is different than the current cached GL content for this
  * uniform variable, updates the cached content if it is, and returns whether the content was changed.
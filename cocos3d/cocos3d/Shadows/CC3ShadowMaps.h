@@ -0,0 +1,284 @@
+/*
+ * CC3ShadowMaps.h
+ *
+ * cocos3d 2.0.0
+ * Author: Bill Hollings
+ * Copyright (c) 2011-2013 The Brenwill Workshop Ltd. All rights reserved.
+ * http://www.brenwill.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * http://en.wikipedia.org/wiki/MIT_License
+ */
+
+/** @file */	// Doxygen marker
+
+
+#import "CC3Light.h"
+#import "CC3NodeVisitor.h"
+
+/** The maximum number of cascades into which the shadow map of a directional light can be split. */
+#define kCC3ShadowMapMaxCascades		4
+
+/** The default width and height, in texels, of each cascade of a shadow map. */
+#define kCC3ShadowMapDefaultSize		1024
+
+/** The default number of cascades used by the shadow map of a directional light. */
+#define kCC3ShadowMapDefaultCascadeCount	3
+
+
+#pragma mark -
+#pragma mark CC3ShadowMap
+
+/**
+ * CC3ShadowMap renders the depth of the shadow-casting nodes, as seen from a light, into an
+ * offscreen texture, which is then sampled by the shaders that draw the scene, to determine
+ * whether each fragment is hidden from the light. A CC3ShadowMap is created automatically
+ * when the shadowTechnique property of a CC3Light is set to kCC3ShadowTechniqueShadowMap.
+ *
+ * Shadow mapping is an alternative to shadow volumes. Rendering a shadow map costs one extra
+ * depth-only drawing of each shadow-casting node per cascade, but it does not require the
+ * silhouette of each shadow-casting node to be extracted on the CPU whenever the node or the
+ * light moves, and it does not require the large stencil fill of the shadow volumes.
+ *
+ * The shadow-casting nodes are the same nodes that would cast shadow volumes from the light.
+ * A node is identified as a shadow-casting node by adding shadow volumes to it, using the
+ * addShadowVolumesForLight: or addShadowVolumes method. This allows the shadow technique of
+ * each light to be switched, to compare the two techniques on the same scene. While a light
+ * is using a shadow map, its shadow volumes are neither updated nor drawn.
+ *
+ * For a directional light, the view frustum of the camera, out to the maxShadowDistance, is
+ * split along its depth into up to kCC3ShadowMapMaxCascades cascades. Each cascade covers a
+ * successively larger portion of the scene with the same number of texels, so that shadows
+ * close to the camera are sharp, while shadows far from the camera remain available. Each
+ * cascade is rendered with an orthographic projection that is fitted around the bounding
+ * sphere of its portion of the camera frustum. The bounding sphere is snapped to the texel
+ * grid of the cascade, so that shadow edges do not shimmer as the camera moves.
+ *
+ * For a positional light, a single perspective shadow map is rendered, looking along the
+ * forwardDirection of the light, with a field of view that covers the cone of a spotlight.
+ * The map does not cover the full sphere around an omnidirectional point light.
+ *
+ * Before the shadow map is drawn, each shadow-casting node is culled on the CPU, by testing
+ * its bounding sphere against the volume covered by each cascade. Only the nodes that can
+ * cast a shadow into a cascade are drawn into it. For a directional light, nodes that lie
+ * between the light and the cascade are retained, and the depth range of the cascade is
+ * extended towards the light to include them.
+ *
+ * The cascades are packed into a single texture atlas, in a 2x2 grid when more than one
+ * cascade is used. The depth of each texel is packed into the four 8-bit components of an
+ * RGBA texture, so that shadow maps can be used on devices that do not support depth textures.
+ * The texture is bound to the last texture unit while the scene is drawn.
+ *
+ * Skinned shadow-casting nodes (instances of CC3SkinMeshNode) are not drawn into the shadow
+ * map, because the depth shader does not apply bone transforms, and would render them in their
+ * bind pose. While a light is using a shadow map, skinned nodes do not cast shadows from it.
+ *
+ * Shadow maps require OpenGL ES 2. Under OpenGL ES 1, shadow maps are not drawn, and a light
+ * whose shadowTechnique is kCC3ShadowTechniqueShadowMap continues to cast its shadows using
+ * shadow volumes. The default shaders
+ * sample the shadow map of the first light in the scene that uses one, and, to limit the number
+ * of varying variables, support only the first three cascades of that shadow map.
+ */
+@interface CC3ShadowMap : NSObject {
+	CC3Light* _light;
+	CCArray* _cascadeCasters[kCC3ShadowMapMaxCascades];
+	CC3Matrix4x4 _viewMatrices[kCC3ShadowMapMaxCascades];
+	CC3Matrix4x4 _projectionMatrices[kCC3ShadowMapMaxCascades];
+	CC3Matrix4x4 _shadowMatrices[kCC3ShadowMapMaxCascades];
+	GLfloat _splitDistances[kCC3ShadowMapMaxCascades];
+	GLuint _frameBufferID;
+	GLuint _depthBufferID;
+	GLuint _textureID;
+	GLuint _textureSize;
+	GLuint _textureUnit;
+	GLuint _mapSize;
+	GLuint _cascadeCount;
+	GLuint _activeCascadeCount;
+	GLuint _castersDrawn;
+	GLuint _castersCulled;
+	GLfloat _maxShadowDistance;
+	GLfloat _splitBlendFactor;
+	GLfloat _depthBias;
+	GLfloat _intensity;
+}
+
+/** The light that casts the shadows rendered into this shadow map. The light is not retained. */
+@property(nonatomic, assign) CC3Light* light;
+
+/**
+ * The width and height, in texels, of each cascade of this shadow map.
+ *
+ * When more than one cascade is in use, the texture holding the shadow map is twice
+ * this size in each dimension. Changing this property releases the GL texture and
+ * framebuffer, which will be recreated the next time this shadow map is drawn.
+ *
+ * The initial value of this property is kCC3ShadowMapDefaultSize.
+ */
+@property(nonatomic, assign) GLuint mapSize;
+
+/**
+ * The number of cascades into which the view frustum of the camera is split, when the light
+ * is directional. The value is clamped to between one and kCC3ShadowMapMaxCascades.
+ *
+ * This property has no effect when the light is positional, because a single perspective
+ * shadow map is always used for a positional light.
+ *
+ * The initial value of this property is kCC3ShadowMapDefaultCascadeCount.
+ */
+@property(nonatomic, assign) GLuint cascadeCount;
+
+/**
+ * The number of cascades that were prepared during the most recent invocation of the
+ * updateWithCamera: method. This is the value of the cascadeCount property if the light
+ * is directional, or one if the light is positional.
+ */
+@property(nonatomic, readonly) GLuint activeCascadeCount;
+
+/**
+ * The distance from the camera, beyond which shadows are not rendered, when the light is
+ * directional. The shadow map covers the camera frustum from the near clipping plane to
+ * the smaller of this distance and the far clipping plane of the camera.
+ *
+ * If the value of this property is zero, the far clipping plane of the camera is used.
+ * The initial value of this property is zero.
+ */
+@property(nonatomic, assign) GLfloat maxShadowDistance;
+
+/**
+ * Determines how the camera frustum is split between the cascades. A value of zero splits the
+ * depth of the frustum into equal intervals, and a value of one splits it into intervals that
+ * increase logarithmically, which matches the way perspective shrinks distant objects. Values
+ * in between blend the two distributions.
+ *
+ * The initial value of this property is 0.75.
+ */
+@property(nonatomic, assign) GLfloat splitBlendFactor;
+
+/**
+ * The amount, in normalized depth units, by which the depth of each fragment is reduced
+ * before it is compared against the depth held in the shadow map. Increasing this value
+ * removes self-shadowing artifacts, at the expense of detaching shadows from their casters.
+ *
+ * The initial value of this property is 0.002.
+ */
+@property(nonatomic, assign) GLfloat depthBias;
+
+/**
+ * The fraction of the color of a fragment that is removed when that fragment is in shadow.
+ *
+ * This value is set automatically from the relative intensity of the light, in the same
+ * way that the opacity of the stencilled shadow painter of a light is set, when the
+ * updateRelativeIntensityFrom: method of the light is invoked.
+ *
+ * The initial value of this property is one, indicating completely black shadows.
+ */
+@property(nonatomic, assign) GLfloat intensity;
+
+/**
+ * Returns the distance from the camera, along its line of sight, to the far end of the cascade
+ * at the specified index, as calculated during the most recent invocation of the
+ * updateWithCamera: method. The index must be less than kCC3ShadowMapMaxCascades. For cascades
+ * beyond the activeCascadeCount, the distance to the far end of the last cascade is returned.
+ */
+-(GLfloat) splitDistanceAt: (GLuint) cascadeIndex;
+
+/**
+ * Returns a pointer to an array of kCC3ShadowMapMaxCascades matrices, each of which transforms a
+ * location in the eye space of the camera into the texture coordinates and normalized depth
+ * of the corresponding cascade within the texture of this shadow map.
+ *
+ * These matrices are updated by the updateWithCamera: method.
+ */
+@property(nonatomic, readonly) CC3Matrix4x4* shadowMatrices;
+
+/** The name of the GL texture holding this shadow map, or zero if the texture has not yet been created. */
+@property(nonatomic, readonly) GLuint textureID;
+
+/** The texture unit to which the texture of this shadow map was most recently bound. */
+@property(nonatomic, readonly) GLuint textureUnit;
+
+/** The total number of shadow-casting nodes, summed across the cascades, that were drawn during the most recent update. */
+@property(nonatomic, readonly) GLuint castersDrawn;
+
+/** The total number of shadow-casting nodes, summed across the cascades, that were culled during the most recent update. */
+@property(nonatomic, readonly) GLuint castersCulled;
+
+
+#pragma mark Allocation and initialization
+
+/** Initializes this instance to render the shadows cast by the specified light. */
+-(id) initForLight: (CC3Light*) aLight;
+
+/** Allocates and initializes an autoreleased instance to render the shadows cast by the specified light. */
++(id) shadowMapForLight: (CC3Light*) aLight;
+
+
+#pragma mark Updating and drawing
+
+/**
+ * Updates the split distances, the projection of each cascade, and the shadow matrices, to
+ * track the specified camera and the light, and culls the shadow-casting nodes against each
+ * cascade.
+ *
+ * This method does not invoke the GL engine, and is invoked automatically by the updateShadows
+ * method of the light, during the update of the scene.
+ */
+-(void) updateWithCamera: (CC3Camera*) aCamera;
+
+/**
+ * Returns whether the specified shadow-casting node can cast a shadow into the cascade at
+ * the specified index, as determined during the most recent invocation of updateWithCamera:.
+ */
+-(BOOL) doesCascade: (GLuint) cascadeIndex containCaster: (CC3Node*) aNode;
+
+/**
+ * Renders the depth of the shadow-casting nodes retained by the most recent update into each
+ * cascade of this shadow map, using the specified visitor, creating the texture and framebuffer
+ * if needed. The framebuffer, viewport and matrices that were in use are restored afterwards.
+ *
+ * This method is invoked automatically by the CC3Scene before the scene is drawn.
+ */
+-(void) drawWithVisitor: (CC3NodeDrawingVisitor*) visitor;
+
+/**
+ * Binds the texture of this shadow map to the specified texture unit, so that it can be
+ * sampled by the shaders while the scene is drawn.
+ */
+-(void) bindToTextureUnit: (GLuint) texUnit;
+
+/** Deletes the GL texture and framebuffer used by this shadow map. */
+-(void) deleteGLBuffers;
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3ShadowMapDrawingVisitor
+
+/**
+ * CC3ShadowMapDrawingVisitor is a CC3NodeDrawingVisitor that draws the depth of the
+ * shadow-casting nodes into a cascade of a CC3ShadowMap.
+ *
+ * Nodes are drawn undecorated, using the GL program that packs the depth of each fragment
+ * into its color. The nodes to be drawn are selected by the shadow map, so this visitor
+ * does not visit children, and does not cull nodes against the frustum of the camera.
+ */
+@interface CC3ShadowMapDrawingVisitor : CC3NodeDrawingVisitor
+@end
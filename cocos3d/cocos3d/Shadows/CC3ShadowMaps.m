@@ -0,0 +1,561 @@
+/*
+ * CC3ShadowMaps.m
+ *
+ * cocos3d 2.0.0
+ * Author: Bill Hollings
+ * Copyright (c) 2011-2013 The Brenwill Workshop Ltd. All rights reserved.
+ * http://www.brenwill.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * http://en.wikipedia.org/wiki/MIT_License
+ * 
+ * See header file CC3ShadowMaps.h for full API documentation.
+ */
+
+#import "CC3ShadowMaps.h"
+#import "CC3ShadowVolumes.h"
+#import "CC3VertexSkinning.h"
+#import "CC3BoundingVolumes.h"
+#import "CC3Camera.h"
+#import "CC3OpenGLESEngine.h"
+
+/** The largest half-angle, in degrees, of the perspective shadow map of a positional light. */
+#define kCC3ShadowMapMaxHalfAngle			60.0f
+
+/** The ratio of the near clipping distance to the far clipping distance of a positional light. */
+#define kCC3ShadowMapPositionalNearRatio	0.005f
+
+
+#pragma mark -
+#pragma mark CC3ShadowMap
+
+@interface CC3ShadowMap (TemplateMethods)
+-(void) updateSplitDistancesWithCamera: (CC3Camera*) aCamera;
+-(void) updateDirectionalCascade: (GLuint) cIdx withCamera: (CC3Camera*) aCamera;
+-(void) updatePositionalCascadeWithCamera: (CC3Camera*) aCamera;
+-(void) updateShadowMatrixForCascade: (GLuint) cIdx fromEye: (CC3Matrix4x4*) eyeMtx;
+-(GLuint) atlasColumnCount;
+-(BOOL) ensureGLBuffers;
+@end
+
+/**
+ * Retrieves the global bounding sphere of the specified shadow-casting node into the specified
+ * sphere, and returns whether the node has a spherical bounding volume from which to do so.
+ */
+static BOOL CC3ShadowCasterGetSphere(CC3Node* aNode, CC3Sphere* aSphere) {
+	CC3NodeBoundingVolume* bv = aNode.boundingVolume;
+	if ([bv isKindOfClass: [CC3NodeSphereThenBoxBoundingVolume class]]) {
+		bv = ((CC3NodeSphereThenBoxBoundingVolume*)bv).sphericalBoundingVolume;
+	}
+	if ( ![bv isKindOfClass: [CC3NodeSphericalBoundingVolume class]] ) return NO;
+	*aSphere = ((CC3NodeSphericalBoundingVolume*)bv).globalSphere;
+	return YES;
+}
+
+/**
+ * Returns whether the specified shadow-casting node should be drawn into the shadow map.
+ *
+ * Skinned nodes are excluded, because the depth shader does not apply bone transforms,
+ * and would draw them in their bind pose, casting shadows that do not match the node.
+ */
+static BOOL CC3ShadowMapCanDrawCaster(CC3MeshNode* aNode) {
+	if ( !aNode || !(aNode.visible || aNode.shouldCastShadowsWhenInvisible) ) return NO;
+	return ![aNode isKindOfClass: [CC3SkinMeshNode class]];
+}
+
+/** Returns the specified location, transformed by the specified matrix. */
+static inline CC3Vector CC3ShadowMapTransformLocation(const CC3Matrix4x4* mtx, CC3Vector aLocation) {
+	return CC3VectorFromTruncatedCC3Vector4(CC3Matrix4x4TransformCC3Vector4(mtx, CC3Vector4FromLocation(aLocation)));
+}
+
+@implementation CC3ShadowMap
+
+@synthesize light=_light, mapSize=_mapSize, cascadeCount=_cascadeCount;
+@synthesize activeCascadeCount=_activeCascadeCount, maxShadowDistance=_maxShadowDistance;
+@synthesize splitBlendFactor=_splitBlendFactor, depthBias=_depthBias, intensity=_intensity;
+@synthesize textureID=_textureID, textureUnit=_textureUnit;
+@synthesize castersDrawn=_castersDrawn, castersCulled=_castersCulled;
+
+-(void) dealloc {
+	_light = nil;			// not retained
+	for (GLuint i = 0; i < kCC3ShadowMapMaxCascades; i++) [_cascadeCasters[i] release];
+	[self deleteGLBuffers];
+	[super dealloc];
+}
+
+-(void) setMapSize: (GLuint) aSize {
+	if (aSize == _mapSize) return;
+	_mapSize = aSize;
+	[self deleteGLBuffers];
+}
+
+-(void) setCascadeCount: (GLuint) aCount {
+	_cascadeCount = CLAMP(aCount, 1, kCC3ShadowMapMaxCascades);
+}
+
+-(GLfloat) splitDistanceAt: (GLuint) cascadeIndex {
+	NSAssert2(cascadeIndex < kCC3ShadowMapMaxCascades, @"Cascade index %u must be less than %u",
+			  cascadeIndex, kCC3ShadowMapMaxCascades);
+	return _splitDistances[cascadeIndex];
+}
+
+-(CC3Matrix4x4*) shadowMatrices { return _shadowMatrices; }
+
+
+#pragma mark Allocation and initialization
+
+-(id) init { return [self initForLight: nil]; }
+
+-(id) initForLight: (CC3Light*) aLight {
+	if ( (self = [super init]) ) {
+		_light = aLight;				// not retained
+		for (GLuint i = 0; i < kCC3ShadowMapMaxCascades; i++) {
+			_cascadeCasters[i] = [[CCArray array] retain];
+			CC3Matrix4x4PopulateIdentity(&_viewMatrices[i]);
+			CC3Matrix4x4PopulateIdentity(&_projectionMatrices[i]);
+			CC3Matrix4x4PopulateIdentity(&_shadowMatrices[i]);
+			_splitDistances[i] = 0.0f;
+		}
+		_frameBufferID = 0;
+		_depthBufferID = 0;
+		_textureID = 0;
+		_textureSize = 0;
+		_textureUnit = 0;
+		_mapSize = kCC3ShadowMapDefaultSize;
+		_cascadeCount = kCC3ShadowMapDefaultCascadeCount;
+		_activeCascadeCount = 0;
+		_castersDrawn = 0;
+		_castersCulled = 0;
+		_maxShadowDistance = 0.0f;
+		_splitBlendFactor = 0.75f;
+		_depthBias = 0.002f;
+		_intensity = 1.0f;
+	}
+	return self;
+}
+
++(id) shadowMapForLight: (CC3Light*) aLight {
+	return [[[self alloc] initForLight: aLight] autorelease];
+}
+
+-(NSString*) description {
+	return [NSString stringWithFormat: @"%@ for %@ with %u cascades of %u texels",
+			[self class], _light, _activeCascadeCount, _mapSize];
+}
+
+
+#pragma mark Updating
+
+-(void) updateWithCamera: (CC3Camera*) aCamera {
+	for (GLuint i = 0; i < kCC3ShadowMapMaxCascades; i++) [_cascadeCasters[i] removeAllObjects];
+	_castersDrawn = 0;
+	_castersCulled = 0;
+	_activeCascadeCount = 0;
+	if ( !(_light && aCamera) ) return;
+
+	if (_light.isDirectionalOnly) {
+		if (CC3VectorLengthSquared(_light.globalLocation) == 0.0f) return;	// No direction
+		_activeCascadeCount = _cascadeCount;
+		[self updateSplitDistancesWithCamera: aCamera];
+		for (GLuint i = 0; i < _activeCascadeCount; i++) {
+			[self updateDirectionalCascade: i withCamera: aCamera];
+		}
+	} else {
+		_activeCascadeCount = 1;
+		for (GLuint i = 0; i < kCC3ShadowMapMaxCascades; i++) {
+			_splitDistances[i] = aCamera.farClippingDistance;
+		}
+		[self updatePositionalCascadeWithCamera: aCamera];
+	}
+
+	// The camera transform maps the eye space of the camera into the global coordinate system
+	CC3Matrix4x4 eyeMtx;
+	[aCamera.transformMatrix populateCC3Matrix4x4: &eyeMtx];
+	for (GLuint i = 0; i < _activeCascadeCount; i++) {
+		[self updateShadowMatrixForCascade: i fromEye: &eyeMtx];
+	}
+	LogTrace(@"%@ updated with %u casters drawn and %u culled", self, _castersDrawn, _castersCulled);
+}
+
+/**
+ * Splits the depth of the camera frustum, out to the maxShadowDistance, between the cascades,
+ * by blending a logarithmic distribution and a uniform distribution, as weighted by the
+ * splitBlendFactor property. Split distances of unused cascades duplicate the last split.
+ */
+-(void) updateSplitDistancesWithCamera: (CC3Camera*) aCamera {
+	GLfloat n = aCamera.nearClippingDistance;
+	GLfloat f = aCamera.farClippingDistance;
+	if (_maxShadowDistance > n) f = MIN(f, _maxShadowDistance);
+	
+	GLfloat cCnt = _activeCascadeCount;
+	for (GLuint i = 0; i < kCC3ShadowMapMaxCascades; i++) {
+		if (i < _activeCascadeCount) {
+			GLfloat frac = (GLfloat)(i + 1) / cCnt;
+			GLfloat logSplit = n * powf(f / n, frac);
+			GLfloat uniSplit = n + ((f - n) * frac);
+			_splitDistances[i] = (_splitBlendFactor * logSplit) + ((1.0f - _splitBlendFactor) * uniSplit);
+		} else {
+			_splitDistances[i] = _splitDistances[i - 1];
+		}
+	}
+}
+
+/**
+ * Fits an orthographic projection, looking along the direction of the light, around the bounding
+ * sphere of the portion of the camera frustum covered by the specified cascade, and culls the
+ * shadow-casting nodes against it.
+ *
+ * The portion of the camera frustum is found by interpolating along the edges of the frustum,
+ * which keeps the size of its bounding sphere constant as the camera rotates. The center of the
+ * sphere is snapped to the texel grid of the cascade, so that shadow edges do not shimmer as
+ * the camera moves.
+ *
+ * Casters are culled in the view space of the light. A caster lying between the light and the
+ * cascade is retained, and the depth range of the cascade is extended towards the light to
+ * include it, since it can cast a shadow into the cascade.
+ */
+-(void) updateDirectionalCascade: (GLuint) cIdx withCamera: (CC3Camera*) aCamera {
+	CC3Frustum* frustum = aCamera.frustum;
+	GLfloat camNear = aCamera.nearClippingDistance;
+	GLfloat camDepth = aCamera.farClippingDistance - camNear;
+	GLfloat nearFrac = ((cIdx == 0 ? camNear : _splitDistances[cIdx - 1]) - camNear) / camDepth;
+	GLfloat farFrac = (_splitDistances[cIdx] - camNear) / camDepth;
+
+	// Corners of the portion of the camera frustum covered by this cascade
+	CC3Vector corners[8];
+	corners[0] = CC3VectorLerp(frustum.nearTopLeft, frustum.farTopLeft, nearFrac);
+	corners[1] = CC3VectorLerp(frustum.nearTopRight, frustum.farTopRight, nearFrac);
+	corners[2] = CC3VectorLerp(frustum.nearBottomLeft, frustum.farBottomLeft, nearFrac);
+	corners[3] = CC3VectorLerp(frustum.nearBottomRight, frustum.farBottomRight, nearFrac);
+	corners[4] = CC3VectorLerp(frustum.nearTopLeft, frustum.farTopLeft, farFrac);
+	corners[5] = CC3VectorLerp(frustum.nearTopRight, frustum.farTopRight, farFrac);
+	corners[6] = CC3VectorLerp(frustum.nearBottomLeft, frustum.farBottomLeft, farFrac);
+	corners[7] = CC3VectorLerp(frustum.nearBottomRight, frustum.farBottomRight, farFrac);
+
+	CC3Vector center = kCC3VectorZero;
+	for (GLuint i = 0; i < 8; i++) center = CC3VectorAdd(center, corners[i]);
+	center = CC3VectorScaleUniform(center, 1.0f / 8.0f);
+	GLfloat radius = 0.0f;
+	for (GLuint i = 0; i < 8; i++) radius = MAX(radius, CC3VectorDistance(center, corners[i]));
+	radius = ceilf(radius * 16.0f) / 16.0f;		// Quantize to keep the texel size stable
+
+	// Rotation from global coordinates into the view space of the light
+	CC3Vector lightDir = CC3VectorNegate(CC3VectorNormalize(_light.globalLocation));
+	CC3Vector upDir = (fabsf(lightDir.y) > 0.99f) ? kCC3VectorUnitZPositive : kCC3VectorUnitYPositive;
+	CC3Matrix4x4* viewMtx = &_viewMatrices[cIdx];
+	CC3Matrix4x4PopulateToPointTowards(viewMtx, lightDir, upDir);
+	CC3Matrix4x4Transpose(viewMtx);
+
+	// Snap the center of the sphere to the texel grid and center the view on it
+	CC3Vector lsCenter = CC3ShadowMapTransformLocation(viewMtx, center);
+	GLfloat texelSize = (2.0f * radius) / _mapSize;
+	lsCenter.x = floorf(lsCenter.x / texelSize) * texelSize;
+	lsCenter.y = floorf(lsCenter.y / texelSize) * texelSize;
+	viewMtx->c4r1 = -lsCenter.x;
+	viewMtx->c4r2 = -lsCenter.y;
+	viewMtx->c4r3 = -lsCenter.z;
+
+	// Cull the casters in the view space of the light, which looks down the negative Z-axis
+	GLfloat zMax = radius;
+	CCArray* casters = _cascadeCasters[cIdx];
+	for (CC3ShadowVolumeMeshNode* sv in _light.shadows) {
+		if ( ![sv isKindOfClass: [CC3ShadowVolumeMeshNode class]] ) continue;
+		CC3MeshNode* caster = sv.shadowCaster;
+		if ( !CC3ShadowMapCanDrawCaster(caster) ) continue;
+
+		CC3Sphere cs;
+		if (CC3ShadowCasterGetSphere(caster, &cs)) {
+			CC3Vector p = CC3ShadowMapTransformLocation(viewMtx, cs.center);
+			GLfloat r = cs.radius;
+			if ( (fabsf(p.x) - r > radius) || (fabsf(p.y) - r > radius) || (p.z + r < -radius) ) {
+				_castersCulled++;
+				continue;
+			}
+			zMax = MAX(zMax, p.z + r);
+		}
+		[casters addObject: caster];
+	}
+	_castersDrawn += casters.count;
+
+	CC3Matrix4x4PopulateOrthoFrustum(&_projectionMatrices[cIdx], -radius, radius, radius, -radius, -zMax, radius);
+}
+
+/**
+ * Builds a single perspective projection from the location of the light, looking along its
+ * forward direction, and culls the shadow-casting nodes against the planes of its frustum.
+ *
+ * The field of view covers the cone of a spotlight, up to a half-angle of kCC3ShadowMapMaxHalfAngle
+ * degrees. The depth of the frustum extends to the shadowRange of the light, or, if the light is not
+ * attenuated, to the far side of the camera frustum.
+ */
+-(void) updatePositionalCascadeWithCamera: (CC3Camera*) aCamera {
+	CC3Vector lightLoc = _light.globalLocation;
+	CC3Vector fwdDir = _light.globalForwardDirection;
+	CC3Vector upDir = (fabsf(fwdDir.y) > 0.99f) ? kCC3VectorUnitZPositive : kCC3VectorUnitYPositive;
+
+	CC3Matrix4x4* viewMtx = &_viewMatrices[0];
+	CC3Matrix4x4PopulateToPointTowards(viewMtx, fwdDir, upDir);
+	viewMtx->c4r1 = lightLoc.x;
+	viewMtx->c4r2 = lightLoc.y;
+	viewMtx->c4r3 = lightLoc.z;
+	CC3Matrix4x4InvertRigid(viewMtx);
+
+	GLfloat farDist = _light.shadowRange;
+	if (isinf(farDist)) farDist = CC3VectorDistance(lightLoc, aCamera.globalLocation) + aCamera.farClippingDistance;
+	GLfloat nearDist = farDist * kCC3ShadowMapPositionalNearRatio;
+	GLfloat halfAngle = MIN(_light.spotCutoffAngle, kCC3ShadowMapMaxHalfAngle);
+	GLfloat halfSize = nearDist * tanf(DegreesToRadians(halfAngle));
+	CC3Matrix4x4PopulatePerspectiveFrustum(&_projectionMatrices[0], -halfSize, halfSize,
+										   halfSize, -halfSize, nearDist, farDist);
+
+	// Extract the outward-facing planes of the frustum, in the same way as CC3Frustum
+	CC3Matrix4x4 m;
+	CC3Matrix4x4Multiply(&m, &_projectionMatrices[0], viewMtx);
+	CC3Plane planes[6];
+	planes[0] = CC3PlaneMake((m.c1r4 + m.c1r2), (m.c2r4 + m.c2r2), (m.c3r4 + m.c3r2), (m.c4r4 + m.c4r2));
+	planes[1] = CC3PlaneMake((m.c1r4 - m.c1r2), (m.c2r4 - m.c2r2), (m.c3r4 - m.c3r2), (m.c4r4 - m.c4r2));
+	planes[2] = CC3PlaneMake((m.c1r4 + m.c1r1), (m.c2r4 + m.c2r1), (m.c3r4 + m.c3r1), (m.c4r4 + m.c4r1));
+	planes[3] = CC3PlaneMake((m.c1r4 - m.c1r1), (m.c2r4 - m.c2r1), (m.c3r4 - m.c3r1), (m.c4r4 - m.c4r1));
+	planes[4] = CC3PlaneMake((m.c1r4 + m.c1r3), (m.c2r4 + m.c2r3), (m.c3r4 + m.c3r3), (m.c4r4 + m.c4r3));
+	planes[5] = CC3PlaneMake((m.c1r4 - m.c1r3), (m.c2r4 - m.c2r3), (m.c3r4 - m.c3r3), (m.c4r4 - m.c4r3));
+	for (GLuint i = 0; i < 6; i++) planes[i] = CC3PlaneNegate(CC3PlaneNormalize(planes[i]));
+
+	CCArray* casters = _cascadeCasters[0];
+	for (CC3ShadowVolumeMeshNode* sv in _light.shadows) {
+		if ( ![sv isKindOfClass: [CC3ShadowVolumeMeshNode class]] ) continue;
+		CC3MeshNode* caster = sv.shadowCaster;
+		if ( !CC3ShadowMapCanDrawCaster(caster) ) continue;
+
+		CC3Sphere cs;
+		if (CC3ShadowCasterGetSphere(caster, &cs)) {
+			BOOL isOutside = NO;
+			for (GLuint i = 0; i < 6 && !isOutside; i++) {
+				isOutside = (CC3DistanceFromPlane(cs.center, planes[i]) > cs.radius);
+			}
+			if (isOutside) {
+				_castersCulled++;
+				continue;
+			}
+		}
+		[casters addObject: caster];
+	}
+	_castersDrawn += casters.count;
+}
+
+/**
+ * The shadow matrix maps the eye space of the camera into the global coordinate system, then into
+ * the clip space of the light, and finally into the texture coordinates and depth of the tile that
+ * holds the cascade within the texture atlas. The tile mapping is applied to homogeneous coordinates,
+ * so the shaders must divide by the W component, to support perspective shadow maps.
+ */
+-(void) updateShadowMatrixForCascade: (GLuint) cIdx fromEye: (CC3Matrix4x4*) eyeMtx {
+	GLuint cols = self.atlasColumnCount;
+	GLfloat tileScale = 1.0f / cols;
+	GLfloat halfScale = 0.5f * tileScale;
+
+	CC3Matrix4x4 tileMtx;
+	CC3Matrix4x4PopulateIdentity(&tileMtx);
+	tileMtx.c1r1 = halfScale;
+	tileMtx.c2r2 = halfScale;
+	tileMtx.c3r3 = 0.5f;
+	tileMtx.c4r1 = halfScale + ((cIdx % cols) * tileScale);
+	tileMtx.c4r2 = halfScale + ((cIdx / cols) * tileScale);
+	tileMtx.c4r3 = 0.5f;
+
+	CC3Matrix4x4 vpMtx, tvpMtx;
+	CC3Matrix4x4Multiply(&vpMtx, &_projectionMatrices[cIdx], &_viewMatrices[cIdx]);
+	CC3Matrix4x4Multiply(&tvpMtx, &tileMtx, &vpMtx);
+	CC3Matrix4x4Multiply(&_shadowMatrices[cIdx], &tvpMtx, eyeMtx);
+}
+
+/** The cascades are tiled across the texture in a 2x2 grid when more than one cascade is in use. */
+-(GLuint) atlasColumnCount { return (_activeCascadeCount > 1) ? 2 : 1; }
+
+-(BOOL) doesCascade: (GLuint) cascadeIndex containCaster: (CC3Node*) aNode {
+	if (cascadeIndex >= _activeCascadeCount) return NO;
+	return [_cascadeCasters[cascadeIndex] containsObject: aNode];
+}
+
+
+#pragma mark Drawing
+
+#if CC3_OGLES_2
+
+/**
+ * Ensures that the texture and framebuffer exist, and are large enough to hold the tiles of the
+ * active cascades. The depth of each texel is packed into an RGBA texture, and the framebuffer
+ * uses a separate depth renderbuffer to resolve visibility while the depth is being rendered.
+ * Returns whether the framebuffer is ready to be drawn into.
+ */
+-(BOOL) ensureGLBuffers {
+	GLuint texSize = _mapSize * self.atlasColumnCount;
+	if (_frameBufferID && texSize == _textureSize) return YES;
+
+	[self deleteGLBuffers];
+	_textureSize = texSize;
+
+	// Bind through the texture unit tracker, to keep the tracker synchronized.
+	glGenTextures(1, &_textureID);
+	CC3OpenGLESTextureUnit* glesTexUnit = [CC3OpenGLESEngine.engine.textures textureUnitAt: 0];
+	[glesTexUnit activate];
+	glesTexUnit.textureBinding.value = _textureID;
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, texSize, texSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+	glGenRenderbuffers(1, &_depthBufferID);
+	glBindRenderbuffer(GL_RENDERBUFFER, _depthBufferID);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT16, texSize, texSize);
+
+	GLint prevFrameBuffer;
+	glGetIntegerv(GL_FRAMEBUFFER_BINDING, &prevFrameBuffer);
+	glGenFramebuffers(1, &_frameBufferID);
+	glBindFramebuffer(GL_FRAMEBUFFER, _frameBufferID);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, _textureID, 0);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, _depthBufferID);
+
+	// Verify the framebuffer
+	GLenum fbStatus = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, prevFrameBuffer);
+	if (fbStatus != GL_FRAMEBUFFER_COMPLETE) {
+		LogError(@"%@ failed to make complete shadow map framebuffer object %x", self, fbStatus);
+		[self deleteGLBuffers];
+		return NO;
+	}
+	LogTrace(@"%@ created shadow map texture %u of size %u", self, _textureID, texSize);
+	return YES;
+}
+
+-(void) deleteGLBuffers {
+	if (_frameBufferID) {
+		glDeleteFramebuffers(1, &_frameBufferID);
+		_frameBufferID = 0;
+	}
+	if (_depthBufferID) {
+		glDeleteRenderbuffers(1, &_depthBufferID);
+		_depthBufferID = 0;
+	}
+	if (_textureID) {
+		glDeleteTextures(1, &_textureID);
+		_textureID = 0;
+	}
+	_textureSize = 0;
+}
+
+/**
+ * Draws each cascade into its tile of the texture atlas, by loading the view and projection
+ * matrices of the cascade, and visiting each of the casters retained for that cascade.
+ *
+ * The texture is cleared to white, which unpacks to the farthest depth, so that texels
+ * that are not covered by a caster never cast a shadow.
+ */
+-(void) drawWithVisitor: (CC3NodeDrawingVisitor*) visitor {
+	if (_activeCascadeCount == 0 || ![self ensureGLBuffers]) return;
+
+	CC3OpenGLESEngine* glesEngine = CC3OpenGLESEngine.engine;
+	CC3OpenGLESState* glesState = glesEngine.state;
+	CC3OpenGLESMatrixStack* glesProjMtx = glesEngine.matrices.projection;
+	CC3OpenGLESMatrixStack* glesMVMtx = glesEngine.matrices.modelview;
+
+	GLint prevFrameBuffer;
+	glGetIntegerv(GL_FRAMEBUFFER_BINDING, &prevFrameBuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, _frameBufferID);
+
+	CC3Viewport prevViewport = glesState.viewport.value;
+	ccColor4F prevClearColor = glesState.clearColor.value;
+	glesState.clearColor.value = kCCC4FWhite;
+	glesState.depthMask.value = YES;
+	[glesState clearBuffers: (GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT)];
+
+	[glesProjMtx push];
+	[glesMVMtx push];
+
+	GLuint cols = self.atlasColumnCount;
+	for (GLuint cIdx = 0; cIdx < _activeCascadeCount; cIdx++) {
+		glesState.viewport.value = CC3ViewportMake((cIdx % cols) * _mapSize, (cIdx / cols) * _mapSize,
+												   _mapSize, _mapSize);
+		[glesProjMtx load: &_projectionMatrices[cIdx]];
+		[glesMVMtx load: &_viewMatrices[cIdx]];
+		for (CC3Node* caster in _cascadeCasters[cIdx]) [visitor visit: caster];
+	}
+
+	[glesMVMtx pop];
+	[glesProjMtx pop];
+
+	glesState.viewport.value = prevViewport;
+	glesState.clearColor.value = prevClearColor;
+	glBindFramebuffer(GL_FRAMEBUFFER, prevFrameBuffer);
+}
+
+-(void) bindToTextureUnit: (GLuint) texUnit {
+	if ( !_textureID ) return;
+	_textureUnit = texUnit;
+	CC3OpenGLESTextureUnit* glesTexUnit = [CC3OpenGLESEngine.engine.textures textureUnitAt: texUnit];
+	[glesTexUnit activate];
+	glesTexUnit.textureBinding.value = _textureID;
+}
+
+#else
+
+-(BOOL) ensureGLBuffers { return NO; }
+
+-(void) deleteGLBuffers {}
+
+-(void) drawWithVisitor: (CC3NodeDrawingVisitor*) visitor {}
+
+-(void) bindToTextureUnit: (GLuint) texUnit {}
+
+#endif
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3ShadowMapDrawingVisitor
+
+@implementation CC3ShadowMapDrawingVisitor
+
+/**
+ * Overridden to draw nodes undecorated, to draw only the node being visited, and to avoid
+ * clearing the depth buffer between casters, since the shadow map clears its own buffers.
+ */
+-(id) init {
+	if ( (self = [super init]) ) {
+		shouldDecorateNode = NO;
+		shouldClearDepthBuffer = NO;
+		shouldVisitChildren = NO;
+	}
+	return self;
+}
+
+/**
+ * Overridden because the casters have already been selected and culled by the shadow map,
+ * and because the frustum of the camera is not relevant when drawing from the light.
+ */
+-(BOOL) shouldDrawNode: (CC3Node*) aNode { return aNode.hasLocalContent; }
+
+/** Overridden to pack the depth of each fragment into its color. */
+-(void) bindUndecoratedProgram {
+	[CC3OpenGLESEngine.engine.shaders bindShadowMapDepthProgramWithVisitor: self];
+}
+
+@end
@@ -70,16 +70,30 @@ static const GLfloat kCC3DefaultShadowVolumeVertexOffsetFactor = 0.001;
  */
 @interface CC3ShadowVolumeMeshNode : CC3MeshNode <CC3ShadowProtocol> {
 	CC3Light* light;
+	GLubyte* faceIllumination;
+	struct CC3ShadowTerminatorEdge* terminatorEdges;
+	GLuint* flippedFaces;
+	CC3Vector4 cachedLightPosition;
+	CC3Vector4 cachedVertexNudge;
+	GLfloat cachedExpansionLimitFactor;
+	GLuint cachedFaceCount;
+	GLuint terminatorEdgeCount;
+	GLuint terminatorEdgeCapacity;
 	GLushort shadowLagFactor;
 	GLushort shadowLagCount;
 	GLfloat shadowVolumeVertexOffsetFactor;
 	GLfloat shadowExpansionLimitFactor;
+	GLubyte cachedShadowMode;
 	BOOL isShadowDirty : 1;
 	BOOL shouldDrawTerminator : 1;
 	BOOL shouldShadowFrontFaces : 1;
 	BOOL shouldShadowBackFaces : 1;
 	BOOL useDepthFailAlgorithm : 1;
 	BOOL shouldAddEndCapsOnlyWhenNeeded : 1;
+	BOOL shouldCacheShadowVolume : 1;
+	BOOL hasCachedShadow : 1;
+	BOOL wasShadowReused : 1;
+	BOOL wasShadowUpdatedIncrementally : 1;
 }
 
 /**
@@ -94,6 +108,35 @@ static const GLfloat kCC3DefaultShadowVolumeVertexOffsetFactor = 0.001;
  */
 @property(nonatomic, assign) BOOL shouldDrawTerminator;
 
+/**
+ * Returns whether the shadow cast by this shadow volume will be visible.
+ *
+ * The shadow is not visible if either the light or the shadow-casting node is invisible, and
+ * is not set to cast shadows when invisible. The shadow is also not visible if the shadow-casting
+ * node lies outside the shadowCastingVolume of the light, or if the volume swept out by the
+ * bounding sphere of the shadow-casting node, as it is extruded away from the light to the
+ * shadowRange of the light, does not intersect the frustum of the camera.
+ */
+@property(nonatomic, readonly) BOOL isShadowVisible;
+
+/**
+ * Returns whether the content of the shadow volume mesh was left unchanged during the most
+ * recent update of this shadow volume, because the location of the light, relative to the
+ * shadow-casting node, had not changed since the mesh was last populated.
+ *
+ * See the notes for the shouldCacheShadowVolumes property of CC3Node for more information.
+ */
+@property(nonatomic, readonly) BOOL wasShadowReused;
+
+/**
+ * Returns whether the terminator of the shadow-casting node was updated incrementally during
+ * the most recent update of this shadow volume, by re-examining only the edges of those faces
+ * whose illumination changed since the previous update.
+ *
+ * See the notes for the shouldCacheShadowVolumes property of CC3Node for more information.
+ */
+@property(nonatomic, readonly) BOOL wasShadowUpdatedIncrementally;
+
 // TODO: will change when polymorphism has been figured out
 /**
  * Draws this node to a stencil. The stencil is marked wherever another node
@@ -638,6 +681,38 @@ static const GLfloat kCC3DefaultShadowVolumeVertexOffsetFactor = 0.001;
  */
 @property(nonatomic, assign) BOOL shouldShadowBackFaces;
 
+/**
+ * Indicates whether shadow volumes should retain the illumination of each face of the
+ * shadow-casting mesh, and the terminator edges found from that illumination, between
+ * updates, so that they can avoid repeating the search for the terminator of the mesh.
+ *
+ * When this property is set to YES, the location of the light, in the local coordinate
+ * system of the shadow-casting node, is recorded each time the shadow volume mesh is
+ * populated. When the shadow is marked dirty, the shadow volume mesh is handled as follows:
+ *   - If neither the local location of the light, nor any property that affects the
+ *     construction of the shadow volume, has changed, the existing mesh is reused unchanged.
+ *     This is the case when the light and the shadow-casting node are moved together, for
+ *     example when they share a parent node that is moving. The shadow volume of a node that
+ *     is deformed by vertex skinning is never reused, since its faces may have moved.
+ *   - Otherwise, the illumination of each face is re-evaluated, and, if the illumination of
+ *     only a small fraction of the faces has changed, only the edges of those faces are
+ *     re-examined to update the terminator. If the illumination of many faces has changed,
+ *     the terminator is rebuilt by examining every edge of the mesh.
+ *
+ * In either of the latter cases, the sides and end caps of the shadow volume are then
+ * regenerated from the terminator, since their extrusion depends on the location of the light.
+ *
+ * Retaining this information requires a small amount of memory for each face of the mesh of
+ * the shadow-casting node. The initial value of this property is YES.
+ *
+ * Setting this value sets the same property on all descendant nodes that are shadows.
+ *
+ * Querying this property returns the first NO value of this property from any
+ * descendant shadow node, or will return YES if no shadow nodes are found in
+ * the descendants of this node.
+ */
+@property(nonatomic, assign) BOOL shouldCacheShadowVolumes;
+
 @end
 
 
@@ -53,11 +53,67 @@
 #pragma mark -
 #pragma mark CC3ShadowVolumeMeshNode
 
+/** A terminator edge, identified by the face that owns it and the index of the edge in that face. */
+struct CC3ShadowTerminatorEdge {
+	GLuint faceIndex;
+	GLuint edgeIndex;
+};
+typedef struct CC3ShadowTerminatorEdge CC3ShadowTerminatorEdge;
+
+/** Flags held for each face of the shadow caster while caching a shadow volume. */
+#define kCC3ShadowFaceLit					0x01
+#define kCC3ShadowFaceFlipped				0x02
+
+/** Bits of the shadow mode, identifying the properties that affect the shadow volume mesh. */
+#define kCC3ShadowModeCapped				0x01
+#define kCC3ShadowModeTerminator			0x02
+#define kCC3ShadowModeVisible				0x04
+#define kCC3ShadowModeFrontFaces			0x08
+#define kCC3ShadowModeBackFaces				0x10
+#define kCC3ShadowModeEdgeMask				(kCC3ShadowModeFrontFaces | kCC3ShadowModeBackFaces)
+
+/** The tolerance, relative to the length of the vectors, within which a cached shadow is reused. */
+#define kCC3ShadowCacheTolerance			1.0e-5f
+
+/** The fraction of faces that may change illumination for the terminator to be updated incrementally. */
+#define kCC3ShadowIncrementalFaceFraction	0.25f
+
+/** Returns whether the two vectors are equal, to within kCC3ShadowCacheTolerance. */
+static BOOL CC3ShadowVector4sAreClose(CC3Vector4 v1, CC3Vector4 v2) {
+	GLfloat tolerance = kCC3ShadowCacheTolerance * MAX(CC3Vector4Length(v1), 1.0f);
+	return CC3Vector4Length(CC3Vector4Difference(v1, v2)) <= tolerance;
+}
+
 @interface CC3ShadowVolumeMeshNode (TemplateMethods)
 -(void) createShadowMesh;
 -(void) checkShadowMaterial;
 -(void) populateShadowMesh;
+-(void) populateShadowMeshFromAllFacesForLightAt: (CC3Vector4) localLightPosition
+									   withNudge: (CC3Vector4) svVtxNudge
+									 withCapping: (BOOL) doesRequireCapping;
+-(void) populateShadowMeshFromTerminatorForLightAt: (CC3Vector4) localLightPosition
+										 withNudge: (CC3Vector4) svVtxNudge
+									   withCapping: (BOOL) doesRequireCapping;
+-(void) getShadowFaceAt: (GLuint) faceIdx nudgedBy: (CC3Vector4) svVtxNudge into: (CC3Vector4*) vertices4d;
+-(BOOL) addShadowVolumeSideForEdge: (GLuint) edgeIdx
+							ofFace: (CC3Vector4*) vertices4d
+							 isLit: (BOOL) isFaceLit
+					   withCapping: (BOOL) doesRequireCapping
+						forLightAt: (CC3Vector4) localLightPosition
+				   startingAtIndex: (GLuint*) shdwVtxIdx;
+-(void) updateShadowMeshVertexCount: (GLuint) shdwVtxCount wasExpanded: (BOOL) wasMeshExpanded;
+-(GLubyte) shadowModeWithCapping: (BOOL) doesRequireCapping;
+-(BOOL) canReuseShadowForLightAt: (CC3Vector4) localLightPosition
+					   withNudge: (CC3Vector4) svVtxNudge
+						  inMode: (GLubyte) shadowMode;
+-(BOOL) updateTerminatorForLightAt: (CC3Vector4) localLightPosition inMode: (GLubyte) shadowMode;
+-(void) rebuildTerminatorEdges;
+-(void) updateTerminatorEdgesForFlippedFaces: (GLuint) flippedCnt;
+-(void) checkTerminatorEdge: (GLuint) edgeIdx ofFace: (GLuint) faceIdx withNeighbour: (GLuint) neighbourFaceIdx;
+-(BOOL) ensureShadowCacheForFaceCount: (GLuint) faceCnt;
+-(void) releaseShadowCache;
 -(void) updateStencilAlgorithm;
+-(BOOL) doesShadowIntersectFrustum;
 -(CC3Vector4) shadowVolumeVertexOffsetForLightAt: (CC3Vector4) localLightPos;
 -(BOOL) addShadowVolumeCapFor: (BOOL) isFaceLit
 						 face: (CC3Vector4*) vertices
@@ -89,6 +145,7 @@
 @synthesize light, shouldDrawTerminator;
 
 -(void) dealloc {
+	[self releaseShadowCache];
 	[light removeShadow: self];		// Will also set light to nil
 	LogTrace(@"Removed %@ from %@ leaving %i shadows", self, light, light.shadows.count);
 	[super dealloc];
@@ -189,6 +246,14 @@
 	super.shouldAddShadowVolumeEndCapsOnlyWhenNeeded = onlyWhenNeeded;
 }
 
+-(BOOL) shouldCacheShadowVolumes { return shouldCacheShadowVolume; }
+
+-(void) setShouldCacheShadowVolumes: (BOOL) shouldCache {
+	shouldCacheShadowVolume = shouldCache;
+	if ( !shouldCache ) [self releaseShadowCache];
+	super.shouldCacheShadowVolumes = shouldCache;
+}
+
 -(BOOL) hasShadowVolumesForLight: (CC3Light*) aLight { return YES; }
 
 -(BOOL) hasShadowVolumes { return YES; }
@@ -214,6 +279,16 @@
 		self.shadowOffsetUnits = -1;
 		shadowVolumeVertexOffsetFactor = 0;
 		shadowExpansionLimitFactor = 100;
+		shouldCacheShadowVolume = YES;
+		hasCachedShadow = NO;
+		wasShadowReused = NO;
+		wasShadowUpdatedIncrementally = NO;
+		faceIllumination = NULL;
+		terminatorEdges = NULL;
+		flippedFaces = NULL;
+		cachedFaceCount = 0;
+		terminatorEdgeCount = 0;
+		terminatorEdgeCapacity = 0;
 		self.pureColor = kCCC4FYellow;		// For terminator lines
 	}
 	return self;
@@ -239,6 +314,7 @@
 	shadowLagCount = another.shadowLagCount;
 	shadowVolumeVertexOffsetFactor = another.shadowVolumeVertexOffsetFactor;
 	shadowExpansionLimitFactor = another.shadowExpansionLimitFactor;
+	shouldCacheShadowVolume = another.shouldCacheShadowVolumes;
 }
 
 /**
@@ -282,6 +358,7 @@
 	CC3VertexArrayMesh* aMesh = [CC3VertexArrayMesh mesh];
 	aMesh.vertexLocations = locArray;
 	self.mesh = aMesh;
+	hasCachedShadow = NO;
 }
 
 /**
@@ -319,11 +396,9 @@
 }
 
 /**
- * Populates the shadow volume mesh by iterating through all the faces in the mesh of
- * the shadow casting node, looking for all pairs of neighbouring faces where one face
- * is in illuminated (facing towards the light) and the other is dark (facing away from
- * the light). The set of edges between these pairs forms the terminator of the mesh,
- * where the mesh on one side of the terminator is illuminated and the other is dark.
+ * Populates the shadow volume mesh from the terminator of the mesh of the shadow casting node,
+ * which is the set of edges between pairs of neighbouring faces where one face is illuminated
+ * (facing towards the light) and the other is dark (facing away from the light).
  *
  * The shadow volume is then constructed by extruding each edge line segment in the
  * terminator out to infinity in the direction away from the light source, forming a
@@ -332,13 +407,16 @@
  * Uses the 4D homogeneous location of the light in the global coordinate system.
  * When using the light location this method transforms this location to the local
  * coordinates system of the shadow caster.
+ *
+ * If the shouldCacheShadowVolumes property is set to YES, the existing mesh is reused if
+ * nothing affecting it has changed since it was last populated, and otherwise the terminator
+ * is found from the terminator of the previous update, if possible. If the shouldCacheShadowVolumes
+ * property is set to NO, or the cache cannot be allocated, the terminator is found by examining
+ * every edge of the mesh of the shadow casting node.
  */
 -(void) populateShadowMesh {
 	
 	CC3MeshNode* scNode = self.shadowCaster;
-	GLuint faceCnt = scNode.faceCount;
-	GLuint shdwVtxIdx = 0;
-	BOOL wasMeshExpanded = NO;
 	BOOL doesRequireCapping = useDepthFailAlgorithm || !shouldAddEndCapsOnlyWhenNeeded;
 	
 	// Transform the 4D position of the light into the local coordinates of the shadow caster.
@@ -347,21 +425,12 @@
 									 transformHomogeneousVector: lightPosition];
 	
 	// Determine whether we want to nudge the shadow volume vertices away from the shadow caster
-	BOOL isNudgingVertices = (shadowVolumeVertexOffsetFactor != 0.0f);
-	CC3Vector4 svVtxNudge = isNudgingVertices
+	CC3Vector4 svVtxNudge = (shadowVolumeVertexOffsetFactor != 0.0f)
 								? [self shadowVolumeVertexOffsetForLightAt: localLightPosition]
 								: kCC3Vector4Zero;
 	
-	//	if (doesRequireCapping) LogDebug(@"Populating %@ with end caps", self);
-	
-	//	if ( [scNode.name isEqualToString: @"GeoSphere01"] ) {
-	//		LogDebug(@"Populating %@ with %i faces for light at %@ and %@ end caps",
-	//					  self, faceCnt, NSStringFromCC3Vector4(lightPosition),
-	//					  (doesRequireCapping ? @"including" : @"excluding"));
-	//	}
-	
 	LogTrace(@"Populating %@ with %i faces for light at %@ and %@ end caps",
-				  self, faceCnt, NSStringFromCC3Vector4(lightPosition),
+				  self, scNode.faceCount, NSStringFromCC3Vector4(lightPosition),
 				  (doesRequireCapping ? @"including" : @"excluding"));
 	
 	LogTrace(@"%@ global light location: %@ shadow local light: %@ %@ inverted: %@",
@@ -370,23 +439,54 @@
 				  scNode.transformMatrix,
 				  scNode.transformMatrixInverted);
 	
+	wasShadowReused = NO;
+	wasShadowUpdatedIncrementally = NO;
+	GLubyte shadowMode = [self shadowModeWithCapping: doesRequireCapping];
+	
+	if (shouldCacheShadowVolume) {
+		if ( [self canReuseShadowForLightAt: localLightPosition withNudge: svVtxNudge inMode: shadowMode] ) {
+			LogTrace(@"%@ reusing shadow volume for local light at %@",
+					 self, NSStringFromCC3Vector4(localLightPosition));
+			wasShadowReused = YES;
+			return;
+		}
+		if ( [self updateTerminatorForLightAt: localLightPosition inMode: shadowMode] ) {
+			[self populateShadowMeshFromTerminatorForLightAt: localLightPosition
+												   withNudge: svVtxNudge
+												   withCapping: doesRequireCapping];
+			cachedLightPosition = localLightPosition;
+			cachedVertexNudge = svVtxNudge;
+			cachedExpansionLimitFactor = shadowExpansionLimitFactor;
+			cachedShadowMode = shadowMode;
+			hasCachedShadow = YES;
+			return;
+		}
+	}
+	[self populateShadowMeshFromAllFacesForLightAt: localLightPosition
+										 withNudge: svVtxNudge
+									   withCapping: doesRequireCapping];
+}
+
+/**
+ * Populates the shadow volume mesh by iterating through all the faces in the mesh of
+ * the shadow casting node, looking for all pairs of neighbouring faces where one face
+ * is illuminated and the other is dark, and extruding the edge between them.
+ */
+-(void) populateShadowMeshFromAllFacesForLightAt: (CC3Vector4) localLightPosition
+									   withNudge: (CC3Vector4) svVtxNudge
+									 withCapping: (BOOL) doesRequireCapping {
+	
+	CC3MeshNode* scNode = self.shadowCaster;
+	GLuint faceCnt = scNode.faceCount;
+	GLuint shdwVtxIdx = 0;
+	BOOL wasMeshExpanded = NO;
+	
 	// Iterate through all the faces in the mesh of the shadow caster.
 	for (GLuint faceIdx = 0; faceIdx < faceCnt; faceIdx++) {
 		
-		// Retrieve the current face, convert it to 4D homogeneous locations
-		CC3Face face = [scNode deformedFaceAt: faceIdx];
+		// Retrieve the current face, as 4D homogeneous locations, nudged if needed
 		CC3Vector4 vertices4d[3];
-		vertices4d[0] = CC3Vector4FromLocation(face.vertices[0]);
-		vertices4d[1] = CC3Vector4FromLocation(face.vertices[1]);
-		vertices4d[2] = CC3Vector4FromLocation(face.vertices[2]);
-		
-		// If needed, nudge the shadow volume face away from the
-		// shadow caster face in the direction away from the light
-		if (isNudgingVertices) {
-			vertices4d[0] = CC3Vector4Add(vertices4d[0], svVtxNudge);
-			vertices4d[1] = CC3Vector4Add(vertices4d[1], svVtxNudge);
-			vertices4d[2] = CC3Vector4Add(vertices4d[2], svVtxNudge);
-		}
+		[self getShadowFaceAt: faceIdx nudgedBy: svVtxNudge into: vertices4d];
 		
 		// Determine whether the face is illuminated.
 		BOOL isFaceLit = CC3Vector4IsInFrontOfPlane(localLightPosition, [scNode deformedFacePlaneAt: faceIdx]);
@@ -441,39 +541,12 @@
 							  neighbourFaceIdx, ((neighbourFaceIdx == kCC3FaceNoNeighbour)
 												 ? @"missing" 
 												 : (isFaceLit ? @"dark" : @"illuminated")));
-				
-				// Get the end points of the terminator edge that we will be extruding.
-				// To have the normals of the shadow volume mesh point outwards, we want the
-				// winding of the extruded face to be the same as the dark face. So, choose
-				// the start and end of the edge based on which face of this pair is illuminated.
-				CC3Vector4 edgeStartLoc, edgeEndLoc;
-				if (isFaceLit) {
-					edgeStartLoc = vertices4d[edgeIdx];
-					edgeEndLoc = vertices4d[(edgeIdx < 2) ? (edgeIdx + 1) : 0];
-				} else {
-					edgeStartLoc = vertices4d[(edgeIdx < 2) ? (edgeIdx + 1) : 0];
-					edgeEndLoc = vertices4d[edgeIdx];
-				}
-				
-				if (self.shouldDrawTerminator && self.visible) {
-					// Draw the terminator line instead of a shadow
-					wasMeshExpanded |= [self addTerminatorLineFrom: edgeStartLoc
-																to: edgeEndLoc
-												   startingAtIndex: &shdwVtxIdx];
-				} else if (CC3Vector4IsDirectional(localLightPosition)) {
-					// Draw the shadow from a directional light
-					wasMeshExpanded |= [self addShadowVolumeSideFrom: edgeStartLoc
-																  to: edgeEndLoc
-											   forDirectionalLightAt: localLightPosition
-													 startingAtIndex: &shdwVtxIdx];
-				} else {
-					// Draw the shadow from a locational light, possibly closing off the far end
-					wasMeshExpanded |= [self addShadowVolumeSideFrom: edgeStartLoc
-																  to: edgeEndLoc
-															 withCap: doesRequireCapping
-												forLocationalLightAt: localLightPosition
-													 startingAtIndex: &shdwVtxIdx];
-				}
+				wasMeshExpanded |= [self addShadowVolumeSideForEdge: edgeIdx
+															 ofFace: vertices4d
+															  isLit: isFaceLit
+														withCapping: doesRequireCapping
+														 forLightAt: localLightPosition
+													startingAtIndex: &shdwVtxIdx];
 			} else {
 				LogTrace(@"\tNeighbouring face %u is %@. Not a terminator edge.",
 							  neighbourFaceIdx, (isFaceLit ? @"illuminated" : @"dark"));
@@ -481,12 +554,128 @@
 		}
 	}
 	
-	// Update the vertex count of the shadow volume mesh, based on how many sides we've added.
-	mesh.vertexCount = shdwVtxIdx;
-	LogTrace(@"%@ setting vertex count to %u", self, shdwVtxIdx);
+	[self updateShadowMeshVertexCount: shdwVtxIdx wasExpanded: wasMeshExpanded];
+}
+
+/**
+ * Populates the shadow volume mesh from the face illumination and terminator edges that
+ * were found by the updateTerminatorForLightAt:inMode: method.
+ *
+ * The end caps and sides are added using the same winding as when iterating all of the
+ * faces, but the end caps are added before the sides.
+ */
+-(void) populateShadowMeshFromTerminatorForLightAt: (CC3Vector4) localLightPosition
+										 withNudge: (CC3Vector4) svVtxNudge
+									   withCapping: (BOOL) doesRequireCapping {
+	
+	CC3MeshNode* scNode = self.shadowCaster;
+	GLuint faceCnt = scNode.faceCount;
+	GLuint shdwVtxIdx = 0;
+	BOOL wasMeshExpanded = NO;
+	CC3Vector4 vertices4d[3];
+	
+	// Add the end caps from the faces that form them.
+	if (doesRequireCapping && !shouldDrawTerminator) {
+		for (GLuint faceIdx = 0; faceIdx < faceCnt; faceIdx++) {
+			BOOL isFaceLit = (faceIllumination[faceIdx] & kCC3ShadowFaceLit) != 0;
+			if (isFaceLit ? shouldShadowBackFaces : shouldShadowFrontFaces) {
+				[self getShadowFaceAt: faceIdx nudgedBy: svVtxNudge into: vertices4d];
+				wasMeshExpanded |= [self addShadowVolumeCapFor: isFaceLit
+														  face: vertices4d
+													forLightAt: localLightPosition
+											   startingAtIndex: &shdwVtxIdx];
+			}
+		}
+	}
+	
+	// Extrude each terminator edge, from the face that owns it.
+	for (GLuint i = 0; i < terminatorEdgeCount; i++) {
+		CC3ShadowTerminatorEdge edge = terminatorEdges[i];
+		[self getShadowFaceAt: edge.faceIndex nudgedBy: svVtxNudge into: vertices4d];
+		wasMeshExpanded |= [self addShadowVolumeSideForEdge: edge.edgeIndex
+													 ofFace: vertices4d
+													  isLit: ((faceIllumination[edge.faceIndex] & kCC3ShadowFaceLit) != 0)
+												withCapping: doesRequireCapping
+												 forLightAt: localLightPosition
+											startingAtIndex: &shdwVtxIdx];
+	}
+	
+	[self updateShadowMeshVertexCount: shdwVtxIdx wasExpanded: wasMeshExpanded];
+}
+
+/**
+ * Retrieves the face at the specified index from the mesh of the shadow caster, converts it
+ * to 4D homogeneous locations, and nudges it by the specified offset, if it is not zero.
+ */
+-(void) getShadowFaceAt: (GLuint) faceIdx nudgedBy: (CC3Vector4) svVtxNudge into: (CC3Vector4*) vertices4d {
+	CC3Face face = [self.shadowCaster deformedFaceAt: faceIdx];
+	vertices4d[0] = CC3Vector4FromLocation(face.vertices[0]);
+	vertices4d[1] = CC3Vector4FromLocation(face.vertices[1]);
+	vertices4d[2] = CC3Vector4FromLocation(face.vertices[2]);
+	
+	// If needed, nudge the shadow volume face away from the
+	// shadow caster face in the direction away from the light
+	if ( !CC3Vector4sAreEqual(svVtxNudge, kCC3Vector4Zero) ) {
+		vertices4d[0] = CC3Vector4Add(vertices4d[0], svVtxNudge);
+		vertices4d[1] = CC3Vector4Add(vertices4d[1], svVtxNudge);
+		vertices4d[2] = CC3Vector4Add(vertices4d[2], svVtxNudge);
+	}
+}
+
+/**
+ * Adds the terminator line, or the side of the shadow volume, that is formed from the edge at
+ * the specified index in the specified face, which is illuminated if isFaceLit is YES.
+ */
+-(BOOL) addShadowVolumeSideForEdge: (GLuint) edgeIdx
+							ofFace: (CC3Vector4*) vertices4d
+							 isLit: (BOOL) isFaceLit
+					   withCapping: (BOOL) doesRequireCapping
+						forLightAt: (CC3Vector4) localLightPosition
+				   startingAtIndex: (GLuint*) shdwVtxIdx {
+	
+	// Get the end points of the terminator edge that we will be extruding.
+	// To have the normals of the shadow volume mesh point outwards, we want the
+	// winding of the extruded face to be the same as the dark face. So, choose
+	// the start and end of the edge based on which face of this pair is illuminated.
+	CC3Vector4 edgeStartLoc, edgeEndLoc;
+	if (isFaceLit) {
+		edgeStartLoc = vertices4d[edgeIdx];
+		edgeEndLoc = vertices4d[(edgeIdx < 2) ? (edgeIdx + 1) : 0];
+	} else {
+		edgeStartLoc = vertices4d[(edgeIdx < 2) ? (edgeIdx + 1) : 0];
+		edgeEndLoc = vertices4d[edgeIdx];
+	}
+	
+	if (self.shouldDrawTerminator && self.visible) {
+		// Draw the terminator line instead of a shadow
+		return [self addTerminatorLineFrom: edgeStartLoc
+										to: edgeEndLoc
+						   startingAtIndex: shdwVtxIdx];
+	} else if (CC3Vector4IsDirectional(localLightPosition)) {
+		// Draw the shadow from a directional light
+		return [self addShadowVolumeSideFrom: edgeStartLoc
+										  to: edgeEndLoc
+					   forDirectionalLightAt: localLightPosition
+							 startingAtIndex: shdwVtxIdx];
+	} else {
+		// Draw the shadow from a locational light, possibly closing off the far end
+		return [self addShadowVolumeSideFrom: edgeStartLoc
+										  to: edgeEndLoc
+									 withCap: doesRequireCapping
+						forLocationalLightAt: localLightPosition
+							 startingAtIndex: shdwVtxIdx];
+	}
+}
+
+/**
+ * Sets the vertex count of the shadow volume mesh, based on how many sides have been added.
+ * If the mesh is using GL VBO's, update them. If the mesh was expanded, recreate the VBO's,
+ * otherwise update them.
+ */
+-(void) updateShadowMeshVertexCount: (GLuint) shdwVtxCount wasExpanded: (BOOL) wasMeshExpanded {
+	mesh.vertexCount = shdwVtxCount;
+	LogTrace(@"%@ setting vertex count to %u", self, shdwVtxCount);
 	
-	// If the mesh is using GL VBO's, update them. If the mesh was expanded,
-	// recreate the VBO's, otherwise update them.
 	if (mesh.isUsingGLBuffers) {
 		if (wasMeshExpanded) {
 			[mesh deleteGLBuffers];
@@ -498,6 +687,211 @@
 	LogTrace(@"Finshed populating %@", self);
 }
 
+
+#pragma mark Shadow caching
+
+-(BOOL) wasShadowReused { return wasShadowReused; }
+
+-(BOOL) wasShadowUpdatedIncrementally { return wasShadowUpdatedIncrementally; }
+
+/** Returns a bitmask of the properties that affect the content of the shadow volume mesh. */
+-(GLubyte) shadowModeWithCapping: (BOOL) doesRequireCapping {
+	return (doesRequireCapping ? kCC3ShadowModeCapped : 0) |
+			(shouldDrawTerminator ? kCC3ShadowModeTerminator : 0) |
+			(self.visible ? kCC3ShadowModeVisible : 0) |
+			(shouldShadowFrontFaces ? kCC3ShadowModeFrontFaces : 0) |
+			(shouldShadowBackFaces ? kCC3ShadowModeBackFaces : 0);
+}
+
+/**
+ * Returns whether the existing shadow volume mesh can be reused unchanged. It can if it was
+ * populated from the cache, using the same local light location and vertex nudge, to within
+ * kCC3ShadowCacheTolerance, and the same shadow mode and expansion limit, and the mesh of the
+ * shadow caster is not deformed by vertex skinning.
+ */
+-(BOOL) canReuseShadowForLightAt: (CC3Vector4) localLightPosition
+					   withNudge: (CC3Vector4) svVtxNudge
+						  inMode: (GLubyte) shadowMode {
+	CC3MeshNode* scNode = self.shadowCaster;
+	return hasCachedShadow &&
+			shadowMode == cachedShadowMode &&
+			shadowExpansionLimitFactor == cachedExpansionLimitFactor &&
+			scNode.faceCount == cachedFaceCount &&
+			!scNode.hasSoftBodyContent &&
+			CC3ShadowVector4sAreClose(localLightPosition, cachedLightPosition) &&
+			CC3ShadowVector4sAreClose(svVtxNudge, cachedVertexNudge);
+}
+
+/**
+ * Updates the illumination of each face of the mesh of the shadow caster, and the terminator
+ * edges of that mesh, for the light at the specified location.
+ *
+ * If the terminator edges held from the previous update are compatible with the specified
+ * shadow mode, and the illumination of no more than kCC3ShadowIncrementalFaceFraction of
+ * the faces has changed, only the edges of the faces whose illumination changed are
+ * re-examined. Otherwise, every edge of the mesh is examined.
+ *
+ * Returns NO if the cache could not be allocated, in which case the shadow volume
+ * mesh should be populated directly from the faces of the mesh of the shadow caster.
+ */
+-(BOOL) updateTerminatorForLightAt: (CC3Vector4) localLightPosition inMode: (GLubyte) shadowMode {
+	CC3MeshNode* scNode = self.shadowCaster;
+	GLuint faceCnt = scNode.faceCount;
+	BOOL canUpdateIncrementally = hasCachedShadow &&
+									faceCnt == cachedFaceCount &&
+									(shadowMode & kCC3ShadowModeEdgeMask) == (cachedShadowMode & kCC3ShadowModeEdgeMask);
+	hasCachedShadow = NO;
+	if (faceCnt == 0 || ![self ensureShadowCacheForFaceCount: faceCnt]) return NO;
+	
+	// Determine the illumination of each face, and mark those faces whose illumination changed.
+	GLuint flippedCnt = 0;
+	for (GLuint faceIdx = 0; faceIdx < faceCnt; faceIdx++) {
+		GLubyte isLit = CC3Vector4IsInFrontOfPlane(localLightPosition, [scNode deformedFacePlaneAt: faceIdx])
+							? kCC3ShadowFaceLit : 0;
+		if (isLit != faceIllumination[faceIdx]) {
+			faceIllumination[faceIdx] = isLit | kCC3ShadowFaceFlipped;
+			flippedFaces[flippedCnt++] = faceIdx;
+		}
+	}
+	
+	if (canUpdateIncrementally && flippedCnt <= (faceCnt * kCC3ShadowIncrementalFaceFraction)) {
+		LogTrace(@"%@ updating terminator incrementally for %u of %u faces", self, flippedCnt, faceCnt);
+		[self updateTerminatorEdgesForFlippedFaces: flippedCnt];
+		wasShadowUpdatedIncrementally = YES;
+	} else {
+		LogTrace(@"%@ rebuilding terminator after %u of %u faces changed", self, flippedCnt, faceCnt);
+		[self rebuildTerminatorEdges];
+	}
+	
+	// Clear the markers of the faces whose illumination changed.
+	for (GLuint i = 0; i < flippedCnt; i++) {
+		faceIllumination[flippedFaces[i]] &= kCC3ShadowFaceLit;
+	}
+	return YES;
+}
+
+/** Rebuilds the terminator edges by examining every edge of the mesh of the shadow caster. */
+-(void) rebuildTerminatorEdges {
+	CC3MeshNode* scNode = self.shadowCaster;
+	GLuint faceCnt = scNode.faceCount;
+	terminatorEdgeCount = 0;
+	for (GLuint faceIdx = 0; faceIdx < faceCnt; faceIdx++) {
+		CC3FaceNeighbours neighbours = [scNode faceNeighboursAt: faceIdx];
+		for (GLuint edgeIdx = 0; edgeIdx < 3; edgeIdx++) {
+			GLuint neighbourFaceIdx = neighbours.edges[edgeIdx];
+			if (neighbourFaceIdx == kCC3FaceNoNeighbour || neighbourFaceIdx > faceIdx) {
+				[self checkTerminatorEdge: edgeIdx ofFace: faceIdx withNeighbour: neighbourFaceIdx];
+			}
+		}
+	}
+}
+
+/**
+ * Updates the terminator edges after the illumination of the specified number of faces,
+ * held in the flippedFaces array, has changed.
+ *
+ * Edges of faces whose illumination has not changed remain part of the terminator, or not, as
+ * before. So only the edges that border a face whose illumination has changed are removed, and
+ * those edges are then re-examined. As with the full rebuild, each edge is owned by the face
+ * with the lower index, so an edge shared by two changed faces is re-examined only once.
+ */
+-(void) updateTerminatorEdgesForFlippedFaces: (GLuint) flippedCnt {
+	CC3MeshNode* scNode = self.shadowCaster;
+	
+	// Remove the edges that border a face whose illumination changed, compacting the list.
+	GLuint keptCnt = 0;
+	for (GLuint i = 0; i < terminatorEdgeCount; i++) {
+		CC3ShadowTerminatorEdge edge = terminatorEdges[i];
+		GLuint neighbourFaceIdx = [scNode faceNeighboursAt: edge.faceIndex].edges[edge.edgeIndex];
+		BOOL isFlipped = (faceIllumination[edge.faceIndex] & kCC3ShadowFaceFlipped) ||
+						 (neighbourFaceIdx != kCC3FaceNoNeighbour &&
+						  (faceIllumination[neighbourFaceIdx] & kCC3ShadowFaceFlipped));
+		if ( !isFlipped ) terminatorEdges[keptCnt++] = edge;
+	}
+	terminatorEdgeCount = keptCnt;
+	
+	// Re-examine each edge of each face whose illumination changed.
+	for (GLuint i = 0; i < flippedCnt; i++) {
+		GLuint faceIdx = flippedFaces[i];
+		CC3FaceNeighbours neighbours = [scNode faceNeighboursAt: faceIdx];
+		for (GLuint edgeIdx = 0; edgeIdx < 3; edgeIdx++) {
+			GLuint neighbourFaceIdx = neighbours.edges[edgeIdx];
+			if (neighbourFaceIdx == kCC3FaceNoNeighbour || neighbourFaceIdx > faceIdx) {
+				[self checkTerminatorEdge: edgeIdx ofFace: faceIdx withNeighbour: neighbourFaceIdx];
+			} else if (neighbourFaceIdx < faceIdx &&
+					   !(faceIllumination[neighbourFaceIdx] & kCC3ShadowFaceFlipped)) {
+				// The edge is owned by the unchanged neighbour. Find the edge within that face.
+				CC3FaceNeighbours nbrNeighbours = [scNode faceNeighboursAt: neighbourFaceIdx];
+				for (GLuint nbrEdgeIdx = 0; nbrEdgeIdx < 3; nbrEdgeIdx++) {
+					if (nbrNeighbours.edges[nbrEdgeIdx] == faceIdx) {
+						[self checkTerminatorEdge: nbrEdgeIdx ofFace: neighbourFaceIdx withNeighbour: faceIdx];
+					}
+				}
+			}
+		}
+	}
+}
+
+/**
+ * Adds the edge at the specified index in the specified face to the terminator edges, if it is
+ * part of the terminator, based on the current illumination of the face and its neighbour.
+ */
+-(void) checkTerminatorEdge: (GLuint) edgeIdx ofFace: (GLuint) faceIdx withNeighbour: (GLuint) neighbourFaceIdx {
+	BOOL isFaceLit = (faceIllumination[faceIdx] & kCC3ShadowFaceLit) != 0;
+	BOOL isTerminatorEdge = (neighbourFaceIdx == kCC3FaceNoNeighbour)
+								? (isFaceLit ? shouldShadowFrontFaces : shouldShadowBackFaces)
+								: (isFaceLit != ((faceIllumination[neighbourFaceIdx] & kCC3ShadowFaceLit) != 0));
+	if ( !isTerminatorEdge ) return;
+	
+	if (terminatorEdgeCount == terminatorEdgeCapacity) {
+		GLuint newCapacity = MAX(terminatorEdgeCapacity * 2, 64);
+		CC3ShadowTerminatorEdge* newEdges = realloc(terminatorEdges, newCapacity * sizeof(CC3ShadowTerminatorEdge));
+		if ( !newEdges ) {
+			LogError(@"%@ could not allocate space for %u terminator edges", self, newCapacity);
+			return;
+		}
+		terminatorEdges = newEdges;
+		terminatorEdgeCapacity = newCapacity;
+	}
+	terminatorEdges[terminatorEdgeCount].faceIndex = faceIdx;
+	terminatorEdges[terminatorEdgeCount].edgeIndex = edgeIdx;
+	terminatorEdgeCount++;
+}
+
+/**
+ * Ensures that the face illumination and changed face arrays can hold the specified number
+ * of faces. If the arrays are reallocated, the cached shadow is discarded.
+ * Returns NO if the arrays could not be allocated.
+ */
+-(BOOL) ensureShadowCacheForFaceCount: (GLuint) faceCnt {
+	if (faceIllumination && faceCnt == cachedFaceCount) return YES;
+
+	[self releaseShadowCache];
+	faceIllumination = calloc(faceCnt, sizeof(GLubyte));
+	flippedFaces = calloc(faceCnt, sizeof(GLuint));
+	if ( !faceIllumination || !flippedFaces ) {
+		LogError(@"%@ could not allocate shadow cache for %u faces", self, faceCnt);
+		[self releaseShadowCache];
+		return NO;
+	}
+	cachedFaceCount = faceCnt;
+	return YES;
+}
+
+/** Releases the memory used to cache the shadow volume, and discards the cached shadow. */
+-(void) releaseShadowCache {
+	free(faceIllumination);
+	faceIllumination = NULL;
+	free(flippedFaces);
+	flippedFaces = NULL;
+	free(terminatorEdges);
+	terminatorEdges = NULL;
+	terminatorEdgeCount = 0;
+	terminatorEdgeCapacity = 0;
+	cachedFaceCount = 0;
+	hasCachedShadow = NO;
+}
+
 /**
  * Adds a side to the shadow volume, by extruding the specified terminator edge of
  * the specified shadow caster mesh to infinity. The light source is directional
@@ -684,14 +1078,57 @@
 	[super processUpdateBeforeTransform: visitor];
 }
 
-/** Returns whether the shadow cast by this shadow volume will be visible. */
 -(BOOL) isShadowVisible {
 	CC3MeshNode* scNode = self.shadowCaster;
 	return (light.visible || light.shouldCastShadowsWhenInvisible) &&
 			(scNode.visible || scNode.shouldCastShadowsWhenInvisible || self.visible) &&
+			self.doesShadowIntersectFrustum &&
 			[scNode doesIntersectBoundingVolume: light.shadowCastingVolume];
 }
 
+/**
+ * Returns whether the shadow of the bounding sphere of the shadow-casting node, extruded away
+ * from the light until the light fades below its shadowCullingThreshold, intersects the frustum
+ * of the camera. Returns YES if the shadow-casting node does not have a spherical bounding volume.
+ *
+ * For a directional light, the shadow is a cylinder. For a positional light, the shadow is a
+ * cone, tangent to the sphere, whose radius grows by r / sqrt(d * d - r * r) per unit distance,
+ * where r is the radius of the sphere and d is the distance from the light to the sphere.
+ */
+-(BOOL) doesShadowIntersectFrustum {
+	CC3Frustum* frustum = self.activeCamera.frustum;
+	CC3NodeBoundingVolume* bv = self.shadowCaster.boundingVolume;
+	if ([bv isKindOfClass: [CC3NodeSphereThenBoxBoundingVolume class]]) {
+		bv = ((CC3NodeSphereThenBoxBoundingVolume*)bv).sphericalBoundingVolume;
+	}
+	if ( !frustum || ![bv isKindOfClass: [CC3NodeSphericalBoundingVolume class]] ) return YES;
+
+	CC3Sphere casterSphere = ((CC3NodeSphericalBoundingVolume*)bv).globalSphere;
+	GLfloat range = light.shadowRange;
+
+	if (light.isDirectionalOnly) {
+		CC3Vector lightDir = light.globalLocation;
+		if (CC3VectorLengthSquared(lightDir) == 0.0f) return YES;
+		return [frustum doesIntersectSphere: casterSphere
+								 sweptAlong: CC3VectorNegate(CC3VectorNormalize(lightDir))
+								forDistance: INFINITY
+								expandingBy: 0.0f];
+	}
+
+	CC3Vector lightToCaster = CC3VectorDifference(casterSphere.center, light.globalLocation);
+	GLfloat dist = CC3VectorLength(lightToCaster);
+	GLfloat radius = casterSphere.radius;
+	if (dist <= radius) return YES;				// Light is inside the caster
+	if (range < dist - radius) return NO;		// Caster is beyond the range of the light
+
+	GLfloat expansion = radius / sqrtf((dist * dist) - (radius * radius));
+	casterSphere.radius = dist * expansion;		// Cone radius at caster center
+	return [frustum doesIntersectSphere: casterSphere
+							 sweptAlong: CC3VectorScaleUniform(lightToCaster, 1.0f / dist)
+							forDistance: MAX(range - dist, 0.0f)
+							expandingBy: expansion];
+}
+
 /**
  * Returns whether this shadow volume is ready to be updated.
  * It is if the lag count has been decremented to zero.
@@ -1131,6 +1568,19 @@
 	}
 }
 
+-(BOOL) shouldCacheShadowVolumes {
+	for (CC3Node* child in children) {
+		if ( !child.shouldCacheShadowVolumes ) return NO;
+	}
+	return YES;
+}
+
+-(void) setShouldCacheShadowVolumes: (BOOL) shouldCache {
+	for (CC3Node* child in children) {
+		child.shouldCacheShadowVolumes = shouldCache;
+	}
+}
+
 @end
 
 
@@ -587,6 +587,19 @@ static inline CC3BoundingBox CC3BoundingBoxUnion(CC3BoundingBox bb1, CC3Bounding
 	return bb1;
 }
 
+/**
+ * Returns the smallest CC3BoundingBox that contains the specified number of locations,
+ * or the null bounding box if the count is zero.
+ *
+ * Each location is read as a CC3Vector from the specified memory, and consecutive locations
+ * are separated by the specified stride, in bytes. Locations may therefore be interleaved with
+ * other vertex content. The stride must be at least the size of a CC3Vector.
+ *
+ * On platforms that support NEON or SSE instructions, the locations are processed using
+ * SIMD instructions. This is much faster than accumulating the locations individually.
+ */
+CC3BoundingBox CC3BoundingBoxFromLocations(const GLvoid* locations, GLuint count, GLuint stride);
+
 /**
  * Returns a bounding box that has the same dimensions as the specified bounding box, but with
  * each corner expanded outward by the specified amount of padding.
@@ -1434,6 +1447,26 @@ static inline BOOL CC3DoesSphereIntersectSphere(CC3Sphere sphereOne, CC3Sphere s
 /** Returns the smallest CC3Sphere that contains the two specified spheres. */
 CC3Sphere CC3SphereUnion(CC3Sphere s1, CC3Sphere s2);
 
+/**
+ * Returns the distance from the specified center to the farthest of the specified number
+ * of locations, or zero if the count is zero.
+ *
+ * The locations are read as described for the CC3BoundingBoxFromLocations function, and
+ * are processed using SIMD instructions on platforms that support them.
+ */
+GLfloat CC3RadiusOfLocationsFromCenter(CC3Vector center, const GLvoid* locations, GLuint count, GLuint stride);
+
+/**
+ * Returns a sphere that contains the specified number of locations, and that is close to the
+ * smallest such sphere, using Ritter's algorithm. The result is typically within a few percent
+ * of the minimal sphere, and is often noticeably smaller than the sphere that is centered on
+ * the center of the bounding box of the locations.
+ *
+ * The locations are read as described for the CC3BoundingBoxFromLocations function.
+ * Returns a sphere of zero radius at the origin if the count is zero.
+ */
+CC3Sphere CC3SphereFromLocations(const GLvoid* locations, GLuint count, GLuint stride);
+
 /** Returns whether the specified ray intersects the specified sphere. */
 BOOL CC3DoesRayIntersectSphere(CC3Ray aRay, CC3Sphere aSphere);
 
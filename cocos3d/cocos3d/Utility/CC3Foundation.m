@@ -33,6 +33,14 @@
 #import "CC3Matrix3x3.h"
 #import "CGPointExtension.h"
 
+#if defined(__ARM_NEON__)
+#	import <arm_neon.h>
+#	define CC3_SIMD_NEON		1
+#elif defined(__SSE2__)
+#	import <emmintrin.h>
+#	define CC3_SIMD_SSE		1
+#endif
+
 
 NSString* NSStringFromCC3Vectors(CC3Vector* vectors, GLuint vectorCount) {
 	NSMutableString* desc = [NSMutableString stringWithCapacity: (vectorCount * 8)];
@@ -68,6 +76,86 @@ void CC3VectorOrthonormalize(CC3Vector* vectors, GLuint vectorCount) {
 #pragma mark -
 #pragma mark Bounding box structure and functions
 
+/**
+ * Returns the location at the specified index within the strided location content.
+ * All locations except the last may be loaded into a 4-component SIMD register, since
+ * the fourth component read is the start of the next vertex. The last location is always
+ * read as a CC3Vector, to avoid reading beyond the end of the vertex content.
+ */
+#define CC3StridedLocation(locs, idx, stride)	((const CC3Vector*)((const GLubyte*)(locs) + ((idx) * (stride))))
+
+CC3BoundingBox CC3BoundingBoxFromLocations(const GLvoid* locations, GLuint count, GLuint stride) {
+	if ( !(locations && count) ) return kCC3BoundingBoxNull;
+
+	CC3Vector lastLoc = *CC3StridedLocation(locations, (count - 1), stride);
+	GLuint simdCount = count - 1;
+	const GLubyte* pLoc = locations;
+	CC3BoundingBox bb;
+
+#if CC3_SIMD_NEON
+	// Two independent sets of accumulators allow successive vertices to be processed in parallel
+	GLfloat lastLoc4[4] = { lastLoc.x, lastLoc.y, lastLoc.z, lastLoc.z };
+	float32x4_t vMin0 = vld1q_f32(lastLoc4), vMax0 = vMin0, vMin1 = vMin0, vMax1 = vMin0;
+	GLuint i = 0;
+	for (; i + 1 < simdCount; i += 2, pLoc += (stride << 1)) {
+		float32x4_t v0 = vld1q_f32((const float32_t*)pLoc);
+		float32x4_t v1 = vld1q_f32((const float32_t*)(pLoc + stride));
+		vMin0 = vminq_f32(vMin0, v0);
+		vMax0 = vmaxq_f32(vMax0, v0);
+		vMin1 = vminq_f32(vMin1, v1);
+		vMax1 = vmaxq_f32(vMax1, v1);
+	}
+	if (i < simdCount) {
+		float32x4_t v0 = vld1q_f32((const float32_t*)pLoc);
+		vMin0 = vminq_f32(vMin0, v0);
+		vMax0 = vmaxq_f32(vMax0, v0);
+	}
+	GLfloat minOut[4], maxOut[4];
+	vst1q_f32(minOut, vminq_f32(vMin0, vMin1));
+	vst1q_f32(maxOut, vmaxq_f32(vMax0, vMax1));
+	bb.minimum = cc3v(minOut[0], minOut[1], minOut[2]);
+	bb.maximum = cc3v(maxOut[0], maxOut[1], maxOut[2]);
+
+#elif CC3_SIMD_SSE
+	__m128 vMin0 = _mm_setr_ps(lastLoc.x, lastLoc.y, lastLoc.z, lastLoc.z);
+	__m128 vMax0 = vMin0, vMin1 = vMin0, vMax1 = vMin0;
+	GLuint i = 0;
+	for (; i + 1 < simdCount; i += 2, pLoc += (stride << 1)) {
+		__m128 v0 = _mm_loadu_ps((const float*)pLoc);
+		__m128 v1 = _mm_loadu_ps((const float*)(pLoc + stride));
+		vMin0 = _mm_min_ps(vMin0, v0);
+		vMax0 = _mm_max_ps(vMax0, v0);
+		vMin1 = _mm_min_ps(vMin1, v1);
+		vMax1 = _mm_max_ps(vMax1, v1);
+	}
+	if (i < simdCount) {
+		__m128 v0 = _mm_loadu_ps((const float*)pLoc);
+		vMin0 = _mm_min_ps(vMin0, v0);
+		vMax0 = _mm_max_ps(vMax0, v0);
+	}
+	GLfloat minOut[4], maxOut[4];
+	_mm_storeu_ps(minOut, _mm_min_ps(vMin0, vMin1));
+	_mm_storeu_ps(maxOut, _mm_max_ps(vMax0, vMax1));
+	bb.minimum = cc3v(minOut[0], minOut[1], minOut[2]);
+	bb.maximum = cc3v(maxOut[0], maxOut[1], maxOut[2]);
+
+#else
+	bb.minimum = lastLoc;
+	bb.maximum = lastLoc;
+	for (GLuint i = 0; i < simdCount; i++, pLoc += stride) {
+		const CC3Vector* pv = (const CC3Vector*)pLoc;
+		bb.minimum.x = MIN(bb.minimum.x, pv->x);
+		bb.minimum.y = MIN(bb.minimum.y, pv->y);
+		bb.minimum.z = MIN(bb.minimum.z, pv->z);
+		bb.maximum.x = MAX(bb.maximum.x, pv->x);
+		bb.maximum.y = MAX(bb.maximum.y, pv->y);
+		bb.maximum.z = MAX(bb.maximum.z, pv->z);
+	}
+#endif
+
+	return bb;
+}
+
 CC3BoundingBox CC3BoundingBoxEngulfLocation(CC3BoundingBox bb, CC3Vector aLoc) {
 	CC3BoundingBox bbOut;
 	if(CC3BoundingBoxIsNull(bb)) {
@@ -386,6 +474,93 @@ GLfloat CC3DistanceFromNormalizedPlane(CC3Plane p, CC3Vector v) {
 #pragma mark -
 #pragma mark Sphere structure and functions
 
+GLfloat CC3RadiusOfLocationsFromCenter(CC3Vector center, const GLvoid* locations, GLuint count, GLuint stride) {
+	if ( !(locations && count) ) return 0.0f;
+
+	// Work with the square of the radius so that all distances can be compared
+	// without having to run expensive square-root calculations.
+	GLfloat radiusSq = CC3VectorDistanceSquared(*CC3StridedLocation(locations, (count - 1), stride), center);
+	GLuint simdCount = count - 1;
+	const GLubyte* pLoc = locations;
+
+#if CC3_SIMD_NEON
+	GLfloat center4[4] = { center.x, center.y, center.z, 0.0f };
+	float32x4_t vCenter = vld1q_f32(center4);
+	float32x2_t vMaxSq = vdup_n_f32(radiusSq);
+	for (GLuint i = 0; i < simdCount; i++, pLoc += stride) {
+		float32x4_t vDiff = vsubq_f32(vld1q_f32((const float32_t*)pLoc), vCenter);
+		vDiff = vsetq_lane_f32(0.0f, vDiff, 3);						// Ignore the fourth component
+		float32x4_t vSq = vmulq_f32(vDiff, vDiff);
+		float32x2_t vSum = vadd_f32(vget_low_f32(vSq), vget_high_f32(vSq));
+		vMaxSq = vmax_f32(vMaxSq, vpadd_f32(vSum, vSum));
+	}
+	radiusSq = vget_lane_f32(vMaxSq, 0);
+
+#elif CC3_SIMD_SSE
+	__m128 vCenter = _mm_setr_ps(center.x, center.y, center.z, 0.0f);
+	__m128 vMask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));	// Ignore the fourth component
+	__m128 vMaxSq = _mm_set_ss(radiusSq);
+	for (GLuint i = 0; i < simdCount; i++, pLoc += stride) {
+		__m128 vDiff = _mm_and_ps(_mm_sub_ps(_mm_loadu_ps((const float*)pLoc), vCenter), vMask);
+		__m128 vSq = _mm_mul_ps(vDiff, vDiff);
+		vSq = _mm_add_ps(vSq, _mm_movehl_ps(vSq, vSq));						// (x+z, y+w, ...)
+		vSq = _mm_add_ss(vSq, _mm_shuffle_ps(vSq, vSq, _MM_SHUFFLE(1, 1, 1, 1)));	// (x+y+z+w, ...)
+		vMaxSq = _mm_max_ss(vMaxSq, vSq);
+	}
+	_mm_store_ss(&radiusSq, vMaxSq);
+
+#else
+	for (GLuint i = 0; i < simdCount; i++, pLoc += stride) {
+		radiusSq = MAX(radiusSq, CC3VectorDistanceSquared(*(const CC3Vector*)pLoc, center));
+	}
+#endif
+
+	return sqrtf(radiusSq);		// Now finally take the square-root
+}
+
+/** Returns the index of the location that is farthest from the specified location. */
+static GLuint CC3IndexOfLocationFarthestFrom(CC3Vector aLoc, const GLvoid* locations, GLuint count, GLuint stride) {
+	GLuint farIdx = 0;
+	GLfloat farDistSq = -1.0f;
+	for (GLuint i = 0; i < count; i++) {
+		GLfloat distSq = CC3VectorDistanceSquared(*CC3StridedLocation(locations, i, stride), aLoc);
+		if (distSq > farDistSq) {
+			farDistSq = distSq;
+			farIdx = i;
+		}
+	}
+	return farIdx;
+}
+
+CC3Sphere CC3SphereFromLocations(const GLvoid* locations, GLuint count, GLuint stride) {
+	if ( !(locations && count) ) return CC3SphereMake(kCC3VectorZero, 0.0f);
+
+	// Find two locations that are far apart, by finding the location farthest from an
+	// arbitrary location, and then the location farthest from that one. Start with the
+	// sphere that has the line between those two locations as its diameter.
+	CC3Vector locY = *CC3StridedLocation(locations, CC3IndexOfLocationFarthestFrom(*CC3StridedLocation(locations, 0, stride), locations, count, stride), stride);
+	CC3Vector locZ = *CC3StridedLocation(locations, CC3IndexOfLocationFarthestFrom(locY, locations, count, stride), stride);
+	CC3Vector center = CC3VectorAverage(locY, locZ);
+	GLfloat radius = CC3VectorDistance(locY, locZ) * 0.5f;
+	GLfloat radiusSq = radius * radius;
+
+	// Grow the sphere to engulf any location that lies outside it, moving the center
+	// toward that location just enough to keep the opposite side of the sphere in place.
+	for (GLuint i = 0; i < count; i++) {
+		CC3Vector aLoc = *CC3StridedLocation(locations, i, stride);
+		GLfloat distSq = CC3VectorDistanceSquared(aLoc, center);
+		if (distSq > radiusSq) {
+			GLfloat dist = sqrtf(distSq);
+			GLfloat newRadius = (radius + dist) * 0.5f;
+			center = CC3VectorAdd(center, CC3VectorScaleUniform(CC3VectorDifference(aLoc, center),
+																((newRadius - radius) / dist)));
+			radius = newRadius;
+			radiusSq = radius * radius;
+		}
+	}
+	return CC3SphereMake(center, radius);
+}
+
 CC3Sphere CC3SphereUnion(CC3Sphere s1, CC3Sphere s2) {
 	CC3Vector uc, mc, is1, is2, epF, epB;
 
@@ -30,6 +30,31 @@
 /** @file */	// Doxygen marker
 
 #import "CC3Foundation.h"
+#import <libkern/OSAtomic.h>
+
+/**
+ * Increments the specified tag counter and returns the incremented value. The increment is
+ * atomic, so that unique tags are allocated even when objects are created on several threads.
+ */
+static inline GLuint CC3IncrementTagCounter(GLuint* tagCounter) {
+	return (GLuint)OSAtomicIncrement32Barrier((volatile int32_t*)tagCounter);
+}
+
+/**
+ * Increments the specified change counter and returns the incremented value. The increment is
+ * atomic, so that no change is lost when changes are counted on several threads.
+ */
+static inline GLuint CC3IncrementChangeCounter(GLuint* changeCounter) {
+	return (GLuint)OSAtomicIncrement32Barrier((volatile int32_t*)changeCounter);
+}
+
+/**
+ * Adds the specified number of changes to the specified change counter, and returns the
+ * resulting value. The addition is atomic, in the same way as CC3IncrementChangeCounter.
+ */
+static inline GLuint CC3AddToChangeCounter(GLuint* changeCounter, GLuint changeCount) {
+	return (GLuint)OSAtomicAdd32Barrier((int32_t)changeCount, (volatile int32_t*)changeCounter);
+}
 
 /**
  * This is a base subclass for any class that uses tags or names to identify individual instances.
@@ -41,6 +66,8 @@
  *
  * When overriding initialization, subclasses typically need only override the most generic
  * initializer, initWithTag:withName:.
+ *
+ * Tag allocation is thread-safe, so instances may be created on background threads.
  */
 @interface CC3Identifiable : NSObject <NSCopying> {
 	GLuint tag;
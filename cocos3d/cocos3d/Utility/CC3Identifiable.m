@@ -40,7 +40,7 @@ static GLint instanceCount = 0;
 -(void) dealloc {
 	[self releaseUserData];
 	[name release];
-	instanceCount--;
+	OSAtomicDecrement32Barrier(&instanceCount);
 	[super dealloc];
 }
 
@@ -72,7 +72,7 @@ static GLint instanceCount = 0;
 
 -(id) initWithTag: (GLuint) aTag withName: (NSString*) aName {
 	if ( (self = [super init]) ) {
-		instanceCount++;
+		OSAtomicIncrement32Barrier(&instanceCount);
 		self.tag = aTag;
 		self.name = aName;
 		[self initUserData];
@@ -123,7 +123,7 @@ static GLint instanceCount = 0;
 static GLuint lastAssignedTag;
 
 -(GLuint) nextTag {
-	return ++lastAssignedTag;
+	return CC3IncrementTagCounter(&lastAssignedTag);
 }
 
 +(void) resetTagAllocation {
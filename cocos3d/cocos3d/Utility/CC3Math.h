@@ -45,7 +45,9 @@
 #define kCC3MaxGLint			INT_MAX
 #define kCC3MaxGLuint			UINT_MAX
 #define kCC3MaxGLushort			0xFFFF
+#define kCC3MaxGLshort			0x7FFF
 #define kCC3MaxGLubyte			0xFF
+#define kCC3MaxGLbyte			0x7F
 #define kCC3MaxGLfloat			CGFLOAT_MAX
 
 /** Conversion between degrees and radians. */
@@ -0,0 +1,163 @@
+/*
+ * CC3ObjectPool.h
+ *
+ * cocos3d 2.0.0
+ * Author: Bill Hollings
+ * Copyright (c) 2011-2013 The Brenwill Workshop Ltd. All rights reserved.
+ * http://www.brenwill.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * http://en.wikipedia.org/wiki/MIT_License
+ */
+
+/** @file */	// Doxygen marker
+
+
+#import "CC3Foundation.h"
+
+/** The default maximum number of free objects held by a CC3ObjectPool. */
+#define kCC3ObjectPoolDefaultCapacity	64
+
+
+#pragma mark -
+#pragma mark CC3ObjectPool
+
+/**
+ * CC3ObjectPool holds objects that are no longer in use, so that they can be reused instead of
+ * being deallocated and replaced with newly allocated objects. This avoids the cost of allocating
+ * and initializing objects, such as projectiles or hit effects, that are created and discarded
+ * at a high rate.
+ *
+ * The acquireObject method returns a free object if one is available, and otherwise creates a
+ * new object by invoking the makeObject template method. When the application is done with an
+ * object, it is returned to the pool with the recycleObject: method, which returns the object to
+ * its initial state by invoking the resetObject: template method, and holds it until it is needed
+ * again. If the pool already holds capacity objects, or the object cannot be reset, the object is
+ * discarded instead.
+ *
+ * This is an abstract class. Subclasses, such as CC3NodePool and CC3ParticlePool, override the
+ * makeObject and resetObject: methods to create and reset objects of a particular type.
+ *
+ * The hitCount, missCount, recycledCount and discardedCount properties track how effectively the
+ * pool is being used, and can be cleared with the resetStatistics method. A high missCount relative
+ * to the hitCount indicates that objects are being acquired faster than they are being recycled,
+ * and that the pool might be populated in advance using the populateWithCount: method.
+ */
+@interface CC3ObjectPool : NSObject {
+	CCArray* freeObjects;
+	GLuint capacity;
+	GLuint hitCount;
+	GLuint missCount;
+	GLuint recycledCount;
+	GLuint discardedCount;
+}
+
+/**
+ * The maximum number of free objects held by this pool. Objects recycled once this
+ * number of objects are held by this pool are discarded.
+ *
+ * Reducing the value of this property discards any free objects beyond the new capacity.
+ *
+ * The initial value of this property is kCC3ObjectPoolDefaultCapacity.
+ */
+@property(nonatomic, assign) GLuint capacity;
+
+/** The number of free objects currently held by this pool, and available to be acquired. */
+@property(nonatomic, readonly) GLuint count;
+
+/** The number of objects acquired that were satisfied by a free object held by this pool. */
+@property(nonatomic, readonly) GLuint hitCount;
+
+/** The number of objects acquired that required a new object to be created. */
+@property(nonatomic, readonly) GLuint missCount;
+
+/** The number of objects that were recycled and are held by this pool for reuse. */
+@property(nonatomic, readonly) GLuint recycledCount;
+
+/**
+ * The number of objects that were returned to this pool but were discarded, either because
+ * the pool was full, or because the object could not be reset.
+ */
+@property(nonatomic, readonly) GLuint discardedCount;
+
+/**
+ * The fraction of acquired objects that were satisfied by a free object held by this pool,
+ * or zero if no objects have been acquired.
+ */
+@property(nonatomic, readonly) GLfloat hitRate;
+
+/** Resets the hitCount, missCount, recycledCount and discardedCount properties to zero. */
+-(void) resetStatistics;
+
+
+#pragma mark Acquiring and recycling objects
+
+/**
+ * Returns an autoreleased object, either by removing a free object from this pool, or by
+ * creating a new object by invoking the makeObject method.
+ */
+-(id) acquireObject;
+
+/**
+ * Returns the specified object to this pool, once the application no longer needs it.
+ *
+ * If this pool holds fewer than capacity objects, the object is reset to its initial state
+ * by invoking the resetObject: method, and is held for reuse. Otherwise, or if the object
+ * cannot be reset, the object is discarded.
+ *
+ * The application must not continue to use the object once it has been recycled.
+ */
+-(void) recycleObject: (id) anObject;
+
+/**
+ * Creates new objects, using the makeObject method, and adds them to this pool, until this
+ * pool holds the specified number of free objects, or is full. This can be used to avoid
+ * creating objects at a time when performance is critical, such as during game play.
+ */
+-(void) populateWithCount: (GLuint) objCount;
+
+/** Discards all free objects held by this pool. */
+-(void) removeAllObjects;
+
+/**
+ * Template method that creates and returns a new autoreleased object for this pool.
+ *
+ * This method is invoked automatically when an object is acquired and no free object is
+ * available. Subclasses must override this method. This implementation raises an assertion.
+ */
+-(id) makeObject;
+
+/**
+ * Template method that returns the specified object to its initial state, before it is held
+ * by this pool for reuse. Returns whether the object could be reset. If this method returns NO,
+ * the object is discarded instead of being held by this pool.
+ *
+ * This method is invoked automatically when an object is recycled. This implementation does
+ * nothing, and returns YES. Subclasses will override.
+ */
+-(BOOL) resetObject: (id) anObject;
+
+
+#pragma mark Allocation and initialization
+
+/** Allocates and initializes an autoreleased instance. */
++(id) pool;
+
+@end
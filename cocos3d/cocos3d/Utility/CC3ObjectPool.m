@@ -0,0 +1,132 @@
+/*
+ * CC3ObjectPool.m
+ *
+ * cocos3d 2.0.0
+ * Author: Bill Hollings
+ * Copyright (c) 2011-2013 The Brenwill Workshop Ltd. All rights reserved.
+ * http://www.brenwill.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * http://en.wikipedia.org/wiki/MIT_License
+ * 
+ * See header file CC3ObjectPool.h for full API documentation.
+ */
+
+#import "CC3ObjectPool.h"
+
+
+#pragma mark -
+#pragma mark CC3ObjectPool
+
+@implementation CC3ObjectPool
+
+@synthesize capacity, hitCount, missCount, recycledCount, discardedCount;
+
+-(void) dealloc {
+	[freeObjects release];
+	[super dealloc];
+}
+
+-(GLuint) count { return freeObjects.count; }
+
+-(void) setCapacity: (GLuint) aCapacity {
+	capacity = aCapacity;
+	while (freeObjects.count > capacity) {
+		[freeObjects removeLastObject];
+		discardedCount++;
+	}
+}
+
+-(GLfloat) hitRate {
+	GLuint acquiredCount = hitCount + missCount;
+	return acquiredCount ? ((GLfloat)hitCount / (GLfloat)acquiredCount) : 0.0f;
+}
+
+-(void) resetStatistics {
+	hitCount = 0;
+	missCount = 0;
+	recycledCount = 0;
+	discardedCount = 0;
+}
+
+
+#pragma mark Acquiring and recycling objects
+
+-(id) acquireObject {
+	id anObject = [freeObjects lastObject];
+	if (anObject) {
+		[[anObject retain] autorelease];		// Keep alive once removed from the pool
+		[freeObjects removeLastObject];
+		hitCount++;
+		return anObject;
+	}
+	missCount++;
+	return [self makeObject];
+}
+
+-(void) recycleObject: (id) anObject {
+	if ( !anObject ) return;
+	if (freeObjects.count < capacity && [self resetObject: anObject]) {
+		[freeObjects addObject: anObject];
+		recycledCount++;
+	} else {
+		discardedCount++;
+	}
+	LogTrace(@"%@ recycled %@", self, anObject);
+}
+
+-(void) populateWithCount: (GLuint) objCount {
+	GLuint targetCount = MIN(objCount, capacity);
+	while (freeObjects.count < targetCount) [freeObjects addObject: [self makeObject]];
+}
+
+-(void) removeAllObjects { [freeObjects removeAllObjects]; }
+
+-(id) makeObject {
+	NSAssert1(NO, @"%@ subclass must implement the makeObject method!", self);
+	return nil;
+}
+
+-(BOOL) resetObject: (id) anObject { return YES; }
+
+
+#pragma mark Allocation and initialization
+
+-(id) init {
+	if ( (self = [super init]) ) {
+		freeObjects = [[CCArray array] retain];
+		capacity = kCC3ObjectPoolDefaultCapacity;
+		[self resetStatistics];
+	}
+	return self;
+}
+
++(id) pool { return [[[self alloc] init] autorelease]; }
+
+-(NSString*) description {
+	return [NSString stringWithFormat: @"%@ holding %u of %u", [self class], self.count, capacity];
+}
+
+-(NSString*) fullDescription {
+	return [NSString stringWithFormat: @"%@ with %u hits, %u misses, %u recycled and %u discarded",
+			[self description], hitCount, missCount, recycledCount, discardedCount];
+}
+
+@end
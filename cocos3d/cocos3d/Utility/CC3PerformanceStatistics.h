@@ -33,6 +33,63 @@
 #import "CC3Foundation.h"
 
 
+#pragma mark -
+#pragma mark Performance phases
+
+/**
+ * Enumeration of the phases of updating and drawing a 3D scene that are individually
+ * timed by CC3PerformanceStatistics.
+ *
+ * Phases may be nested. The kCC3PerformancePhaseUpdate and kCC3PerformancePhaseDraw phases
+ * encompass the other update and draw phases, respectively. The kCC3PerformancePhaseCulling
+ * and kCC3PerformancePhaseSubmission phases are nested within kCC3PerformancePhaseDrawNodes.
+ * Each phase is recorded at most once per frame.
+ */
+typedef enum {
+	kCC3PerformancePhaseUpdate,					/**< The complete update pass of the scene. */
+	kCC3PerformancePhaseUpdateNodes,			/**< Updating and transforming nodes with the updateVisitor. */
+	kCC3PerformancePhaseUpdateTargets,			/**< Updating nodes that track targets. */
+	kCC3PerformancePhaseUpdateCamera,			/**< Updating the camera projection. */
+	kCC3PerformancePhaseUpdateBillboards,		/**< Aligning billboards to the camera. */
+	kCC3PerformancePhaseUpdateFog,				/**< Updating fog. */
+	kCC3PerformancePhaseUpdateShadows,			/**< Updating shadows cast by lights. */
+	kCC3PerformancePhaseUpdateDrawSequence,		/**< Updating the order of the drawing sequencer. */
+	kCC3PerformancePhaseDraw,					/**< The complete drawing pass of the scene. */
+	kCC3PerformancePhaseDrawSetup,				/**< Opening the GL state, viewport and camera. */
+	kCC3PerformancePhaseDrawShadowMaps,			/**< Drawing the shadow maps of lights from the viewpoint of each light. */
+	kCC3PerformancePhaseNodePicking,			/**< Picking a touched node. */
+	kCC3PerformancePhaseIllumination,			/**< Binding the lights and fog. */
+	kCC3PerformancePhaseDrawNodes,				/**< Visiting the nodes with the drawVisitor. */
+	kCC3PerformancePhaseCulling,				/**< Traversing, culling and sequencing nodes into a draw command list. */
+	kCC3PerformancePhaseSubmission,				/**< Replaying a draw command list to the GL engine. */
+	kCC3PerformancePhaseDrawShadows,			/**< Drawing shadows. */
+	kCC3PerformancePhaseDraw2DBillboards,		/**< Drawing 2D billboards after closing the 3D scene. */
+	kCC3PerformancePhaseTextureUpload,			/**< Uploading texture content loaded in the background. */
+	kCC3PerformancePhaseCount					/**< The number of phases. Not a valid phase. */
+} CC3PerformancePhase;
+
+/** Returns a string description of the specified performance phase. */
+NSString* NSStringFromCC3PerformancePhase(CC3PerformancePhase phase);
+
+/** Returns the current value of a high-resolution monotonic clock, in seconds. */
+double CC3PerformanceTimeNow(void);
+
+/** The number of recent frames whose phase timings are retained for calculating percentiles. */
+#define kCC3PerformanceFrameHistorySize 256
+
+/** The timing of each performance phase during a single frame. */
+typedef struct {
+	ccTime phaseTimes[kCC3PerformancePhaseCount];	/**< The time spent in each phase, in seconds. */
+} CC3PerformanceFrameTiming;
+
+/** A single timed occurrence of a performance phase, as recorded for trace export. */
+typedef struct {
+	CC3PerformancePhase phase;		/**< The phase that was timed. */
+	double startTime;				/**< The start time, in seconds, relative to the start of the trace. */
+	double duration;				/**< The duration, in seconds. */
+} CC3PerformanceTraceEvent;
+
+
 #pragma mark -
 #pragma mark CC3PerformanceStatistics
 
@@ -50,6 +107,8 @@
 	ccTime accumulatedUpdateTime;
 	GLuint nodesUpdated;
 	GLuint nodesTransformed;
+	GLuint bonesUpdated;
+	GLuint bonesSkipped;
 	
 	GLuint framesHandled;
 	ccTime accumulatedFrameTime;
@@ -57,6 +116,21 @@
 	GLuint nodesDrawn;
 	GLuint drawingCallsMade;
 	GLuint facesPresented;
+	GLuint shadowVolumesCulled;
+	GLuint shadowLightsCulled;
+	GLuint shadowCastersCulled;
+
+	double phaseStartTimes[kCC3PerformancePhaseCount];
+	ccTime accumulatedPhaseTimes[kCC3PerformancePhaseCount];
+	GLuint phaseOccurrences[kCC3PerformancePhaseCount];
+	CC3PerformanceFrameTiming frameTimings[kCC3PerformanceFrameHistorySize];
+	GLuint frameTimingIndex;
+	GLuint frameTimingCount;
+	CC3PerformanceTraceEvent* traceEvents;
+	GLuint traceEventCount;
+	GLuint traceEventCapacity;
+	double traceStartTime;
+	BOOL shouldCaptureTrace : 1;
 }
 
 
@@ -95,6 +169,26 @@
 /** Increments the nodesTransformed property by one. */
 -(void) incrementNodesTransformed;
 
+/**
+ * The total number of animated skeleton nodes, such as bones, whose animation was applied
+ * since the reset method was last invoked, as counted by soft-body nodes that are using a
+ * CC3AnimationLODPolicy.
+ */
+@property(nonatomic, readonly) GLuint bonesUpdated;
+
+/** Adds the specified number of bones to the bonesUpdated property. */
+-(void) addBonesUpdated: (GLuint) boneCount;
+
+/**
+ * The total number of animated skeleton nodes, such as bones, whose animation was skipped
+ * since the reset method was last invoked, because the level of detail of the animation of
+ * the skeleton was reduced by a CC3AnimationLODPolicy.
+ */
+@property(nonatomic, readonly) GLuint bonesSkipped;
+
+/** Adds the specified number of bones to the bonesSkipped property. */
+-(void) addBonesSkipped: (GLuint) boneCount;
+
 
 #pragma mark Accumulated frame drawing statistics
 
@@ -169,6 +263,166 @@
  */
 -(void) addSingleCallFacesPresented: (GLuint) faceCount;
 
+/**
+ * The total number of shadow volumes that were not drawn since the reset method was last
+ * invoked, because the shadow cast by each could not be visible within the camera frustum.
+ *
+ * Shadow volumes belonging to lights counted in the shadowLightsCulled property are not
+ * included in this count.
+ */
+@property(nonatomic, readonly) GLuint shadowVolumesCulled;
+
+/** Adds the specified number of shadow volumes to the shadowVolumesCulled property. */
+-(void) addShadowVolumesCulled: (GLuint) volumeCount;
+
+/**
+ * The total number of times, since the reset method was last invoked, that the shadows of
+ * a light were neither updated nor drawn, because the shadowRange of the light did not
+ * reach the camera frustum.
+ */
+@property(nonatomic, readonly) GLuint shadowLightsCulled;
+
+/** Increments the shadowLightsCulled property by one. */
+-(void) incrementShadowLightsCulled;
+
+/**
+ * The total number of shadow-casting nodes, summed across the cascades of the shadow maps of
+ * the lights, that were not drawn into a cascade since the reset method was last invoked,
+ * because the shadow cast by each could not fall within the area covered by that cascade.
+ */
+@property(nonatomic, readonly) GLuint shadowCastersCulled;
+
+/** Adds the specified number of shadow-casting nodes to the shadowCastersCulled property. */
+-(void) addShadowCastersCulled: (GLuint) casterCount;
+
+
+#pragma mark Phase timing
+
+/**
+ * Marks the start of the specified phase, using a high-resolution timer.
+ *
+ * This is invoked automatically by the CC3Scene and its visitors at the start of each
+ * phase of updating and drawing. Different phases may be nested, but a single phase
+ * may not be nested within itself.
+ */
+-(void) beginPhase: (CC3PerformancePhase) phase;
+
+/**
+ * Marks the end of the specified phase, which must have been started with the beginPhase:
+ * method, and accumulates the time spent in the phase into the accumulatedTimeForPhase:
+ * value, into the timing of the current frame, and, if the shouldCaptureTrace property is
+ * set to YES, into the trace events.
+ */
+-(void) endPhase: (CC3PerformancePhase) phase;
+
+/**
+ * Accumulates the specified duration, in seconds, as a single occurrence of the specified
+ * phase, in the same way as the endPhase: method.
+ *
+ * This is used for a phase whose work is interleaved with the work of another phase, and
+ * which is therefore timed in pieces that are summed before being recorded.
+ */
+-(void) addTime: (ccTime) duration toPhase: (CC3PerformancePhase) phase;
+
+/** Returns the total time spent in the specified phase since the reset method was last invoked. */
+-(ccTime) accumulatedTimeForPhase: (CC3PerformancePhase) phase;
+
+/** Returns the number of times the specified phase occurred since the reset method was last invoked. */
+-(GLuint) occurrencesOfPhase: (CC3PerformancePhase) phase;
+
+/**
+ * Returns the average time spent in each occurrence of the specified phase, calculated by
+ * dividing the accumulatedTimeForPhase: value by the occurrencesOfPhase: value.
+ */
+-(ccTime) averageTimeForPhase: (CC3PerformancePhase) phase;
+
+
+#pragma mark Frame timing history
+
+/**
+ * The number of frames currently held in the frame timing history.
+ *
+ * The frame timing history is a ring buffer holding the phase timings of the most recent
+ * kCC3PerformanceFrameHistorySize frames. A new frame is started each time the addUpdateTime:
+ * method is invoked, so each frame contains one update pass and the drawing pass that follows it.
+ *
+ * Unlike the accumulated statistics, the frame timing history is a rolling window, and is not
+ * cleared by the reset method. Use the clearFrameTimings method to clear it.
+ */
+@property(nonatomic, readonly) GLuint frameTimingCount;
+
+/**
+ * Returns the phase timings of the frame at the specified age, where zero is the frame
+ * currently being timed, one is the frame before that, and so on. The specified age must
+ * be less than the value of the frameTimingCount property.
+ */
+-(CC3PerformanceFrameTiming*) frameTimingAtAge: (GLuint) age;
+
+/**
+ * Returns the time spent in the specified phase, at the specified percentile (between zero
+ * and 100) of the frames held in the frame timing history. Frames in which the phase did
+ * not occur contribute a time of zero.
+ *
+ * Returns zero if the frame timing history is empty.
+ */
+-(ccTime) timeForPhase: (CC3PerformancePhase) phase atPercentile: (GLfloat) percentile;
+
+/** Returns the median (50th percentile) time spent in the specified phase over the frame timing history. */
+-(ccTime) p50TimeForPhase: (CC3PerformancePhase) phase;
+
+/** Returns the 95th percentile time spent in the specified phase over the frame timing history. */
+-(ccTime) p95TimeForPhase: (CC3PerformancePhase) phase;
+
+/** Returns the 99th percentile time spent in the specified phase over the frame timing history. */
+-(ccTime) p99TimeForPhase: (CC3PerformancePhase) phase;
+
+/** Removes all frames from the frame timing history. */
+-(void) clearFrameTimings;
+
+/**
+ * Returns a description of the timing of each phase that has occurred since the reset method
+ * was last invoked, including the average time, and the p50, p95 and p99 times over the frame
+ * timing history, all in milliseconds.
+ */
+-(NSString*) phaseTimingDescription;
+
+
+#pragma mark Trace capture
+
+/**
+ * Indicates whether each timed occurrence of each phase should be captured as a trace event,
+ * for later export using the traceEventJSON or writeTraceEventsToFile: methods.
+ *
+ * Trace events accumulate until the clearTraceEvents method is invoked, and are not cleared
+ * by the reset method, so that a complete session can be captured and inspected offline.
+ *
+ * The initial value of this property is NO.
+ */
+@property(nonatomic, assign) BOOL shouldCaptureTrace;
+
+/** The number of trace events that have been captured. */
+@property(nonatomic, readonly) GLuint traceEventCount;
+
+/** Returns the trace event at the specified index, which must be less than traceEventCount. */
+-(CC3PerformanceTraceEvent*) traceEventAt: (GLuint) index;
+
+/** Removes all captured trace events, and restarts the trace clock at zero. */
+-(void) clearTraceEvents;
+
+/**
+ * Returns the captured trace events as a JSON string in the Chrome trace-event format,
+ * which can be loaded into the chrome://tracing viewer, or other compatible tools.
+ *
+ * Each event is exported as a complete ("X") event, with timestamps and durations in microseconds.
+ */
+-(NSString*) traceEventJSON;
+
+/**
+ * Writes the string returned by the traceEventJSON method to the file at the specified path.
+ * Returns whether the file was successfully written.
+ */
+-(BOOL) writeTraceEventsToFile: (NSString*) aFilePath;
+
 
 #pragma mark Average update statistics
 
@@ -190,6 +444,18 @@
  */
 @property(nonatomic, readonly) GLfloat averageNodesTransformedPerUpdate;
 
+/**
+ * The average bones whose animation was applied per update, calculated by dividing
+ * the bonesUpdated property by the updatesHandled property.
+ */
+@property(nonatomic, readonly) GLfloat averageBonesUpdatedPerUpdate;
+
+/**
+ * The average bones whose animation was skipped per update, calculated by dividing
+ * the bonesSkipped property by the updatesHandled property.
+ */
+@property(nonatomic, readonly) GLfloat averageBonesSkippedPerUpdate;
+
 
 #pragma mark Average frame drawing statistics
 
@@ -245,6 +511,9 @@
 /**
  * Resets all the performance statistics back to zero.
  *
+ * The frame timing history and the captured trace events are not cleared by this method.
+ * Use the clearFrameTimings and clearTraceEvents methods to clear them.
+ *
  * To allow flexibility in calculating statistics, this class does not automatically
  * clear the accumulated statistics. It is the responsibility of the application to
  * read the values, and invoke the reset method on the instance periodically, to ensure
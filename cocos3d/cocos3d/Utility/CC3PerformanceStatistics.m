@@ -30,27 +30,89 @@
  */
 
 #import "CC3PerformanceStatistics.h"
+#import <mach/mach_time.h>
+
+
+#pragma mark -
+#pragma mark Performance phases
+
+NSString* NSStringFromCC3PerformancePhase(CC3PerformancePhase phase) {
+	switch (phase) {
+		case kCC3PerformancePhaseUpdate: return @"Update";
+		case kCC3PerformancePhaseUpdateNodes: return @"UpdateNodes";
+		case kCC3PerformancePhaseUpdateTargets: return @"UpdateTargets";
+		case kCC3PerformancePhaseUpdateCamera: return @"UpdateCamera";
+		case kCC3PerformancePhaseUpdateBillboards: return @"UpdateBillboards";
+		case kCC3PerformancePhaseUpdateFog: return @"UpdateFog";
+		case kCC3PerformancePhaseUpdateShadows: return @"UpdateShadows";
+		case kCC3PerformancePhaseUpdateDrawSequence: return @"UpdateDrawSequence";
+		case kCC3PerformancePhaseDraw: return @"Draw";
+		case kCC3PerformancePhaseDrawSetup: return @"DrawSetup";
+		case kCC3PerformancePhaseDrawShadowMaps: return @"DrawShadowMaps";
+		case kCC3PerformancePhaseNodePicking: return @"NodePicking";
+		case kCC3PerformancePhaseIllumination: return @"Illumination";
+		case kCC3PerformancePhaseDrawNodes: return @"DrawNodes";
+		case kCC3PerformancePhaseCulling: return @"Culling";
+		case kCC3PerformancePhaseSubmission: return @"Submission";
+		case kCC3PerformancePhaseDrawShadows: return @"DrawShadows";
+		case kCC3PerformancePhaseDraw2DBillboards: return @"Draw2DBillboards";
+		case kCC3PerformancePhaseTextureUpload: return @"TextureUpload";
+		default: return [NSString stringWithFormat: @"Unknown phase (%u)", phase];
+	}
+}
+
+double CC3PerformanceTimeNow(void) {
+	static double secondsPerTick = 0.0;
+	if (secondsPerTick == 0.0) {
+		mach_timebase_info_data_t tbInfo;
+		mach_timebase_info(&tbInfo);
+		secondsPerTick = ((double)tbInfo.numer / (double)tbInfo.denom) * 1.0e-9;
+	}
+	return (double)mach_absolute_time() * secondsPerTick;
+}
+
+/** Comparison function used when sorting frame timings to determine percentiles. */
+static int CC3PerformanceCompareTimes(const void* t1, const void* t2) {
+	ccTime time1 = *(const ccTime*)t1;
+	ccTime time2 = *(const ccTime*)t2;
+	return (time1 < time2) ? -1 : ((time1 > time2) ? 1 : 0);
+}
+
+// The number of trace events for which space is allocated when the first event is captured.
+#define kCC3PerformanceTraceInitialCapacity 1024
 
 
 #pragma mark -
 #pragma mark CC3PerformanceStatistics
 
+@interface CC3PerformanceStatistics (TemplateMethods)
+-(void) addTime: (ccTime) duration toPhase: (CC3PerformancePhase) phase startingAt: (double) startTime;
+@end
+
 @implementation CC3PerformanceStatistics
 
-@synthesize updatesHandled, accumulatedUpdateTime, nodesUpdated, nodesTransformed;
+@synthesize updatesHandled, accumulatedUpdateTime, nodesUpdated, nodesTransformed, bonesUpdated, bonesSkipped;
 @synthesize framesHandled, accumulatedFrameTime, nodesVisitedForDrawing;
-@synthesize nodesDrawn, drawingCallsMade, facesPresented;
+@synthesize nodesDrawn, drawingCallsMade, facesPresented, shadowVolumesCulled, shadowLightsCulled;
+@synthesize shadowCastersCulled;
+@synthesize frameTimingCount, shouldCaptureTrace, traceEventCount;
 
 -(void) dealloc {
+	free(traceEvents);
 	[super dealloc];
 }
 
 
 #pragma mark Accumulated update statistics
 
+/** Each update starts a new frame in the frame timing history. */
 -(void) addUpdateTime: (ccTime) deltaTime {
 	updatesHandled++;
 	accumulatedUpdateTime += deltaTime;
+
+	frameTimingIndex = (frameTimingIndex + 1) % kCC3PerformanceFrameHistorySize;
+	memset(&frameTimings[frameTimingIndex], 0, sizeof(CC3PerformanceFrameTiming));
+	frameTimingCount = MIN(frameTimingCount + 1, kCC3PerformanceFrameHistorySize);
 }
 
 -(void) addNodesUpdated: (GLuint) nodeCount {
@@ -69,6 +131,14 @@
 	nodesTransformed++;
 }
 
+-(void) addBonesUpdated: (GLuint) boneCount {
+	bonesUpdated += boneCount;
+}
+
+-(void) addBonesSkipped: (GLuint) boneCount {
+	bonesSkipped += boneCount;
+}
+
 
 #pragma mark Accumulated frame drawing statistics
 
@@ -106,6 +176,151 @@
 	facesPresented += faceCount;
 }
 
+-(void) addShadowVolumesCulled: (GLuint) volumeCount {
+	shadowVolumesCulled += volumeCount;
+}
+
+-(void) incrementShadowLightsCulled {
+	shadowLightsCulled++;
+}
+
+-(void) addShadowCastersCulled: (GLuint) casterCount {
+	shadowCastersCulled += casterCount;
+}
+
+
+#pragma mark Phase timing
+
+-(void) beginPhase: (CC3PerformancePhase) phase {
+	phaseStartTimes[phase] = CC3PerformanceTimeNow();
+}
+
+-(void) endPhase: (CC3PerformancePhase) phase {
+	double startTime = phaseStartTimes[phase];
+	[self addTime: (CC3PerformanceTimeNow() - startTime) toPhase: phase startingAt: startTime];
+}
+
+-(void) addTime: (ccTime) duration toPhase: (CC3PerformancePhase) phase {
+	[self addTime: duration toPhase: phase startingAt: (CC3PerformanceTimeNow() - duration)];
+}
+
+/** Accumulates the duration of an occurrence of the phase, and records it as a trace event. */
+-(void) addTime: (ccTime) duration toPhase: (CC3PerformancePhase) phase startingAt: (double) startTime {
+	accumulatedPhaseTimes[phase] += duration;
+	phaseOccurrences[phase]++;
+	frameTimings[frameTimingIndex].phaseTimes[phase] += duration;
+
+	if (shouldCaptureTrace) {
+		if (traceEventCount == traceEventCapacity) {
+			traceEventCapacity = MAX(traceEventCapacity * 2, kCC3PerformanceTraceInitialCapacity);
+			traceEvents = realloc(traceEvents, traceEventCapacity * sizeof(CC3PerformanceTraceEvent));
+			NSAssert1(traceEvents, @"Could not allocate space for %u trace events", traceEventCapacity);
+		}
+		if (traceEventCount == 0 && traceStartTime == 0.0) traceStartTime = startTime;
+
+		CC3PerformanceTraceEvent* te = &traceEvents[traceEventCount++];
+		te->phase = phase;
+		te->startTime = startTime - traceStartTime;
+		te->duration = duration;
+	}
+}
+
+-(ccTime) accumulatedTimeForPhase: (CC3PerformancePhase) phase { return accumulatedPhaseTimes[phase]; }
+
+-(GLuint) occurrencesOfPhase: (CC3PerformancePhase) phase { return phaseOccurrences[phase]; }
+
+-(ccTime) averageTimeForPhase: (CC3PerformancePhase) phase {
+	GLuint occurrences = phaseOccurrences[phase];
+	return occurrences ? (accumulatedPhaseTimes[phase] / (ccTime)occurrences) : 0.0;
+}
+
+
+#pragma mark Frame timing history
+
+-(CC3PerformanceFrameTiming*) frameTimingAtAge: (GLuint) age {
+	NSAssert2(age < frameTimingCount, @"Frame timing age %u must be less than frame timing count %u",
+			  age, frameTimingCount);
+	GLuint ftIdx = (frameTimingIndex + kCC3PerformanceFrameHistorySize - age) % kCC3PerformanceFrameHistorySize;
+	return &frameTimings[ftIdx];
+}
+
+-(ccTime) timeForPhase: (CC3PerformancePhase) phase atPercentile: (GLfloat) percentile {
+	if (frameTimingCount == 0) return 0.0;
+
+	ccTime times[kCC3PerformanceFrameHistorySize];
+	for (GLuint age = 0; age < frameTimingCount; age++) {
+		times[age] = [self frameTimingAtAge: age]->phaseTimes[phase];
+	}
+	qsort(times, frameTimingCount, sizeof(ccTime), CC3PerformanceCompareTimes);
+
+	GLfloat rank = CLAMP(percentile, 0.0f, 100.0f) / 100.0f * (GLfloat)(frameTimingCount - 1);
+	return times[(GLuint)(rank + 0.5f)];
+}
+
+-(ccTime) p50TimeForPhase: (CC3PerformancePhase) phase { return [self timeForPhase: phase atPercentile: 50.0f]; }
+
+-(ccTime) p95TimeForPhase: (CC3PerformancePhase) phase { return [self timeForPhase: phase atPercentile: 95.0f]; }
+
+-(ccTime) p99TimeForPhase: (CC3PerformancePhase) phase { return [self timeForPhase: phase atPercentile: 99.0f]; }
+
+-(void) clearFrameTimings {
+	memset(frameTimings, 0, sizeof(frameTimings));
+	frameTimingIndex = 0;
+	frameTimingCount = 0;
+}
+
+-(NSString*) phaseTimingDescription {
+	NSMutableString* desc = [NSMutableString stringWithCapacity: 1000];
+	[desc appendFormat: @"%@ phase timing (ms)", [self class]];
+	[desc appendFormat: @"\n\tPhase\tCount\tAverage\tp50\tp95\tp99"];
+	for (GLuint phase = 0; phase < kCC3PerformancePhaseCount; phase++) {
+		if (phaseOccurrences[phase]) {
+			[desc appendFormat: @"\n\t%@\t%u\t%.3f\t%.3f\t%.3f\t%.3f",
+			 NSStringFromCC3PerformancePhase(phase), phaseOccurrences[phase],
+			 [self averageTimeForPhase: phase] * 1000.0f, [self p50TimeForPhase: phase] * 1000.0f,
+			 [self p95TimeForPhase: phase] * 1000.0f, [self p99TimeForPhase: phase] * 1000.0f];
+		}
+	}
+	return desc;
+}
+
+
+#pragma mark Trace capture
+
+-(CC3PerformanceTraceEvent*) traceEventAt: (GLuint) index {
+	NSAssert2(index < traceEventCount, @"Trace event index %u must be less than trace event count %u",
+			  index, traceEventCount);
+	return &traceEvents[index];
+}
+
+-(void) clearTraceEvents {
+	traceEventCount = 0;
+	traceStartTime = 0.0;
+}
+
+-(NSString*) traceEventJSON {
+	NSMutableString* json = [NSMutableString stringWithCapacity: (traceEventCount * 100 + 50)];
+	[json appendString: @"{\"traceEvents\":["];
+	for (GLuint i = 0; i < traceEventCount; i++) {
+		CC3PerformanceTraceEvent* te = &traceEvents[i];
+		[json appendFormat: @"%@\n{\"name\":\"%@\",\"cat\":\"cocos3d\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":1}",
+		 (i ? @"," : @""), NSStringFromCC3PerformancePhase(te->phase),
+		 te->startTime * 1.0e6, te->duration * 1.0e6];
+	}
+	[json appendString: @"\n],\"displayTimeUnit\":\"ms\"}\n"];
+	return json;
+}
+
+-(BOOL) writeTraceEventsToFile: (NSString*) aFilePath {
+	NSError* err = nil;
+	BOOL wasWritten = [self.traceEventJSON writeToFile: aFilePath
+											atomically: YES
+											  encoding: NSUTF8StringEncoding
+												 error: &err];
+	if ( !wasWritten ) LogError(@"%@ could not write trace events to %@: %@", self, aFilePath, err);
+	return wasWritten;
+}
+
 
 #pragma mark Averaged update statistics
 
@@ -121,6 +336,14 @@
 	return framesHandled ? ((GLfloat)nodesTransformed / (GLfloat)updatesHandled) : 0.0;
 }
 
+-(GLfloat) averageBonesUpdatedPerUpdate {
+	return updatesHandled ? ((GLfloat)bonesUpdated / (GLfloat)updatesHandled) : 0.0;
+}
+
+-(GLfloat) averageBonesSkippedPerUpdate {
+	return updatesHandled ? ((GLfloat)bonesSkipped / (GLfloat)updatesHandled) : 0.0;
+}
+
 
 #pragma mark Average frame drawing statistics
 
@@ -149,6 +372,12 @@
 
 -(id) init {
 	if ( (self = [super init]) ) {
+		traceEvents = NULL;
+		traceEventCount = 0;
+		traceEventCapacity = 0;
+		traceStartTime = 0.0;
+		shouldCaptureTrace = NO;
+		[self clearFrameTimings];
 		[self reset];
 	}
 	return self;
@@ -163,6 +392,8 @@
 	accumulatedUpdateTime = 0;
 	nodesUpdated = 0;
 	nodesTransformed = 0;
+	bonesUpdated = 0;
+	bonesSkipped = 0;
 	
 	framesHandled = 0;
 	accumulatedFrameTime = 0.0;
@@ -170,6 +401,12 @@
 	nodesDrawn = 0;
 	drawingCallsMade = 0;
 	facesPresented = 0;
+	shadowVolumesCulled = 0;
+	shadowLightsCulled = 0;
+	shadowCastersCulled = 0;
+
+	memset(accumulatedPhaseTimes, 0, sizeof(accumulatedPhaseTimes));
+	memset(phaseOccurrences, 0, sizeof(phaseOccurrences));
 }
 
 // Template method that populates this instance from the specified other instance.
@@ -179,6 +416,8 @@
 	accumulatedUpdateTime = another.accumulatedUpdateTime;
 	nodesUpdated = another.nodesUpdated;
 	nodesTransformed = another.nodesTransformed;
+	bonesUpdated = another.bonesUpdated;
+	bonesSkipped = another.bonesSkipped;
 	
 	framesHandled = another.framesHandled;
 	accumulatedFrameTime = another.accumulatedFrameTime;
@@ -186,6 +425,26 @@
 	nodesDrawn = another.nodesDrawn;
 	drawingCallsMade = another.drawingCallsMade;
 	facesPresented = another.facesPresented;
+	shadowVolumesCulled = another.shadowVolumesCulled;
+	shadowLightsCulled = another.shadowLightsCulled;
+	shadowCastersCulled = another.shadowCastersCulled;
+
+	for (GLuint phase = 0; phase < kCC3PerformancePhaseCount; phase++) {
+		accumulatedPhaseTimes[phase] = [another accumulatedTimeForPhase: phase];
+		phaseOccurrences[phase] = [another occurrencesOfPhase: phase];
+	}
+
+	// Rebuild the frame timing history, oldest frame first
+	[self clearFrameTimings];
+	GLuint ftCount = another.frameTimingCount;
+	for (GLuint age = ftCount; age > 0; age--) {
+		frameTimingIndex = (ftCount - age);
+		frameTimings[frameTimingIndex] = *[another frameTimingAtAge: (age - 1)];
+	}
+	frameTimingCount = ftCount;
+	
+	// Trace events are not copied, but the trace setting is
+	shouldCaptureTrace = another.shouldCaptureTrace;
 }
 
 -(id) copyWithZone: (NSZone*) zone {